@@ -24,6 +24,7 @@ Abstract:
 
 --*/
 
+#include <errno.h>
 #include "EmsEftp.h"
 #include "EmsEftpSession.h"
 #include "EmsEftpStrategy.h"
@@ -92,12 +93,187 @@ Returns:
   fseek (Strategy->Fp, 0, SEEK_END);
   Strategy->FileSizeInBytes   = ftell (Strategy->Fp);
   Strategy->BlockSizeInBytes  = FILE_BLK_SIZE;
+  Strategy->WindowSize        = 1;
   Strategy->NextBlkNo         = 1;
   Strategy->FileMaxBlkNo      = (Strategy->FileSizeInBytes + Strategy->BlockSizeInBytes - 1) / Strategy->BlockSizeInBytes;
 
   return 0;
 }
 
+STATIC
+VOID
+EmsEftpRrqStrategySendEof (
+  Eftp_Strategy *Strategy
+  )
+/*++
+
+Routine Description:
+
+  Tell the client the whole file is acknowledged and close the session
+
+Arguments:
+
+  Strategy  - The session's strategy
+
+Returns:
+
+  None
+
+--*/
+{
+  INT8          SendPkt[MAX_EFTP_BUF_LEN];
+  UINT32        SendPktLen;
+  Eftp_Session  *Session;
+
+  Session     = StrategyToSession (Strategy);
+  SendPktLen  = Session->BuildPkt (
+                          Session,
+                          SendPkt,
+                          EFTP_TYPE,
+                          EFTP_OACK,
+                          Strategy->NextBlkNo,
+                          "File EOF",
+                          sizeof ("File EOF")
+                          );
+  Session->SilentShutdown (Session);
+  Session->SendData (Session, SendPkt, SendPktLen);
+}
+
+STATIC
+VOID
+EmsEftpRrqStrategyWindowAck (
+  Eftp_Strategy *Strategy,
+  CONST INT8    *PktBuffer
+  )
+/*++
+
+Routine Description:
+
+  Process an ACK of the windowed transfer. The ACK acknowledges every
+  block up to its block number; its optional bitmap tells which of the
+  following blocks the client has, so the holes below the highest of them
+  are resent. The window is then filled up with new blocks. A repeated ACK
+  that makes nothing to send resends the holes, or the first block not
+  acknowledged, again.
+
+Arguments:
+
+  Strategy  - The session's strategy
+  PktBuffer - The data buffer of the ACK packet
+
+Returns:
+
+  None
+
+--*/
+{
+  INT8          FileContent[EFTP_MAX_BLK_SIZE];
+  INT8          SendPkt[MAX_EFTP_BUF_LEN];
+  INT32         Holes[EFTP_MAX_WINDOW_SIZE];
+  INT32         Queue[EFTP_MAX_WINDOW_SIZE * 2];
+  INT32         HoleCount;
+  INT32         Count;
+  INT32         Index;
+  INT32         Bit;
+  UINT32        ReadLength;
+  UINT32        SendPktLen;
+  UINT16        AckNo;
+  UINT16        Length;
+  BOOLEAN       Repeated;
+  CONST UINT8   *Map;
+  Eftp_Session  *Session;
+
+  Session = StrategyToSession (Strategy);
+  Session->GetBlkNo (PktBuffer, &AckNo);
+  Session->GetLength ((INT8 *) PktBuffer, &Length);
+
+  if ((AckNo < Strategy->LastAckNo) || (AckNo >= Strategy->NextBlkNo)) {
+    return ;
+  }
+
+  Repeated            = (BOOLEAN) (AckNo == Strategy->LastAckNo);
+  Strategy->LastAckNo = AckNo;
+
+  if (AckNo >= Strategy->FileMaxBlkNo) {
+    EmsEftpRrqStrategySendEof (Strategy);
+    return ;
+  }
+
+  HoleCount = 0;
+  if (Length >= EFTP_HEADER_LEN + EFTP_WINDOW_MAP_LEN) {
+    Map = (CONST UINT8 *) PktBuffer + DATA_OFFSET;
+    for (Index = EFTP_MAX_WINDOW_SIZE - 1; Index >= 0; Index--) {
+      if (Map[Index / 8] & (1 << (Index % 8))) {
+        break;
+      }
+    }
+
+    for (Bit = 0; Bit < Index; Bit++) {
+      if (!(Map[Bit / 8] & (1 << (Bit % 8)))) {
+        Holes[HoleCount++] = AckNo + 1 + Bit;
+      }
+    }
+  }
+
+  Count = 0;
+  for (Index = 0; Index < HoleCount; Index++) {
+    if (Holes[Index] > Strategy->ResendBlkNo) {
+      Queue[Count++] = Holes[Index];
+    }
+  }
+
+  while ((Strategy->NextBlkNo <= AckNo + Strategy->WindowSize) &&
+         (Strategy->NextBlkNo <= Strategy->FileMaxBlkNo)) {
+    Queue[Count++] = Strategy->NextBlkNo++;
+  }
+
+  if ((Count == 0) && Repeated) {
+    for (Index = 0; Index < HoleCount; Index++) {
+      Queue[Count++] = Holes[Index];
+    }
+
+    if (Count == 0) {
+      Queue[Count++] = AckNo + 1;
+    }
+  }
+
+  for (Index = 0; Index < HoleCount; Index++) {
+    if (Holes[Index] > Strategy->ResendBlkNo) {
+      Strategy->ResendBlkNo = Holes[Index];
+    }
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if ((0 != fseek (Strategy->Fp, Strategy->BlockSizeInBytes * (Queue[Index] - 1), SEEK_SET)) ||
+        ((ReadLength = fread (FileContent, 1, Strategy->BlockSizeInBytes, Strategy->Fp)) <= 0)
+        ) {
+      EFTP_ERROR_MSG ("EmsEftpRrqStrategyWindowAck: file read error SilentShutdown\n");
+      Session->SilentShutdown (Session);
+      return ;
+    }
+
+    SendPktLen = Session->BuildPkt (
+                            Session,
+                            SendPkt,
+                            EFTP_TYPE,
+                            EFTP_DATA,
+                            (UINT16) Queue[Index],
+                            FileContent,
+                            ReadLength
+                            );
+
+    //
+    // Only the last block of the burst waits for the next ACK, and is the
+    // one resent when it times out
+    //
+    if (Index == Count - 1) {
+      Session->SendData (Session, SendPkt, SendPktLen);
+    } else {
+      Session->PostData (Session, SendPkt, SendPktLen);
+    }
+  }
+}
+
 VOID
 EmsEftpRrqStrategyHandlePkt (
   Eftp_Strategy *Strategy,
@@ -123,7 +299,7 @@ Returns:
 
 --*/
 {
-  INT8          FileContent[FILE_BLK_SIZE];
+  INT8          FileContent[EFTP_MAX_BLK_SIZE];
   UINT32        ReadLength;
   UINT32        SendPktLen;
   INT8          SendPkt[MAX_EFTP_BUF_LEN];
@@ -138,6 +314,21 @@ Returns:
 
   switch (OpCode) {
   case EFTP_RRQ:
+    //
+    // A request with options is answered with an OACK, and the transfer
+    // starts with the client's ACK0
+    //
+    if (0 != (TmpLen = Session->Negotiate (Session, PktBuffer, FileContent))) {
+      Strategy->FileMaxBlkNo  = (Strategy->FileSizeInBytes + Strategy->BlockSizeInBytes - 1) / Strategy->BlockSizeInBytes;
+      Strategy->NextBlkNo     = 1;
+      Strategy->LastAckNo     = 0;
+      Strategy->ResendBlkNo   = 0;
+
+      SendPktLen = Session->BuildPkt (Session, SendPkt, EFTP_TYPE, EFTP_OACK, 0, FileContent, TmpLen);
+      Session->SendData (Session, SendPkt, SendPktLen);
+      break;
+    }
+
     fseek (Strategy->Fp, 0, SEEK_SET);
     memset (FileContent, 0, sizeof (FileContent));
     if ((ReadLength = fread (FileContent, 1, Strategy->BlockSizeInBytes, Strategy->Fp)) <= 0) {
@@ -161,6 +352,11 @@ Returns:
     break;
 
   case EFTP_ACK:
+    if (Strategy->WindowSize > 1) {
+      EmsEftpRrqStrategyWindowAck (Strategy, PktBuffer);
+      break;
+    }
+
     Session->GetBlkNo (PktBuffer, &BlkNo);
 
     if (BlkNo > Strategy->NextBlkNo - 1) {
@@ -78,6 +78,12 @@ UINT32              CRCTable[256] = {
   0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
+//
+// CRCSliceTable[0] is CRCTable, CRCSliceTable[k][n] the CRC of byte n
+// followed by k zero bytes. Filled by EmsEftpCrcSetup.
+//
+STATIC UINT32       CRCSliceTable[8][256];
+
 #define EMSEFTPSESSIONPKTPOOLMAXSIZE  0x100
 
 STATIC EmsEftpPkt   *EmsEftpSessionPktPool      = NULL;
@@ -324,6 +330,10 @@ Returns:
 
 --*/
 {
+  if (Len > MAX_EFTP_BUF_LEN) {
+    return -1;
+  }
+
   if (EmsEftpSessionPktPoolGet (Pkt) != 0) {
     return -1;
 
@@ -537,6 +547,41 @@ Returns:
   EmsEftpSessionPktPoolPutMass (Head, Tail, NodeNum);
 }
 
+STATIC
+VOID
+EmsEftpCrcSetup (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Derive the slicing-by-8 tables of EmsEftpCalCrc from CRCTable
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  Slice;
+  UINT32  Crc;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = CRCTable[Index];
+    CRCSliceTable[0][Index] = Crc;
+    for (Slice = 1; Slice < 8; Slice++) {
+      Crc = (Crc >> 8) ^ CRCTable[(UINT8) Crc];
+      CRCSliceTable[Slice][Index] = Crc;
+    }
+  }
+}
+
 UINT32
 EmsEftpCalCrc (
   UINT8  *pt,
@@ -546,7 +591,8 @@ EmsEftpCalCrc (
 
 Routine Description:
 
-  Compute the Crc for a packet
+  Compute the Crc for a packet. Eight bytes are folded in per step with
+  the slicing-by-8 tables, the tail one byte at a time with CRCTable.
 
 Arguments:
 
@@ -560,11 +606,28 @@ Returns:
 --*/
 {
   UINT32  Crc;
+  UINT32  Low;
+  UINT32  High;
 
   //
   // compute crc
   //
   Crc = 0xffffffff;
+  while (Size >= 8) {
+    Low   = Crc ^ ((UINT32) pt[0] | ((UINT32) pt[1] << 8) | ((UINT32) pt[2] << 16) | ((UINT32) pt[3] << 24));
+    High  = (UINT32) pt[4] | ((UINT32) pt[5] << 8) | ((UINT32) pt[6] << 16) | ((UINT32) pt[7] << 24);
+    Crc   = CRCSliceTable[7][Low & 0xff] ^
+            CRCSliceTable[6][(Low >> 8) & 0xff] ^
+            CRCSliceTable[5][(Low >> 16) & 0xff] ^
+            CRCSliceTable[4][Low >> 24] ^
+            CRCSliceTable[3][High & 0xff] ^
+            CRCSliceTable[2][(High >> 8) & 0xff] ^
+            CRCSliceTable[1][(High >> 16) & 0xff] ^
+            CRCSliceTable[0][High >> 24];
+    pt += 8;
+    Size -= 8;
+  }
+
   while (Size) {
     Crc = (Crc >> 8) ^ CRCTable[(UINT8) Crc ^ *pt];
     pt += 1;
@@ -851,6 +914,106 @@ Returns:
   return Length;
 }
 
+STATIC
+UINT32
+EmsEftpSessionNegotiate (
+  Eftp_Session *Session,
+  CONST INT8   *Pkt,
+  INT8         *OackBuf
+  )
+/*++
+
+Routine Description:
+
+  Take the options of a RRQ or WRQ into the session's strategy and build
+  the data of the OACK answering them. "blksize" and "windowsize" are
+  clamped to what one frame and one acknowledgement bitmap can carry,
+  "tsize" is answered with the size of the file to read.
+
+Arguments:
+
+  Session - The EMS Eftp session the request belongs to
+  Pkt     - The RRQ or WRQ packet
+  OackBuf - Buffer of at least EFTP_MAX_BLK_SIZE bytes for the OACK data
+
+Returns:
+
+  The length of the OACK data, 0 if the request has no known option and
+  must be answered the stop-and-wait way
+
+--*/
+{
+  Eftp_Strategy *Strategy;
+  CONST INT8    *Cursor;
+  CONST INT8    *Last;
+  CONST INT8    *Name;
+  CONST INT8    *Value;
+  UINT16        OpCode;
+  UINT16        Length;
+  UINT32        OackLen;
+  INT32         Number;
+  INT32         Index;
+
+  Strategy = &Session->Strategy;
+  OackLen  = 0;
+
+  Session->GetOpCode (Pkt, &OpCode);
+  Session->GetLength ((INT8 *) Pkt, &Length);
+  if (LENGTH_OFFSET + Length > MAX_EFTP_BUF_LEN) {
+    return 0;
+  }
+
+  //
+  // Skip the file name and the mode
+  //
+  Cursor  = Pkt + FILE_NAME_OFFSET;
+  Last    = Pkt + LENGTH_OFFSET + Length;
+  for (Index = 0; Index < 2; Index++) {
+    if ((Cursor >= Last) || (NULL == (Cursor = memchr (Cursor, 0, Last - Cursor)))) {
+      return 0;
+    }
+
+    Cursor++;
+  }
+
+  while (Cursor < Last) {
+    Name = Cursor;
+    if (NULL == (Cursor = memchr (Name, 0, Last - Name)) || (++Cursor >= Last)) {
+      break;
+    }
+
+    Value = Cursor;
+    if (NULL == (Cursor = memchr (Value, 0, Last - Value))) {
+      break;
+    }
+
+    Cursor++;
+    Number = atoi (Value);
+    if (OackLen + 32 > EFTP_MAX_BLK_SIZE) {
+      break;
+    }
+
+    if ((_stricmp (Name, "blksize") == 0) && (Number >= 8)) {
+      Strategy->BlockSizeInBytes = (Number < EFTP_MAX_BLK_SIZE) ? Number : EFTP_MAX_BLK_SIZE;
+      Number = Strategy->BlockSizeInBytes;
+    } else if ((_stricmp (Name, "windowsize") == 0) && (Number >= 1)) {
+      Strategy->WindowSize = (Number < EFTP_MAX_WINDOW_SIZE) ? Number : EFTP_MAX_WINDOW_SIZE;
+      Number = Strategy->WindowSize;
+    } else if (_stricmp (Name, "tsize") == 0) {
+      if (OpCode == EFTP_RRQ) {
+        Number = Strategy->FileSizeInBytes;
+      }
+    } else {
+      continue;
+    }
+
+    OackLen += sprintf (OackBuf + OackLen, "%s", Name) + 1;
+    OackLen += sprintf (OackBuf + OackLen, "%d", Number) + 1;
+  }
+
+  return OackLen;
+}
+
 VOID
 EmsEftpSessionResendData (
   Eftp_Session *Session
@@ -874,6 +1037,43 @@ Returns:
   Session->SendData (Session, Session->LastSentMsg, Session->LastSentLen);
 }
 
+STATIC
+VOID
+EmsEftpSessionPostData (
+  Eftp_Session *Session,
+  INT8         *Pkt,
+  UINT32       Len
+  )
+/*++
+
+Routine Description:
+
+  The routine for send data without waiting for the answer, used for the
+  blocks of a window but the last one
+
+Arguments:
+
+  Session - The EMS Eftp session which should send data
+  Pkt     - The packet which should be send
+  Len     - The length of the packet
+
+Returns:
+
+  None
+
+--*/
+{
+  DWORD RetVal;
+
+  if ((RetVal = libnet_write_link (Session->LibnetHandler, Pkt, Len)) < Len) {
+    EFTP_DEBUG_MSG ("EmsEftpSessionPostData: Error should be %d actual ret is %d !!!!!!!!\n", Len, RetVal);
+    return ;
+  }
+
+  memcpy (Session->LastSentMsg, Pkt, Len);
+  Session->LastSentLen = Len;
+}
+
 STATIC
 VOID
 EmsEftpSessionSendData (
@@ -909,11 +1109,19 @@ Returns:
       /* Error */
       EFTP_DEBUG_MSG ("EmsEftpSessionSendData: Error should be %d actual ret is %d !!!!!!!!\n", Len, RetVal);
       return ;
-    } else {
+    } else if (Pkt != Session->LastSentMsg) {
       memcpy (Session->LastSentMsg, Pkt, Len);
       Session->LastSentLen = Len;
     }
 
+    //
+    // The signal of a packet queued while the last one was handled is
+    // taken already; the packet is the answer, do not wait for another one
+    //
+    if (Session->SessionPktListHead != NULL) {
+      return ;
+    }
+
     switch (RetVal = EmsEftpSessionTimeWait (Session)) {
     case WAIT_TIMEOUT:
       /* send again */
@@ -1065,8 +1273,10 @@ Returns:
   Session->GetBlkNo       = EmsEftpSessionGetBlkno;
   Session->GetLength      = EmsEftpSessionGetLength;
   Session->SendData       = EmsEftpSessionSendData;
+  Session->PostData       = EmsEftpSessionPostData;
   Session->ResendData     = EmsEftpSessionResendData;
   Session->BuildPkt       = EmsEftpSessionBuildPkt;
+  Session->Negotiate      = EmsEftpSessionNegotiate;
   Session->SilentShutdown = EmsEftpSessionSilentShutdown;
   Session->LoudShutdown   = EmsEftpSessionLoudShutdown;
 
@@ -1297,6 +1507,7 @@ Returns:
 
   EmsEftpSessionArraySetup ();
   EmsEftpSessionPktPoolCreate ();
+  EmsEftpCrcSetup ();
 
   if (NULL == (Res = (EmsTclResMng *) malloc (sizeof (EmsTclResMng)))) {
     printf ("EmsEftpSessionModSetup malloc EmsTclResMng Failure\n");
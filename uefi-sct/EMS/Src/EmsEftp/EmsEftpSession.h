@@ -98,11 +98,13 @@ typedef struct Eftp_Session_Struct {
   HANDLE                      Mutex;
 
   VOID (*SendData) (struct Eftp_Session_Struct *, INT8 *, UINT32);
+  VOID (*PostData) (struct Eftp_Session_Struct *, INT8 *, UINT32);
   VOID (*ResendData) (struct Eftp_Session_Struct *);
   VOID (*GetOpCode) (CONST INT8 *, UINT16 *);
   VOID (*GetBlkNo) (CONST INT8 *, UINT16 *);
   VOID (*GetLength) (INT8 *, UINT16 *);
   UINT32 (*BuildPkt) (struct Eftp_Session_Struct *, UINT8 *, UINT16, UINT16, UINT16, INT8 *, UINT32);
+  UINT32 (*Negotiate) (struct Eftp_Session_Struct *, CONST INT8 *, INT8 *);
   VOID_P (*SilentShutdown) (struct Eftp_Session_Struct *);
   VOID_P (*LoudShutdown) (struct Eftp_Session_Struct *);
 }
@@ -36,6 +36,21 @@ typedef struct Eftp_Strategy_Struct {
   INT32                         NextBlkNo;
   INT32                         LastAckNo;
 
+  //
+  // Windowed transfer, negotiated with the "windowsize" option. WindowSize
+  // is 1 for the stop-and-wait transfer. HighBlkNo is the highest block
+  // sent (RRQ) or received (WRQ), ResendBlkNo the highest block resent for
+  // a hole. For WRQ, WindowEnd is the last block the client sends before
+  // it waits for an ACK, and RecvMap the blocks received after
+  // NextBlkNo - 1.
+  //
+  INT32                         WindowSize;
+  INT32                         HighBlkNo;
+  INT32                         ResendBlkNo;
+  INT32                         LastBlkNo;
+  INT32                         WindowEnd;
+  UINT8                         RecvMap[EFTP_WINDOW_MAP_LEN];
+
   VOID_P (*HandlePkt) (struct Eftp_Strategy_Struct *, CONST INT8 *, INT32 );
   INT32 (*Open) (struct Eftp_Strategy_Struct *, CONST INT8 *);
   VOID_P (*Close) (struct Eftp_Strategy_Struct *);
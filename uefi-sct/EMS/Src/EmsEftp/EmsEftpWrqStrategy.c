@@ -64,11 +64,198 @@ Returns:
   }
 
   Strategy->BlockSizeInBytes  = FILE_BLK_SIZE;
+  Strategy->WindowSize        = 1;
   Strategy->NextBlkNo         = 1;
 
   return 0;
 }
 
+STATIC
+BOOLEAN
+EmsEftpWrqStrategyHasHoles (
+  Eftp_Strategy *Strategy
+  )
+/*++
+
+Routine Description:
+
+  Check whether blocks after a missing one were received
+
+Arguments:
+
+  Strategy  - The session's strategy
+
+Returns:
+
+  TRUE if RecvMap is not empty
+
+--*/
+{
+  INT32 Index;
+
+  for (Index = 0; Index < EFTP_WINDOW_MAP_LEN; Index++) {
+    if (Strategy->RecvMap[Index] != 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+STATIC
+VOID
+EmsEftpWrqStrategySendAck (
+  Eftp_Strategy *Strategy
+  )
+/*++
+
+Routine Description:
+
+  Acknowledge every block before NextBlkNo. When blocks after a missing
+  one were received, RecvMap follows as the data of the ACK: bit i tells
+  that block NextBlkNo + i is received. The client answers with the blocks
+  up to WindowEnd.
+
+Arguments:
+
+  Strategy  - The session's strategy
+
+Returns:
+
+  None
+
+--*/
+{
+  INT8          SendPkt[MAX_EFTP_BUF_LEN];
+  UINT32        SendPktLen;
+  Eftp_Session  *Session;
+
+  Session             = StrategyToSession (Strategy);
+  Strategy->WindowEnd = Strategy->NextBlkNo - 1 + Strategy->WindowSize;
+  SendPktLen          = Session->BuildPkt (
+                                  Session,
+                                  SendPkt,
+                                  EFTP_TYPE,
+                                  EFTP_ACK,
+                                  (UINT16) (Strategy->NextBlkNo - 1),
+                                  EmsEftpWrqStrategyHasHoles (Strategy) ? (INT8 *) Strategy->RecvMap : NULL,
+                                  EmsEftpWrqStrategyHasHoles (Strategy) ? EFTP_WINDOW_MAP_LEN : 0
+                                  );
+  Session->SendData (Session, SendPkt, SendPktLen);
+}
+
+STATIC
+VOID
+EmsEftpWrqStrategyWindowData (
+  Eftp_Strategy *Strategy,
+  CONST INT8    *PktBuffer
+  )
+/*++
+
+Routine Description:
+
+  Process a DATA of the windowed transfer. The block is written at its
+  place even when earlier ones are missing. An ACK is sent when a hole
+  appears or is filled, at the end of the window, at the last block, and
+  when no more block comes in time. A block acknowledged already is
+  answered at once: the client resends it when our ACK is lost. Another
+  block received before is a late resend of a hole, only answered at the
+  end of the window.
+
+Arguments:
+
+  Strategy  - The session's strategy
+  PktBuffer - The data buffer of the DATA packet
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT16        BlkNo;
+  UINT16        Length;
+  INT32         Offset;
+  INT32         Index;
+  BOOLEAN       HadHoles;
+  BOOLEAN       AckNow;
+  Eftp_Session  *Session;
+
+  Session = StrategyToSession (Strategy);
+  Session->GetBlkNo (PktBuffer, &BlkNo);
+  Session->GetLength ((INT8 *) PktBuffer, &Length);
+
+  Offset = BlkNo - Strategy->NextBlkNo;
+  if ((Offset >= EFTP_MAX_WINDOW_SIZE) ||
+      ((Strategy->LastBlkNo != 0) && (BlkNo > Strategy->LastBlkNo))) {
+    return ;
+  }
+
+  if ((Offset < 0) || (Strategy->RecvMap[Offset / 8] & (1 << (Offset % 8)))) {
+    if ((Offset < 0) || (BlkNo >= Strategy->WindowEnd)) {
+      EmsEftpWrqStrategySendAck (Strategy);
+    }
+
+    return ;
+  }
+
+  fseek (Strategy->Fp, Strategy->BlockSizeInBytes * (BlkNo - 1), SEEK_SET);
+  if (fwrite (PktBuffer + DATA_OFFSET, 1, Length - EFTP_HEADER_LEN, Strategy->Fp) != (UINT32) (Length - EFTP_HEADER_LEN)) {
+    EFTP_DEBUG_MSG ("EmsEftpWrqStrategyWindowData: Write file failure \n");
+    Session->SilentShutdown (Session);
+    return ;
+  }
+
+  if (Length - EFTP_HEADER_LEN < Strategy->BlockSizeInBytes) {
+    Strategy->LastBlkNo = BlkNo;
+  }
+
+  HadHoles  = EmsEftpWrqStrategyHasHoles (Strategy);
+  AckNow    = (BOOLEAN) (BlkNo > Strategy->HighBlkNo + 1);
+  if (BlkNo > Strategy->HighBlkNo) {
+    Strategy->HighBlkNo = BlkNo;
+  }
+
+  //
+  // Mark the block, then slide NextBlkNo over the received ones
+  //
+  Strategy->RecvMap[Offset / 8] |= (UINT8) (1 << (Offset % 8));
+  while (Strategy->RecvMap[0] & 1) {
+    for (Index = 0; Index < EFTP_WINDOW_MAP_LEN - 1; Index++) {
+      Strategy->RecvMap[Index] = (UINT8) ((Strategy->RecvMap[Index] >> 1) | (Strategy->RecvMap[Index + 1] << 7));
+    }
+
+    Strategy->RecvMap[EFTP_WINDOW_MAP_LEN - 1] >>= 1;
+    Strategy->NextBlkNo++;
+  }
+
+  if (HadHoles && !EmsEftpWrqStrategyHasHoles (Strategy)) {
+    AckNow = TRUE;
+  }
+
+  if ((BlkNo >= Strategy->WindowEnd) ||
+      ((Strategy->LastBlkNo != 0) && (Strategy->NextBlkNo > Strategy->LastBlkNo))) {
+    AckNow = TRUE;
+  }
+
+  //
+  // Without an ACK to send, wait for the next block of the window; when
+  // none comes in time acknowledge what is received so far. The event may
+  // be left set by a packet handled already, so the list tells.
+  //
+  if (!AckNow) {
+    for (Index = 0; (Index < 2) && (Session->SessionPktListHead == NULL); Index++) {
+      WaitForSingleObject (Session->SessionWaitPktEvent, EFTP_WINDOW_WAIT);
+    }
+
+    if (Session->SessionPktListHead != NULL) {
+      return ;
+    }
+  }
+
+  EmsEftpWrqStrategySendAck (Strategy);
+}
+
 VOID
 EmsEftpWrqStrategyHandlePkt (
   Eftp_Strategy *Strategy,
@@ -97,6 +284,8 @@ Returns:
   UINT32        WriteLength;
   UINT32        SendPktLen;
   INT8          SendPkt[MAX_EFTP_BUF_LEN];
+  INT8          Oack[EFTP_MAX_BLK_SIZE];
+  UINT32        OackLen;
   UINT16        OpCode;
   UINT16        BlkNo;
   UINT16        Length;
@@ -107,12 +296,25 @@ Returns:
 
   switch (OpCode) {
   case EFTP_WRQ:
+    /* A request with options is answered with an OACK in place of Ack(Blk0) */
+    if (0 != (OackLen = Session->Negotiate (Session, PktBuffer, Oack))) {
+      Strategy->WindowEnd = Strategy->WindowSize;
+      SendPktLen = Session->BuildPkt (Session, SendPkt, EFTP_TYPE, EFTP_OACK, 0, Oack, OackLen);
+      Session->SendData (Session, SendPkt, SendPktLen);
+      break;
+    }
+
     /* Build Ack(Blk0) and send */
     SendPktLen = Session->BuildPkt (Session, SendPkt, EFTP_TYPE, EFTP_ACK, 0, NULL, 0);
     Session->SendData (Session, SendPkt, SendPktLen);
     break;
 
   case EFTP_DATA:
+    if (Strategy->WindowSize > 1) {
+      EmsEftpWrqStrategyWindowData (Strategy, PktBuffer);
+      break;
+    }
+
     /* Get the BlkNo from the data pkt */
     Session->GetBlkNo (PktBuffer, &BlkNo);
 
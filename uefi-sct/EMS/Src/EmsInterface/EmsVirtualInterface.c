@@ -269,7 +269,12 @@ Returns:
 
   GetAdaptersInfo (pInfo, &ulSize);
   pInfoTemp = pInfo = (PIP_ADAPTER_INFO) malloc (ulSize * sizeof (INT8));
-  GetAdaptersInfo (pInfo, &ulSize);
+  if ((pInfo == NULL) || (GetAdaptersInfo (pInfo, &ulSize) != ERROR_SUCCESS)) {
+    //
+    // No adapter, or it is added between the two calls
+    //
+    pInfo = NULL;
+  }
 
   //
   // Show all the network adapter in system.
@@ -386,7 +391,12 @@ Returns:
 
   GetAdaptersInfo (pInfo, &ulSize);
   pInfoTemp = pInfo = (PIP_ADAPTER_INFO) malloc (ulSize * sizeof (INT8));
-  GetAdaptersInfo (pInfo, &ulSize);
+  if ((pInfo == NULL) || (GetAdaptersInfo (pInfo, &ulSize) != ERROR_SUCCESS)) {
+    //
+    // No adapter, or it is added between the two calls
+    //
+    pInfo = NULL;
+  }
 
   //
   // Get Mac address.
@@ -29,6 +29,7 @@ Abstract:
 #include "EmsUtilityString.h"
 #include "EmsLogUtility.h"
 #include "EmsLogReport.h"
+#include "EmsLogQueue.h"
 #include "EmsThread.h"
 
 INT8                    CaseName[256];
@@ -59,6 +60,8 @@ STATIC Tcl_CmdProc      TclBeginLogPacket;
 STATIC Tcl_CmdProc      TclEndLogPacket;
 STATIC Tcl_CmdProc      TclSendLogFilePacket;
 STATIC Tcl_CmdProc      TclResendCapturedPacket;
+STATIC Tcl_CmdProc      TclLogMode;
+STATIC Tcl_CmdProc      TclLogStat;
 
 STATIC TCL_CMD_TBL      TclCmd[] = {
   {
@@ -129,6 +132,14 @@ STATIC TCL_CMD_TBL      TclCmd[] = {
     "ResendCapturedPacket",
     TclResendCapturedPacket
   },
+  {
+    "LogMode",
+    TclLogMode
+  },
+  {
+    "LogStat",
+    TclLogStat
+  },
   {
     NULL,
     NULL
@@ -1269,3 +1280,111 @@ Returns:
 ErrorExit:
   return TCL_ERROR;
 }
+
+STATIC
+INT32
+TclLogMode (
+  IN ClientData      clientData,
+  IN Tcl_Interp      *Interp,
+  IN INT32           Argc,
+  IN CONST84 INT8    *Argv[]
+  )
+/*++
+
+Routine Description:
+
+  TCL command "LogMode" implementation routine. "LogMode Async" queues the
+  log for the writer thread, "LogMode Sync" writes it in the caller. The
+  current mode is returned.
+
+Arguments:
+
+  clientData  - Private data, if any.
+  Interp      - TCL intepreter.
+  Argc        - Argument counter.
+  Argv        - Argument value pointer array.
+
+Returns:
+
+  TCL_OK or TCL_ERROR
+
+--*/
+{
+  if (Argc > 2) {
+    Tcl_AppendResult (
+      Interp,
+      "LogMode: LogMode [Sync|Async]",
+      (INT8 *) NULL
+      );
+    return TCL_ERROR;
+  }
+
+  if (Argc == 2) {
+    if (0 == strcmp_i ("Async", (INT8 *) Argv[1])) {
+      EmsLogQueueSetAsync (TRUE);
+    } else if (0 == strcmp_i ("Sync", (INT8 *) Argv[1])) {
+      EmsLogQueueSetAsync (FALSE);
+    } else {
+      Tcl_AppendResult (
+        Interp,
+        "LogMode: 1st argument MUST be one of ",
+        "Sync, Async",
+        (INT8 *) NULL
+        );
+      return TCL_ERROR;
+    }
+  }
+
+  Tcl_AppendResult (
+    Interp,
+    EmsLogQueueIsAsync () ? "Async" : "Sync",
+    (INT8 *) NULL
+    );
+  return TCL_OK;
+}
+
+STATIC
+INT32
+TclLogStat (
+  IN ClientData      clientData,
+  IN Tcl_Interp      *Interp,
+  IN INT32           Argc,
+  IN CONST84 INT8    *Argv[]
+  )
+/*++
+
+Routine Description:
+
+  TCL command "LogStat" implementation routine. The log is flushed, then the
+  counters of the writer are returned as a list and reset.
+
+Arguments:
+
+  clientData  - Private data, if any.
+  Interp      - TCL intepreter.
+  Argc        - Argument counter.
+  Argv        - Argument value pointer array.
+
+Returns:
+
+  TCL_OK
+
+--*/
+{
+  EMS_LOG_QUEUE_STAT  Stat;
+  INT8                Buffer[128];
+
+  EmsLogQueueFlush ();
+  EmsLogQueueGetStat (&Stat);
+
+  sprintf (
+    Buffer,
+    "Records %u Batches %u ScreenUpdates %u MaxBatch %u",
+    Stat.Records,
+    Stat.Batches,
+    Stat.ScreenUpdates,
+    Stat.MaxBatch
+    );
+  Tcl_AppendResult (Interp, Buffer, (INT8 *) NULL);
+  return TCL_OK;
+}
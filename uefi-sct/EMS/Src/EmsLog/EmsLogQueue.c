@@ -0,0 +1,545 @@
+/** @file
+
+  Copyright 2006 - 2011 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2011, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+    EmsLogQueue.c
+
+Abstract:
+
+    Implementation of the asynchronous log writer. The log strings are
+    formatted by the producers as before, copied into a record and pushed
+    on a lock-free stack with a compare-and-swap, so a producer never waits
+    for the file or the screen. A writer thread takes the whole stack with
+    one exchange, restores the order and writes the batch. The screen text
+    of a batch is joined and shown at most once per EMS_LOG_SCREEN_INTERVAL,
+    since every update is a command to the GUI thread.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EmsPlatform.h"
+#include "EmsLogUtility.h"
+#include "EmsLogQueue.h"
+
+typedef struct _EMS_LOG_RECORD {
+  struct _EMS_LOG_RECORD  *Next;
+  FILE                    *File1;
+  FILE                    *File2;
+  BOOLEAN                 Screen;
+  UINT32                  Length;
+  INT8                    String[1];
+} EMS_LOG_RECORD;
+
+STATIC BOOLEAN            LogQueueAsync     = TRUE;
+STATIC BOOLEAN            LogQueueFailed    = FALSE;
+STATIC BOOLEAN            LogQueueRun       = FALSE;
+STATIC PVOID              LogQueueMutex     = NULL;   // Protects the start and the stop
+STATIC HANDLE             LogQueueThread    = NULL;
+STATIC HANDLE             LogQueueEvent     = NULL;   // Signaled on the first push and on a flush
+STATIC PVOID              LogQueueTop       = NULL;   // The pushed records, the newest first
+
+//
+// A flush takes a ticket, and waits until the writer has finished a pass
+// which started after the ticket was taken
+//
+STATIC LONG               LogQueueTicket    = 0;
+STATIC LONG               LogQueueFlushed   = 0;
+STATIC EMS_LOCK           LogQueueLock;
+STATIC EMS_CONDITION      LogQueueDone;
+STATIC EMS_LOG_QUEUE_STAT LogQueueStat;
+
+//
+// The screen text not shown yet, only used by the writer
+//
+STATIC INT8               LogQueueScreen[EMS_MAX_PRINT_BUFFER];
+STATIC UINT32             LogQueueScreenLen = 0;
+
+STATIC
+DWORD
+WINAPI
+LogQueueWriter (
+  LPVOID lpParameter
+  );
+
+STATIC
+VOID_P
+LogQueueExitHandler (
+  IN ClientData clientData
+  );
+
+STATIC
+VOID
+LogQueueWriteFiles (
+  IN FILE           *File1,
+  IN FILE           *File2,
+  IN CONST INT8     *String,
+  IN UINT32         Length
+  )
+{
+  if (File1 != NULL) {
+    fwrite (String, Length, 1, File1);
+  }
+
+  if (File2 != NULL) {
+    fwrite (String, Length, 1, File2);
+  }
+}
+
+STATIC
+VOID
+LogQueueShowScreen (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Show the collected screen text with one GUI command.
+
+--*/
+{
+  if (LogQueueScreenLen == 0) {
+    return;
+  }
+
+  LogQueueScreen[LogQueueScreenLen] = '\0';
+  Output2Screen (LogQueueScreen);
+  LogQueueScreenLen = 0;
+  LogQueueStat.ScreenUpdates++;
+}
+
+STATIC
+VOID
+LogQueueAddScreen (
+  IN CONST INT8     *String,
+  IN UINT32         Length
+  )
+/*++
+
+Routine Description:
+
+  Add a string to the screen text. Output2Screen wraps the text in a GUI
+  command, so the text is kept below EMS_MAX_PRINT_BUFFER with some room.
+
+--*/
+{
+  if (LogQueueScreenLen + Length + 4 > EMS_MAX_PRINT_BUFFER) {
+    LogQueueShowScreen ();
+  }
+
+  if (Length + 4 > EMS_MAX_PRINT_BUFFER) {
+    Output2Screen ((INT8 *) String);
+    LogQueueStat.ScreenUpdates++;
+    return;
+  }
+
+  memcpy (LogQueueScreen + LogQueueScreenLen, String, Length);
+  LogQueueScreenLen += Length;
+}
+
+STATIC
+UINT32
+LogQueueDrain (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Take every pushed record and write them in the order they were pushed.
+
+Arguments:
+
+  None
+
+Returns:
+
+  The number of records written.
+
+--*/
+{
+  EMS_LOG_RECORD  *Batch;
+  EMS_LOG_RECORD  *Record;
+  EMS_LOG_RECORD  *Next;
+  UINT32          Count;
+
+  Batch = (EMS_LOG_RECORD *) InterlockedExchangePointer (&LogQueueTop, NULL);
+
+  //
+  // The stack is the newest first
+  //
+  Record  = NULL;
+  Count   = 0;
+  while (Batch != NULL) {
+    Next          = Batch->Next;
+    Batch->Next   = Record;
+    Record        = Batch;
+    Batch         = Next;
+    Count++;
+  }
+
+  for (; Record != NULL; Record = Next) {
+    Next = Record->Next;
+    LogQueueWriteFiles (Record->File1, Record->File2, Record->String, Record->Length);
+    if (Record->Screen) {
+      LogQueueAddScreen (Record->String, Record->Length);
+    }
+
+    free (Record);
+  }
+
+  return Count;
+}
+
+STATIC
+BOOLEAN
+LogQueueStart (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Start the writer thread on the first queued string. If the thread cannot
+  be started, the log stays synchronous.
+
+Arguments:
+
+  None
+
+Returns:
+
+  TRUE if the writer thread is running.
+
+--*/
+{
+  HANDLE  Mutex;
+  DWORD   ThreadId;
+
+  //
+  // The log is written from several threads
+  //
+  if (NULL == LogQueueMutex) {
+    Mutex = CreateMutex (NULL, FALSE, NULL);
+    if (NULL != InterlockedCompareExchangePointer (&LogQueueMutex, Mutex, NULL)) {
+      CloseHandle (Mutex);
+    }
+  }
+
+  WaitForSingleObject (LogQueueMutex, INFINITE);
+  if ((NULL == LogQueueThread) && !LogQueueFailed) {
+    EmsLockInit (&LogQueueLock);
+    EmsConditionInit (&LogQueueDone);
+
+    LogQueueEvent = CreateEvent (NULL, FALSE, FALSE, NULL);
+    if (NULL != LogQueueEvent) {
+      LogQueueRun     = TRUE;
+      LogQueueThread  = CreateThread (NULL, 0, LogQueueWriter, NULL, 0, &ThreadId);
+    }
+
+    if (NULL == LogQueueThread) {
+      if (NULL != LogQueueEvent) {
+        CloseHandle (LogQueueEvent);
+        LogQueueEvent = NULL;
+      }
+
+      LogQueueFailed  = TRUE;
+      LogQueueAsync   = FALSE;
+      printf ("EmsLog: Cannot create writer thread, the log is synchronous\n");
+    } else {
+      Tcl_CreateExitHandler (LogQueueExitHandler, NULL);
+    }
+  }
+
+  ReleaseMutex (LogQueueMutex);
+  return (BOOLEAN) (NULL != LogQueueThread);
+}
+
+STATIC
+DWORD
+WINAPI
+LogQueueWriter (
+  LPVOID lpParameter
+  )
+/*++
+
+Routine Description:
+
+  The writer thread. It waits for the first push, or for the screen
+  interval while screen text is pending, then writes everything pushed so
+  far in the order it was pushed.
+
+Arguments:
+
+  lpParameter - Not used.
+
+Returns:
+
+  0  - Success.
+
+--*/
+{
+  UINT32          Count;
+  LONG            Ticket;
+  BOOLEAN         Stop;
+  DWORD           LastScreen;
+
+  LastScreen = GetTickCount ();
+
+  while (TRUE) {
+    WaitForSingleObject (
+      LogQueueEvent,
+      (LogQueueScreenLen != 0) ? EMS_LOG_SCREEN_INTERVAL : INFINITE
+      );
+
+    //
+    // Read the ticket before taking the records, so a flush also covers the
+    // records pushed before it
+    //
+    Stop    = (BOOLEAN) !LogQueueRun;
+    Ticket  = LogQueueTicket;
+    Count   = LogQueueDrain ();
+
+    if ((Ticket != LogQueueFlushed) || Stop ||
+        (GetTickCount () - LastScreen >= EMS_LOG_SCREEN_INTERVAL)) {
+      LogQueueShowScreen ();
+      LastScreen = GetTickCount ();
+    }
+
+    EmsLockAcquire (&LogQueueLock);
+    if (Count != 0) {
+      LogQueueStat.Records += Count;
+      LogQueueStat.Batches++;
+      if (Count > LogQueueStat.MaxBatch) {
+        LogQueueStat.MaxBatch = Count;
+      }
+    }
+
+    LogQueueFlushed = Ticket;
+    EmsConditionSignal (&LogQueueDone);
+    EmsLockRelease (&LogQueueLock);
+
+    if (Stop && (NULL == LogQueueTop)) {
+      break;
+    }
+  }
+
+  return 0;
+}
+
+EFI_STATUS
+EmsLogQueueWrite (
+  IN FILE           *File1,
+  IN FILE           *File2,
+  IN BOOLEAN        Screen,
+  IN CONST INT8     *String
+  )
+/*++
+
+Routine Description:
+
+  Write a string to up to two files and optionally to the screen. In the
+  asynchronous mode the string is copied and queued for the writer thread,
+  the files must stay open until EmsLogQueueFlush returns.
+
+Arguments:
+
+  File1   - The first file, or NULL.
+  File2   - The second file, or NULL.
+  Screen  - Also output the string to the screen.
+  String  - The string to be written.
+
+Returns:
+
+  EFI_SUCCESS           - Successfully.
+  EFI_OUT_OF_RESOURCES  - The string could not be queued.
+
+--*/
+{
+  EMS_LOG_RECORD  *Record;
+  PVOID           Top;
+  UINT32          Length;
+
+  Length = (UINT32) strlen (String);
+
+  if (!LogQueueAsync || ((NULL == LogQueueThread) && !LogQueueStart ())) {
+    LogQueueWriteFiles (File1, File2, String, Length);
+    if (Screen) {
+      Output2Screen ((INT8 *) String);
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  Record = (EMS_LOG_RECORD *) malloc (sizeof (EMS_LOG_RECORD) + Length);
+  if (NULL == Record) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Record->File1   = File1;
+  Record->File2   = File2;
+  Record->Screen  = Screen;
+  Record->Length  = Length;
+  memcpy (Record->String, String, Length + 1);
+
+  do {
+    Top           = LogQueueTop;
+    Record->Next  = (EMS_LOG_RECORD *) Top;
+  } while (InterlockedCompareExchangePointer (&LogQueueTop, Record, Top) != Top);
+
+  //
+  // The writer takes the whole stack, so only the first push wakes it up
+  //
+  if (NULL == Top) {
+    SetEvent (LogQueueEvent);
+  }
+
+  return EFI_SUCCESS;
+}
+
+VOID
+EmsLogQueueFlush (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Wait until every string queued before the call is written and shown.
+
+--*/
+{
+  LONG  Ticket;
+
+  if (NULL == LogQueueThread) {
+    return;
+  }
+
+  Ticket = InterlockedIncrement (&LogQueueTicket);
+  SetEvent (LogQueueEvent);
+
+  //
+  // The condition wakes one waiter only, so a second flushing thread
+  // checks again after a while
+  //
+  EmsLockAcquire (&LogQueueLock);
+  while ((LONG) (Ticket - LogQueueFlushed) > 0) {
+    EmsConditionWait (&LogQueueDone, &LogQueueLock, EMS_LOG_SCREEN_INTERVAL);
+  }
+
+  EmsConditionSignal (&LogQueueDone);
+  EmsLockRelease (&LogQueueLock);
+}
+
+VOID
+EmsLogQueueSetAsync (
+  IN BOOLEAN        Async
+  )
+/*++
+
+Routine Description:
+
+  Select the asynchronous or the synchronous mode. The queue is flushed
+  first, so the order of the strings is kept.
+
+--*/
+{
+  EmsLogQueueFlush ();
+  LogQueueAsync = (BOOLEAN) (Async && !LogQueueFailed);
+}
+
+BOOLEAN
+EmsLogQueueIsAsync (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Return TRUE if the strings are queued for the writer thread.
+
+--*/
+{
+  return LogQueueAsync;
+}
+
+VOID
+EmsLogQueueGetStat (
+  OUT EMS_LOG_QUEUE_STAT  *Stat
+  )
+/*++
+
+Routine Description:
+
+  Get the counters of the log writer, and reset them.
+
+--*/
+{
+  if (NULL == LogQueueThread) {
+    memset (Stat, 0, sizeof (EMS_LOG_QUEUE_STAT));
+    return;
+  }
+
+  EmsLockAcquire (&LogQueueLock);
+  *Stat = LogQueueStat;
+  memset (&LogQueueStat, 0, sizeof (EMS_LOG_QUEUE_STAT));
+  EmsLockRelease (&LogQueueLock);
+}
+
+STATIC
+VOID_P
+LogQueueExitHandler (
+  IN ClientData clientData
+  )
+/*++
+
+Routine Description:
+
+  Write the queued strings and stop the writer thread when EMS exits. The
+  strings logged after it are written synchronously.
+
+Arguments:
+
+  clientData  - Not used.
+
+Returns:
+
+  None
+
+--*/
+{
+  WaitForSingleObject (LogQueueMutex, INFINITE);
+  if (NULL != LogQueueThread) {
+    LogQueueAsync   = FALSE;
+    LogQueueFailed  = TRUE;
+    LogQueueRun     = FALSE;
+    SetEvent (LogQueueEvent);
+    WaitForSingleObject (LogQueueThread, INFINITE);
+    CloseHandle (LogQueueThread);
+    LogQueueThread  = NULL;
+
+    //
+    // A producer may have pushed after the writer looked the last time
+    //
+    LogQueueDrain ();
+    LogQueueShowScreen ();
+  }
+
+  ReleaseMutex (LogQueueMutex);
+}
@@ -0,0 +1,132 @@
+/** @file
+
+  Copyright 2006 - 2011 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2011, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+    EmsLogQueue.h
+
+Abstract:
+
+    Data definition for the asynchronous log writer
+
+--*/
+
+#ifndef __EMS_LOG_QUEUE_H__
+#define __EMS_LOG_QUEUE_H__
+
+#include <stdio.h>
+#include <EmsTypes.h>
+
+//
+// The screen is updated at most once per interval, with all the text
+// written in the meantime
+//
+#define EMS_LOG_SCREEN_INTERVAL         100
+
+//
+// Counters of the log writer
+//
+typedef struct {
+  UINT32            Records;
+  UINT32            Batches;
+  UINT32            ScreenUpdates;
+  UINT32            MaxBatch;
+} EMS_LOG_QUEUE_STAT;
+
+EFI_STATUS
+EmsLogQueueWrite (
+  IN FILE           *File1,
+  IN FILE           *File2,
+  IN BOOLEAN        Screen,
+  IN CONST INT8     *String
+  )
+/*++
+
+Routine Description:
+
+  Write a string to up to two files and optionally to the screen. In the
+  asynchronous mode the string is copied and queued for the writer thread,
+  the files must stay open until EmsLogQueueFlush returns.
+
+Arguments:
+
+  File1   - The first file, or NULL.
+  File2   - The second file, or NULL.
+  Screen  - Also output the string to the screen.
+  String  - The string to be written.
+
+Returns:
+
+  EFI_SUCCESS           - Successfully.
+  EFI_OUT_OF_RESOURCES  - The string could not be queued.
+
+--*/
+;
+
+VOID
+EmsLogQueueFlush (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Wait until every string queued before the call is written and shown.
+
+--*/
+;
+
+VOID
+EmsLogQueueSetAsync (
+  IN BOOLEAN        Async
+  )
+/*++
+
+Routine Description:
+
+  Select the asynchronous or the synchronous mode. The queue is flushed
+  first, so the order of the strings is kept.
+
+--*/
+;
+
+BOOLEAN
+EmsLogQueueIsAsync (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Return TRUE if the strings are queued for the writer thread.
+
+--*/
+;
+
+VOID
+EmsLogQueueGetStat (
+  OUT EMS_LOG_QUEUE_STAT  *Stat
+  )
+/*++
+
+Routine Description:
+
+  Get the counters of the log writer, and reset them.
+
+--*/
+;
+
+#endif // __EMS_LOG_QUEUE_H__
@@ -24,7 +24,7 @@ Abstract:
 
 --*/
 
-#include <windows.h>
+#include "EmsPlatform.h"
 #include "EmsLogReport.h"
 #include "EmsLogUtility.h"
 #include "EmsUtilityString.h"
@@ -393,6 +393,8 @@ NextLog:
       }
     }
 
+    FindClose (LogFind);
+
 NextProtocol:
     if (!FindNextFile (ProtocolFind, &FindFileData)) {
       if (GetLastError () == ERROR_NO_MORE_FILES) {
@@ -402,6 +404,8 @@ NextProtocol:
       }
     }
   }
+
+  FindClose (ProtocolFind);
   //
   // write the repotr information to the report file
   //
@@ -674,6 +678,8 @@ NextLog:
       }
     }
 
+    FindClose (LogFind);
+
 NextProtocol:
     if (!FindNextFile (ProtocolFind, &FindFileData)) {
       if (GetLastError () == ERROR_NO_MORE_FILES) {
@@ -683,6 +689,8 @@ NextProtocol:
       }
     }
   }
+
+  FindClose (ProtocolFind);
   //
   // write the repotr information to the report file
   //
@@ -51,6 +51,7 @@ Abstract:
 
 #include "EmsNet.h"
 #include "EmsLogUtility.h"
+#include "EmsLogQueue.h"
 #include "EmsUtilityString.h"
 
 STATIC INT8           HexStr[] = {
@@ -627,6 +628,8 @@ Returns:
 
 --*/
 {
+  EmsLogQueueFlush ();
+
   if(Private.CaseLog) fclose(Private.CaseLog);
   if(Private.CaseKey) fclose(Private.CaseKey);
   if(Private.SummaryLog) fclose (Private.SummaryLog);
@@ -1049,8 +1052,10 @@ Returns:
 	free(AssertionFree);
   }
   //
-  // close files
+  // close files, once the queued strings are written
   //
+  EmsLogQueueFlush ();
+
   fclose (Private.CaseLog);
   fclose (Private.CaseKey);
   fclose (Private.SummaryLog);
@@ -1117,7 +1122,7 @@ WriteLogFile (
 
 Routine Description:
 
-  write string to log files
+  write string to log files and to the screen, through the log writer
 
 Arguments:
 
@@ -1125,25 +1130,15 @@ Arguments:
 
 Returns:
 
-  EFI_SUCCESS   - Successfully.
+  EFI_SUCCESS           - Successfully.
+  EFI_OUT_OF_RESOURCES  - The string could not be queued.
 
 --*/
 {
   //
-  // write to case log file and summary log file
-  //
-  if (Private.CaseLog != NULL) {
-    fwrite (String, strlen (String), 1, Private.CaseLog);
-  }
-
-  if (Private.SummaryLog != NULL) {
-    fwrite (String, strlen (String), 1, Private.SummaryLog);
-  }
-  //
-  // output screen
+  // write to case log file and summary log file, and output screen
   //
-  Output2Screen (String);
-  return EFI_SUCCESS;
+  return EmsLogQueueWrite (Private.CaseLog, Private.SummaryLog, TRUE, String);
 }
 
 EFI_STATUS
@@ -1154,7 +1149,7 @@ WriteKeyFile (
 
 Routine Description:
 
-  write string to key files
+  write string to key files, through the log writer
 
 Arguments:
 
@@ -1162,22 +1157,15 @@ Arguments:
 
 Returns:
 
-  EFI_SUCCESS   - Successfully.
+  EFI_SUCCESS           - Successfully.
+  EFI_OUT_OF_RESOURCES  - The string could not be queued.
 
 --*/
 {
   //
   // write to case key file and summary key file
   //
-  if (Private.CaseKey != NULL) {
-    fwrite (String, strlen (String), 1, Private.CaseKey);
-  }
-
-  if (Private.SummaryKey != NULL) {
-    fwrite (String, strlen (String), 1, Private.SummaryKey);
-  }
-
-  return EFI_SUCCESS;
+  return EmsLogQueueWrite (Private.CaseKey, Private.SummaryKey, FALSE, String);
 }
 
 EFI_STATUS
@@ -43,144 +43,84 @@ STATIC Tcl_CmdProc  TclStartCapture;
 STATIC Tcl_CmdProc  TclEndCapture;
 STATIC Tcl_CmdProc  TclReceiveCcbPacket;
 
+STATIC Tcl_CmdProc  TclCaptureStatistics;
+
 STATIC INT8         EmsFilter[MAX_FILTER_LEN];
-STATIC CAP_INFO     *Info = NULL;
 extern INT8         *EmsInterface;
 
 STATIC
-VOID_P
-GotOnePacket (
-  IN u_char                   *UserStr,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST u_char             *Packet
-  );
-
-INT32
-ThreadCapture (
-  IN     UINT32 Timeout
+PACKET_T *
+EngineCapture (
+  IN ENGINE_CONSUMER  *Consumer,
+  IN UINT32           Timeout,
+  IN CONST INT8       *Name
   )
 /*++
 
 Routine Description:
 
-  Thread to capture packet continuously.
+  Receive one packet from a consumer of the capture engine, and create a
+  packet with the given name from it. The packet is not added to the packet
+  list.
 
 Arguments:
 
-  Timeout - Timeout value used in pcap API.
+  Consumer  - Consumer of the capture engine.
+  Timeout   - Timeout value in seconds.
+  Name      - The name of the packet to create.
 
 Returns:
 
-  0  - Success.
-  -1 - Failure.
+  The created packet, or NULL if no packet is received.
 
 --*/
 {
-  INT8                ErrBuff[PCAP_ERRBUF_SIZE * 2];
-  pcap_t              *Des;
-  struct bpf_program  Bp;
-  INT8                *TempFilter;
-  INT32               Index;
-  INT32               Res;
-  UINT32              DueTime;
-  Index = 0;
-
-  /* Open the device */
-  if ((
-        Des = pcap_open_live (
-                    EmsInterface,         // name of the device
-                    65536,                // portion of the packet to capture
-                    1,                    // promiscuous mode
-                    10,                    // read timeout
-                    ErrBuff               // error buffer
-                    )) == NULL) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_QUIET,
-      "CapturePacket: Cannot open network device to capture Packet - %a %a:%d",
-      ErrBuff,
-      __FILE__,
-      __LINE__
-      );
-    return -1;
-  }
-
-  if (0 == strcmp_i (EmsFilter, " ALL")) {
-    TempFilter = NULL;
-  } else {
-    TempFilter = EmsFilter;
-  }
-
-  if (-1 == pcap_compile (Des, &Bp, TempFilter, 0, 0xFFFFFF)) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_QUIET,
-      "CapturePacket: Cannot compile the Packet Filter - %a:%d",
-      __FILE__,
-      __LINE__
-      );
-    goto ErrorExit;
-  }
+  ENGINE_PACKET Packet;
+  PACKET_T      *PacketPointer;
+  UINT32        DueTime;
+  UINT32        Now;
+
+  Now     = GetTickCount ();
+  DueTime = Now + Timeout * 1000;
+  while (Now <= DueTime) {
+    if (!EmsEngineReceive (Consumer, DueTime - Now, &Packet)) {
+      break;
+    }
 
-  if (-1 == pcap_setfilter (Des, &Bp)) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_QUIET,
-      "CapturePacket: Cannot set Packet Filter - %a:%d",
-      __FILE__,
-      __LINE__
-      );
-    goto ErrorExit;
-  }
+    PacketPointer = EmsPacketCreate (Name, Packet.Data, Packet.CapLen, &Packet.Time);
 
-  DueTime = GetTickCount ();
-  DueTime = DueTime + Timeout * 1000;
-  while (1) {
-    //
-    // bugbug
     //
-    // Tcl_DoOneEvent(TCL_TIMER_EVEMS);
+    // A packet overwritten during the copy is lost, wait for the next one
     //
-    Res = pcap_dispatch (Des, 1, GotOnePacket, NULL);
-    if (1 == Res) {
-      break;
+    if (EmsEngineRelease (Consumer, &Packet)) {
+      return PacketPointer;
     }
 
-    if (GetTickCount () >= DueTime) {
-      break;
+    if (PacketPointer) {
+      EmsPacketDestroy (PacketPointer);
     }
 
-    Tcl_Sleep (1);
-  }
-  //
-  //  res = pcap_next_ex( des, &header, &pkt_data);
-  //
-  if (Des->Packet) {
-    PacketFreePacket (Des->Packet);
-    Des->Packet = NULL;
+    Now = GetTickCount ();
   }
 
-  pcap_close (Des);
-  WSACleanup ();
-  return 0;
-ErrorExit:
-  return -1;
+  return NULL;
 }
 
+STATIC
 VOID_P
-GotOnePacket (
-  IN u_char                   *UserStr,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST u_char             *Packet
+EngineReplacePacket (
+  IN PACKET_T         *PacketPointer
   )
 /*++
 
 Routine Description:
 
-  Callback function to handle captured packet.
+  Add a captured packet to the packet list, replacing the packet with the
+  same name.
 
 Arguments:
 
-  UserStr - User string corresponds to user parameter of pcap_dispatch().
-  PktHdr  - Packet header buffer.
-  Packet  - Packet data buffer.
+  PacketPointer - The captured packet.
 
 Returns:
 
@@ -188,13 +128,15 @@ Returns:
 
 --*/
 {
-  if (Info) {
-    Info->Packet = malloc (PktHdr->len);
-    memcpy (Info->Packet, Packet, PktHdr->len);
-    Info->Len = PktHdr->len;
-    memcpy (&(Info->Time), &(PktHdr->ts), sizeof (struct timeval));
-    Info->GotOne = TRUE;
+  PACKET_T  *OldPacket;
+
+  OldPacket = EmsPacketFindByName (PacketPointer->Name);
+  if (OldPacket) {
+    EmsPacketRemove (OldPacket);
+    EmsPacketDestroy (OldPacket);
   }
+
+  EmsPacketAdd (PacketPointer);
 }
 
 VOID_P
@@ -259,6 +201,14 @@ Returns:
     (ClientData) NULL,
     (Tcl_CmdDeleteProc *) NULL
     );
+
+  Tcl_CreateCommand (
+    Interp,
+    "CaptureStatistics",
+    TclCaptureStatistics,
+    (ClientData) NULL,
+    (Tcl_CmdDeleteProc *) NULL
+    );
 }
 
 STATIC
@@ -288,11 +238,12 @@ Returns:
 
 --*/
 {
-  INT8      *Name;
-  UINT32    Timeout;
-  PACKET_T  *PacketPointer;
-  INT8      ErrBuff[1000];
-  UINT32    Count;
+  INT8            *Name;
+  UINT32          Timeout;
+  PACKET_T        *PacketPointer;
+  ENGINE_CONSUMER *Consumer;
+  INT8            ErrBuff[1000];
+  UINT32          Count;
 
   Count = 0;
 
@@ -301,7 +252,7 @@ Returns:
   // Parse argument
   //
   if (Argc < 4) {
-    goto ErrorExit;
+    goto arg_wrong;
   }
 
   Name = (INT8 *) Argv[1];
@@ -319,66 +270,31 @@ Returns:
   //
   //  if (0 == timeout) goto arg_wrong;
   //
-  Info = (CAP_INFO *) calloc (sizeof (CAP_INFO), 1);
-
-  if (NULL == Info) {
-    sprintf (ErrBuff, "CapturePacket: Fail to allocate memory.");
-    goto ErrorExit;
-  }
-
-  if (-1 == ThreadCapture (Timeout)) {
+  Consumer = EmsEngineOpen (
+               EmsInterface,
+               "CapturePacket",
+               (0 == strcmp_i (EmsFilter, " ALL")) ? NULL : EmsFilter
+               );
+  if (NULL == Consumer) {
     sprintf (ErrBuff, "CapturePacket: Filter error.");
     goto ErrorExit;
-  };
-
-  if (Info->GotOne == TRUE) {
-    PacketPointer = EmsPacketFindByName (Name);
-    if (PacketPointer) {
-      EmsPacketRemove (PacketPointer);
-      EmsPacketDestroy (PacketPointer);
-    }
-
-    PacketPointer = EmsPacketCreate (Name, Info->Packet, Info->Len, &(Info->Time));
-    EmsPacketAdd (PacketPointer);
-    Count = 1;
-  } else {
-    Count = 0;
   }
 
-  if (Info) {
-    if (Info->Packet) {
-      free (Info->Packet);
-    }
+  PacketPointer = EngineCapture (Consumer, Timeout, Name);
+  EmsEngineClose (Consumer);
 
-    free (Info);
-    Info = NULL;
+  if (PacketPointer) {
+    EngineReplacePacket (PacketPointer);
+    Count = 1;
   }
 
   sprintf (ErrBuff, "%d", Count);
   Tcl_AppendResult (Interp, ErrBuff, (INT8 *) NULL);
   return TCL_OK;
 ErrorExit:
-  if (Info) {
-    if (Info->Packet) {
-      free (Info->Packet);
-    }
-
-    free (Info);
-    Info = NULL;
-  }
-
   Tcl_AppendResult (Interp, ErrBuff, (INT8 *) NULL);
   return TCL_ERROR;
 arg_wrong:
-  if (Info) {
-    if (Info->Packet) {
-      free (Info->Packet);
-    }
-
-    free (Info);
-    Info = NULL;
-  }
-
   Tcl_AppendResult (Interp, "CapturePacket: CapturePacket Name -t Timeout\n", (INT8 *) NULL);
   return TCL_ERROR;
 }
@@ -432,58 +348,24 @@ Returns:
   return TCL_OK;
 }
 
-STATIC
-VOID_P
-CcbGotPacket (
-  IN u_char                   *User,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST u_char             *Packet
-  )
-/*++
-
-Routine Description:
-
-  Callback function used to handle CCB (Capture Control Block) packet.
-
-Arguments:
-
-  User    - User string corresponds to user parameter of pcap_dispatch().
-  PktHdr  - Packet header buffer.
-  Packet  - Packet data buffer.
-
-Returns:
-
-  None.
-
---*/
-{
-  CCB *Ccb;
-
-  Ccb = (CCB *) User;
-  if (Ccb) {
-    Ccb->ReceiveBuff = malloc (PktHdr->len);
-    memcpy (Ccb->ReceiveBuff, Packet, PktHdr->len);
-    Ccb->ReceiveLen = PktHdr->len;
-    Ccb->Received   = 1;
-    memcpy (&(Ccb->Time), &(PktHdr->ts), sizeof (struct timeval));
-  }
-}
-
 INT32
 EmsCcbCapture (
-  IN UINT32 Timeout,
-  IN CCB    *Ccb
+  IN UINT32     Timeout,
+  IN CCB        *Ccb,
+  IN CONST INT8 *Name
   )
 /*++
 
 Routine Description:
 
-  One specified process be responsible for capturing packet
+  Receive one packet using a CCB (Capture Control Block), and save it as
+  a packet with the given name.
 
 Arguments:
 
   Timeout - Timeout value for packet capturing.
   Ccb     - CCB context.
+  Name    - The name of the packet.
 
 Returns:
 
@@ -491,32 +373,16 @@ Returns:
 
 --*/
 {
-  INT32   Res;
-  UINT32  DueTime;
+  PACKET_T  *PacketPointer;
 
   Ccb->Received = 0;
 
-  DueTime       = GetTickCount ();
-  DueTime       = DueTime + Timeout * 1000;
-  while (1) {
-    //
-    // bugbug
-    // There is one specified process be responsible for capturing packet,
-    // which is different from other packets' capture. So the calling of this
-    // function may cause packet capture blocking.
-    //
-    // Tcl_DoOneEvent(TCL_TIMER_EVEMS);
-    //
-    Res = pcap_dispatch (Ccb->Capturer, 1, CcbGotPacket, (UINT8 *) Ccb);
-    if (1 == Res) {
-      break;
-    }
-
-    if (GetTickCount () >= DueTime) {
-      break;
-    }
-
-    Tcl_Sleep (1);
+  PacketPointer = EngineCapture (Ccb->Consumer, Timeout, Name);
+  if (PacketPointer) {
+    Ccb->ReceiveLen = PacketPointer->DataLen;
+    Ccb->Received   = 1;
+    memcpy (&(Ccb->Time), &(PacketPointer->Time), sizeof (struct timeval));
+    EngineReplacePacket (PacketPointer);
   }
 
   return 0;
@@ -549,15 +415,10 @@ Returns:
 
 --*/
 {
-  CONST INT8     *Name;
-  CCB                 *Ccb;
-  //
-  //  HANDLE handle;
-  //
-  INT8                ErrBuff[1000];
-  INT8                *TempFilter;
-  struct bpf_program  Bp;
-  INT32               Index;
+  CONST INT8  *Name;
+  CCB         *Ccb;
+  INT8        ErrBuff[1000];
+  INT32       Index;
 
   Index = 0;
 
@@ -588,51 +449,22 @@ Returns:
     strcat (Ccb->CaptureFilter, Argv[Index]);
   }
 
-  Ccb->ReceiveBuff  = NULL;
   Ccb->ReceiveLen   = 0;
   Ccb->Received     = 0;
 
-  /* Open the capture device */
-  if ((
-        Ccb->Capturer = pcap_open_live (
-                    EmsInterface,         // name of the device
-                    65536,                // portion of the packet to capture
-                    1,                    // promiscuous mode
-                    1,                    // read timeout
-                    ErrBuff               // error buffer
-                    )) == NULL) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_QUIET,
-      "StartCapture: Cannot open network device to capture Packet - %a %a:%d",
-      ErrBuff,
-      __FILE__,
-      __LINE__
-      );
-    free (Ccb);
-    goto ErrorExit;
-  }
-
-  if (0 == strcmp_i (Ccb->CaptureFilter, " ALL")) {
-    TempFilter = NULL;
-  } else {
-    TempFilter = Ccb->CaptureFilter;
-  }
-
-  if (-1 == pcap_compile (Ccb->Capturer, &Bp, TempFilter, 0, 0xFFFFFF)) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_QUIET,
-      "StartCapture: Cannot compile the Packet Filter - %a:%d",
-      __FILE__,
-      __LINE__
-      );
-    free (Ccb);
-    goto ErrorExit;
-  }
-
-  if (-1 == pcap_setfilter (Ccb->Capturer, &Bp)) {
+  //
+  // Open a consumer of the capture engine
+  //
+  Ccb->Consumer = EmsEngineOpen (
+                    EmsInterface,
+                    Name,
+                    (0 == strcmp_i (Ccb->CaptureFilter, " ALL")) ? NULL : Ccb->CaptureFilter
+                    );
+  if (NULL == Ccb->Consumer) {
     RecordMessage (
       EMS_VERBOSE_LEVEL_QUIET,
-      "StartCapture: Cannot set Packet Filter - %a:%d",
+      "StartCapture: Cannot start capture %a - %a:%d",
+      Name,
       __FILE__,
       __LINE__
       );
@@ -681,7 +513,6 @@ Returns:
   CCB       *Ccb;
   UINT32    Timeout;
   UINT32    Count;
-  PACKET_T  *PacketPointer;
   INT8      ErrBuff[1000];
 
   Count = 0;
@@ -718,7 +549,7 @@ Returns:
     goto ErrorExit;
   }
 
-  if (EmsCcbCapture (Timeout, Ccb) < 0) {
+  if (EmsCcbCapture (Timeout, Ccb, PacketName) < 0) {
     Tcl_AppendResult (
       Interp,
       "ReceiveCcbPacket: Fail to receive Packet using capture control block ccb",
@@ -729,24 +560,7 @@ Returns:
   //
   // the capture control block received a packet
   //
-  if (Ccb->Received) {
-    PacketPointer = EmsPacketFindByName (PacketName);
-    if (PacketPointer) {
-      EmsPacketRemove (PacketPointer);
-      EmsPacketDestroy (PacketPointer);
-    }
-
-    PacketPointer = EmsPacketCreate (PacketName, Ccb->ReceiveBuff, Ccb->ReceiveLen, &(Ccb->Time));
-    EmsPacketAdd (PacketPointer);
-    Count = 1;
-  } else {
-    Count = 0;
-  }
-
-  if (Ccb->ReceiveBuff) {
-    free (Ccb->ReceiveBuff);
-    Ccb->ReceiveBuff = NULL;
-  }
+  Count = Ccb->Received ? 1 : 0;
 
   sprintf (ErrBuff, "%d", Count);
   Tcl_AppendResult (Interp, ErrBuff, (INT8 *) NULL);
@@ -813,12 +627,7 @@ Returns:
       Ccb   = (CCB *) (Node1->Goods);
 
       EmsCcbDestroyTcls (Interp, Node1->Name);
-      if (Ccb->Capturer->Packet) {
-        PacketFreePacket (Ccb->Capturer->Packet);
-        Ccb->Capturer->Packet = NULL;
-      }
-
-      pcap_close (Ccb->Capturer);
+      EmsEngineClose (Ccb->Consumer);
 
       EmsNlFreeNode (Node1);
     }
@@ -839,12 +648,7 @@ Returns:
 
     EmsCcbDestroyTcls (Interp, Argv[1]);
     Ccb = (CCB *) (Node->Goods);
-    if ((Ccb->Capturer)->Packet) {
-      PacketFreePacket ((Ccb->Capturer)->Packet);
-      (Ccb->Capturer)->Packet = NULL;
-    }
-
-    pcap_close (Ccb->Capturer);
+    EmsEngineClose (Ccb->Consumer);
 
     EmsNlFreeNode (Node);
     if (CcbList == NULL) {
@@ -858,6 +662,53 @@ ErrorExit:
   return TCL_ERROR;
 }
 
+STATIC
+INT32
+TclCaptureStatistics (
+  IN ClientData        clientData,
+  IN Tcl_Interp        *Interp,
+  IN INT32             Argc,
+  IN CONST84 INT8      *Argv[]
+  )
+/*++
+
+Routine Description:
+
+  TCL command "CaptureStatistics" implementation routine. It returns the
+  packets received and dropped by the capture engines, and the packets
+  delivered to and lost by each consumer.
+
+Arguments:
+
+  clientData  - Private data, if any.
+  Interp      - TCL intepreter.
+  Argc        - Argument counter.
+  Argv        - Argument value pointer array.
+
+Returns:
+
+  TCL_OK or TCL_ERROR
+
+--*/
+{
+  INT8  Buffer[4096];
+
+  LogCurrentCommand (Argc, Argv);
+
+  if (Argc != 1) {
+    Tcl_AppendResult (
+      Interp,
+      "CaptureStatistics: CaptureStatistics",
+      (INT8 *) NULL
+      );
+    return TCL_ERROR;
+  }
+
+  EmsEngineStatistics (Buffer, sizeof (Buffer));
+  Tcl_AppendResult (Interp, Buffer, (INT8 *) NULL);
+  return TCL_OK;
+}
+
 VOID
 EmsCaptureEndAll(
   VOID
@@ -888,12 +739,7 @@ Returns:
 
 	Ccb     = (CCB *) (Node->Goods);
 	EmsCcbDestroyTcls (EmsThreadSelf()->Interp, Node->Name);
-	if(Ccb->Capturer->Packet)
-    {
-      PacketFreePacket(Ccb->Capturer->Packet);
-	  Ccb->Capturer->Packet = NULL;
-    }
-	pcap_close(Ccb->Capturer);
+	EmsEngineClose (Ccb->Consumer);
     EmsNlFreeNode(Node);
   }
 
@@ -106,6 +106,9 @@ Returns:
   INT8      Ch;
   UINT32    Index;
   UINT32    Line;
+#ifndef WIN32
+  struct tm *dtime;
+#endif
 
   LogCurrentCommand (Argc, Argv);
 
@@ -145,7 +148,7 @@ Returns:
     Buff
     );
 #else
-  dtime = localtime (&PacketPointer->Time.tv_sec);
+  dtime = localtime ((const time_t *)&PacketPointer->Time.tv_sec);
   strftime (Str, sizeof (Str), "%H:%M:%S", dtime);
 
   sprintf (
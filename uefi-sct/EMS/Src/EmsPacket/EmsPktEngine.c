@@ -0,0 +1,732 @@
+/** @file
+ 
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR> 
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+ 
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+Module Name:
+  
+    EmsPktEngine.c
+    
+Abstract:
+
+    Implementation of the packet capture engine. The device of an interface
+    is opened once, and a reader thread copies the captured packets into a
+    ring of preallocated slots. The reader is the only writer of the ring and
+    never waits for the consumers; each consumer keeps its own cursor, checks
+    the slots against its own filter and counts the packets it lost because
+    the ring wrapped around. If the capture fails, the engine is marked failed
+    and all the consumers are woken up, so none of them waits for a packet
+    that never comes. The next EmsEngineOpen() on the interface starts a new
+    engine.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EmsPktEngine.h"
+#include "EmsLogUtility.h"
+
+STATIC ENGINE *EngineList  = NULL;
+STATIC PVOID  EngineMutex = NULL;   // Protects the engine list
+
+STATIC
+DWORD
+WINAPI
+EngineReader (
+  LPVOID lpParameter
+  );
+
+STATIC
+VOID_P
+EngineExitHandler (
+  IN ClientData clientData
+  );
+
+STATIC
+ENGINE *
+EngineStart (
+  IN CONST INT8 *Interface
+  )
+/*++
+
+Routine Description:
+
+  Open the device of an interface and start the reader thread.
+
+Arguments:
+
+  Interface - The name of the network device.
+
+Returns:
+
+  The engine, or NULL if failed.
+
+--*/
+{
+  ENGINE  *Engine;
+  INT8    ErrBuff[PCAP_ERRBUF_SIZE];
+  UINT32  Index;
+  DWORD   ThreadId;
+
+  Engine = calloc (1, sizeof (ENGINE));
+  if (NULL == Engine) {
+    return NULL;
+  }
+
+  Engine->Interface = _strdup (Interface);
+  Engine->Slots     = malloc (ENGINE_SLOT_NUM * sizeof (ENGINE_SLOT));
+  Engine->Mutex     = CreateMutex (NULL, FALSE, NULL);
+  if ((NULL == Engine->Interface) || (NULL == Engine->Slots) || (NULL == Engine->Mutex)) {
+    goto ErrorExit;
+  }
+
+  for (Index = 0; Index < ENGINE_SLOT_NUM; Index++) {
+    Engine->Slots[Index].Sequence = ENGINE_SLOT_BUSY;
+  }
+
+  if ((
+        Engine->Capturer = pcap_open_live (
+                            Engine->Interface,    // name of the device
+                            ENGINE_SLOT_SIZE,     // portion of the packet to capture
+                            1,                    // promiscuous mode
+                            ENGINE_READ_TIMEOUT,  // read timeout
+                            ErrBuff               // error buffer
+                            )) == NULL) {
+    RecordMessage (
+      EMS_VERBOSE_LEVEL_QUIET,
+      "EmsEngine: Cannot open network device %a - %a %a:%d",
+      Interface,
+      ErrBuff,
+      __FILE__,
+      __LINE__
+      );
+    goto ErrorExit;
+  }
+
+  Engine->Run     = TRUE;
+  Engine->Thread  = CreateThread (NULL, 0, EngineReader, (LPVOID) Engine, 0, &ThreadId);
+  if (NULL == Engine->Thread) {
+    RecordMessage (
+      EMS_VERBOSE_LEVEL_QUIET,
+      "EmsEngine: Cannot create reader thread - %a:%d",
+      __FILE__,
+      __LINE__
+      );
+    pcap_close (Engine->Capturer);
+    goto ErrorExit;
+  }
+
+  return Engine;
+
+ErrorExit:
+  if (Engine->Mutex) {
+    CloseHandle (Engine->Mutex);
+  }
+
+  free (Engine->Slots);
+  free (Engine->Interface);
+  free (Engine);
+  return NULL;
+}
+
+STATIC
+DWORD
+WINAPI
+EngineReader (
+  LPVOID lpParameter
+  )
+/*++
+
+Routine Description:
+
+  The reader thread of an engine. A slot is marked busy while it is written,
+  and the head is only moved after the slot is complete, so the consumers
+  never need a lock to read the ring.
+
+Arguments:
+
+  lpParameter - The engine.
+
+Returns:
+
+  0  - Success.
+  -1 - Failure.
+
+--*/
+{
+  ENGINE              *Engine;
+  ENGINE_SLOT         *Slot;
+  ENGINE_CONSUMER     *Consumer;
+  struct pcap_pkthdr  *PktHdr;
+  CONST UINT8         *Packet;
+  struct pcap_stat    Stat;
+  UINT32              Sequence;
+  INT32               Res;
+
+  Engine = (ENGINE *) lpParameter;
+
+  while (Engine->Run) {
+    Res = pcap_next_ex (Engine->Capturer, &PktHdr, &Packet);
+    if (Res < 0) {
+      RecordMessage (
+        EMS_VERBOSE_LEVEL_QUIET,
+        "EmsEngine: Capture on %a failed - %a %a:%d",
+        Engine->Interface,
+        pcap_geterr (Engine->Capturer),
+        __FILE__,
+        __LINE__
+        );
+
+      //
+      // Stop the engine and wake up all the consumers, they see the failure
+      // instead of waiting for the next packet
+      //
+      WaitForSingleObject (Engine->Mutex, INFINITE);
+      Engine->Failed  = TRUE;
+      Engine->Run     = FALSE;
+      for (Consumer = Engine->Consumers; Consumer != NULL; Consumer = Consumer->Next) {
+        SetEvent (Consumer->Arrived);
+      }
+
+      ReleaseMutex (Engine->Mutex);
+      return -1;
+    }
+
+    if (0 == Res) {
+      //
+      // Read timeout, a good time to update the driver statistics
+      //
+      if (0 == pcap_stats (Engine->Capturer, &Stat)) {
+        Engine->Dropped = Stat.ps_drop;
+      }
+
+      continue;
+    }
+
+    Sequence  = (UINT32) Engine->Head;
+    Slot      = &Engine->Slots[Sequence % ENGINE_SLOT_NUM];
+
+    InterlockedExchange (&Slot->Sequence, ENGINE_SLOT_BUSY);
+
+    Slot->Len     = PktHdr->len;
+    Slot->CapLen  = PktHdr->caplen;
+    if (Slot->CapLen > ENGINE_SLOT_SIZE) {
+      Slot->CapLen = ENGINE_SLOT_SIZE;
+    }
+
+    if (Slot->CapLen < Slot->Len) {
+      Engine->Truncated++;
+    }
+
+    memcpy (Slot->Data, Packet, Slot->CapLen);
+    memcpy (&Slot->Time, &PktHdr->ts, sizeof (struct timeval));
+
+    InterlockedExchange (&Slot->Sequence, (LONG) Sequence);
+    InterlockedExchange (&Engine->Head, (LONG) (Sequence + 1));
+
+    //
+    // Wake up the waiting consumers
+    //
+    WaitForSingleObject (Engine->Mutex, INFINITE);
+    for (Consumer = Engine->Consumers; Consumer != NULL; Consumer = Consumer->Next) {
+      SetEvent (Consumer->Arrived);
+    }
+
+    ReleaseMutex (Engine->Mutex);
+  }
+
+  return 0;
+}
+
+ENGINE_CONSUMER *
+EmsEngineOpen (
+  IN CONST INT8       *Interface,
+  IN CONST INT8       *Name,
+  IN CONST INT8       *Filter
+  )
+/*++
+
+Routine Description:
+
+  Open a consumer on the capture engine of an interface. The engine is started
+  on the first use of the interface and keeps running until EMS exits.
+  The consumer only sees the packets captured after it is opened. A failed
+  engine is replaced by a new one.
+
+Arguments:
+
+  Interface - The name of the network device.
+  Name      - The name of the consumer, used in the statistics.
+  Filter    - The BPF filter expression, or NULL to receive all the packets.
+
+Returns:
+
+  The consumer, or NULL if the engine or the filter failed.
+
+--*/
+{
+  ENGINE          *Engine;
+  ENGINE          **Link;
+  ENGINE_CONSUMER *Consumer;
+  HANDLE          Mutex;
+
+  if (NULL == Interface) {
+    return NULL;
+  }
+
+  //
+  // The consumers are opened from several threads
+  //
+  if (NULL == EngineMutex) {
+    Mutex = CreateMutex (NULL, FALSE, NULL);
+    if (NULL != InterlockedCompareExchangePointer (&EngineMutex, Mutex, NULL)) {
+      CloseHandle (Mutex);
+    }
+  }
+
+  //
+  // Find or start the engine of the interface
+  //
+  WaitForSingleObject (EngineMutex, INFINITE);
+  for (Link = &EngineList; *Link != NULL; Link = &(*Link)->Next) {
+    if (0 == strcmp ((*Link)->Interface, Interface)) {
+      break;
+    }
+  }
+
+  Engine = *Link;
+  if ((NULL != Engine) && Engine->Failed) {
+    //
+    // The reader of a failed engine has returned, so its device is closed
+    // here. The engine itself is kept for the consumers still holding it.
+    //
+    *Link = Engine->Next;
+    WaitForSingleObject (Engine->Thread, INFINITE);
+    pcap_close (Engine->Capturer);
+    Engine->Capturer = NULL;
+    Engine = NULL;
+  }
+
+  if (NULL == Engine) {
+    Engine = EngineStart (Interface);
+    if (NULL != Engine) {
+      if (NULL == EngineList) {
+        Tcl_CreateExitHandler (EngineExitHandler, NULL);
+      }
+
+      Engine->Next  = EngineList;
+      EngineList    = Engine;
+    }
+  }
+
+  ReleaseMutex (EngineMutex);
+  if (NULL == Engine) {
+    return NULL;
+  }
+
+  Consumer = calloc (1, sizeof (ENGINE_CONSUMER));
+  if (NULL == Consumer) {
+    return NULL;
+  }
+
+  Consumer->Engine  = Engine;
+  Consumer->Arrived = CreateEvent (NULL, FALSE, FALSE, NULL);
+  if (NULL == Consumer->Arrived) {
+    free (Consumer);
+    return NULL;
+  }
+
+  strncpy (Consumer->Name, Name, ENGINE_NAME_LEN - 1);
+
+  WaitForSingleObject (Engine->Mutex, INFINITE);
+  if (NULL != Filter) {
+    //
+    // The filter is checked by the consumer, but it is compiled for the
+    // link type of the engine device
+    //
+    if (-1 == pcap_compile (Engine->Capturer, &Consumer->Filter, (INT8 *) Filter, 0, 0xFFFFFF)) {
+      RecordMessage (
+        EMS_VERBOSE_LEVEL_QUIET,
+        "EmsEngine: Cannot compile the Packet Filter %a - %a %a:%d",
+        Filter,
+        pcap_geterr (Engine->Capturer),
+        __FILE__,
+        __LINE__
+        );
+      ReleaseMutex (Engine->Mutex);
+      CloseHandle (Consumer->Arrived);
+      free (Consumer);
+      return NULL;
+    }
+
+    Consumer->Filtered = TRUE;
+  }
+
+  Consumer->Cursor    = (UINT32) Engine->Head;
+  Consumer->Next      = Engine->Consumers;
+  Engine->Consumers   = Consumer;
+  ReleaseMutex (Engine->Mutex);
+
+  return Consumer;
+}
+
+VOID_P
+EmsEngineClose (
+  IN ENGINE_CONSUMER  *Consumer
+  )
+/*++
+
+Routine Description:
+
+  Close a consumer opened by EmsEngineOpen().
+
+Arguments:
+
+  Consumer  - The consumer to close.
+
+Returns:
+
+  None
+
+--*/
+{
+  ENGINE          *Engine;
+  ENGINE_CONSUMER **Link;
+
+  if (NULL == Consumer) {
+    return ;
+  }
+
+  Engine = Consumer->Engine;
+
+  WaitForSingleObject (Engine->Mutex, INFINITE);
+  for (Link = &Engine->Consumers; *Link != NULL; Link = &(*Link)->Next) {
+    if (*Link == Consumer) {
+      *Link = Consumer->Next;
+      break;
+    }
+  }
+
+  ReleaseMutex (Engine->Mutex);
+
+  if (Consumer->Filtered) {
+    pcap_freecode (&Consumer->Filter);
+  }
+
+  CloseHandle (Consumer->Arrived);
+  free (Consumer);
+}
+
+BOOLEAN
+EmsEngineReceive (
+  IN  ENGINE_CONSUMER *Consumer,
+  IN  UINT32          Timeout,
+  OUT ENGINE_PACKET   *Packet
+  )
+/*++
+
+Routine Description:
+
+  Wait for the next packet matching the filter of a consumer. The packet is
+  not copied, Packet->Data points into the ring.
+
+Arguments:
+
+  Consumer  - The consumer.
+  Timeout   - The maximum milliseconds to wait, 0 to only check the ring,
+              INFINITE to wait forever.
+  Packet    - The received packet.
+
+Returns:
+
+  TRUE if a packet is received, FALSE on timeout or if the engine failed.
+
+--*/
+{
+  ENGINE              *Engine;
+  ENGINE_SLOT         *Slot;
+  struct pcap_pkthdr  PktHdr;
+  UINT32              Head;
+  UINT32              Sequence;
+  UINT32              DueTime;
+  UINT32              Now;
+  BOOLEAN             Match;
+
+  Engine  = Consumer->Engine;
+  DueTime = GetTickCount () + Timeout;
+
+  while (1) {
+    Head = (UINT32) Engine->Head;
+
+    while (Consumer->Cursor != Head) {
+      //
+      // The oldest slot may be written by the reader at any time, so the
+      // consumer must not fall more than ENGINE_SLOT_NUM - 1 packets behind
+      //
+      if (Head - Consumer->Cursor > ENGINE_SLOT_NUM - 1) {
+        Consumer->Lost   += Head - Consumer->Cursor - (ENGINE_SLOT_NUM - 1);
+        Consumer->Cursor  = Head - (ENGINE_SLOT_NUM - 1);
+      }
+
+      Sequence          = Consumer->Cursor;
+      Slot              = &Engine->Slots[Sequence % ENGINE_SLOT_NUM];
+      Consumer->Cursor += 1;
+
+      if ((UINT32) Slot->Sequence != Sequence) {
+        Consumer->Lost++;
+        continue;
+      }
+
+      Packet->Sequence  = Sequence;
+      Packet->Data      = Slot->Data;
+      Packet->Len       = Slot->Len;
+      Packet->CapLen    = Slot->CapLen;
+      memcpy (&Packet->Time, &Slot->Time, sizeof (struct timeval));
+
+      Match = TRUE;
+      if (Consumer->Filtered) {
+        memcpy (&PktHdr.ts, &Packet->Time, sizeof (struct timeval));
+        PktHdr.caplen = Packet->CapLen;
+        PktHdr.len    = Packet->Len;
+        Match         = (BOOLEAN) (0 != pcap_offline_filter (&Consumer->Filter, &PktHdr, Packet->Data));
+      }
+
+      //
+      // The slot may have been overwritten while it was checked
+      //
+      if ((UINT32) Slot->Sequence != Sequence) {
+        Consumer->Lost++;
+        continue;
+      }
+
+      if (Match) {
+        Consumer->Delivered++;
+        return TRUE;
+      }
+    }
+
+    //
+    // The packets left in the ring are delivered, but a failed engine gets
+    // no new ones
+    //
+    if (Engine->Failed) {
+      if (!Consumer->Reported) {
+        RecordMessage (
+          EMS_VERBOSE_LEVEL_QUIET,
+          "EmsEngine: %a stops receiving, the capture on %a failed - %a:%d",
+          Consumer->Name,
+          Engine->Interface,
+          __FILE__,
+          __LINE__
+          );
+        Consumer->Reported = TRUE;
+      }
+
+      return FALSE;
+    }
+
+    if (INFINITE == Timeout) {
+      WaitForSingleObject (Consumer->Arrived, INFINITE);
+      continue;
+    }
+
+    Now = GetTickCount ();
+    if (Now >= DueTime) {
+      return FALSE;
+    }
+
+    WaitForSingleObject (Consumer->Arrived, DueTime - Now);
+  }
+}
+
+BOOLEAN
+EmsEngineFailed (
+  IN ENGINE_CONSUMER  *Consumer
+  )
+/*++
+
+Routine Description:
+
+  Check whether the engine of a consumer failed. A failed engine never
+  receives any more packets, the consumer must be closed and opened again.
+
+Arguments:
+
+  Consumer  - The consumer.
+
+Returns:
+
+  TRUE if the engine failed.
+
+--*/
+{
+  return Consumer->Engine->Failed;
+}
+
+BOOLEAN
+EmsEngineRelease (
+  IN ENGINE_CONSUMER  *Consumer,
+  IN ENGINE_PACKET    *Packet
+  )
+/*++
+
+Routine Description:
+
+  Finish using a packet returned by EmsEngineReceive(). The reader never waits
+  for the consumers, so a slow consumer may have its packet overwritten. The
+  data read from the packet is only valid if this returns TRUE.
+
+Arguments:
+
+  Consumer  - The consumer.
+  Packet    - The packet returned by EmsEngineReceive().
+
+Returns:
+
+  TRUE if the packet was intact, FALSE if it was overwritten.
+
+--*/
+{
+  ENGINE_SLOT *Slot;
+
+  Slot = &Consumer->Engine->Slots[Packet->Sequence % ENGINE_SLOT_NUM];
+  if ((UINT32) Slot->Sequence != Packet->Sequence) {
+    Consumer->Lost++;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+INT32
+EmsEngineStatistics (
+  OUT INT8            *Buffer,
+  IN  UINT32          Size
+  )
+/*++
+
+Routine Description:
+
+  Format the statistics of all the engines and consumers, one line each.
+
+Arguments:
+
+  Buffer    - The buffer for the statistics.
+  Size      - The size of the buffer.
+
+Returns:
+
+  The length of the statistics.
+
+--*/
+{
+  ENGINE          *Engine;
+  ENGINE_CONSUMER *Consumer;
+  UINT32          Len;
+  INT8            Line[ENGINE_NAME_LEN + 128];
+
+  Len       = 0;
+  Buffer[0] = '\0';
+  if (NULL == EngineMutex) {
+    return 0;
+  }
+
+  WaitForSingleObject (EngineMutex, INFINITE);
+  for (Engine = EngineList; Engine != NULL; Engine = Engine->Next) {
+    WaitForSingleObject (Engine->Mutex, INFINITE);
+    _snprintf (
+      Line,
+      sizeof (Line) - 1,
+      "%s received %u dropped %u truncated %u\n",
+      Engine->Interface,
+      (UINT32) Engine->Head,
+      Engine->Dropped,
+      Engine->Truncated
+      );
+    Line[sizeof (Line) - 1] = '\0';
+
+    for (Consumer = Engine->Consumers; ; Consumer = Consumer->Next) {
+      if (Len + strlen (Line) >= Size) {
+        break;
+      }
+
+      strcpy (Buffer + Len, Line);
+      Len += strlen (Line);
+
+      if (NULL == Consumer) {
+        break;
+      }
+
+      sprintf (
+        Line,
+        "  %s delivered %u lost %u\n",
+        Consumer->Name,
+        Consumer->Delivered,
+        Consumer->Lost
+        );
+    }
+
+    ReleaseMutex (Engine->Mutex);
+  }
+
+  ReleaseMutex (EngineMutex);
+  return Len;
+}
+
+STATIC
+VOID_P
+EngineExitHandler (
+  IN ClientData clientData
+  )
+/*++
+
+Routine Description:
+
+  Stop the reader threads and close the devices of all the engines when EMS
+  exits. The engines are not freed, since the other threads may still wait
+  on their consumers.
+
+Arguments:
+
+  clientData  - Not used.
+
+Returns:
+
+  None
+
+--*/
+{
+  ENGINE  *Engine;
+
+  WaitForSingleObject (EngineMutex, INFINITE);
+  for (Engine = EngineList; Engine != NULL; Engine = Engine->Next) {
+    Engine->Run = FALSE;
+    WaitForSingleObject (Engine->Thread, INFINITE);
+
+#if defined(__WIN32__) || defined(WIN32)
+    //
+    // WinPcap keeps the packet of the driver in the capturer
+    //
+    if (Engine->Capturer->Packet) {
+      PacketFreePacket (Engine->Capturer->Packet);
+      Engine->Capturer->Packet = NULL;
+    }
+#endif
+
+    pcap_close (Engine->Capturer);
+  }
+
+  ReleaseMutex (EngineMutex);
+}
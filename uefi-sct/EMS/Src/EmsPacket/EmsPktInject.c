@@ -0,0 +1,328 @@
+/** @file
+ 
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR> 
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+ 
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+Module Name:
+  
+    EmsPktInject.c
+    
+Abstract:
+
+    Implementation of the packet injectors. The link layer device of an
+    interface is opened once and shared by everything that sends frames on
+    it, instead of a libnet context per packet or per TCB. On Linux a batch
+    of frames is written by one sendmmsg call on the same socket.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EmsPktInject.h"
+#include "EmsLogUtility.h"
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <errno.h>
+#endif
+
+STATIC INJECTOR *InjectorList  = NULL;
+STATIC PVOID    InjectorMutex = NULL;   // Protects the injector list
+
+STATIC
+VOID_P
+InjectorExitHandler (
+  IN ClientData clientData
+  );
+
+STATIC
+INJECTOR *
+InjectorStart (
+  IN CONST INT8 *Interface
+  )
+/*++
+
+Routine Description:
+
+  Open the link layer device of an interface.
+
+Arguments:
+
+  Interface - The name of the network device.
+
+Returns:
+
+  The injector, or NULL if failed.
+
+--*/
+{
+  INJECTOR  *Injector;
+  INT8      ErrBuf[LIBNET_ERRBUF_SIZE];
+
+  Injector = calloc (1, sizeof (INJECTOR));
+  if (NULL == Injector) {
+    return NULL;
+  }
+
+  Injector->Interface = _strdup (Interface);
+  if (NULL == Injector->Interface) {
+    goto ErrorExit;
+  }
+
+  Injector->Writer = libnet_init (LIBNET_LINK, Injector->Interface, ErrBuf);
+  if (NULL == Injector->Writer) {
+    RecordMessage (
+      EMS_VERBOSE_LEVEL_QUIET,
+      "EmsInjector: Cannot open the device %a - %a %a:%d",
+      Interface,
+      ErrBuf,
+      __FILE__,
+      __LINE__
+      );
+    goto ErrorExit;
+  }
+
+#if defined(__linux__)
+  Injector->IfIndex = if_nametoindex (Injector->Interface);
+#endif
+
+  return Injector;
+
+ErrorExit:
+  free (Injector->Interface);
+  free (Injector);
+  return NULL;
+}
+
+INJECTOR *
+EmsInjectorOpen (
+  IN CONST INT8       *Interface
+  )
+/*++
+
+Routine Description:
+
+  Get the injector of an interface. The injector is opened on the first use
+  of the interface and stays open until EMS exits.
+
+Arguments:
+
+  Interface - The name of the network device.
+
+Returns:
+
+  The injector, or NULL if the device cannot be opened.
+
+--*/
+{
+  INJECTOR  *Injector;
+  HANDLE    Mutex;
+
+  if (NULL == Interface) {
+    return NULL;
+  }
+
+  //
+  // The injectors are opened from several threads
+  //
+  if (NULL == InjectorMutex) {
+    Mutex = CreateMutex (NULL, FALSE, NULL);
+    if (NULL != InterlockedCompareExchangePointer (&InjectorMutex, Mutex, NULL)) {
+      CloseHandle (Mutex);
+    }
+  }
+
+  WaitForSingleObject (InjectorMutex, INFINITE);
+  for (Injector = InjectorList; Injector != NULL; Injector = Injector->Next) {
+    if (0 == strcmp (Injector->Interface, Interface)) {
+      break;
+    }
+  }
+
+  if (NULL == Injector) {
+    Injector = InjectorStart (Interface);
+    if (NULL != Injector) {
+      if (NULL == InjectorList) {
+        Tcl_CreateExitHandler (InjectorExitHandler, NULL);
+      }
+
+      Injector->Next  = InjectorList;
+      InjectorList    = Injector;
+    }
+  }
+
+  ReleaseMutex (InjectorMutex);
+  return Injector;
+}
+
+INT32
+EmsInjectorSend (
+  IN INJECTOR         *Injector,
+  IN UINT8            *Frame,
+  IN UINT32           Len
+  )
+/*++
+
+Routine Description:
+
+  Write a frame to the interface.
+
+Arguments:
+
+  Injector  - The injector.
+  Frame     - The frame, from the Ethernet header on.
+  Len       - The length of the frame.
+
+Returns:
+
+  The number of bytes written, or -1 if failed.
+
+--*/
+{
+  return libnet_write_link (Injector->Writer, Frame, Len);
+}
+
+UINT32
+EmsInjectorSendBatch (
+  IN INJECTOR         *Injector,
+  IN INJECT_FRAME     *Frames,
+  IN UINT32           Count
+  )
+/*++
+
+Routine Description:
+
+  Write several frames to the interface, in order. On Linux up to
+  INJECT_BATCH_MAX frames are handed to the kernel by one sendmmsg call,
+  elsewhere they are written one by one.
+
+Arguments:
+
+  Injector  - The injector.
+  Frames    - The frames.
+  Count     - The number of frames.
+
+Returns:
+
+  The number of frames written. The frames after the first failed one are
+  not written.
+
+--*/
+{
+  UINT32              Sent;
+#if defined(__linux__)
+  struct mmsghdr      Messages[INJECT_BATCH_MAX];
+  struct iovec        Vectors[INJECT_BATCH_MAX];
+  struct sockaddr_ll  Address;
+  UINT32              Batch;
+  UINT32              Index;
+  INT32               Result;
+#endif
+
+  Sent = 0;
+
+#if defined(__linux__)
+  if (0 != Injector->IfIndex) {
+    memset (&Address, 0, sizeof (Address));
+    Address.sll_family  = AF_PACKET;
+    Address.sll_ifindex = Injector->IfIndex;
+
+    memset (Messages, 0, sizeof (Messages));
+    while (Sent < Count) {
+      Batch = (Count - Sent < INJECT_BATCH_MAX) ? Count - Sent : INJECT_BATCH_MAX;
+      for (Index = 0; Index < Batch; Index++) {
+        Vectors[Index].iov_base               = Frames[Sent + Index].Data;
+        Vectors[Index].iov_len                = Frames[Sent + Index].Len;
+        Messages[Index].msg_hdr.msg_name      = &Address;
+        Messages[Index].msg_hdr.msg_namelen   = sizeof (Address);
+        Messages[Index].msg_hdr.msg_iov       = &Vectors[Index];
+        Messages[Index].msg_hdr.msg_iovlen    = 1;
+      }
+
+      Result = sendmmsg (libnet_getfd (Injector->Writer), Messages, Batch, 0);
+      if (Result < 0) {
+        if (EINTR == errno) {
+          continue;
+        }
+
+        //
+        // The socket of libnet may not take an address, e.g. an old
+        // SOCK_PACKET one. Write one by one from now on.
+        //
+        if (EINVAL == errno) {
+          Injector->IfIndex = 0;
+        }
+
+        break;
+      }
+
+      Sent += (UINT32) Result;
+      if ((UINT32) Result < Batch) {
+        return Sent;
+      }
+    }
+
+    if (Sent == Count) {
+      return Sent;
+    }
+  }
+#endif
+
+  for (; Sent < Count; Sent++) {
+    if (-1 == libnet_write_link (Injector->Writer, Frames[Sent].Data, Frames[Sent].Len)) {
+      break;
+    }
+  }
+
+  return Sent;
+}
+
+STATIC
+VOID_P
+InjectorExitHandler (
+  IN ClientData clientData
+  )
+/*++
+
+Routine Description:
+
+  Close the devices of all the injectors when EMS exits.
+
+Arguments:
+
+  clientData  - Not used.
+
+Returns:
+
+  None
+
+--*/
+{
+  INJECTOR  *Injector;
+
+  WaitForSingleObject (InjectorMutex, INFINITE);
+  while (NULL != InjectorList) {
+    Injector      = InjectorList;
+    InjectorList  = Injector->Next;
+
+    libnet_destroy (Injector->Writer);
+    free (Injector->Interface);
+    free (Injector);
+  }
+
+  ReleaseMutex (InjectorMutex);
+}
@@ -22,19 +22,55 @@ Abstract:
 
     Implementation for packet validation validation
 
+    A pattern is compiled once into a postfix program, with the field names
+    resolved to the indexes of the unpacked field list and the constants
+    converted. The programs are cached by the pattern text and the field
+    list, and evaluated without any global state, so the validation could be
+    done by several threads at the same time.
+
 --*/
 
 #include "EmsPktValidate.h"
 #include "EmsTypes.h"
 #include "EmsPktMain.h"
 #include "EmsProtocols.h"
+#include "EmsPktPattern.h"
 #include "EmsUtilityString.h"
 
-STATIC INT8     Expression[EXPR_MAX_LEN];
-STATIC BOOLEAN  Operands[EXPR_MAX_LEN];
-STATIC INT8     Operators[EXPR_MAX_LEN];
-STATIC BOOLEAN  *OperandTop;
-STATIC INT8     *OperatorTop;
+//
+// Instructions of a compiled pattern besides OP_AND, OP_OR and OP_NOT
+//
+#define PATTERN_OP_CONST    0x10
+#define PATTERN_OP_FIELD    0x11
+
+#define PATTERN_CACHE_SIZE  64
+
+typedef struct _PATTERN_INST_T {
+  UINT8           Op;
+  UINT8           Type;       /* Field type of PATTERN_OP_FIELD */
+  BOOLEAN         Result;     /* Value of PATTERN_OP_CONST */
+  UINT32          Field;      /* Index in the unpacked field list */
+  UINT32          Len;        /* Length of a STRING constant */
+  union {
+    UINT32        Value;
+    UINT8         Eth[6];
+    EMS_IPV6_ADDR IPv6Addr;
+    INT8          *String;
+  } Const;
+} PATTERN_INST_T;
+
+struct _PATTERN_T {
+  PATTERN_T       *Next;
+  UINT32          Hash;
+  INT8            *Text;
+  FIELD_T         *Fields;
+  UINT32          Depth;      /* Max depth of the operand stack */
+  UINT32          Count;
+  PATTERN_INST_T  *Inst;
+};
+
+STATIC PATTERN_T  *PatternCache[PATTERN_CACHE_SIZE];
+STATIC Tcl_Mutex  PatternCacheMutex;
 
 //
 // operators in packet validate expression  :
@@ -135,348 +171,547 @@ UINT32          Priority[6][6] = {
 };  /* # */
 
 STATIC
-VOID_P
-InitOperandStack (
-  VOID_P
+INT8
+GetOperatorIndex (
+  IN INT8 *OperatorName
   )
 /*++
 
 Routine Description:
 
-  Initialize the Stack of Operand
+  Get index of the Operator for convenience of comparing priority.
 
 Arguments:
 
-  VOID_P - None
+  OperatorName - The Operator per se.'+','-',etc..
 
 Returns:
 
-  None
+  The Operator's index.
 
 --*/
 {
-  BOOLEAN *PacketPointer;
   UINT32  Index;
-  PacketPointer = Operands;
-  for (Index = 0; Index < EXPR_MAX_LEN; Index++) {
-    PacketPointer[Index] = TRUE;
+  for (Index = 0; OperatorList[Index].Name; Index++) {
+    if (strlen (OperatorList[Index].Name) > strlen (OperatorName)) {
+      continue;
+    }
+
+    if (!(strncmp (OperatorList[Index].Name, OperatorName, strlen (OperatorList[Index].Name)))) {
+      return Index;
+    }
   }
+
+  return -1;
 }
 
 STATIC
-VOID_P
-PushOperandStack (
-  IN BOOLEAN Value
+UINT8
+ComparePriority (
+  IN INT8 Operator1,
+  IN INT8 Operator2
   )
 /*++
 
 Routine Description:
 
-  Push an Operand into Stack.
+  Compare priorities between two operators.
 
 Arguments:
 
-  Value - The Operand to push.
+  Operator1 - The operators.
+  Operator2 - The operators.
 
 Returns:
 
-  None
+  HIGHP, LOWP, EQUAP or ERRP
 
 --*/
 {
-  *OperandTop = Value;
-  OperandTop += 1;
+  return Priority[Operator1][Operator2];
 }
 
 STATIC
 BOOLEAN
-PopOperandStack (
-  VOID_P
+OneStepCalculate (
+  IN INT8        Operation,
+  IN BOOLEAN     Operand1,
+  IN BOOLEAN     Operand2
   )
 /*++
 
 Routine Description:
 
-  Pop an Operand from Stack.
+  Just execute a step of calculate
 
 Arguments:
 
-  None
+  Operation - The Operator,'AND' 'OR' 'NOT' '/'
+  Operand1  - The 1st operand
+  Operand2  - The 2nd operand
 
 Returns:
 
-  The Operand on top of stack.
+  The calculated result.
 
 --*/
 {
-  OperandTop -= 1;
-  return *OperandTop;
+  BOOLEAN Result;
+  Result = TRUE;
+
+  switch (Operation) {
+  case OP_AND:
+    Result = Operand1 ? Operand2 : FALSE;
+    break;
+
+  case OP_OR:
+    Result = Operand1 ? TRUE : Operand2;
+    break;
+
+  case OP_NOT:
+    Result = Operand2 ? FALSE : TRUE;
+    break;
+
+  default:
+    break;
+  }
+
+  return Result;
 }
 
 STATIC
 BOOLEAN
-GetTopOperandStack (
-  VOID_P
+CompileOperand (
+  IN     INT8            *ExprP,
+  IN     FIELD_T         *Fields,
+  OUT    PATTERN_INST_T  *Inst,
+  OUT    UINT32          *Offset
   )
 /*++
 
 Routine Description:
 
-  Just get the top Operand from Stack, without any change to stack pointer.
+  Compile a Bool expression into an instruction. The field is resolved and
+  the constant is converted, but the expression is consumed as the former
+  per-packet parser did, so the patterns keep their meaning.
+  e.g. "ip_addr=192.168.88.1"
 
 Arguments:
 
-  None
+  ExprP   - The expression
+  Fields  - The unpacked field list
+  Inst    - The compiled instruction
+  Offset  - The offset the compilation end
 
 Returns:
 
-  The Operand on top of stack.
+  FALSE if the expression has no '=', TRUE otherwise.
 
 --*/
 {
-  return *(OperandTop - 1);
-}
-
-STATIC
-VOID_P
-InitOperatorStack (
-  VOID_P
-  )
-/*++
+  INT32   Status;
+  UINT32  Index;
+  UINT32  Len;
 
-Routine Description:
+  memset (Inst, 0, sizeof (PATTERN_INST_T));
+  Inst->Op      = PATTERN_OP_CONST;
+  Inst->Result  = FALSE;
 
-  Initialize the Operator Stack.
+  //
+  // Find first '='
+  //
+  for (Len = 0; ExprP[Len]; Len++) {
+    if (ExprP[Len] == '=') {
+      break;
+    }
+  }
 
-Arguments:
+  if (ExprP[Len] == '\0') {
+    return FALSE;
+  }
 
-  None
+  Len++;
 
-Returns:
+  for (; ExprP[Len]; Len++) {
+    if (ExprP[Len] != ' ') {
+      break;
+    }
+  }
 
-  None
+  *Offset = Len;
 
---*/
-{
-  INT8    *PacketPointer;
-  UINT32  Index;
-  PacketPointer = Operators;
+  for (Index = 0; Fields[Index].Name; Index++) {
+    if (0 != strncmp_i (Fields[Index].Name, ExprP, strlen (Fields[Index].Name))) {
+      continue;
+    }
 
-  for (Index = 0; Index < EXPR_MAX_LEN; Index++) {
-    PacketPointer[Index] = -1;
-  }
-}
+    Inst->Op    = PATTERN_OP_FIELD;
+    Inst->Type  = Fields[Index].Type;
+    Inst->Field = Index;
 
-/*++
+    switch (Fields[Index].Type) {
+    case OCTET1:
+    case OCTET2:
+    case OCTET4:
+      Status = AsciiStringToUint32 (ExprP + Len, &Inst->Const.Value);
+      break;
 
-Routine Description:
-   Push an Operator into Stack.
-Argumems:
-   The Operator to push.
-Returns:
---*/
-STATIC
-VOID_P
-PushOperatorStack (
-  IN INT8 Value
-  )
-/*++
+    case IPADDR:
+      Status = AsciiStringToIpv4 (ExprP + Len, &Inst->Const.Value);
+      break;
 
-Routine Description:
+    case IPV6ADDR:
+      Status = AsciiStringToIpv6 (ExprP + Len, &Inst->Const.IPv6Addr);
+      break;
 
-  Push an Operator into Stack.
+    case MACADDR:
+      Status = AsciiStringToMac (ExprP + Len, Inst->Const.Eth);
+      break;
 
-Arguments:
+    case STRING:
+      //
+      // The value is compared in the length of the field name part
+      //
+      Inst->Len           = Len;
+      Inst->Const.String  = malloc (Len + 1);
+      if (NULL == Inst->Const.String) {
+        Inst->Op      = PATTERN_OP_CONST;
+        Inst->Result  = ERROR_INTERNAL;
+        return TRUE;
+      }
 
-  Value - The Operator to push.
+      strncpy (Inst->Const.String, ExprP + Len, Len);
+      Inst->Const.String[Len] = '\0';
+      return TRUE;
+
+    case PAYLOAD:
+    //
+    // How to validata payload ???
+    // Now case writer has to use "ParsePacket" to store the payload into
+    // a packet then validate it.
+    //
+    default:
+      Inst->Op      = PATTERN_OP_CONST;
+      Inst->Result  = ERROR_INTERNAL;
+      return TRUE;
+    }
 
-Returns:
+    if ((Status < 0) ||
+        ((Status == 0) && ((Inst->Type == OCTET1) || (Inst->Type == IPV6ADDR)))) {
+      Inst->Op      = PATTERN_OP_CONST;
+      Inst->Result  = ERROR_WRONGFORMAT;
+      return TRUE;
+    }
 
-  None
+    *Offset += Status;
+    return TRUE;
+  }
 
---*/
-{
-  *OperatorTop = Value;
-  OperatorTop += 1;
+  return TRUE;
 }
 
 STATIC
-INT8
-PopOperatorStack (
-  VOID_P
+BOOLEAN
+EvaluateOperand (
+  IN PATTERN_INST_T  *Inst,
+  IN FIELD_T         *Unpack
   )
 /*++
 
 Routine Description:
 
-  Pop an Operator from Stack.
+  Evaluate a compiled Bool expression on the unpacked fields.
 
 Arguments:
 
-  None
+  Inst    - The compiled instruction
+  Unpack  - The Data
 
 Returns:
 
-  The Operator on top of stack.
+  Calculated result.
 
 --*/
 {
-  OperatorTop -= 1;
-  return *OperatorTop;
-}
+  VOID_P  *Value;
+  UINT32  AddrIndex;
 
-STATIC
-INT8
-GetTopOperatorStack (
-  VOID_P
-  )
-/*++
+  if (PATTERN_OP_CONST == Inst->Op) {
+    return Inst->Result;
+  }
 
-Routine Description:
+  Value = Unpack[Inst->Field].Value;
 
-  Just get the top Operator from Stack, without any change to stack pointer.
+  switch (Inst->Type) {
+  case OCTET1:
+    return (BOOLEAN) ((UINT8) Inst->Const.Value == *(UINT8 *) Value);
 
-Arguments:
+  case OCTET2:
+    return (BOOLEAN) ((UINT16) Inst->Const.Value == *(UINT16 *) Value);
 
-  None
+  case OCTET4:
+  case IPADDR:
+    return (BOOLEAN) (Inst->Const.Value == *(UINT32 *) Value);
 
-Returns:
+  case IPV6ADDR:
+    for (AddrIndex = 0; AddrIndex < 8; AddrIndex++) {
+      if (((EMS_IPV6_ADDR *) Value)->__u6_addr.__u6_addr16[AddrIndex] !=
+          Inst->Const.IPv6Addr.__u6_addr.__u6_addr16[AddrIndex]) {
+        return FALSE;
+      }
+    }
+    return TRUE;
 
-  The Operator on top of stack.
+  case MACADDR:
+    return (BOOLEAN) (0 == memcmp (Value, Inst->Const.Eth, 6));
 
---*/
-{
-  return *(OperatorTop - 1);
+  case STRING:
+    if (Inst->Len != strlen (*(INT8 **) Value)) {
+      return FALSE;
+    }
+
+    return (BOOLEAN) (0 == strncmp (*(INT8 **) Value, Inst->Const.String, Inst->Len));
+
+  default:
+    return ERROR_INTERNAL;
+  }
 }
 
 STATIC
-INT8
-GetOperatorIndex (
-  IN INT8 *OperatorName
+VOID_P
+EmitConstant (
+  IN OUT PATTERN_T  *Program,
+  IN     BOOLEAN    Result
   )
 /*++
 
 Routine Description:
 
-  Get index of the Operator for convenience of comparing priority.
+  Replace the whole program with a constant result.
 
 Arguments:
 
-  OperatorName - The Operator per se.'+','-',etc..
+  Program - The compiled pattern
+  Result  - The constant result
 
 Returns:
 
-  The Operator's index.
+  None
 
 --*/
 {
   UINT32  Index;
-  for (Index = 0; OperatorList[Index].Name; Index++) {
-    if (strlen (OperatorList[Index].Name) > strlen (OperatorName)) {
-      continue;
-    }
 
-    if (!(strncmp (OperatorList[Index].Name, OperatorName, strlen (OperatorList[Index].Name)))) {
-      return Index;
+  for (Index = 0; Index < Program->Count; Index++) {
+    if ((PATTERN_OP_FIELD == Program->Inst[Index].Op) && (STRING == Program->Inst[Index].Type)) {
+      free (Program->Inst[Index].Const.String);
     }
   }
 
-  return -1;
+  memset (Program->Inst, 0, sizeof (PATTERN_INST_T));
+  Program->Inst[0].Op     = PATTERN_OP_CONST;
+  Program->Inst[0].Result = Result;
+  Program->Count          = 1;
+  Program->Depth          = 1;
 }
 
-STATIC
-UINT8
-ComparePriority (
-  IN INT8 Operator1,
-  IN INT8 Operator2
+PATTERN_T *
+CompilePattern (
+  IN INT8      *Pattern,
+  IN FIELD_T   *Fields
   )
 /*++
 
 Routine Description:
 
-  Compare priorities between two operators.
+  Compile a pattern for an unpacked field list. The operators are ordered
+  with the same priority stack as the former per-packet parser, and the
+  operands are emitted in postfix order. A pattern with a syntax error is
+  compiled into the constant -1.
 
 Arguments:
 
-  Operator1 - The operators.
-  Operator2 - The operators.
+  Pattern - The pattern validation
+  Fields  - The unpacked field list
 
 Returns:
 
-  HIGHP, LOWP, EQUAP or ERRP
+  The compiled pattern, or NULL if out of memory.
 
 --*/
 {
-  return Priority[Operator1][Operator2];
+  PATTERN_T *Program;
+  INT8      *Expression;
+  INT8      *Operators;
+  INT8      *OperatorTop;
+  INT8      *ExprP;
+  INT8      TempOperator;
+  UINT32    ExprLenth;
+  UINT32    Offset;
+  UINT32    Depth;
+  BOOLEAN   Error;
+
+  ExprLenth   = (UINT32) strlen (Pattern);
+  Program     = calloc (1, sizeof (PATTERN_T));
+  Expression  = malloc (ExprLenth + 2);
+  Operators   = malloc (ExprLenth + 2);
+  if (NULL != Program) {
+    Program->Text = malloc (ExprLenth + 1);
+    Program->Inst = calloc (ExprLenth + 2, sizeof (PATTERN_INST_T));
+  }
+
+  if ((NULL == Program) || (NULL == Expression) || (NULL == Operators) ||
+      (NULL == Program->Text) || (NULL == Program->Inst)) {
+    if (NULL != Program) {
+      free (Program->Text);
+      free (Program->Inst);
+    }
+
+    free (Program);
+    free (Expression);
+    free (Operators);
+    return NULL;
+  }
+
+  strcpy (Program->Text, Pattern);
+  Program->Fields = Fields;
+
+  strcpy (Expression, Pattern);
+  Expression[ExprLenth]     = '#';
+  Expression[ExprLenth + 1] = '\0';
+  ExprP                     = Expression;
+  Operators[0]              = OP_CRS;
+  OperatorTop               = Operators + 1;
+  Depth                     = 0;
+  Error                     = FALSE;
+
+  while (*ExprP && !Error) {
+    if (('#' == *ExprP) && (OP_CRS == *(OperatorTop - 1))) {
+      break;
+    }
+
+    TempOperator = GetOperatorIndex (ExprP);
+
+    if (TempOperator >= 0) {
+      switch (ComparePriority (*(OperatorTop - 1), TempOperator)) {
+      case HIGHP:
+        //
+        // Both operands are popped and the result is pushed
+        //
+        if (Depth < 2) {
+          Error = TRUE;
+          break;
+        }
+
+        OperatorTop -= 1;
+        Program->Inst[Program->Count++].Op = *OperatorTop;
+        Depth -= 1;
+        break;
+
+      case LOWP:
+        *OperatorTop = TempOperator;
+        OperatorTop += 1;
+        if (TempOperator == OP_NOT) {
+          Program->Inst[Program->Count].Op      = PATTERN_OP_CONST;
+          Program->Inst[Program->Count].Result  = TRUE;
+          Program->Count++;
+          Depth += 1;
+        }
+
+        ExprP += strlen (OperatorList[TempOperator].Name);
+        break;
+
+      case EQUAP:
+        OperatorTop -= 1;
+        ExprP += 1;
+        break;
+
+      default:
+        Error = TRUE;
+        break;
+      }
+    } else if (' ' == *ExprP) {
+      ExprP += 1;
+    } else {
+      if (!CompileOperand (ExprP, Fields, &Program->Inst[Program->Count], &Offset)) {
+        Error = TRUE;
+        break;
+      }
+
+      Program->Count++;
+      ExprP += Offset;
+      Depth += 1;
+    }
+
+    if (Depth > Program->Depth) {
+      Program->Depth = Depth;
+    }
+  }
+
+  if (Error) {
+    EmitConstant (Program, (BOOLEAN) -1);
+  } else if (0 == Depth) {
+    EmitConstant (Program, FALSE);
+  }
+
+  free (Expression);
+  free (Operators);
+  return Program;
 }
 
-STATIC
-BOOLEAN
-OneStepCalculate (
-  IN INT8        Operation,
-  IN BOOLEAN     Operand1,
-  IN BOOLEAN     Operand2
+VOID_P
+FreePattern (
+  IN PATTERN_T *Program
   )
 /*++
 
 Routine Description:
 
-  Just execute a step of calculate
+  Free a compiled pattern, which is not in the cache.
 
 Arguments:
 
-  Operation - The Operator,'AND' 'OR' 'NOT' '/'
-  Operand1  - The 1st operand
-  Operand2  - The 2nd operand
+  Program - The compiled pattern
 
 Returns:
 
-  The calculated result.
+  None
 
 --*/
 {
-  BOOLEAN Result;
-  Result = TRUE;
-
-  switch (Operation) {
-  case OP_AND:
-    Result = Operand1 ? Operand2 : FALSE;
-    break;
-
-  case OP_OR:
-    Result = Operand1 ? TRUE : Operand2;
-    break;
+  UINT32  Index;
 
-  case OP_NOT:
-    Result = Operand2 ? FALSE : TRUE;
-    break;
+  if (NULL == Program) {
+    return;
+  }
 
-  default:
-    break;
+  for (Index = 0; Index < Program->Count; Index++) {
+    if ((PATTERN_OP_FIELD == Program->Inst[Index].Op) && (STRING == Program->Inst[Index].Type)) {
+      free (Program->Inst[Index].Const.String);
+    }
   }
 
-  return Result;
+  free (Program->Inst);
+  free (Program->Text);
+  free (Program);
 }
 
-STATIC
 BOOLEAN
-GetOperand (
-  IN     INT8      *ExprP,
-  IN     FIELD_T   *Unpack,
-  IN OUT UINT32    *Offset
+EvaluatePattern (
+  IN PATTERN_T *Program,
+  IN FIELD_T   *Unpack
   )
 /*++
 
 Routine Description:
 
-  Calculate a Bool expression. 
-  e.g. "ip_addr=192.168.88.1"
+  Evaluate a compiled pattern on the unpacked fields of a packet. Unpack must
+  be the field list the pattern is compiled for.
 
 Arguments:
 
-  ExprP   - The expression
+  Program - The compiled pattern
   Unpack  - The Data
-  Offset  - The offset the calculation end
 
 Returns:
 
@@ -484,148 +719,100 @@ Returns:
 
 --*/
 {
-  BOOLEAN Result;
-  INT32   Status;
-  UINT32  Index;
-  UINT32  AddrIndex;
-  UINT32  Len;
-  UINT32  Value;
-  EMS_IPV6_ADDR IPv6Addr;
-  UINT8   Eth[6];
-
-  Result = FALSE;
-  //
-  // Find first '='
-  //
-  for (Len = 0; ExprP[Len]; Len++) {
-    if (ExprP[Len] == '=') {
-      break;
-    }
+  BOOLEAN         LocalStack[EXPR_MAX_LEN];
+  BOOLEAN         *Stack;
+  BOOLEAN         Result;
+  UINT32          Top;
+  UINT32          Index;
+  PATTERN_INST_T  *Inst;
+
+  if ((NULL == Program) || (NULL == Unpack)) {
+    return FALSE;
   }
 
-  if (ExprP[Len] == '\0') {
-    return Result;
-
+  if (Program->Depth <= EXPR_MAX_LEN) {
+    Stack = LocalStack;
+  } else {
+    Stack = malloc (Program->Depth * sizeof (BOOLEAN));
+    if (NULL == Stack) {
+      return (BOOLEAN) -1;
+    }
   }
 
-  Len++;
-
-  for (; ExprP[Len]; Len++) {
-    if (ExprP[Len] != ' ') {
-      break;
+  Top = 0;
+  for (Index = 0; Index < Program->Count; Index++) {
+    Inst = &Program->Inst[Index];
+    if ((PATTERN_OP_CONST == Inst->Op) || (PATTERN_OP_FIELD == Inst->Op)) {
+      Stack[Top++] = EvaluateOperand (Inst, Unpack);
+    } else {
+      Top -= 1;
+      Stack[Top - 1] = OneStepCalculate (Inst->Op, Stack[Top - 1], Stack[Top]);
     }
   }
 
-  *Offset = Len;
+  Result = Stack[Top - 1];
+  if (Stack != LocalStack) {
+    free (Stack);
+  }
 
-  for (Index = 0; Unpack[Index].Name; Index++) {
-    if (0 == strncmp_i (Unpack[Index].Name, ExprP, strlen (Unpack[Index].Name))) {
+  return Result;
+}
 
-      switch (Unpack[Index].Type) {
-      case OCTET1:
-        Status = AsciiStringToUint32 (ExprP + Len, &Value);
-        if (Status <= 0) {
-          return ERROR_WRONGFORMAT;
-        }
+PATTERN_T *
+LookupPattern (
+  IN INT8      *Pattern,
+  IN FIELD_T   *Fields
+  )
+/*++
 
-        *Offset += Status;
-        if ((UINT8) Value == * (UINT8 *) (Unpack[Index].Value)) {
-          return TRUE;
-        } else {
-          return FALSE;
-        }
+Routine Description:
 
-      case OCTET2:
-        Status = AsciiStringToUint32 (ExprP + Len, &Value);
-        if (Status < 0) {
-          return ERROR_WRONGFORMAT;
-        }
+  Get the compiled pattern for an unpacked field list from the cache. It is
+  compiled and cached at the first use. The cached patterns are kept until
+  EMS exits, the patterns come from the test scripts.
 
-        *Offset += Status;
-        if ((UINT16) Value == * (UINT16 *) (Unpack[Index].Value)) {
-          return TRUE;
-        } else {
-          return FALSE;
-        }
+Arguments:
 
-      case OCTET4:
-        Status = AsciiStringToUint32 (ExprP + Len, &Value);
-        if (Status < 0) {
-          return ERROR_WRONGFORMAT;
-        }
+  Pattern - The pattern validation
+  Fields  - The unpacked field list
 
-        *Offset += Status;
-        if (*(UINT32 *) (Unpack[Index].Value) == (UINT32) Value) {
-          return TRUE;
-        } else {
-          return FALSE;
-        }
+Returns:
 
-      case IPADDR:
-        Status = AsciiStringToIpv4 (ExprP + Len, &Value);
-        if (Status < 0) {
-          return ERROR_WRONGFORMAT;
-        }
+  The compiled pattern, or NULL if out of memory.
 
-        *Offset += Status;
-        if (*(UINT32 *) (Unpack[Index].Value) == (UINT32) Value) {
-          return TRUE;
-        } else {
-          return FALSE;
-        }
-		
-	  case IPV6ADDR:
-        Status = AsciiStringToIpv6 (ExprP + Len, &IPv6Addr);
-        if (Status <= 0) {
-          return ERROR_WRONGFORMAT;
-        }
+--*/
+{
+  PATTERN_T *Program;
+  UINT32    Hash;
+  INT8      *Char;
 
-        *Offset += Status;
-		for (AddrIndex = 0; AddrIndex< 8 ; AddrIndex++){
-          if (((EMS_IPV6_ADDR*)Unpack[Index].Value)->__u6_addr.__u6_addr16[AddrIndex] != 
-		  	    IPv6Addr.__u6_addr.__u6_addr16[AddrIndex]){
-            return FALSE;
-		  }
-		}
-		return TRUE;
-
-      case MACADDR:
-        Status = AsciiStringToMac (ExprP + Len, Eth);
-        if (Status < 0) {
-          return ERROR_WRONGFORMAT;
-        }
+  Hash = 5381;
+  for (Char = Pattern; *Char; Char++) {
+    Hash = (Hash << 5) + Hash + (UINT8) *Char;
+  }
 
-        *Offset += Status;
-        if (0 == memcmp (Unpack[Index].Value, Eth, 6)) {
-          return TRUE;
-        } else {
-          return FALSE;
-        }
+  Hash ^= (UINT32) (((UINT64) (size_t) Fields) >> 4);
 
-      case STRING:
-        if (Len != strlen (*(INT8 **) Unpack[Index].Value)) {
-          return FALSE;
-        }
+  Tcl_MutexLock (&PatternCacheMutex);
 
-        if (0 == strncmp (*(INT8 **) Unpack[Index].Value, ExprP + Len, Len)) {
-          return TRUE;
-        } else {
-          return FALSE;
-        }
+  for (Program = PatternCache[Hash % PATTERN_CACHE_SIZE]; Program != NULL; Program = Program->Next) {
+    if ((Program->Hash == Hash) && (Program->Fields == Fields) && (0 == strcmp (Program->Text, Pattern))) {
+      break;
+    }
+  }
 
-      case PAYLOAD:
-      //
-      // How to validata payload ???
-      // Now case writer has to use "ParsePacket" to store the payload into
-      // a packet then validate it.
-      //
-      default:
-        return ERROR_INTERNAL;
-      }
+  if (NULL == Program) {
+    Program = CompilePattern (Pattern, Fields);
+    if (NULL != Program) {
+      Program->Hash = Hash;
+      Program->Next = PatternCache[Hash % PATTERN_CACHE_SIZE];
+      PatternCache[Hash % PATTERN_CACHE_SIZE] = Program;
     }
   }
 
-  return FALSE;
+  Tcl_MutexUnlock (&PatternCacheMutex);
+
+  return Program;
 }
 
 BOOLEAN
@@ -650,74 +837,16 @@ Returns:
 
 --*/
 {
-
-  INT8    *ExprP;
-  INT8    CurrentOperator;
-  INT8    TempOperator;
-  BOOLEAN Operand1;
-  BOOLEAN Operand2;
-  BOOLEAN TempResult;
-  UINT32  ExprLenth;
-  UINT32  Offset;
+  PATTERN_T *Program;
 
   if (NULL == Unpack || NULL == Pattern) {
     return FALSE;
   }
 
-  strcpy (Expression, Pattern);
-
-  InitOperatorStack ();
-  InitOperandStack ();
-  Operators[0]          = OP_CRS;
-  ExprLenth             = strlen (Expression);
-  Expression[ExprLenth] = '#';
-  ExprP                 = Expression;
-  OperatorTop           = Operators + 1;
-  OperandTop            = Operands;
-
-  while (*ExprP) {
-    if (('#' == *ExprP) && (OP_CRS == GetTopOperatorStack ())) {
-      break;
-    }
-
-    TempOperator = GetOperatorIndex (ExprP);
-
-    if (TempOperator >= 0) {
-      switch (ComparePriority (GetTopOperatorStack (), TempOperator)) {
-      case HIGHP:
-        CurrentOperator = PopOperatorStack ();
-        Operand2        = PopOperandStack ();
-        Operand1        = PopOperandStack ();
-        TempResult      = OneStepCalculate (CurrentOperator, Operand1, Operand2);
-        PushOperandStack (TempResult);
-        break;
-
-      case LOWP:
-        PushOperatorStack (TempOperator);
-        if (TempOperator == OP_NOT) {
-          PushOperandStack (TRUE);
-        }
-
-        ExprP += strlen (OperatorList[TempOperator].Name);
-        break;
-
-      case EQUAP:
-        PopOperatorStack ();
-        ExprP += 1;
-        break;
-
-      default:
-        return -1;
-        break;
-      }
-    } else if (' ' == *ExprP) {
-      ExprP += 1;
-    } else {
-      TempResult = GetOperand (ExprP, Unpack, &Offset);
-      ExprP += Offset;
-      PushOperandStack (TempResult);
-    }
+  Program = LookupPattern (Pattern, Unpack);
+  if (NULL == Program) {
+    return (BOOLEAN) -1;
   }
 
-  return GetTopOperandStack ();
+  return EvaluatePattern (Program, Unpack);
 }
@@ -30,6 +30,101 @@ Abstract:
 #include "EmsTypes.h"
 #include "EmsProtocols.h"
 
+//
+// A pattern compiled for an unpacked field list
+//
+typedef struct _PATTERN_T PATTERN_T;
+
+PATTERN_T *
+CompilePattern (
+  INT8    *Pattern,
+  FIELD_T *Fields
+  )
+/*++
+
+Routine Description:
+
+  Compile a pattern for an unpacked field list
+
+Arguments:
+
+  Pattern - The pattern validation
+  Fields  - The unpacked field list
+
+Returns:
+
+  The compiled pattern, or NULL if out of memory.
+
+--*/
+;
+
+VOID_P
+FreePattern (
+  PATTERN_T *Program
+  )
+/*++
+
+Routine Description:
+
+  Free a compiled pattern, which is not in the cache
+
+Arguments:
+
+  Program - The compiled pattern
+
+Returns:
+
+  None
+
+--*/
+;
+
+BOOLEAN
+EvaluatePattern (
+  PATTERN_T *Program,
+  FIELD_T   *Unpack
+  )
+/*++
+
+Routine Description:
+
+  Evaluate a compiled pattern on the unpacked fields of a packet
+
+Arguments:
+
+  Program - The compiled pattern
+  Unpack  - The Data, it must be the field list the pattern is compiled for
+
+Returns:
+
+  Calculated result.
+
+--*/
+;
+
+PATTERN_T *
+LookupPattern (
+  INT8    *Pattern,
+  FIELD_T *Fields
+  )
+/*++
+
+Routine Description:
+
+  Get the compiled pattern for an unpacked field list from the cache
+
+Arguments:
+
+  Pattern - The pattern validation
+  Fields  - The unpacked field list
+
+Returns:
+
+  The compiled pattern, or NULL if out of memory.
+
+--*/
+;
+
 BOOLEAN
 Validate (
   INT8    *Pattern,
@@ -130,20 +130,9 @@ Returns:
 --*/
 {
   ASSERTION_PACKAGE   AssertionPkt;
-  INT8                ErrBuff[PCAP_ERRBUF_SIZE * 2];
-  struct bpf_program  Bp;
-  INT32               Res;
+  ENGINE_PACKET       Packet;
 
   printf("======Enter EmsRecvAssertionThread\n");
-  if ((AssertionPkt.Capturer = pcap_open_live (
-                                EmsInterface, // name of the device
-                                65536,        // portion of the packet to capture
-                                1,            // PCAP_OPENFLAG_PROMISCUOUS,
-                                10,           // read timeout
-                                ErrBuff       // error buffer
-                                )) == NULL) {
-    return ;
-  }
   //
   // set the filter
   //
@@ -154,56 +143,67 @@ Returns:
     ASSERTION_LOCAL_PORT
     );
 
-  if (-1 == pcap_compile (AssertionPkt.Capturer, &Bp, AssertionPkt.CaptureFilter, 0, 0xFFFFFF)) {
+  AssertionPkt.Consumer = EmsEngineOpen (EmsInterface, "RecvAssertion", AssertionPkt.CaptureFilter);
+  if (NULL == AssertionPkt.Consumer) {
     return ;
   }
 
-  if (-1 == pcap_setfilter (AssertionPkt.Capturer, &Bp)) {
+  //
+  // The packet is parsed in place, so it is copied out of the capture engine
+  //
+  AssertionPkt.ReceiveBuff  = malloc (ENGINE_SLOT_SIZE);
+  if (NULL == AssertionPkt.ReceiveBuff) {
+    EmsEngineClose (AssertionPkt.Consumer);
     return ;
   }
 
-  AssertionPkt.ReceiveBuff  = NULL;
-
-  Res                       = 0;
-
   while (1) {
     AssertionPkt.Received = 0;
     //
-    // Capture the packet
+    // Wait for the packet
     //
-    Res = pcap_dispatch (AssertionPkt.Capturer, 1, EmsRecvedAssertionPkt, (UINT8 *) (&AssertionPkt));
-
-    if (Res == 1) {
+    if (!EmsEngineReceive (AssertionPkt.Consumer, INFINITE, &Packet)) {
       //
-      // Got a packet
+      // It only returns without a packet if the capture failed, reopen the
+      // consumer on a new engine
       //
+      if (EmsEngineFailed (AssertionPkt.Consumer)) {
+        EmsEngineClose (AssertionPkt.Consumer);
+        Tcl_Sleep (ENGINE_READ_TIMEOUT);
+        AssertionPkt.Consumer = EmsEngineOpen (EmsInterface, "RecvAssertion", AssertionPkt.CaptureFilter);
+        if (NULL == AssertionPkt.Consumer) {
+          break;
+        }
+      }
+
+      continue;
+    }
+
+    memcpy (AssertionPkt.ReceiveBuff, Packet.Data, Packet.CapLen);
+    if (EmsEngineRelease (AssertionPkt.Consumer, &Packet)) {
+      EmsRecvedAssertionPkt (&AssertionPkt, Packet.CapLen);
     }
-    //
-    // Sleep for a while
-    //
-    Tcl_Sleep (100);
   }
 
-  pcap_close (AssertionPkt.Capturer);
+  EmsEngineClose (AssertionPkt.Consumer);
+  free (AssertionPkt.ReceiveBuff);
 }
 
 VOID_P
 EmsRecvedAssertionPkt (
-  IN UINT8                    *User,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST UINT8              *Packet
+  IN ASSERTION_PACKAGE        *AssertionPackagePtr,
+  IN UINT32                   Len
   )
 /*++
 
 Routine Description:
 
-  The callback routine of receive assertion packet
+  Handle an assertion packet copied into the receive buffer
 
 Arguments:
 
-  User    - User string corresponds to user parameter of pcap_dispatch().
-  PktHdr  - Packet header buffer.
-  Packet  - Packet data buffer.
+  AssertionPackagePtr - The pointer to the assertion package
+  Len                 - The length of the packet
 
 Returns:
 
@@ -211,19 +211,7 @@ Returns:
 
 --*/
 {
-  ASSERTION_PACKAGE *AssertionPackagePtr;
-
-  AssertionPackagePtr = (ASSERTION_PACKAGE *) User;
-
-  if (AssertionPackagePtr->ReceiveBuff) {
-    free (AssertionPackagePtr->ReceiveBuff);
-  }
-
-  AssertionPackagePtr->ReceiveBuff = malloc (PktHdr->len);
-
-  memcpy (AssertionPackagePtr->ReceiveBuff, Packet, PktHdr->len);
-
-  AssertionPackagePtr->ReceiveLen = PktHdr->len;
+  AssertionPackagePtr->ReceiveLen = Len;
 
   AssertionPackagePtr->Received   = 1;
 
@@ -27,9 +27,12 @@ Abstract:
 #include "EmsTclInit.h"
 #include "EmsNet.h"
 #include "EmsPktSend.h"
+#include "EmsPktInject.h"
 #include "EmsUtilityString.h"
 #include "EmsLogCommand.h"
 
+extern INT8         *EmsInterface;
+
 STATIC Tcl_CmdProc  TclSendPacket;
 
 VOID_P
@@ -92,12 +95,18 @@ Returns:
 
 --*/
 {
-  INT8      *Name;
-  libnet_t  *l;
-  INT32     Repeat;
-  INT32     Count;
-  INT32     Index;
-  INT8      Result[100];
+  INT8          *Name;
+  libnet_t      *l;
+  INT32         Repeat;
+  INT32         Count;
+  INT32         Index;
+  INT8          Result[100];
+  INJECTOR      *Injector;
+  INJECT_FRAME  Frames[INJECT_BATCH_MAX];
+  UINT8         *Frame;
+  UINT32        Len;
+  UINT32        Batch;
+  UINT32        Sent;
 
   LogCurrentCommand (Argc, Argv);
   //
@@ -129,12 +138,43 @@ Returns:
     goto NoSuchPacket;
   }
 
-  Count = 0;
-  for (Index = 0; Index < Repeat; Index++) {
-    if (-1 == libnet_write (l)) {
-      continue;
-    };
-    Count++;
+  //
+  // The packet is assembled once, and its copies are written in batches by
+  // the injector of the interface. Only a packet created in the advanced
+  // mode can be taken out of libnet.
+  //
+  Injector = EmsInjectorOpen (EmsInterface);
+  if ((NULL != Injector) && (-1 != libnet_adv_cull_packet (l, &Frame, &Len))) {
+    Count = 0;
+    Index = 0;
+    while (Index < Repeat) {
+      Batch = (UINT32) (Repeat - Index);
+      if (Batch > INJECT_BATCH_MAX) {
+        Batch = INJECT_BATCH_MAX;
+      }
+
+      for (Sent = 0; Sent < Batch; Sent++) {
+        Frames[Sent].Data = Frame;
+        Frames[Sent].Len  = Len;
+      }
+
+      Sent    = EmsInjectorSendBatch (Injector, Frames, Batch);
+      Count  += Sent;
+      //
+      // Skip the copy that failed, as libnet_write does
+      //
+      Index  += (Sent < Batch) ? Sent + 1 : Sent;
+    }
+
+    libnet_adv_free_packet (l, Frame);
+  } else {
+    Count = 0;
+    for (Index = 0; Index < Repeat; Index++) {
+      if (-1 == libnet_write (l)) {
+        continue;
+      };
+      Count++;
+    }
   }
 
   sprintf (Result, "%d", Count);
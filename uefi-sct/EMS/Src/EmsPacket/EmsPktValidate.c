@@ -24,6 +24,9 @@ Abstract:
 
 --*/
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "EmsPktValidate.h"
 #include "EmsTypes.h"
 #include "EmsProtocols.h"
@@ -34,6 +37,9 @@ Abstract:
 #include "EmsLogCommand.h"
 
 STATIC Tcl_CmdProc  TclValidatePacket;
+STATIC Tcl_CmdProc  TclValidatePacketBenchmark;
+
+#define BENCHMARK_DEFAULT_FRAMES  1000000
 
 INT8                *ValidateResult;
 
@@ -67,6 +73,13 @@ Returns:
     (ClientData) NULL,
     (Tcl_CmdDeleteProc *) NULL
     );
+  Tcl_CreateCommand (
+    Interp,
+    "ValidatePacketBenchmark",
+    TclValidatePacketBenchmark,
+    (ClientData) NULL,
+    (Tcl_CmdDeleteProc *) NULL
+    );
   //
   // Link Packet related TCL variables
   //
@@ -209,3 +222,166 @@ Returns:
 ErrorExit:
   return TCL_ERROR;
 }
+
+STATIC
+INT32
+TclValidatePacketBenchmark (
+  IN ClientData        clientData,
+  IN Tcl_Interp        *Interp,
+  IN INT32             Argc,
+  IN CONST84 INT8      *Argv[]
+  )
+/*++
+
+Routine Description:
+
+  TCL command "ValidatePacketBenchmark" implementation routine. It validates
+  synthetic frames derived from a packet, once with the cached pattern program
+  and once compiling the pattern for every frame, and returns the timings.
+
+    ValidatePacketBenchmark <Packet> -t <Protocol> <Pattern> [Frames]
+
+  Each synthetic frame is a copy of the packet with one byte changed, so the
+  fields differ from frame to frame.
+
+Arguments:
+
+  clientData  - Private data, if any.
+  Interp      - TCL intepreter.
+  Argc        - Argument counter.
+  Argv        - Argument value pointer array.
+
+Returns:
+
+  TCL_OK or TCL_ERROR
+
+--*/
+{
+  INT8              *Name;
+  INT8              *Pattern;
+  PROTOCOL_ENTRY_T  *Protocol;
+  PACKET_T          *Packet;
+  FIELD_T           *Unpack;
+  PATTERN_T         *Program;
+  UINT8             *Frame;
+  UINT32            Frames;
+  UINT32            Index;
+  UINT32            Seed;
+  UINT32            Position;
+  UINT32            Matched[2];
+  UINT32            Elapsed[2];
+  UINT32            Pass;
+  BOOLEAN           Result;
+  INT8              Buffer[128];
+
+  LogCurrentCommand (Argc, Argv);
+
+  if ((Argc != 5) && (Argc != 6)) {
+    Tcl_AppendResult (
+      Interp,
+      "ValidatePacketBenchmark <Packet> -t <Protocol> <Pattern> [Frames]",
+      (INT8 *) NULL
+      );
+    return TCL_ERROR;
+  }
+
+  Name    = (INT8 *) Argv[1];
+  Pattern = (INT8 *) Argv[4];
+  if (strcmp_i ((INT8 *) Argv[2], "-t") != 0) {
+    Tcl_AppendResult (Interp, "Missing -t <Protocol>", (INT8 *) NULL);
+    return TCL_ERROR;
+  }
+
+  Frames = BENCHMARK_DEFAULT_FRAMES;
+  if (Argc == 6) {
+    Frames = (UINT32) atoi (Argv[5]);
+    if (0 == Frames) {
+      Tcl_AppendResult (Interp, "Invalid frame count ", Argv[5], (INT8 *) NULL);
+      return TCL_ERROR;
+    }
+  }
+
+  Packet = EmsPacketFindByName (Name);
+  if ((NULL == Packet) || (0 == Packet->DataLen)) {
+    Tcl_AppendResult (Interp, "Cannot find Packet ", Name, (INT8 *) NULL);
+    return TCL_ERROR;
+  }
+
+  Protocol = GetProtocolByName ((INT8 *) Argv[3]);
+  if (NULL == Protocol) {
+    Tcl_AppendResult (
+      Interp,
+      "The Protocol ",
+      Argv[3],
+      " is not supported!",
+      (INT8 *) NULL
+      );
+    return TCL_ERROR;
+  }
+
+  Frame = malloc (Packet->DataLen);
+  if (NULL == Frame) {
+    Tcl_AppendResult (Interp, "Out of memory", (INT8 *) NULL);
+    return TCL_ERROR;
+  }
+
+  //
+  // Pass 0 uses the pattern cache, pass 1 compiles the pattern per frame.
+  // Both passes see the same frames.
+  //
+  for (Pass = 0; Pass < 2; Pass++) {
+    Seed          = 1;
+    Matched[Pass] = 0;
+    Elapsed[Pass] = GetTickCount ();
+
+    for (Index = 0; Index < Frames; Index++) {
+      memcpy (Frame, Packet->Data, Packet->DataLen);
+      Seed            = Seed * 1103515245 + 12345;
+      Position        = (Seed >> 16) % Packet->DataLen;
+      Frame[Position] = (UINT8) (Frame[Position] ^ (Seed >> 8));
+
+      Unpack = Protocol->UnpackPacket (Frame, Packet->DataLen);
+
+      if (0 == Pass) {
+        Result = Validate (Pattern, Unpack);
+      } else {
+        Program = CompilePattern (Pattern, Unpack);
+        if (NULL == Program) {
+          free (Frame);
+          Tcl_AppendResult (Interp, "Out of memory", (INT8 *) NULL);
+          return TCL_ERROR;
+        }
+
+        Result = EvaluatePattern (Program, Unpack);
+        FreePattern (Program);
+      }
+
+      if ((TRUE != Result) && (FALSE != Result)) {
+        free (Frame);
+        Tcl_AppendResult (Interp, "Invalid pattern ", Pattern, (INT8 *) NULL);
+        return TCL_ERROR;
+      }
+
+      if (TRUE == Result) {
+        Matched[Pass]++;
+      }
+    }
+
+    Elapsed[Pass] = GetTickCount () - Elapsed[Pass];
+  }
+
+  free (Frame);
+
+  sprintf (
+    Buffer,
+    "Frames %u Matched %u Cached %u ms Uncached %u ms",
+    Frames,
+    Matched[0],
+    Elapsed[0],
+    Elapsed[1]
+    );
+  RecordMessage (EMS_VERBOSE_LEVEL_DEFAULT, "ValidatePacketBenchmark: %a", Buffer);
+  Tcl_AppendResult (Interp, Buffer, (INT8 *) NULL);
+
+  return TCL_OK;
+}
@@ -0,0 +1,224 @@
+/** @file
+
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+    EmsPlatform.c
+
+Abstract:
+
+    Implementation of the EMS locks and condition variables on Windows and
+    on POSIX.
+
+--*/
+
+#include "EmsPlatform.h"
+
+#if !defined(__WIN32__) && !defined(WIN32)
+#include <errno.h>
+#include <time.h>
+#endif
+
+VOID
+EmsLockInit (
+  IN EMS_LOCK       *Lock
+  )
+/*++
+
+Routine Description:
+
+  Initialize a lock. A lock is not recursive.
+
+Arguments:
+
+  Lock  - The lock to be initialized
+
+Returns:
+
+  None
+
+--*/
+{
+#if defined(__WIN32__) || defined(WIN32)
+  InitializeCriticalSection (Lock);
+#else
+  pthread_mutex_init (Lock, NULL);
+#endif
+}
+
+VOID
+EmsLockAcquire (
+  IN EMS_LOCK       *Lock
+  )
+/*++
+
+Routine Description:
+
+  Acquire a lock.
+
+Arguments:
+
+  Lock  - The lock to be acquired
+
+Returns:
+
+  None
+
+--*/
+{
+#if defined(__WIN32__) || defined(WIN32)
+  EnterCriticalSection (Lock);
+#else
+  pthread_mutex_lock (Lock);
+#endif
+}
+
+VOID
+EmsLockRelease (
+  IN EMS_LOCK       *Lock
+  )
+/*++
+
+Routine Description:
+
+  Release a lock.
+
+Arguments:
+
+  Lock  - The lock to be released
+
+Returns:
+
+  None
+
+--*/
+{
+#if defined(__WIN32__) || defined(WIN32)
+  LeaveCriticalSection (Lock);
+#else
+  pthread_mutex_unlock (Lock);
+#endif
+}
+
+VOID
+EmsConditionInit (
+  IN EMS_CONDITION  *Condition
+  )
+/*++
+
+Routine Description:
+
+  Initialize a condition variable. On POSIX the timed waits are measured
+  with the monotonic clock, so they are not affected by the changes of the
+  system time.
+
+Arguments:
+
+  Condition - The condition variable to be initialized
+
+Returns:
+
+  None
+
+--*/
+{
+#if defined(__WIN32__) || defined(WIN32)
+  InitializeConditionVariable (Condition);
+#else
+  pthread_condattr_t  Attributes;
+
+  pthread_condattr_init (&Attributes);
+  pthread_condattr_setclock (&Attributes, CLOCK_MONOTONIC);
+  pthread_cond_init (Condition, &Attributes);
+  pthread_condattr_destroy (&Attributes);
+#endif
+}
+
+BOOLEAN
+EmsConditionWait (
+  IN EMS_CONDITION  *Condition,
+  IN EMS_LOCK       *Lock,
+  IN UINT32         Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Release Lock and wait for Condition to be signaled, for at most
+  Milliseconds, or forever if it is INFINITE. Lock is acquired again
+  before return. A waiter may wake up without being signaled, so the
+  predicate must be checked again.
+
+Arguments:
+
+  Condition     - The condition variable
+  Lock          - The lock owned by the caller
+  Milliseconds  - The maximum time to wait
+
+Returns:
+
+  FALSE if the wait timed out, TRUE otherwise
+
+--*/
+{
+#if defined(__WIN32__) || defined(WIN32)
+  return (BOOLEAN) (SleepConditionVariableCS (Condition, Lock, Milliseconds) ? TRUE : FALSE);
+#else
+  struct timespec DueTime;
+
+  if (Milliseconds == INFINITE) {
+    pthread_cond_wait (Condition, Lock);
+    return TRUE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &DueTime);
+  DueTime.tv_sec  += Milliseconds / 1000;
+  DueTime.tv_nsec += (Milliseconds % 1000) * 1000000;
+  if (DueTime.tv_nsec >= 1000000000) {
+    DueTime.tv_sec++;
+    DueTime.tv_nsec -= 1000000000;
+  }
+
+  return (BOOLEAN) ((pthread_cond_timedwait (Condition, Lock, &DueTime) == ETIMEDOUT) ? FALSE : TRUE);
+#endif
+}
+
+VOID
+EmsConditionSignal (
+  IN EMS_CONDITION  *Condition
+  )
+/*++
+
+Routine Description:
+
+  Wake one waiter of a condition variable.
+
+Arguments:
+
+  Condition - The condition variable
+
+Returns:
+
+  None
+
+--*/
+{
+#if defined(__WIN32__) || defined(WIN32)
+  WakeConditionVariable (Condition);
+#else
+  pthread_cond_signal (Condition);
+#endif
+}
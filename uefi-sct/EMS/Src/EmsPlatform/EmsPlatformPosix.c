@@ -0,0 +1,1805 @@
+/** @file
+
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+    EmsPlatformPosix.c
+
+Abstract:
+
+    POSIX backend of the EMS platform abstraction. It provides the subset of
+    the Win32 API declared in EmsPlatform.h:
+
+    - A mutex is a recursive pthread mutex, as a Win32 mutex may be acquired
+      again by its owner.
+    - An event is an eventfd, so a wait is a poll() which is also a
+      cancellation point. Signaling an auto-reset event several times before
+      it is waited for wakes one waiter, as on Windows.
+    - A thread is a detached pthread. Its handle is reference counted, so it
+      may be closed while the thread is running, and it owns a manual-reset
+      event signaled when the thread ends.
+
+    Only Linux is supported, since the adapters are enumerated with the
+    AF_PACKET addresses of getifaddrs() and the addresses are configured
+    with rtnetlink.
+
+--*/
+
+#if !defined(__WIN32__) && !defined(WIN32)
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <ifaddrs.h>
+#include <limits.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include "EmsPlatform.h"
+
+typedef enum {
+  HandleMutex = 1,
+  HandleEvent,
+  HandleThread,
+  HandleFile,
+  HandleFind
+} HANDLE_TYPE;
+
+typedef struct {
+  HANDLE_TYPE             Type;
+
+  //
+  // The mutex of a mutex handle, or the lock of a thread handle
+  //
+  pthread_mutex_t         Mutex;
+
+  //
+  // Event and file
+  //
+  INT32                   Fd;
+  BOOL                    ManualReset;
+
+  //
+  // Thread
+  //
+  pthread_t               Thread;
+  LPTHREAD_START_ROUTINE  StartAddress;
+  LPVOID                  Parameter;
+  DWORD                   ThreadId;
+  volatile DWORD          ExitCode;
+  BOOLEAN                 Exited;
+  HANDLE                  Done;
+  HANDLE                  Resume;
+  volatile LONG           References;
+
+  //
+  // Find
+  //
+  DIR                     *Dir;
+  INT8                    Path[MAX_PATH];
+  INT8                    Pattern[MAX_PATH];
+} EMS_HANDLE;
+
+STATIC __thread EMS_HANDLE  *CurrentThread    = NULL;
+STATIC __thread DWORD       CurrentThreadId   = 0;
+STATIC __thread DWORD       LastError         = ERROR_SUCCESS;
+STATIC volatile DWORD       LastThreadId      = 0;
+
+//
+// The addresses added by AddIPAddress, the context is the index plus 1
+//
+#define MAX_IP_ADDRESS_CONTEXT  64
+
+typedef struct {
+  BOOLEAN                   InUse;
+  DWORD                     IfIndex;
+  IPAddr                    Address;
+  UINT8                     PrefixLength;
+} IP_ADDRESS_CONTEXT;
+
+STATIC IP_ADDRESS_CONTEXT   IpAddressTable[MAX_IP_ADDRESS_CONTEXT];
+STATIC pthread_mutex_t      IpAddressLock = PTHREAD_MUTEX_INITIALIZER;
+
+STATIC
+DWORD
+ErrnoToError (
+  IN INT32              Errno
+  )
+/*++
+
+Routine Description:
+
+  Translate an errno value to a Win32 error code. The values without a
+  Win32 equivalent are returned as is.
+
+--*/
+{
+  switch (Errno) {
+  case ENOENT:
+  case ENOTDIR:
+    return ERROR_FILE_NOT_FOUND;
+
+  case EACCES:
+  case EPERM:
+    return ERROR_ACCESS_DENIED;
+
+  case EBADF:
+    return ERROR_INVALID_HANDLE;
+
+  case ENOMEM:
+    return ERROR_NOT_ENOUGH_MEMORY;
+
+  case EEXIST:
+    return ERROR_ALREADY_EXISTS;
+
+  case EINVAL:
+    return ERROR_INVALID_PARAMETER;
+
+  default:
+    return (DWORD) Errno;
+  }
+}
+
+STATIC
+EMS_HANDLE *
+HandleCreate (
+  IN HANDLE_TYPE        Type
+  )
+/*++
+
+Routine Description:
+
+  Allocate a handle of Type.
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+
+  Handle = (EMS_HANDLE *) calloc (1, sizeof (EMS_HANDLE));
+  if (Handle == NULL) {
+    LastError = ERROR_NOT_ENOUGH_MEMORY;
+    return NULL;
+  }
+
+  Handle->Type  = Type;
+  Handle->Fd    = -1;
+  return Handle;
+}
+
+STATIC
+EMS_HANDLE *
+HandleCheck (
+  IN HANDLE             Handle,
+  IN HANDLE_TYPE        Type
+  )
+/*++
+
+Routine Description:
+
+  Check that Handle is a handle of Type.
+
+--*/
+{
+  if ((Handle == NULL) || (Handle == INVALID_HANDLE_VALUE) ||
+      (((EMS_HANDLE *) Handle)->Type != Type)) {
+    LastError = ERROR_INVALID_HANDLE;
+    return NULL;
+  }
+
+  return (EMS_HANDLE *) Handle;
+}
+
+STATIC
+DWORD
+EventWait (
+  IN EMS_HANDLE         *Event,
+  IN DWORD              Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Wait for an event. The counter of an auto-reset event is consumed by
+  read(); when several threads wait for the same event, the ones which
+  lose the race wait again.
+
+--*/
+{
+  struct pollfd Poll;
+  UINT64        Value;
+  DWORD         Start;
+  DWORD         Elapsed;
+  INT32         Timeout;
+  INT32         Ret;
+
+  Start = GetTickCount ();
+  for (;;) {
+    if (Milliseconds == INFINITE) {
+      Timeout = -1;
+    } else {
+      Elapsed = GetTickCount () - Start;
+      if (Elapsed >= Milliseconds) {
+        Timeout = 0;
+      } else if (Milliseconds - Elapsed > INT_MAX) {
+        Timeout = INT_MAX;
+      } else {
+        Timeout = (INT32) (Milliseconds - Elapsed);
+      }
+    }
+
+    Poll.fd       = Event->Fd;
+    Poll.events   = POLLIN;
+    Poll.revents  = 0;
+    Ret           = poll (&Poll, 1, Timeout);
+    if (Ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      LastError = ErrnoToError (errno);
+      return WAIT_FAILED;
+    }
+
+    if (Ret == 0) {
+      return WAIT_TIMEOUT;
+    }
+
+    if (Event->ManualReset) {
+      return WAIT_OBJECT_0;
+    }
+
+    if (read (Event->Fd, &Value, sizeof (Value)) == sizeof (Value)) {
+      return WAIT_OBJECT_0;
+    }
+  }
+}
+
+STATIC
+DWORD
+MutexWait (
+  IN EMS_HANDLE         *Mutex,
+  IN DWORD              Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Acquire a mutex.
+
+--*/
+{
+  struct timespec DueTime;
+  INT32           Ret;
+
+  if (Milliseconds == INFINITE) {
+    Ret = pthread_mutex_lock (&Mutex->Mutex);
+  } else if (Milliseconds == 0) {
+    Ret = pthread_mutex_trylock (&Mutex->Mutex);
+    if (Ret == EBUSY) {
+      return WAIT_TIMEOUT;
+    }
+  } else {
+    clock_gettime (CLOCK_REALTIME, &DueTime);
+    DueTime.tv_sec  += Milliseconds / 1000;
+    DueTime.tv_nsec += (Milliseconds % 1000) * 1000000;
+    if (DueTime.tv_nsec >= 1000000000) {
+      DueTime.tv_sec++;
+      DueTime.tv_nsec -= 1000000000;
+    }
+
+    Ret = pthread_mutex_timedlock (&Mutex->Mutex, &DueTime);
+    if (Ret == ETIMEDOUT) {
+      return WAIT_TIMEOUT;
+    }
+  }
+
+  if (Ret != 0) {
+    LastError = ErrnoToError (Ret);
+    return WAIT_FAILED;
+  }
+
+  return WAIT_OBJECT_0;
+}
+
+//
+// Mutex and event
+//
+
+HANDLE
+CreateMutex (
+  PVOID       Attributes,
+  BOOL        InitialOwner,
+  const char  *Name
+  )
+/*++
+
+Routine Description:
+
+  Create a recursive mutex. Attributes and Name are ignored.
+
+Arguments:
+
+  Attributes    - Not used
+  InitialOwner  - Whether the calling thread owns the new mutex
+  Name          - Not used
+
+Returns:
+
+  The handle of the mutex, or NULL on failure
+
+--*/
+{
+  EMS_HANDLE          *Mutex;
+  pthread_mutexattr_t MutexAttributes;
+
+  Mutex = HandleCreate (HandleMutex);
+  if (Mutex == NULL) {
+    return NULL;
+  }
+
+  pthread_mutexattr_init (&MutexAttributes);
+  pthread_mutexattr_settype (&MutexAttributes, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init (&Mutex->Mutex, &MutexAttributes);
+  pthread_mutexattr_destroy (&MutexAttributes);
+
+  if (InitialOwner) {
+    pthread_mutex_lock (&Mutex->Mutex);
+  }
+
+  return Mutex;
+}
+
+BOOL
+ReleaseMutex (
+  HANDLE      Mutex
+  )
+/*++
+
+Routine Description:
+
+  Release a mutex owned by the calling thread.
+
+Arguments:
+
+  Mutex - The handle of the mutex
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+  INT32       Ret;
+
+  Handle = HandleCheck (Mutex, HandleMutex);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  Ret = pthread_mutex_unlock (&Handle->Mutex);
+  if (Ret != 0) {
+    LastError = ErrnoToError (Ret);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+HANDLE
+CreateEvent (
+  PVOID       Attributes,
+  BOOL        ManualReset,
+  BOOL        InitialState,
+  const char  *Name
+  )
+/*++
+
+Routine Description:
+
+  Create an event backed by an eventfd. Attributes and Name are ignored.
+
+Arguments:
+
+  Attributes    - Not used
+  ManualReset   - Whether the event stays signaled until ResetEvent
+  InitialState  - Whether the event is signaled
+  Name          - Not used
+
+Returns:
+
+  The handle of the event, or NULL on failure
+
+--*/
+{
+  EMS_HANDLE  *Event;
+
+  Event = HandleCreate (HandleEvent);
+  if (Event == NULL) {
+    return NULL;
+  }
+
+  Event->Fd = eventfd (InitialState ? 1 : 0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (Event->Fd < 0) {
+    LastError = ErrnoToError (errno);
+    free (Event);
+    return NULL;
+  }
+
+  Event->ManualReset = ManualReset;
+  return Event;
+}
+
+BOOL
+SetEvent (
+  HANDLE      Event
+  )
+/*++
+
+Routine Description:
+
+  Signal an event. An auto-reset event wakes one waiter and is reset.
+
+Arguments:
+
+  Event - The handle of the event
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+  UINT64      Value;
+
+  Handle = HandleCheck (Event, HandleEvent);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  Value = 1;
+  if (write (Handle->Fd, &Value, sizeof (Value)) != sizeof (Value)) {
+    LastError = ErrnoToError (errno);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+BOOL
+ResetEvent (
+  HANDLE      Event
+  )
+/*++
+
+Routine Description:
+
+  Reset an event to the non-signaled state.
+
+Arguments:
+
+  Event - The handle of the event
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+  UINT64      Value;
+
+  Handle = HandleCheck (Event, HandleEvent);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  //
+  // The read fails with EAGAIN if the event is not signaled
+  //
+  read (Handle->Fd, &Value, sizeof (Value));
+  return TRUE;
+}
+
+DWORD
+WaitForSingleObject (
+  HANDLE      Handle,
+  DWORD       Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Wait for a mutex, an event or a thread, for at most Milliseconds, or
+  forever if it is INFINITE.
+
+Arguments:
+
+  Handle        - The handle to wait for
+  Milliseconds  - The maximum time to wait
+
+Returns:
+
+  WAIT_OBJECT_0, WAIT_TIMEOUT or WAIT_FAILED
+
+--*/
+{
+  EMS_HANDLE  *Object;
+
+  if ((Handle == NULL) || (Handle == INVALID_HANDLE_VALUE)) {
+    LastError = ERROR_INVALID_HANDLE;
+    return WAIT_FAILED;
+  }
+
+  Object = (EMS_HANDLE *) Handle;
+  switch (Object->Type) {
+  case HandleMutex:
+    return MutexWait (Object, Milliseconds);
+
+  case HandleEvent:
+    return EventWait (Object, Milliseconds);
+
+  case HandleThread:
+    return EventWait ((EMS_HANDLE *) Object->Done, Milliseconds);
+
+  default:
+    LastError = ERROR_INVALID_HANDLE;
+    return WAIT_FAILED;
+  }
+}
+
+//
+// Thread
+//
+
+STATIC
+EMS_HANDLE *
+ThreadHandleCreate (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Allocate a thread handle, referenced by its creator and by the thread.
+
+--*/
+{
+  EMS_HANDLE  *Thread;
+
+  Thread = HandleCreate (HandleThread);
+  if (Thread == NULL) {
+    return NULL;
+  }
+
+  Thread->Done    = CreateEvent (NULL, TRUE, FALSE, NULL);
+  Thread->Resume  = CreateEvent (NULL, FALSE, FALSE, NULL);
+  if ((Thread->Done == NULL) || (Thread->Resume == NULL)) {
+    if (Thread->Done != NULL) {
+      CloseHandle (Thread->Done);
+    }
+
+    if (Thread->Resume != NULL) {
+      CloseHandle (Thread->Resume);
+    }
+
+    free (Thread);
+    return NULL;
+  }
+
+  pthread_mutex_init (&Thread->Mutex, NULL);
+  Thread->ExitCode    = STILL_ACTIVE;
+  Thread->Exited      = FALSE;
+  Thread->References  = 2;
+  return Thread;
+}
+
+STATIC
+VOID
+ThreadHandleRelease (
+  IN EMS_HANDLE         *Thread
+  )
+/*++
+
+Routine Description:
+
+  Drop a reference of a thread handle, and free it with the last one.
+
+--*/
+{
+  if (InterlockedDecrement (&Thread->References) == 0) {
+    CloseHandle (Thread->Done);
+    CloseHandle (Thread->Resume);
+    pthread_mutex_destroy (&Thread->Mutex);
+    free (Thread);
+  }
+}
+
+STATIC
+VOID
+ThreadCleanup (
+  IN VOID               *Arg
+  )
+/*++
+
+Routine Description:
+
+  Run when a thread ends, by return, ExitThread or TerminateThread.
+
+--*/
+{
+  EMS_HANDLE  *Thread;
+
+  Thread = (EMS_HANDLE *) Arg;
+
+  pthread_mutex_lock (&Thread->Mutex);
+  Thread->Exited = TRUE;
+  pthread_mutex_unlock (&Thread->Mutex);
+
+  SetEvent (Thread->Done);
+  ThreadHandleRelease (Thread);
+}
+
+STATIC
+VOID *
+ThreadStart (
+  IN VOID               *Arg
+  )
+/*++
+
+Routine Description:
+
+  The common entry of the threads created by CreateThread.
+
+--*/
+{
+  EMS_HANDLE  *Thread;
+  DWORD       ExitCode;
+
+  Thread          = (EMS_HANDLE *) Arg;
+  CurrentThread   = Thread;
+  CurrentThreadId = Thread->ThreadId;
+
+  pthread_cleanup_push (ThreadCleanup, Thread);
+  ExitCode          = Thread->StartAddress (Thread->Parameter);
+  Thread->ExitCode  = ExitCode;
+  pthread_cleanup_pop (1);
+
+  return NULL;
+}
+
+HANDLE
+CreateThread (
+  PVOID                   Attributes,
+  size_t                  StackSize,
+  LPTHREAD_START_ROUTINE  StartAddress,
+  LPVOID                  Parameter,
+  DWORD                   CreationFlags,
+  LPDWORD                 ThreadId
+  )
+/*++
+
+Routine Description:
+
+  Create a detached thread running StartAddress (Parameter). Attributes
+  and CreationFlags are ignored.
+
+Arguments:
+
+  Attributes    - Not used
+  StackSize     - The stack size, or 0 for the default one
+  StartAddress  - The routine of the thread
+  Parameter     - The parameter of the routine
+  CreationFlags - Not used
+  ThreadId      - Return the ID of the thread, if not NULL
+
+Returns:
+
+  The handle of the thread, or NULL on failure
+
+--*/
+{
+  EMS_HANDLE      *Thread;
+  pthread_attr_t  ThreadAttributes;
+  INT32           Ret;
+
+  Thread = ThreadHandleCreate ();
+  if (Thread == NULL) {
+    return NULL;
+  }
+
+  Thread->StartAddress  = StartAddress;
+  Thread->Parameter     = Parameter;
+  Thread->ThreadId      = InterlockedIncrement (&LastThreadId);
+
+  pthread_attr_init (&ThreadAttributes);
+  pthread_attr_setdetachstate (&ThreadAttributes, PTHREAD_CREATE_DETACHED);
+  if (StackSize != 0) {
+    pthread_attr_setstacksize (&ThreadAttributes, StackSize);
+  }
+
+  Ret = pthread_create (&Thread->Thread, &ThreadAttributes, ThreadStart, Thread);
+  pthread_attr_destroy (&ThreadAttributes);
+  if (Ret != 0) {
+    LastError = ErrnoToError (Ret);
+    Thread->References = 1;
+    ThreadHandleRelease (Thread);
+    return NULL;
+  }
+
+  if (ThreadId != NULL) {
+    *ThreadId = Thread->ThreadId;
+  }
+
+  return Thread;
+}
+
+HANDLE
+GetCurrentThread (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the handle of the calling thread. Unlike Windows, it is a real handle
+  which may be used from the other threads. The handle of a thread not
+  created by CreateThread, such as the main thread, is never freed.
+
+Arguments:
+
+  None
+
+Returns:
+
+  The handle of the calling thread
+
+--*/
+{
+  EMS_HANDLE  *Thread;
+
+  if (CurrentThread == NULL) {
+    Thread = ThreadHandleCreate ();
+    if (Thread == NULL) {
+      return NULL;
+    }
+
+    Thread->Thread    = pthread_self ();
+    Thread->ThreadId  = GetCurrentThreadId ();
+    CurrentThread     = Thread;
+  }
+
+  return CurrentThread;
+}
+
+DWORD
+GetCurrentThreadId (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the ID of the calling thread, unique in the process.
+
+Arguments:
+
+  None
+
+Returns:
+
+  The ID of the calling thread
+
+--*/
+{
+  if (CurrentThreadId == 0) {
+    CurrentThreadId = InterlockedIncrement (&LastThreadId);
+  }
+
+  return CurrentThreadId;
+}
+
+VOID
+ExitThread (
+  DWORD       ExitCode
+  )
+/*++
+
+Routine Description:
+
+  Terminate the calling thread.
+
+Arguments:
+
+  ExitCode  - The exit code of the thread
+
+Returns:
+
+  None
+
+--*/
+{
+  if (CurrentThread != NULL) {
+    CurrentThread->ExitCode = ExitCode;
+  }
+
+  pthread_exit (NULL);
+}
+
+BOOL
+TerminateThread (
+  HANDLE      Thread,
+  DWORD       ExitCode
+  )
+/*++
+
+Routine Description:
+
+  Cancel a thread. The thread stops at its next cancellation point, that is
+  the next blocking call. Nothing is done if the thread already ended.
+
+Arguments:
+
+  Thread    - The handle of the thread
+  ExitCode  - The exit code of the thread
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+
+  Handle = HandleCheck (Thread, HandleThread);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  //
+  // The thread is detached, so its ID is only valid until ThreadCleanup
+  //
+  pthread_mutex_lock (&Handle->Mutex);
+  if (!Handle->Exited) {
+    Handle->ExitCode = ExitCode;
+    pthread_cancel (Handle->Thread);
+  }
+  pthread_mutex_unlock (&Handle->Mutex);
+
+  return TRUE;
+}
+
+BOOL
+GetExitCodeThread (
+  HANDLE      Thread,
+  LPDWORD     ExitCode
+  )
+/*++
+
+Routine Description:
+
+  Get the exit code of a thread, STILL_ACTIVE if it is running.
+
+Arguments:
+
+  Thread    - The handle of the thread
+  ExitCode  - Return the exit code
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+
+  Handle = HandleCheck (Thread, HandleThread);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  *ExitCode = Handle->ExitCode;
+  return TRUE;
+}
+
+DWORD
+SuspendThread (
+  HANDLE      Thread
+  )
+/*++
+
+Routine Description:
+
+  Suspend the calling thread until ResumeThread is called. A thread can
+  not be suspended by the other threads with pthreads, (DWORD) -1 is
+  returned in that case.
+
+Arguments:
+
+  Thread  - The handle of the calling thread
+
+Returns:
+
+  0 on success, (DWORD) -1 otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+
+  Handle = HandleCheck (Thread, HandleThread);
+  if ((Handle == NULL) || (Handle != GetCurrentThread ())) {
+    LastError = ERROR_INVALID_PARAMETER;
+    return (DWORD) -1;
+  }
+
+  WaitForSingleObject (Handle->Resume, INFINITE);
+  return 0;
+}
+
+DWORD
+ResumeThread (
+  HANDLE      Thread
+  )
+/*++
+
+Routine Description:
+
+  Resume a thread suspended by SuspendThread.
+
+Arguments:
+
+  Thread  - The handle of the thread
+
+Returns:
+
+  1 on success, (DWORD) -1 otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+
+  Handle = HandleCheck (Thread, HandleThread);
+  if (Handle == NULL) {
+    return (DWORD) -1;
+  }
+
+  SetEvent (Handle->Resume);
+  return 1;
+}
+
+//
+// Time
+//
+
+VOID
+Sleep (
+  DWORD       Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Suspend the calling thread for Milliseconds.
+
+Arguments:
+
+  Milliseconds  - The time to sleep
+
+Returns:
+
+  None
+
+--*/
+{
+  struct timespec Time;
+
+  Time.tv_sec   = Milliseconds / 1000;
+  Time.tv_nsec  = (Milliseconds % 1000) * 1000000;
+  while ((nanosleep (&Time, &Time) != 0) && (errno == EINTR))
+    ;
+}
+
+DWORD
+GetTickCount (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the milliseconds elapsed since an unspecified point, from the
+  monotonic clock. The value wraps around as on Windows.
+
+Arguments:
+
+  None
+
+Returns:
+
+  The tick count
+
+--*/
+{
+  struct timespec Time;
+
+  clock_gettime (CLOCK_MONOTONIC, &Time);
+  return (DWORD) ((UINT64) Time.tv_sec * 1000 + Time.tv_nsec / 1000000);
+}
+
+VOID
+GetSystemTime (
+  SYSTEMTIME  *SystemTime
+  )
+/*++
+
+Routine Description:
+
+  Get the current UTC time.
+
+Arguments:
+
+  SystemTime  - Return the time
+
+Returns:
+
+  None
+
+--*/
+{
+  struct timespec Time;
+  struct tm       Tm;
+
+  clock_gettime (CLOCK_REALTIME, &Time);
+  gmtime_r (&Time.tv_sec, &Tm);
+
+  SystemTime->wYear         = (WORD) (Tm.tm_year + 1900);
+  SystemTime->wMonth        = (WORD) (Tm.tm_mon + 1);
+  SystemTime->wDayOfWeek    = (WORD) Tm.tm_wday;
+  SystemTime->wDay          = (WORD) Tm.tm_mday;
+  SystemTime->wHour         = (WORD) Tm.tm_hour;
+  SystemTime->wMinute       = (WORD) Tm.tm_min;
+  SystemTime->wSecond       = (WORD) Tm.tm_sec;
+  SystemTime->wMilliseconds = (WORD) (Time.tv_nsec / 1000000);
+}
+
+DWORD
+GetLastError (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the error code of the last failed call of this backend in the calling
+  thread.
+
+Arguments:
+
+  None
+
+Returns:
+
+  The error code
+
+--*/
+{
+  return LastError;
+}
+
+//
+// File
+//
+
+BOOL
+CreateDirectory (
+  const char  *PathName,
+  PVOID       Attributes
+  )
+/*++
+
+Routine Description:
+
+  Create a directory. Attributes is ignored.
+
+Arguments:
+
+  PathName    - The path of the directory
+  Attributes  - Not used
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  if (mkdir (PathName, 0777) != 0) {
+    LastError = ErrnoToError (errno);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+HANDLE
+CreateFile (
+  const char  *FileName,
+  DWORD       DesiredAccess,
+  DWORD       ShareMode,
+  PVOID       Attributes,
+  DWORD       CreationDisposition,
+  DWORD       FlagsAndAttributes,
+  HANDLE      TemplateFile
+  )
+/*++
+
+Routine Description:
+
+  Open a file. Only CREATE_ALWAYS and OPEN_EXISTING are supported. The
+  sharing mode, the attributes and the template are ignored.
+
+Arguments:
+
+  FileName            - The path of the file
+  DesiredAccess       - GENERIC_READ and/or GENERIC_WRITE
+  ShareMode           - Not used
+  Attributes          - Not used
+  CreationDisposition - CREATE_ALWAYS or OPEN_EXISTING
+  FlagsAndAttributes  - Not used
+  TemplateFile        - Not used
+
+Returns:
+
+  The handle of the file, or INVALID_HANDLE_VALUE on failure
+
+--*/
+{
+  EMS_HANDLE  *File;
+  INT32       Flags;
+
+  if ((DesiredAccess & GENERIC_READ) && (DesiredAccess & GENERIC_WRITE)) {
+    Flags = O_RDWR;
+  } else if (DesiredAccess & GENERIC_WRITE) {
+    Flags = O_WRONLY;
+  } else {
+    Flags = O_RDONLY;
+  }
+
+  switch (CreationDisposition) {
+  case CREATE_ALWAYS:
+    Flags |= O_CREAT | O_TRUNC;
+    break;
+
+  case OPEN_EXISTING:
+    break;
+
+  default:
+    LastError = ERROR_INVALID_PARAMETER;
+    return INVALID_HANDLE_VALUE;
+  }
+
+  File = HandleCreate (HandleFile);
+  if (File == NULL) {
+    return INVALID_HANDLE_VALUE;
+  }
+
+  File->Fd = open (FileName, Flags | O_CLOEXEC, 0666);
+  if (File->Fd < 0) {
+    LastError = ErrnoToError (errno);
+    free (File);
+    return INVALID_HANDLE_VALUE;
+  }
+
+  return File;
+}
+
+BOOL
+ReadFile (
+  HANDLE      File,
+  PVOID       Buffer,
+  DWORD       NumberOfBytesToRead,
+  LPDWORD     NumberOfBytesRead,
+  PVOID       Overlapped
+  )
+/*++
+
+Routine Description:
+
+  Read a file until the buffer is full or the end of the file.
+
+Arguments:
+
+  File                - The handle of the file
+  Buffer              - The buffer
+  NumberOfBytesToRead - The size of the buffer
+  NumberOfBytesRead   - Return the bytes read
+  Overlapped          - Must be NULL
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+  ssize_t     Ret;
+  DWORD       Done;
+
+  *NumberOfBytesRead = 0;
+
+  Handle = HandleCheck (File, HandleFile);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  for (Done = 0; Done < NumberOfBytesToRead; Done += (DWORD) Ret) {
+    Ret = read (Handle->Fd, (UINT8 *) Buffer + Done, NumberOfBytesToRead - Done);
+    if (Ret < 0) {
+      if (errno == EINTR) {
+        Ret = 0;
+        continue;
+      }
+
+      LastError = ErrnoToError (errno);
+      *NumberOfBytesRead = Done;
+      return FALSE;
+    }
+
+    if (Ret == 0) {
+      break;
+    }
+  }
+
+  *NumberOfBytesRead = Done;
+  return TRUE;
+}
+
+BOOL
+WriteFile (
+  HANDLE      File,
+  const VOID  *Buffer,
+  DWORD       NumberOfBytesToWrite,
+  LPDWORD     NumberOfBytesWritten,
+  PVOID       Overlapped
+  )
+/*++
+
+Routine Description:
+
+  Write a whole buffer to a file.
+
+Arguments:
+
+  File                  - The handle of the file
+  Buffer                - The buffer
+  NumberOfBytesToWrite  - The size of the buffer
+  NumberOfBytesWritten  - Return the bytes written
+  Overlapped            - Must be NULL
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Handle;
+  ssize_t     Ret;
+  DWORD       Done;
+
+  *NumberOfBytesWritten = 0;
+
+  Handle = HandleCheck (File, HandleFile);
+  if (Handle == NULL) {
+    return FALSE;
+  }
+
+  for (Done = 0; Done < NumberOfBytesToWrite; Done += (DWORD) Ret) {
+    Ret = write (Handle->Fd, (const UINT8 *) Buffer + Done, NumberOfBytesToWrite - Done);
+    if (Ret < 0) {
+      if (errno == EINTR) {
+        Ret = 0;
+        continue;
+      }
+
+      LastError = ErrnoToError (errno);
+      *NumberOfBytesWritten = Done;
+      return FALSE;
+    }
+  }
+
+  *NumberOfBytesWritten = Done;
+  return TRUE;
+}
+
+HANDLE
+FindFirstFile (
+  const char        *FileName,
+  WIN32_FIND_DATA   *FindFileData
+  )
+/*++
+
+Routine Description:
+
+  Find the first file matching FileName, a path whose last component may
+  contain the '*' and '?' wildcards. As on Windows, "*" matches "." and
+  "..".
+
+Arguments:
+
+  FileName      - The path to match
+  FindFileData  - Return the first file found
+
+Returns:
+
+  The search handle, or INVALID_HANDLE_VALUE if no file is found
+
+--*/
+{
+  EMS_HANDLE  *Find;
+  const char  *Separator;
+  UINT32      PathLen;
+
+  Find = HandleCreate (HandleFind);
+  if (Find == NULL) {
+    return INVALID_HANDLE_VALUE;
+  }
+
+  Separator = strrchr (FileName, '/');
+  if (Separator == NULL) {
+    strcpy (Find->Path, ".");
+    Separator = FileName - 1;
+  } else {
+    PathLen = (UINT32) (Separator - FileName);
+    if ((PathLen == 0) || (PathLen >= MAX_PATH)) {
+      PathLen = (PathLen == 0) ? 1 : MAX_PATH - 1;
+    }
+
+    memcpy (Find->Path, FileName, PathLen);
+    Find->Path[PathLen] = '\0';
+  }
+
+  strncpy (Find->Pattern, Separator + 1, MAX_PATH - 1);
+
+  Find->Dir = opendir (Find->Path);
+  if (Find->Dir == NULL) {
+    LastError = ErrnoToError (errno);
+    free (Find);
+    return INVALID_HANDLE_VALUE;
+  }
+
+  if (!FindNextFile (Find, FindFileData)) {
+    closedir (Find->Dir);
+    free (Find);
+    LastError = ERROR_FILE_NOT_FOUND;
+    return INVALID_HANDLE_VALUE;
+  }
+
+  return Find;
+}
+
+BOOL
+FindNextFile (
+  HANDLE            FindFile,
+  WIN32_FIND_DATA   *FindFileData
+  )
+/*++
+
+Routine Description:
+
+  Find the next file. ERROR_NO_MORE_FILES is set when there are no more.
+
+Arguments:
+
+  FindFile      - The search handle
+  FindFileData  - Return the file found
+
+Returns:
+
+  TRUE if a file is found, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE    *Find;
+  struct dirent *Entry;
+  struct stat   Stat;
+  INT8          Path[MAX_PATH * 2];
+
+  Find = HandleCheck (FindFile, HandleFind);
+  if (Find == NULL) {
+    return FALSE;
+  }
+
+  while ((Entry = readdir (Find->Dir)) != NULL) {
+    if (fnmatch (Find->Pattern, Entry->d_name, 0) != 0) {
+      continue;
+    }
+
+    snprintf (Path, sizeof (Path), "%s/%s", Find->Path, Entry->d_name);
+    if ((stat (Path, &Stat) == 0) && S_ISDIR (Stat.st_mode)) {
+      FindFileData->dwFileAttributes = FILE_ATTRIBUTE_DIRECTORY;
+    } else {
+      FindFileData->dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    }
+
+    strncpy (FindFileData->cFileName, Entry->d_name, MAX_PATH - 1);
+    FindFileData->cFileName[MAX_PATH - 1] = '\0';
+    return TRUE;
+  }
+
+  LastError = ERROR_NO_MORE_FILES;
+  return FALSE;
+}
+
+BOOL
+FindClose (
+  HANDLE            FindFile
+  )
+/*++
+
+Routine Description:
+
+  Close a search handle.
+
+Arguments:
+
+  FindFile  - The search handle
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Find;
+
+  Find = HandleCheck (FindFile, HandleFind);
+  if (Find == NULL) {
+    return FALSE;
+  }
+
+  closedir (Find->Dir);
+  free (Find);
+  return TRUE;
+}
+
+BOOL
+CloseHandle (
+  HANDLE      Handle
+  )
+/*++
+
+Routine Description:
+
+  Close any handle of this backend. A thread keeps running after its
+  handle is closed.
+
+Arguments:
+
+  Handle  - The handle to close
+
+Returns:
+
+  TRUE on success, FALSE otherwise
+
+--*/
+{
+  EMS_HANDLE  *Object;
+
+  if ((Handle == NULL) || (Handle == INVALID_HANDLE_VALUE)) {
+    LastError = ERROR_INVALID_HANDLE;
+    return FALSE;
+  }
+
+  Object = (EMS_HANDLE *) Handle;
+  switch (Object->Type) {
+  case HandleMutex:
+    pthread_mutex_destroy (&Object->Mutex);
+    break;
+
+  case HandleEvent:
+  case HandleFile:
+    close (Object->Fd);
+    break;
+
+  case HandleThread:
+    ThreadHandleRelease (Object);
+    return TRUE;
+
+  case HandleFind:
+    return FindClose (Handle);
+
+  default:
+    LastError = ERROR_INVALID_HANDLE;
+    return FALSE;
+  }
+
+  Object->Type = 0;
+  free (Object);
+  return TRUE;
+}
+
+//
+// Adapter
+//
+
+DWORD
+GetAdaptersInfo (
+  PIP_ADAPTER_INFO  AdapterInfo,
+  PULONG            SizePointer
+  )
+/*++
+
+Routine Description:
+
+  Get the Ethernet adapters of the system, the loopback excluded. The name
+  of an adapter is the one of the interface, which is also the device name
+  of libpcap and libnet. If the buffer is too small, the size needed is
+  returned in SizePointer.
+
+Arguments:
+
+  AdapterInfo - The buffer to receive the list of the adapters
+  SizePointer - The size of the buffer
+
+Returns:
+
+  ERROR_SUCCESS, ERROR_BUFFER_OVERFLOW or ERROR_NO_DATA
+
+--*/
+{
+  struct ifaddrs      *List;
+  struct ifaddrs      *Entry;
+  struct sockaddr_ll  *Link;
+  UINT32              Count;
+  UINT32              Index;
+
+  if (getifaddrs (&List) != 0) {
+    return ERROR_NO_DATA;
+  }
+
+  Count = 0;
+  for (Entry = List; Entry != NULL; Entry = Entry->ifa_next) {
+    if ((Entry->ifa_addr != NULL) && (Entry->ifa_addr->sa_family == AF_PACKET) &&
+        !(Entry->ifa_flags & IFF_LOOPBACK)) {
+      Count++;
+    }
+  }
+
+  if (Count == 0) {
+    freeifaddrs (List);
+    return ERROR_NO_DATA;
+  }
+
+  if ((AdapterInfo == NULL) || (*SizePointer < Count * sizeof (IP_ADAPTER_INFO))) {
+    *SizePointer = Count * sizeof (IP_ADAPTER_INFO);
+    freeifaddrs (List);
+    return ERROR_BUFFER_OVERFLOW;
+  }
+
+  Index = 0;
+  for (Entry = List; Entry != NULL; Entry = Entry->ifa_next) {
+    if ((Entry->ifa_addr == NULL) || (Entry->ifa_addr->sa_family != AF_PACKET) ||
+        (Entry->ifa_flags & IFF_LOOPBACK)) {
+      continue;
+    }
+
+    Link = (struct sockaddr_ll *) Entry->ifa_addr;
+    memset (&AdapterInfo[Index], 0, sizeof (IP_ADAPTER_INFO));
+    AdapterInfo[Index].Index          = (DWORD) Link->sll_ifindex;
+    AdapterInfo[Index].AddressLength  = (Link->sll_halen < MAX_ADAPTER_ADDRESS_LENGTH) ?
+                                        Link->sll_halen : MAX_ADAPTER_ADDRESS_LENGTH;
+    memcpy (AdapterInfo[Index].Address, Link->sll_addr, AdapterInfo[Index].AddressLength);
+    strncpy (AdapterInfo[Index].AdapterName, Entry->ifa_name, MAX_ADAPTER_NAME_LENGTH);
+    strncpy (AdapterInfo[Index].Description, Entry->ifa_name, MAX_ADAPTER_DESCRIPTION_LENGTH);
+    AdapterInfo[Index].Next           = (Index + 1 < Count) ? &AdapterInfo[Index + 1] : NULL;
+    Index++;
+  }
+
+  freeifaddrs (List);
+  return ERROR_SUCCESS;
+}
+
+STATIC
+DWORD
+IpAddressRequest (
+  IN UINT16             Type,
+  IN IP_ADDRESS_CONTEXT *Context
+  )
+/*++
+
+Routine Description:
+
+  Send an RTM_NEWADDR or RTM_DELADDR request and wait for its
+  acknowledgement.
+
+--*/
+{
+  struct {
+    struct nlmsghdr   Header;
+    struct ifaddrmsg  Message;
+    UINT8             Attributes[64];
+  }                   Request;
+  struct {
+    struct nlmsghdr   Header;
+    struct nlmsgerr   Error;
+  }                   Reply;
+  struct sockaddr_nl  Kernel;
+  struct rtattr       *Attribute;
+  INT32               Socket;
+  ssize_t             Len;
+  DWORD               Status;
+
+  memset (&Request, 0, sizeof (Request));
+  Request.Header.nlmsg_len        = NLMSG_LENGTH (sizeof (struct ifaddrmsg));
+  Request.Header.nlmsg_type       = Type;
+  Request.Header.nlmsg_flags      = NLM_F_REQUEST | NLM_F_ACK;
+  if (Type == RTM_NEWADDR) {
+    Request.Header.nlmsg_flags   |= NLM_F_CREATE | NLM_F_EXCL;
+  }
+
+  Request.Message.ifa_family      = AF_INET;
+  Request.Message.ifa_prefixlen   = Context->PrefixLength;
+  Request.Message.ifa_scope       = RT_SCOPE_UNIVERSE;
+  Request.Message.ifa_index       = Context->IfIndex;
+
+  //
+  // IFA_LOCAL and IFA_ADDRESS are the same address on a broadcast link
+  //
+  Attribute = (struct rtattr *) ((UINT8 *) &Request + NLMSG_ALIGN (Request.Header.nlmsg_len));
+  Attribute->rta_type = IFA_LOCAL;
+  Attribute->rta_len  = RTA_LENGTH (sizeof (IPAddr));
+  memcpy (RTA_DATA (Attribute), &Context->Address, sizeof (IPAddr));
+  Request.Header.nlmsg_len = NLMSG_ALIGN (Request.Header.nlmsg_len) + RTA_ALIGN (Attribute->rta_len);
+
+  Attribute = (struct rtattr *) ((UINT8 *) &Request + NLMSG_ALIGN (Request.Header.nlmsg_len));
+  Attribute->rta_type = IFA_ADDRESS;
+  Attribute->rta_len  = RTA_LENGTH (sizeof (IPAddr));
+  memcpy (RTA_DATA (Attribute), &Context->Address, sizeof (IPAddr));
+  Request.Header.nlmsg_len = NLMSG_ALIGN (Request.Header.nlmsg_len) + RTA_ALIGN (Attribute->rta_len);
+
+  Socket = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (Socket < 0) {
+    return ErrnoToError (errno);
+  }
+
+  memset (&Kernel, 0, sizeof (Kernel));
+  Kernel.nl_family = AF_NETLINK;
+  if (sendto (Socket, &Request, Request.Header.nlmsg_len, 0, (struct sockaddr *) &Kernel, sizeof (Kernel)) < 0) {
+    Status = ErrnoToError (errno);
+    close (Socket);
+    return Status;
+  }
+
+  Len = recv (Socket, &Reply, sizeof (Reply), 0);
+  if ((Len < (ssize_t) sizeof (Reply)) || (Reply.Header.nlmsg_type != NLMSG_ERROR)) {
+    Status = ERROR_INVALID_PARAMETER;
+  } else {
+    Status = (Reply.Error.error == 0) ? ERROR_SUCCESS : ErrnoToError (-Reply.Error.error);
+  }
+
+  close (Socket);
+  return Status;
+}
+
+DWORD
+AddIPAddress (
+  IPAddr            Address,
+  IPMask            Mask,
+  DWORD             IfIndex,
+  PULONG            NTEContext,
+  PULONG            NTEInstance
+  )
+/*++
+
+Routine Description:
+
+  Add an IPv4 address to an adapter with rtnetlink. The context returned is
+  never 0, and is used to delete the address.
+
+Arguments:
+
+  Address     - The address, in network byte order
+  Mask        - The subnet mask, in network byte order
+  IfIndex     - The index of the adapter
+  NTEContext  - Return the context of the address
+  NTEInstance - Return the instance of the address, always 0
+
+Returns:
+
+  ERROR_SUCCESS, or the error of the failure
+
+--*/
+{
+  IP_ADDRESS_CONTEXT  *Context;
+  UINT32              Index;
+  DWORD               Status;
+
+  pthread_mutex_lock (&IpAddressLock);
+  for (Index = 0; Index < MAX_IP_ADDRESS_CONTEXT; Index++) {
+    if (!IpAddressTable[Index].InUse) {
+      break;
+    }
+  }
+
+  if (Index == MAX_IP_ADDRESS_CONTEXT) {
+    pthread_mutex_unlock (&IpAddressLock);
+    return ERROR_NOT_ENOUGH_MEMORY;
+  }
+
+  Context               = &IpAddressTable[Index];
+  Context->IfIndex      = IfIndex;
+  Context->Address      = Address;
+  Context->PrefixLength = (UINT8) __builtin_popcount (Mask);
+
+  Status = IpAddressRequest (RTM_NEWADDR, Context);
+  if (Status == ERROR_SUCCESS) {
+    Context->InUse  = TRUE;
+    *NTEContext     = Index + 1;
+    *NTEInstance    = 0;
+  }
+
+  pthread_mutex_unlock (&IpAddressLock);
+  return Status;
+}
+
+DWORD
+DeleteIPAddress (
+  ULONG             NTEContext
+  )
+/*++
+
+Routine Description:
+
+  Delete an IPv4 address added by AddIPAddress.
+
+Arguments:
+
+  NTEContext  - The context returned by AddIPAddress
+
+Returns:
+
+  ERROR_SUCCESS, or the error of the failure
+
+--*/
+{
+  DWORD               Status;
+
+  if ((NTEContext == 0) || (NTEContext > MAX_IP_ADDRESS_CONTEXT)) {
+    return ERROR_INVALID_PARAMETER;
+  }
+
+  pthread_mutex_lock (&IpAddressLock);
+  if (!IpAddressTable[NTEContext - 1].InUse) {
+    pthread_mutex_unlock (&IpAddressLock);
+    return ERROR_INVALID_PARAMETER;
+  }
+
+  Status = IpAddressRequest (RTM_DELADDR, &IpAddressTable[NTEContext - 1]);
+  IpAddressTable[NTEContext - 1].InUse = FALSE;
+  pthread_mutex_unlock (&IpAddressLock);
+  return Status;
+}
+
+#endif
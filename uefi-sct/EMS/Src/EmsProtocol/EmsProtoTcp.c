@@ -240,7 +240,7 @@ Returns:
   //  Initialize the libnet
   //
   l = libnet_init (
-        LIBNET_LINK,
+        LIBNET_LINK_ADV,
         /* injection type */EmsInterface,
         /* network interface */ErrBuf /* errbuf */
         );
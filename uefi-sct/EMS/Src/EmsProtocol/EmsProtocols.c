@@ -35,7 +35,7 @@ Abstract:
 #include "EmsProtoIcmp.h"
 #include "EmsProtoDhcp.h"
 #include "EmsProtoTcp.h"
-#include "EmsProtoIPv6.h"
+#include "EmsProtoIpv6.h"
 
 PROTOCOL_ENTRY_T  *Protocols[] = {
   &EthProtocol,
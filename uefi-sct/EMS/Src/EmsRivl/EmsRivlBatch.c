@@ -0,0 +1,94 @@
+/** @file
+
+  Copyright 2006 - 2011 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2011, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+    EmsRivlBatch.c
+
+Abstract:
+
+    Implementation of RIVL RivlBatch(TCL command)
+
+--*/
+
+#include "EmsRivlType.h"
+#include "EmsRivlMain.h"
+#include "EmsRpcMain.h"
+
+INT32
+TclRivlBatch (
+  IN ClientData        clientData,
+  IN Tcl_Interp        *Interp,
+  IN INT32             Argc,
+  IN CONST84 INT8      *Argv[]
+  )
+/*++
+
+Routine Description:
+
+  TCL command "RivlBatch" implementation routine. The script is evaluated
+  with the SetVar, DelVar, DelType and variable and type creation commands
+  queued, and the queued commands are sent to the agent in one message when
+  another command needs its ack or the script ends.
+
+Arguments:
+
+  clientData  - Private data, if any.
+  Interp      - TCL intepreter.
+  Argc        - Argument counter.
+  Argv        - Argument value pointer array.
+
+Returns:
+
+  TCL_OK or TCL_ERROR
+
+--*/
+{
+  INT8    ErrorBuff[MAX_ERRBUFF_LEN];
+  INT8    FailBuff[MAX_ERRBUFF_LEN];
+  INT32   Result;
+  UINT32  Failed;
+
+  //
+  // Format of RivlBatch should be
+  //      RivlBatch {script}
+  //
+  if (Argc != 2) {
+    sprintf (ErrorBuff, "RivlBatch: RivlBatch {script}");
+    goto ErrorExit;
+  }
+
+  RpcBatchBegin ();
+  Result = Tcl_Eval (Interp, Argv[1]);
+  Failed = RpcBatchEnd (FailBuff);
+
+  if (Result != TCL_OK) {
+    return Result;
+  }
+
+  if (Failed != 0) {
+    Tcl_ResetResult (Interp);
+    sprintf (ErrorBuff, "EAS: RivlBatch %d command(s) failed, ", Failed);
+    Tcl_AppendResult (Interp, ErrorBuff, FailBuff, (INT8 *) NULL);
+    return TCL_ERROR;
+  }
+
+  return TCL_OK;
+
+ErrorExit:
+  Tcl_AppendResult (Interp, ErrorBuff, (INT8 *) NULL);
+  return TCL_ERROR;
+}
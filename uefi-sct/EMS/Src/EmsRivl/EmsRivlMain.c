@@ -104,6 +104,10 @@ STATIC TCL_CMD_TBL  TclCmd[] = {
     "Exec",
     TclExec
   },
+  {
+    "RivlBatch",
+    TclRivlBatch
+  },
   {
     "GetFile",
     TclGetFile
@@ -26,10 +26,166 @@ Abstract:
 
 #include "EmsRivlMain.h"
 #include "EmsRivlType.h"
+#include "EmsRivlUtil.h"
 #include "stdlib.h"
 
 RIVL_TYPE *ExternalTypes = NULL;
 
+//
+// ExternalTypes keeps the definition order, TypeHash finds a type by name
+//
+STATIC RIVL_TYPE  *ExternalTypesTail  = NULL;
+STATIC RIVL_TYPE  **TypeHash          = NULL;
+STATIC UINT32     TypeHashSize        = 0;
+STATIC UINT32     TypeCount           = 0;
+
+STATIC
+BOOLEAN
+RivlTypeHashGrow (
+  VOID_P
+  )
+/*++
+
+Routine Description:
+
+  Double the type hash table, or create it, and hash all the types again
+
+Arguments:
+
+  None
+
+Returns:
+
+  TRUE if all the types are hashed in a new table, FALSE if out of memory
+
+--*/
+{
+  RIVL_TYPE *TPointer;
+  RIVL_TYPE **NewHash;
+  UINT32    NewSize;
+  UINT32    Bucket;
+
+  NewSize = (TypeHashSize == 0) ? RIVL_HASH_MIN_SIZE : TypeHashSize * 2;
+  NewHash = (RIVL_TYPE **) calloc (NewSize, sizeof (RIVL_TYPE *));
+  if (NewHash == NULL) {
+    //
+    // Keep the old table, it only gets slower
+    //
+    return FALSE;
+  }
+
+  for (TPointer = ExternalTypes; TPointer; TPointer = TPointer->Next) {
+    Bucket                = RivlNameHash (TPointer->Name) & (NewSize - 1);
+    TPointer->NextByName  = NewHash[Bucket];
+    NewHash[Bucket]       = TPointer;
+  }
+
+  free (TypeHash);
+  TypeHash      = NewHash;
+  TypeHashSize  = NewSize;
+  return TRUE;
+}
+
+STATIC
+VOID_P
+RivlTypeBuildMemberMap (
+  RIVL_TYPE *Type
+  )
+/*++
+
+Routine Description:
+
+  Build the member map of a type: an open addressing table of the member
+  indexes by name, at most half full. Without it the members are searched
+  one by one.
+
+Arguments:
+
+  Type  - The RIVL type
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Size;
+  UINT32  Index;
+  UINT32  Slot;
+
+  Type->MemberMap     = NULL;
+  Type->MemberMapSize = 0;
+  if ((Type->Members == NULL) || (Type->MemberNum == 0)) {
+    return ;
+  }
+
+  for (Size = 4; Size < Type->MemberNum * 2; Size *= 2)
+    ;
+  Type->MemberMap = (UINT32 *) calloc (Size, sizeof (UINT32));
+  if (Type->MemberMap == NULL) {
+    return ;
+  }
+
+  Type->MemberMapSize = Size;
+  for (Index = 0; Index < Type->MemberNum; Index++) {
+    Slot = RivlNameHash (Type->Members[Index].Name) & (Size - 1);
+    while (Type->MemberMap[Slot] != 0) {
+      Slot = (Slot + 1) & (Size - 1);
+    }
+
+    Type->MemberMap[Slot] = Index + 1;
+  }
+}
+
+STATIC
+VOID_P
+RivlTypeUnlink (
+  RIVL_TYPE *Type
+  )
+/*++
+
+Routine Description:
+
+  Take a type out of the type list and the hash table
+
+Arguments:
+
+  Type  - The RIVL type to be unlinked
+
+Returns:
+
+  None
+
+--*/
+{
+  RIVL_TYPE *TPointer;
+  RIVL_TYPE **Link;
+
+  if (TypeHash != NULL) {
+    Link = &TypeHash[RivlNameHash (Type->Name) & (TypeHashSize - 1)];
+    while (*Link != Type) {
+      Link = &(*Link)->NextByName;
+    }
+
+    *Link = Type->NextByName;
+  }
+
+  if (ExternalTypes == Type) {
+    ExternalTypes = Type->Next;
+    TPointer      = NULL;
+  } else {
+    for (TPointer = ExternalTypes; TPointer->Next != Type; TPointer = TPointer->Next)
+      ;
+    TPointer->Next = Type->Next;
+  }
+
+  if (ExternalTypesTail == Type) {
+    ExternalTypesTail = TPointer;
+  }
+
+  TypeCount--;
+}
+
 RIVL_TYPE *
 RivlTypeFindByName (
   INT8 *Name
@@ -51,13 +207,31 @@ Returns:
 --*/
 {
   RIVL_TYPE *TPointer;
-  TPointer = ExternalTypes;
+
+  if (Name == NULL) {
+    return NULL;
+  }
+
+  //
+  // Without the table, out of memory, the list is walked
+  //
+  if (TypeHash == NULL) {
+    for (TPointer = ExternalTypes; TPointer; TPointer = TPointer->Next) {
+      if (0 == strcmp (Name, TPointer->Name)) {
+        break;
+      }
+    }
+
+    return TPointer;
+  }
+
+  TPointer = TypeHash[RivlNameHash (Name) & (TypeHashSize - 1)];
   while (TPointer) {
     if (0 == strcmp (Name, TPointer->Name)) {
       break;
     }
 
-    TPointer = TPointer->Next;
+    TPointer = TPointer->NextByName;
   }
 
   return TPointer;
@@ -106,29 +280,15 @@ Returns:
 
 --*/
 {
-  RIVL_TYPE *TPointer;
-
   RIVL_TYPE *DestroyPointer;
 
-  if (ExternalTypes == NULL) {
+  DestroyPointer = RivlTypeFindByName (Name);
+  if (DestroyPointer == NULL) {
     return ;
   }
 
-  if (0 == strcmp (Name, ExternalTypes->Name)) {
-    DestroyPointer  = ExternalTypes;
-    ExternalTypes   = ExternalTypes->Next;
-    RivlTypeDestroy (DestroyPointer);
-    return ;
-  }
-
-  for (TPointer = ExternalTypes; TPointer && TPointer->Next; TPointer = TPointer->Next) {
-    if (0 == strcmp (Name, TPointer->Next->Name)) {
-      DestroyPointer  = TPointer->Next;
-      TPointer->Next  = TPointer->Next->Next;
-      RivlTypeDestroy (DestroyPointer);
-      return ;
-    }
-  }
+  RivlTypeUnlink (DestroyPointer);
+  RivlTypeDestroy (DestroyPointer);
   //
   //  Tcl_DeleteCommand(tcl_interpreter, name);
   //
@@ -155,6 +315,7 @@ Returns:
 --*/
 {
   if (Type) {
+    free (Type->MemberMap);
     free (Type->Members);
     free (Type);
   }
@@ -181,7 +342,6 @@ Returns:
 --*/
 {
   RIVL_TYPE *TPointer;
-  TPointer  = ExternalTypes;
 
   TPointer  = ExternalTypes;
   while (TPointer) {
@@ -189,6 +349,12 @@ Returns:
     RivlTypeDestroy (TPointer);
     TPointer = ExternalTypes;
   }
+
+  free (TypeHash);
+  TypeHash          = NULL;
+  TypeHashSize      = 0;
+  TypeCount         = 0;
+  ExternalTypesTail = NULL;
 }
 
 VOID_P
@@ -199,7 +365,7 @@ RivlTypeAdd (
 
 Routine Description:
 
-  Add a new RIVL type
+  Add a new RIVL type, and build its member map
 
 Arguments:
 
@@ -211,21 +377,36 @@ Returns:
 
 --*/
 {
-  RIVL_TYPE *TPointer;
+  UINT32  Bucket;
+
   if (Type == NULL) {
     return ;
   }
 
+  RivlTypeBuildMemberMap (Type);
+
+  Type->Next = NULL;
   if (ExternalTypes == NULL) {
     ExternalTypes = Type;
-    Type->Next    = NULL;
+  } else {
+    ExternalTypesTail->Next = Type;
+  }
+
+  ExternalTypesTail = Type;
+  TypeCount++;
+
+  //
+  // A new table hashes the type with all the others
+  //
+  if (((TypeHash == NULL) || (TypeCount > TypeHashSize * 2)) && RivlTypeHashGrow ()) {
     return ;
   }
 
-  for (TPointer = ExternalTypes; TPointer->Next; TPointer = TPointer->Next)
-    ;
-  TPointer->Next  = Type;
-  Type->Next      = NULL;
+  if (TypeHash == NULL) {
+    return ;
+  }
 
-  return ;
+  Bucket            = RivlNameHash (Type->Name) & (TypeHashSize - 1);
+  Type->NextByName  = TypeHash[Bucket];
+  TypeHash[Bucket]  = Type;
 }
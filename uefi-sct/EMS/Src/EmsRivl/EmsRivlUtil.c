@@ -433,6 +433,36 @@ Returns:
   return ;
 }
 
+UINT32
+RivlNameHash (
+  IN INT8      *Name
+  )
+/*++
+
+Routine Description:
+
+  Hash a variable, type or member name for the lookup tables
+
+Arguments:
+
+  Name    - The name
+
+Returns:
+
+  The FNV-1a hash of the name
+
+--*/
+{
+  UINT32  Hash;
+
+  Hash = 2166136261U;
+  while (*Name != '\0') {
+    Hash = (Hash ^ (UINT8) *Name++) * 16777619U;
+  }
+
+  return Hash;
+}
+
 RIVL_MEMBER *
 GetMemberFromName (
   IN RIVL_TYPE *EType,
@@ -459,6 +489,23 @@ Returns:
   UINT32      MemberNum;
   RIVL_MEMBER *member;
 
+  //
+  // The member map of the type is probed linearly from the hash slot until
+  // an empty one
+  //
+  if (EType->MemberMap != NULL) {
+    for (Index = RivlNameHash (Name) & (EType->MemberMapSize - 1);
+         EType->MemberMap[Index] != 0;
+         Index = (Index + 1) & (EType->MemberMapSize - 1)) {
+      member = &(EType->Members[EType->MemberMap[Index] - 1]);
+      if (0 == strcmp (Name, member->Name)) {
+        return member;
+      }
+    }
+
+    return NULL;
+  }
+
   MemberNum = EType->MemberNum;
   for (Index = 0; Index < MemberNum; Index++) {
     member = &(EType->Members[Index]);
@@ -26,10 +26,72 @@ Abstract:
 
 #include "EmsRivlMain.h"
 #include "EmsRivlVar.h"
+#include "EmsRivlUtil.h"
 #include "stdlib.h"
 
 STATIC RIVL_VARIABLE  *Variables = NULL;
 
+//
+// Variables keeps the definition order, VariableHash finds a variable by
+// name. The variables of no scope are chained from GlobalFirst, the ones of
+// a scope from its FirstVar.
+//
+STATIC RIVL_VARIABLE  *VariablesTail    = NULL;
+STATIC RIVL_VARIABLE  **VariableHash    = NULL;
+STATIC UINT32         VariableHashSize  = 0;
+STATIC UINT32         VariableCount     = 0;
+STATIC RIVL_VARIABLE  *GlobalFirst      = NULL;
+STATIC RIVL_VARIABLE  *GlobalLast       = NULL;
+
+STATIC
+BOOLEAN
+RivlVariableHashGrow (
+  VOID_P
+  )
+/*++
+
+Routine Description:
+
+  Double the variable hash table, or create it, and hash all the variables
+  again
+
+Arguments:
+
+  None
+
+Returns:
+
+  TRUE if all the variables are hashed in a new table, FALSE if out of
+  memory
+
+--*/
+{
+  RIVL_VARIABLE *VPointer;
+  RIVL_VARIABLE **NewHash;
+  UINT32        NewSize;
+  UINT32        Bucket;
+
+  NewSize = (VariableHashSize == 0) ? RIVL_HASH_MIN_SIZE : VariableHashSize * 2;
+  NewHash = (RIVL_VARIABLE **) calloc (NewSize, sizeof (RIVL_VARIABLE *));
+  if (NewHash == NULL) {
+    //
+    // Keep the old table, it only gets slower
+    //
+    return FALSE;
+  }
+
+  for (VPointer = Variables; VPointer; VPointer = VPointer->Next) {
+    Bucket                = RivlNameHash (VPointer->Name) & (NewSize - 1);
+    VPointer->NextByName  = NewHash[Bucket];
+    NewHash[Bucket]       = VPointer;
+  }
+
+  free (VariableHash);
+  VariableHash      = NewHash;
+  VariableHashSize  = NewSize;
+  return TRUE;
+}
+
 RIVL_VARIABLE *
 RivlVariableFindByName (
   INT8 *Name
@@ -56,13 +118,26 @@ Returns:
     return NULL;
   }
 
-  VPointer = Variables;
+  //
+  // Without the table, out of memory, the list is walked
+  //
+  if (VariableHash == NULL) {
+    for (VPointer = Variables; VPointer; VPointer = VPointer->Next) {
+      if (0 == strcmp (Name, VPointer->Name)) {
+        break;
+      }
+    }
+
+    return VPointer;
+  }
+
+  VPointer = VariableHash[RivlNameHash (Name) & (VariableHashSize - 1)];
   while (VPointer) {
-    if (VPointer->Name && (0 == strcmp (Name, VPointer->Name))) {
+    if (0 == strcmp (Name, VPointer->Name)) {
       return VPointer;
     }
 
-    VPointer = VPointer->Next;
+    VPointer = VPointer->NextByName;
   }
 
   return NULL;
@@ -88,42 +163,58 @@ Returns:
 
 --*/
 {
-  RIVL_VARIABLE *VPointer;
-
   RIVL_VARIABLE *destroy;
+  RIVL_VARIABLE **Link;
 
-  if (Variables == NULL) {
+  destroy = RivlVariableFindByName (Name);
+  if (destroy == NULL) {
     return ;
   }
   //
-  // if the first node is to be deleted
+  // Remove it from the hash bucket
   //
-  if (0 == strcmp (Name, Variables->Name)) {
-    destroy   = Variables;
-    Variables = destroy->Next;
-    RivlVariableDestroy (destroy);
-    return ;
+  if (VariableHash != NULL) {
+    Link = &VariableHash[RivlNameHash (Name) & (VariableHashSize - 1)];
+    while (*Link != destroy) {
+      Link = &(*Link)->NextByName;
+    }
+
+    *Link = destroy->NextByName;
   }
   //
-  // Find the variable
+  // Remove it from the chain
   //
-  for (VPointer = Variables; VPointer && VPointer->Next; VPointer = VPointer->Next) {
-    if (0 == strcmp (Name, VPointer->Next->Name)) {
-      destroy         = VPointer->Next;
-      VPointer->Next  = VPointer->Next->Next;
-      break;
-    }
+  if (destroy->Prev) {
+    destroy->Prev->Next = destroy->Next;
+  } else {
+    Variables = destroy->Next;
+  }
+
+  if (destroy->Next) {
+    destroy->Next->Prev = destroy->Prev;
+  } else {
+    VariablesTail = destroy->Prev;
   }
   //
   // Remove it from the chain by scope
   //
-  for (VPointer = Variables; VPointer && VPointer != destroy; VPointer = VPointer->Next) {
-    if (VPointer->NextByScope == destroy) {
-      VPointer->NextByScope = destroy->NextByScope;
-      break;
-    }
+  if (destroy->PrevByScope) {
+    destroy->PrevByScope->NextByScope = destroy->NextByScope;
+  } else if (destroy->Scope) {
+    destroy->Scope->FirstVar = destroy->NextByScope;
+  } else {
+    GlobalFirst = destroy->NextByScope;
   }
 
+  if (destroy->NextByScope) {
+    destroy->NextByScope->PrevByScope = destroy->PrevByScope;
+  } else if (destroy->Scope) {
+    destroy->Scope->LastVar = destroy->PrevByScope;
+  } else {
+    GlobalLast = destroy->PrevByScope;
+  }
+
+  VariableCount--;
   RivlVariableDestroy (destroy);
   return ;
 }
@@ -200,6 +291,14 @@ Returns:
     RivlVariableDestroy (Variable);
     Variable = Variables;
   }
+
+  free (VariableHash);
+  VariableHash      = NULL;
+  VariableHashSize  = 0;
+  VariableCount     = 0;
+  VariablesTail     = NULL;
+  GlobalFirst       = NULL;
+  GlobalLast        = NULL;
 }
 
 VOID_P
@@ -222,31 +321,61 @@ Returns:
 
 --*/
 {
-  RIVL_VARIABLE *VPointer;
+  UINT32  Bucket;
+
   if (Var == NULL) {
     return ;
   }
-
-  if (Variables == NULL) {
+  //
+  // Add to the tail, and to the tail by scope
+  //
+  Var->Next = NULL;
+  Var->Prev = VariablesTail;
+  if (VariablesTail) {
+    VariablesTail->Next = Var;
+  } else {
     Variables = Var;
-    Var->Next = NULL;
-    return ;
   }
+
+  VariablesTail     = Var;
+
+  Var->NextByScope  = NULL;
+  if (Var->Scope) {
+    Var->PrevByScope = Var->Scope->LastVar;
+    if (Var->Scope->LastVar) {
+      Var->Scope->LastVar->NextByScope = Var;
+    } else {
+      Var->Scope->FirstVar = Var;
+    }
+
+    Var->Scope->LastVar = Var;
+  } else {
+    Var->PrevByScope = GlobalLast;
+    if (GlobalLast) {
+      GlobalLast->NextByScope = Var;
+    } else {
+      GlobalFirst = Var;
+    }
+
+    GlobalLast = Var;
+  }
+
+  VariableCount++;
+
   //
-  // Add to the tail  by scope
+  // A new table hashes the variable with all the others
   //
-  for (VPointer = Variables; VPointer; VPointer = VPointer->Next) {
-    if ((VPointer->Scope == Var->Scope) && (NULL == VPointer->NextByScope)) {
-      VPointer->NextByScope = Var;
-      break;
-    }
+  if (((VariableHash == NULL) || (VariableCount > VariableHashSize * 2)) && RivlVariableHashGrow ()) {
+    return ;
   }
 
-  for (VPointer = Variables; VPointer->Next; VPointer = VPointer->Next)
-    ;
-  VPointer->Next    = Var;
-  Var->Next         = NULL;
-  Var->NextByScope  = NULL;
+  if (VariableHash == NULL) {
+    return ;
+  }
+
+  Bucket                = RivlNameHash (Var->Name) & (VariableHashSize - 1);
+  Var->NextByName       = VariableHash[Bucket];
+  VariableHash[Bucket]  = Var;
 
   return ;
 }
@@ -271,15 +400,9 @@ Returns:
 
 --*/
 {
-  RIVL_VARIABLE *VPointer;
   if (NULL == Scope) {
     return NULL;
   }
 
-  for (VPointer = Variables; VPointer; VPointer = VPointer->Next) {
-    if (VPointer->Scope == Scope) {
-      return VPointer;
-    }
-  };
-  return NULL;
+  return Scope->FirstVar;
 }
@@ -33,6 +33,7 @@ Abstract:
 #include "EmsRpcEth.h"
 #include "EmsRpcTarget.h"
 #include "EmsLogUtility.h"
+#include "EmsPktEngine.h"
 
 extern HANDLE EmsTimerMutex;
 extern HANDLE EmsListenMutex;
@@ -65,7 +66,40 @@ STATIC UINT32   LastRecvSeq;
 STATIC UINT32   FragSeq;
 STATIC INT32    CurState;
 
-STATIC pcap_t   *Des;
+//
+// The windowed link negotiated with the current target. LinkWindow is 0 for
+// the stop-and-wait link.
+//
+STATIC UINT32   LinkWindow      = 0;
+STATIC UINT32   LinkMaxMessage  = 0;
+
+//
+// Sender side of the windowed link, protected by EmsTimerMutex like
+// SendPacket. Srtt is scaled by 8 and RttVar by 4, as in RFC 6298.
+//
+typedef struct {
+  UINT32  Count;
+  UINT32  Next;
+  UINT8   Acked[LINK_BITMAP_SIZE];
+  UINT8   Resent[LINK_BITMAP_SIZE];
+  UINT32  SendTick[LINK_FRAGMENT_MAX];
+  UINT32  DueTick;
+  UINT32  Srtt;
+  UINT32  RttVar;
+  UINT32  Rto;
+} LINK_SEND_WINDOW;
+
+STATIC LINK_SEND_WINDOW SendWindow = { 0, 0, { 0 }, { 0 }, { 0 }, 0, 0, 0, LINK_RTO_INITIAL };
+
+//
+// Receiver side: the fragments of the message in RecvPacket held so far.
+// RecvCount is 0 until the last fragment arrives.
+//
+STATIC UINT8    RecvBitmap[LINK_BITMAP_SIZE];
+STATIC UINT32   RecvCount;
+STATIC UINT32   RecvLength;
+STATIC UINT32   RecvSinceAck;
+
 BOOLEAN         EthernetListenRun     = FALSE;
 BOOLEAN         EthernetTimerRun      = FALSE;
 
@@ -157,6 +191,30 @@ SendOutData (
   INT8          *Buffer
   );
 
+STATIC
+VOID_P
+WindowStart (
+  VOID_P
+  );
+
+STATIC
+VOID_P
+WindowAcknowledge (
+  UINT8         *Bitmap
+  );
+
+STATIC
+VOID_P
+WindowSack (
+  UINT8         *Bitmap
+  );
+
+STATIC
+VOID_P
+WindowTimeout (
+  VOID_P
+  );
+
 VOID_P
 HandlePacket (
   IN u_char                   *UserStr,
@@ -194,6 +252,38 @@ Returns:
   return SendOutPacket (LLC_HEAD_LENGTH, Packet);
 }
 
+STATIC
+INT32
+SendOutSack (
+  UINT32      SeqId
+  )
+/*++
+
+Routine Description:
+
+  Report the fragments received of a message to target machine, only used
+  by the windowed link
+
+Arguments:
+
+  SeqId - The sequence ID
+
+Returns:
+
+  -1 Failure
+  0  Success
+
+--*/
+{
+  UINT8 Packet[LLC_HEAD_LENGTH + LINK_BITMAP_SIZE];
+
+  FillCnlLlFlag (Packet, SeqId, LINK_OPERATION_DATA_SACK, 0, FALSE);
+  memcpy (Packet + LLC_HEAD_LENGTH, RecvBitmap, LINK_BITMAP_SIZE);
+  RecvSinceAck = 0;
+
+  return SendOutPacket (sizeof (Packet), Packet);
+}
+
 STATIC
 INT32
 SendOutData (
@@ -243,6 +333,397 @@ Returns:
   return 0;
 }
 
+STATIC
+INT32
+WindowSendFragment (
+  UINT32        Index
+  )
+/*++
+
+Routine Description:
+
+  Send one fragment of the message in SendPacket, the caller holds
+  EmsTimerMutex
+
+Arguments:
+
+  Index - The index of the fragment
+
+Returns:
+
+  -1 Failure
+  0  Success
+
+--*/
+{
+  UINT8   Packet[ETH_FRAME_LEN];
+  INT32   Start;
+  INT32   Len;
+
+  Start = Index * MAX_DATA_FRAME_LEN;
+  Len   = SendPacket.Len - Start;
+  if (Len > MAX_DATA_FRAME_LEN) {
+    Len = MAX_DATA_FRAME_LEN;
+  }
+
+  FillCnlLlFlag (Packet, LastSendSeq, LINK_OPERATION_DATA, (UINT16) Start, (Start + Len < SendPacket.Len) ? TRUE : FALSE);
+  memcpy (Packet + LLC_HEAD_LENGTH, SendPacket.Buffer + Start, Len);
+  SendWindow.SendTick[Index] = GetTickCount ();
+
+  return SendOutPacket (Len + LLC_HEAD_LENGTH, Packet);
+}
+
+STATIC
+VOID_P
+WindowFill (
+  VOID_P
+  )
+/*++
+
+Routine Description:
+
+  Send the fragments never sent, as long as less than LinkWindow fragments
+  are unacknowledged
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  InFlight;
+
+  InFlight = 0;
+  for (Index = 0; Index < SendWindow.Next; Index++) {
+    if (!LINK_BITMAP_TEST (SendWindow.Acked, Index)) {
+      InFlight++;
+    }
+  }
+
+  while ((SendWindow.Next < SendWindow.Count) && (InFlight < LinkWindow)) {
+    WindowSendFragment (SendWindow.Next);
+    SendWindow.Next++;
+    InFlight++;
+  }
+}
+
+STATIC
+VOID_P
+WindowUpdateRto (
+  UINT32        Rtt
+  )
+/*++
+
+Routine Description:
+
+  Update the retransmission timeout with a round trip time sample
+
+Arguments:
+
+  Rtt - The round trip time of a fragment sent once, in milliseconds
+
+Returns:
+
+  None
+
+--*/
+{
+  INT32   Delta;
+  UINT32  Variation;
+
+  if (Rtt == 0) {
+    Rtt = 1;
+  }
+
+  if (SendWindow.Srtt == 0) {
+    SendWindow.Srtt   = Rtt << 3;
+    SendWindow.RttVar = Rtt << 1;
+  } else {
+    Delta = (INT32) Rtt - (INT32) (SendWindow.Srtt >> 3);
+    SendWindow.Srtt = (UINT32) ((INT32) SendWindow.Srtt + Delta);
+    if (Delta < 0) {
+      Delta = -Delta;
+    }
+
+    SendWindow.RttVar = (UINT32) ((INT32) SendWindow.RttVar + Delta - (INT32) (SendWindow.RttVar >> 2));
+  }
+
+  Variation       = (SendWindow.RttVar > LINK_TIMER_GRANULARITY) ? SendWindow.RttVar : LINK_TIMER_GRANULARITY;
+  SendWindow.Rto  = (SendWindow.Srtt >> 3) + Variation;
+  if (SendWindow.Rto < LINK_RTO_MIN) {
+    SendWindow.Rto = LINK_RTO_MIN;
+  } else if (SendWindow.Rto > LINK_RTO_MAX) {
+    SendWindow.Rto = LINK_RTO_MAX;
+  }
+}
+
+STATIC
+VOID_P
+WindowStart (
+  VOID_P
+  )
+/*++
+
+Routine Description:
+
+  Start sending the message in SendPacket over the windowed link, the caller
+  holds EmsTimerMutex
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  SendWindow.Count  = (SendPacket.Len + MAX_DATA_FRAME_LEN - 1) / MAX_DATA_FRAME_LEN;
+  SendWindow.Next   = 0;
+  memset (SendWindow.Acked, 0, LINK_BITMAP_SIZE);
+  memset (SendWindow.Resent, 0, LINK_BITMAP_SIZE);
+
+  WindowFill ();
+  SendWindow.DueTick = GetTickCount () + SendWindow.Rto;
+}
+
+STATIC
+VOID_P
+WindowAcknowledge (
+  UINT8         *Bitmap
+  )
+/*++
+
+Routine Description:
+
+  Mark the fragments reported by the target as received. Only the fragments
+  sent once give a round trip time sample (Karn's algorithm). The caller
+  holds EmsTimerMutex.
+
+Arguments:
+
+  Bitmap  - The fragments received by the target
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  Now;
+  UINT32  Rtt;
+  BOOLEAN Sampled;
+  BOOLEAN Progress;
+
+  Now       = GetTickCount ();
+  Rtt       = 0;
+  Sampled   = FALSE;
+  Progress  = FALSE;
+
+  for (Index = 0; Index < SendWindow.Next; Index++) {
+    if (!LINK_BITMAP_TEST (Bitmap, Index) || LINK_BITMAP_TEST (SendWindow.Acked, Index)) {
+      continue;
+    }
+
+    LINK_BITMAP_SET (SendWindow.Acked, Index);
+    Progress = TRUE;
+    if (!LINK_BITMAP_TEST (SendWindow.Resent, Index)) {
+      Rtt     = Now - SendWindow.SendTick[Index];
+      Sampled = TRUE;
+    }
+  }
+
+  if (Sampled) {
+    WindowUpdateRto (Rtt);
+  }
+
+  if (Progress) {
+    SendWindow.DueTick = Now + SendWindow.Rto;
+  }
+}
+
+STATIC
+VOID_P
+WindowSack (
+  UINT8         *Bitmap
+  )
+/*++
+
+Routine Description:
+
+  Handle a DATA_SACK of the message in SendPacket. A fragment missing below
+  one received is resent at once if it has been in flight for a round trip,
+  then the window slides. The caller holds EmsTimerMutex.
+
+Arguments:
+
+  Bitmap  - The fragments received by the target
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  Highest;
+  UINT32  Now;
+
+  WindowAcknowledge (Bitmap);
+
+  Highest = 0;
+  for (Index = 0; Index < SendWindow.Next; Index++) {
+    if (LINK_BITMAP_TEST (SendWindow.Acked, Index)) {
+      Highest = Index;
+    }
+  }
+
+  Now = GetTickCount ();
+  for (Index = 0; Index < Highest; Index++) {
+    if (LINK_BITMAP_TEST (SendWindow.Acked, Index)) {
+      continue;
+    }
+
+    if (Now - SendWindow.SendTick[Index] >= (SendWindow.Srtt >> 3)) {
+      LINK_BITMAP_SET (SendWindow.Resent, Index);
+      WindowSendFragment (Index);
+    }
+  }
+
+  WindowFill ();
+}
+
+STATIC
+VOID_P
+WindowTimeout (
+  VOID_P
+  )
+/*++
+
+Routine Description:
+
+  The retransmission timer of the windowed link expired: back off and resend
+  the fragments in flight. If the target holds all of them the DATA_ACK was
+  lost, the last fragment is resent to have it repeated. The caller holds
+  EmsTimerMutex.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  BOOLEAN Resent;
+
+  SendWindow.Rto = (SendWindow.Rto * 2 > LINK_RTO_MAX) ? LINK_RTO_MAX : SendWindow.Rto * 2;
+
+  Resent = FALSE;
+  for (Index = 0; Index < SendWindow.Next; Index++) {
+    if (!LINK_BITMAP_TEST (SendWindow.Acked, Index)) {
+      LINK_BITMAP_SET (SendWindow.Resent, Index);
+      WindowSendFragment (Index);
+      Resent = TRUE;
+    }
+  }
+
+  if (!Resent && (SendWindow.Count > 0)) {
+    LINK_BITMAP_SET (SendWindow.Resent, SendWindow.Count - 1);
+    WindowSendFragment (SendWindow.Count - 1);
+  }
+
+  SendWindow.DueTick = GetTickCount () + SendWindow.Rto;
+}
+
+STATIC
+VOID_P
+FillCapability (
+  INT8          *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Fill the windowed link capability of EMS
+
+Arguments:
+
+  Buffer  - Return the capability
+
+Returns:
+
+  None
+
+--*/
+{
+  EAS_LINK_CAPABILITY Capability;
+
+  Capability.Signature  = htonl (LINK_CAPABILITY_SIGNATURE);
+  Capability.Version    = LINK_CAPABILITY_VERSION;
+  Capability.Window     = EMS_LINK_WINDOW;
+  Capability.MaxMessage = htons (MAX_RIVL_MESSAGE_LEN);
+
+  memcpy (Buffer, &Capability, sizeof (Capability));
+}
+
+STATIC
+VOID_P
+ParseCapability (
+  INT32         NRead,
+  INT8          *Buffer,
+  TARGET_T      *Target
+  )
+/*++
+
+Routine Description:
+
+  Record the windowed link offered in a PROBE_ACK. An agent that does not
+  know the windowed link sends no capability.
+
+Arguments:
+
+  NRead   - The size of the packet
+  Buffer  - The packet
+  Target  - The target which sent the PROBE_ACK
+
+Returns:
+
+  None
+
+--*/
+{
+  EAS_LINK_CAPABILITY Capability;
+
+  Target->Window      = 0;
+  Target->MaxMessage  = 0;
+
+  if (NRead < DATA_POS + (INT32) sizeof (Capability)) {
+    return ;
+  }
+
+  memcpy (&Capability, Buffer + DATA_POS, sizeof (Capability));
+  if ((ntohl (Capability.Signature) != LINK_CAPABILITY_SIGNATURE) ||
+      (Capability.Version < LINK_CAPABILITY_VERSION) ||
+      (Capability.Window == 0) ||
+      (ntohs (Capability.MaxMessage) == 0)) {
+    return ;
+  }
+
+  Target->Window      = (Capability.Window < EMS_LINK_WINDOW) ? Capability.Window : EMS_LINK_WINDOW;
+  Target->MaxMessage  = ntohs (Capability.MaxMessage);
+}
+
 STATIC
 INT32
 RecycleSendPacket (
@@ -397,7 +878,8 @@ ReassemblePacket (
 
 Routine Description:
 
-  Reassemble the packet
+  Reassemble the packet. The fragments are placed by their offset, so they
+  may arrive in any order.
 
 Arguments:
 
@@ -410,52 +892,66 @@ Arguments:
 Returns:
 
   -1 Failure
-  0  Success
+  0  More fragments are needed
+  1  The message is complete
 
 --*/
 {
-  //
-  // check frag_SeqId
-  //
-  if (FragSeq == 0) {
-    FragSeq = SeqId;
-  } else {
-    if (FragSeq != SeqId) {
-      RecordMessage (
-        EMS_VERBOSE_LEVEL_DEFAULT,
-        "EMS: Receive an fragment with ErrorExit SeqId.  Expected Id =%x, Actual Id=%x \n",
-        FragSeq,
-        SeqId
-        );
-      return -1;
-    }
-  }
+  INT32   Len;
+  UINT32  Index;
 
   if (NULL == RecvPacket.Buffer) {
     return -1;
   }
 
-  if (Offset == 0) {
-    RecvPacket.Len = 0;
-  }
   //
-  // re-assemble all packets, assume no out-of-sequence fragment
+  // A message is cut at MAX_DATA_FRAME_LEN, only its last fragment is shorter
   //
-  if (RecvPacket.Len != Offset) {
-    //
-    // out-of-sequence packet incoming
-    //
+  Len = NRead - DATA_POS;
+  if ((Offset % MAX_DATA_FRAME_LEN != 0) ||
+      (More && (Len != MAX_DATA_FRAME_LEN)) ||
+      (Offset + Len > MAX_RIVL_MESSAGE_LEN)) {
     RecordMessage (
       EMS_VERBOSE_LEVEL_DEFAULT,
-      "EMS: Receive an out-of-sequence Packet"
+      "EMS: Receive a malformed fragment, Offset=%d Length=%d",
+      Offset,
+      Len
       );
     return -1;
   }
 
-  memcpy (RecvPacket.Buffer + RecvPacket.Len, Buffer + DATA_POS, (NRead - DATA_POS));
-  RecvPacket.Len = RecvPacket.Len + (NRead - DATA_POS);
+  //
+  // The fragment of a new message
+  //
+  if ((FragSeq == 0) || (FragSeq != (UINT32) SeqId)) {
+    FragSeq       = SeqId;
+    RecvCount     = 0;
+    RecvLength    = 0;
+    RecvSinceAck  = 0;
+    memset (RecvBitmap, 0, LINK_BITMAP_SIZE);
+  }
+
+  Index = Offset / MAX_DATA_FRAME_LEN;
+  memcpy (RecvPacket.Buffer + Offset, Buffer + DATA_POS, Len);
+  LINK_BITMAP_SET (RecvBitmap, Index);
 
-  return 0;
+  if (!More) {
+    RecvCount   = Index + 1;
+    RecvLength  = Offset + Len;
+  }
+
+  if (RecvCount == 0) {
+    return 0;
+  }
+
+  for (Index = 0; Index < RecvCount; Index++) {
+    if (!LINK_BITMAP_TEST (RecvBitmap, Index)) {
+      return 0;
+    }
+  }
+
+  RecvPacket.Len = RecvLength;
+  return 1;
 }
 
 STATIC
@@ -660,7 +1156,12 @@ Returns:
   GetAdaptersInfo (PInfo, &UlSize);
   PInfoTem = PInfo = (PIP_ADAPTER_INFO) malloc (UlSize * sizeof (INT8));
 
-  GetAdaptersInfo (PInfo, &UlSize);
+  if ((PInfo == NULL) || (GetAdaptersInfo (PInfo, &UlSize) != ERROR_SUCCESS)) {
+    //
+    // No adapter, or it is added between the two calls
+    //
+    PInfo = NULL;
+  }
   while (PInfo) {
     if (PInfo->Index != EmsIfIndex) {
       PInfo = PInfo->Next;
@@ -713,7 +1214,7 @@ SetEasMac (
 
 Routine Description:
 
-  Set the EAS MAC address
+  Set the EAS MAC address, and select the link offered by that target
 
 Arguments:
 
@@ -726,12 +1227,33 @@ Returns:
 
 --*/
 {
+  TARGET_T  *Target;
+
   if (!Mac) {
     return -1;
   }
 
   memcpy (EasMacAddr, Mac, 6);
 
+  //
+  // Use the windowed link if the target offered it in the PROBE_ACK, and
+  // learn the round trip time of the new target from scratch
+  //
+  Target = RpcTargetFindByMac (Mac);
+  if ((Target != NULL) && (Target->Window != 0)) {
+    LinkWindow      = Target->Window;
+    LinkMaxMessage  = Target->MaxMessage;
+  } else {
+    LinkWindow      = 0;
+    LinkMaxMessage  = 0;
+  }
+
+  WaitForSingleObject (EmsTimerMutex, INFINITE);
+  SendWindow.Srtt   = 0;
+  SendWindow.RttVar = 0;
+  SendWindow.Rto    = LINK_RTO_INITIAL;
+  ReleaseMutex (EmsTimerMutex);
+
   return 0;
 }
 
@@ -754,10 +1276,21 @@ Arguments:
 
 Returns:
 
-  0 Success
+  -1 The message is too long
+  0  Success
 
 --*/
 {
+  if ((DataLen > MAX_RIVL_MESSAGE_LEN) ||
+      ((LinkWindow != 0) && ((UINT32) DataLen > LinkMaxMessage))) {
+    RecordMessage (
+      EMS_VERBOSE_LEVEL_DEFAULT,
+      "EMS:  Message of %d bytes is too long for the agent",
+      DataLen
+      );
+    return -1;
+  }
+
   LastSendSeq++;
   WaitForSingleObject (EmsTimerMutex, INFINITE);
 
@@ -767,7 +1300,11 @@ Returns:
 
   SendPacket.Len = DataLen;
   memcpy (SendPacket.Buffer, Buffer, DataLen);
-  SendOutData (SendPacket.Len, SendPacket.Buffer);
+  if (LinkWindow != 0) {
+    WindowStart ();
+  } else {
+    SendOutData (SendPacket.Len, SendPacket.Buffer);
+  }
   CurState = RIVL_SENDING;
 
   ReleaseMutex (EmsTimerMutex);
@@ -855,7 +1392,7 @@ Returns:
 
 --*/
 {
-  UINT8       Packet[LLC_HEAD_LENGTH];
+  UINT8       Packet[LLC_HEAD_LENGTH + sizeof (EAS_LINK_CAPABILITY)];
   UINT32      Ret;
   __time64_t  Time;
   __time64_t  Time1;
@@ -868,14 +1405,15 @@ Returns:
   RpcTargetRemoveAll ();
 
   //
-  // pack a probe packet
+  // pack a probe packet, offering the windowed link
   //
   FillCnlLlFlag (Packet, 0, LINK_OPERATION_PROBE, 0, FALSE);
+  FillCapability (Packet + LLC_HEAD_LENGTH);
 
   ProbAckReceived = FALSE;
 
   Tcl_Sleep (2000);
-  Ret = SendOutPacket (LLC_HEAD_LENGTH, Packet);
+  Ret = SendOutPacket (sizeof (Packet), Packet);
 
   _time64 (&Time);
   Time += 3;
@@ -919,7 +1457,11 @@ Returns:
     //
     // if there's packet needed to be resent
     //
-    if (SendPacket.Len > 0) {
+    if ((SendPacket.Len > 0) && (LinkWindow != 0)) {
+      if ((INT32) (GetTickCount () - SendWindow.DueTick) >= 0) {
+        WindowTimeout ();
+      }
+    } else if (SendPacket.Len > 0) {
       _time64 (&NowTime);
       if (DueTime < NowTime) {
         //
@@ -931,7 +1473,7 @@ Returns:
 
     ReleaseMutex (EmsTimerMutex);
     //Tcl_Sleep (1);
-    Tcl_Sleep (150);
+    Tcl_Sleep ((LinkWindow != 0) ? LINK_TIMER_GRANULARITY : 150);
   }
 
   return 0;
@@ -960,11 +1502,12 @@ Returns:
 --*/
 {
   time_t              Tick;
-  struct bpf_program  Bp;
   INT8                TempFilter[100];
   INT32               Index;
-  pcap_t              *AdHandle;
-  INT8                ErrBuf[PCAP_ERRBUF_SIZE];
+  ENGINE_CONSUMER     *Consumer;
+  ENGINE_PACKET       Packet;
+  struct pcap_pkthdr  PktHdr;
+  UINT8               Frame[ETH_FRAME_LEN];
 
   Index = 0;
   //
@@ -993,7 +1536,7 @@ Returns:
   }
 
   SendPacket.Len    = 0;
-  SendPacket.Buffer = malloc (ETH_FRAME_LEN);
+  SendPacket.Buffer = malloc (MAX_RIVL_MESSAGE_LEN);
   if (SendPacket.Buffer == NULL) {
     free (RecvPacket.Buffer);
     RecvPacket.Buffer = NULL;
@@ -1011,25 +1554,6 @@ Returns:
   //
   CurState = RIVL_LISTENING;
 
-  /* Open the device */
-  if ((
-        AdHandle = pcap_open_live (
-                    EmsInterface,         // name of the device
-                    65536,                // portion of the packet to capture
-                    0,                    // promiscuous mode
-                    1,                    // read timeout
-                    ErrBuf              // error buffer
-                    )) == NULL) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_DEFAULT,
-      "EMS:  Fail to open adapter %s - %a:%d",
-      EmsInterface,
-      __FILE__,
-      __LINE__
-      );
-    return -1;
-  }
-
   sprintf (
     TempFilter,
     "ether proto 0x1234 and ether dst %02x:%02x:%02x:%02x:%02x:%02x",
@@ -1040,26 +1564,21 @@ Returns:
     EmsMacAddr[4],
     EmsMacAddr[5]
     );
-  if (-1 == pcap_compile (AdHandle, &Bp, TempFilter, 0, 0xFFFFFF)) {
-    RecordMessage (
-      EMS_VERBOSE_LEVEL_DEFAULT,
-      "EMS:  Fail to complile the Packet Filter %s - %a:%d",
-      TempFilter,
-      __FILE__,
-      __LINE__
-      );
-    goto ErrorExit;
-  }
-
-  if (-1 == pcap_setfilter (AdHandle, &Bp)) {
+  //
+  // The capture engine filters by the destination MAC, so the device does
+  // not need to be opened in non-promiscuous mode
+  //
+  Consumer = EmsEngineOpen (EmsInterface, "Rpc", TempFilter);
+  if (NULL == Consumer) {
     RecordMessage (
       EMS_VERBOSE_LEVEL_DEFAULT,
-      "EMS:  Fail to set Packet Filter %s - %a:%d",
+      "EMS:  Fail to open adapter %s with Packet Filter %s - %a:%d",
+      EmsInterface,
       TempFilter,
       __FILE__,
       __LINE__
       );
-    goto ErrorExit;
+    return -1;
   }
 
   EthernetListenRun = TRUE;
@@ -1067,15 +1586,51 @@ Returns:
   /* start the capture */
   while (EthernetListenRun) {
     EthernetListenRunning = TRUE;
-    pcap_dispatch (AdHandle, 1, HandlePacket, NULL);
-    Tcl_Sleep (1);
+    if (!EmsEngineReceive (Consumer, ENGINE_READ_TIMEOUT, &Packet)) {
+      //
+      // Reopen the consumer on a new engine if the capture failed
+      //
+      if (EmsEngineFailed (Consumer)) {
+        EmsEngineClose (Consumer);
+        Tcl_Sleep (ENGINE_READ_TIMEOUT);
+        Consumer = EmsEngineOpen (EmsInterface, "Rpc", TempFilter);
+        if (NULL == Consumer) {
+          break;
+        }
+      }
+
+      continue;
+    }
+
+    if (Packet.CapLen > ETH_FRAME_LEN) {
+      EmsEngineRelease (Consumer, &Packet);
+      continue;
+    }
+
+    //
+    // Copy the packet out of the ring before handling it, a packet that is
+    // overwritten during the copy is lost
+    //
+    memcpy (Frame, Packet.Data, Packet.CapLen);
+    if (!EmsEngineRelease (Consumer, &Packet)) {
+      RecordMessage (
+        EMS_VERBOSE_LEVEL_DEFAULT,
+        "EMS:  Lost a Packet from agent - %a:%d",
+        __FILE__,
+        __LINE__
+        );
+      continue;
+    }
+
+    memcpy (&PktHdr.ts, &Packet.Time, sizeof (struct timeval));
+    PktHdr.caplen = Packet.CapLen;
+    PktHdr.len    = Packet.Len;
+    HandlePacket (NULL, &PktHdr, Frame);
   }
 
-  pcap_close (AdHandle);
+  EmsEngineClose (Consumer);
   EthernetListenRunning = FALSE;
   return 0;
-ErrorExit:
-  return -1;
 }
 
 VOID_P
@@ -1156,7 +1711,7 @@ Returns:
 {
 
   INT32   NRead;
-  INT8    Buffer[ETH_FRAME_LEN];
+  INT8    *Buffer;
   UINT16  ProtId;
   UINT8   OpCode;
   UINT32  SeqId;
@@ -1164,11 +1719,14 @@ Returns:
   UINT16  Offset;
   INT8    SrcMac[6];
   INT8    DstMac[6];
+  INT32   Ret;
+  UINT8   Bitmap[LINK_BITMAP_SIZE];
+  TARGET_T *Target;
 
   WaitForSingleObject (EmsListenMutex, INFINITE);
 
-  memcpy (Buffer, Packet, PktHdr->len);
-  NRead = PktHdr->len;
+  Buffer  = (INT8 *) Packet;
+  NRead   = PktHdr->caplen;
 
   if (NRead < LLC_HEAD_LENGTH + ETHER_HEAD_LENGTH) {
     RecordMessage (
@@ -1187,28 +1745,20 @@ Returns:
   if (AnalyzeRivlHeader (NRead, Buffer, &OpCode, &SeqId, &More, &Offset) != 0) {
     goto Done;
   }
-  //
-  // re-assemble packet
-  //
-  if (ReassemblePacket (NRead, Buffer, More, SeqId, Offset) == -1) {
-    RecvPacket.Len = 0;
-    goto Done;
-  }
-
-  if (More) {
-    //
-    // need fragment
-    //
-    goto Done1;
-  }
 
   switch (OpCode) {
   //
   //   1. Probe Ack  ==> collect active target
   //
   case LINK_OPERATION_PROBE_ACK:
-    if (RpcTargetFindByMac (SrcMac) == NULL) {
+    Target = RpcTargetFindByMac (SrcMac);
+    if (Target == NULL) {
       RpcTargetAddByMac (SrcMac);
+      Target = RpcTargetFindByMac (SrcMac);
+    }
+
+    if (Target != NULL) {
+      ParseCapability (NRead, Buffer, Target);
     }
 
     ProbAckReceived = TRUE;
@@ -1220,6 +1770,18 @@ Returns:
     switch (CurState) {
     case RIVL_SENDING:
       if (SeqId == LastSendSeq) {
+        if (LinkWindow != 0) {
+          //
+          // The whole message is received, take the last round trip time
+          //
+          memset (Bitmap, 0xFF, LINK_BITMAP_SIZE);
+          WaitForSingleObject (EmsTimerMutex, INFINITE);
+          if (SendPacket.Len > 0) {
+            WindowAcknowledge (Bitmap);
+          }
+          ReleaseMutex (EmsTimerMutex);
+        }
+
         RecycleSendPacket ();
         CurState = RIVL_LISTENING;
       } else {
@@ -1260,6 +1822,22 @@ Returns:
     }
     break;
 
+  case LINK_OPERATION_DATA_SACK:
+    //
+    // Only the windowed link reports part of a message
+    //
+    if ((CurState != RIVL_SENDING) || (SeqId != LastSendSeq) ||
+        (LinkWindow == 0) || (NRead < DATA_POS + LINK_BITMAP_SIZE)) {
+      break;
+    }
+
+    WaitForSingleObject (EmsTimerMutex, INFINITE);
+    if (SendPacket.Len > 0) {
+      WindowSack (Buffer + DATA_POS);
+    }
+    ReleaseMutex (EmsTimerMutex);
+    break;
+
   case LINK_OPERATION_DATA:
     //
     // In EMS, Data must be FINISH message
@@ -1284,15 +1862,39 @@ Returns:
       }
 	  else if ((LastRecvSeq < SeqId) || (LastRecvSeq == 0))
 	  {
-        SendOutAck (SeqId);
-        if (ProcessFin () == 0)
-		{
-          RecycleSendPacket ();
-          LastRecvSeq = FragSeq;
-          CurState    = RIVL_LISTENING;
+        //
+        // re-assemble packet
+        //
+        Ret = ReassemblePacket (NRead, Buffer, More, SeqId, Offset);
+        if (Ret < 0) {
+          break;
         }
-		else
-		{
+
+        if (Ret == 0) {
+          //
+          // need fragment. The windowed link reports a hole, the end of the
+          // message, and every half window of fragments.
+          //
+          RecvSinceAck++;
+          if ((LinkWindow != 0) &&
+              (!More ||
+               ((Offset > 0) && !LINK_BITMAP_TEST (RecvBitmap, Offset / MAX_DATA_FRAME_LEN - 1)) ||
+               (RecvSinceAck * 2 >= LinkWindow))) {
+            SendOutSack (SeqId);
+          }
+          break;
+        }
+
+        SendOutAck (SeqId);
+
+        //
+        // Settle the link before the message is handed over, the reader may
+        // send the next request at once
+        //
+        RecycleSendPacket ();
+        LastRecvSeq = FragSeq;
+        CurState    = RIVL_LISTENING;
+        if (ProcessFin () != 0) {
           RecordMessage (
             EMS_VERBOSE_LEVEL_DEFAULT,
             "EMS:  Unkown error - %a:%d",
@@ -1300,6 +1902,8 @@ Returns:
             __LINE__
             );
         }
+
+        FragSeq = 0;
       }
       break;
 
@@ -1319,9 +1923,6 @@ Returns:
   }
 
 Done:
-  RecvPacket.Len  = 0;
-  FragSeq         = 0;
-Done1:
   ReleaseMutex (EmsListenMutex);
   return ;
 }
@@ -1348,4 +1949,5 @@ Returns:
 {
   LastRecvSeq = 0;
   FragSeq     = 0;
+  RecvCount   = 0;
 }
@@ -66,6 +66,36 @@ STATIC INT32        Link1 = LINK_NONE;
 #define SEND_QUE_ID 111
 #define RECV_QUE_ID 110
 
+//
+// A RIVL batch carries its commands separated by RPC_BATCH_DELIM, and the
+// agent answers with their acks separated the same way. Only the commands
+// whose ack carries nothing but the status are queued.
+//
+#define RPC_BATCH_CMD       "RIVL_BATCH "
+#define RPC_BATCH_DELIM     " _NEXT_ "
+#define RPC_BATCH_ACK       " _ACK_ P "
+#define RPC_BATCH_MAX_CMD   32
+#define RPC_BATCH_MAX_LEN   (MAX_DATA_LEN - sizeof (RIVL_DATA_FLAG) - 1)
+
+STATIC CONST INT8   *BatchCmds[] = {
+  "RIVL_DEFTYPE",
+  "RIVL_DELTYPE",
+  "RIVL_CRTVAR",
+  "RIVL_SETVAR",
+  "RIVL_DELVAR",
+  NULL
+};
+
+STATIC UINT32       BatchDepth      = 0;
+STATIC BOOLEAN      BatchSupported  = TRUE;
+STATIC BOOLEAN      BatchAckPending = FALSE;
+STATIC UINT32       BatchCount      = 0;
+STATIC INT32        BatchLen        = 0;
+STATIC INT8         BatchMessage[MAX_DATA_LEN];
+STATIC INT8         BatchAck[MAX_DATA_LEN];
+STATIC UINT32       BatchFailed     = 0;
+STATIC INT8         BatchError[MAX_ERRBUFF_LEN];
+
 #define FILTER_SPACE(Pointer) \
   { \
     while (*Pointer == ' ') \
@@ -129,6 +159,27 @@ CheckDataId (
   INT32                                     ExpectId
   );
 
+STATIC
+INT32
+RpcSendData (
+  INT32                             Length,
+  INT8                              *Buff
+  );
+
+STATIC
+INT32
+RpcRecvData (
+  INT32                             Timeout,
+  UINT32                            Length,
+  INT8                              *Message
+  );
+
+STATIC
+VOID
+RpcBatchFlush (
+  VOID
+  );
+
 STATIC
 VOID
 RpcTclMutexInit(
@@ -779,6 +830,38 @@ Returns:
   return 0;
 }
 
+STATIC
+BOOLEAN
+RpcBatchCanDefer (
+  IN INT8                 *Buff
+  )
+/*++
+
+Routine Description:
+
+  Check whether the ack of a rpc message carries nothing but the status
+
+Arguments:
+
+  Buff    - The data of rpc message
+
+Returns:
+
+  TRUE or FALSE
+
+--*/
+{
+  UINT32  Index;
+
+  for (Index = 0; BatchCmds[Index] != NULL; Index++) {
+    if (strncmp (Buff, BatchCmds[Index], strlen (BatchCmds[Index])) == 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 INT32
 RpcSendMessage (
   INT32       Length,
@@ -788,7 +871,74 @@ RpcSendMessage (
 
 Routine Description:
 
-  Send a rpc message
+  Send a rpc message. In a batch, the message is queued if its ack carries
+  nothing but the status, otherwise the queued messages are sent first.
+
+Arguments:
+
+  Length  - The size of rpc message
+  Buff    - The data of rpc message
+
+Returns:
+
+  If succeed return 0, else return -1
+
+--*/
+{
+  INT32   DelimLen;
+
+  if (BatchDepth != 0) {
+    DelimLen = (BatchCount == 0) ? strlen (RPC_BATCH_CMD) : strlen (RPC_BATCH_DELIM);
+    //
+    // The messages are queued for an agent without the batch too, the
+    // flush sends them one by one and reports their failures the same way
+    //
+    if (RpcBatchCanDefer (Buff)) {
+      if ((BatchCount == RPC_BATCH_MAX_CMD) ||
+          (BatchLen + DelimLen + Length > (INT32) RPC_BATCH_MAX_LEN)) {
+        RpcBatchFlush ();
+        DelimLen = strlen (RPC_BATCH_CMD);
+      }
+
+      if (DelimLen + Length <= (INT32) RPC_BATCH_MAX_LEN) {
+        if (BatchCount == 0) {
+          strcpy (BatchMessage, RPC_BATCH_CMD);
+          BatchLen = 0;
+        } else {
+          strcpy (BatchMessage + BatchLen, RPC_BATCH_DELIM);
+        }
+
+        BatchLen += DelimLen;
+        memcpy (BatchMessage + BatchLen, Buff, Length);
+        BatchLen += Length;
+        BatchMessage[BatchLen] = '\0';
+        BatchCount++;
+
+        //
+        // The caller gets a passed ack, the real one is checked at flush
+        //
+        BatchAckPending = TRUE;
+        return 0;
+      }
+    }
+
+    RpcBatchFlush ();
+  }
+
+  return RpcSendData (Length, Buff);
+}
+
+STATIC
+INT32
+RpcSendData (
+  INT32       Length,
+  INT8        *Buff
+  )
+/*++
+
+Routine Description:
+
+  Send a rpc message to the agent
 
 Arguments:
 
@@ -917,38 +1067,71 @@ Returns:
 
 --*/
 {
-  INT32            Run;
+  if (BatchAckPending) {
+    BatchAckPending = FALSE;
+    strcpy (Message, RPC_BATCH_ACK);
+    return strlen (Message);
+  }
+
+  return RpcRecvData (Timeout, Length, Message);
+}
+
+STATIC
+INT32
+RpcRecvData (
+  INT32     Timeout,
+  UINT32     Length,
+  INT8      *Message
+  )
+/*++
+
+Routine Description:
+
+  Receive the rpc message from the agent
+
+Arguments:
+
+  Timeout - The maxinum time to wait
+  Length  - The length of message received
+  Message - The data of message received
+
+Returns:
+
+  If succeed return 0, else return -1
+
+--*/
+{
   INT32            retlen;
-  INT32            Count;
   INT32            DataId;
+  UINT32           Start;
+  UINT32           Elapsed;
+  UINT32           Wait;
 
   //
   // Get current time, and Compute timeout timestamp
   // If timeout == -1, means blocking
   //
-  if (-1 != Timeout) {
-    Count = 0;
-  }
+  Start = GetTickCount ();
+
   //
   // I can get the operation result, and out parameter
   //
-  Run = 1;
-  while (Run)
-  {
-    //
-    // If timeout, no longer recv
-    //
-    if (-1 != Timeout) {
-      if (Count >= Timeout * 1000) {
-        Run = 0;
+  for (;;) {
+    if (-1 == Timeout) {
+      Wait = WAIT_FOREVER;
+    } else {
+      Elapsed = GetTickCount () - Start;
+      if (Elapsed >= (UINT32) Timeout * 1000) {
+        break;
       }
-	  Count++;
+
+      Wait = (UINT32) Timeout * 1000 - Elapsed;
     }
 
     //
-    // If get message, no longer recv
+    // Wait for a message, until timeout
     //
-    retlen = EmsMsgQReceive (DataMessage, Length);
+    retlen = EmsMsgQReceive (DataMessage, Length, Wait);
     if (retlen > 0)
 	{
       if ((DataId = CheckDataId (DataMessage, LastDataId)) != 0)
@@ -963,8 +1146,6 @@ Returns:
       RecordMessage (EMS_VERBOSE_LEVEL_NOISY, "EMS: recv \"%a\"", Message);
       return retlen;
     }
-
-    Tcl_Sleep (1);
   }
 
   return -1;
@@ -1088,3 +1269,239 @@ Returns:
 
   return TRUE;
 }
+
+STATIC
+INT8 *
+RpcBatchSplit (
+  IN INT8                 *Str
+  )
+/*++
+
+Routine Description:
+
+  Cut a batch string at its first delimiter
+
+Arguments:
+
+  Str     - The batch string
+
+Returns:
+
+  The string after the delimiter, or NULL if there is none
+
+--*/
+{
+  INT8  *Delim;
+
+  Delim = strstr (Str, RPC_BATCH_DELIM);
+  if (Delim == NULL) {
+    return NULL;
+  }
+
+  *Delim = '\0';
+  return Delim + strlen (RPC_BATCH_DELIM);
+}
+
+STATIC
+VOID
+RpcBatchRecordFail (
+  IN INT8                 *Cmd,
+  IN INT8                 *Log
+  )
+/*++
+
+Routine Description:
+
+  Record a batched command which failed on the agent
+
+Arguments:
+
+  Cmd     - The command
+  Log     - The log in its ack, or NULL
+
+Returns:
+
+  None
+
+--*/
+{
+  if (Log == NULL) {
+    Log = "";
+  }
+
+  RecordMessage (
+    EMS_VERBOSE_LEVEL_DEFAULT,
+    "EMS: Batched \"%a\" failed %a\n",
+    Cmd,
+    Log
+    );
+
+  if (BatchFailed++ == 0) {
+    _snprintf (BatchError, sizeof (BatchError) - 1, "\"%s\" failed %s", Cmd, Log);
+    BatchError[sizeof (BatchError) - 1] = '\0';
+  }
+}
+
+STATIC
+VOID
+RpcBatchFlush (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Send the queued commands in one message and check their acks. If the
+  agent does not know the batch, the commands are sent one by one.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  INT8    *Cmd;
+  INT8    *NextCmd;
+  INT8    *Ack;
+  INT8    *NextAck;
+  INT32   Length;
+  UINT32  Count;
+  UINT32  Index;
+  BOOLEAN Pass;
+  INT8    *Out;
+  INT8    *Log;
+
+  if (BatchCount == 0) {
+    return;
+  }
+
+  Count       = BatchCount;
+  BatchCount  = 0;
+  Cmd         = BatchMessage + strlen (RPC_BATCH_CMD);
+
+  if ((Count > 1) && BatchSupported) {
+    if (RpcSendData (BatchLen, BatchMessage) != 0) {
+      for (Index = 0; Index < Count; Index++) {
+        NextCmd = RpcBatchSplit (Cmd);
+        RpcBatchRecordFail (Cmd, "to be sent");
+        Cmd = NextCmd;
+      }
+
+      return;
+    }
+
+    BatchAck[0] = '\0';
+    Length      = RpcRecvData (-1, MAX_DATA_LEN, BatchAck);
+
+    //
+    // An agent without the batch fails it with a single ack
+    //
+    if ((Length > 0) && (strstr (BatchAck, RPC_BATCH_DELIM) != NULL)) {
+      RecordMessage (
+        EMS_VERBOSE_LEVEL_NOISY,
+        "EMS: Sent %d commands in one batch\n",
+        Count
+        );
+
+      Ack = BatchAck;
+      for (Index = 0; Index < Count; Index++) {
+        NextCmd = RpcBatchSplit (Cmd);
+        NextAck = (Ack != NULL) ? RpcBatchSplit (Ack) : NULL;
+        if ((Ack == NULL) || !ParseAckMessage (strlen (Ack), Ack, &Pass, &Out, &Log)) {
+          RpcBatchRecordFail (Cmd, "without ack");
+        } else if (!Pass) {
+          RpcBatchRecordFail (Cmd, Log);
+        }
+
+        Cmd = NextCmd;
+        Ack = NextAck;
+      }
+
+      return;
+    }
+
+    RecordMessage (
+      EMS_VERBOSE_LEVEL_DEFAULT,
+      "EMS: The agent does not support RIVL_BATCH, commands are sent one by one\n"
+      );
+    BatchSupported = FALSE;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    NextCmd = RpcBatchSplit (Cmd);
+    RpcSendData (strlen (Cmd), Cmd);
+    BatchAck[0] = '\0';
+    Log         = NULL;
+    Length      = RpcRecvData (-1, MAX_DATA_LEN, BatchAck);
+    if (!ParseAckMessage (Length, BatchAck, &Pass, &Out, &Log) || !Pass) {
+      RpcBatchRecordFail (Cmd, Log);
+    }
+
+    Cmd = NextCmd;
+  }
+}
+
+VOID
+RpcBatchBegin (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Begin a batch of rpc messages, batches may be nested
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  BatchDepth++;
+}
+
+UINT32
+RpcBatchEnd (
+  OUT INT8        *ErrorBuff
+  )
+/*++
+
+Routine Description:
+
+  End a batch of rpc messages. The outermost batch sends the queued
+  messages, and reports the failed ones of the whole batch.
+
+Arguments:
+
+  ErrorBuff - Return the first failure, MAX_ERRBUFF_LEN at least
+
+Returns:
+
+  The number of the failed messages
+
+--*/
+{
+  UINT32  Failed;
+
+  ErrorBuff[0] = '\0';
+  if ((BatchDepth == 0) || (--BatchDepth != 0)) {
+    return 0;
+  }
+
+  RpcBatchFlush ();
+
+  Failed        = BatchFailed;
+  BatchFailed   = 0;
+  strcpy (ErrorBuff, BatchError);
+  BatchError[0] = '\0';
+
+  return Failed;
+}
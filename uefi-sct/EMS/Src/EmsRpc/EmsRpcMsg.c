@@ -27,13 +27,21 @@ Abstract:
 #include "stdlib.h"
 #include "memory.h"
 
+#include "EmsPlatform.h"
 #include "EmsUtilityString.h"
 #include "EmsPktMain.h"
 #include "EmsRpcMsg.h"
 #include "EmsLogUtility.h"
 
-MSG_QUEUE *EmsMsgQueue = NULL;
-HANDLE    EmsMsgMutex;
+//
+// The messages are appended at the tail and received from the head. The
+// receivers wait on EmsMsgNotEmpty instead of polling the queue.
+//
+STATIC MSG_QUEUE      *EmsMsgHead = NULL;
+STATIC MSG_QUEUE      *EmsMsgTail = NULL;
+STATIC EMS_LOCK       EmsMsgLock;
+STATIC EMS_CONDITION  EmsMsgNotEmpty;
+STATIC BOOLEAN        EmsMsgCreated = FALSE;
 
 INT32
 EmsMsgQCreate (
@@ -43,7 +51,8 @@ EmsMsgQCreate (
 
 Routine Description:
 
-  create an EMS message queue
+  create an EMS message queue. The queue is created once, the later calls
+  return the same queue.
 
 Arguments:
 
@@ -55,7 +64,12 @@ Returns:
 
 --*/
 {
-  EmsMsgMutex = CreateMutex (NULL, FALSE, NULL);
+  if (!EmsMsgCreated) {
+    EmsLockInit (&EmsMsgLock);
+    EmsConditionInit (&EmsMsgNotEmpty);
+    EmsMsgCreated = TRUE;
+  }
+
   return 1;
 }
 
@@ -119,7 +133,7 @@ EmsMsgQSend (
 
 Routine Description:
 
-  sent a message to an EMS message queue
+  sent a message to an EMS message queue, and wake up a receiver
 
 Arguments:
 
@@ -134,21 +148,23 @@ Returns:
 --*/
 {
   MSG_QUEUE *PacketPointer;
-  MSG_QUEUE *PacketPointer1;
-  INT32     Ret;
-  WaitForSingleObject (EmsMsgMutex, INFINITE);
 
+  if (!EmsMsgCreated) {
+    return -1;
+  }
+
+  //
+  // Allocate the message out of the lock
+  //
   PacketPointer = (MSG_QUEUE *) malloc (sizeof (MSG_QUEUE));
   if (NULL == PacketPointer) {
-    Ret = -1;
-    goto Done;
+    return -1;
   }
 
   PacketPointer->Message = (INT8 *) malloc (Length);
   if (NULL == PacketPointer->Message) {
     free (PacketPointer);
-    Ret = -1;
-    goto Done;
+    return -1;
   }
 
   memcpy (PacketPointer->Message, Buf, Length);
@@ -157,37 +173,39 @@ Returns:
   PacketPointer->Priority = Priority;
   PacketPointer->Next     = NULL;
 
-  if (EmsMsgQueue == NULL) {
-    EmsMsgQueue = PacketPointer;
-    Ret         = 0;
-    goto Done;
+  EmsLockAcquire (&EmsMsgLock);
+
+  if (EmsMsgTail == NULL) {
+    EmsMsgHead = PacketPointer;
+  } else {
+    EmsMsgTail->Next = PacketPointer;
   }
 
-  for (PacketPointer1 = EmsMsgQueue; PacketPointer1->Next; PacketPointer1 = PacketPointer1->Next)
-    ;
-  PacketPointer1->Next  = PacketPointer;
-  Ret                   = 0;
+  EmsMsgTail = PacketPointer;
+  EmsConditionSignal (&EmsMsgNotEmpty);
 
-Done:
-  ReleaseMutex (EmsMsgMutex);
-  return Ret;
+  EmsLockRelease (&EmsMsgLock);
+  return 0;
 }
 
 INT32
 EmsMsgQReceive (
   INT8            *Buf,
-  UINT32           Length
+  UINT32          Length,
+  UINT32          Timeout
   )
 /*++
 
 Routine Description:
 
-  receive message from an EMS message queue
+  receive message from an EMS message queue, waiting for a message if the
+  queue is empty
 
 Arguments:
 
   Buf     - Buffer to receive message
   Length  - the Length of input Buffer
+  Timeout - The milliseconds to wait, 0 to return at once, or WAIT_FOREVER
 
 Returns:
 
@@ -197,17 +215,39 @@ Returns:
 --*/
 {
   MSG_QUEUE *PacketPointer;
+  UINT32    Start;
+  UINT32    Elapsed;
   INT32     Ret;
 
-  WaitForSingleObject (EmsMsgMutex, INFINITE);
+  if (!EmsMsgCreated) {
+    return -1;
+  }
+
+  EmsLockAcquire (&EmsMsgLock);
 
-  if (NULL == EmsMsgQueue) {
-    Ret = -1;
-    goto Done;
+  Start = GetTickCount ();
+  while (NULL == EmsMsgHead) {
+    if (Timeout == WAIT_FOREVER) {
+      EmsConditionWait (&EmsMsgNotEmpty, &EmsMsgLock, INFINITE);
+      continue;
+    }
+
+    Elapsed = GetTickCount () - Start;
+    if (Elapsed >= Timeout) {
+      EmsLockRelease (&EmsMsgLock);
+      return -1;
+    }
+
+    EmsConditionWait (&EmsMsgNotEmpty, &EmsMsgLock, Timeout - Elapsed);
+  }
+
+  PacketPointer = EmsMsgHead;
+  EmsMsgHead    = EmsMsgHead->Next;
+  if (EmsMsgHead == NULL) {
+    EmsMsgTail = NULL;
   }
 
-  PacketPointer = EmsMsgQueue;
-  EmsMsgQueue   = EmsMsgQueue->Next;
+  EmsLockRelease (&EmsMsgLock);
 
   if (Length < PacketPointer->Length) {
     RecordMessage (
@@ -215,14 +255,12 @@ Returns:
       "EMS:  Receive a too long Message from agent "
       );
     Ret = -1;
-    goto Done;
+  } else {
+    memcpy (Buf, PacketPointer->Message, PacketPointer->Length);
+    Ret = PacketPointer->Length;
   }
 
-  memcpy (Buf, PacketPointer->Message, PacketPointer->Length);
-  Ret = PacketPointer->Length;
   EmsMsgDestroy (PacketPointer);
-Done:
-  ReleaseMutex (EmsMsgMutex);
   return Ret;
 }
 
@@ -249,18 +287,23 @@ Returns:
   MSG_QUEUE *PacketPointer;
   MSG_QUEUE *PacketPointer1;
 
-  WaitForSingleObject (EmsMsgMutex, INFINITE);
+  if (!EmsMsgCreated) {
+    return 0;
+  }
+
+  EmsLockAcquire (&EmsMsgLock);
+
+  PacketPointer = EmsMsgHead;
+  EmsMsgHead    = NULL;
+  EmsMsgTail    = NULL;
+
+  EmsLockRelease (&EmsMsgLock);
 
-  PacketPointer = EmsMsgQueue;
   while (PacketPointer) {
     PacketPointer1  = PacketPointer;
     PacketPointer   = PacketPointer->Next;
     EmsMsgDestroy (PacketPointer1);
   }
 
-  EmsMsgQueue = NULL;
-
-  ReleaseMutex (EmsMsgMutex);
-
   return 0;
 }
@@ -65,6 +65,8 @@ Returns:
   }
 
   memcpy (Node->Mac, Mac, 6);
+  Node->Window      = 0;
+  Node->MaxMessage  = 0;
 
   if (Targets == NULL) {
     Targets     = Node;
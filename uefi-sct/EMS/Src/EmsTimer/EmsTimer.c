@@ -24,7 +24,7 @@ Abstract:
 
 --*/
 
-#include <windows.h>
+#include "EmsPlatform.h"
 #include "EmsTimer.h"
 
 STATIC
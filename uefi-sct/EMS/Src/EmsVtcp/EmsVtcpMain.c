@@ -44,6 +44,7 @@ STATIC Tcl_CmdProc  TclVTcpCreateTcb;
 STATIC Tcl_CmdProc  TclVTcpDestroyTcb;
 STATIC Tcl_CmdProc  TclVTcpUpdateSendBuffer;
 STATIC Tcl_CmdProc  TclVTcpSendPacket;
+STATIC Tcl_CmdProc  TclVTcpSendStream;
 STATIC Tcl_CmdProc  TclVTcpRecvPacket;
 STATIC Tcl_CmdProc  TclVTcpBuildOption;
 STATIC Tcl_CmdProc  TclVTcpGetChecksum;
@@ -61,6 +62,10 @@ STATIC TCL_CMD_TBL  TclCmd[] = {
     "SendTcpPacket",
     TclVTcpSendPacket
   },
+  {
+    "SendTcpStream",
+    TclVTcpSendStream
+  },
   {
     "UpdateTcpSendBuffer",
     TclVTcpUpdateSendBuffer
@@ -259,14 +264,9 @@ Returns:
 
     Tcb      = (VTCB *)(Node->Goods);
     EmsVTcbDestroyTcls(EmsThreadSelf()->Interp, Node->Name);
-    libnet_cq_remove(Tcb->SendBuff);
-    libnet_destroy(Tcb->SendBuff);
-    if(Tcb->Capturer->Packet)
-    {
-      PacketFreePacket(Tcb->Capturer->Packet);
-      Tcb->Capturer->Packet = NULL;
-    }
-    pcap_close(Tcb->Capturer);
+    free(Tcb->SendBuff);
+    EmsEngineClose(Tcb->Consumer);
+    free(Tcb->ReceiveBuff);
     EmsNlFreeNode(Node);
     VTcbList = NULL;
   }
@@ -324,14 +324,9 @@ Returns:
       Tcb   = (VTCB *) (Node1->Goods);
 
       EmsVTcbDestroyTcls (Interp, Node1->Name);
-      libnet_cq_remove(Tcb->SendBuff);
-      libnet_destroy (Tcb->SendBuff);
-      if (Tcb->Capturer->Packet) {
-        PacketFreePacket (Tcb->Capturer->Packet);
-        Tcb->Capturer->Packet = NULL;
-      }
-
-      pcap_close (Tcb->Capturer);
+      free (Tcb->SendBuff);
+      EmsEngineClose (Tcb->Consumer);
+      free (Tcb->ReceiveBuff);
 
       EmsNlFreeNode (Node1);
     }
@@ -351,14 +346,9 @@ Returns:
 
     EmsVTcbDestroyTcls (Interp, Argv[1]);
     Tcb = (VTCB *) (Node->Goods);
-    libnet_cq_remove(Tcb->SendBuff);
-    libnet_destroy (Tcb->SendBuff);
-    if (Tcb->Capturer->Packet) {
-      PacketFreePacket (Tcb->Capturer->Packet);
-      Tcb->Capturer->Packet = NULL;
-    }
-
-    pcap_close (Tcb->Capturer);
+    free (Tcb->SendBuff);
+    EmsEngineClose (Tcb->Consumer);
+    free (Tcb->ReceiveBuff);
 
     EmsNlFreeNode (Node);
   }
@@ -434,6 +424,184 @@ ErrorExit:
   return TCL_ERROR;
 }
 
+STATIC
+INT32
+TclVTcpSendStream (
+  IN ClientData        clientData,
+  IN Tcl_Interp        *Interp,
+  IN INT32             Argc,
+  IN CONST84 INT8      *Argv[]
+  )
+/*++
+
+Routine Description:
+
+  TCL command "SendTcpStream" implementation routine. Count segments carry
+  the same payload with consecutive sequence numbers, they are sent in
+  batches without going back to the script. The number of segments sent is
+  returned.
+
+Arguments:
+
+  clientData  - Private data, if any.
+  Interp      - TCL intepreter.
+  Argc        - Argument counter.
+  Argv        - Argument value pointer array.
+
+Returns:
+
+  TCL_OK or TCL_ERROR
+
+--*/
+{
+  VTCB      *Tcb;
+  UINT32    Index;
+  UINT32    Seq;
+  UINT32    Ack;
+  UINT32    Control;
+  UINT32    Win;
+  UINT32    Count;
+  UINT8     *Payload;
+  UINT32    PayloadLen;
+  INT32     Sent;
+  INT8      Result[20];
+  PACKET_T  *PacketPointer;
+
+  LogCurrentCommand (Argc, Argv);
+
+  if (Argc < 2) {
+    goto arg_wrong;
+  }
+
+  Tcb = EmsNlFindGoodsByName (Argv[1], &VTcbList);
+  if (NULL == Tcb) {
+    Tcl_AppendResult (
+      Interp,
+      "SendTcpStream: No such TCB",
+      (INT8 *) NULL
+      );
+    goto ErrorExit;
+  }
+
+  Seq         = Tcb->LocalNextSeq + Tcb->LocalIsn;
+  Ack         = Tcb->RemoteNextSeq + Tcb->RemoteIsn;
+  Win         = Tcb->LocalWin;
+  Control     = TH_ACK;
+  Count       = 0;
+  Payload     = NULL;
+  PayloadLen  = 0;
+
+  for (Index = 2; Index + 1 < (UINT32) Argc; Index++) {
+    if ('-' != Argv[Index][0]) {
+      goto arg_wrong;
+    }
+
+    switch (Argv[Index][1]) {
+    case 's':
+    case 'S':
+      Index++;
+      AsciiStringToUint32 (Argv[Index], &Seq);
+      break;
+
+    case 'a':
+    case 'A':
+      Index++;
+      AsciiStringToUint32 (Argv[Index], &Ack);
+      break;
+
+    case 'c':
+    case 'C':
+      Index++;
+      AsciiStringToUint32 (Argv[Index], &Control);
+      break;
+
+    case 'w':
+    case 'W':
+      Index++;
+      AsciiStringToUint32 (Argv[Index], &Win);
+      break;
+
+    case 'n':
+    case 'N':
+      Index++;
+      AsciiStringToUint32 (Argv[Index], &Count);
+      break;
+
+    case 'p':
+    case 'P':
+      Index++;
+      PacketPointer = EmsPacketFindByName (Argv[Index]);
+      if (NULL == PacketPointer) {
+        Tcl_AppendResult (
+          Interp,
+          "SendTcpStream: No such Payload",
+          (INT8 *) NULL
+          );
+        goto ErrorExit;
+      }
+
+      Payload     = PacketPointer->Data;
+      PayloadLen  = PacketPointer->DataLen;
+      break;
+
+    default:
+      goto arg_wrong;
+    }
+  }
+
+  if ((Index != (UINT32) Argc) || (0 == Count) || (0 == PayloadLen)) {
+    goto arg_wrong;
+  }
+
+  Sent = EmsVTcbSendStream (
+          Tcb,
+          Seq,
+          Ack,
+          (UINT8) Control,
+          (UINT16) Win,
+          Payload,
+          PayloadLen,
+          Count
+          );
+  if (Sent < 0) {
+    Tcl_AppendResult (
+      Interp,
+      "SendTcpStream: Fail to allocate memory",
+      (INT8 *) NULL
+      );
+    goto ErrorExit;
+  }
+
+  if (Control & TH_ACK) {
+    if (Ack > Tcb->RemoteIsn) {
+      Tcb->LocalAckedSeq = Ack - Tcb->RemoteIsn;
+    }
+
+    Tcb->LocalMaxAckedSeq = MAX (Tcb->LocalAckedSeq, Tcb->LocalMaxAckedSeq);
+  }
+
+  Tcb->LocalNextSeq = Seq - Tcb->LocalIsn + Sent * PayloadLen;
+  Tcb->LocalMaxSeq  = MAX (Tcb->LocalMaxSeq, Tcb->LocalNextSeq);
+
+  sprintf (Result, "%d", Sent);
+  Tcl_AppendResult (Interp, Result, (INT8 *) NULL);
+  return TCL_OK;
+
+arg_wrong:
+  Tcl_AppendResult (
+    Interp,
+    "SendTcpStream: SendTcpStream <Name> -n Count -p Payload [Options]",
+    "  Options: ",
+    "    -s/S  Seq of the first segment ",
+    "    -a/A  Ack ",
+    "    -c/C  Control, ACK by default ",
+    "    -w/W  Win ",
+    (INT8 *) NULL
+    );
+ErrorExit:
+  return TCL_ERROR;
+}
+
 STATIC
 INT32
 TclVTcpUpdateSendBuffer (
@@ -43,6 +43,17 @@ extern INT8   *EmsInterface;
 extern UINT8  RemoteEthaddr[6];
 extern UINT8  LocalEthaddr[6];
 
+//
+// Ethernet, IP and TCP header of a segment, without TCP options
+//
+#define VTCB_HEADER_LEN (sizeof (ETH_HEADER) + sizeof (IP_HEADER) + sizeof (TCP_HEADER))
+#define VTCB_OPTION_MAX 40
+
+//
+// A frame starts this far into its buffer, so the IP header is 32-bit aligned
+//
+#define VTCB_ALIGNER    2
+
 typedef struct _VTCB_FIELD_T {
   INT8    *Name;
   UINT32  Offset;
@@ -215,14 +226,6 @@ STATIC VTCB_FIELD_T VTcbFields[] = {
   }
 };
 
-STATIC
-VOID_P
-TcbGotPacket (
-  IN u_char                   *User,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST u_char             *Packet
-  );
-
 VTCB *
 EmsVTcbCreate (
   UINT32          LocalIp,
@@ -250,8 +253,6 @@ Returns:
 --*/
 {
   VTCB                *Con;
-  INT8                ErrBuff[PCAP_ERRBUF_SIZE * 2];
-  struct bpf_program  Bp;
 
   Con = malloc (sizeof (VTCB));
   if (NULL == Con) {
@@ -320,34 +321,17 @@ Returns:
   Con->RemoteTsEcr        = 0;
   Con->RemoteTsVal        = 0;
 
+  Con->Injector           = NULL;
   Con->SendBuff           = NULL;
-  Con->TcpOptionTag       = 0;
-  Con->TcpTag             = 0;
-  Con->IpTag              = 0;
-  Con->EthTag             = 0;
+  Con->SendLen            = 0;
+  Con->SendSize           = 0;
 
   Con->ReceiveBuff        = NULL;
   Con->ReceiveLen         = 0;      /* */
   Con->Received           = 0;      /* Received ??*/
 
-  if ((
-        Con->Capturer = pcap_open_live (
-                    EmsInterface,         // name of the device
-                    65536,                // portion of the packet to capture
-                    1,                    // promiscuous mode
-                    1,                    // read timeout
-                    ErrBuff               // error buffer
-                    )) == NULL) {
-    free (Con);
-    return NULL;
-  }
-
-  if (-1 == pcap_compile (Con->Capturer, &Bp, Con->CaptureFilter, 0, 0xFFFFFF)) {
-    free (Con);
-    return NULL;
-  }
-
-  if (-1 == pcap_setfilter (Con->Capturer, &Bp)) {
+  Con->Consumer = EmsEngineOpen (EmsInterface, "Tcb", Con->CaptureFilter);
+  if (NULL == Con->Consumer) {
     free (Con);
     return NULL;
   }
@@ -424,125 +408,169 @@ Returns:
   return ;
 }
 
-INT32
-EmsVTcbInitSendBuff (
-  VTCB              *Tcb
+STATIC
+UINT32
+VTcbBuildSegment (
+  IN     VTCB   *Tcb,
+  IN OUT UINT8  *Frame,
+  IN     UINT32 Seq,
+  IN     UINT32 Ack,
+  IN     UINT16 CheckSum,
+  IN     UINT8  Control,
+  IN     UINT16 Win,
+  IN     UINT16 Urg,
+  IN     UINT8  *Options,
+  IN     UINT32 OptionsLen,
+  IN     UINT8  *Payload,
+  IN     UINT32 PayloadLen
   )
 /*++
 
 Routine Description:
 
-  initialize the send data buffer
+  Fill a segment in a frame whose headers are a copy of the template. Only
+  the fields that change between segments are written.
 
 Arguments:
 
-  Tcb - The structure of TCP
+  Tcb       - The data structure of TCP
+  Frame     - The frame, VTCB_HEADER_LEN + VTCB_OPTION_MAX + PayloadLen bytes,
+              VTCB_ALIGNER bytes into a 32-bit aligned buffer
+  Seq       - the sequence
+  Ack       - the ack
+  CheckSum  - the checksum, 0 to compute it
+  Control   - the control
+  Win       - the win
+  Urg       - whe urgent
+  Options   - The options
+  OptionsLen - The size of the options, at most VTCB_OPTION_MAX
+  Payload   - The payload
+  PayloadLen - The size of the payload
 
 Returns:
 
-  -1 Failure
-  0  Success
+  The length of the frame
 
 --*/
 {
+  ETH_HEADER  *EthHdr;
+  IP_HEADER   *IpHdr;
+  TCP_HEADER  *TcpHdr;
+  UINT32      TcpLen;
+  UINT32      Padded;
+
+  EthHdr  = (ETH_HEADER *) Frame;
+  IpHdr   = (IP_HEADER *) (Frame + sizeof (ETH_HEADER));
+  TcpHdr  = (TCP_HEADER *) (Frame + sizeof (ETH_HEADER) + sizeof (IP_HEADER));
 
-  libnet_t      *l;
-  libnet_ptag_t TcpOptionTag;
-  libnet_ptag_t TcpTag;
-  libnet_ptag_t IpTag;
-  libnet_ptag_t EthTag;
-  INT8          ErrBuf[LIBNET_ERRBUF_SIZE];
-  UINT32        Len;
   //
-  //  Initialize the libnet
+  // The options are padded with End of Option List to a 32-bit boundary
   //
-  l = libnet_init (
-        LIBNET_LINK,
-        /* injection type */EmsInterface,
-        /* network interface */ErrBuf /* errbuf */
-        );
-  if (NULL == l) {
-    return -1;
+  Padded  = (OptionsLen + 3) & ~3;
+  TcpLen  = sizeof (TCP_HEADER) + Padded + PayloadLen;
+
+  memcpy (EthHdr->Dst, RemoteEthaddr, 6);
+  memcpy (EthHdr->Src, LocalEthaddr, 6);
+
+  IpHdr->IpLen  = htons ((UINT16) (sizeof (IP_HEADER) + TcpLen));
+  IpHdr->IpId   = htons (GetIpId ());
+  IpHdr->IpSum  = 0;
+  IpHdr->IpSum  = EmsVTcbInChecksum ((UINT16 *) IpHdr, sizeof (IP_HEADER));
+
+  TcpHdr->TcpSeq        = htonl (Seq);
+  TcpHdr->TcpAck        = htonl (Ack);
+  TcpHdr->TcpDataOffset = (UINT8) (((sizeof (TCP_HEADER) + Padded) / 4) << 4);
+  TcpHdr->TcpCtrlFlag   = Control;
+  TcpHdr->TcpWinSize    = htons (Win);
+  TcpHdr->TcpChecksum   = 0;
+  TcpHdr->TcpUrgent     = htons (Urg);
+
+  if (0 != OptionsLen) {
+    memcpy ((UINT8 *) (TcpHdr + 1), Options, OptionsLen);
+    memset ((UINT8 *) (TcpHdr + 1) + OptionsLen, TCP_OPTION_END, Padded - OptionsLen);
   }
 
-  /*
-   * Build TCP options
-   */
-  TcpOptionTag = libnet_build_tcp_options (
-                  NULL,
-                  0,
-                  l,
-                  0
-                  );
-  if (-1 == TcpOptionTag) {
-    return -1;
+  if (0 != PayloadLen) {
+    memcpy ((UINT8 *) (TcpHdr + 1) + Padded, Payload, PayloadLen);
   }
 
-  /*
-  * Build TCP packet
-  */
-  Len = LIBNET_TCP_H;
-
-  TcpTag = libnet_build_tcp (
-            (UINT16) (Tcb->LocalPort),
-            (UINT16) (Tcb->RemotePort),
-            0,
-            0,
-            0,
-            (UINT16) (Tcb->LocalWin),
-            0,
-            0,
-            Len,
-            NULL,
-            0,
-            l,
-            0
-            );
-
-  if (-1 == TcpTag) {
-    return -1;
+  if (0 != CheckSum) {
+    TcpHdr->TcpChecksum = htons (CheckSum);
+  } else {
+    TcpHdr->TcpChecksum = EmsVTcbTcpChecksum (IpHdr->IpSrc, IpHdr->IpDst, (UINT8 *) TcpHdr, TcpLen);
   }
 
-  Len = LIBNET_IPV4_H + LIBNET_TCP_H;
-
-  IpTag = libnet_build_ipv4 (
-            Len,
-            0,
-            /* TOS */GetIpId (),
-            /* IP ID */0,
-            /* IP Frag */0x40,
-            /* TTL */IPPROTO_TCP,
-            /* protocol */0,
-            /* CheckSum */htonl (Tcb->LocalIp),
-            htonl (Tcb->RemoteIp),
-            NULL,
-            /* payload */0,
-            /* payload size */l,
-            0
-            );
-  if (-1 == IpTag) {
+  return sizeof (ETH_HEADER) + sizeof (IP_HEADER) + TcpLen;
+}
+
+INT32
+EmsVTcbInitSendBuff (
+  VTCB              *Tcb
+  )
+/*++
+
+Routine Description:
+
+  initialize the send data buffer
+
+Arguments:
+
+  Tcb - The structure of TCP
+
+Returns:
+
+  -1 Failure
+  0  Success
+
+--*/
+{
+  UINT8       *Frame;
+  IP_HEADER   *IpHdr;
+  TCP_HEADER  *TcpHdr;
+
+  Tcb->Injector = EmsInjectorOpen (EmsInterface);
+  if (NULL == Tcb->Injector) {
     return -1;
   }
 
-  EthTag = libnet_build_ethernet (
-            RemoteEthaddr,
-            LocalEthaddr,
-            ETHERTYPE_IP,
-            NULL,
-            0,
-            l,
-            0
-            );
-  if (-1 == EthTag) {
+  Tcb->SendSize = VTCB_ALIGNER + VTCB_HEADER_LEN + VTCB_OPTION_MAX;
+  Tcb->SendBuff = calloc (1, Tcb->SendSize);
+  if (NULL == Tcb->SendBuff) {
     return -1;
   }
 
-  Tcb->TcpOptionTag = TcpOptionTag;
-  Tcb->TcpTag       = TcpTag;
-  Tcb->IpTag        = IpTag;
-  Tcb->EthTag       = EthTag;
-  Tcb->SendBuff     = l;
-
+  //
+  // The fields that never change are only written here
+  //
+  Frame = Tcb->SendBuff + VTCB_ALIGNER;
+  ((ETH_HEADER *) Frame)->Type = htons (ETHERTYPE_IP);
+
+  IpHdr           = (IP_HEADER *) (Frame + sizeof (ETH_HEADER));
+  IpHdr->IpVer    = 4;
+  IpHdr->IpIhl    = sizeof (IP_HEADER) / 4;
+  IpHdr->IpTtl    = 0x40;
+  IpHdr->IpProto  = IPPROTO_TCP;
+  IpHdr->IpSrc    = htonl (Tcb->LocalIp);
+  IpHdr->IpDst    = htonl (Tcb->RemoteIp);
+
+  TcpHdr              = (TCP_HEADER *) (IpHdr + 1);
+  TcpHdr->TcpSrcPort  = htons ((UINT16) Tcb->LocalPort);
+  TcpHdr->TcpDstPort  = htons ((UINT16) Tcb->RemotePort);
+
+  Tcb->SendLen = VTcbBuildSegment (
+                  Tcb,
+                  Frame,
+                  0,
+                  0,
+                  0,
+                  0,
+                  (UINT16) (Tcb->LocalWin),
+                  0,
+                  NULL,
+                  0,
+                  NULL,
+                  0
+                  );
   return 0;
 }
 
@@ -587,108 +615,41 @@ Returns:
 
 --*/
 {
-  libnet_t      *l;
-  libnet_ptag_t TcpOptionTag;
-  libnet_ptag_t TcpTag;
-  libnet_ptag_t IpTag;
-  libnet_ptag_t EthTag;
-  INT8          ErrBuf[LIBNET_ERRBUF_SIZE];
-  UINT32        Len;
-
-  l = Tcb->SendBuff;
+  UINT8   *Buffer;
+  UINT32  Size;
 
-  if (NULL != l) {
-    libnet_cq_remove(l);
-    libnet_destroy (l);
-  }
-
-  l = libnet_init (
-        LIBNET_LINK,
-        /* injection type */EmsInterface,
-        /* network interface */ErrBuf /* errbuf */
-        );
-  if (NULL == l) {
+  if (OptionsLen > VTCB_OPTION_MAX) {
     return -1;
   }
 
-  TcpOptionTag  = Tcb->TcpOptionTag;
-  TcpTag        = Tcb->TcpTag;
-  IpTag         = Tcb->IpTag;
-  EthTag        = Tcb->EthTag;
+  //
+  // The buffer only grows, the headers in it are kept
+  //
+  Size = VTCB_ALIGNER + VTCB_HEADER_LEN + VTCB_OPTION_MAX + PayloadLen;
+  if (Size > Tcb->SendSize) {
+    Buffer = realloc (Tcb->SendBuff, Size);
+    if (NULL == Buffer) {
+      return -1;
+    }
+
+    Tcb->SendBuff = Buffer;
+    Tcb->SendSize = Size;
+  }
 
-  TcpOptionTag = libnet_build_tcp_options (
+  Tcb->SendLen = VTcbBuildSegment (
+                  Tcb,
+                  Tcb->SendBuff + VTCB_ALIGNER,
+                  Seq,
+                  Ack,
+                  CheckSum,
+                  Control,
+                  Win,
+                  Urg,
                   Options,
                   OptionsLen,
-                  l,                  //        TcpOptionTag
-                  0
+                  Payload,
+                  PayloadLen
                   );
-  if (-1 == TcpOptionTag) {
-    return -1;
-  }
-
-  Len = LIBNET_TCP_H;
-  Len += PayloadLen + OptionsLen;
-
-  TcpTag = libnet_build_tcp (
-            (UINT16) (Tcb->LocalPort),
-            (UINT16) (Tcb->RemotePort),
-            Seq,
-            Ack,
-            Control,
-            Win,
-            CheckSum,
-            Urg,
-            Len,
-            Payload,
-            PayloadLen,
-            l,                        //        TcpTag
-            0
-            );
-
-  if (-1 == TcpTag) {
-    return -1;
-  }
-
-  Len = LIBNET_IPV4_H + LIBNET_TCP_H;
-  Len += PayloadLen + OptionsLen;
-
-  IpTag = libnet_build_ipv4 (
-            Len,
-            0,
-            /* TOS      */GetIpId (),
-            /* IP ID    */0,
-            /* IP Frag  */0x40,
-            /* TTL      */IPPROTO_TCP,
-            /* protocol */0,
-            /* CheckSum */htonl (Tcb->LocalIp),
-            htonl (Tcb->RemoteIp),
-            NULL,
-            /* payload */0,
-            /* payload size */l,  //        IpTag
-            0
-            );
-  if (-1 == IpTag) {
-    return -1;
-  }
-
-  EthTag = libnet_build_ethernet (
-            RemoteEthaddr,
-            LocalEthaddr,
-            ETHERTYPE_IP,
-            NULL,
-            0,
-            l,                    //          EthTag
-            0
-            );
-  if (-1 == EthTag) {
-    return -1;
-  }
-
-  Tcb->SendBuff     = l;
-  Tcb->TcpOptionTag = TcpOptionTag;
-  Tcb->TcpTag       = TcpTag;
-  Tcb->IpTag        = IpTag;
-  Tcb->EthTag       = EthTag;
   return 0;
 }
 
@@ -708,108 +669,154 @@ Arguments:
 
 Returns:
 
-  return the result of libnet_write
+  The number of bytes written, or -1 if failed
 
 --*/
 {
-  //
-  //  _asm int 3;
-  //
-  return libnet_write (Tcb->SendBuff);
+  return EmsInjectorSend (Tcb->Injector, Tcb->SendBuff + VTCB_ALIGNER, Tcb->SendLen);
 }
 
 INT32
-EmsVTcbCapture (
-  IN     UINT32 Timeout,
-  IN     VTCB   *Tcb
+EmsVTcbSendStream (
+  VTCB              *Tcb,
+  UINT32            Seq,
+  UINT32            Ack,
+  UINT8             Control,
+  UINT16            Win,
+  UINT8             *Payload,
+  UINT32            PayloadLen,
+  UINT32            Count
   )
 /*++
 
 Routine Description:
 
-  The virtual TCP's capture packet routine
+  Send a stream of segments with the same payload, the sequence number of
+  each one follows the previous one. The segments are written in batches.
 
 Arguments:
 
-  Timeout - The maxinum time will wait
-  Tcb     - The structure of the TCP
+  Tcb       - The data structure of TCP
+  Seq       - the sequence of the first segment
+  Ack       - the ack
+  Control   - the control
+  Win       - the win
+  Payload   - The payload of every segment
+  PayloadLen - The size of the payload
+  Count     - The number of segments
 
 Returns:
 
-  0
+  The number of segments sent, or -1 if failed
 
 --*/
 {
-  INT32   Index;
-
-  INT32   Res;
-  UINT32  DueTime;
-
-  Index         = 0;
-  Tcb->Received = 0;
+  INJECT_FRAME  Frames[INJECT_BATCH_MAX];
+  UINT8         *Buffer;
+  UINT32        Stride;
+  UINT32        Batch;
+  UINT32        Index;
+  UINT32        Sent;
+  UINT32        Result;
+
+  Stride  = (VTCB_ALIGNER + VTCB_HEADER_LEN + PayloadLen + 3) & ~3;
+  Buffer  = malloc (Stride * MIN (Count, INJECT_BATCH_MAX));
+  if (NULL == Buffer) {
+    return -1;
+  }
 
-  DueTime       = GetTickCount ();
-  DueTime       = DueTime + Timeout * 1000;
-  while (1) {
-    //
-    // bugbug
-    // There is one specified process be responsible for capturing packet,
-    // which is different from other packets' capture. So the calling of this
-    // function may cause packet capture blocking.
-    //
-    // Tcl_DoOneEvent(TCL_TIMER_EVEMS);
-    //
-    Res = pcap_dispatch (Tcb->Capturer, 1, TcbGotPacket, (UINT8 *) Tcb);
-    if (1 == Res) {
-      break;
+  Sent = 0;
+  while (Sent < Count) {
+    Batch = MIN (Count - Sent, INJECT_BATCH_MAX);
+    for (Index = 0; Index < Batch; Index++) {
+      Frames[Index].Data = Buffer + Index * Stride + VTCB_ALIGNER;
+      memcpy (Frames[Index].Data, Tcb->SendBuff + VTCB_ALIGNER, VTCB_HEADER_LEN);
+      Frames[Index].Len = VTcbBuildSegment (
+                            Tcb,
+                            Frames[Index].Data,
+                            Seq + (Sent + Index) * PayloadLen,
+                            Ack,
+                            0,
+                            Control,
+                            Win,
+                            0,
+                            NULL,
+                            0,
+                            Payload,
+                            PayloadLen
+                            );
     }
 
-    if (GetTickCount () >= DueTime) {
+    Result  = EmsInjectorSendBatch (Tcb->Injector, Frames, Batch);
+    Sent   += Result;
+    if (Result < Batch) {
       break;
     }
-
-    Tcl_Sleep (1);
   }
 
-  return 0;
+  free (Buffer);
+  return (INT32) Sent;
 }
 
-STATIC
-VOID_P
-TcbGotPacket (
-  IN u_char                   *User,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST u_char             *Packet
+INT32
+EmsVTcbCapture (
+  IN     UINT32 Timeout,
+  IN     VTCB   *Tcb
   )
 /*++
 
 Routine Description:
 
-  The callback function of geting a TCP packet
+  The virtual TCP's capture packet routine
 
 Arguments:
 
-  User    - User string corresponds to user parameter of pcap_dispatch().
-  PktHdr  - Packet header buffer.
-  Packet  - Packet data buffer.
+  Timeout - The maxinum time will wait
+  Tcb     - The structure of the TCP
 
 Returns:
 
-  None
+  -1 Failure
+  0  Success
 
 --*/
 {
-  VTCB  *Tcb;
+  ENGINE_PACKET Packet;
+  UINT32        DueTime;
+  UINT32        Now;
+
+  Tcb->Received = 0;
+
+  Now     = GetTickCount ();
+  DueTime = Now + Timeout * 1000;
+  while (Now <= DueTime) {
+    if (!EmsEngineReceive (Tcb->Consumer, DueTime - Now, &Packet)) {
+      break;
+    }
+
+    //
+    // The receive buffer is kept for parsing, and reused for the next packet
+    //
+    if (NULL == Tcb->ReceiveBuff) {
+      Tcb->ReceiveBuff = malloc (ENGINE_SLOT_SIZE);
+      if (NULL == Tcb->ReceiveBuff) {
+        EmsEngineRelease (Tcb->Consumer, &Packet);
+        return -1;
+      }
+    }
+
+    memcpy (Tcb->ReceiveBuff, Packet.Data, Packet.CapLen);
+    Tcb->ReceiveLen = Packet.CapLen;
 
-  Tcb = (VTCB *) User;
-  if (Tcb->ReceiveBuff) {
-    free (Tcb->ReceiveBuff);
+    if (EmsEngineRelease (Tcb->Consumer, &Packet)) {
+      Tcb->Received = 1;
+      break;
+    }
+
+    Now = GetTickCount ();
   }
 
-  Tcb->ReceiveBuff = malloc (PktHdr->len);
-  memcpy (Tcb->ReceiveBuff, Packet, PktHdr->len);
-  Tcb->ReceiveLen = PktHdr->len;
-  Tcb->Received   = 1;
+  return 0;
 }
 
 INT32
@@ -951,9 +958,9 @@ Returns:
     case TCP_OPTION_TIMSTAM:
       if ((*OptionsPointer++ == TIMSTAM_OPTION_LEN) && (OptionsPointer + TIMSTAM_OPTION_LEN - 2) <= OptionsEnd) {
         Tcb->RemoteTsVal = ntohl (*((UINT32 *) OptionsPointer));
-        ((UINT32 *) OptionsPointer)++;
+        OptionsPointer += sizeof (UINT32);
         Tcb->RemoteTsEcr = ntohl (*((UINT32 *) OptionsPointer));
-        ((UINT32 *) OptionsPointer)++;
+        OptionsPointer += sizeof (UINT32);
       } else {
         Tcb->RemoteError  = OPTION_LEN_ERROR;
         OptionsPointer    = OptionsEnd;
@@ -1010,29 +1017,13 @@ Returns:
   UINT16        Sum;
   UINT32        Len;
   TCP_HEADER    *TcpPacket; /*Tcp packet need to CheckSum include tcp header and data*/
-  PSEUDO_HEADER *PseudoHdr; /*Tcp pseudo header */
   IP_HEADER     *IpHdr;
-  UINT8         *PkgBuffer;
 
-  Sum       = 0;
   TcpPacket = (TCP_HEADER *) (Tcb->ReceiveBuff + sizeof (ETH_HEADER) + sizeof (IP_HEADER));
   IpHdr     = (IP_HEADER *) (Tcb->ReceiveBuff + sizeof (ETH_HEADER));
   Len       = htons (IpHdr->IpLen) - sizeof (IP_HEADER);
-  PkgBuffer = (UINT8 *) malloc (Len + sizeof (PSEUDO_HEADER));
-
-  /* pseudo header */
-  PseudoHdr           = (PSEUDO_HEADER *) PkgBuffer;
-  PseudoHdr->Source   = IpHdr->IpSrc;
-  PseudoHdr->Dest     = IpHdr->IpDst;
-  PseudoHdr->Mbz      = 0;
-  PseudoHdr->Protocol = TCP_PTCL;
-  PseudoHdr->Length   = ntohs (Len);
-
-  /* check Sum tcp packet include pseudo header, tcp header and tcp packet*/
-  memcpy ((PkgBuffer + sizeof (PSEUDO_HEADER)), (UINT8 *) TcpPacket, Len);
-  Sum = EmsVTcbInChecksum ((UINT16 *) PkgBuffer, (sizeof (PSEUDO_HEADER) + Len));
 
-  free (PkgBuffer);
+  Sum = EmsVTcbTcpChecksum (IpHdr->IpSrc, IpHdr->IpDst, (UINT8 *) TcpPacket, Len);
 
   if (0x0000 != Sum) {
     RecordAssertion (
@@ -1087,3 +1078,52 @@ Returns:
 
   return (UINT16) (~Chksum);
 }
+
+UINT16
+EmsVTcbTcpChecksum (
+  IN  UINT32    Source,
+  IN  UINT32    Dest,
+  IN  UINT8     *Segment,
+  IN  UINT32    Len
+  )
+/*++
+
+Routine Description:
+
+  Compute the checksum of a TCP segment, including the pseudo header. The
+  pseudo header is added to the sum directly, so the segment is not copied.
+
+Arguments:
+
+  Source  - The source IP, in network order
+  Dest    - The destination IP, in network order
+  Segment - The TCP header and data
+  Len     - The length of the segment
+
+Returns:
+
+  Return the checksum, 0 if the checksum field of the segment is right
+
+--*/
+{
+  UINT32  Chksum;
+  UINT16  *Buffer;
+
+  Chksum  = (Source & 0xffff) + (Source >> 16) + (Dest & 0xffff) + (Dest >> 16);
+  Chksum += htons (TCP_PTCL) + htons ((UINT16) Len);
+
+  Buffer  = (UINT16 *) Segment;
+  while (Len > 1) {
+    Chksum += *Buffer++;
+    Len -= sizeof (UINT16);
+  }
+
+  if (Len) {
+    Chksum += *(UINT8 *) Buffer;
+  }
+
+  Chksum = (Chksum >> 16) + (Chksum & 0xffff);
+  Chksum += (Chksum >> 16);
+
+  return (UINT16) (~Chksum);
+}
@@ -32,7 +32,7 @@ Abstract:
 #include <EmsNet.h>
 
 #define EFTP_TYPE         0x8888
-#define MAX_EFTP_BUF_LEN  1500
+#define MAX_EFTP_BUF_LEN  1514
 #define SRC_MAC_OFFSET    0
 #define DES_MAC_OFFSET    6
 #define TYPE_OFFSET       12
@@ -52,6 +52,21 @@ Abstract:
 #define EFTP_CRC_LEN      4
 #define MAX_SESSION_NUM   6
 
+//
+// Negotiated transfer options. A block must fit in one Ethernet frame with
+// the EFTP header and the CRC; a window is acknowledged with a bitmap of
+// EFTP_WINDOW_MAP_LEN bytes, one bit per block after the acknowledged one.
+//
+#define EFTP_MAX_BLK_SIZE     (MAX_EFTP_BUF_LEN - DATA_OFFSET - EFTP_CRC_LEN)
+#define EFTP_MAX_WINDOW_SIZE  64
+#define EFTP_WINDOW_MAP_LEN   (EFTP_MAX_WINDOW_SIZE / 8)
+
+//
+// Milliseconds a window waits for its next block; the blocks of a window
+// come back to back, so a longer silence means the rest of it is lost
+//
+#define EFTP_WINDOW_WAIT      50
+
 typedef struct EmsPktStruct {
   struct EmsPktStruct *Next;
   UINT32              Length;
@@ -28,7 +28,7 @@ Abstract:
 #define __EMS_LOG_UTILITY_H__
 
 #include "EmsMain.h"
-#include "Tcl.h"
+#include "tcl.h"
 
 //
 // definition
@@ -37,10 +37,12 @@ Abstract:
 #define HAVE_VSNPRINTF
 #endif
 
-#include <Pcap-int.h>
-
 #if defined(__WIN32__) || defined(WIN32)
+#include <Pcap-int.h>
 #include <iphlpapi.h>
+#else
+#include <pcap.h>
+#include "EmsPlatform.h"
 #endif
 
 #endif
@@ -32,6 +32,7 @@ Abstract:
 #include <EmsNet.h>
 
 #include "EmsVtcpNamedList.h"
+#include "EmsPktEngine.h"
 
 extern
 VOID_P
@@ -55,17 +56,6 @@ Returns:
 --*/
 ;
 
-//
-// This struct is used for capturing one packet.
-// Transfer between the parent and child processes
-//
-typedef struct {
-  BOOLEAN         GotOne;   // Capture one packet?
-  UINT8           *Packet;  // Packet content
-  UINT32          Len;      // The length of the packet
-  struct timeval  Time;     // When got the packet?
-} CAP_INFO;
-
 //
 // This struct is used for capturing multiple packets
 // Transfer between the parent and child processes
@@ -82,9 +72,8 @@ typedef struct {
 //
 typedef struct {
   UINT32          Received;     // Received
-  UINT8           *ReceiveBuff; // Buffer the lasted packet received
   UINT32          ReceiveLen;   // the length of the received packet
-  pcap_t          *Capturer;    //
+  ENGINE_CONSUMER *Consumer;    // Consumer of the capture engine
   UINT8           CaptureFilter[MAX_FILTER_LEN];
   struct timeval  Time;
 } CCB;
@@ -0,0 +1,240 @@
+/** @file
+ 
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR> 
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+ 
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+Module Name:
+  
+    EmsPktEngine.h
+    
+Abstract:
+
+    Data definition for the packet capture engine. There is one engine per
+    interface. Its reader thread copies every packet into a ring of slots,
+    and each consumer walks the ring with its own cursor and filter.
+
+--*/
+
+#ifndef __EMS_PKT_ENGINE_H__
+#define __EMS_PKT_ENGINE_H__
+
+#include "EmsPlatform.h"
+#include <EmsTypes.h>
+#include <EmsNet.h>
+
+#define ENGINE_SLOT_NUM       512
+#define ENGINE_SLOT_SIZE      9216    // snapshot length, enough for jumbo frames
+#define ENGINE_NAME_LEN       32
+#define ENGINE_READ_TIMEOUT   10      // ms, the reader checks for stop at least this often
+
+//
+// A slot of the ring. Sequence is ENGINE_SLOT_BUSY while the reader is writing
+// the slot, and the sequence number of the packet in it otherwise.
+//
+#define ENGINE_SLOT_BUSY      ((LONG) -1)
+
+typedef struct {
+  volatile LONG   Sequence;
+  UINT32          Len;                // Length of the packet on the wire
+  UINT32          CapLen;             // Length of the data in the slot
+  struct timeval  Time;
+  UINT8           Data[ENGINE_SLOT_SIZE];
+} ENGINE_SLOT;
+
+typedef struct _ENGINE_CONSUMER {
+  struct _ENGINE_CONSUMER *Next;
+  struct _ENGINE          *Engine;
+  INT8                    Name[ENGINE_NAME_LEN];
+  BOOLEAN                 Filtered;
+  struct bpf_program      Filter;
+  UINT32                  Cursor;     // Sequence number of the next packet to check
+  UINT32                  Delivered;  // Packets returned to the consumer
+  UINT32                  Lost;       // Packets overwritten before the consumer read them
+  HANDLE                  Arrived;    // Signaled by the reader for every new packet
+  BOOLEAN                 Reported;   // The failure of the engine is logged
+} ENGINE_CONSUMER;
+
+typedef struct _ENGINE {
+  struct _ENGINE          *Next;
+  INT8                    *Interface;
+  pcap_t                  *Capturer;
+  HANDLE                  Thread;
+  HANDLE                  Mutex;      // Protects the consumer list and pcap_compile
+  volatile BOOLEAN        Run;
+  volatile BOOLEAN        Failed;     // The capture failed, the reader has stopped
+  volatile LONG           Head;       // Sequence number of the next packet
+  UINT32                  Truncated;  // Packets longer than a slot
+  UINT32                  Dropped;    // Packets dropped by the driver
+  ENGINE_SLOT             *Slots;
+  ENGINE_CONSUMER         *Consumers;
+} ENGINE;
+
+//
+// A received packet. Data points into the ring and stays valid only until the
+// ring wraps around, see EmsEngineRelease().
+//
+typedef struct {
+  UINT32          Sequence;
+  UINT8           *Data;
+  UINT32          Len;
+  UINT32          CapLen;
+  struct timeval  Time;
+} ENGINE_PACKET;
+
+ENGINE_CONSUMER *
+EmsEngineOpen (
+  IN CONST INT8       *Interface,
+  IN CONST INT8       *Name,
+  IN CONST INT8       *Filter
+  )
+/*++
+
+Routine Description:
+
+  Open a consumer on the capture engine of an interface. The engine is started
+  on the first use of the interface and keeps running until EMS exits.
+  The consumer only sees the packets captured after it is opened.
+
+Arguments:
+
+  Interface - The name of the network device.
+  Name      - The name of the consumer, used in the statistics.
+  Filter    - The BPF filter expression, or NULL to receive all the packets.
+
+Returns:
+
+  The consumer, or NULL if the engine or the filter failed.
+
+--*/
+;
+
+VOID_P
+EmsEngineClose (
+  IN ENGINE_CONSUMER  *Consumer
+  )
+/*++
+
+Routine Description:
+
+  Close a consumer opened by EmsEngineOpen().
+
+Arguments:
+
+  Consumer  - The consumer to close.
+
+Returns:
+
+  None
+
+--*/
+;
+
+BOOLEAN
+EmsEngineReceive (
+  IN  ENGINE_CONSUMER *Consumer,
+  IN  UINT32          Timeout,
+  OUT ENGINE_PACKET   *Packet
+  )
+/*++
+
+Routine Description:
+
+  Wait for the next packet matching the filter of a consumer. The packet is
+  not copied, Packet->Data points into the ring.
+
+Arguments:
+
+  Consumer  - The consumer.
+  Timeout   - The maximum milliseconds to wait, 0 to only check the ring,
+              INFINITE to wait forever.
+  Packet    - The received packet.
+
+Returns:
+
+  TRUE if a packet is received, FALSE on timeout or if the engine failed.
+
+--*/
+;
+
+BOOLEAN
+EmsEngineFailed (
+  IN ENGINE_CONSUMER  *Consumer
+  )
+/*++
+
+Routine Description:
+
+  Check whether the engine of a consumer failed. A failed engine never
+  receives any more packets, the consumer must be closed and opened again.
+
+Arguments:
+
+  Consumer  - The consumer.
+
+Returns:
+
+  TRUE if the engine failed.
+
+--*/
+;
+
+BOOLEAN
+EmsEngineRelease (
+  IN ENGINE_CONSUMER  *Consumer,
+  IN ENGINE_PACKET    *Packet
+  )
+/*++
+
+Routine Description:
+
+  Finish using a packet returned by EmsEngineReceive(). The reader never waits
+  for the consumers, so a slow consumer may have its packet overwritten. The
+  data read from the packet is only valid if this returns TRUE.
+
+Arguments:
+
+  Consumer  - The consumer.
+  Packet    - The packet returned by EmsEngineReceive().
+
+Returns:
+
+  TRUE if the packet was intact, FALSE if it was overwritten.
+
+--*/
+;
+
+INT32
+EmsEngineStatistics (
+  OUT INT8            *Buffer,
+  IN  UINT32          Size
+  )
+/*++
+
+Routine Description:
+
+  Format the statistics of all the engines and consumers, one line each.
+
+Arguments:
+
+  Buffer    - The buffer for the statistics.
+  Size      - The size of the buffer.
+
+Returns:
+
+  The length of the statistics.
+
+--*/
+;
+
+#endif
@@ -0,0 +1,128 @@
+/** @file
+ 
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR> 
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+ 
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+Module Name:
+  
+    EmsPktInject.h
+    
+Abstract:
+
+    Data definition for the packet injectors. There is one injector per
+    interface, it owns the link layer socket that the frames built by EMS
+    are written to.
+
+--*/
+
+#ifndef __EMS_PKT_INJECT_H__
+#define __EMS_PKT_INJECT_H__
+
+#include "EmsPlatform.h"
+#include <EmsTypes.h>
+#include <EmsNet.h>
+
+#define INJECT_BATCH_MAX      64      // frames handed to the kernel at once
+
+typedef struct _INJECTOR {
+  struct _INJECTOR        *Next;
+  INT8                    *Interface;
+  libnet_t                *Writer;    // Only used for its link layer socket
+  UINT32                  IfIndex;    // Index of the interface, 0 if the batched send is not available
+} INJECTOR;
+
+//
+// A frame of a batch, from the Ethernet header on
+//
+typedef struct {
+  UINT8           *Data;
+  UINT32          Len;
+} INJECT_FRAME;
+
+INJECTOR *
+EmsInjectorOpen (
+  IN CONST INT8       *Interface
+  )
+/*++
+
+Routine Description:
+
+  Get the injector of an interface. The injector is opened on the first use
+  of the interface and stays open until EMS exits.
+
+Arguments:
+
+  Interface - The name of the network device.
+
+Returns:
+
+  The injector, or NULL if the device cannot be opened.
+
+--*/
+;
+
+INT32
+EmsInjectorSend (
+  IN INJECTOR         *Injector,
+  IN UINT8            *Frame,
+  IN UINT32           Len
+  )
+/*++
+
+Routine Description:
+
+  Write a frame to the interface.
+
+Arguments:
+
+  Injector  - The injector.
+  Frame     - The frame, from the Ethernet header on.
+  Len       - The length of the frame.
+
+Returns:
+
+  The number of bytes written, or -1 if failed.
+
+--*/
+;
+
+UINT32
+EmsInjectorSendBatch (
+  IN INJECTOR         *Injector,
+  IN INJECT_FRAME     *Frames,
+  IN UINT32           Count
+  )
+/*++
+
+Routine Description:
+
+  Write several frames to the interface, in order. On Linux up to
+  INJECT_BATCH_MAX frames are handed to the kernel by one sendmmsg call,
+  elsewhere they are written one by one.
+
+Arguments:
+
+  Injector  - The injector.
+  Frames    - The frames.
+  Count     - The number of frames.
+
+Returns:
+
+  The number of frames written. The frames after the first failed one are
+  not written.
+
+--*/
+;
+
+#endif
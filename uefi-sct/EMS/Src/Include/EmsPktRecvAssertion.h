@@ -27,6 +27,8 @@ Abstract:
 #ifndef __EMS_RECV_ASSERTION_H__
 #define __EMS_RECV_ASSERTION_H__
 
+#include "EmsPktEngine.h"
+
 #define PRINT_MAC_STRING_LEN    35
 #define PRINT_TYPE_STRING_LEN   10
 #define PRINT_GUID_STRING_LEN   50
@@ -43,7 +45,7 @@ typedef struct _ASSERTION_PACKAGE {
   UINT8   *ReceiveBuff;       // Buffer the lasted packet received
   UINT32  ReceiveLen;
   UINT32  Received;           // Received
-  pcap_t  *Capturer;          // Pcap Capturer, for receiving remote packet
+  ENGINE_CONSUMER *Consumer;  // Consumer of the capture engine, for receiving remote packet
   UINT8   CaptureFilter[100]; // Packet filter
 } ASSERTION_PACKAGE;
 
@@ -72,21 +74,19 @@ Returns:
 
 VOID_P
 EmsRecvedAssertionPkt (
-  IN UINT8                    *User,
-  IN CONST struct pcap_pkthdr *PktHdr,
-  IN CONST UINT8              *Packet
+  IN ASSERTION_PACKAGE        *AssertionPackagePtr,
+  IN UINT32                   Len
   )
 /*++
 
 Routine Description:
 
-  The callback routine of receive assertion packet
+  Handle an assertion packet copied into the receive buffer
 
 Arguments:
 
-  User    - User string corresponds to user parameter of pcap_dispatch().
-  PktHdr  - Packet header buffer.
-  Packet  - Packet data buffer.
+  AssertionPackagePtr - The pointer to the assertion package
+  Len                 - The length of the packet
 
 Returns:
 
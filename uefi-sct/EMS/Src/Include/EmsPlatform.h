@@ -0,0 +1,717 @@
+/** @file
+
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+    EmsPlatform.h
+
+Abstract:
+
+    Platform abstraction of EMS. EMS is written against a small subset of
+    the Win32 API: the mutexes, the events, the threads and the few file,
+    time and adapter services listed below. On Windows this header is just
+    <windows.h>. On the other platforms the same subset is provided by the
+    POSIX backend (EmsPlatformPosix.c) on top of pthreads and eventfd.
+
+    The locks and the condition variables are the only EMS specific
+    primitives; they map to CRITICAL_SECTION/CONDITION_VARIABLE on Windows
+    and to pthread_mutex_t/pthread_cond_t otherwise.
+
+--*/
+
+#ifndef __EMS_PLATFORM_H__
+#define __EMS_PLATFORM_H__
+
+#if defined(__WIN32__) || defined(WIN32)
+
+#include <windows.h>
+
+typedef CRITICAL_SECTION    EMS_LOCK;
+typedef CONDITION_VARIABLE  EMS_CONDITION;
+
+#else
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+
+//
+// Types
+//
+#ifndef VOID
+#define VOID  void
+#endif
+
+typedef void                *HANDLE;
+typedef void                *PVOID;
+typedef void                *LPVOID;
+typedef int                 BOOL;
+typedef int                 LONG;
+typedef unsigned int        ULONG;
+typedef unsigned int        *PULONG;
+typedef unsigned int        DWORD;
+typedef unsigned int        *LPDWORD;
+typedef unsigned short      WORD;
+typedef unsigned char       BYTE;
+typedef unsigned int        UINT;
+typedef int                 INT;
+
+#define WINAPI
+
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE) (LPVOID);
+
+//
+// Wait and thread
+//
+#define INFINITE                  0xFFFFFFFF
+#define WAIT_OBJECT_0             0x00000000
+#define WAIT_TIMEOUT              0x00000102
+#define WAIT_FAILED               0xFFFFFFFF
+#define STILL_ACTIVE              0x00000103
+
+//
+// File
+//
+#define INVALID_HANDLE_VALUE      ((HANDLE) (long) -1)
+#define MAX_PATH                  260
+
+#define GENERIC_READ              0x80000000
+#define GENERIC_WRITE             0x40000000
+#define FILE_SHARE_READ           0x00000001
+#define CREATE_ALWAYS             2
+#define OPEN_EXISTING             3
+#define FILE_ATTRIBUTE_DIRECTORY  0x00000010
+#define FILE_ATTRIBUTE_NORMAL     0x00000080
+
+//
+// The error codes returned by GetLastError
+//
+#define ERROR_SUCCESS             0
+#define ERROR_FILE_NOT_FOUND      2
+#define ERROR_ACCESS_DENIED       5
+#define ERROR_INVALID_HANDLE      6
+#define ERROR_NOT_ENOUGH_MEMORY   8
+#define ERROR_NO_MORE_FILES       18
+#define ERROR_INVALID_PARAMETER   87
+#define ERROR_BUFFER_OVERFLOW     111
+#define ERROR_ALREADY_EXISTS      183
+#define ERROR_NO_DATA             232
+
+typedef struct {
+  DWORD dwFileAttributes;
+  char  cFileName[MAX_PATH];
+} WIN32_FIND_DATA;
+
+typedef struct {
+  WORD  wYear;
+  WORD  wMonth;
+  WORD  wDayOfWeek;
+  WORD  wDay;
+  WORD  wHour;
+  WORD  wMinute;
+  WORD  wSecond;
+  WORD  wMilliseconds;
+} SYSTEMTIME;
+
+//
+// Adapter. Only the fields used by EMS are provided, and the index is the
+// one of the OS, as on Windows.
+//
+#define MAX_ADAPTER_NAME_LENGTH         256
+#define MAX_ADAPTER_DESCRIPTION_LENGTH  128
+#define MAX_ADAPTER_ADDRESS_LENGTH      8
+
+typedef struct _IP_ADAPTER_INFO {
+  struct _IP_ADAPTER_INFO *Next;
+  DWORD                   Index;
+  char                    AdapterName[MAX_ADAPTER_NAME_LENGTH + 4];
+  char                    Description[MAX_ADAPTER_DESCRIPTION_LENGTH + 4];
+  UINT                    AddressLength;
+  BYTE                    Address[MAX_ADAPTER_ADDRESS_LENGTH];
+} IP_ADAPTER_INFO, *PIP_ADAPTER_INFO;
+
+typedef ULONG               IPAddr;
+typedef ULONG               IPMask;
+
+//
+// C runtime
+//
+#define _strdup       strdup
+#define _stricmp      strcasecmp
+#define _snprintf     snprintf
+#define __time64_t    time_t
+#define _time64       time
+#define _localtime64  localtime
+
+//
+// There is no asynchronous procedure call, so a wait is never alerted
+//
+#define WaitForSingleObjectEx(Handle, Milliseconds, Alertable) \
+  WaitForSingleObject ((Handle), (Milliseconds))
+
+//
+// Interlocked operations, all of them are full barriers
+//
+#define InterlockedIncrement(Target)    __sync_add_and_fetch ((Target), 1)
+#define InterlockedDecrement(Target)    __sync_sub_and_fetch ((Target), 1)
+#define InterlockedExchange(Target, Value) \
+  __atomic_exchange_n ((Target), (Value), __ATOMIC_SEQ_CST)
+#define InterlockedCompareExchangePointer(Destination, Exchange, Comparand) \
+  __sync_val_compare_and_swap ((Destination), (Comparand), (Exchange))
+#define InterlockedExchangePointer(Target, Value) \
+  __atomic_exchange_n ((Target), (Value), __ATOMIC_SEQ_CST)
+
+typedef pthread_mutex_t     EMS_LOCK;
+typedef pthread_cond_t      EMS_CONDITION;
+
+HANDLE
+CreateMutex (
+  PVOID       Attributes,
+  BOOL        InitialOwner,
+  const char  *Name
+  )
+/*++
+
+Routine Description:
+
+  Create a recursive mutex. Attributes and Name are ignored.
+
+--*/
+;
+
+BOOL
+ReleaseMutex (
+  HANDLE      Mutex
+  )
+/*++
+
+Routine Description:
+
+  Release a mutex owned by the calling thread.
+
+--*/
+;
+
+HANDLE
+CreateEvent (
+  PVOID       Attributes,
+  BOOL        ManualReset,
+  BOOL        InitialState,
+  const char  *Name
+  )
+/*++
+
+Routine Description:
+
+  Create an event backed by an eventfd. Attributes and Name are ignored.
+
+--*/
+;
+
+BOOL
+SetEvent (
+  HANDLE      Event
+  )
+/*++
+
+Routine Description:
+
+  Signal an event. An auto-reset event wakes one waiter and is reset.
+
+--*/
+;
+
+BOOL
+ResetEvent (
+  HANDLE      Event
+  )
+/*++
+
+Routine Description:
+
+  Reset an event to the non-signaled state.
+
+--*/
+;
+
+DWORD
+WaitForSingleObject (
+  HANDLE      Handle,
+  DWORD       Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Wait for a mutex, an event or a thread, for at most Milliseconds, or
+  forever if it is INFINITE.
+
+Returns:
+
+  WAIT_OBJECT_0, WAIT_TIMEOUT or WAIT_FAILED
+
+--*/
+;
+
+BOOL
+CloseHandle (
+  HANDLE      Handle
+  )
+/*++
+
+Routine Description:
+
+  Close any handle of this backend. A thread keeps running after its
+  handle is closed.
+
+--*/
+;
+
+HANDLE
+CreateThread (
+  PVOID                   Attributes,
+  size_t                  StackSize,
+  LPTHREAD_START_ROUTINE  StartAddress,
+  LPVOID                  Parameter,
+  DWORD                   CreationFlags,
+  LPDWORD                 ThreadId
+  )
+/*++
+
+Routine Description:
+
+  Create a detached thread running StartAddress (Parameter). Attributes
+  and CreationFlags are ignored.
+
+--*/
+;
+
+HANDLE
+GetCurrentThread (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the handle of the calling thread. Unlike Windows, it is a real handle
+  which may be used from the other threads.
+
+--*/
+;
+
+DWORD
+GetCurrentThreadId (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the ID of the calling thread, unique in the process.
+
+--*/
+;
+
+VOID
+ExitThread (
+  DWORD       ExitCode
+  )
+/*++
+
+Routine Description:
+
+  Terminate the calling thread.
+
+--*/
+;
+
+BOOL
+TerminateThread (
+  HANDLE      Thread,
+  DWORD       ExitCode
+  )
+/*++
+
+Routine Description:
+
+  Cancel a thread. The thread stops at its next cancellation point, that is
+  the next blocking call.
+
+--*/
+;
+
+BOOL
+GetExitCodeThread (
+  HANDLE      Thread,
+  LPDWORD     ExitCode
+  )
+/*++
+
+Routine Description:
+
+  Get the exit code of a thread, STILL_ACTIVE if it is running.
+
+--*/
+;
+
+DWORD
+SuspendThread (
+  HANDLE      Thread
+  )
+/*++
+
+Routine Description:
+
+  Suspend the calling thread until ResumeThread is called. A thread can
+  not be suspended by the other threads with pthreads, (DWORD) -1 is
+  returned in that case.
+
+--*/
+;
+
+DWORD
+ResumeThread (
+  HANDLE      Thread
+  )
+/*++
+
+Routine Description:
+
+  Resume a thread suspended by SuspendThread.
+
+--*/
+;
+
+VOID
+Sleep (
+  DWORD       Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Suspend the calling thread for Milliseconds.
+
+--*/
+;
+
+DWORD
+GetTickCount (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the milliseconds elapsed since an unspecified point, from the
+  monotonic clock.
+
+--*/
+;
+
+VOID
+GetSystemTime (
+  SYSTEMTIME  *SystemTime
+  )
+/*++
+
+Routine Description:
+
+  Get the current UTC time.
+
+--*/
+;
+
+DWORD
+GetLastError (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the error code of the last failed call of this backend in the calling
+  thread.
+
+--*/
+;
+
+BOOL
+CreateDirectory (
+  const char  *PathName,
+  PVOID       Attributes
+  )
+/*++
+
+Routine Description:
+
+  Create a directory. Attributes is ignored.
+
+--*/
+;
+
+HANDLE
+CreateFile (
+  const char  *FileName,
+  DWORD       DesiredAccess,
+  DWORD       ShareMode,
+  PVOID       Attributes,
+  DWORD       CreationDisposition,
+  DWORD       FlagsAndAttributes,
+  HANDLE      TemplateFile
+  )
+/*++
+
+Routine Description:
+
+  Open a file. Only CREATE_ALWAYS and OPEN_EXISTING are supported.
+
+--*/
+;
+
+BOOL
+ReadFile (
+  HANDLE      File,
+  PVOID       Buffer,
+  DWORD       NumberOfBytesToRead,
+  LPDWORD     NumberOfBytesRead,
+  PVOID       Overlapped
+  )
+/*++
+
+Routine Description:
+
+  Read a file. Overlapped must be NULL.
+
+--*/
+;
+
+BOOL
+WriteFile (
+  HANDLE      File,
+  const VOID  *Buffer,
+  DWORD       NumberOfBytesToWrite,
+  LPDWORD     NumberOfBytesWritten,
+  PVOID       Overlapped
+  )
+/*++
+
+Routine Description:
+
+  Write a file. Overlapped must be NULL.
+
+--*/
+;
+
+HANDLE
+FindFirstFile (
+  const char        *FileName,
+  WIN32_FIND_DATA   *FindFileData
+  )
+/*++
+
+Routine Description:
+
+  Find the first file matching FileName, a path whose last component may
+  contain the '*' and '?' wildcards.
+
+--*/
+;
+
+BOOL
+FindNextFile (
+  HANDLE            FindFile,
+  WIN32_FIND_DATA   *FindFileData
+  )
+/*++
+
+Routine Description:
+
+  Find the next file. ERROR_NO_MORE_FILES is set when there are no more.
+
+--*/
+;
+
+BOOL
+FindClose (
+  HANDLE            FindFile
+  )
+/*++
+
+Routine Description:
+
+  Close a search handle.
+
+--*/
+;
+
+DWORD
+GetAdaptersInfo (
+  PIP_ADAPTER_INFO  AdapterInfo,
+  PULONG            SizePointer
+  )
+/*++
+
+Routine Description:
+
+  Get the Ethernet adapters of the system, the loopback excluded. If the
+  buffer is too small, the size needed is returned in SizePointer.
+
+Returns:
+
+  ERROR_SUCCESS, ERROR_BUFFER_OVERFLOW or ERROR_NO_DATA
+
+--*/
+;
+
+DWORD
+AddIPAddress (
+  IPAddr            Address,
+  IPMask            Mask,
+  DWORD             IfIndex,
+  PULONG            NTEContext,
+  PULONG            NTEInstance
+  )
+/*++
+
+Routine Description:
+
+  Add an IPv4 address to an adapter with rtnetlink. The context returned is
+  never 0, and is used to delete the address.
+
+--*/
+;
+
+DWORD
+DeleteIPAddress (
+  ULONG             NTEContext
+  )
+/*++
+
+Routine Description:
+
+  Delete an IPv4 address added by AddIPAddress.
+
+--*/
+;
+
+#endif
+
+#include "EmsTypes.h"
+
+//
+// EMS locks and condition variables
+//
+VOID
+EmsLockInit (
+  IN EMS_LOCK       *Lock
+  )
+/*++
+
+Routine Description:
+
+  Initialize a lock. A lock is not recursive.
+
+--*/
+;
+
+VOID
+EmsLockAcquire (
+  IN EMS_LOCK       *Lock
+  )
+/*++
+
+Routine Description:
+
+  Acquire a lock.
+
+--*/
+;
+
+VOID
+EmsLockRelease (
+  IN EMS_LOCK       *Lock
+  )
+/*++
+
+Routine Description:
+
+  Release a lock.
+
+--*/
+;
+
+VOID
+EmsConditionInit (
+  IN EMS_CONDITION  *Condition
+  )
+/*++
+
+Routine Description:
+
+  Initialize a condition variable.
+
+--*/
+;
+
+BOOLEAN
+EmsConditionWait (
+  IN EMS_CONDITION  *Condition,
+  IN EMS_LOCK       *Lock,
+  IN UINT32         Milliseconds
+  )
+/*++
+
+Routine Description:
+
+  Release Lock and wait for Condition to be signaled, for at most
+  Milliseconds, or forever if it is INFINITE. Lock is acquired again
+  before return. A waiter may wake up without being signaled, so the
+  predicate must be checked again.
+
+Arguments:
+
+  Condition     - The condition variable
+  Lock          - The lock owned by the caller
+  Milliseconds  - The maximum time to wait
+
+Returns:
+
+  FALSE if the wait timed out, TRUE otherwise
+
+--*/
+;
+
+VOID
+EmsConditionSignal (
+  IN EMS_CONDITION  *Condition
+  )
+/*++
+
+Routine Description:
+
+  Wake one waiter of a condition variable.
+
+--*/
+;
+
+#endif
@@ -29,6 +29,7 @@ Abstract:
 
 #include "EmsMain.h"
 #include "EmsTypes.h"
+#include "EmsPlatform.h"
 #include "EmsRivlNameScope.h"
 #include "EmsTclInit.h"
 #include "EmsUtilityString.h"
@@ -67,6 +68,7 @@ extern Tcl_CmdProc  TclRemoteDelFunc; // DelFunc
 extern Tcl_CmdProc  TclPack;          // Pack
 extern Tcl_CmdProc  TclDelTclVar;     // DelTclVar
 extern Tcl_CmdProc  TclExec;          // Exec
+extern Tcl_CmdProc  TclRivlBatch;     // RivlBatch
 extern Tcl_CmdProc  TclGetFile;       // GetFile
 extern Tcl_CmdProc  TclPutFile;       // PutFile
 extern Tcl_CmdProc  TclSetTargetBits; // TargetBits
@@ -87,6 +89,12 @@ extern Tcl_CmdProc  TclEndScope;
 
 #define MAX_MESSAGE_LEN     4096
 
+//
+// The name hash tables of variables and types start with this many buckets
+// and double when they hold twice as many names
+//
+#define RIVL_HASH_MIN_SIZE  64
+
 //
 // Internal type validate routine
 //
@@ -144,6 +152,9 @@ typedef struct _RIVL_TYPE {
   BOOLEAN           IsUnion;                // is it union definition?
   UINT32            Align;                  // Alignment bytes
   struct _RIVL_TYPE *Next;                  // next
+  struct _RIVL_TYPE *NextByName;            // next in the name hash bucket
+  UINT32            *MemberMap;             // member index + 1 by name hash, 0 if empty
+  UINT32            MemberMapSize;          // slots in MemberMap, a power of 2
 } RIVL_TYPE;
 
 //
@@ -173,6 +184,9 @@ typedef struct _RIVL_VARIABLE {
   struct _RIVL_VARIABLE *Next;                  // next
   RIVL_SCOPE            *Scope;                 // Name scope
   struct _RIVL_VARIABLE *NextByScope;           // next by scope
+  struct _RIVL_VARIABLE *Prev;                  // previous
+  struct _RIVL_VARIABLE *PrevByScope;           // previous by scope
+  struct _RIVL_VARIABLE *NextByName;            // next in the name hash bucket
 } RIVL_VARIABLE;
 
 //
@@ -37,7 +37,9 @@ Abstract:
 #define MAX_SCOPENAME_LEN 128
 
 typedef struct _RIVL_SCOPE {
-  INT8  Name[MAX_SCOPENAME_LEN];  // name
+  INT8                  Name[MAX_SCOPENAME_LEN];  // name
+  struct _RIVL_VARIABLE *FirstVar;                // first variable of the scope
+  struct _RIVL_VARIABLE *LastVar;                 // last variable of the scope
 } RIVL_SCOPE;
 
 extern RIVL_SCOPE *RivlScopes[SCOPE_STACK_DEPTH];
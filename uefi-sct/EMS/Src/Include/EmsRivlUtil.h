@@ -414,6 +414,27 @@ Returns:
 --*/
 ;
 
+UINT32
+RivlNameHash (
+  IN INT8      *Name
+  )
+/*++
+
+Routine Description:
+
+  Hash a variable, type or member name for the lookup tables
+
+Arguments:
+
+  Name    - The name
+
+Returns:
+
+  The FNV-1a hash of the name
+
+--*/
+;
+
 BOOLEAN
 CheckVariableType (
   INT8            *VarStr,
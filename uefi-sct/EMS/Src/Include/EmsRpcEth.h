@@ -50,6 +50,47 @@ typedef union {
 #define LINK_OPERATION_CLEANUP_ACK	0x22
 #define LINK_OPERATION_DATA			0x11
 #define LINK_OPERATION_DATA_ACK		0x12
+#define LINK_OPERATION_DATA_SACK		0x13
+
+//
+// The capability of the windowed link, carried in the payload of PROBE and
+// PROBE_ACK. An agent that does not know it pads the frame with zeros, and
+// the link stays stop-and-wait.
+//
+#define LINK_CAPABILITY_SIGNATURE 0x53574E44
+#define LINK_CAPABILITY_VERSION   1
+
+#pragma pack(1)
+typedef struct {
+  UINT32  Signature;
+  UINT8   Version;
+  UINT8   Window;
+  UINT16  MaxMessage;
+} EAS_LINK_CAPABILITY;
+#pragma pack()
+
+//
+// In the windowed link the fragments of a message are sent without waiting,
+// at most Window of them unacknowledged. The receiver reports the fragments
+// it holds with DATA_SACK, a bitmap indexed by Offset / MAX_DATA_FRAME_LEN,
+// and the whole message with DATA_ACK.
+//
+#define LINK_FRAGMENT_MAX         64
+#define LINK_BITMAP_SIZE          (LINK_FRAGMENT_MAX / 8)
+#define LINK_BITMAP_TEST(Map, Index)  (((Map)[(Index) / 8] & (1 << ((Index) % 8))) != 0)
+#define LINK_BITMAP_SET(Map, Index)   ((Map)[(Index) / 8] |= (UINT8) (1 << ((Index) % 8)))
+
+#ifndef EMS_LINK_WINDOW
+#define EMS_LINK_WINDOW           16
+#endif
+
+//
+// Retransmission timeout of the windowed link, in milliseconds
+//
+#define LINK_RTO_INITIAL          1000
+#define LINK_RTO_MIN              50
+#define LINK_RTO_MAX              8000
+#define LINK_TIMER_GRANULARITY    10
 
 #define RIVL_LISTENING            1
 #define RIVL_SENDING              2
@@ -265,6 +265,49 @@ Returns:
 --*/
 ;
 
+VOID
+RpcBatchBegin (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Begin a batch of rpc messages, batches may be nested
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+;
+
+UINT32
+RpcBatchEnd (
+  OUT INT8        *ErrorBuff
+  )
+/*++
+
+Routine Description:
+
+  End a batch of rpc messages. The outermost batch sends the queued
+  messages, and reports the failed ones of the whole batch.
+
+Arguments:
+
+  ErrorBuff - Return the first failure, MAX_ERRBUFF_LEN at least
+
+Returns:
+
+  The number of the failed messages
+
+--*/
+;
+
 STATIC Tcl_CmdProc  EmsSetTargetMac;
 STATIC Tcl_CmdProc  EmsGetTargetMac;
 STATIC Tcl_CmdProc  TclOpenDev;
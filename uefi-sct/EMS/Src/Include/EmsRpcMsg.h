@@ -59,7 +59,8 @@ EmsMsgQCreate (
 
 Routine Description:
 
-  create an EMS message queue
+  create an EMS message queue. The queue is created once, the later calls
+  return the same queue.
 
 Arguments:
 
@@ -103,7 +104,7 @@ EmsMsgQSend (
 
 Routine Description:
 
-  sent a message to an EMS message queue
+  sent a message to an EMS message queue, and wake up a receiver
 
 Arguments:
 
@@ -120,19 +121,22 @@ Returns:
 
 INT32
 EmsMsgQReceive (
-  INT8  *Buf,
-  UINT32 Length
+  INT8   *Buf,
+  UINT32 Length,
+  UINT32 Timeout
   )
 /*++
 
 Routine Description:
 
-  receive message from an EMS message queue
+  receive message from an EMS message queue, waiting for a message if the
+  queue is empty
 
 Arguments:
 
   Buf     - Buffer to receive message
   Length  - the Length of input Buffer
+  Timeout - The milliseconds to wait, 0 to return at once, or WAIT_FOREVER
 
 Returns:
 
@@ -32,6 +32,11 @@ Abstract:
 
 typedef struct _TARGET_T {
   INT8              Mac[6];
+  //
+  // The windowed link offered in the PROBE_ACK, 0 for stop-and-wait
+  //
+  UINT8             Window;
+  UINT16            MaxMessage;
   struct _TARGET_T  *Next;
 } TARGET_T;
 
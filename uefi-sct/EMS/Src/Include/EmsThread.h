@@ -28,7 +28,7 @@ Abstract:
 #define __EMSTHREADS__
 
 #include <tcl.h>
-#include <windows.h>
+#include "EmsPlatform.h"
 #include <EmsTypes.h>
 #include <EmsMain.h>
 
@@ -31,6 +31,8 @@ Abstract:
 #include "EmsVtcpNamedList.h"
 #include "EmsTclInit.h"
 #include "EmsNet.h"
+#include "EmsPktEngine.h"
+#include "EmsPktInject.h"
 
 #include "EmsLogUtility.h"
 
@@ -136,19 +138,16 @@ typedef struct _VTCB {
   UINT32          RemoteTsVal;        /*The Time stamp value, this is tcp header option section*/
   UINT32          RemoteTsEcr;        /*The time stamp echo reply, this is tcp header option section*/
 
-  libnet_t        *SendBuff;          /* A temp buffer to send */
-
-  /* Libnet tags for fast rebuild send buffer, not used yet */
-  libnet_ptag_t   TcpOptionTag;
-  libnet_ptag_t   TcpTag;
-  libnet_ptag_t   IpTag;
-  libnet_ptag_t   EthTag;
+  INJECTOR        *Injector;          /* Injector of the interface, shared by all the TCBs */
+  UINT8           *SendBuff;          /* The segment to send, its headers are the template of the next one */
+  UINT32          SendLen;            /* Length of the segment in SendBuff */
+  UINT32          SendSize;           /* Size of SendBuff */
 
   UINT8           *ReceiveBuff;       /* Buffer the lasted packet received */
   UINT32          ReceiveLen;         /* */
   UINT32          Received;           /* Received*/
 
-  pcap_t          *Capturer;          /* Pcap Capturer, for receiving remote packet */
+  ENGINE_CONSUMER *Consumer;          /* Consumer of the capture engine, for receiving remote packet */
   UINT8           CaptureFilter[100]; /* Packet filter */
 } VTCB;
 
@@ -333,7 +332,70 @@ Arguments:
 
 Returns:
 
-  return the result of libnet_write
+  The number of bytes written, or -1 if failed
+
+--*/
+;
+
+INT32
+EmsVTcbSendStream (
+  VTCB              *Tcb,
+  UINT32            Seq,
+  UINT32            Ack,
+  UINT8             Control,
+  UINT16            Win,
+  UINT8             *Payload,
+  UINT32            PayloadLen,
+  UINT32            Count
+  )
+/*++
+
+Routine Description:
+
+  Send a stream of segments with the same payload, the sequence number of
+  each one follows the previous one. The segments are written in batches.
+
+Arguments:
+
+  Tcb       - The data structure of TCP
+  Seq       - the sequence of the first segment
+  Ack       - the ack
+  Control   - the control
+  Win       - the win
+  Payload   - The payload of every segment
+  PayloadLen - The size of the payload
+  Count     - The number of segments
+
+Returns:
+
+  The number of segments sent, or -1 if failed
+
+--*/
+;
+
+UINT16
+EmsVTcbTcpChecksum (
+  IN  UINT32    Source,
+  IN  UINT32    Dest,
+  IN  UINT8     *Segment,
+  IN  UINT32    Len
+  )
+/*++
+
+Routine Description:
+
+  Compute the checksum of a TCP segment, including the pseudo header
+
+Arguments:
+
+  Source  - The source IP, in network order
+  Dest    - The destination IP, in network order
+  Segment - The TCP header and data
+  Len     - The length of the segment
+
+Returns:
+
+  Return the checksum, 0 if the checksum field of the segment is right
 
 --*/
 ;
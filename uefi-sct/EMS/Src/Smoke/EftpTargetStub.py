@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EftpTargetStub.py
+#
+# Abstract:
+#
+#     A local stand-in for the EFTP client of the target (ENTS Eftp), used by
+#     the EFTP benchmark. It reads a file from EMS (RRQ) or writes one to it
+#     (WRQ) and prints the rate. The frame layout is the one of EmsEftp.h.
+#
+#     Without --blksize and --windowsize the request carries no option, and
+#     the transfer is the stop-and-wait one with 512 byte blocks. --loss
+#     drops the given percentage of the received DATA and ACK frames.
+#
+#     Usage: EftpTargetStub.py [--put] [--blksize n] [--windowsize n]
+#                              [--loss percent] ifname hostmac remote local
+#
+
+import argparse
+import random
+import select
+import socket
+import struct
+import sys
+import time
+import zlib
+
+EFTP_TYPE             = 0x8888
+
+EFTP_RRQ              = 1
+EFTP_WRQ              = 2
+EFTP_DATA             = 3
+EFTP_ACK              = 4
+EFTP_ERROR            = 5
+EFTP_OACK             = 6
+
+ETHER_HEAD_LENGTH     = 14
+EFTP_HEADER_LEN       = 8
+DATA_OFFSET           = ETHER_HEAD_LENGTH + EFTP_HEADER_LEN
+MIN_ETH_FRAME_LEN     = 60
+
+EFTP_DEFAULT_BLKSIZE  = 1024
+EFTP_WINDOW_MAP_LEN   = 8
+EFTP_MAX_WINDOW_SIZE  = EFTP_WINDOW_MAP_LEN * 8
+
+#
+# Length, Checksum, OpCode, BlkNo
+#
+HEADER                = struct.Struct ("!HHHH")
+
+ACK_TIMEOUT           = 0.05
+RETRY_TIMEOUT         = 1.0
+RETRY_COUNT           = 10
+
+
+class Target:
+  def __init__ (self, Ifname, HostMac, Loss):
+    self.Sock = socket.socket (socket.AF_PACKET, socket.SOCK_RAW, socket.htons (EFTP_TYPE))
+    #
+    # Room for a few windows, so that a slow interpreter does not lose frames
+    #
+    self.Sock.setsockopt (socket.SOL_SOCKET, socket.SO_RCVBUF, 4 << 20)
+    self.Sock.bind ((Ifname, EFTP_TYPE))
+    self.Mac  = self.Sock.getsockname ()[4][:6]
+    self.Host = bytes.fromhex (HostMac.replace (":", ""))
+    self.Loss = Loss
+    self.Rand = random.Random (1)
+
+  def Send (self, OpCode, BlkNo, Data = b""):
+    Header  = HEADER.pack (EFTP_HEADER_LEN + len (Data), 0, OpCode, BlkNo)
+    Frame   = self.Host + self.Mac + struct.pack ("!H", EFTP_TYPE) + Header + Data
+    #
+    # The CRC field as EMS builds it: the CRC of the first half of the frame,
+    # stored with htons ()
+    #
+    Crc     = zlib.crc32 (Frame[:len (Frame) // 2])
+    Frame  += struct.pack ("<I", ((Crc & 0xff) << 8) | ((Crc >> 8) & 0xff))
+    if len (Frame) < MIN_ETH_FRAME_LEN:
+      Frame += b"\0" * (MIN_ETH_FRAME_LEN - len (Frame))
+    self.Sock.send (Frame)
+
+  def Recv (self, Timeout):
+    """Return (OpCode, BlkNo, Data) of the next EFTP frame of EMS, None on timeout"""
+    Due = time.monotonic () + Timeout
+    while True:
+      Left = Due - time.monotonic ()
+      if Left <= 0 or not select.select ([self.Sock], [], [], Left)[0]:
+        return None
+      Frame = self.Sock.recv (2048)
+      if len (Frame) < DATA_OFFSET or Frame[6:12] == self.Mac:
+        continue
+      Length, CheckSum, OpCode, BlkNo = HEADER.unpack_from (Frame, ETHER_HEAD_LENGTH)
+      if OpCode in (EFTP_DATA, EFTP_ACK) and self.Loss and self.Rand.random () * 100 < self.Loss:
+        continue
+      return OpCode, BlkNo, Frame[DATA_OFFSET:ETHER_HEAD_LENGTH + Length]
+
+  def Request (self, OpCode, Remote, Options):
+    """Send the request until EMS answers, return the answer"""
+    Data = Remote.encode () + b"\0octet\0"
+    for Name, Value in Options:
+      Data += Name.encode () + b"\0" + str (Value).encode () + b"\0"
+    for Retry in range (RETRY_COUNT):
+      self.Send (OpCode, 0, Data)
+      Answer = self.Recv (RETRY_TIMEOUT)
+      if Answer is not None:
+        return Answer
+    sys.exit ("eftp: no answer from EMS")
+
+
+def ParseOack (Data):
+  Items = Data.split (b"\0")
+  return dict ((Items[Index].decode ().lower (), int (Items[Index + 1]))
+               for Index in range (0, len (Items) - 1, 2) if Items[Index + 1].isdigit ())
+
+
+def Bitmap (Received, AckNo):
+  Map = bytearray (EFTP_WINDOW_MAP_LEN)
+  for BlkNo in Received:
+    if AckNo < BlkNo <= AckNo + EFTP_MAX_WINDOW_SIZE:
+      Map[(BlkNo - AckNo - 1) // 8] |= 1 << ((BlkNo - AckNo - 1) % 8)
+  return bytes (Map) if any (Map) else b""
+
+
+def Get (Eftp, Remote, Options):
+  """Read Remote from EMS, return its content"""
+  BlkSize   = EFTP_DEFAULT_BLKSIZE
+  Window    = 1
+  Size      = None
+  Answer    = Eftp.Request (EFTP_RRQ, Remote, Options)
+  if Answer[0] == EFTP_OACK and Answer[1] == 0:
+    Agreed  = ParseOack (Answer[2])
+    BlkSize = Agreed.get ("blksize", BlkSize)
+    Window  = Agreed.get ("windowsize", Window)
+    Size    = Agreed.get ("tsize")
+    Eftp.Send (EFTP_ACK, 0)
+    Answer  = Eftp.Recv (RETRY_TIMEOUT)
+
+  Blocks    = {}
+  AckNo     = 0
+  EndBlkNo  = None if Size is None else (Size + BlkSize - 1) // BlkSize
+  Retry     = 0
+
+  #
+  # EMS sends up to Window blocks after the acknowledged one, and waits for
+  # the ACK after the last of them
+  #
+  def SendAck ():
+    Eftp.Send (EFTP_ACK, AckNo & 0xffff, Bitmap (Blocks, AckNo))
+    return AckNo + Window
+  WindowEnd = Window
+
+  while True:
+    if Answer is None:
+      #
+      # Nothing came in time: acknowledge what is received so far. The
+      # "File EOF" of a windowed read may be lost, the file is complete then
+      #
+      Retry += 1
+      if AckNo == EndBlkNo and Retry > 2:
+        break
+      if Retry > RETRY_COUNT:
+        sys.exit ("eftp: EMS stopped at block %d" % AckNo)
+      WindowEnd = SendAck ()
+      Answer    = Eftp.Recv (ACK_TIMEOUT if Window > 1 else RETRY_TIMEOUT)
+      continue
+
+    OpCode, BlkNo, Data = Answer
+    Retry = 0
+    if OpCode == EFTP_ERROR:
+      sys.exit ("eftp: EMS error %s" % Data.split (b"\0")[0].decode (errors = "replace"))
+    if OpCode == EFTP_OACK and AckNo == EndBlkNo:
+      break
+
+    if OpCode == EFTP_DATA:
+      #
+      # Unwrap the 16-bit block number next to the expected one
+      #
+      BlkNo += (AckNo + 1) & ~0xffff
+      Duplicate = BlkNo in Blocks or BlkNo <= AckNo
+      Filled    = not Duplicate and BlkNo < max (Blocks, default = 0)
+      if not Duplicate:
+        Blocks[BlkNo] = Data
+        if len (Data) < BlkSize:
+          EndBlkNo = BlkNo
+      Gap = not Duplicate and BlkNo > AckNo + 1 and BlkNo - 1 not in Blocks
+      while AckNo + 1 in Blocks:
+        AckNo += 1
+      #
+      # A duplicate of the windowed transfer is a late resend, answering it
+      # would make EMS resend again
+      #
+      Filled = Filled and AckNo == max (Blocks)
+      if (Duplicate and Window == 1) or Gap or Filled or BlkNo >= WindowEnd or AckNo == EndBlkNo:
+        WindowEnd = SendAck ()
+      if Window == 1 and AckNo == EndBlkNo:
+        break
+
+    Answer = Eftp.Recv (ACK_TIMEOUT if Window > 1 else RETRY_TIMEOUT)
+
+  return b"".join (Blocks[BlkNo] for BlkNo in range (1, AckNo + 1))
+
+
+def Put (Eftp, Remote, Content, Options):
+  """Write Content to Remote of EMS"""
+  BlkSize   = EFTP_DEFAULT_BLKSIZE
+  Window    = 1
+  Answer    = Eftp.Request (EFTP_WRQ, Remote, Options)
+  if Answer[0] == EFTP_OACK and Answer[1] == 0:
+    Agreed  = ParseOack (Answer[2])
+    BlkSize = Agreed.get ("blksize", BlkSize)
+    Window  = Agreed.get ("windowsize", Window)
+  elif Answer[0] != EFTP_ACK or Answer[1] != 0:
+    sys.exit ("eftp: EMS refused the write")
+
+  #
+  # A file of whole blocks ends with an empty one
+  #
+  EndBlkNo  = len (Content) // BlkSize + 1
+  AckNo     = 0
+  NextBlkNo = 1
+  ResendNo  = 0
+  Retry     = 0
+
+  def SendBlk (BlkNo):
+    Eftp.Send (EFTP_DATA, BlkNo & 0xffff, Content[(BlkNo - 1) * BlkSize:BlkNo * BlkSize])
+
+  def SendNew ():
+    Sent = 0
+    while NextBlkNo + Sent <= min (AckNo + Window, EndBlkNo):
+      SendBlk (NextBlkNo + Sent)
+      Sent += 1
+    return Sent
+
+  NextBlkNo += SendNew ()
+  while AckNo < EndBlkNo:
+    Answer = Eftp.Recv (RETRY_TIMEOUT)
+    if Answer is None:
+      Retry += 1
+      if Retry > RETRY_COUNT:
+        sys.exit ("eftp: EMS stopped at block %d" % AckNo)
+      ResendNo = AckNo
+      SendBlk (AckNo + 1)
+      continue
+
+    OpCode, BlkNo, Data = Answer
+    Retry = 0
+    if OpCode == EFTP_ERROR:
+      sys.exit ("eftp: EMS error %s" % Data.split (b"\0")[0].decode (errors = "replace"))
+    if OpCode != EFTP_ACK:
+      continue
+
+    BlkNo += AckNo & ~0xffff
+    if BlkNo < AckNo:
+      BlkNo += 0x10000
+    if BlkNo < AckNo or BlkNo >= NextBlkNo:
+      continue
+
+    Repeated  = BlkNo == AckNo
+    AckNo     = BlkNo
+    Holes     = []
+    if len (Data) >= EFTP_WINDOW_MAP_LEN:
+      Bits  = [Index for Index in range (EFTP_MAX_WINDOW_SIZE) if Data[Index // 8] & (1 << (Index % 8))]
+      Holes = [AckNo + 1 + Index for Index in range (max (Bits, default = 0)) if Index not in Bits]
+    if AckNo == EndBlkNo:
+      break
+
+    #
+    # The holes are resent once, and again only when the ACK repeats with
+    # nothing new to send, as the windowed sender of EMS does
+    #
+    Sent = 0
+    for Hole in Holes:
+      if Hole > ResendNo:
+        SendBlk (Hole)
+        ResendNo = Hole
+        Sent += 1
+    New        = SendNew ()
+    NextBlkNo += New
+    if Window > 1 and Repeated and Sent + New == 0:
+      for Hole in Holes or [AckNo + 1]:
+        SendBlk (Hole)
+
+
+def Main ():
+  Parser = argparse.ArgumentParser ()
+  Parser.add_argument ("--put", action = "store_true")
+  Parser.add_argument ("--blksize", type = int)
+  Parser.add_argument ("--windowsize", type = int)
+  Parser.add_argument ("--loss", type = float, default = 0)
+  Parser.add_argument ("ifname")
+  Parser.add_argument ("hostmac")
+  Parser.add_argument ("remote")
+  Parser.add_argument ("local")
+  Args = Parser.parse_args ()
+
+  Options = []
+  if Args.blksize:
+    Options.append (("blksize", Args.blksize))
+  if Args.windowsize:
+    Options.append (("windowsize", Args.windowsize))
+
+  Eftp  = Target (Args.ifname, Args.hostmac, Args.loss)
+  Start = time.monotonic ()
+  if Args.put:
+    with open (Args.local, "rb") as File:
+      Content = File.read ()
+    Put (Eftp, Args.remote, Content, Options)
+  else:
+    if Options:
+      Options.append (("tsize", 0))
+    Content = Get (Eftp, Args.remote, Options)
+    with open (Args.local, "wb") as File:
+      File.write (Content)
+  Elapsed = max (time.monotonic () - Start, 1e-6)
+
+  print ("%s %d bytes in %.2f s: %.2f MB/s" % ("put" if Args.put else "get", len (Content),
+                                                 Elapsed, len (Content) / Elapsed / 1e6), flush = True)
+
+
+if __name__ == "__main__":
+  Main ()
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsAgentStub.py
+#
+# Abstract:
+#
+#     A local stand-in for the EFI agent (EAS) of the MNP link, used by the
+#     EMS smoke test and link benchmark. It answers PROBE with PROBE_ACK,
+#     acknowledges every DATA message, and replies to each RIVL message with
+#     " _ACK_ P". A RIVL command naming a variable or type R_Fail... is
+#     failed with the name in the log. "TEST_EXEC Bench n" is answered with
+#     n bytes of output. The frame layout is the one of EmsRpcEth.h.
+#
+#     The windowed link is agreed when the PROBE offers it, unless --legacy
+#     is given; the stop-and-wait link is used otherwise. RIVL_BATCH is
+#     answered with one ack per command, or failed as an unknown command
+#     with --no-batch, like an agent older than the batch.
+#
+#     Usage: EmsAgentStub.py [--legacy] [--no-batch] ifname
+#
+
+import re
+import select
+import socket
+import struct
+import sys
+import time
+
+EMS_PROTO_ID                = 0x1234
+
+LINK_OPERATION_PROBE        = 0x01
+LINK_OPERATION_PROBE_ACK    = 0x02
+LINK_OPERATION_DATA         = 0x11
+LINK_OPERATION_DATA_ACK     = 0x12
+LINK_OPERATION_DATA_SACK    = 0x13
+LINK_OPERATION_CLEANUP      = 0x21
+LINK_OPERATION_CLEANUP_ACK  = 0x22
+
+ETHER_HEAD_LENGTH           = 14
+LLC_HEAD_LENGTH             = 8
+DATA_FLAG_LENGTH            = 8
+MIN_ETH_FRAME_LEN           = 60
+MAX_DATA_FRAME_LEN          = 1492
+
+#
+# EAS_RIVL_LL_FLAG: SeqId, Offset, OpCode, then the "more fragments" flag in
+# the highest bit of the last byte
+#
+LL_FLAG                     = struct.Struct ("!IHBB")
+LL_FLAG_MF                  = 0x80
+
+#
+# EAS_LINK_CAPABILITY: Signature, Version, Window, MaxMessage
+#
+CAPABILITY                  = struct.Struct ("!IBBH")
+CAPABILITY_SIGNATURE        = 0x53574E44
+CAPABILITY_VERSION          = 1
+
+AGENT_WINDOW                = 16
+AGENT_MAX_MESSAGE           = DATA_FLAG_LENGTH + 4096
+LINK_BITMAP_SIZE            = 8
+LINK_TIMEOUT                = 0.2
+
+RIVL_BATCH                  = b"RIVL_BATCH "
+RIVL_BATCH_DELIM            = b" _NEXT_ "
+RIVL_FAIL                   = re.compile (rb"\bR_Fail\w*")
+
+
+def Send (Sock, Dst, Src, SeqId, OpCode, Payload = b"", Offset = 0, Flags = 0):
+  Frame = Dst + Src + struct.pack ("!H", EMS_PROTO_ID) + \
+          LL_FLAG.pack (SeqId, Offset, OpCode, Flags) + Payload
+  if len (Frame) < MIN_ETH_FRAME_LEN:
+    Frame += b"\0" * (MIN_ETH_FRAME_LEN - len (Frame))
+  Sock.send (Frame)
+
+
+def Reply (Message, Batch = True):
+  #
+  # The acks of a batch are in the order of its commands
+  #
+  if Message.startswith (RIVL_BATCH):
+    if not Batch:
+      return b" _ACK_ F "
+    return RIVL_BATCH_DELIM.join (Reply (Command)
+                                  for Command in Message[len (RIVL_BATCH):].split (RIVL_BATCH_DELIM))
+  if Message.startswith (b"RIVL_"):
+    Name = RIVL_FAIL.search (Message)
+    if Name is not None:
+      return b" _ACK_ F _LOG_ " + Name.group () + b" refused"
+    return b" _ACK_ P"
+  #
+  # Exec expects a "Status" in the log
+  #
+  if Message.startswith (b"TEST_EXEC Bench "):
+    Size = int (Message.split ()[2])
+    return b" _ACK_ P _OUT_ " + b"x" * Size + b" _LOG_ Status: Success"
+  if Message.startswith (b"TEST_EXEC "):
+    return b" _ACK_ P _LOG_ Status: Success"
+  return b" _ACK_ P"
+
+
+class Link:
+  def __init__ (self, Sock, Legacy):
+    self.Sock       = Sock
+    self.Mac        = Sock.getsockname ()[4][:6]
+    self.Legacy     = Legacy
+    self.Window     = 0
+    self.Peer       = None
+    self.SendSeq    = 0
+    self.LastSeq    = None
+    self.RecvSeq    = None
+    self.RecvParts  = {}
+    self.RecvCount  = 0
+    self.SinceAck   = 0
+    self.Pending    = []
+
+  def Recv (self, Timeout):
+    if not select.select ([self.Sock], [], [], Timeout)[0]:
+      return None
+    Frame = self.Sock.recv (2048)
+    if len (Frame) < ETHER_HEAD_LENGTH + LLC_HEAD_LENGTH or Frame[6:12] == self.Mac:
+      return None
+    SeqId, Offset, OpCode, Flags = LL_FLAG.unpack_from (Frame, ETHER_HEAD_LENGTH)
+    return Frame[6:12], SeqId, Offset, OpCode, Flags, Frame[ETHER_HEAD_LENGTH + LLC_HEAD_LENGTH:]
+
+  def Bitmap (self):
+    Map = bytearray (LINK_BITMAP_SIZE)
+    for Index in self.RecvParts:
+      Map[Index // 8] |= 1 << (Index % 8)
+    return bytes (Map)
+
+  def Probe (self, Src, Data):
+    self.Peer   = Src
+    self.Window = 0
+    if not self.Legacy and len (Data) >= CAPABILITY.size:
+      Signature, Version, Window, MaxMessage = CAPABILITY.unpack_from (Data)
+      if Signature == CAPABILITY_SIGNATURE and Version >= CAPABILITY_VERSION and Window != 0:
+        self.Window = min (Window, AGENT_WINDOW)
+    if self.Window == 0:
+      Send (self.Sock, Src, self.Mac, 0, LINK_OPERATION_PROBE_ACK)
+    else:
+      Send (self.Sock, Src, self.Mac, 0, LINK_OPERATION_PROBE_ACK,
+            CAPABILITY.pack (CAPABILITY_SIGNATURE, CAPABILITY_VERSION, AGENT_WINDOW, AGENT_MAX_MESSAGE))
+
+  def Data (self, Src, SeqId, Offset, Flags, Data):
+    """Reassemble a DATA fragment by its offset, return the complete message"""
+    self.Peer = Src
+    if SeqId == self.LastSeq:
+      #
+      # A retransmission, the DATA_ACK was lost
+      #
+      if self.Window != 0 or not Flags & LL_FLAG_MF:
+        Send (self.Sock, Src, self.Mac, SeqId, LINK_OPERATION_DATA_ACK)
+      return None
+
+    if SeqId != self.RecvSeq:
+      self.RecvSeq, self.RecvParts, self.RecvCount, self.SinceAck = SeqId, {}, 0, 0
+    Index = Offset // MAX_DATA_FRAME_LEN
+    #
+    # The frame padding after the last fragment is cut by Serve at the NUL
+    # that ends the text; the DATA_FLAG itself may hold zero bytes
+    #
+    self.RecvParts[Index] = Data
+    if not Flags & LL_FLAG_MF:
+      self.RecvCount = Index + 1
+
+    if self.RecvCount == 0 or len (self.RecvParts) < self.RecvCount:
+      self.SinceAck += 1
+      if self.Window != 0 and (not Flags & LL_FLAG_MF or
+                               (Index > 0 and Index - 1 not in self.RecvParts) or
+                               self.SinceAck * 2 >= self.Window):
+        self.SinceAck = 0
+        Send (self.Sock, Src, self.Mac, SeqId, LINK_OPERATION_DATA_SACK, self.Bitmap ())
+      return None
+
+    Send (self.Sock, Src, self.Mac, SeqId, LINK_OPERATION_DATA_ACK)
+    self.LastSeq = SeqId
+    Message = b"".join (self.RecvParts[Index] for Index in range (self.RecvCount))
+    self.RecvSeq = None
+    return Message
+
+  def SendMessage (self, Message):
+    """Send a message and wait for its DATA_ACK, stop-and-wait or windowed"""
+    self.SendSeq += 1
+    Parts = [Message[Offset:Offset + MAX_DATA_FRAME_LEN]
+             for Offset in range (0, len (Message), MAX_DATA_FRAME_LEN)]
+    Acked = set ()
+    Next  = 0
+    Rto   = LINK_TIMEOUT
+
+    def SendPart (Index):
+      Flags = 0 if Index == len (Parts) - 1 else LL_FLAG_MF
+      Send (self.Sock, self.Peer, self.Mac, self.SendSeq, LINK_OPERATION_DATA,
+            Parts[Index], Index * MAX_DATA_FRAME_LEN, Flags)
+
+    Window = self.Window if self.Window != 0 else len (Parts)
+    while True:
+      while Next < len (Parts) and Next - len (Acked) < Window:
+        SendPart (Next)
+        Next += 1
+
+      Due = time.monotonic () + Rto
+      while True:
+        Left = Due - time.monotonic ()
+        if Left <= 0:
+          break
+        Frame = self.Recv (Left)
+        if Frame is None:
+          continue
+        Src, SeqId, Offset, OpCode, Flags, Data = Frame
+        if OpCode == LINK_OPERATION_DATA_ACK and SeqId == self.SendSeq:
+          return
+        if OpCode == LINK_OPERATION_DATA_SACK and SeqId == self.SendSeq and self.Window != 0:
+          Acked |= set (Index for Index in range (len (Parts)) if Data[Index // 8] & (1 << (Index % 8)))
+          for Index in range (max (Acked, default = 0)):
+            if Index not in Acked:
+              SendPart (Index)
+          break
+        if OpCode == LINK_OPERATION_DATA:
+          #
+          # A new request is the acknowledgement of the reply
+          #
+          Message = self.Data (Src, SeqId, Offset, Flags, Data)
+          if Message is not None:
+            self.Pending.append (Message)
+            return
+        elif OpCode == LINK_OPERATION_PROBE:
+          self.Probe (Src, Data)
+          return
+
+      if Left <= 0:
+        #
+        # Time out: back off and resend what is not acknowledged
+        #
+        Rto = min (Rto * 2, 8.0)
+        Unacked = [Index for Index in range (Next) if Index not in Acked] or [len (Parts) - 1]
+        for Index in Unacked:
+          SendPart (Index)
+
+
+def Serve (Link, Message, Batch):
+  DataFlag = Message[:DATA_FLAG_LENGTH]
+  Text     = Message[DATA_FLAG_LENGTH:].split (b"\0", 1)[0]
+  print ("agent: recv (%s)" % Text[:64].decode (errors = "replace"), flush = True)
+  Link.SendMessage (DataFlag + Reply (Text, Batch) + b"\0")
+
+
+def Main ():
+  Legacy = "--legacy" in sys.argv[1:]
+  Batch  = "--no-batch" not in sys.argv[1:]
+  Ifname = [Arg for Arg in sys.argv[1:] if not Arg.startswith ("--")][0]
+
+  Sock = socket.socket (socket.AF_PACKET, socket.SOCK_RAW, socket.htons (EMS_PROTO_ID))
+  Sock.bind ((Ifname, EMS_PROTO_ID))
+  Agent = Link (Sock, Legacy)
+
+  while True:
+    if Agent.Pending:
+      Serve (Agent, Agent.Pending.pop (0), Batch)
+      continue
+
+    Frame = Agent.Recv (None)
+    if Frame is None:
+      continue
+    Src, SeqId, Offset, OpCode, Flags, Data = Frame
+
+    if OpCode == LINK_OPERATION_PROBE:
+      Agent.Probe (Src, Data)
+
+    elif OpCode == LINK_OPERATION_CLEANUP:
+      Send (Sock, Src, Agent.Mac, SeqId, LINK_OPERATION_CLEANUP_ACK)
+
+    elif OpCode == LINK_OPERATION_DATA:
+      Message = Agent.Data (Src, SeqId, Offset, Flags, Data)
+      if Message is not None:
+        Serve (Agent, Message, Batch)
+
+
+if __name__ == "__main__":
+  Main ()
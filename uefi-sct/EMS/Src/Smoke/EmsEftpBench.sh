@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsEftpBench.sh
+#
+# Abstract:
+#
+#     EFTP throughput of EMS for a test image of Size MB. EftpTargetStub.py
+#     stands in for the target over a veth pair and reads the image with the
+#     1024 byte stop-and-wait transfer, with 1488 byte blocks, and windowed,
+#     then writes it back windowed. Each copy is compared with the image.
+#     LOSS drops that percentage of the frames the stand-in receives, e.g.
+#     LOSS=1. Needs CAP_NET_ADMIN and CAP_NET_RAW.
+#
+#     The stop-and-wait transfer is limited to 65535 blocks by its 16-bit
+#     block numbers, so it reads at most 60 MB of the image.
+#
+#     Usage: EmsEftpBench.sh path/to/Ems [Size]
+#
+
+EMS=$(realpath "${1:-../Bin/Ems}")
+DIR=$(realpath "$(dirname "$0")")
+SIZE=${2:-50}
+EMS_IF=ems-eftp0
+EAS_IF=eas-eftp0
+WORK=$(mktemp -d)
+
+Cleanup () {
+  [ -n "$SERVER" ] && kill "$SERVER" 2>/dev/null
+  ip link del "$EMS_IF" 2>/dev/null
+  rm -rf "$WORK"
+}
+trap Cleanup EXIT
+
+ip link add "$EMS_IF" type veth peer name "$EAS_IF" || exit 1
+ip link set "$EMS_IF" up
+ip link set "$EAS_IF" up
+HOST_MAC=$(cat /sys/class/net/$EMS_IF/address)
+
+#
+# An image of whole blocks would need the empty last block, not sent by the
+# stop-and-wait read of EMS
+#
+cd "$WORK" || exit 1
+head -c $((SIZE * 1048576 + 1000)) /dev/urandom > Image
+head -c $(((SIZE < 60 ? SIZE : 60) * 1048576 + 1000)) Image > Legacy
+
+"$EMS" "$DIR/EmsEftpBench.tcl" "$(cat /sys/class/net/$EMS_IF/ifindex)" "$EMS_IF" "$HOST_MAC" > Ems.log 2>&1 &
+SERVER=$!
+sleep 1
+
+Run () {
+  Name=$1
+  File=$2
+  shift 2
+  printf "%-16s" "$Name:"
+  python3 "$DIR/EftpTargetStub.py" ${LOSS:+--loss $LOSS} "$@" "$EAS_IF" "$HOST_MAC" "$File" Copy || exit 1
+  cmp -s "$File" Copy || { echo "BENCH FAIL: $Name copy differs"; exit 1; }
+  rm -f Copy
+  #
+  # Let EMS time out the finished session, a late resend restarts its wait
+  #
+  sleep 10
+}
+
+Run "stop-and-wait"  Legacy
+Run "blksize 1488"   Image --blksize 1488
+Run "windowsize 16"  Image --blksize 1488 --windowsize 16
+
+cp Image Local
+printf "%-16s" "put windowed:"
+python3 "$DIR/EftpTargetStub.py" ${LOSS:+--loss $LOSS} --put --blksize 1488 --windowsize 16 \
+  "$EAS_IF" "$HOST_MAC" Upload Local || exit 1
+sleep 10
+cmp -s Image Upload || { echo "BENCH FAIL: put copy differs"; exit 1; }
+echo "BENCH PASS"
@@ -0,0 +1,33 @@
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsEftpBench.tcl
+#
+# Abstract:
+#
+#     Serve EFTP on an interface until killed, for EmsEftpBench.sh. Files are
+#     read and written relative to the working directory.
+#
+#     Usage: Ems EmsEftpBench.tcl ifindex ifname hostmac
+#
+
+if {[llength $argv] != 3} {
+  puts "BENCH FAIL: usage: Ems EmsEftpBench.tcl ifindex ifname hostmac"
+  exit 1
+}
+
+Interface [lindex $argv 0] [lindex $argv 1]
+EftpStart [lindex $argv 2]
+vwait forever
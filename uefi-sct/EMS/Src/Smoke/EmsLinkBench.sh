@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsLinkBench.sh
+#
+# Abstract:
+#
+#     Throughput of the stop-and-wait and the windowed MNP link. EMS talks to
+#     EmsAgentStub.py over a veth pair, once with the agent in --legacy mode
+#     and once windowed. DELAY and LOSS add a netem delay and loss, e.g.
+#     DELAY=5ms LOSS=1%. Needs CAP_NET_ADMIN and CAP_NET_RAW.
+#
+#     To measure against a real agent, e.g. SCT in QEMU on a tap, give the
+#     interface instead: the agent then decides the link itself.
+#
+#     Usage: EmsLinkBench.sh path/to/Ems [ifname] [Count] [Size]
+#
+
+EMS=${1:-../Bin/Ems}
+DIR=$(dirname "$0")
+COUNT=${3:-200}
+SIZE=${4:-3500}
+EMS_IF=ems-bench0
+EAS_IF=eas-bench0
+
+Run () {
+  timeout 600 "$EMS" "$DIR/EmsLinkBench.tcl" "$(cat /sys/class/net/$1/ifindex)" "$1" "$COUNT" "$SIZE"
+}
+
+if [ -n "$2" ]; then
+  Run "$2"
+  exit $?
+fi
+
+Cleanup () {
+  [ -n "$AGENT" ] && kill "$AGENT" 2>/dev/null
+  ip link del "$EMS_IF" 2>/dev/null
+}
+trap Cleanup EXIT
+
+ip link add "$EMS_IF" type veth peer name "$EAS_IF" || exit 1
+ip link set "$EMS_IF" up
+ip link set "$EAS_IF" up
+
+if [ -n "$DELAY$LOSS" ]; then
+  for IF in "$EMS_IF" "$EAS_IF"; do
+    tc qdisc add dev "$IF" root netem ${DELAY:+delay $DELAY} ${LOSS:+loss $LOSS} || exit 1
+  done
+fi
+
+for MODE in --legacy --windowed; do
+  python3 "$DIR/EmsAgentStub.py" $([ "$MODE" = --legacy ] && echo --legacy) "$EAS_IF" > /dev/null &
+  AGENT=$!
+  echo "link: ${MODE#--}"
+  Run "$EMS_IF" || exit 1
+  kill "$AGENT"
+  wait "$AGENT" 2>/dev/null
+  AGENT=
+done
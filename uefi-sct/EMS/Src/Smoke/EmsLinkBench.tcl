@@ -0,0 +1,69 @@
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsLinkBench.tcl
+#
+# Abstract:
+#
+#     Throughput of the MNP link: run Count round trips of a request of three
+#     fragments, answered with Size bytes of output, and print the rate.
+#
+#     Usage: Ems EmsLinkBench.tcl ifindex ifname [Count] [Size]
+#
+
+proc Fail {Message} {
+  puts "BENCH FAIL: $Message"
+  exit 1
+}
+
+if {[llength $argv] < 2} {
+  Fail "usage: Ems EmsLinkBench.tcl ifindex ifname \[Count\] \[Size\]"
+}
+
+set Count [expr {[llength $argv] > 2 ? [lindex $argv 2] : 200}]
+set Size  [expr {[llength $argv] > 3 ? [lindex $argv 3] : 3500}]
+
+Interface [lindex $argv 0] [lindex $argv 1]
+
+if {[catch {OpenDev mnp} Result]} {
+  Fail $Result
+}
+
+#
+# DumpTarget lists the MAC of every target that answered the probe
+#
+CheckTarget
+set Target [string range [DumpTarget] 0 16]
+if {$Target eq ""} {
+  Fail "no agent answered the probe"
+}
+SetTargetMac $Target
+
+set Argument [string repeat "y" 3500]
+set Start    [clock milliseconds]
+for {set Index 0} {$Index < $Count} {incr Index} {
+  if {[catch {Exec "Bench $Size $Argument"} Result]} {
+    Fail $Result
+  }
+}
+set Elapsed [expr {max ([clock milliseconds] - $Start, 1)}]
+
+set Bytes [expr {$Count * ($Size + [string length $Argument])}]
+puts [format "BENCH %d round trips in %d ms: %.1f msg/s, %.1f KB/s" \
+        $Count $Elapsed [expr {$Count * 1000.0 / $Elapsed}]          \
+        [expr {$Bytes / 1.024 / $Elapsed}]]
+
+CloseDev mnp
+exit 0
@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsLogBench.sh
+#
+# Abstract:
+#
+#     Assertion rate and timer jitter of the EMS log, written in the caller
+#     and by the writer thread. No network is used, the log goes to a
+#     scratch directory that is removed afterwards.
+#
+#     Usage: EmsLogBench.sh path/to/Ems [Count] [Ticks] [PerTick] [Period]
+#
+
+EMS=$(realpath "${1:-../Bin/Ems}")
+DIR=$(realpath "$(dirname "$0")")
+WORK=$(mktemp -d) || exit 1
+
+trap 'rm -rf "$WORK"' EXIT
+
+cd "$WORK" || exit 1
+timeout 600 "$EMS" "$DIR/EmsLogBench.tcl" ${2:-5000} ${3:-200} ${4:-10} ${5:-20}
@@ -0,0 +1,107 @@
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsLogBench.tcl
+#
+# Abstract:
+#
+#     Cost of the EMS log, once written in the caller and once by the writer
+#     thread. For each mode Count assertions are recorded back to back, then
+#     a periodic timer records PerTick assertions per tick, and the lateness
+#     of the ticks is measured. A late tick is what delays a retransmission
+#     timer of a test case.
+#
+#     Usage: Ems EmsLogBench.tcl [Count] [Ticks] [PerTick] [Period]
+#
+
+proc Fail {Message} {
+  puts "BENCH FAIL: $Message"
+  exit 1
+}
+
+set Count   [expr {[llength $argv] > 0 ? [lindex $argv 0] : 5000}]
+set Ticks   [expr {[llength $argv] > 1 ? [lindex $argv 1] : 200}]
+set PerTick [expr {[llength $argv] > 2 ? [lindex $argv 2] : 10}]
+set Period  [expr {[llength $argv] > 3 ? [lindex $argv 3] : 20}]
+
+set BenchGuid 5B1E2C3A-7D4F-4E6A-9B8C-0D1E2F3A4B5C
+
+proc Record {Index} {
+  global BenchGuid
+  if {[catch {RecordAssertion pass $BenchGuid "Log bench" "Index - $Index"} Result]} {
+    Fail $Result
+  }
+}
+
+proc Tick {} {
+  global Ticks PerTick Period Next Late Done Sequence
+
+  set Now [clock microseconds]
+  lappend Late [expr {$Now - $Next}]
+  for {set Index 0} {$Index < $PerTick} {incr Index} {
+    Record [incr Sequence]
+  }
+
+  if {[llength $Late] >= $Ticks} {
+    set Done 1
+    return
+  }
+
+  #
+  # The ticks are due on a fixed schedule, so a late tick does not shift
+  # the following ones
+  #
+  set Next [expr {$Next + $Period * 1000}]
+  after [expr {max (0, ($Next - [clock microseconds]) / 1000)}] Tick
+}
+
+foreach Mode {Sync Async} {
+  if {[catch {LogMode $Mode} Result]} {
+    Fail $Result
+  }
+
+  CaseGuid     $BenchGuid
+  CaseName     LogBench.$Mode
+  CaseCategory Bench
+  BeginLog
+
+  set Start [clock microseconds]
+  for {set Index 0} {$Index < $Count} {incr Index} {
+    Record $Index
+  }
+  set Queued [expr {[clock microseconds] - $Start}]
+  LogStat
+  set Written [expr {[clock microseconds] - $Start}]
+
+  set Late     {}
+  set Sequence 0
+  set Next     [expr {[clock microseconds] + $Period * 1000}]
+  after $Period Tick
+  vwait Done
+  set Stat [LogStat]
+
+  EndLog
+
+  set Late [lsort -integer $Late]
+  set P99  [lindex $Late [expr {int ([llength $Late] * 0.99)}]]
+
+  puts [format "BENCH %-5s: %.0f assertions/s recorded, %.0f assertions/s written" \
+          $Mode [expr {$Count * 1e6 / $Queued}] [expr {$Count * 1e6 / $Written}]]
+  puts [format "BENCH %-5s: %d ms tick, %d assertions/tick, lateness p99 %.2f ms, max %.2f ms" \
+          $Mode $Period $PerTick [expr {$P99 / 1000.0}] [expr {[lindex $Late end] / 1000.0}]]
+  puts [format "BENCH %-5s: %s" $Mode $Stat]
+}
+
+exit 0
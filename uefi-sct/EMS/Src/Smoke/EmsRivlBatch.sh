@@ -0,0 +1,83 @@
+#!/bin/sh
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsRivlBatch.sh
+#
+# Abstract:
+#
+#     Loopback test of RivlBatch, run against EmsAgentStub.py with and
+#     without RIVL_BATCH support. The agent without it must see a single
+#     RIVL_BATCH, after which EMS sends the commands one by one. Needs
+#     CAP_NET_ADMIN and CAP_NET_RAW.
+#
+#     Usage: EmsRivlBatch.sh path/to/Ems [N]
+#
+
+EMS=${1:-../Bin/Ems}
+DIR=$(dirname "$0")
+N=${2:-128}
+EMS_IF=ems-batch0
+EAS_IF=eas-batch0
+AGENT_LOG=$(mktemp)
+EMS_LOG=$(mktemp)
+
+Cleanup () {
+  [ -n "$AGENT" ] && kill "$AGENT" 2>/dev/null
+  ip link del "$EMS_IF" 2>/dev/null
+  rm -f "$AGENT_LOG" "$EMS_LOG"
+}
+trap Cleanup EXIT
+
+ip link add "$EMS_IF" type veth peer name "$EAS_IF" || exit 1
+ip link set "$EMS_IF" up
+ip link set "$EAS_IF" up
+
+#
+# Run the test against the agent started with the given options, and check
+# how many RIVL_BATCH messages it got
+#
+Run () {
+  Expect=$1
+  shift
+  python3 "$DIR/EmsAgentStub.py" "$@" "$EAS_IF" > "$AGENT_LOG" &
+  AGENT=$!
+  timeout 120 "$EMS" "$DIR/EmsRivlBatch.tcl" "$(cat /sys/class/net/$EMS_IF/ifindex)" "$EMS_IF" "$N" 2> "$EMS_LOG" > /dev/null
+  Status=$?
+  kill "$AGENT" 2>/dev/null
+  wait "$AGENT" 2>/dev/null
+  AGENT=
+
+  cat "$EMS_LOG"
+  if [ "$Status" -ne 0 ] || ! grep -q "^BATCH PASS" "$EMS_LOG"; then
+    return 1
+  fi
+
+  Batches=$(grep -c "recv (RIVL_BATCH " "$AGENT_LOG")
+  if [ "$Expect" = "one" ] && [ "$Batches" -ne 1 ]; then
+    echo "BATCH FAIL: $Batches RIVL_BATCH messages sent to an agent without the batch"
+    return 1
+  fi
+  if [ "$Expect" = "some" ] && [ "$Batches" -eq 0 ]; then
+    echo "BATCH FAIL: no RIVL_BATCH message sent"
+    return 1
+  fi
+  return 0
+}
+
+echo "agent with RIVL_BATCH:"
+Run some || exit 1
+echo "agent without RIVL_BATCH:"
+Run one --no-batch || exit 1
@@ -0,0 +1,143 @@
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsRivlBatch.tcl
+#
+# Abstract:
+#
+#     Test of RivlBatch against EmsAgentStub.py, which fails the RIVL
+#     commands naming R_Fail...: a batch mixing type, variable and Exec
+#     commands, a batch failing in the middle, whose first failure must be
+#     reported with its own ack, and the time to set up N variables one by
+#     one and in a batch. The same results are expected from an agent
+#     without RIVL_BATCH, the commands are then sent one by one. The
+#     results go to stderr, apart from the messages EMS prints.
+#
+#     Usage: Ems EmsRivlBatch.tcl ifindex ifname [N]
+#
+
+proc Fail {Message} {
+  puts stderr "BATCH FAIL: $Message"
+  exit 1
+}
+
+proc Setup {Prefix N} {
+  for {set Index 0} {$Index < $N} {incr Index} {
+    UINT32 $Prefix$Index
+    SetVar $Prefix$Index $Index
+  }
+}
+
+proc Cleanup {Prefix N} {
+  for {set Index 0} {$Index < $N} {incr Index} {
+    DelVar $Prefix$Index
+  }
+}
+
+if {[llength $argv] < 2} {
+  Fail "usage: Ems EmsRivlBatch.tcl ifindex ifname \[N\]"
+}
+
+set N [expr {[llength $argv] > 2 ? [lindex $argv 2] : 128}]
+
+Interface [lindex $argv 0] [lindex $argv 1]
+
+if {[catch {OpenDev mnp} Result]} {
+  Fail $Result
+}
+
+#
+# DumpTarget lists the MAC of every target that answered the probe
+#
+CheckTarget
+set Target [string range [DumpTarget] 0 16]
+if {$Target eq ""} {
+  Fail "no agent answered the probe"
+}
+SetTargetMac $Target
+
+#
+# Mixed batch: the Exec in the middle needs its ack, so the commands queued
+# before it are flushed first
+#
+if {[catch {
+  RivlBatch {
+    Struct R_Pair {
+      UINT32  First;
+      UINT32  Second;
+    }
+    UINT32 R_Before
+    SetVar R_Before 1
+    set Exec [Exec "Smoke"]
+    UINT32 R_After
+    SetVar R_After 2
+    DelVar R_Before
+    DelVar R_After
+    DelType R_Pair
+  }
+} Result]} {
+  Fail "mixed batch: $Result"
+}
+if {[string first "Status" $Exec] != 0} {
+  Fail "mixed batch: unexpected Exec result \"$Exec\""
+}
+
+#
+# Failure mid-batch: the agent refuses the 2nd and the 4th command. The
+# first failure is reported with the log of its own ack, which names the
+# variable of the command it belongs to
+#
+if {![catch {
+  RivlBatch {
+    UINT32 R_Good
+    UINT32 R_FailFirst
+    SetVar R_Good 1
+    UINT32 R_FailSecond
+    DelVar R_Good
+  }
+} Result]} {
+  Fail "failing batch passed"
+}
+if {![regexp {^EAS: RivlBatch (\d+) command\(s\) failed, "([^"]*)" failed (\S+) refused$} \
+        $Result All Count Command Name]} {
+  Fail "failing batch: unexpected error \"$Result\""
+}
+if {$Count != 2} {
+  Fail "failing batch: $Count failures reported, 2 expected"
+}
+if {$Name ne "R_FailFirst" || ![regexp "\\m$Name\\M" $Command]} {
+  Fail "failing batch: ack of $Name reported for \"$Command\""
+}
+
+#
+# Setup time of N variables, one by one and in batches
+#
+set Start [clock microseconds]
+Setup R_Single $N
+set Single [expr {([clock microseconds] - $Start) / 1000.0}]
+Cleanup R_Single $N
+
+set Start [clock microseconds]
+if {[catch {RivlBatch [list Setup R_Batched $N]} Result]} {
+  Fail "setup batch: $Result"
+}
+set Batched [expr {([clock microseconds] - $Start) / 1000.0}]
+Cleanup R_Batched $N
+
+puts stderr [format "BATCH N %d: one by one %.1f ms, batched %.1f ms" $N $Single $Batched]
+
+CloseDev mnp
+puts stderr "BATCH PASS"
+exit 0
@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsRivlBench.sh
+#
+# Abstract:
+#
+#     Latency of RIVL variable operations for 1000 to 8000 variables. EMS
+#     talks to EmsAgentStub.py over a veth pair, so the SetVar round trip
+#     is the EMS side and the link only. Needs CAP_NET_ADMIN and CAP_NET_RAW.
+#
+#     To measure the agent tables too, e.g. SCT in QEMU on a tap, give the
+#     interface instead.
+#
+#     Usage: EmsRivlBench.sh path/to/Ems [ifname] [Count]
+#
+
+EMS=${1:-../Bin/Ems}
+DIR=$(dirname "$0")
+COUNT=${3:-500}
+EMS_IF=ems-rivl0
+EAS_IF=eas-rivl0
+
+Run () {
+  timeout 1800 "$EMS" "$DIR/EmsRivlBench.tcl" "$(cat /sys/class/net/$1/ifindex)" "$1" "$COUNT" \
+    1000 2000 4000 8000
+}
+
+if [ -n "$2" ]; then
+  Run "$2"
+  exit $?
+fi
+
+Cleanup () {
+  [ -n "$AGENT" ] && kill "$AGENT" 2>/dev/null
+  ip link del "$EMS_IF" 2>/dev/null
+}
+trap Cleanup EXIT
+
+ip link add "$EMS_IF" type veth peer name "$EAS_IF" || exit 1
+ip link set "$EMS_IF" up
+ip link set "$EAS_IF" up
+
+python3 "$DIR/EmsAgentStub.py" "$EAS_IF" > /dev/null &
+AGENT=$!
+
+Run "$EMS_IF"
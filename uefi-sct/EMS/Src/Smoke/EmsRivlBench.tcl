@@ -0,0 +1,103 @@
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsRivlBench.tcl
+#
+# Abstract:
+#
+#     Latency of RIVL variable operations as the number of variables grows.
+#     For each N, N UINT32 variables are declared on EMS and the agent, then
+#     Count SetVar round trips and Count local Sizeof/Typeof lookups are
+#     timed, and the variables are deleted again.
+#
+#     Usage: Ems EmsRivlBench.tcl ifindex ifname [Count] [N ...]
+#
+
+proc Fail {Message} {
+  puts "BENCH FAIL: $Message"
+  exit 1
+}
+
+proc PerOp {Start Count} {
+  return [expr {([clock microseconds] - $Start) / double ($Count)}]
+}
+
+if {[llength $argv] < 2} {
+  Fail "usage: Ems EmsRivlBench.tcl ifindex ifname \[Count\] \[N ...\]"
+}
+
+set Count [expr {[llength $argv] > 2 ? [lindex $argv 2] : 500}]
+set Sizes [expr {[llength $argv] > 3 ? [lrange $argv 3 end] : {1000 2000 4000 8000}}]
+
+Interface [lindex $argv 0] [lindex $argv 1]
+
+if {[catch {OpenDev mnp} Result]} {
+  Fail $Result
+}
+
+#
+# DumpTarget lists the MAC of every target that answered the probe
+#
+CheckTarget
+set Target [string range [DumpTarget] 0 16]
+if {$Target eq ""} {
+  Fail "no agent answered the probe"
+}
+SetTargetMac $Target
+
+foreach N $Sizes {
+  set Start [clock microseconds]
+  for {set Index 0} {$Index < $N} {incr Index} {
+    if {[catch {UINT32 R_Bench$Index} Result]} {
+      Fail $Result
+    }
+  }
+  set Declare [PerOp $Start $N]
+
+  #
+  # The names are spread over the whole table, the last declared ones are
+  # the slowest for a list
+  #
+  set Start [clock microseconds]
+  for {set Index 0} {$Index < $Count} {incr Index} {
+    if {[catch {SetVar R_Bench[expr {$N - 1 - $Index % $N}] $Index} Result]} {
+      Fail $Result
+    }
+  }
+  set Remote [PerOp $Start $Count]
+
+  set Start [clock microseconds]
+  for {set Index 0} {$Index < $Count} {incr Index} {
+    set Name R_Bench[expr {$N - 1 - $Index % $N}]
+    if {[Sizeof $Name] != 4 || [Typeof $Name] ne "UINT32"} {
+      Fail "lookup of $Name"
+    }
+  }
+  set Local [PerOp $Start $Count]
+
+  set Start [clock microseconds]
+  for {set Index 0} {$Index < $N} {incr Index} {
+    if {[catch {DelVar R_Bench$Index} Result]} {
+      Fail $Result
+    }
+  }
+  set Delete [PerOp $Start $N]
+
+  puts [format "BENCH N %5d: declare %.1f us, SetVar %.1f us, Sizeof+Typeof %.1f us, DelVar %.1f us" \
+          $N $Declare $Remote $Local $Delete]
+}
+
+CloseDev mnp
+exit 0
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsSmoke.sh
+#
+# Abstract:
+#
+#     Loopback smoke test of the Linux build of EMS. EMS and the stand-in
+#     agent are connected by a veth pair, so no target machine is needed.
+#     Needs CAP_NET_ADMIN and CAP_NET_RAW.
+#
+#     Usage: EmsSmoke.sh path/to/Ems
+#
+
+EMS=${1:-../Bin/Ems}
+DIR=$(dirname "$0")
+EMS_IF=ems-smoke0
+EAS_IF=eas-smoke0
+
+Cleanup () {
+  [ -n "$AGENT" ] && kill "$AGENT" 2>/dev/null
+  ip link del "$EMS_IF" 2>/dev/null
+}
+trap Cleanup EXIT
+
+ip link add "$EMS_IF" type veth peer name "$EAS_IF" || exit 1
+ip link set "$EMS_IF" up
+ip link set "$EAS_IF" up
+
+python3 "$DIR/EmsAgentStub.py" "$EAS_IF" &
+AGENT=$!
+
+timeout 60 "$EMS" "$DIR/EmsSmoke.tcl" "$(cat /sys/class/net/$EMS_IF/ifindex)" "$EMS_IF"
@@ -0,0 +1,61 @@
+#
+#  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+#  Copyright (c) 2010, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+#
+# Module Name:
+#
+#     EmsSmoke.tcl
+#
+# Abstract:
+#
+#     Smoke test of EMS against EmsAgentStub.py: probe the agent over the MNP
+#     link, and run a RIVL round trip.
+#
+#     Usage: Ems EmsSmoke.tcl ifindex ifname
+#
+
+proc Fail {Message} {
+  puts "SMOKE FAIL: $Message"
+  exit 1
+}
+
+if {[llength $argv] != 2} {
+  Fail "usage: Ems EmsSmoke.tcl ifindex ifname"
+}
+
+Interface [lindex $argv 0] [lindex $argv 1]
+
+if {[catch {OpenDev mnp} Result]} {
+  Fail $Result
+}
+
+#
+# DumpTarget lists the MAC of every target that answered the probe
+#
+CheckTarget
+set Target [string range [DumpTarget] 0 16]
+if {$Target eq ""} {
+  Fail "no agent answered the probe"
+}
+SetTargetMac $Target
+puts "target: $Target"
+
+if {[catch {Exec "Smoke"} Result]} {
+  Fail $Result
+}
+if {[string first "Status" $Result] != 0} {
+  Fail "unexpected result \"$Result\""
+}
+
+CloseDev mnp
+puts "SMOKE PASS"
+exit 0
@@ -0,0 +1,332 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2017, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  TestProfileBench.c
+
+Abstract:
+
+  Microbenchmark of the test profile library. The test profile driver must be
+  loaded before, e.g. "load TestProfile.efi".
+
+  Usage: TestProfileBench [sections] [entries]
+
+--*/
+
+#include "TestProfileBench.h"
+
+//
+// Internal functions
+//
+
+EFI_STATUS
+OpenTestProfileLibrary (
+  OUT EFI_TSL_INIT_INTERFACE              **TslInit,
+  OUT EFI_HANDLE                          *LibHandle,
+  OUT EFI_TEST_PROFILE_LIBRARY_PROTOCOL   **TestProfile
+  );
+
+UINTN
+GetElapsedTime (
+  IN EFI_TIME                             *StartTime
+  );
+
+//
+// Entry point
+//
+
+EFI_STATUS
+EFIAPI
+TestProfileBench (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  )
+{
+  EFI_STATUS                          Status;
+  UINTN                               Argc;
+  CHAR16                              **Argv;
+  UINTN                               SectionNum;
+  UINTN                               EntryNum;
+  UINTN                               SectionIndex;
+  UINTN                               EntryIndex;
+  UINTN                               Missed;
+  UINTN                               Index;
+  UINT32                              OrderNum;
+  UINT32                              MaxLength;
+  EFI_TIME                            StartTime;
+  EFI_DEVICE_PATH_PROTOCOL            *DevicePath;
+  CHAR16                              *FilePath;
+  CHAR16                              *FileName;
+  CHAR16                              Section[BENCH_MAX_STRING_LEN];
+  CHAR16                              Entry[BENCH_MAX_STRING_LEN];
+  CHAR16                              Value[BENCH_MAX_STRING_LEN];
+  EFI_HANDLE                          LibHandle;
+  EFI_TSL_INIT_INTERFACE              *TslInit;
+  EFI_TEST_PROFILE_LIBRARY_PROTOCOL   *TestProfile;
+  EFI_INI_FILE_HANDLE                 IniFile;
+
+  //
+  // Initialize libraries
+  //
+  SctShellApplicationInit (ImageHandle, SystemTable);
+
+  //
+  // Process the arguments
+  //
+  SctShellGetArguments (&Argc, &Argv);
+  SectionNum = DEFAULT_SECTION_NUM;
+  EntryNum   = DEFAULT_ENTRY_NUM;
+  if (Argc > 1) {
+    SectionNum = SctAtoi (Argv[1]);
+  }
+  if (Argc > 2) {
+    EntryNum = SctAtoi (Argv[2]);
+  }
+  if ((SectionNum == 0) || (EntryNum == 0)) {
+    SctPrint (L"Usage: TestProfileBench [sections] [entries]\n");
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // The profile is created next to this application
+  //
+  Status = SctGetFilesystemDevicePath (Argv[0], &DevicePath, &FilePath);
+  if (EFI_ERROR (Status)) {
+    SctPrint (L"Get file system device path - %r\n", Status);
+    return Status;
+  }
+
+  for (Index = SctStrLen (FilePath); Index > 0; Index --) {
+    if (FilePath[Index - 1] == L'\\') {
+      break;
+    }
+  }
+  if (Index > 0) {
+    FilePath[Index - 1] = L'\0';
+  }
+
+  FileName = SctPoolPrint (L"%s\\%s", FilePath, BENCH_PROFILE_NAME);
+  if (FileName == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = OpenTestProfileLibrary (&TslInit, &LibHandle, &TestProfile);
+  if (EFI_ERROR (Status)) {
+    SctPrint (L"Open test profile library - %r\n", Status);
+    tBS->FreePool (FileName);
+    return Status;
+  }
+
+  SctPrint (
+    L"Test profile: %d sections x %d entries in %s\n",
+    SectionNum,
+    EntryNum,
+    FileName
+    );
+
+  //
+  // Build the profile. An existing profile is reused, its values are updated.
+  //
+  tRT->GetTime (&StartTime, NULL);
+
+  Status = TestProfile->EfiIniCreate (TestProfile, DevicePath, FileName, &IniFile);
+  if (Status == EFI_ACCESS_DENIED) {
+    Status = TestProfile->EfiIniOpen (TestProfile, DevicePath, FileName, &IniFile);
+  }
+  if (EFI_ERROR (Status)) {
+    SctPrint (L"Create profile - %r\n", Status);
+    goto Done;
+  }
+
+  for (SectionIndex = 0; SectionIndex < SectionNum; SectionIndex ++) {
+    SctSPrint (Section, sizeof (Section), L"Section%d", SectionIndex);
+    for (EntryIndex = 0; EntryIndex < EntryNum; EntryIndex ++) {
+      SctSPrint (Entry, sizeof (Entry), L"Entry%d", EntryIndex);
+      SctSPrint (Value, sizeof (Value), L"Value%d.%d", SectionIndex, EntryIndex);
+      IniFile->SetString (IniFile, Section, Entry, Value);
+    }
+  }
+  SctPrint (L"  Set      : %d ms\n", GetElapsedTime (&StartTime));
+
+  tRT->GetTime (&StartTime, NULL);
+  Status = TestProfile->EfiIniClose (TestProfile, IniFile);
+  SctPrint (L"  Flush    : %d ms - %r\n", GetElapsedTime (&StartTime), Status);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  //
+  // Load it again and query every entry
+  //
+  tRT->GetTime (&StartTime, NULL);
+  Status = TestProfile->EfiIniOpen (TestProfile, DevicePath, FileName, &IniFile);
+  SctPrint (L"  Load     : %d ms - %r\n", GetElapsedTime (&StartTime), Status);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Missed = 0;
+  tRT->GetTime (&StartTime, NULL);
+  for (SectionIndex = 0; SectionIndex < SectionNum; SectionIndex ++) {
+    SctSPrint (Section, sizeof (Section), L"Section%d", SectionIndex);
+    for (EntryIndex = 0; EntryIndex < EntryNum; EntryIndex ++) {
+      SctSPrint (Entry, sizeof (Entry), L"Entry%d", EntryIndex);
+      MaxLength = BENCH_MAX_STRING_LEN;
+      Status = IniFile->GetString (IniFile, Section, Entry, Value, &MaxLength);
+      if (EFI_ERROR (Status)) {
+        Missed ++;
+      }
+    }
+  }
+  SctPrint (L"  Get      : %d ms, %d missed\n", GetElapsedTime (&StartTime), Missed);
+
+  Missed = 0;
+  tRT->GetTime (&StartTime, NULL);
+  for (SectionIndex = 0; SectionIndex < SectionNum; SectionIndex ++) {
+    SctSPrint (Section, sizeof (Section), L"Section%d", SectionIndex);
+    IniFile->GetOrderNum (IniFile, Section, &OrderNum);
+    for (EntryIndex = 0; EntryIndex < EntryNum; EntryIndex ++) {
+      SctSPrint (Entry, sizeof (Entry), L"Entry%d", EntryIndex);
+      MaxLength = BENCH_MAX_STRING_LEN;
+      Status = IniFile->GetStringByOrder (IniFile, 0, Section, Entry, Value, &MaxLength);
+      if (EFI_ERROR (Status) || (OrderNum != 1)) {
+        Missed ++;
+      }
+    }
+  }
+  SctPrint (L"  GetOrder : %d ms, %d missed\n", GetElapsedTime (&StartTime), Missed);
+
+  //
+  // Nothing is modified, close does not write it back
+  //
+  tRT->GetTime (&StartTime, NULL);
+  Status = TestProfile->EfiIniClose (TestProfile, IniFile);
+  SctPrint (L"  Close    : %d ms - %r\n", GetElapsedTime (&StartTime), Status);
+
+Done:
+  TslInit->Close (TslInit, LibHandle);
+  tBS->FreePool (FileName);
+  return Status;
+}
+
+//
+// Internal functions implementation
+//
+
+EFI_STATUS
+OpenTestProfileLibrary (
+  OUT EFI_TSL_INIT_INTERFACE              **TslInit,
+  OUT EFI_HANDLE                          *LibHandle,
+  OUT EFI_TEST_PROFILE_LIBRARY_PROTOCOL   **TestProfile
+  )
+/*++
+
+Routine Description:
+
+  Find the test profile library among the loaded test support libraries and
+  open it.
+
+--*/
+{
+  EFI_STATUS              Status;
+  UINTN                   NoHandles;
+  EFI_HANDLE              *HandleBuffer;
+  UINTN                   Index;
+  EFI_TSL_INIT_INTERFACE  *Interface;
+  VOID                    *PrivateInterface;
+
+  Status = tBS->LocateHandleBuffer (
+                 ByProtocol,
+                 &gEfiTslInitInterfaceGuid,
+                 NULL,
+                 &NoHandles,
+                 &HandleBuffer
+                 );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < NoHandles; Index ++) {
+    Status = tBS->HandleProtocol (
+                   HandleBuffer[Index],
+                   &gEfiTslInitInterfaceGuid,
+                   (VOID **) &Interface
+                   );
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    if (SctCompareGuid (&Interface->LibraryGuid, &gEfiTestProfileLibraryGuid) != 0) {
+      Status = EFI_NOT_FOUND;
+      continue;
+    }
+
+    *LibHandle = NULL;
+    Status = Interface->Open (Interface, LibHandle, &PrivateInterface);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Status = tBS->HandleProtocol (
+                   *LibHandle,
+                   &gEfiTestProfileLibraryGuid,
+                   (VOID **) TestProfile
+                   );
+    if (EFI_ERROR (Status)) {
+      Interface->Close (Interface, *LibHandle);
+      break;
+    }
+
+    *TslInit = Interface;
+    break;
+  }
+
+  tBS->FreePool (HandleBuffer);
+  return Status;
+}
+
+UINTN
+GetElapsedTime (
+  IN EFI_TIME                             *StartTime
+  )
+/*++
+
+Routine Description:
+
+  Get the elapsed time in milliseconds since StartTime. The resolution is the
+  one of the real time clock.
+
+--*/
+{
+  EFI_TIME  EndTime;
+  UINTN     Start;
+  UINTN     End;
+
+  tRT->GetTime (&EndTime, NULL);
+
+  Start = ((StartTime->Hour * 60 + StartTime->Minute) * 60 + StartTime->Second) * 1000 +
+          StartTime->Nanosecond / 1000000;
+  End   = ((EndTime.Hour * 60 + EndTime.Minute) * 60 + EndTime.Second) * 1000 +
+          EndTime.Nanosecond / 1000000;
+
+  if (End < Start) {
+    End += 24 * 60 * 60 * 1000;
+  }
+
+  return End - Start;
+}
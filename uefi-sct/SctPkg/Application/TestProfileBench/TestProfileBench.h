@@ -0,0 +1,61 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2017, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+Module Name:
+
+  TestProfileBench.h
+
+Abstract:
+
+  Microbenchmark of the test profile library.
+
+--*/
+
+#ifndef _EFI_TEST_PROFILE_BENCH_H_
+#define _EFI_TEST_PROFILE_BENCH_H_
+
+//
+// Includes
+//
+
+#include "SctLib.h"
+#include "EfiTest.h"
+
+#include EFI_TEST_PROTOCOL_DEFINITION(TslInit)
+#include EFI_TEST_PROTOCOL_DEFINITION(TestProfileLibrary)
+
+//
+// Global definitions
+//
+
+#define DEFAULT_SECTION_NUM       500
+#define DEFAULT_ENTRY_NUM         100       // 50k entries by default
+
+#define BENCH_PROFILE_NAME        L"TestProfileBench.ini"
+#define BENCH_MAX_STRING_LEN      64
+
+//
+// Entry point
+//
+
+EFI_STATUS
+EFIAPI
+TestProfileBench (
+  IN EFI_HANDLE         ImageHandle,
+  IN EFI_SYSTEM_TABLE   *SystemTable
+  );
+
+#endif
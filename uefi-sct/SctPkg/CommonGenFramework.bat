@@ -227,6 +227,8 @@ rem *********************************************
 call :CopyDependency EfiCompliant
 call :CopyDependency ProtocolHandlerServices
 call :CopyDependency ImageServices
+call :CopyDependency VariableServices
+call :CopyDependency BlockIo2
 call :CopyDependency Decompress
 call :CopyDependency DeviceIo
 call :CopyDependency Ebc
@@ -259,6 +259,8 @@ then
     CopyDependency EfiCompliant
     CopyDependency ProtocolHandlerServices
     CopyDependency ImageServices
+    CopyDependency VariableServices
+    CopyDependency BlockIo2
     CopyDependency Decompress
     CopyDependency DeviceIo
     CopyDependency Ebc
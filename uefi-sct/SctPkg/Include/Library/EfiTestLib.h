@@ -299,6 +299,97 @@ Returns:
 --*/
 ;
 
+//
+// Readiness wait for devices that need time after a reset or a user prompt
+//
+
+//
+// Default ceiling of EfiTestWaitForReady, in microseconds. It is the fixed
+// stall the tests used before they polled the device.
+//
+#define EFI_TEST_READY_TIMEOUT            5000000
+
+//
+// Device specific readiness probe, returns TRUE when the device is ready
+//
+typedef
+BOOLEAN
+(EFIAPI *EFI_TEST_READY_PROBE) (
+  IN VOID                                *Context
+  );
+
+EFI_STATUS
+EFIAPI
+EfiTestWaitForReady (
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL  *StandardLib OPTIONAL,
+  IN CHAR16                              *What,
+  IN EFI_TEST_READY_PROBE                Probe,
+  IN VOID                                *Context,
+  IN UINTN                               Timeout
+  )
+/*++
+
+Routine Description:
+
+  Wait until a device is ready. The probe is polled with an interval that
+  starts at 1 millisecond and doubles up to 100 milliseconds, so a device
+  that is ready at once costs nothing and a slow one is not hammered. The
+  time spent waiting is recorded in the log.
+
+Arguments:
+
+  StandardLib             - The pointer to the standard test library protocol,
+                            NULL if nothing is to be recorded.
+  What                    - The name of the wait in the log.
+  Probe                   - The device specific readiness probe.
+  Context                 - The context of the probe.
+  Timeout                 - The ceiling of the wait in microseconds, usually
+                            EFI_TEST_READY_TIMEOUT.
+
+Returns:
+
+  EFI_SUCCESS             - The device is ready.
+  EFI_INVALID_PARAMETER   - Probe is NULL.
+  EFI_TIMEOUT             - The device is not ready within Timeout.
+
+--*/
+;
+
+//
+// Context of EfiTestInputReadyProbe
+//
+typedef struct {
+  EFI_EVENT                              Event;
+  UINTN                                  Pending;
+} EFI_TEST_INPUT_PROBE_CONTEXT;
+
+BOOLEAN
+EFIAPI
+EfiTestInputReadyProbe (
+  IN VOID                                *Context
+  )
+/*++
+
+Routine Description:
+
+  Readiness probe for a tester's input, such as a key press or a pointer
+  action. The wait event of the input device is checked without reading the
+  input, and the input is taken as complete once it has stayed pending for
+  several polls, so that a key release or the rest of a burst is not left to
+  arrive in the middle of the test.
+
+Arguments:
+
+  Context                 - An EFI_TEST_INPUT_PROBE_CONTEXT, with Event set to
+                            the wait event of the device and Pending to 0.
+
+Returns:
+
+  TRUE if the input is complete.
+
+--*/
+;
+
 //
 // GUIDs for special usage
 //
@@ -1757,6 +1757,30 @@ PassiveTestContextDelete (
   IN CHAR16                                    *FileName
   );
 
+EFI_STATUS
+PassiveTestContextSync (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Flush the passive test context records kept in memory down to the context
+  file and drop them. Call it before a reset, or before an other image may
+  change the file; the next access loads the file again.
+
+Arguments:
+
+  None
+
+Returns:
+
+  EFI_SUCCESS - The records are flushed or none is in memory.
+  Others      - The flush failed, the records are dropped anyway.
+
+--*/
+;
+
 EFI_STATUS
 EntsNetworkServiceBindingGetControllerHandle (
   IN  EFI_GUID                 *ProtocolGuid,
@@ -68,6 +68,7 @@ typedef UINT32 EFI_TEST_ATTRIBUTE;
 #define EFI_TEST_CASE_MANUAL            0x01
 #define EFI_TEST_CASE_DESTRUCTIVE       0x02
 #define EFI_TEST_CASE_RESET_REQUIRED    0x04
+#define EFI_TEST_CASE_WARM_RESET        0x08
 
 //
 // EFI Test Assertion Types
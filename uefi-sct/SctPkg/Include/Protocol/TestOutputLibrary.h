@@ -47,7 +47,12 @@ Abstract:
 #define EFI_TEST_OUTPUT_LIBRARY_GUID        \
   { 0x8bfeab85, 0x83cf, 0x4c7b, {0x9e, 0xcd, 0xcf, 0x14, 0x28, 0x87, 0xe7, 0x12 }}
 
-#define EFI_TEST_OUTPUT_LIBRARY_REVISION    0x00010000
+#define EFI_TEST_OUTPUT_LIBRARY_REVISION    0x00010001
+
+//
+// The first revision with the WriteData interface
+//
+#define EFI_TEST_OUTPUT_LIBRARY_REVISION_WRITE_DATA   0x00010001
 
 //
 // Forward reference for pure ANSI compatibility
@@ -152,6 +157,41 @@ Returns:
 --*/
 ;
 
+//
+// EFI Test Output Library Protocol API - WriteData
+//
+typedef
+EFI_STATUS
+(EFIAPI *EFI_TOL_WRITE_DATA) (
+  IN  EFI_TEST_OUTPUT_LIBRARY_PROTOCOL          *This,
+  IN  EFI_FILE                                  *FileHandle,
+  IN  UINTN                                     BufferSize,
+  IN  VOID                                      *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Write raw data to the output file. Only available since the revision
+  EFI_TEST_OUTPUT_LIBRARY_REVISION_WRITE_DATA.
+
+Arguments:
+
+  This          - Test output library protocol instance.
+
+  FileHandle    - Handle for the opened file.
+
+  BufferSize    - Size of the data in bytes.
+
+  Buffer        - Data to be written.
+
+Returns:
+
+  EFI_SUCCESS if everything is correct.
+
+--*/
+;
+
 //
 // EFI Test Output Library Protocol
 //
@@ -163,6 +203,7 @@ struct _EFI_TEST_OUTPUT_LIBRARY_PROTOCOL {
   EFI_TOL_OPEN                          Open;
   EFI_TOL_CLOSE                         Close;
   EFI_TOL_WRITE                         Write;
+  EFI_TOL_WRITE_DATA                    WriteData;
 };
 
 //
@@ -22,6 +22,7 @@
 #include EFI_PROTOCOL_DEFINITION (SimpleFileSystem)
 #include EDK_PROTOCOL_DEFINITION (FileInfo)
 #include <Library/UefiBootServicesTableLib.h>
+#include <UEFI/Protocol/TimeStamp.h>
 
 
 //
@@ -1039,6 +1040,54 @@ SctStrTrim (
   IN     CHAR16   c
   );
 
+//
+// Timer API
+//
+
+typedef struct {
+  EFI_TIMESTAMP_PROTOCOL        *TimeStamp;
+  UINT64                        EndValue;
+  UINTN                         Frequency;
+  UINTN                         Shift;
+  UINT64                        Overhead;
+} SCT_TIMER;
+
+EFI_STATUS
+SctTimerInit (
+  OUT SCT_TIMER                 *Timer
+  );
+
+UINT64
+SctTimerRead (
+  IN SCT_TIMER                  *Timer
+  );
+
+UINT64
+SctTimerElapsed (
+  IN SCT_TIMER                  *Timer,
+  IN UINT64                     Start,
+  IN UINT64                     End
+  );
+
+UINT64
+SctTimerTicksToNs (
+  IN SCT_TIMER                  *Timer,
+  IN UINT64                     Ticks
+  );
+
+VOID
+SctTimerSortSamples (
+  IN OUT UINT64                 *Samples,
+  IN UINTN                      Count
+  );
+
+UINT64
+SctTimerPercentile (
+  IN UINT64                     *Samples,
+  IN UINTN                      Count,
+  IN UINTN                      Percent
+  );
+
 //
 // Unicode API
 //
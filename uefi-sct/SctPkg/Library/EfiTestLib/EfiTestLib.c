@@ -895,3 +895,97 @@ CheckBBTestCanRunAndRecordAssertion (
 }
 
 #endif
+
+
+//
+// Poll interval bounds of EfiTestWaitForReady, in microseconds
+//
+#define READY_POLL_MIN_INTERVAL   1000
+#define READY_POLL_MAX_INTERVAL   100000
+
+//
+// Polls a tester's input stays pending before it is taken as complete, about
+// half a second once the poll interval is at its maximum
+//
+#define INPUT_SETTLE_POLLS        5
+
+EFI_STATUS
+EFIAPI
+EfiTestWaitForReady (
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL  *StandardLib OPTIONAL,
+  IN CHAR16                              *What,
+  IN EFI_TEST_READY_PROBE                Probe,
+  IN VOID                                *Context,
+  IN UINTN                               Timeout
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Waited;
+  UINTN       Interval;
+
+  if (Probe == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Waited   = 0;
+  Interval = READY_POLL_MIN_INTERVAL;
+  Status   = EFI_SUCCESS;
+
+  while (!Probe (Context)) {
+    if (Waited >= Timeout) {
+      Status = EFI_TIMEOUT;
+      break;
+    }
+
+    //
+    // Back off, but never sleep past the ceiling
+    //
+    if (Interval > Timeout - Waited) {
+      Interval = Timeout - Waited;
+    }
+    gtBS->Stall (Interval);
+    Waited += Interval;
+
+    Interval *= 2;
+    if (Interval > READY_POLL_MAX_INTERVAL) {
+      Interval = READY_POLL_MAX_INTERVAL;
+    }
+  }
+
+  if (StandardLib != NULL) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\n%s: waited %d ms of %d ms, %r",
+                   What,
+                   Waited / 1000,
+                   Timeout / 1000,
+                   Status
+                   );
+  }
+
+  return Status;
+}
+
+BOOLEAN
+EFIAPI
+EfiTestInputReadyProbe (
+  IN VOID                                *Context
+  )
+{
+  EFI_TEST_INPUT_PROBE_CONTEXT  *Input;
+
+  Input = (EFI_TEST_INPUT_PROBE_CONTEXT *)Context;
+
+  //
+  // CheckEvent runs the notify function of the wait event again, so the
+  // event is still signaled for a later WaitForEvent while input is pending
+  //
+  if (gtBS->CheckEvent (Input->Event) != EFI_SUCCESS) {
+    Input->Pending = 0;
+    return FALSE;
+  }
+
+  Input->Pending++;
+  return (BOOLEAN)(Input->Pending > INPUT_SETTLE_POLLS);
+}
@@ -0,0 +1,262 @@
+/** @file
+
+  Copyright 2006 - 2016 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2016, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+Module Name:
+
+  Timer.c
+
+Abstract:
+
+  Interval timing on top of the Timestamp Protocol, and the percentiles of
+  the timed samples
+
+--*/
+
+#include "SctLibInternal.h"
+
+#define SCT_TIMER_CALIBRATE_TIMES   16
+
+STATIC EFI_GUID mSctTimeStampProtocolGuid = EFI_TIMESTAMP_PROTOCOL_GUID;
+
+/*++
+
+Routine Description:
+
+  Locate the Timestamp Protocol and prepare Timer for converting its ticks.
+
+Arguments:
+
+  Timer           - The timer to initialize.
+
+Returns:
+
+  EFI_SUCCESS     - The timer is ready.
+  EFI_UNSUPPORTED - The protocol reports a zero frequency.
+  Other           - The protocol is not present or failed.
+
+--*/
+EFI_STATUS
+SctTimerInit (
+  OUT SCT_TIMER                 *Timer
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_TIMESTAMP_PROPERTIES      Properties;
+  UINTN                         Index;
+  UINT64                        Start;
+  UINT64                        Ticks;
+
+  SctZeroMem (Timer, sizeof (SCT_TIMER));
+
+  Status = tBS->LocateProtocol (
+                  &mSctTimeStampProtocolGuid,
+                  NULL,
+                  (VOID **) &Timer->TimeStamp
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = Timer->TimeStamp->GetProperties (&Properties);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (Properties.Frequency == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Keep the frequency a UINTN divisor
+  //
+  Timer->EndValue = Properties.EndValue;
+  Timer->Shift    = 0;
+  while (SctRShiftU64 (Properties.Frequency, Timer->Shift) > 0xFFFFFFFF) {
+    Timer->Shift++;
+  }
+  Timer->Frequency = (UINTN) SctRShiftU64 (Properties.Frequency, Timer->Shift);
+
+  //
+  // The cheapest back-to-back read is the cost of reading the timer
+  //
+  Timer->Overhead = (UINT64) -1;
+  for (Index = 0; Index < SCT_TIMER_CALIBRATE_TIMES; Index++) {
+    Start = SctTimerRead (Timer);
+    Ticks = SctTimerElapsed (Timer, Start, SctTimerRead (Timer));
+    if (Ticks < Timer->Overhead) {
+      Timer->Overhead = Ticks;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/*++
+
+Routine Description:
+
+  Read the current tick count of the timer.
+
+Arguments:
+
+  Timer           - A timer initialized by SctTimerInit.
+
+Returns:
+
+  The current tick count.
+
+--*/
+UINT64
+SctTimerRead (
+  IN SCT_TIMER                  *Timer
+  )
+{
+  return Timer->TimeStamp->GetTimestamp ();
+}
+
+/*++
+
+Routine Description:
+
+  Get the ticks from Start to End. The counter wraps to zero after
+  EndValue, so End may be less than Start.
+
+Arguments:
+
+  Timer           - A timer initialized by SctTimerInit.
+  Start           - The tick count at the start of the interval.
+  End             - The tick count at the end of the interval.
+
+Returns:
+
+  The ticks of the interval.
+
+--*/
+UINT64
+SctTimerElapsed (
+  IN SCT_TIMER                  *Timer,
+  IN UINT64                     Start,
+  IN UINT64                     End
+  )
+{
+  if (End >= Start) {
+    return End - Start;
+  }
+  return (Timer->EndValue - Start) + End + 1;
+}
+
+/*++
+
+Routine Description:
+
+  Convert ticks of the timer to nanoseconds.
+
+Arguments:
+
+  Timer           - A timer initialized by SctTimerInit.
+  Ticks           - The ticks to convert.
+
+Returns:
+
+  The nanoseconds.
+
+--*/
+UINT64
+SctTimerTicksToNs (
+  IN SCT_TIMER                  *Timer,
+  IN UINT64                     Ticks
+  )
+{
+  UINTN                         Remainder;
+  UINT64                        Ns;
+
+  Ticks = SctRShiftU64 (Ticks, Timer->Shift);
+  Ns    = SctMultU64x32 (SctDivU64x32 (Ticks, Timer->Frequency, &Remainder), 1000000000);
+  Ns   += SctDivU64x32 (SctMultU64x32 ((UINT64) Remainder, 1000000000), Timer->Frequency, NULL);
+
+  return Ns;
+}
+
+/*++
+
+Routine Description:
+
+  Sort timed samples in ascending order, for SctTimerPercentile.
+
+Arguments:
+
+  Samples         - The samples, in ticks or in nanoseconds.
+  Count           - The number of samples.
+
+Returns:
+
+  None
+
+--*/
+VOID
+SctTimerSortSamples (
+  IN OUT UINT64                 *Samples,
+  IN UINTN                      Count
+  )
+{
+  UINTN                         Gap;
+  UINTN                         IndexI;
+  UINTN                         IndexJ;
+  UINT64                        Value;
+
+  for (Gap = Count / 2; Gap > 0; Gap /= 2) {
+    for (IndexI = Gap; IndexI < Count; IndexI++) {
+      Value = Samples[IndexI];
+      for (IndexJ = IndexI; IndexJ >= Gap && Samples[IndexJ - Gap] > Value; IndexJ -= Gap) {
+        Samples[IndexJ] = Samples[IndexJ - Gap];
+      }
+      Samples[IndexJ] = Value;
+    }
+  }
+}
+
+/*++
+
+Routine Description:
+
+  Get a percentile of sorted samples by the nearest rank.
+
+Arguments:
+
+  Samples         - The samples sorted by SctTimerSortSamples.
+  Count           - The number of samples, at least one.
+  Percent         - The percentile, 0 - 100.
+
+Returns:
+
+  The sample of the percentile, in the unit of Samples.
+
+--*/
+UINT64
+SctTimerPercentile (
+  IN UINT64                     *Samples,
+  IN UINTN                      Count,
+  IN UINTN                      Percent
+  )
+{
+  UINTN                         Index;
+
+  Index = (Count * Percent + 99) / 100;
+  if (Index > 0) {
+    Index--;
+  }
+
+  return Samples[Index];
+}
@@ -375,3 +375,9 @@ EFI_GUID gMemoryAllocationServicesBBTestFunctionAssertionGuid075 = EFI_TEST_MEMO
 
 EFI_GUID gMemoryAllocationServicesBBTestFunctionAssertionGuid076 = EFI_TEST_MEMORYALLOCATIONSERVICESBBTESTFUNCTION_ASSERTION_076_GUID;
 
+EFI_GUID gMemoryAllocationServicesBenchmarkTestAssertionGuid001 = EFI_TEST_MEMORYALLOCATIONSERVICESBENCHMARKTEST_ASSERTION_001_GUID;
+
+EFI_GUID gMemoryAllocationServicesBenchmarkTestAssertionGuid002 = EFI_TEST_MEMORYALLOCATIONSERVICESBENCHMARKTEST_ASSERTION_002_GUID;
+
+EFI_GUID gMemoryAllocationServicesBenchmarkTestAssertionGuid003 = EFI_TEST_MEMORYALLOCATIONSERVICESBENCHMARKTEST_ASSERTION_003_GUID;
+
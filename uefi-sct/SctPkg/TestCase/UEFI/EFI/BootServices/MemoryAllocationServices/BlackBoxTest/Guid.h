@@ -892,3 +892,18 @@ extern EFI_GUID gMemoryAllocationServicesBBTestFunctionAssertionGuid075;
 
 extern EFI_GUID gMemoryAllocationServicesBBTestFunctionAssertionGuid076;
 
+#define EFI_TEST_MEMORYALLOCATIONSERVICESBENCHMARKTEST_ASSERTION_001_GUID \
+{ 0xeb625dce, 0x2772, 0x4f0b, {0xa7, 0xca, 0x11, 0x11, 0x11, 0x21, 0x63, 0xe2 }}
+
+extern EFI_GUID gMemoryAllocationServicesBenchmarkTestAssertionGuid001;
+
+#define EFI_TEST_MEMORYALLOCATIONSERVICESBENCHMARKTEST_ASSERTION_002_GUID \
+{ 0xd5f54a6f, 0x95f8, 0x48ee, {0xae, 0x08, 0x87, 0x30, 0x7b, 0xbc, 0x38, 0x56 }}
+
+extern EFI_GUID gMemoryAllocationServicesBenchmarkTestAssertionGuid002;
+
+#define EFI_TEST_MEMORYALLOCATIONSERVICESBENCHMARKTEST_ASSERTION_003_GUID \
+{ 0x37feb767, 0x192d, 0x47b6, {0xb2, 0xcc, 0xd1, 0x0e, 0xcb, 0xab, 0x1e, 0xac }}
+
+extern EFI_GUID gMemoryAllocationServicesBenchmarkTestAssertionGuid003;
+
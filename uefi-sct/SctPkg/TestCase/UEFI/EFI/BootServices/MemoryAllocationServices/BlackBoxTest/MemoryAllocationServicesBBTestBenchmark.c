@@ -0,0 +1,869 @@
+/** @file
+
+  Copyright 2006 - 2016 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2016, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  MemoryAllocationServicesBBTestBenchmark.c
+
+Abstract:
+
+  Benchmark Test Cases of Memory Allocation Boot Services
+
+  Measures the latency of AllocatePool/FreePool for 16 B - 16 MB and of
+  AllocatePages/FreePages for 4 KB - 16 MB, in BootServicesData, LoaderData
+  and RuntimeServicesData, and the latency of GetMemoryMap with the number
+  of descriptors it returns. Every call is timed on its own with the
+  Timestamp Protocol, BENCH_SAMPLES calls per series.
+
+  Each sweep runs on memory fragmented to each level N of
+  mBenchFragmentLevels: 2 * N single pages and 2 * N small pool blocks are
+  allocated and every other one is freed again, which leaves N holes of
+  each kind while the sweep runs.
+
+  Each series is reported as one message of the form
+
+    BENCH <Op> type=<Type> frag=<N> size=<Bytes> n=<Samples> p50=<ns>
+    p90=<ns> p99=<ns> max=<ns> hist=<c0>,<c1>,...,<c15>
+
+  on a single line, where bucket 0 counts calls below 128 ns, bucket i
+  counts calls of [64 << i, 128 << i) ns and the last bucket counts the
+  rest. GetMemoryMap is reported the same way with desc=<Count> in place
+  of type and size.
+
+--*/
+
+#include "SctLib.h"
+#include "MemoryAllocationServicesBBTestMain.h"
+
+#define BENCH_SAMPLES               64
+#define BENCH_HISTOGRAM_BUCKETS     16
+#define BENCH_HISTOGRAM_SHIFT       6
+#define BENCH_MAP_SLACK_PAGES       4
+#define BENCH_TEXT_SIZE             256
+
+//
+// Size classes 16 B - 16 MB. The pages sweep starts at 4 KB, below that
+// every size is one page.
+//
+STATIC UINTN mBenchPoolSizes[] = {
+  0x10, 0x40, 0x100, 0x400, 0x1000, 0x4000,
+  0x10000, 0x40000, 0x100000, 0x400000, 0x1000000
+};
+
+STATIC UINTN mBenchPagesSizes[] = {
+  0x1000, 0x4000, 0x10000, 0x40000, 0x100000, 0x400000, 0x1000000
+};
+
+STATIC UINTN mBenchFragmentLevels[] = { 0, 64, 256, 1024, 4096 };
+
+STATIC UINTN mBenchFragmentPoolSizes[] = { 24, 40, 72, 136, 264, 520, 1032 };
+
+typedef struct {
+  EFI_MEMORY_TYPE             Type;
+  CHAR16                      *Name;
+} BENCH_MEMORY_TYPE;
+
+STATIC BENCH_MEMORY_TYPE mBenchMemoryTypes[] = {
+  { EfiBootServicesData,      L"BootServicesData"    },
+  { EfiLoaderData,            L"LoaderData"          },
+  { EfiRuntimeServicesData,   L"RuntimeServicesData" }
+};
+
+//
+// The blocks kept allocated to fragment the memory
+//
+typedef struct {
+  UINTN                       Pages;
+  UINTN                       Pools;
+  EFI_PHYSICAL_ADDRESS        *PageList;
+  VOID                        **PoolList;
+} BENCH_FRAGMENT;
+
+//
+// The latencies of one series in ns
+//
+typedef struct {
+  UINTN                       Count;
+  UINT64                      Latency[BENCH_SAMPLES];
+} BENCH_SERIES;
+
+/**
+ *  Nanoseconds from Start to End, less the cost of reading the timer.
+ *  @param Timer    The timer.
+ *  @param Start    The timestamp taken before the call.
+ *  @param End      The timestamp taken after the call.
+ *  @return The cost of the call in nanoseconds.
+ */
+STATIC
+UINT64
+BenchTimerNs (
+  IN SCT_TIMER                *Timer,
+  IN UINT64                   Start,
+  IN UINT64                   End
+  )
+{
+  UINT64                      Ticks;
+
+  Ticks = SctTimerElapsed (Timer, Start, End);
+  if (Ticks > Timer->Overhead) {
+    Ticks -= Timer->Overhead;
+  } else {
+    Ticks = 0;
+  }
+
+  return SctTimerTicksToNs (Timer, Ticks);
+}
+
+
+/**
+ *  Sort the series and format its percentiles and histogram.
+ *  @param Series   The series, with at least one sample.
+ *  @param Buffer   The buffer of BufferSize bytes for the text.
+ *  @param BufferSize   The size of Buffer in bytes.
+ */
+STATIC
+VOID
+BenchFormatSeries (
+  IN OUT BENCH_SERIES         *Series,
+  OUT CHAR16                  *Buffer,
+  IN UINTN                    BufferSize
+  )
+{
+  UINTN                       Histogram[BENCH_HISTOGRAM_BUCKETS];
+  UINTN                       Index;
+  UINTN                       Bucket;
+  UINTN                       Length;
+  UINT64                      Ns;
+
+  SctTimerSortSamples (Series->Latency, Series->Count);
+
+  SctZeroMem (Histogram, sizeof (Histogram));
+  for (Index = 0; Index < Series->Count; Index++) {
+    Ns     = SctRShiftU64 (Series->Latency[Index], BENCH_HISTOGRAM_SHIFT);
+    Bucket = 0;
+    while ((Ns > 1) && (Bucket < BENCH_HISTOGRAM_BUCKETS - 1)) {
+      Ns = SctRShiftU64 (Ns, 1);
+      Bucket++;
+    }
+    Histogram[Bucket]++;
+  }
+
+  SctSPrint (
+    Buffer,
+    BufferSize,
+    L"n=%d p50=%ld p90=%ld p99=%ld max=%ld hist=%d",
+    Series->Count,
+    SctTimerPercentile (Series->Latency, Series->Count, 50),
+    SctTimerPercentile (Series->Latency, Series->Count, 90),
+    SctTimerPercentile (Series->Latency, Series->Count, 99),
+    Series->Latency[Series->Count - 1],
+    Histogram[0]
+    );
+  for (Index = 1; Index < BENCH_HISTOGRAM_BUCKETS; Index++) {
+    Length = SctStrLen (Buffer);
+    SctSPrint (
+      Buffer + Length,
+      BufferSize - Length * sizeof (CHAR16),
+      L",%d",
+      Histogram[Index]
+      );
+  }
+}
+
+
+/**
+ *  Fragment the memory with Level pages and Level pool blocks, each one
+ *  next to a freed neighbour.
+ *  @param Level      The number of pages and pool blocks to keep.
+ *  @param Fragment   The blocks kept.
+ *  @return EFI_SUCCESS   Level pages and pool blocks are kept.
+ */
+STATIC
+EFI_STATUS
+BenchFragmentCreate (
+  IN UINTN                    Level,
+  OUT BENCH_FRAGMENT          *Fragment
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       Index;
+  UINTN                       Count;
+
+  SctZeroMem (Fragment, sizeof (BENCH_FRAGMENT));
+  if (Level == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gtBS->AllocatePool (
+                   EfiBootServicesData,
+                   2 * Level * sizeof (EFI_PHYSICAL_ADDRESS),
+                   (VOID **) &Fragment->PageList
+                   );
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Status = gtBS->AllocatePool (
+                   EfiBootServicesData,
+                   2 * Level * sizeof (VOID *),
+                   (VOID **) &Fragment->PoolList
+                   );
+  if (EFI_ERROR(Status)) {
+    gtBS->FreePool (Fragment->PageList);
+    Fragment->PageList = NULL;
+    return Status;
+  }
+
+  //
+  // All blocks are taken first, otherwise a freed block is just handed
+  // out again
+  //
+  for (Count = 0; Count < 2 * Level; Count++) {
+    Status = gtBS->AllocatePages (
+                     AllocateAnyPages,
+                     EfiBootServicesData,
+                     1,
+                     &Fragment->PageList[Count]
+                     );
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+  }
+  for (Index = 0; Index < Count; Index++) {
+    if ((Index & 1) != 0) {
+      gtBS->FreePages (Fragment->PageList[Index], 1);
+    } else {
+      Fragment->PageList[Fragment->Pages++] = Fragment->PageList[Index];
+    }
+  }
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  for (Count = 0; Count < 2 * Level; Count++) {
+    Status = gtBS->AllocatePool (
+                     EfiBootServicesData,
+                     mBenchFragmentPoolSizes[Count % (sizeof (mBenchFragmentPoolSizes) / sizeof (UINTN))],
+                     &Fragment->PoolList[Count]
+                     );
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+  }
+  for (Index = 0; Index < Count; Index++) {
+    if ((Index & 1) != 0) {
+      gtBS->FreePool (Fragment->PoolList[Index]);
+    } else {
+      Fragment->PoolList[Fragment->Pools++] = Fragment->PoolList[Index];
+    }
+  }
+
+  return Status;
+}
+
+
+/**
+ *  Free the blocks kept by BenchFragmentCreate().
+ *  @param Fragment   The blocks kept.
+ *  @return EFI_SUCCESS   Every block was freed.
+ */
+STATIC
+EFI_STATUS
+BenchFragmentFree (
+  IN OUT BENCH_FRAGMENT       *Fragment
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_STATUS                  Result;
+  UINTN                       Index;
+
+  Result = EFI_SUCCESS;
+
+  for (Index = 0; Index < Fragment->Pages; Index++) {
+    Status = gtBS->FreePages (Fragment->PageList[Index], 1);
+    if (EFI_ERROR(Status)) {
+      Result = Status;
+    }
+  }
+  for (Index = 0; Index < Fragment->Pools; Index++) {
+    Status = gtBS->FreePool (Fragment->PoolList[Index]);
+    if (EFI_ERROR(Status)) {
+      Result = Status;
+    }
+  }
+
+  if (Fragment->PageList != NULL) {
+    gtBS->FreePool (Fragment->PageList);
+  }
+  if (Fragment->PoolList != NULL) {
+    gtBS->FreePool (Fragment->PoolList);
+  }
+  SctZeroMem (Fragment, sizeof (BENCH_FRAGMENT));
+
+  return Result;
+}
+
+
+/**
+ *  Time BENCH_SAMPLES allocate/free pairs of one size class.
+ *  @param Timer      The timer.
+ *  @param Pages      TRUE for AllocatePages/FreePages, FALSE for
+ *                    AllocatePool/FreePool.
+ *  @param Type       The memory type to allocate.
+ *  @param Size       The size in bytes.
+ *  @param Allocate   The latencies of the allocations.
+ *  @param Free       The latencies of the frees.
+ *  @return EFI_SUCCESS   Every block was allocated and freed.
+ */
+STATIC
+EFI_STATUS
+BenchMeasureSize (
+  IN SCT_TIMER                *Timer,
+  IN BOOLEAN                  Pages,
+  IN EFI_MEMORY_TYPE          Type,
+  IN UINTN                    Size,
+  OUT BENCH_SERIES            *Allocate,
+  OUT BENCH_SERIES            *Free
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       Index;
+  UINT64                      Start;
+  UINT64                      End;
+  EFI_PHYSICAL_ADDRESS        Address;
+  VOID                        *Buffer;
+
+  Allocate->Count = 0;
+  Free->Count     = 0;
+
+  for (Index = 0; Index < BENCH_SAMPLES; Index++) {
+    if (Pages) {
+      Start  = SctTimerRead (Timer);
+      Status = gtBS->AllocatePages (AllocateAnyPages, Type, EFI_SIZE_TO_PAGES (Size), &Address);
+      End    = SctTimerRead (Timer);
+    } else {
+      Start  = SctTimerRead (Timer);
+      Status = gtBS->AllocatePool (Type, Size, &Buffer);
+      End    = SctTimerRead (Timer);
+    }
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+    Allocate->Latency[Allocate->Count++] = BenchTimerNs (Timer, Start, End);
+
+    if (Pages) {
+      Start  = SctTimerRead (Timer);
+      Status = gtBS->FreePages (Address, EFI_SIZE_TO_PAGES (Size));
+      End    = SctTimerRead (Timer);
+    } else {
+      Start  = SctTimerRead (Timer);
+      Status = gtBS->FreePool (Buffer);
+      End    = SctTimerRead (Timer);
+    }
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+    Free->Latency[Free->Count++] = BenchTimerNs (Timer, Start, End);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+ *  Sweep the size classes, memory types and fragmentation levels.
+ *  @param StandardLib  A pointer to EFI_STANDARD_TEST_LIBRARY_PROTOCOL
+ *                      instance.
+ *  @param Pages        TRUE for AllocatePages/FreePages, FALSE for
+ *                      AllocatePool/FreePool.
+ *  @param AssertionGuid  The GUID of the clean up assertion.
+ *  @return EFI_SUCCESS Successfully.
+ */
+STATIC
+EFI_STATUS
+BenchAllocateSweep (
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL   *StandardLib,
+  IN BOOLEAN                              Pages,
+  IN EFI_GUID                             AssertionGuid
+  )
+{
+  EFI_STATUS            Status;
+  EFI_STATUS            FreeStatus;
+  EFI_TEST_ASSERTION    Result;
+  SCT_TIMER             Timer;
+  BENCH_FRAGMENT        Fragment;
+  BENCH_SERIES          *Allocate;
+  BENCH_SERIES          *Free;
+  CHAR16                *AllocateName;
+  CHAR16                *FreeName;
+  CHAR16                *Text;
+  UINTN                 *Sizes;
+  UINTN                 SizeCount;
+  UINTN                 LevelIndex;
+  UINTN                 TypeIndex;
+  UINTN                 SizeIndex;
+  UINTN                 Failed;
+
+  if (Pages) {
+    AllocateName = L"AllocatePages";
+    FreeName     = L"FreePages";
+    Sizes        = mBenchPagesSizes;
+    SizeCount    = sizeof (mBenchPagesSizes) / sizeof (UINTN);
+  } else {
+    AllocateName = L"AllocatePool";
+    FreeName     = L"FreePool";
+    Sizes        = mBenchPoolSizes;
+    SizeCount    = sizeof (mBenchPoolSizes) / sizeof (UINTN);
+  }
+
+  Status = SctTimerInit (&Timer);
+  if (EFI_ERROR(Status)) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nTimestamp Protocol not usable (%r), benchmark skipped",
+                   Status
+                   );
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The series are kept off the stack
+  //
+  Allocate = NULL;
+  Free     = NULL;
+  Text     = NULL;
+  Status = gtBS->AllocatePool (EfiBootServicesData, sizeof (BENCH_SERIES), (VOID **) &Allocate);
+  if (!EFI_ERROR(Status)) {
+    Status = gtBS->AllocatePool (EfiBootServicesData, sizeof (BENCH_SERIES), (VOID **) &Free);
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = gtBS->AllocatePool (EfiBootServicesData, BENCH_TEXT_SIZE * sizeof (CHAR16), (VOID **) &Text);
+  }
+  if (EFI_ERROR(Status)) {
+    StandardLib->RecordAssertion (
+                   StandardLib,
+                   EFI_TEST_ASSERTION_FAILED,
+                   gTestGenericFailureGuid,
+                   L"BS.AllocatePool - Allocate the benchmark buffers",
+                   L"%a:%d:Status - %r",
+                   __FILE__,
+                   (UINTN)__LINE__,
+                   Status
+                   );
+    if (Allocate != NULL) {
+      gtBS->FreePool (Allocate);
+    }
+    if (Free != NULL) {
+      gtBS->FreePool (Free);
+    }
+    return Status;
+  }
+
+  Failed     = 0;
+  FreeStatus = EFI_SUCCESS;
+
+  for (LevelIndex = 0; LevelIndex < sizeof (mBenchFragmentLevels) / sizeof (UINTN); LevelIndex++) {
+    Status = BenchFragmentCreate (mBenchFragmentLevels[LevelIndex], &Fragment);
+    if (EFI_ERROR(Status)) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\nFragmentation to %d blocks failed at %d pages, %d pool blocks (%r), sweep stopped",
+                     mBenchFragmentLevels[LevelIndex],
+                     Fragment.Pages,
+                     Fragment.Pools,
+                     Status
+                     );
+      Status = BenchFragmentFree (&Fragment);
+      if (EFI_ERROR(Status)) {
+        FreeStatus = Status;
+      }
+      break;
+    }
+
+    for (TypeIndex = 0; TypeIndex < sizeof (mBenchMemoryTypes) / sizeof (BENCH_MEMORY_TYPE); TypeIndex++) {
+      for (SizeIndex = 0; SizeIndex < SizeCount; SizeIndex++) {
+        Status = BenchMeasureSize (
+                   &Timer,
+                   Pages,
+                   mBenchMemoryTypes[TypeIndex].Type,
+                   Sizes[SizeIndex],
+                   Allocate,
+                   Free
+                   );
+        if (EFI_ERROR(Status)) {
+          //
+          // Large classes may not fit on small platforms, a failed free
+          // is counted by the assertion
+          //
+          StandardLib->RecordMessage (
+                         StandardLib,
+                         EFI_VERBOSE_LEVEL_DEFAULT,
+                         L"\r\n%s/%s type=%s frag=%d size=%d failed after %d samples (%r)",
+                         AllocateName,
+                         FreeName,
+                         mBenchMemoryTypes[TypeIndex].Name,
+                         mBenchFragmentLevels[LevelIndex],
+                         Sizes[SizeIndex],
+                         Free->Count,
+                         Status
+                         );
+          if (Allocate->Count != Free->Count) {
+            Failed++;
+          }
+          continue;
+        }
+
+        BenchFormatSeries (Allocate, Text, BENCH_TEXT_SIZE * sizeof (CHAR16));
+        StandardLib->RecordMessage (
+                       StandardLib,
+                       EFI_VERBOSE_LEVEL_DEFAULT,
+                       L"\r\nBENCH %s type=%s frag=%d size=%d %s",
+                       AllocateName,
+                       mBenchMemoryTypes[TypeIndex].Name,
+                       mBenchFragmentLevels[LevelIndex],
+                       Sizes[SizeIndex],
+                       Text
+                       );
+
+        BenchFormatSeries (Free, Text, BENCH_TEXT_SIZE * sizeof (CHAR16));
+        StandardLib->RecordMessage (
+                       StandardLib,
+                       EFI_VERBOSE_LEVEL_DEFAULT,
+                       L"\r\nBENCH %s type=%s frag=%d size=%d %s",
+                       FreeName,
+                       mBenchMemoryTypes[TypeIndex].Name,
+                       mBenchFragmentLevels[LevelIndex],
+                       Sizes[SizeIndex],
+                       Text
+                       );
+      }
+    }
+
+    Status = BenchFragmentFree (&Fragment);
+    if (EFI_ERROR(Status)) {
+      FreeStatus = Status;
+    }
+  }
+
+  gtBS->FreePool (Allocate);
+  gtBS->FreePool (Free);
+  gtBS->FreePool (Text);
+
+  if (!EFI_ERROR(FreeStatus) && (Failed == 0)) {
+    Result = EFI_TEST_ASSERTION_PASSED;
+  } else {
+    Result = EFI_TEST_ASSERTION_FAILED;
+  }
+
+  StandardLib->RecordAssertion (
+                 StandardLib,
+                 Result,
+                 AssertionGuid,
+                 Pages ? L"BS.FreePages - Free every benchmark allocation" :
+                         L"BS.FreePool - Free every benchmark allocation",
+                 L"%a:%d:Status - %r, Failed frees - %d",
+                 __FILE__,
+                 (UINTN)__LINE__,
+                 FreeStatus,
+                 Failed
+                 );
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+ *  Entrypoint for AllocatePool/FreePool Benchmark Test.
+ *  @param This a pointer of EFI_BB_TEST_PROTOCOL.
+ *  @param ClientInterface a pointer to the interface to be tested.
+ *  @param TestLevel test "thoroughness" control.
+ *  @param SupportHandle a handle containing protocols required.
+ *  @return EFI_SUCCESS Finish the test successfully.
+ */
+EFI_STATUS
+BBTestPoolBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  EFI_STANDARD_TEST_LIBRARY_PROTOCOL   *StandardLib;
+  EFI_STATUS                           Status;
+
+  //
+  // Get the Standard Library Interface
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiStandardTestLibraryGuid,
+                   (VOID **) &StandardLib
+                   );
+
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  return BenchAllocateSweep (
+           StandardLib,
+           FALSE,
+           gMemoryAllocationServicesBenchmarkTestAssertionGuid001
+           );
+}
+
+
+/**
+ *  Entrypoint for AllocatePages/FreePages Benchmark Test.
+ *  @param This a pointer of EFI_BB_TEST_PROTOCOL.
+ *  @param ClientInterface a pointer to the interface to be tested.
+ *  @param TestLevel test "thoroughness" control.
+ *  @param SupportHandle a handle containing protocols required.
+ *  @return EFI_SUCCESS Finish the test successfully.
+ */
+EFI_STATUS
+BBTestPagesBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  EFI_STANDARD_TEST_LIBRARY_PROTOCOL   *StandardLib;
+  EFI_STATUS                           Status;
+
+  //
+  // Get the Standard Library Interface
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiStandardTestLibraryGuid,
+                   (VOID **) &StandardLib
+                   );
+
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  return BenchAllocateSweep (
+           StandardLib,
+           TRUE,
+           gMemoryAllocationServicesBenchmarkTestAssertionGuid002
+           );
+}
+
+
+/**
+ *  Entrypoint for GetMemoryMap Benchmark Test.
+ *  @param This a pointer of EFI_BB_TEST_PROTOCOL.
+ *  @param ClientInterface a pointer to the interface to be tested.
+ *  @param TestLevel test "thoroughness" control.
+ *  @param SupportHandle a handle containing protocols required.
+ *  @return EFI_SUCCESS Finish the test successfully.
+ */
+EFI_STATUS
+BBTestGetMemoryMapBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  EFI_STANDARD_TEST_LIBRARY_PROTOCOL   *StandardLib;
+  EFI_STATUS                           Status;
+  EFI_STATUS                           FreeStatus;
+  EFI_TEST_ASSERTION                   AssertionType;
+  SCT_TIMER                            Timer;
+  BENCH_FRAGMENT                       Fragment;
+  BENCH_SERIES                         *Series;
+  CHAR16                               *Text;
+  EFI_MEMORY_DESCRIPTOR                *Map;
+  UINT8                                TmpMemoryMap[1];
+  UINTN                                MapBufferSize;
+  UINTN                                MemoryMapSize;
+  UINTN                                MapKey;
+  UINTN                                DescriptorSize;
+  UINT32                               DescriptorVersion;
+  UINTN                                Descriptors;
+  UINTN                                LevelIndex;
+  UINTN                                Index;
+  UINT64                               Start;
+  UINT64                               End;
+
+  //
+  // Get the Standard Library Interface
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiStandardTestLibraryGuid,
+                   (VOID **) &StandardLib
+                   );
+
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Status = SctTimerInit (&Timer);
+  if (EFI_ERROR(Status)) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nTimestamp Protocol not usable (%r), benchmark skipped",
+                   Status
+                   );
+    return EFI_SUCCESS;
+  }
+
+  Series = NULL;
+  Text   = NULL;
+  Status = gtBS->AllocatePool (EfiBootServicesData, sizeof (BENCH_SERIES), (VOID **) &Series);
+  if (!EFI_ERROR(Status)) {
+    Status = gtBS->AllocatePool (EfiBootServicesData, BENCH_TEXT_SIZE * sizeof (CHAR16), (VOID **) &Text);
+  }
+  if (EFI_ERROR(Status)) {
+    StandardLib->RecordAssertion (
+                   StandardLib,
+                   EFI_TEST_ASSERTION_FAILED,
+                   gTestGenericFailureGuid,
+                   L"BS.AllocatePool - Allocate the benchmark buffers",
+                   L"%a:%d:Status - %r",
+                   __FILE__,
+                   (UINTN)__LINE__,
+                   Status
+                   );
+    if (Series != NULL) {
+      gtBS->FreePool (Series);
+    }
+    return Status;
+  }
+
+  FreeStatus = EFI_SUCCESS;
+
+  for (LevelIndex = 0; LevelIndex < sizeof (mBenchFragmentLevels) / sizeof (UINTN); LevelIndex++) {
+    Status = BenchFragmentCreate (mBenchFragmentLevels[LevelIndex], &Fragment);
+    if (EFI_ERROR(Status)) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\nFragmentation to %d blocks failed at %d pages, %d pool blocks (%r), sweep stopped",
+                     mBenchFragmentLevels[LevelIndex],
+                     Fragment.Pages,
+                     Fragment.Pools,
+                     Status
+                     );
+      Status = BenchFragmentFree (&Fragment);
+      if (EFI_ERROR(Status)) {
+        FreeStatus = Status;
+      }
+      break;
+    }
+
+    //
+    // Size the buffer for this level, the allocation itself may add a
+    // descriptor
+    //
+    MemoryMapSize = 1;
+    gtBS->GetMemoryMap (
+            &MemoryMapSize,
+            (EFI_MEMORY_DESCRIPTOR *)TmpMemoryMap,
+            &MapKey,
+            &DescriptorSize,
+            &DescriptorVersion
+            );
+    MapBufferSize = MemoryMapSize + BENCH_MAP_SLACK_PAGES * EFI_PAGE_SIZE;
+    Status = gtBS->AllocatePool (EfiBootServicesData, MapBufferSize, (VOID **) &Map);
+
+    if (!EFI_ERROR(Status)) {
+      Series->Count = 0;
+      Descriptors   = 0;
+      for (Index = 0; Index < BENCH_SAMPLES; Index++) {
+        MemoryMapSize = MapBufferSize;
+        Start  = SctTimerRead (&Timer);
+        Status = gtBS->GetMemoryMap (
+                         &MemoryMapSize,
+                         Map,
+                         &MapKey,
+                         &DescriptorSize,
+                         &DescriptorVersion
+                         );
+        End    = SctTimerRead (&Timer);
+        if (EFI_ERROR(Status)) {
+          break;
+        }
+        Series->Latency[Series->Count++] = BenchTimerNs (&Timer, Start, End);
+        Descriptors = MemoryMapSize / DescriptorSize;
+      }
+      gtBS->FreePool (Map);
+    }
+
+    if (EFI_ERROR(Status)) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\nGetMemoryMap frag=%d failed (%r)",
+                     mBenchFragmentLevels[LevelIndex],
+                     Status
+                     );
+    } else {
+      BenchFormatSeries (Series, Text, BENCH_TEXT_SIZE * sizeof (CHAR16));
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\nBENCH GetMemoryMap desc=%d frag=%d %s",
+                     Descriptors,
+                     mBenchFragmentLevels[LevelIndex],
+                     Text
+                     );
+      if (Descriptors != 0) {
+        StandardLib->RecordMessage (
+                       StandardLib,
+                       EFI_VERBOSE_LEVEL_DEFAULT,
+                       L"\r\nGetMemoryMap frag=%d: %ld ns per descriptor at p50",
+                       mBenchFragmentLevels[LevelIndex],
+                       SctDivU64x32 (SctTimerPercentile (Series->Latency, Series->Count, 50), Descriptors, NULL)
+                       );
+      }
+    }
+
+    Status = BenchFragmentFree (&Fragment);
+    if (EFI_ERROR(Status)) {
+      FreeStatus = Status;
+    }
+  }
+
+  gtBS->FreePool (Series);
+  gtBS->FreePool (Text);
+
+  if (!EFI_ERROR(FreeStatus)) {
+    AssertionType = EFI_TEST_ASSERTION_PASSED;
+  } else {
+    AssertionType = EFI_TEST_ASSERTION_FAILED;
+  }
+
+  StandardLib->RecordAssertion (
+                 StandardLib,
+                 AssertionType,
+                 gMemoryAllocationServicesBenchmarkTestAssertionGuid003,
+                 L"BS.FreePages - Free every fragmentation block",
+                 L"%a:%d:Status - %r",
+                 __FILE__,
+                 (UINTN)__LINE__,
+                 FreeStatus
+                 );
+
+  return EFI_SUCCESS;
+}
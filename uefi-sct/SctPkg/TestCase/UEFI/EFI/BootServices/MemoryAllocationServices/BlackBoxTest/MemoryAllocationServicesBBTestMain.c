@@ -169,6 +169,33 @@ EFI_BB_TEST_ENTRY_FIELD gBBTestEntryField[] = {
     BBTestPoolStressTest
   },
 #endif
+  {
+    MEMORY_ALLOCATION_SERVICES_GETMEMORYMAP_BENCHMARK_GUID,
+    L"GetMemoryMap_Bench",
+    L"Latency of GetMemoryMap against the number of descriptors",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gSupportProtocolGuid1,
+    EFI_TEST_CASE_AUTO,
+    BBTestGetMemoryMapBenchmarkTest
+  },
+  {
+    MEMORY_ALLOCATION_SERVICES_PAGES_BENCHMARK_GUID,
+    L"Allocate/FreePages_Bench",
+    L"Latency of AllocatePages and FreePages under fragmentation",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gSupportProtocolGuid1,
+    EFI_TEST_CASE_AUTO,
+    BBTestPagesBenchmarkTest
+  },
+  {
+    MEMORY_ALLOCATION_SERVICES_POOL_BENCHMARK_GUID,
+    L"Allocate/FreePool_Bench",
+    L"Latency of AllocatePool and FreePool under fragmentation",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gSupportProtocolGuid1,
+    EFI_TEST_CASE_AUTO,
+    BBTestPoolBenchmarkTest
+  },
 
   EFI_NULL_GUID
 };
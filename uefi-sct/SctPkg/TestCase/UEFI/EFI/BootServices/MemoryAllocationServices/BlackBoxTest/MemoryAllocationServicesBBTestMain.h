@@ -189,6 +189,33 @@ BBTestPoolStressTest (
   IN EFI_HANDLE                 SupportHandle
   );
 
+//
+// Benchmark
+//
+EFI_STATUS
+BBTestGetMemoryMapBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
+EFI_STATUS
+BBTestPagesBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
+EFI_STATUS
+BBTestPoolBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
 //
 // Prototypes of Internal Functions
 //
@@ -267,4 +294,13 @@ GetSecondMaxFreeMemoryDescriptor (
 #define MEMORY_ALLOCATION_SERVICES_POOL_STRESS_TEST_GUID \
   { 0x76b79925, 0x5353, 0x472d, {0x9d, 0x58, 0xfc, 0x53, 0x9, 0xcc, 0xcd, 0x7 }}
 
+#define MEMORY_ALLOCATION_SERVICES_GETMEMORYMAP_BENCHMARK_GUID \
+  { 0x667ff2d5, 0xcccc, 0x4fb8, {0x92, 0x3a, 0x32, 0x6b, 0x71, 0x42, 0x26, 0xd5 }}
+
+#define MEMORY_ALLOCATION_SERVICES_PAGES_BENCHMARK_GUID \
+  { 0xb1241d99, 0x435f, 0x4814, {0xaa, 0xe5, 0xd9, 0x20, 0xe6, 0xa4, 0xc0, 0x58 }}
+
+#define MEMORY_ALLOCATION_SERVICES_POOL_BENCHMARK_GUID \
+  { 0x3ded82a7, 0x8757, 0x4a93, {0x9d, 0xd7, 0x48, 0x22, 0xfa, 0xb9, 0x05, 0x03 }}
+
 #endif
@@ -731,3 +731,49 @@ FreeAlignedPool (
   return Status;
 }
 
+
+/**
+ *  readiness probe of the block device after a reset, see EfiTestWaitForReady
+ *  @param  Context BlockIo protocol interface
+ *  @return TRUE if the device answers a read of its first block
+*/
+BOOLEAN
+EFIAPI
+BlockIoReadyProbe (
+  IN VOID             *Context
+  )
+{
+  EFI_BLOCK_IO_PROTOCOL   *BlockIo;
+  VOID                    *Buffer;
+  EFI_STATUS              Status;
+
+  BlockIo = (EFI_BLOCK_IO_PROTOCOL *)Context;
+
+  //
+  // No media is nothing to wait for
+  //
+  if (!BlockIo->Media->MediaPresent) {
+    return TRUE;
+  }
+
+  Buffer = AllocateAlignedPool (
+             EfiBootServicesData,
+             BlockIo->Media->BlockSize,
+             BlockIo->Media->IoAlign
+             );
+  if (Buffer == NULL) {
+    return TRUE;
+  }
+
+  Status = BlockIo->ReadBlocks (
+                      BlockIo,
+                      BlockIo->Media->MediaId,
+                      0,
+                      BlockIo->Media->BlockSize,
+                      Buffer
+                      );
+
+  FreeAlignedPool (Buffer);
+
+  return (BOOLEAN)(Status != EFI_NOT_READY && Status != EFI_DEVICE_ERROR);
+}
@@ -311,5 +311,11 @@ FreeAlignedPool (
   IN VOID   *Buffer
   );
 
+BOOLEAN
+EFIAPI
+BlockIoReadyProbe (
+  IN VOID             *Context
+  );
+
 #endif
 
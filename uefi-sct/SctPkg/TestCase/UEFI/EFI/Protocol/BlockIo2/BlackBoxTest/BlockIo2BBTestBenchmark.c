@@ -0,0 +1,1061 @@
+/** @file
+
+  Copyright 2006 - 2016 Unified EFI, Inc.<BR>
+  Copyright (c) 2011 - 2016, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  BlockIo2BBTestBenchmark.c
+
+Abstract:
+
+  Throughput and latency benchmark of Block I/O 2 Protocol. Every run
+  issues a fixed number of transfers of one size at one queue depth, keeps
+  up to queue depth tokens outstanding with ReadBlocksEx/WriteBlocksEx and
+  times each transfer from submission to its token event. The synchronous
+  Block I/O Protocol on the same handle is measured as the queue depth 1
+  baseline, and replaces the token path if the driver refuses tokens.
+
+  Every run is recorded as a message in the test log and as one CSV line
+  in Log\Benchmark\BlockIo2BBTest.csv under the SCT directory.
+
+  The write benchmark destroys the data in the first BENCH_MAX_REGION bytes
+  of the device. It only runs on RAM disks and on devices listed in the
+  [Benchmark_Scratch] sections of BlockIo2BBTest.ini.
+
+--*/
+
+
+#include "SctLib.h"
+#include "BlockIo2BBTestMain.h"
+
+#define BENCH_MAX_QUEUE_DEPTH       32
+#define BENCH_OPS_PER_RUN           1024
+#define BENCH_BYTES_PER_RUN         0x4000000
+#define BENCH_MAX_REGION            0x4000000
+#define BENCH_RANDOM_SEED           0x2545F491
+#define BENCH_STALL_TIMEOUT_NS      10000000000ULL
+#define BENCH_RECORD_LEN            1024
+
+#define BENCH_WRITE_PATTERN         0x5A
+
+//
+// Media device path subtype of a RAM disk
+//
+#define BENCH_MEDIA_RAM_DISK_DP     0x09
+
+#define BENCH_LOG_DIR               L"Log\\Benchmark"
+#define BENCH_LOG_FILE              L"BlockIo2BBTest.csv"
+#define BENCH_INI_DIR               L"Dependency\\BlockIo2BBTest"
+#define BENCH_INI_FILE              L"BlockIo2BBTest.ini"
+#define BENCH_SCRATCH_SECTION       L"Benchmark_Scratch"
+
+#define BENCH_LOG_HEADER            "Device,Operation,Pattern,Mode,TransferSize,QueueDepth,Ops,Errors,ElapsedUs,MBps,KBps,IOPS,LatP50Ns,LatP90Ns,LatP99Ns,LatMaxNs\r\n"
+
+STATIC UINTN mBenchTransferSizes[] = { 0x1000, 0x10000, 0x100000 };
+STATIC UINTN mBenchQueueDepths[]   = { 1, 4, 16, BENCH_MAX_QUEUE_DEPTH };
+
+//
+// State shared by the runs on one device
+//
+typedef struct {
+  EFI_BLOCK_IO2_PROTOCOL            *BlockIo2;
+  EFI_BLOCK_IO_PROTOCOL             *BlockIo;
+  SCT_TIMER                         Timer;
+  EFI_LBA                           RegionBlocks;
+  UINT64                            *Latency;
+  volatile UINTN                    Completed;
+  volatile UINTN                    Errors;
+  UINT32                            Seed;
+} BENCH_CONTEXT;
+
+//
+// One outstanding transfer of the token path
+//
+typedef struct {
+  EFI_BLOCK_IO2_TOKEN               Token;
+  BENCH_CONTEXT                     *Bench;
+  UINT64                            Start;
+  VOID                              *Buffer;
+  volatile BOOLEAN                  Busy;
+} BENCH_REQUEST;
+
+typedef struct {
+  BOOLEAN                           Write;
+  BOOLEAN                           Random;
+  BOOLEAN                           Sync;
+  UINTN                             TransferSize;
+  UINTN                             QueueDepth;
+  UINTN                             Ops;
+  UINTN                             Errors;
+  UINT64                            ElapsedUs;
+  UINT64                            KBps;
+  UINT64                            Iops;
+  UINT64                            P50Ns;
+  UINT64                            P90Ns;
+  UINT64                            P99Ns;
+  UINT64                            MaxNs;
+} BENCH_RESULT;
+
+
+STATIC
+EFI_LBA
+BenchNextLba (
+  IN BENCH_CONTEXT                  *Bench,
+  IN UINTN                          Op,
+  IN BOOLEAN                        Random,
+  IN UINTN                          TransferBlocks
+  )
+{
+  UINTN                             Slots;
+  UINTN                             Index;
+
+  Slots = (UINTN) SctDivU64x32 (Bench->RegionBlocks, TransferBlocks, NULL);
+  if (Random) {
+    Bench->Seed = Bench->Seed * 1103515245 + 12345;
+    Index       = (Bench->Seed >> 8) % Slots;
+  } else {
+    Index       = Op % Slots;
+  }
+
+  return SctMultU64x32 ((UINT64) Index, TransferBlocks);
+}
+
+
+VOID
+EFIAPI
+BenchRequestNotifyFunc (
+  IN  EFI_EVENT                     Event,
+  IN  VOID                          *Context
+  )
+{
+  BENCH_REQUEST                     *Request;
+  BENCH_CONTEXT                     *Bench;
+  UINT64                            End;
+
+  Request = (BENCH_REQUEST *) Context;
+  Bench   = Request->Bench;
+  End     = SctTimerRead (&Bench->Timer);
+
+  if (EFI_ERROR (Request->Token.TransactionStatus)) {
+    Bench->Errors++;
+  }
+  Bench->Latency[Bench->Completed] = SctTimerElapsed (&Bench->Timer, Request->Start, End);
+  Bench->Completed++;
+  Request->Busy = FALSE;
+}
+
+
+STATIC
+VOID
+BenchSummarize (
+  IN BENCH_CONTEXT                  *Bench,
+  IN UINT64                         ElapsedTicks,
+  IN OUT BENCH_RESULT               *Result
+  )
+{
+  UINTN                             Count;
+  UINT64                            Bytes;
+
+  Count             = Bench->Completed;
+  Result->Ops       = Count;
+  Result->Errors    = Bench->Errors;
+  Result->ElapsedUs = SctDivU64x32 (SctTimerTicksToNs (&Bench->Timer, ElapsedTicks), 1000, NULL);
+  if (Result->ElapsedUs == 0) {
+    Result->ElapsedUs = 1;
+  }
+
+  Bytes        = SctMultU64x32 ((UINT64) Count, Result->TransferSize);
+  Result->KBps = SctDivU64x32 (SctMultU64x32 (SctRShiftU64 (Bytes, 10), 1000000), (UINTN) Result->ElapsedUs, NULL);
+  Result->Iops = SctDivU64x32 (SctMultU64x32 ((UINT64) Count, 1000000), (UINTN) Result->ElapsedUs, NULL);
+
+  if (Count == 0) {
+    return;
+  }
+
+  SctTimerSortSamples (Bench->Latency, Count);
+  Result->P50Ns = SctTimerTicksToNs (&Bench->Timer, SctTimerPercentile (Bench->Latency, Count, 50));
+  Result->P90Ns = SctTimerTicksToNs (&Bench->Timer, SctTimerPercentile (Bench->Latency, Count, 90));
+  Result->P99Ns = SctTimerTicksToNs (&Bench->Timer, SctTimerPercentile (Bench->Latency, Count, 99));
+  Result->MaxNs = SctTimerTicksToNs (&Bench->Timer, Bench->Latency[Count - 1]);
+}
+
+
+/**
+ *  Run one token path measurement with up to QueueDepth transfers outstanding.
+ *  @param Bench the benchmark context.
+ *  @param Requests the QueueDepth request slots, events already created.
+ *  @param Result the run parameters on input, the measurement on output.
+ *  @return EFI_SUCCESS the run finished.
+ *  @return EFI_TIMEOUT transfers stopped completing, the request slots are
+ *          still owned by the driver and must not be freed.
+ *  @return others ReadBlocksEx/WriteBlocksEx refused a token.
+ */
+STATIC
+EFI_STATUS
+BenchRunAsync (
+  IN BENCH_CONTEXT                  *Bench,
+  IN BENCH_REQUEST                  *Requests,
+  IN OUT BENCH_RESULT               *Result
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_BLOCK_IO2_PROTOCOL            *BlockIo2;
+  BENCH_REQUEST                     *Request;
+  UINTN                             TransferBlocks;
+  UINTN                             Ops;
+  UINTN                             Issued;
+  UINTN                             Seen;
+  UINTN                             Index;
+  EFI_LBA                           Lba;
+  UINT64                            Start;
+  UINT64                            Now;
+  UINT64                            LastProgress;
+
+  BlockIo2         = Bench->BlockIo2;
+  TransferBlocks   = Result->TransferSize / BlockIo2->Media->BlockSize;
+  Ops              = Result->Ops;
+  Issued           = 0;
+  Seen             = 0;
+  Bench->Completed = 0;
+  Bench->Errors    = 0;
+  Bench->Seed      = BENCH_RANDOM_SEED;
+  Status           = EFI_SUCCESS;
+
+  Start        = SctTimerRead (&Bench->Timer);
+  LastProgress = Start;
+
+  while ((Bench->Completed < Issued) || ((Issued < Ops) && !EFI_ERROR (Status))) {
+    for (Index = 0; (Index < Result->QueueDepth) && (Issued < Ops) && !EFI_ERROR (Status); Index++) {
+      Request = &Requests[Index];
+      if (Request->Busy) {
+        continue;
+      }
+
+      Lba = BenchNextLba (Bench, Issued, Result->Random, TransferBlocks);
+      Request->Busy                    = TRUE;
+      Request->Token.TransactionStatus = EFI_NOT_READY;
+      Request->Start                   = SctTimerRead (&Bench->Timer);
+
+      if (Result->Write) {
+        Status = BlockIo2->WriteBlocksEx (
+                             BlockIo2,
+                             BlockIo2->Media->MediaId,
+                             Lba,
+                             &Request->Token,
+                             Result->TransferSize,
+                             Request->Buffer
+                             );
+      } else {
+        Status = BlockIo2->ReadBlocksEx (
+                             BlockIo2,
+                             BlockIo2->Media->MediaId,
+                             Lba,
+                             &Request->Token,
+                             Result->TransferSize,
+                             Request->Buffer
+                             );
+      }
+
+      if (EFI_ERROR (Status)) {
+        Request->Busy = FALSE;
+      } else {
+        Issued++;
+      }
+    }
+
+    Now = SctTimerRead (&Bench->Timer);
+    if (Bench->Completed != Seen) {
+      Seen         = Bench->Completed;
+      LastProgress = Now;
+    } else if (SctTimerTicksToNs (&Bench->Timer, SctTimerElapsed (&Bench->Timer, LastProgress, Now)) > BENCH_STALL_TIMEOUT_NS) {
+      return EFI_TIMEOUT;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  BenchSummarize (Bench, SctTimerElapsed (&Bench->Timer, Start, SctTimerRead (&Bench->Timer)), Result);
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+ *  Run one measurement on the synchronous Block I/O Protocol.
+ *  @param Bench the benchmark context.
+ *  @param Buffer the transfer buffer.
+ *  @param Result the run parameters on input, the measurement on output.
+ *  @return EFI_SUCCESS the run finished.
+ */
+STATIC
+EFI_STATUS
+BenchRunSync (
+  IN BENCH_CONTEXT                  *Bench,
+  IN VOID                           *Buffer,
+  IN OUT BENCH_RESULT               *Result
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_BLOCK_IO_PROTOCOL             *BlockIo;
+  UINTN                             TransferBlocks;
+  UINTN                             Op;
+  EFI_LBA                           Lba;
+  UINT64                            Start;
+  UINT64                            OpStart;
+  UINT64                            End;
+
+  BlockIo          = Bench->BlockIo;
+  TransferBlocks   = Result->TransferSize / BlockIo->Media->BlockSize;
+  Bench->Completed = 0;
+  Bench->Errors    = 0;
+  Bench->Seed      = BENCH_RANDOM_SEED;
+
+  Start = SctTimerRead (&Bench->Timer);
+
+  for (Op = 0; Op < Result->Ops; Op++) {
+    Lba     = BenchNextLba (Bench, Op, Result->Random, TransferBlocks);
+    OpStart = SctTimerRead (&Bench->Timer);
+
+    if (Result->Write) {
+      Status = BlockIo->WriteBlocks (
+                          BlockIo,
+                          BlockIo->Media->MediaId,
+                          Lba,
+                          Result->TransferSize,
+                          Buffer
+                          );
+    } else {
+      Status = BlockIo->ReadBlocks (
+                          BlockIo,
+                          BlockIo->Media->MediaId,
+                          Lba,
+                          Result->TransferSize,
+                          Buffer
+                          );
+    }
+
+    End = SctTimerRead (&Bench->Timer);
+    if (EFI_ERROR (Status)) {
+      Bench->Errors++;
+    }
+    Bench->Latency[Bench->Completed] = SctTimerElapsed (&Bench->Timer, OpStart, End);
+    Bench->Completed++;
+  }
+
+  BenchSummarize (Bench, SctTimerElapsed (&Bench->Timer, Start, SctTimerRead (&Bench->Timer)), Result);
+
+  return EFI_SUCCESS;
+}
+
+
+STATIC
+BOOLEAN
+BenchIsRamDisk (
+  IN EFI_DEVICE_PATH_PROTOCOL       *DevicePath
+  )
+{
+  if (DevicePath == NULL) {
+    return FALSE;
+  }
+
+  while (!SctIsDevicePathEnd (DevicePath)) {
+    if ((SctDevicePathType (DevicePath) == MEDIA_DEVICE_PATH) &&
+        (SctDevicePathSubType (DevicePath) == BENCH_MEDIA_RAM_DISK_DP)) {
+      return TRUE;
+    }
+    DevicePath = SctNextDevicePathNode (DevicePath);
+  }
+
+  return FALSE;
+}
+
+
+/**
+ *  Check whether the device is listed in a [Benchmark_Scratch] section.
+ *  @param ProfileLib the test profile library.
+ *  @param DevicePathStr the text of the device path under test.
+ *  @return TRUE the device may be overwritten by the benchmark.
+ */
+STATIC
+BOOLEAN
+BenchIsScratchDevice (
+  IN EFI_TEST_PROFILE_LIBRARY_PROTOCOL  *ProfileLib,
+  IN CHAR16                             *DevicePathStr
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_DEVICE_PATH_PROTOCOL          *SysDevicePath;
+  CHAR16                            *SysFilePath;
+  CHAR16                            *FilePath;
+  EFI_INI_FILE_HANDLE               FileHandle;
+  UINT32                            MaxOrder;
+  UINT32                            Order;
+  UINT32                            MaxLen;
+  CHAR16                            Buffer[BENCH_RECORD_LEN];
+  BOOLEAN                           Found;
+
+  if (DevicePathStr == NULL) {
+    return FALSE;
+  }
+
+  Status = ProfileLib->EfiGetSystemDevicePath (
+                         ProfileLib,
+                         &SysDevicePath,
+                         &SysFilePath
+                         );
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  FilePath = SctPoolPrint (L"%s\\%s\\%s", SysFilePath, BENCH_INI_DIR, BENCH_INI_FILE);
+  gtBS->FreePool (SysFilePath);
+  if (FilePath == NULL) {
+    gtBS->FreePool (SysDevicePath);
+    return FALSE;
+  }
+
+  Status = ProfileLib->EfiIniOpen (
+                         ProfileLib,
+                         SysDevicePath,
+                         FilePath,
+                         &FileHandle
+                         );
+  gtBS->FreePool (FilePath);
+  gtBS->FreePool (SysDevicePath);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  Found    = FALSE;
+  MaxOrder = 0;
+  Status   = FileHandle->GetOrderNum (FileHandle, BENCH_SCRATCH_SECTION, &MaxOrder);
+  if (!EFI_ERROR (Status)) {
+    for (Order = 0; (Order < MaxOrder) && !Found; Order++) {
+      MaxLen    = BENCH_RECORD_LEN;
+      Buffer[0] = L'\0';
+      Status = FileHandle->GetStringByOrder (
+                             FileHandle,
+                             Order,
+                             BENCH_SCRATCH_SECTION,
+                             L"DevicePath",
+                             Buffer,
+                             &MaxLen
+                             );
+      if (!EFI_ERROR (Status) && (Buffer[0] != L'\0') &&
+          (SctStriCmp (Buffer, DevicePathStr) == 0)) {
+        Found = TRUE;
+      }
+    }
+  }
+
+  ProfileLib->EfiIniClose (ProfileLib, FileHandle);
+
+  return Found;
+}
+
+
+/**
+ *  Open the CSV record file for appending, create it with a header if needed.
+ *  @param ProfileLib the test profile library.
+ *  @param LogFile the opened file.
+ *  @return EFI_SUCCESS the file is ready for appending.
+ */
+STATIC
+EFI_STATUS
+BenchOpenLog (
+  IN EFI_TEST_PROFILE_LIBRARY_PROTOCOL  *ProfileLib,
+  OUT EFI_FILE_HANDLE                   *LogFile
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_DEVICE_PATH_PROTOCOL          *SysDevicePath;
+  EFI_DEVICE_PATH_PROTOCOL          *DevicePath;
+  CHAR16                            *SysFilePath;
+  CHAR16                            *DirName;
+  CHAR16                            *FileName;
+  EFI_HANDLE                        DeviceHandle;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL   *Vol;
+  EFI_FILE_HANDLE                   RootDir;
+  EFI_FILE_HANDLE                   Handle;
+  EFI_FILE_INFO                     *FileInfo;
+  UINTN                             Size;
+
+  Status = ProfileLib->EfiGetSystemDevicePath (
+                         ProfileLib,
+                         &SysDevicePath,
+                         &SysFilePath
+                         );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  DirName  = SctPoolPrint (L"%s\\%s", SysFilePath, BENCH_LOG_DIR);
+  FileName = SctPoolPrint (L"%s\\%s\\%s", SysFilePath, BENCH_LOG_DIR, BENCH_LOG_FILE);
+  gtBS->FreePool (SysFilePath);
+
+  DevicePath = SysDevicePath;
+  Status = gtBS->LocateDevicePath (
+                   &gEfiSimpleFileSystemProtocolGuid,
+                   &DevicePath,
+                   &DeviceHandle
+                   );
+  gtBS->FreePool (SysDevicePath);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+  if ((DirName == NULL) || (FileName == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Status = gtBS->HandleProtocol (
+                   DeviceHandle,
+                   &gEfiSimpleFileSystemProtocolGuid,
+                   (VOID **) &Vol
+                   );
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = Vol->OpenVolume (Vol, &RootDir);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = SctCreateDirectory (RootDir, DirName);
+  if (!EFI_ERROR (Status)) {
+    Status = RootDir->Open (
+                        RootDir,
+                        &Handle,
+                        FileName,
+                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                        0
+                        );
+  }
+  RootDir->Close (RootDir);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = SctGetFileInfo (Handle, &FileInfo);
+  if (EFI_ERROR (Status)) {
+    Handle->Close (Handle);
+    goto Done;
+  }
+
+  if (FileInfo->FileSize == 0) {
+    Size   = SctAsciiStrLen (BENCH_LOG_HEADER);
+    Status = Handle->Write (Handle, &Size, BENCH_LOG_HEADER);
+  } else {
+    Status = Handle->SetPosition (Handle, FileInfo->FileSize);
+  }
+  gtBS->FreePool (FileInfo);
+
+  if (EFI_ERROR (Status)) {
+    Handle->Close (Handle);
+    goto Done;
+  }
+
+  *LogFile = Handle;
+
+Done:
+  if (DirName != NULL) {
+    gtBS->FreePool (DirName);
+  }
+  if (FileName != NULL) {
+    gtBS->FreePool (FileName);
+  }
+
+  return Status;
+}
+
+
+STATIC
+VOID
+BenchReport (
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL  *StandardLib,
+  IN EFI_FILE_HANDLE                     LogFile,
+  IN CHAR16                              *DevicePathStr,
+  IN BENCH_RESULT                        *Result
+  )
+{
+  CHAR8                             Record[BENCH_RECORD_LEN];
+  UINTN                             Size;
+
+  StandardLib->RecordMessage (
+                 StandardLib,
+                 EFI_VERBOSE_LEVEL_DEFAULT,
+                 L"\r\n%s %s %s: %d bytes, QD %d, %d ops, %d errors, %ld KB/s, %ld IOPS, latency ns p50 %ld p90 %ld p99 %ld max %ld",
+                 Result->Write ? L"Write" : L"Read",
+                 Result->Random ? L"random" : L"sequential",
+                 Result->Sync ? L"BlockIo" : L"BlockIo2",
+                 Result->TransferSize,
+                 Result->QueueDepth,
+                 Result->Ops,
+                 Result->Errors,
+                 Result->KBps,
+                 Result->Iops,
+                 Result->P50Ns,
+                 Result->P90Ns,
+                 Result->P99Ns,
+                 Result->MaxNs
+                 );
+
+  if (LogFile == NULL) {
+    return;
+  }
+
+  Size = SctASPrint (
+           Record,
+           sizeof (Record),
+           "\"%s\",%s,%s,%s,%d,%d,%d,%d,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld\r\n",
+           (DevicePathStr != NULL) ? DevicePathStr : L"",
+           Result->Write ? L"write" : L"read",
+           Result->Random ? L"random" : L"sequential",
+           Result->Sync ? L"sync" : L"async",
+           Result->TransferSize,
+           Result->QueueDepth,
+           Result->Ops,
+           Result->Errors,
+           Result->ElapsedUs,
+           SctRShiftU64 (Result->KBps, 10),
+           Result->KBps,
+           Result->Iops,
+           Result->P50Ns,
+           Result->P90Ns,
+           Result->P99Ns,
+           Result->MaxNs
+           );
+  LogFile->Write (LogFile, &Size, Record);
+}
+
+
+/**
+ *  Sweep transfer sizes, access patterns and queue depths on one device.
+ *  @param StandardLib a point to standard test lib.
+ *  @param Bench the benchmark context, the timer already initialized.
+ *  @param LogFile the CSV record file, or NULL.
+ *  @param DevicePathStr the text of the device path under test.
+ *  @param Write TRUE to measure WriteBlocksEx, FALSE for ReadBlocksEx.
+ *  @return EFI_SUCCESS Finish the test successfully.
+ */
+STATIC
+EFI_STATUS
+BenchSweep (
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL  *StandardLib,
+  IN BENCH_CONTEXT                       *Bench,
+  IN EFI_FILE_HANDLE                     LogFile,
+  IN CHAR16                              *DevicePathStr,
+  IN BOOLEAN                             Write
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_BLOCK_IO_MEDIA                *Media;
+  BENCH_REQUEST                     *Requests;
+  BENCH_RESULT                      Result;
+  EFI_TEST_ASSERTION                AssertionType;
+  UINTN                             SizeIndex;
+  UINTN                             DepthIndex;
+  UINTN                             Index;
+  UINTN                             Pattern;
+  UINTN                             Ops;
+  BOOLEAN                           AsyncUsable;
+
+  Media    = Bench->BlockIo2->Media;
+  Requests = NULL;
+  Status   = EFI_SUCCESS;
+
+  Bench->RegionBlocks = SctDivU64x32 (BENCH_MAX_REGION, Media->BlockSize, NULL);
+  if (Bench->RegionBlocks > Media->LastBlock + 1) {
+    Bench->RegionBlocks = Media->LastBlock + 1;
+  }
+
+  Bench->Latency = SctAllocatePool (BENCH_OPS_PER_RUN * sizeof (UINT64));
+  Requests       = SctAllocateZeroPool (BENCH_MAX_QUEUE_DEPTH * sizeof (BENCH_REQUEST));
+  if ((Bench->Latency == NULL) || (Requests == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  for (Index = 0; Index < BENCH_MAX_QUEUE_DEPTH; Index++) {
+    Requests[Index].Bench = Bench;
+    Status = gtBS->CreateEvent (
+                     EVT_NOTIFY_SIGNAL,
+                     TPL_CALLBACK,
+                     (EFI_EVENT_NOTIFY) BenchRequestNotifyFunc,
+                     &Requests[Index],
+                     &Requests[Index].Token.Event
+                     );
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  AsyncUsable = TRUE;
+
+  for (SizeIndex = 0; SizeIndex < sizeof (mBenchTransferSizes) / sizeof (UINTN); SizeIndex++) {
+    if ((mBenchTransferSizes[SizeIndex] % Media->BlockSize != 0) ||
+        (mBenchTransferSizes[SizeIndex] / Media->BlockSize > Bench->RegionBlocks)) {
+      continue;
+    }
+
+    Ops = MINIMUM (BENCH_OPS_PER_RUN, BENCH_BYTES_PER_RUN / mBenchTransferSizes[SizeIndex]);
+
+    for (Index = 0; Index < BENCH_MAX_QUEUE_DEPTH; Index++) {
+      Requests[Index].Buffer = AllocateAlignedPool (
+                                 EfiBootServicesData,
+                                 mBenchTransferSizes[SizeIndex],
+                                 Media->IoAlign
+                                 );
+      if (Requests[Index].Buffer == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        goto Done;
+      }
+      SctSetMem (Requests[Index].Buffer, mBenchTransferSizes[SizeIndex], BENCH_WRITE_PATTERN);
+    }
+
+    for (Pattern = 0; Pattern < 2; Pattern++) {
+      //
+      // Queue depth 1 baseline on the synchronous protocol
+      //
+      if (Bench->BlockIo != NULL) {
+        SctZeroMem (&Result, sizeof (Result));
+        Result.Write        = Write;
+        Result.Random       = (BOOLEAN) (Pattern != 0);
+        Result.Sync         = TRUE;
+        Result.TransferSize = mBenchTransferSizes[SizeIndex];
+        Result.QueueDepth   = 1;
+        Result.Ops          = Ops;
+
+        BenchRunSync (Bench, Requests[0].Buffer, &Result);
+        BenchReport (StandardLib, LogFile, DevicePathStr, &Result);
+      }
+
+      for (DepthIndex = 0; AsyncUsable && (DepthIndex < sizeof (mBenchQueueDepths) / sizeof (UINTN)); DepthIndex++) {
+        SctZeroMem (&Result, sizeof (Result));
+        Result.Write        = Write;
+        Result.Random       = (BOOLEAN) (Pattern != 0);
+        Result.TransferSize = mBenchTransferSizes[SizeIndex];
+        Result.QueueDepth   = mBenchQueueDepths[DepthIndex];
+        Result.Ops          = Ops;
+
+        Status = BenchRunAsync (Bench, Requests, &Result);
+        if (Status == EFI_TIMEOUT) {
+          StandardLib->RecordAssertion (
+                         StandardLib,
+                         EFI_TEST_ASSERTION_FAILED,
+                         Write ? gBlockIo2BenchmarkAssertionGuid002 : gBlockIo2BenchmarkAssertionGuid001,
+                         Write ? L"EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx - transfers stop completing"
+                               : L"EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx - transfers stop completing",
+                         L"%a:%d:TransferSize - %d, QueueDepth - %d, Completed - %d",
+                         __FILE__,
+                         (UINTN)__LINE__,
+                         Result.TransferSize,
+                         Result.QueueDepth,
+                         Bench->Completed
+                         );
+          //
+          // The driver still owns the tokens and buffers, leave them alone
+          //
+          return Status;
+        }
+
+        if (EFI_ERROR (Status)) {
+          //
+          // Tokens are refused, the Block I/O baseline is all there is
+          //
+          StandardLib->RecordMessage (
+                         StandardLib,
+                         EFI_VERBOSE_LEVEL_DEFAULT,
+                         L"\r\nBlockIo2 tokens refused (%r), measuring BlockIo only",
+                         Status
+                         );
+          AsyncUsable = FALSE;
+          Status      = EFI_SUCCESS;
+          break;
+        }
+
+        BenchReport (StandardLib, LogFile, DevicePathStr, &Result);
+
+        AssertionType = (Result.Errors == 0) ? EFI_TEST_ASSERTION_PASSED : EFI_TEST_ASSERTION_FAILED;
+        StandardLib->RecordAssertion (
+                       StandardLib,
+                       AssertionType,
+                       Write ? gBlockIo2BenchmarkAssertionGuid002 : gBlockIo2BenchmarkAssertionGuid001,
+                       Write ? L"EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx - all benchmark transfers succeed"
+                             : L"EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx - all benchmark transfers succeed",
+                       L"%a:%d:TransferSize - %d, QueueDepth - %d, Errors - %d",
+                       __FILE__,
+                       (UINTN)__LINE__,
+                       Result.TransferSize,
+                       Result.QueueDepth,
+                       Result.Errors
+                       );
+      }
+    }
+
+    for (Index = 0; Index < BENCH_MAX_QUEUE_DEPTH; Index++) {
+      FreeAlignedPool (Requests[Index].Buffer);
+      Requests[Index].Buffer = NULL;
+    }
+  }
+
+Done:
+  if (Requests != NULL) {
+    for (Index = 0; Index < BENCH_MAX_QUEUE_DEPTH; Index++) {
+      if (Requests[Index].Token.Event != NULL) {
+        gtBS->CloseEvent (Requests[Index].Token.Event);
+      }
+      if (Requests[Index].Buffer != NULL) {
+        FreeAlignedPool (Requests[Index].Buffer);
+      }
+    }
+    gtBS->FreePool (Requests);
+  }
+  if (Bench->Latency != NULL) {
+    gtBS->FreePool (Bench->Latency);
+    Bench->Latency = NULL;
+  }
+
+  return Status;
+}
+
+
+STATIC
+EFI_STATUS
+BBTestBlockIo2Benchmark (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_HANDLE                 SupportHandle,
+  IN BOOLEAN                    Write
+  )
+{
+  EFI_STATUS                                 Status;
+  EFI_STANDARD_TEST_LIBRARY_PROTOCOL         *StandardLib = NULL;
+  EFI_TEST_PROFILE_LIBRARY_PROTOCOL          *ProfileLib = NULL;
+  EFI_BLOCK_IO2_PROTOCOL                     *BlockIo2 = NULL;
+  EFI_BLOCK_IO2_PROTOCOL                     *BlockIo2Temp = NULL;
+  EFI_DEVICE_PATH_PROTOCOL                   *DevicePath = NULL;
+  CHAR16                                     *DevicePathStr = NULL;
+  EFI_FILE_HANDLE                            LogFile = NULL;
+  EFI_HANDLE                                 *HandleBuffer = NULL;
+  UINTN                                      NoHandles;
+  UINTN                                      Index;
+  BENCH_CONTEXT                              *Bench;
+
+  //
+  // Get the Standard Library Interface
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiStandardTestLibraryGuid,
+                   (VOID **) &StandardLib
+                   );
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  //
+  // Get the Profile Library Interface
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiTestProfileLibraryGuid,
+                   (VOID **) &ProfileLib
+                   );
+  if (EFI_ERROR(Status)) {
+    StandardLib->RecordAssertion (
+                   StandardLib,
+                   EFI_TEST_ASSERTION_FAILED,
+                   gTestGenericFailureGuid,
+                   L"BS.HandleProtocol - Handle profile library",
+                   L"%a:%d:Status - %r",
+                   __FILE__,
+                   (UINTN)__LINE__,
+                   Status
+                   );
+    return Status;
+  }
+
+  BlockIo2 = (EFI_BLOCK_IO2_PROTOCOL *)ClientInterface;
+
+  if (!BlockIo2->Media->MediaPresent) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nNo media, benchmark skipped"
+                   );
+    return EFI_SUCCESS;
+  }
+
+  if (Write && BlockIo2->Media->ReadOnly) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nRead only media, write benchmark skipped"
+                   );
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Token events may still reference the context after a timeout, so it
+  // lives in pool and is only freed once every transfer has completed
+  //
+  Bench = SctAllocateZeroPool (sizeof (BENCH_CONTEXT));
+  if (Bench == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Bench->BlockIo2 = BlockIo2;
+
+  Status = SctTimerInit (&Bench->Timer);
+  if (EFI_ERROR (Status)) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nTimestamp Protocol not usable (%r), benchmark skipped",
+                   Status
+                   );
+    gtBS->FreePool (Bench);
+    return EFI_SUCCESS;
+  }
+
+  LocateDevicePathFromBlockIo2 (BlockIo2, &DevicePath, StandardLib);
+  DevicePathStr = SctDevicePathToStr (DevicePath);
+  if (DevicePathStr != NULL) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"Current Device: %s",
+                   DevicePathStr
+                   );
+  }
+
+  //
+  // Writing destroys the data on the device, only touch scratch devices
+  //
+  if (Write && !BenchIsRamDisk (DevicePath) && !BenchIsScratchDevice (ProfileLib, DevicePathStr)) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nNot a RAM disk nor listed in [%s] of %s, write benchmark skipped",
+                   BENCH_SCRATCH_SECTION,
+                   BENCH_INI_FILE
+                   );
+    goto Done;
+  }
+
+  //
+  // Locate Block IO protocol on same handler for the synchronous baseline
+  //
+  Status = gtBS->LocateHandleBuffer (
+                   ByProtocol,
+                   &gBlackBoxEfiBlockIo2ProtocolGuid,
+                   NULL,
+                   &NoHandles,
+                   &HandleBuffer
+                   );
+  if (!EFI_ERROR (Status)) {
+    for (Index = 0; Index < NoHandles; Index++) {
+      Status = gtBS->HandleProtocol (
+                       HandleBuffer[Index],
+                       &gBlackBoxEfiBlockIo2ProtocolGuid,
+                       (VOID **) &BlockIo2Temp
+                       );
+      if (Status == EFI_SUCCESS && BlockIo2Temp == BlockIo2) {
+        Status = gtBS->HandleProtocol (
+                         HandleBuffer[Index],
+                         &gBlackBoxEfiBlockIoProtocolGuid,
+                         (VOID **) &Bench->BlockIo
+                         );
+        if (Status != EFI_SUCCESS) {
+          Bench->BlockIo = NULL;
+        }
+        break;
+      }
+    }
+    gtBS->FreePool (HandleBuffer);
+  }
+
+  Status = BenchOpenLog (ProfileLib, &LogFile);
+  if (EFI_ERROR (Status)) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nCannot open %s\\%s (%r), records go to the log only",
+                   BENCH_LOG_DIR,
+                   BENCH_LOG_FILE,
+                   Status
+                   );
+    LogFile = NULL;
+  }
+
+  Status = BenchSweep (StandardLib, Bench, LogFile, DevicePathStr, Write);
+
+  if (LogFile != NULL) {
+    LogFile->Close (LogFile);
+  }
+
+Done:
+  if (Status != EFI_TIMEOUT) {
+    gtBS->FreePool (Bench);
+  }
+  if (DevicePathStr != NULL) {
+    gtBS->FreePool (DevicePathStr);
+  }
+
+  return Status;
+}
+
+
+/**
+ *  Entrypoint for EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx() Benchmark.
+ *  @param This a pointer of EFI_BB_TEST_PROTOCOL.
+ *  @param ClientInterface a pointer to the interface to be tested.
+ *  @param TestLevel test "thoroughness" control.
+ *  @param SupportHandle a handle containing protocols required.
+ *  @return EFI_SUCCESS Finish the test successfully.
+ */
+EFI_STATUS
+BBTestReadBlocksExBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  return BBTestBlockIo2Benchmark (This, ClientInterface, SupportHandle, FALSE);
+}
+
+
+/**
+ *  Entrypoint for EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx() Benchmark.
+ *  @param This a pointer of EFI_BB_TEST_PROTOCOL.
+ *  @param ClientInterface a pointer to the interface to be tested.
+ *  @param TestLevel test "thoroughness" control.
+ *  @param SupportHandle a handle containing protocols required.
+ *  @return EFI_SUCCESS Finish the test successfully.
+ */
+EFI_STATUS
+BBTestWriteBlocksExBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  return BBTestBlockIo2Benchmark (This, ClientInterface, SupportHandle, TRUE);
+}
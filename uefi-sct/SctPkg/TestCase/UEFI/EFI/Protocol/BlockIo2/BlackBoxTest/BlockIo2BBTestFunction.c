@@ -1206,11 +1206,17 @@ BBTestResetFunctionAutoTest (
   }
 
   //
-  // Sometimes the file system will be destroied from this point. Just add a
-  // stall to avoid it. (Need investigation, I don't know it is useful or not!)
-  //
-  SctPrint (L"Wait 5 seconds for the block IO 2 device resetting...");
-  gtBS->Stall (5000000);
+  // Sometimes the file system will be destroied from this point. Just wait
+  // for the device to answer a read again to avoid it.
+  //
+  SctPrint (L"Wait for the block IO 2 device resetting...");
+  EfiTestWaitForReady (
+    StandardLib,
+    L"EFI_BLOCK_IO2_PROTOCOL.Reset - Wait for the block IO 2 device",
+    BlockIo2ReadyProbe,
+    BlockIo2,
+    EFI_TEST_READY_TIMEOUT
+    );
 
   StandardLib->RecordAssertion (
                  StandardLib,
@@ -1235,11 +1241,17 @@ BBTestResetFunctionAutoTest (
   }
 
   //
-  // Sometimes the file system will be destroied from this point. Just add a
-  // stall to avoid it. (Need investigation, I don't know it is useful or not!)
+  // Sometimes the file system will be destroied from this point. Just wait
+  // for the device to answer a read again to avoid it.
   //
-  SctPrint (L"Wait 5 seconds for the block IO 2 device resetting...");
-  gtBS->Stall (5000000);
+  SctPrint (L"Wait for the block IO 2 device resetting...");
+  EfiTestWaitForReady (
+    StandardLib,
+    L"EFI_BLOCK_IO2_PROTOCOL.Reset - Wait for the block IO 2 device",
+    BlockIo2ReadyProbe,
+    BlockIo2,
+    EFI_TEST_READY_TIMEOUT
+    );
 
   StandardLib->RecordAssertion (
                  StandardLib,
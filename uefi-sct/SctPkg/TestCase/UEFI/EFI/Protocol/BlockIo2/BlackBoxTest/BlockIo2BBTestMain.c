@@ -45,6 +45,12 @@ EFI_GUID gSupportProtocolGuid1[2] = {
   EFI_NULL_GUID
 };
 
+EFI_GUID gSupportProtocolGuid2[3] = {
+  EFI_STANDARD_TEST_LIBRARY_GUID,
+  EFI_TEST_PROFILE_LIBRARY_GUID,
+  EFI_NULL_GUID
+};
+
 EFI_BB_TEST_ENTRY_FIELD gBBTestEntryField[] = {
   //
   // Conformance test section
@@ -124,6 +130,27 @@ EFI_BB_TEST_ENTRY_FIELD gBBTestEntryField[] = {
     EFI_TEST_CASE_AUTO,
     BBTestMediaInfoCheckAutoTest
   },
+  //
+  // Benchmark section
+  //
+  {
+    BLOCK_IO2_PROTOCOL_READBLOCKSEX_BENCHMARK_GUID,
+    L"ReadBlocksEx_Bench",
+    L"Measure ReadBlocksEx throughput and latency across transfer sizes and queue depths",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gSupportProtocolGuid2,
+    EFI_TEST_CASE_AUTO,
+    BBTestReadBlocksExBenchmarkTest
+  },
+  {
+    BLOCK_IO2_PROTOCOL_WRITEBLOCKSEX_BENCHMARK_GUID,
+    L"WriteBlocksEx_Bench",
+    L"Measure WriteBlocksEx throughput and latency on RAM disks and scratch devices",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gSupportProtocolGuid2,
+    EFI_TEST_CASE_AUTO | EFI_TEST_CASE_DESTRUCTIVE,
+    BBTestWriteBlocksExBenchmarkTest
+  },
   0
 };
 
@@ -660,3 +687,51 @@ FreeAlignedPool (
 
   return Status;
 }
+
+
+/**
+ *  readiness probe of the block device after a reset, see EfiTestWaitForReady
+ *  @param  Context BlockIo2 protocol interface
+ *  @return TRUE if the device answers a read of its first block
+*/
+BOOLEAN
+EFIAPI
+BlockIo2ReadyProbe (
+  IN VOID             *Context
+  )
+{
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  VOID                    *Buffer;
+  EFI_STATUS              Status;
+
+  BlockIo2 = (EFI_BLOCK_IO2_PROTOCOL *)Context;
+
+  //
+  // No media is nothing to wait for
+  //
+  if (!BlockIo2->Media->MediaPresent) {
+    return TRUE;
+  }
+
+  Buffer = AllocateAlignedPool (
+             EfiBootServicesData,
+             BlockIo2->Media->BlockSize,
+             BlockIo2->Media->IoAlign
+             );
+  if (Buffer == NULL) {
+    return TRUE;
+  }
+
+  Status = BlockIo2->ReadBlocksEx (
+                       BlockIo2,
+                       BlockIo2->Media->MediaId,
+                       0,
+                       NULL,
+                       BlockIo2->Media->BlockSize,
+                       Buffer
+                       );
+
+  FreeAlignedPool (Buffer);
+
+  return (BOOLEAN)(Status != EFI_NOT_READY && Status != EFI_DEVICE_ERROR);
+}
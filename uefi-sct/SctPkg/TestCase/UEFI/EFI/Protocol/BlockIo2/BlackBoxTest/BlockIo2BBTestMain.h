@@ -37,6 +37,8 @@ Abstract:
 #include <UEFI/Protocol/BlockIo2.h>
 #include <Library/EfiTestLib.h>
 
+#include EFI_TEST_PROTOCOL_DEFINITION(TestProfileLibrary)
+
 //
 // Definitions
 //
@@ -94,6 +96,15 @@ Abstract:
 #define BLOCK_IO2_PROTOCOL_MEDIAINFO_INTEGRITY_AUTO_GUID \
   { 0xbd03c32b, 0xb8b1, 0x4ff2, { 0xb9, 0xe1, 0x0e, 0xf5, 0x44, 0x05, 0x56, 0x03 } }
 
+//
+// Benchmark
+//
+#define BLOCK_IO2_PROTOCOL_READBLOCKSEX_BENCHMARK_GUID \
+  { 0x40ed5e83, 0x6e1e, 0x4299, { 0xb0, 0x97, 0x59, 0x1a, 0x50, 0xbb, 0xf5, 0x49 } }
+
+#define BLOCK_IO2_PROTOCOL_WRITEBLOCKSEX_BENCHMARK_GUID \
+  { 0x231f0374, 0x5222, 0x4a68, { 0x96, 0x85, 0xfe, 0x42, 0x5c, 0xdf, 0x7f, 0xa9 } }
+
 //
 // Global variables
 //
@@ -197,6 +208,26 @@ BBTestMediaInfoCheckAutoTest (
   IN EFI_HANDLE                 SupportHandle
   );
 
+//
+// Benchmark test case prototypes
+//
+
+EFI_STATUS
+BBTestReadBlocksExBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
+EFI_STATUS
+BBTestWriteBlocksExBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
 //
 // Internal support function prototypes
 //
@@ -241,5 +272,11 @@ FreeAlignedPool (
   IN VOID   *Buffer
   );
 
+BOOLEAN
+EFIAPI
+BlockIo2ReadyProbe (
+  IN VOID             *Context
+  );
+
 #endif
 
@@ -131,3 +131,7 @@ EFI_GUID gBlockIo2FunctionTestAssertionGuid020 = EFI_TEST_BLOCKIO2FUNCTIONTEST_A
 EFI_GUID gBlockIo2FunctionTestAssertionGuid021 = EFI_TEST_BLOCKIO2FUNCTIONTEST_ASSERTION_021_GUID;
 
 EFI_GUID gBlockIo2FunctionTestAssertionGuid022 = EFI_TEST_BLOCKIO2FUNCTIONTEST_ASSERTION_022_GUID;
+
+EFI_GUID gBlockIo2BenchmarkAssertionGuid001 = EFI_TEST_BLOCKIO2BENCHMARK_ASSERTION_001_GUID;
+
+EFI_GUID gBlockIo2BenchmarkAssertionGuid002 = EFI_TEST_BLOCKIO2BENCHMARK_ASSERTION_002_GUID;
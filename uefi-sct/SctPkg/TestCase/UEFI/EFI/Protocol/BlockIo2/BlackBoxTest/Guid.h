@@ -284,3 +284,16 @@ extern EFI_GUID gBlockIo2FunctionTestAssertionGuid021;
 { 0x6739b945, 0x2498, 0x4a1c, { 0x87, 0xb0, 0x85, 0xa4, 0xbe, 0xf6, 0x53, 0x7c } }
 
 extern EFI_GUID gBlockIo2FunctionTestAssertionGuid022;
+
+//
+// Benchmark
+//
+#define EFI_TEST_BLOCKIO2BENCHMARK_ASSERTION_001_GUID \
+{ 0xa5f26e40, 0xeb07, 0x44b3, { 0xb2, 0xdc, 0x64, 0xb7, 0x30, 0x40, 0x0, 0x9a } }
+
+extern EFI_GUID gBlockIo2BenchmarkAssertionGuid001;
+
+#define EFI_TEST_BLOCKIO2BENCHMARK_ASSERTION_002_GUID \
+{ 0x563e922b, 0xc542, 0x4b61, { 0x84, 0x72, 0x38, 0xe, 0x8b, 0x5c, 0xc4, 0xb } }
+
+extern EFI_GUID gBlockIo2BenchmarkAssertionGuid002;
@@ -61,6 +61,7 @@ BBTestResetClearanceManualTest (
 
   EFI_SIMPLE_POINTER_STATE             State;
   UINTN                                WaitIndex;
+  EFI_TEST_INPUT_PROBE_CONTEXT         InputContext;
 
 
 
@@ -188,7 +189,15 @@ BBTestResetClearanceManualTest (
   // Prompt user to input from pointer device
   //
   SctPrint (L"\r\nPlease move the mouse or press some button!\r\n");
-  gtBS->Stall (5000000);
+  InputContext.Event   = SimplePointer->WaitForInput;
+  InputContext.Pending = 0;
+  EfiTestWaitForReady (
+    StandardLib,
+    L"EFI_SIMPLE_POINTER_PROTOCOL - Wait for the pointer input",
+    EfiTestInputReadyProbe,
+    &InputContext,
+    EFI_TEST_READY_TIMEOUT
+    );
 
   //
   // Call WaitForEvent to test whether user had input
@@ -370,7 +379,15 @@ BBTestResetClearanceManualTest (
   // Prompt user to input from pointer device
   //
   SctPrint (L"\r\nPlease move mouse or press some button AGAIN!\r\n");
-  gtBS->Stall (5000000);
+  InputContext.Event   = SimplePointer->WaitForInput;
+  InputContext.Pending = 0;
+  EfiTestWaitForReady (
+    StandardLib,
+    L"EFI_SIMPLE_POINTER_PROTOCOL - Wait for the pointer input",
+    EfiTestInputReadyProbe,
+    &InputContext,
+    EFI_TEST_READY_TIMEOUT
+    );
 
   //
   // Call WaitForEvent to test whether user had input
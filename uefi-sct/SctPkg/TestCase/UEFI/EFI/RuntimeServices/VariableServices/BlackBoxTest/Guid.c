@@ -204,3 +204,5 @@ EFI_GUID gHwErrRecBbTestAssertionGuid003 = EFI_TEST_VARIABLESERVICESBBTEST_HWERR
 
 EFI_GUID gHwErrRecBbTestAssertionGuid004 = EFI_TEST_VARIABLESERVICESBBTEST_HWERRREC_ASSERTION_004_GUID;
 
+EFI_GUID gVariableServicesBbTestBenchmarkAssertionGuid001 = EFI_TEST_VARIABLESERVICESBBTESTBENCHMARK_ASSERTION_001_GUID;
+
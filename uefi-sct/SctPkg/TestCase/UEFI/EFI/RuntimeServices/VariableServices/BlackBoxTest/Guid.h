@@ -462,3 +462,8 @@ extern EFI_GUID gHwErrRecBbTestAssertionGuid003;
 
 extern EFI_GUID gHwErrRecBbTestAssertionGuid004;
 
+#define EFI_TEST_VARIABLESERVICESBBTESTBENCHMARK_ASSERTION_001_GUID \
+{ 0x9f81bd3f, 0x68e9, 0x4184, {0xb8, 0x65, 0xac, 0x53, 0x74, 0x5a, 0xb7, 0xea }}
+
+extern EFI_GUID gVariableServicesBbTestBenchmarkAssertionGuid001;
+
@@ -0,0 +1,821 @@
+/** @file
+
+  Copyright 2006 - 2016 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2016, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  VariableServicesBBTestBenchmark.c
+
+Abstract:
+
+  Source file for Variable Services Black-Box Test - Benchmark.
+
+  The store is populated with N benchmark variables for each N of the
+  sweep, and at each N the cost of GetVariable(), SetVariable(), a full
+  GetNextVariableName() walk and QueryVariableInfo() is recorded, so a
+  store whose lookups are linear in N shows up as a per-call walk cost
+  that grows with N. All benchmark variables live under their own vendor
+  GUID and are deleted again, also those left behind by an interrupted
+  run.
+
+  The sweep is VariableCounts of the [Benchmark] section in
+  VariableServicesBBTest.ini, an ascending list of up to BENCH_MAX_COUNTS
+  values of 1 - BENCH_MAX_VARIABLES, or mBenchVariableCounts if the file
+  or the entry is missing.
+
+--*/
+
+#include "SctLib.h"
+#include "VariableServicesBBTestMain.h"
+
+#define BENCH_MAX_VARIABLES         4096
+#define BENCH_MAX_COUNTS            16
+#define BENCH_SAMPLES               64
+#define BENCH_QUERY_TIMES           16
+#define BENCH_DATA_SIZE             32
+#define BENCH_NAME_SIZE             32
+#define BENCH_RECORD_LEN            256
+
+#define BENCH_INI_DIR               L"Dependency\\VariableServicesBBTest"
+#define BENCH_INI_FILE              L"VariableServicesBBTest.ini"
+#define BENCH_SECTION               L"Benchmark"
+#define BENCH_COUNTS_ENTRY          L"VariableCounts"
+
+//
+// Rough store cost of one benchmark variable: header, name and data
+//
+#define BENCH_VARIABLE_COST         (64 + BENCH_NAME_SIZE + BENCH_DATA_SIZE)
+
+#define BENCH_VENDOR_GUID \
+  { 0xef882d4b, 0x4ab6, 0x4d92, { 0x8f, 0x95, 0x67, 0x2b, 0x16, 0xbb, 0xc5, 0xd8 } }
+
+STATIC UINTN mBenchVariableCounts[] = { 16, 64, 256, 1024 };
+
+STATIC EFI_GUID mBenchVendorGuid = BENCH_VENDOR_GUID;
+
+//
+// One point of the latency curves, all costs per call
+//
+typedef struct {
+  UINTN                       Count;
+  UINTN                       Calls;
+  UINT64                      CreateNs;
+  UINT64                      GetNs;
+  UINT64                      UpdateNs;
+  UINT64                      NextNs;
+  UINT64                      WalkUs;
+  UINT64                      QueryNs;
+} BENCH_POINT;
+
+//
+// Prototypes (internal)
+//
+
+EFI_STATUS
+VariableBenchmarkSub1 (
+  IN EFI_RUNTIME_SERVICES                 *RT,
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL   *StandardLib,
+  IN EFI_TEST_LOGGING_LIBRARY_PROTOCOL    *LoggingLib,
+  IN EFI_TEST_PROFILE_LIBRARY_PROTOCOL    *ProfileLib,
+  IN UINT32                               Attributes
+  );
+
+//
+// Functions
+//
+
+/**
+ *  Entry point for the volatile variable benchmark.
+ *  @param This             A pointer to the EFI_BB_TEST_PROTOCOL instance.
+ *  @param ClientInterface  A pointer to the interface to be tested.
+ *  @param TestLevel        Test "thoroughness" control.
+ *  @param SupportHandle    A handle containing support protocols.
+ *  @return EFI_SUCCESS     Successfully.
+ *  @return Other value     Something failed.
+ */
+EFI_STATUS
+VolatileVariableBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_STANDARD_TEST_LIBRARY_PROTOCOL  *StandardLib;
+  EFI_TEST_RECOVERY_LIBRARY_PROTOCOL  *RecoveryLib;
+  EFI_TEST_LOGGING_LIBRARY_PROTOCOL   *LoggingLib;
+  EFI_TEST_PROFILE_LIBRARY_PROTOCOL   *ProfileLib;
+
+  //
+  // Get test support library interfaces
+  //
+  Status = GetTestSupportLibrary (
+             SupportHandle,
+             &StandardLib,
+             &RecoveryLib,
+             &LoggingLib
+             );
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  //
+  // The profile library is only needed for the configured sweep
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiTestProfileLibraryGuid,
+                   (VOID **) &ProfileLib
+                   );
+  if (EFI_ERROR(Status)) {
+    ProfileLib = NULL;
+  }
+
+  return VariableBenchmarkSub1 (
+           (EFI_RUNTIME_SERVICES *)ClientInterface,
+           StandardLib,
+           LoggingLib,
+           ProfileLib,
+           EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS
+           );
+}
+
+
+/**
+ *  Entry point for the non-volatile variable benchmark.
+ *  @param This             A pointer to the EFI_BB_TEST_PROTOCOL instance.
+ *  @param ClientInterface  A pointer to the interface to be tested.
+ *  @param TestLevel        Test "thoroughness" control.
+ *  @param SupportHandle    A handle containing support protocols.
+ *  @return EFI_SUCCESS     Successfully.
+ *  @return Other value     Something failed.
+ */
+EFI_STATUS
+NonVolatileVariableBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_STANDARD_TEST_LIBRARY_PROTOCOL  *StandardLib;
+  EFI_TEST_RECOVERY_LIBRARY_PROTOCOL  *RecoveryLib;
+  EFI_TEST_LOGGING_LIBRARY_PROTOCOL   *LoggingLib;
+  EFI_TEST_PROFILE_LIBRARY_PROTOCOL   *ProfileLib;
+
+  //
+  // Get test support library interfaces
+  //
+  Status = GetTestSupportLibrary (
+             SupportHandle,
+             &StandardLib,
+             &RecoveryLib,
+             &LoggingLib
+             );
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  //
+  // The profile library is only needed for the configured sweep
+  //
+  Status = gtBS->HandleProtocol (
+                   SupportHandle,
+                   &gEfiTestProfileLibraryGuid,
+                   (VOID **) &ProfileLib
+                   );
+  if (EFI_ERROR(Status)) {
+    ProfileLib = NULL;
+  }
+
+  return VariableBenchmarkSub1 (
+           (EFI_RUNTIME_SERVICES *)ClientInterface,
+           StandardLib,
+           LoggingLib,
+           ProfileLib,
+           EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS
+           );
+}
+
+
+/**
+ *  Nanoseconds since Start, divided by Calls.
+ *  @param Timer    The timer.
+ *  @param Start    The timestamp taken before the calls.
+ *  @param Calls    The number of calls timed.
+ *  @return The cost of one call in nanoseconds.
+ */
+STATIC
+UINT64
+BenchTimerNs (
+  IN SCT_TIMER                *Timer,
+  IN UINT64                   Start,
+  IN UINTN                    Calls
+  )
+{
+  UINT64                      Ns;
+
+  Ns = SctTimerTicksToNs (Timer, SctTimerElapsed (Timer, Start, SctTimerRead (Timer)));
+
+  if (Calls == 0) {
+    return Ns;
+  }
+  return SctDivU64x32 (Ns, Calls, NULL);
+}
+
+
+STATIC
+VOID
+BenchVariableName (
+  IN UINTN                    Index,
+  OUT CHAR16                  *Name
+  )
+{
+  SctSPrint (Name, BENCH_NAME_SIZE * sizeof (CHAR16), L"SctBench%04x", Index);
+}
+
+
+/**
+ *  Delete benchmark variables 0 .. Count - 1, missing ones are skipped.
+ *  @param RT         A pointer to the runtime services.
+ *  @param Count      The number of benchmark variable names to delete.
+ *  @param Deleted    The number of variables that were present.
+ *  @return EFI_SUCCESS   Every present variable was deleted.
+ */
+STATIC
+EFI_STATUS
+BenchDeleteVariables (
+  IN EFI_RUNTIME_SERVICES     *RT,
+  IN UINTN                    Count,
+  OUT UINTN                   *Deleted
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_STATUS                  Result;
+  UINTN                       Index;
+  CHAR16                      Name[BENCH_NAME_SIZE];
+
+  Result   = EFI_SUCCESS;
+  *Deleted = 0;
+
+  for (Index = 0; Index < Count; Index++) {
+    BenchVariableName (Index, Name);
+    Status = RT->SetVariable (Name, &mBenchVendorGuid, 0, 0, NULL);
+    if (Status == EFI_SUCCESS) {
+      (*Deleted)++;
+    } else if (Status != EFI_NOT_FOUND) {
+      Result = Status;
+    }
+  }
+
+  return Result;
+}
+
+
+/**
+ *  Walk every variable of the store with GetNextVariableName().
+ *  @param RT         A pointer to the runtime services.
+ *  @param Calls      The number of GetNextVariableName() calls.
+ *  @return EFI_SUCCESS   The walk reached the end of the store.
+ */
+STATIC
+EFI_STATUS
+BenchWalkVariables (
+  IN EFI_RUNTIME_SERVICES     *RT,
+  OUT UINTN                   *Calls
+  )
+{
+  EFI_STATUS                  Status;
+  CHAR16                      *Name;
+  CHAR16                      *NewName;
+  UINTN                       BufferSize;
+  UINTN                       NameSize;
+  EFI_GUID                    VendorGuid;
+
+  *Calls     = 0;
+  BufferSize = MAX_BUFFER_SIZE;
+  Name       = SctAllocateZeroPool (BufferSize);
+  if (Name == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  while (TRUE) {
+    NameSize = BufferSize;
+    Status   = RT->GetNextVariableName (&NameSize, Name, &VendorGuid);
+    (*Calls)++;
+
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      NewName = SctAllocateZeroPool (NameSize);
+      if (NewName == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+      SctCopyMem (NewName, Name, BufferSize);
+      gtBS->FreePool (Name);
+      Name       = NewName;
+      BufferSize = NameSize;
+      continue;
+    }
+
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+  }
+
+  gtBS->FreePool (Name);
+
+  if (Status == EFI_NOT_FOUND) {
+    return EFI_SUCCESS;
+  }
+  return Status;
+}
+
+
+/**
+ *  Measure the variable services at the current population.
+ *  @param RT         A pointer to the runtime services.
+ *  @param Timer      The timer.
+ *  @param Attributes The attributes of the benchmark variables.
+ *  @param Point      The point with Count set, filled with the costs.
+ *  @return EFI_SUCCESS   Successfully.
+ */
+STATIC
+EFI_STATUS
+BenchMeasurePoint (
+  IN EFI_RUNTIME_SERVICES     *RT,
+  IN SCT_TIMER                *Timer,
+  IN UINT32                   Attributes,
+  IN OUT BENCH_POINT          *Point
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       Samples;
+  UINTN                       Index;
+  UINTN                       DataSize;
+  UINT32                      GetAttributes;
+  UINT8                       Data[BENCH_DATA_SIZE];
+  CHAR16                      Name[BENCH_NAME_SIZE];
+  UINT64                      Start;
+#if (EFI_SPECIFICATION_VERSION >= 0x00020000)
+  UINT64                      MaximumVariableStorageSize;
+  UINT64                      RemainingVariableStorageSize;
+  UINT64                      MaximumVariableSize;
+#endif
+
+  Samples = MINIMUM (Point->Count, BENCH_SAMPLES);
+
+  //
+  // Lookups spread evenly over the population
+  //
+  Start = SctTimerRead (Timer);
+  for (Index = 0; Index < Samples; Index++) {
+    BenchVariableName (Index * Point->Count / Samples, Name);
+    DataSize = BENCH_DATA_SIZE;
+    Status = RT->GetVariable (Name, &mBenchVendorGuid, &GetAttributes, &DataSize, Data);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  Point->GetNs = BenchTimerNs (Timer, Start, Samples);
+
+  //
+  // In-place updates of the same size
+  //
+  SctSetMem (Data, BENCH_DATA_SIZE, (UINT8) Point->Count);
+  Start = SctTimerRead (Timer);
+  for (Index = 0; Index < Samples; Index++) {
+    BenchVariableName (Index * Point->Count / Samples, Name);
+    Status = RT->SetVariable (Name, &mBenchVendorGuid, Attributes, BENCH_DATA_SIZE, Data);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  Point->UpdateNs = BenchTimerNs (Timer, Start, Samples);
+
+  //
+  // Full enumeration
+  //
+  Start  = SctTimerRead (Timer);
+  Status = BenchWalkVariables (RT, &Point->Calls);
+  Point->NextNs = BenchTimerNs (Timer, Start, Point->Calls);
+  Point->WalkUs = SctDivU64x32 (SctMultU64x32 (Point->NextNs, Point->Calls), 1000, NULL);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+#if (EFI_SPECIFICATION_VERSION >= 0x00020000)
+  Start = SctTimerRead (Timer);
+  for (Index = 0; Index < BENCH_QUERY_TIMES; Index++) {
+    Status = RT->QueryVariableInfo (
+                   Attributes,
+                   &MaximumVariableStorageSize,
+                   &RemainingVariableStorageSize,
+                   &MaximumVariableSize
+                   );
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  Point->QueryNs = BenchTimerNs (Timer, Start, BENCH_QUERY_TIMES);
+#endif
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+ *  Check that the store has room for Count more benchmark variables.
+ *  @param RT         A pointer to the runtime services.
+ *  @param Attributes The attributes of the benchmark variables.
+ *  @param Count      The number of variables to be created.
+ *  @return TRUE      Less than half of the remaining space is needed.
+ */
+STATIC
+BOOLEAN
+BenchHasRoom (
+  IN EFI_RUNTIME_SERVICES     *RT,
+  IN UINT32                   Attributes,
+  IN UINTN                    Count
+  )
+{
+#if (EFI_SPECIFICATION_VERSION >= 0x00020000)
+  EFI_STATUS                  Status;
+  UINT64                      MaximumVariableStorageSize;
+  UINT64                      RemainingVariableStorageSize;
+  UINT64                      MaximumVariableSize;
+
+  Status = RT->QueryVariableInfo (
+                 Attributes,
+                 &MaximumVariableStorageSize,
+                 &RemainingVariableStorageSize,
+                 &MaximumVariableSize
+                 );
+  if (EFI_ERROR(Status)) {
+    return TRUE;
+  }
+
+  return (BOOLEAN) (SctMultU64x32 (Count * BENCH_VARIABLE_COST, 2) <= RemainingVariableStorageSize);
+#else
+  return TRUE;
+#endif
+}
+
+
+/**
+ *  Read the sweep from VariableCounts of the [Benchmark] section.
+ *  @param ProfileLib The test profile library, or NULL.
+ *  @param Counts     The BENCH_MAX_COUNTS entries for the sweep.
+ *  @param CountNum   The number of values in Counts.
+ *  @return EFI_SUCCESS           The sweep was read.
+ *  @return EFI_NOT_FOUND         There is no configuration file or entry.
+ *  @return EFI_INVALID_PARAMETER The entry is not an ascending list of
+ *                                1 - BENCH_MAX_VARIABLES.
+ */
+STATIC
+EFI_STATUS
+BenchGetVariableCounts (
+  IN EFI_TEST_PROFILE_LIBRARY_PROTOCOL  *ProfileLib,
+  OUT UINTN                             *Counts,
+  OUT UINTN                             *CountNum
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_DEVICE_PATH_PROTOCOL    *SysDevicePath;
+  CHAR16                      *SysFilePath;
+  CHAR16                      *FilePath;
+  EFI_INI_FILE_HANDLE         FileHandle;
+  UINT32                      MaxLen;
+  CHAR16                      Buffer[BENCH_RECORD_LEN];
+  CHAR16                      *Pointer;
+  UINTN                       Value;
+
+  *CountNum = 0;
+
+  if (ProfileLib == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = ProfileLib->EfiGetSystemDevicePath (
+                         ProfileLib,
+                         &SysDevicePath,
+                         &SysFilePath
+                         );
+  if (EFI_ERROR(Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  FilePath = SctPoolPrint (L"%s\\%s\\%s", SysFilePath, BENCH_INI_DIR, BENCH_INI_FILE);
+  gtBS->FreePool (SysFilePath);
+  if (FilePath == NULL) {
+    gtBS->FreePool (SysDevicePath);
+    return EFI_NOT_FOUND;
+  }
+
+  Status = ProfileLib->EfiIniOpen (
+                         ProfileLib,
+                         SysDevicePath,
+                         FilePath,
+                         &FileHandle
+                         );
+  gtBS->FreePool (FilePath);
+  gtBS->FreePool (SysDevicePath);
+  if (EFI_ERROR(Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  MaxLen    = BENCH_RECORD_LEN;
+  Buffer[0] = L'\0';
+  Status = FileHandle->GetString (
+                         FileHandle,
+                         BENCH_SECTION,
+                         BENCH_COUNTS_ENTRY,
+                         Buffer,
+                         &MaxLen
+                         );
+  ProfileLib->EfiIniClose (ProfileLib, FileHandle);
+  if (EFI_ERROR(Status) || (Buffer[0] == L'\0')) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // The values are separated by spaces or commas
+  //
+  Pointer = Buffer;
+  while (*Pointer != L'\0') {
+    if ((*Pointer == L' ') || (*Pointer == L',') || (*Pointer == L'\t')) {
+      Pointer++;
+      continue;
+    }
+    if ((*Pointer < L'0') || (*Pointer > L'9') || (*CountNum == BENCH_MAX_COUNTS)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Value = SctAtoi (Pointer);
+    if ((Value == 0) || (Value > BENCH_MAX_VARIABLES) ||
+        ((*CountNum != 0) && (Value <= Counts[*CountNum - 1]))) {
+      return EFI_INVALID_PARAMETER;
+    }
+    Counts[(*CountNum)++] = Value;
+
+    while ((*Pointer >= L'0') && (*Pointer <= L'9')) {
+      Pointer++;
+    }
+  }
+
+  return (*CountNum != 0) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+
+/**
+ *  Populate, measure and clean up for every N of the sweep.
+ *  @param RT             A pointer to the runtime services.
+ *  @param StandardLib    A pointer to EFI_STANDARD_TEST_LIBRARY_PROTOCOL
+ *                        instance.
+ *  @param LoggingLib     A pointer to EFI_TEST_LOGGING_LIBRARY_PROTOCOL
+ *                        instance.
+ *  @param ProfileLib     A pointer to EFI_TEST_PROFILE_LIBRARY_PROTOCOL
+ *                        instance, or NULL for the default sweep.
+ *  @param Attributes     The attributes of the benchmark variables.
+ *  @return EFI_SUCCESS   Successfully.
+ *  @return Other value   Something failed.
+ */
+EFI_STATUS
+VariableBenchmarkSub1 (
+  IN EFI_RUNTIME_SERVICES                 *RT,
+  IN EFI_STANDARD_TEST_LIBRARY_PROTOCOL   *StandardLib,
+  IN EFI_TEST_LOGGING_LIBRARY_PROTOCOL    *LoggingLib,
+  IN EFI_TEST_PROFILE_LIBRARY_PROTOCOL    *ProfileLib,
+  IN UINT32                               Attributes
+  )
+{
+  EFI_STATUS            Status;
+  EFI_TEST_ASSERTION    Result;
+  SCT_TIMER             Timer;
+  BENCH_POINT           Point;
+  BENCH_POINT           First;
+  CHAR16                *Kind;
+  CHAR16                Name[BENCH_NAME_SIZE];
+  UINT8                 Data[BENCH_DATA_SIZE];
+  UINTN                 Populated;
+  UINTN                 Deleted;
+  UINTN                 Index;
+  UINTN                 Counts[BENCH_MAX_COUNTS];
+  UINTN                 CountNum;
+  UINTN                 CountIndex;
+  UINT64                Start;
+  UINT64                DeleteNs;
+
+  Kind = (Attributes & EFI_VARIABLE_NON_VOLATILE) ? L"NonVolatile" : L"Volatile";
+
+  //
+  // Trace ...
+  //
+  if (LoggingLib != NULL) {
+    LoggingLib->EnterFunction (
+                  LoggingLib,
+                  L"VariableBenchmarkSub1",
+                  Kind
+                  );
+  }
+
+  Status = SctTimerInit (&Timer);
+  if (EFI_ERROR(Status)) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nTimestamp Protocol not usable (%r), benchmark skipped",
+                   Status
+                   );
+    if (LoggingLib != NULL) {
+      LoggingLib->ExitFunction (
+                    LoggingLib,
+                    L"VariableBenchmarkSub1",
+                    L"No timer"
+                    );
+    }
+    return EFI_SUCCESS;
+  }
+
+  Status = BenchGetVariableCounts (ProfileLib, Counts, &CountNum);
+  if (EFI_ERROR(Status)) {
+    if (Status != EFI_NOT_FOUND) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\n%s of %s is not an ascending list of 1 - %d, the default sweep is used",
+                     BENCH_COUNTS_ENTRY,
+                     BENCH_INI_FILE,
+                     BENCH_MAX_VARIABLES
+                     );
+    }
+    CountNum = sizeof (mBenchVariableCounts) / sizeof (UINTN);
+    SctCopyMem (Counts, mBenchVariableCounts, sizeof (mBenchVariableCounts));
+  }
+
+  //
+  // Remove what an interrupted run left behind
+  //
+  BenchDeleteVariables (RT, BENCH_MAX_VARIABLES, &Deleted);
+  if (Deleted != 0) {
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\nDeleted %d benchmark variables of an earlier run",
+                   Deleted
+                   );
+  }
+
+  SctZeroMem (&First, sizeof (First));
+  SctSetMem (Data, BENCH_DATA_SIZE, 0);
+  Populated = 0;
+  Status    = EFI_SUCCESS;
+
+  for (CountIndex = 0; CountIndex < CountNum; CountIndex++) {
+    SctZeroMem (&Point, sizeof (Point));
+    Point.Count = Counts[CountIndex];
+
+    if (!BenchHasRoom (RT, Attributes, Point.Count - Populated)) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\n%s: not enough variable storage for N=%d, sweep stopped",
+                     Kind,
+                     Point.Count
+                     );
+      break;
+    }
+
+    //
+    // Grow the population to Count
+    //
+    Start = SctTimerRead (&Timer);
+    for (Index = Populated; Index < Point.Count; Index++) {
+      BenchVariableName (Index, Name);
+      Status = RT->SetVariable (Name, &mBenchVendorGuid, Attributes, BENCH_DATA_SIZE, Data);
+      if (EFI_ERROR(Status)) {
+        break;
+      }
+    }
+    Point.CreateNs = BenchTimerNs (&Timer, Start, Index - Populated);
+    Populated      = Index;
+
+    if (EFI_ERROR(Status)) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\n%s: SetVariable failed at %d variables (%r), sweep stopped",
+                     Kind,
+                     Populated,
+                     Status
+                     );
+      break;
+    }
+
+    Status = BenchMeasurePoint (RT, &Timer, Attributes, &Point);
+    if (EFI_ERROR(Status)) {
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\n%s: measurement at N=%d failed (%r), sweep stopped",
+                     Kind,
+                     Point.Count,
+                     Status
+                     );
+      break;
+    }
+
+    StandardLib->RecordMessage (
+                   StandardLib,
+                   EFI_VERBOSE_LEVEL_DEFAULT,
+                   L"\r\n%s N=%d: SetVariable create %ld ns, GetVariable %ld ns, SetVariable update %ld ns, GetNextVariableName %ld ns/call (%d calls, %ld us walk), QueryVariableInfo %ld ns",
+                   Kind,
+                   Point.Count,
+                   Point.CreateNs,
+                   Point.GetNs,
+                   Point.UpdateNs,
+                   Point.NextNs,
+                   Point.Calls,
+                   Point.WalkUs,
+                   Point.QueryNs
+                   );
+
+    if (CountIndex == 0) {
+      First = Point;
+    } else if (First.NextNs != 0) {
+      //
+      // A store that enumerates in O(n^2) shows a per-call cost growing with N
+      //
+      StandardLib->RecordMessage (
+                     StandardLib,
+                     EFI_VERBOSE_LEVEL_DEFAULT,
+                     L"\r\n%s N=%d: GetNextVariableName cost per call is %d%% of N=%d",
+                     Kind,
+                     Point.Count,
+                     (UINTN) SctDivU64x32 (SctMultU64x32 (Point.NextNs, 100), (UINTN) First.NextNs, NULL),
+                     First.Count
+                     );
+    }
+  }
+
+  //
+  // Clean up
+  //
+  Start    = SctTimerRead (&Timer);
+  Status   = BenchDeleteVariables (RT, Populated, &Deleted);
+  DeleteNs = BenchTimerNs (&Timer, Start, Deleted);
+
+  StandardLib->RecordMessage (
+                 StandardLib,
+                 EFI_VERBOSE_LEVEL_DEFAULT,
+                 L"\r\n%s: SetVariable delete %ld ns over %d variables",
+                 Kind,
+                 DeleteNs,
+                 Deleted
+                 );
+
+  if (!EFI_ERROR(Status) && (Deleted == Populated)) {
+    Result = EFI_TEST_ASSERTION_PASSED;
+  } else {
+    Result = EFI_TEST_ASSERTION_FAILED;
+  }
+
+  StandardLib->RecordAssertion (
+                 StandardLib,
+                 Result,
+                 gVariableServicesBbTestBenchmarkAssertionGuid001,
+                 L"RT.SetVariable - Delete every benchmark variable",
+                 L"%a:%d:Status - %r, Populated - %d, Deleted - %d",
+                 __FILE__,
+                 (UINTN)__LINE__,
+                 Status,
+                 Populated,
+                 Deleted
+                 );
+
+  //
+  // Trace ...
+  //
+  if (LoggingLib != NULL) {
+    LoggingLib->ExitFunction (
+                  LoggingLib,
+                  L"VariableBenchmarkSub1",
+                  Kind
+                  );
+  }
+
+  return EFI_SUCCESS;
+}
@@ -46,6 +46,13 @@ EFI_GUID gSupportProtocolGuid[] = {
   EFI_NULL_GUID
 };
 
+EFI_GUID gBenchmarkSupportProtocolGuid[] = {
+  EFI_STANDARD_TEST_LIBRARY_GUID,
+  EFI_TEST_RECOVERY_LIBRARY_GUID,
+  EFI_TEST_PROFILE_LIBRARY_GUID,
+  EFI_NULL_GUID
+};
+
 EFI_BB_TEST_ENTRY_FIELD gBBTestEntryField[] = {
   {
     GET_VARIABLE_CONF_TEST_GUID,
@@ -188,6 +195,24 @@ EFI_BB_TEST_ENTRY_FIELD gBBTestEntryField[] = {
     OverflowStressTest
   },
 #endif
+  {
+    VOLATILE_VARIABLE_BENCHMARK_TEST_GUID,
+    L"Volatile_Benchmark",
+    L"Latency of the variable services against the number of volatile variables",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gBenchmarkSupportProtocolGuid,
+    EFI_TEST_CASE_AUTO,
+    VolatileVariableBenchmarkTest
+  },
+  {
+    NON_VOLATILE_VARIABLE_BENCHMARK_TEST_GUID,
+    L"NonVolatile_Benchmark",
+    L"Latency of the variable services against the number of non-volatile variables",
+    EFI_TEST_LEVEL_EXHAUSTIVE,
+    gBenchmarkSupportProtocolGuid,
+    EFI_TEST_CASE_AUTO,
+    NonVolatileVariableBenchmarkTest
+  },
 
   0
 };
@@ -34,6 +34,7 @@ Abstract:
 
 #include EFI_TEST_PROTOCOL_DEFINITION(TestRecoveryLibrary)
 #include EFI_TEST_PROTOCOL_DEFINITION(TestLoggingLibrary)
+#include EFI_TEST_PROTOCOL_DEFINITION(TestProfileLibrary)
 
 //
 // Definitions
@@ -70,6 +71,11 @@ Abstract:
 #define OVERFLOW_STRESS_TEST_GUID                 \
   { 0xa9f04a54, 0x1f65, 0x44d2, { 0x8b, 0x52, 0xe6, 0xd4, 0xa0, 0x7f, 0x82, 0x1e } }
 
+#define VOLATILE_VARIABLE_BENCHMARK_TEST_GUID     \
+  { 0x94ec5cfa, 0x30bb, 0x4253, { 0x9e, 0x7c, 0xa4, 0xee, 0xc3, 0xdc, 0x08, 0x54 } }
+#define NON_VOLATILE_VARIABLE_BENCHMARK_TEST_GUID \
+  { 0x6046f555, 0xfcf2, 0x471f, { 0xbd, 0xca, 0xad, 0xd3, 0xfa, 0x6d, 0xb6, 0x33 } }
+
 //
 // For QueryVariableInfo
 //
@@ -294,6 +300,25 @@ OverflowStressTest (
   IN EFI_HANDLE                 SupportHandle
   );
 
+//
+// Benchmark
+//
+EFI_STATUS
+VolatileVariableBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
+EFI_STATUS
+NonVolatileVariableBenchmarkTest (
+  IN EFI_BB_TEST_PROTOCOL       *This,
+  IN VOID                       *ClientInterface,
+  IN EFI_TEST_LEVEL             TestLevel,
+  IN EFI_HANDLE                 SupportHandle
+  );
+
 //
 // Support functions
 //
@@ -311,5 +311,11 @@ EFI_STATUS
 FreeAlignedPool (
   IN VOID   *Buffer
   );
+
+BOOLEAN
+EFIAPI
+BlockIoReadyProbe (
+  IN VOID             *Context
+  );
 #endif
 
@@ -96,11 +96,17 @@ BBTestResetStressAutoTest (
     }
 
     //
-    // Sometimes the file system will be destroied from this point. Just add a
-    // stall to avoid it. (Need investigation, I don't know it is useful or not!)
+    // Sometimes the file system will be destroied from this point. Just wait
+    // for the device to answer a read again to avoid it.
     //
-    SctPrint (L"Wait 5 seconds for the block device resetting...");
-    gtBS->Stall (5000000);
+    SctPrint (L"Wait for the block device resetting...");
+    EfiTestWaitForReady (
+      StandardLib,
+      L"EFI_BLOCK_IO_PROTOCOL.Reset - Wait for the block device",
+      BlockIoReadyProbe,
+      BlockIo,
+      EFI_TEST_READY_TIMEOUT
+      );
 
     StandardLib->RecordAssertion (
                    StandardLib,
@@ -128,11 +134,17 @@ BBTestResetStressAutoTest (
     }
 
     //
-    // Sometimes the file system will be destroied from this point. Just add a
-    // stall to avoid it. (Need investigation, I don't know it is useful or not!)
+    // Sometimes the file system will be destroied from this point. Just wait
+    // for the device to answer a read again to avoid it.
     //
-    SctPrint (L"Wait 5 seconds for the block device resetting...");
-    gtBS->Stall (5000000);
+    SctPrint (L"Wait for the block device resetting...");
+    EfiTestWaitForReady (
+      StandardLib,
+      L"EFI_BLOCK_IO_PROTOCOL.Reset - Wait for the block device",
+      BlockIoReadyProbe,
+      BlockIo,
+      EFI_TEST_READY_TIMEOUT
+      );
 
     StandardLib->RecordAssertion (
                    StandardLib,
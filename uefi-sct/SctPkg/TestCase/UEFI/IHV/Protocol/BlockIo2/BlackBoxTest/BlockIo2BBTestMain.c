@@ -660,3 +660,51 @@ FreeAlignedPool (
 
   return Status;
 }
+
+
+/**
+ *  readiness probe of the block device after a reset, see EfiTestWaitForReady
+ *  @param  Context BlockIo2 protocol interface
+ *  @return TRUE if the device answers a read of its first block
+*/
+BOOLEAN
+EFIAPI
+BlockIo2ReadyProbe (
+  IN VOID             *Context
+  )
+{
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  VOID                    *Buffer;
+  EFI_STATUS              Status;
+
+  BlockIo2 = (EFI_BLOCK_IO2_PROTOCOL *)Context;
+
+  //
+  // No media is nothing to wait for
+  //
+  if (!BlockIo2->Media->MediaPresent) {
+    return TRUE;
+  }
+
+  Buffer = AllocateAlignedPool (
+             EfiBootServicesData,
+             BlockIo2->Media->BlockSize,
+             BlockIo2->Media->IoAlign
+             );
+  if (Buffer == NULL) {
+    return TRUE;
+  }
+
+  Status = BlockIo2->ReadBlocksEx (
+                       BlockIo2,
+                       BlockIo2->Media->MediaId,
+                       0,
+                       NULL,
+                       BlockIo2->Media->BlockSize,
+                       Buffer
+                       );
+
+  FreeAlignedPool (Buffer);
+
+  return (BOOLEAN)(Status != EFI_NOT_READY && Status != EFI_DEVICE_ERROR);
+}
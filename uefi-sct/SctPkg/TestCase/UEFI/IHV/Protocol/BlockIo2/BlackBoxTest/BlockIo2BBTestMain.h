@@ -244,5 +244,11 @@ FreeAlignedPool (
   IN VOID   *Buffer
   );
 
+BOOLEAN
+EFIAPI
+BlockIo2ReadyProbe (
+  IN VOID             *Context
+  );
+
 #endif
 
@@ -707,9 +707,10 @@ MyUINTToStr (
 
 
 EFI_STATUS
-WriteLogFile (
+WriteFileData (
   IN STANDARD_TEST_PRIVATE_DATA   *Private,
-  IN CHAR16                       *String,
+  IN VOID                         *Buffer,
+  IN UINTN                        BufSize,
   IN UINT8                        FileType
   )
 {
@@ -719,7 +720,6 @@ WriteLogFile (
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL   *Vol;
   EFI_FILE_HANDLE                   RootDir;  
   EFI_FILE_HANDLE                   FileHandle;
-  UINTN                             BufSize;
 
   Status     = EFI_SUCCESS;
   FileHandle = NULL;
@@ -817,10 +817,9 @@ WriteLogFile (
   }
 
   //
-  // Write the String to the file
+  // Write the data to the file
   //
-  BufSize = SctStrLen(String) * 2;
-  Status = FileHandle->Write (FileHandle, &BufSize, String);
+  Status = FileHandle->Write (FileHandle, &BufSize, Buffer);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -831,6 +830,76 @@ WriteLogFile (
   return Status;
 }
 
+EFI_STATUS
+WriteLogFile (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN CHAR16                       *String,
+  IN UINT8                        FileType
+  )
+{
+  return WriteFileData (Private, String, SctStrLen (String) * 2, FileType);
+}
+
+EFI_STATUS
+WriteKeyAssertion (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_TEST_ASSERTION           Type,
+  IN EFI_GUID                     *EventId,
+  IN CHAR16                       *Description,
+  IN CHAR16                       *Detail
+  )
+/*++
+
+Routine Description:
+
+  Write an assertion record to the binary key files, with an inline
+  description since the interned ones belong to the test library. The
+  description and the detail are each cut to EFI_MAX_PRINT_BUFFER - 1
+  characters, so the record always fits in its buffer.
+
+--*/
+{
+  EFI_STATUS                      Status;
+  EFI_KEY_FILE_ASSERTION_RECORD   Assertion;
+  UINT8                           Record[sizeof(EFI_KEY_FILE_ASSERTION_RECORD) + 2 * EFI_MAX_PRINT_BUFFER * sizeof(CHAR16)];
+  UINTN                           Offset;
+  UINTN                           Length;
+
+  Offset = sizeof(EFI_KEY_FILE_ASSERTION_RECORD);
+  Length = SctStrLen (Description);
+  if (Length > EFI_MAX_PRINT_BUFFER - 1) {
+    Length = EFI_MAX_PRINT_BUFFER - 1;
+  }
+  SctCopyMem (Record + Offset, Description, Length * sizeof(CHAR16));
+  Offset += Length * sizeof(CHAR16);
+  SctZeroMem (Record + Offset, sizeof(CHAR16));
+  Offset += sizeof(CHAR16);
+
+  Length = SctStrLen (Detail);
+  if (Length > EFI_MAX_PRINT_BUFFER - 1) {
+    Length = EFI_MAX_PRINT_BUFFER - 1;
+  }
+  SctCopyMem (Record + Offset, Detail, Length * sizeof(CHAR16));
+  Offset += Length * sizeof(CHAR16);
+  SctZeroMem (Record + Offset, sizeof(CHAR16));
+  Offset += sizeof(CHAR16);
+
+  SctZeroMem (&Assertion, sizeof(EFI_KEY_FILE_ASSERTION_RECORD));
+  Assertion.Record.Type   = EFI_KEY_FILE_RECORD_ASSERTION;
+  Assertion.Record.Size   = (UINT16) Offset;
+  Assertion.Result        = (UINT8) Type;
+  Assertion.DescriptionId = EFI_KEY_FILE_INLINE_DESCRIPTION;
+  SctCopyMem (&Assertion.EventId, EventId, sizeof(EFI_GUID));
+  SctCopyMem (Record, &Assertion, sizeof(EFI_KEY_FILE_ASSERTION_RECORD));
+
+  Status = WriteFileData (Private, Record, Offset, SYSTEMKEY);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return WriteFileData (Private, Record, Offset, CASEKEY);
+}
+
 
 
 STATIC
@@ -937,6 +1006,17 @@ Returns:
   // To disable the remotion assertion function in this case
   //NetRecordAssertion((NET_EFI_TEST_ASSERTION) Type, EventId, Buffer);
   
+  //
+  // write key file detail record in the binary format
+  //
+  if (Private->BinaryKeyFile) {
+    VA_START(Marker, Detail);
+    DBVSPrint (Buffer, EFI_MAX_PRINT_BUFFER, Detail, Marker);
+    VA_END (Marker);
+
+    return WriteKeyAssertion (Private, Type, &EventId, Description, Buffer);
+  }
+
   //
   // write key file detail line
   //
@@ -982,6 +1062,7 @@ EndLogging (
   UINT32                          DaysElapsed;
   UINT32                          HoursElapsed;
   UINT32                          MunitesElapsed;
+  EFI_KEY_FILE_TERM_RECORD        Term;
 
   Private = STANDARD_TEST_PRIVATE_DATA_FROM_STSL (This);
 
@@ -1113,6 +1194,27 @@ EndLogging (
   WriteLogFile (Private, DashLine, SYSTEMLOG);
   WriteLogFile (Private, DashLine, CASELOG);
 
+  //
+  // Write key file terminator record in the binary format
+  //
+  if (Private->BinaryKeyFile) {
+    SctZeroMem (&Term, sizeof(EFI_KEY_FILE_TERM_RECORD));
+    Term.Record.Type    = EFI_KEY_FILE_RECORD_TERM;
+    Term.Record.Size    = (UINT16) sizeof(EFI_KEY_FILE_TERM_RECORD);
+    Term.TestStatus     = (UINT16)(Status & 0xFFFF);
+    Term.EndTime.Year   = CurrentTime.Year;
+    Term.EndTime.Month  = CurrentTime.Month;
+    Term.EndTime.Day    = CurrentTime.Day;
+    Term.EndTime.Hour   = CurrentTime.Hour;
+    Term.EndTime.Minute = CurrentTime.Minute;
+    Term.EndTime.Second = CurrentTime.Second;
+    Term.ElapsedSeconds = ((DaysElapsed * HOURS_PER_DAY + HoursElapsed) * MINS_PER_HOUR + MunitesElapsed) * SECS_PER_MIN + SecondsElapsed;
+
+    WriteFileData (Private, &Term, sizeof(EFI_KEY_FILE_TERM_RECORD), SYSTEMKEY);
+    WriteFileData (Private, &Term, sizeof(EFI_KEY_FILE_TERM_RECORD), CASEKEY);
+    return;
+  }
+
   //
   // Write key file terminator line
   //
@@ -288,6 +288,7 @@ BBTestResetFunctionManualTest (
   CHAR16                               *DevicePathStr;
 
   EFI_INPUT_KEY                        Key;
+  EFI_TEST_INPUT_PROBE_CONTEXT         InputContext;
 
 
   //
@@ -391,9 +392,17 @@ BBTestResetFunctionManualTest (
   SctPrint (L"Press some displayble keys in 5 second!");
 
   //
-  // Wait 5 seconds
+  // Wait for the keys, 5 seconds at most
   //
-  gtBS->Stall (5000000);
+  InputContext.Event   = SimpleIn->WaitForKey;
+  InputContext.Pending = 0;
+  EfiTestWaitForReady (
+    StandardLib,
+    L"EFI_SIMPLE_TEXT_IN_PROTOCOL - Wait for the key input",
+    EfiTestInputReadyProbe,
+    &InputContext,
+    EFI_TEST_READY_TIMEOUT
+    );
 
   //
   // Call SimpleTextIn.Reset with ExtendedVerification as FALSE again
@@ -467,9 +476,17 @@ BBTestResetFunctionManualTest (
   SctPrint (L"Press some displayble keys in 5 second AGAIN!");
 
   //
-  // Wait 5 seconds
+  // Wait for the keys, 5 seconds at most
   //
-  gtBS->Stall (5000000);
+  InputContext.Event   = SimpleIn->WaitForKey;
+  InputContext.Pending = 0;
+  EfiTestWaitForReady (
+    StandardLib,
+    L"EFI_SIMPLE_TEXT_IN_PROTOCOL - Wait for the key input",
+    EfiTestInputReadyProbe,
+    &InputContext,
+    EFI_TEST_READY_TIMEOUT
+    );
 
   //
   // Call SimpleTextIn.Reset with ExtendedVerification as TRUE again
@@ -0,0 +1,131 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2017, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  KeyFile.h
+
+Abstract:
+
+  This file defines the binary format of the key files. A binary key file has
+  the same name as a text key file, and starts with the same Unicode flag
+  0xFEFF written by the test output library. Each logging session appends a
+  segment:
+
+    EFI_KEY_FILE_HEADER
+    EFI_KEY_FILE_HEAD_RECORD          (not in a recovered session)
+    EFI_KEY_FILE_DESCRIPTION_RECORD   (before the first use of a description)
+    EFI_KEY_FILE_ASSERTION_RECORD     ...
+    EFI_KEY_FILE_TERM_RECORD
+
+  All values are little-endian. The strings are null-terminated CHAR16
+  strings following the fixed part of a record, and the size of a record is
+  always even. The description IDs are only valid in their own segment.
+
+  The host tools (GenReport, ExportKeyFile) have their own copy of these
+  definitions.
+
+--*/
+
+#ifndef _EFI_KEY_FILE_H_
+#define _EFI_KEY_FILE_H_
+
+//
+// Definitions
+//
+
+#define EFI_KEY_FILE_SIGNATURE              EFI_SIGNATURE_32('S','K','E','Y')
+#define EFI_KEY_FILE_VERSION                0x0001
+
+#define EFI_KEY_FILE_RECORD_HEAD            0x0001
+#define EFI_KEY_FILE_RECORD_DESCRIPTION     0x0002
+#define EFI_KEY_FILE_RECORD_ASSERTION       0x0003
+#define EFI_KEY_FILE_RECORD_TERM            0x0004
+
+//
+// An assertion with this description ID carries its description inline,
+// before the detail string
+//
+#define EFI_KEY_FILE_INLINE_DESCRIPTION     0xFFFF
+#define EFI_KEY_FILE_MAX_DESCRIPTION        0xFFFF
+
+#pragma pack(1)
+
+typedef struct {
+  UINT32                              Signature;
+  UINT16                              Version;
+  UINT16                              HeaderSize;
+} EFI_KEY_FILE_HEADER;
+
+typedef struct {
+  UINT16                              Type;
+  UINT16                              Size;
+} EFI_KEY_FILE_RECORD;
+
+typedef struct {
+  UINT16                              Year;
+  UINT8                               Month;
+  UINT8                               Day;
+  UINT8                               Hour;
+  UINT8                               Minute;
+  UINT8                               Second;
+  UINT8                               Reserved;
+} EFI_KEY_FILE_TIME;
+
+//
+// Followed by the scenario, entry name, test name, test category and device
+// path strings
+//
+typedef struct {
+  EFI_KEY_FILE_RECORD                 Record;
+  UINT32                              ConfigurationNumber;
+  EFI_GUID                            EntryId;
+  UINT64                              TestRevision;
+  EFI_KEY_FILE_TIME                   StartTime;
+} EFI_KEY_FILE_HEAD_RECORD;
+
+//
+// Followed by the description string
+//
+typedef struct {
+  EFI_KEY_FILE_RECORD                 Record;
+  UINT16                              Id;
+} EFI_KEY_FILE_DESCRIPTION_RECORD;
+
+//
+// Result is an EFI_TEST_ASSERTION value and Timestamp is the seconds since
+// the start of the session. Followed by the description string if it is
+// inline, and the detail string.
+//
+typedef struct {
+  EFI_KEY_FILE_RECORD                 Record;
+  UINT8                               Result;
+  UINT8                               Reserved;
+  UINT16                              DescriptionId;
+  EFI_GUID                            EventId;
+  UINT32                              Timestamp;
+} EFI_KEY_FILE_ASSERTION_RECORD;
+
+typedef struct {
+  EFI_KEY_FILE_RECORD                 Record;
+  UINT16                              TestStatus;
+  EFI_KEY_FILE_TIME                   EndTime;
+  UINT32                              ElapsedSeconds;
+} EFI_KEY_FILE_TERM_RECORD;
+
+#pragma pack()
+
+#endif
@@ -102,6 +102,11 @@ typedef struct {
   //
   CHAR16                              *TestCategory;
   CHAR16                              *DevicePath;
+
+  //
+  // Key files' format, see KeyFile.h for the binary format
+  //
+  BOOLEAN                             BinaryKeyFile;
 } EFI_LIB_CONFIG_DATA;
 
 #endif
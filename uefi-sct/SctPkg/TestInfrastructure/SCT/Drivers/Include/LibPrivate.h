@@ -34,6 +34,7 @@ Abstract:
 //
 
 #include "LibConfig.h"
+#include "KeyFile.h"
 
 //
 // Private interface for each test support library
@@ -157,6 +157,57 @@ StslFreePointer (
   IN STANDARD_TEST_PRIVATE_DATA   *Private
   );
 
+EFI_STATUS
+StslWriteKeyData (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer
+  );
+
+UINTN
+StslAppendKeyString (
+  IN OUT UINT8                    *Record,
+  IN UINTN                        Offset,
+  IN CHAR16                       *String,
+  IN UINTN                        Length
+  );
+
+EFI_STATUS
+StslWriteKeyHead (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_TIME                     *CurrentTime
+  );
+
+EFI_STATUS
+StslWriteKeyAssertion (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_TEST_ASSERTION           Type,
+  IN EFI_GUID                     *EventId,
+  IN CHAR16                       *Description,
+  IN CHAR16                       *Detail,
+  IN UINTN                        DetailLength
+  );
+
+EFI_STATUS
+StslWriteKeyTerm (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_STATUS                   TestStatus,
+  IN EFI_TIME                     *CurrentTime,
+  IN UINT32                       ElapsedSeconds
+  );
+
+EFI_STATUS
+StslInternDescription (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN CHAR16                       *Description,
+  OUT UINT16                      *DescriptionId
+  );
+
+VOID
+StslFreeDescriptions (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private
+  );
+
 //
 // Global variables and definitions
 //
@@ -563,6 +614,7 @@ Returns:
   CHAR16                          Buffer[EFI_MAX_PRINT_BUFFER];
   CHAR16                          AssertionDetail[EFI_MAX_PRINT_BUFFER];
   CHAR16                          AssertionType[10];
+  UINTN                           DetailLength;
   STANDARD_TEST_PRIVATE_DATA      *Private;
 
   Private = STANDARD_TEST_PRIVATE_DATA_FROM_STSL (This);
@@ -581,7 +633,8 @@ Returns:
   SctVSPrint (AssertionDetail, EFI_MAX_PRINT_BUFFER, Detail, Marker);
   VA_END (Marker);
 
-  if ( SctStrLen (AssertionDetail) + 5 < EFI_MAX_PRINT_BUFFER) {
+  DetailLength = SctStrLen (AssertionDetail);
+  if ( DetailLength + 5 < EFI_MAX_PRINT_BUFFER) {
     SctStrCat (AssertionDetail, L"\r\n");
   }
 
@@ -624,6 +677,20 @@ Returns:
   //
   NetRecordAssertion((NET_EFI_TEST_ASSERTION) Type, EventId, Buffer);
   
+  //
+  // Write key file detail record, the binary one is not formatted at all
+  //
+  if (Private->BinaryKeyFile) {
+    return StslWriteKeyAssertion (
+             Private,
+             Type,
+             &EventId,
+             Description,
+             AssertionDetail,
+             DetailLength
+             );
+  }
+
   //
   // write key file detail line
   //
@@ -776,6 +843,13 @@ Returns:
   //
   Private->OutputProtocol = Config->OutputProtocol;
 
+  //
+  // Key file format, the binary one needs the WriteData interface
+  //
+  Private->BinaryKeyFile  = (BOOLEAN) (Config->BinaryKeyFile &&
+                            (Config->OutputProtocol->LibraryRevision >=
+                             EFI_TEST_OUTPUT_LIBRARY_REVISION_WRITE_DATA));
+
   //
   // SystemLogFile
   //
@@ -996,11 +1070,13 @@ Returns:
   EFI_LIB_CONFIG_FILE_HANDLE        *FileConf;
   EFI_GUID                          *Guid;
   EFI_TIME                          *CurrentTime;
+  EFI_KEY_FILE_HEADER               KeyFileHeader;
 
   Private = STANDARD_TEST_PRIVATE_DATA_FROM_PI (This);
   Output = Private->OutputProtocol;
 
   StslCloseAllFiles (Private);
+  StslFreeDescriptions (Private);
 
   //
   // Open log and key files
@@ -1070,6 +1146,17 @@ Returns:
     return Status;
   }
 
+  //
+  // Each session starts a new segment of the binary key files, a recovered
+  // session has no head record
+  //
+  if (Private->BinaryKeyFile) {
+    KeyFileHeader.Signature  = EFI_KEY_FILE_SIGNATURE;
+    KeyFileHeader.Version    = EFI_KEY_FILE_VERSION;
+    KeyFileHeader.HeaderSize = (UINT16) sizeof(EFI_KEY_FILE_HEADER);
+    StslWriteKeyData (Private, sizeof(EFI_KEY_FILE_HEADER), &KeyFileHeader);
+  }
+
   //
   // Write log file header data
   //
@@ -1128,30 +1215,50 @@ Returns:
 
     StslWriteLogFile (Private, DashLine);
 
-    //
-    // Write key file header line
-    //
-    SctSPrint (
-      Buffer, EFI_MAX_PRINT_BUFFER, L"|HEAD|||%d|%s|%02d-%02d-%04d|%02d:%02d:%02d|%g|0x%08lx|%s|%s|%s|%s\n",
-      Private->ConfigurationNumber,
-      Private->ScenarioString,
-      CurrentTime->Day,
-      CurrentTime->Month,
-      CurrentTime->Year,
-      CurrentTime->Hour,
-      CurrentTime->Minute,
-      CurrentTime->Second,
-      &Private->EntryId,
-      Private->TestRevision,
-      Private->EntryName,
-      Private->TestName,
-      Private->TestCategory,
-      Private->DevicePath
-      );
-
-    StslWriteKeyFile (Private, Buffer);
+    if (Private->BinaryKeyFile) {
+      //
+      // Write key file head record
+      //
+      StslWriteKeyHead (Private, CurrentTime);
+    } else {
+      //
+      // Write key file header line
+      //
+      SctSPrint (
+        Buffer, EFI_MAX_PRINT_BUFFER, L"|HEAD|||%d|%s|%02d-%02d-%04d|%02d:%02d:%02d|%g|0x%08lx|%s|%s|%s|%s\n",
+        Private->ConfigurationNumber,
+        Private->ScenarioString,
+        CurrentTime->Day,
+        CurrentTime->Month,
+        CurrentTime->Year,
+        CurrentTime->Hour,
+        CurrentTime->Minute,
+        CurrentTime->Second,
+        &Private->EntryId,
+        Private->TestRevision,
+        Private->EntryName,
+        Private->TestName,
+        Private->TestCategory,
+        Private->DevicePath
+        );
+
+      StslWriteKeyFile (Private, Buffer);
+    }
   }
 
+  //
+  // The assertion timestamps are relative to the start of the session
+  //
+  Private->StartSeconds = SecondsElapsedFromBaseYear (
+                            Private->StartTime.Year,
+                            Private->StartTime.Year,
+                            Private->StartTime.Month,
+                            Private->StartTime.Day,
+                            Private->StartTime.Hour,
+                            Private->StartTime.Minute,
+                            Private->StartTime.Second
+                            );
+
   //
   // Initial private data
   //
@@ -1302,26 +1409,36 @@ Returns:
   //
   // Write key file terminator line
   //
-  SctSPrint (
-    Buffer, EFI_MAX_PRINT_BUFFER, L"|TERM|%04x|%02d-%02d-%04d|%02d:%02d:%02d|%d %02d:%02d:%02d\n",
-    (UINT16)(TestStatus & 0xFFFF),
-    CurrentTime.Day,
-    CurrentTime.Month,
-    CurrentTime.Year,
-    CurrentTime.Hour,
-    CurrentTime.Minute,
-    CurrentTime.Second,
-    DaysElapsed,
-    HoursElapsed,
-    MunitesElapsed,
-    SecondsElapsed
-    );
-  StslWriteKeyFile (Private, Buffer);
+  if (Private->BinaryKeyFile) {
+    StslWriteKeyTerm (
+      Private,
+      TestStatus,
+      &CurrentTime,
+      ((DaysElapsed * HOURS_PER_DAY + HoursElapsed) * MINS_PER_HOUR + MunitesElapsed) * SECS_PER_MIN + SecondsElapsed
+      );
+  } else {
+    SctSPrint (
+      Buffer, EFI_MAX_PRINT_BUFFER, L"|TERM|%04x|%02d-%02d-%04d|%02d:%02d:%02d|%d %02d:%02d:%02d\n",
+      (UINT16)(TestStatus & 0xFFFF),
+      CurrentTime.Day,
+      CurrentTime.Month,
+      CurrentTime.Year,
+      CurrentTime.Hour,
+      CurrentTime.Minute,
+      CurrentTime.Second,
+      DaysElapsed,
+      HoursElapsed,
+      MunitesElapsed,
+      SecondsElapsed
+      );
+    StslWriteKeyFile (Private, Buffer);
+  }
 
   //
   // Close log and key files
   //
   StslCloseAllFiles (Private);
+  StslFreeDescriptions (Private);
 
   Private->BeginLogging   = FALSE;
 
@@ -1497,6 +1614,360 @@ StslWriteKeyFile (
   return Status;
 }
 
+EFI_STATUS
+StslWriteKeyData (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Write a binary record to the system and case key files. A record is always
+  written at once, so a key file only holds complete records.
+
+--*/
+{
+  EFI_STATUS                        Status;
+  EFI_TEST_OUTPUT_LIBRARY_PROTOCOL  *Output;
+  EFI_FILE_HANDLE                   FileHandle;
+
+  Output = Private->OutputProtocol;
+  Status = EFI_SUCCESS;
+
+  //
+  // System key file
+  //
+  FileHandle = Private->SystemKeyFile.FileHandle;
+  if (FileHandle != NULL) {
+    Status = Output->WriteData (Output, FileHandle, BufferSize, Buffer);
+    if ( EFI_ERROR (Status) ) {
+      return Status;
+    }
+  }
+
+  //
+  // Case key file
+  //
+  FileHandle = Private->CaseKeyFile.FileHandle;
+  if (FileHandle != NULL) {
+    Status = Output->WriteData (Output, FileHandle, BufferSize, Buffer);
+  }
+
+  return Status;
+}
+
+UINTN
+StslAppendKeyString (
+  IN OUT UINT8                    *Record,
+  IN UINTN                        Offset,
+  IN CHAR16                       *String,
+  IN UINTN                        Length
+  )
+/*++
+
+Routine Description:
+
+  Append Length characters of a string and a null terminator to a binary
+  record. Returns the offset after the terminator.
+
+--*/
+{
+  SctCopyMem (Record + Offset, String, Length * sizeof(CHAR16));
+  Offset += Length * sizeof(CHAR16);
+  Record[Offset]     = 0;
+  Record[Offset + 1] = 0;
+
+  return Offset + sizeof(CHAR16);
+}
+
+EFI_STATUS
+StslWriteKeyHead (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_TIME                     *CurrentTime
+  )
+/*++
+
+Routine Description:
+
+  Write the head record of the binary key files.
+
+--*/
+{
+  EFI_STATUS                Status;
+  EFI_KEY_FILE_HEAD_RECORD  Head;
+  CHAR16                    *Strings[5];
+  UINTN                     Index;
+  UINTN                     Size;
+  UINTN                     Offset;
+  UINT8                     *Record;
+
+  Strings[0] = Private->ScenarioString;
+  Strings[1] = Private->EntryName;
+  Strings[2] = Private->TestName;
+  Strings[3] = Private->TestCategory;
+  Strings[4] = Private->DevicePath;
+
+  Size = sizeof(EFI_KEY_FILE_HEAD_RECORD);
+  for (Index = 0; Index < 5; Index ++) {
+    Size += (SctStrLen (Strings[Index]) + 1) * sizeof(CHAR16);
+  }
+
+  if (Size > 0xFFFF) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Status = tBS->AllocatePool (
+                  EfiBootServicesData,
+                  Size,
+                  (VOID **)&Record
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SctZeroMem (&Head, sizeof(EFI_KEY_FILE_HEAD_RECORD));
+  Head.Record.Type          = EFI_KEY_FILE_RECORD_HEAD;
+  Head.Record.Size          = (UINT16) Size;
+  Head.ConfigurationNumber  = Private->ConfigurationNumber;
+  Head.TestRevision         = Private->TestRevision;
+  Head.StartTime.Year       = CurrentTime->Year;
+  Head.StartTime.Month      = CurrentTime->Month;
+  Head.StartTime.Day        = CurrentTime->Day;
+  Head.StartTime.Hour       = CurrentTime->Hour;
+  Head.StartTime.Minute     = CurrentTime->Minute;
+  Head.StartTime.Second     = CurrentTime->Second;
+  SctCopyMem (&Head.EntryId, &Private->EntryId, sizeof(EFI_GUID));
+
+  SctCopyMem (Record, &Head, sizeof(EFI_KEY_FILE_HEAD_RECORD));
+  Offset = sizeof(EFI_KEY_FILE_HEAD_RECORD);
+  for (Index = 0; Index < 5; Index ++) {
+    Offset = StslAppendKeyString (Record, Offset, Strings[Index], SctStrLen (Strings[Index]));
+  }
+
+  Status = StslWriteKeyData (Private, Size, Record);
+
+  tBS->FreePool (Record);
+  return Status;
+}
+
+EFI_STATUS
+StslWriteKeyAssertion (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_TEST_ASSERTION           Type,
+  IN EFI_GUID                     *EventId,
+  IN CHAR16                       *Description,
+  IN CHAR16                       *Detail,
+  IN UINTN                        DetailLength
+  )
+/*++
+
+Routine Description:
+
+  Write an assertion record to the binary key files. The description is
+  interned, so it is only written once in a segment.
+
+--*/
+{
+  EFI_KEY_FILE_ASSERTION_RECORD   Assertion;
+  UINT8                           Record[sizeof(EFI_KEY_FILE_ASSERTION_RECORD) + 2 * EFI_MAX_PRINT_BUFFER * sizeof(CHAR16)];
+  UINTN                           Offset;
+  UINT16                          DescriptionId;
+  EFI_TIME                        CurrentTime;
+  UINT32                          Seconds;
+
+  //
+  // An out of resources interning falls back to an inline description
+  //
+  if (EFI_ERROR (StslInternDescription (Private, Description, &DescriptionId))) {
+    DescriptionId = EFI_KEY_FILE_INLINE_DESCRIPTION;
+  }
+
+  Seconds = 0;
+  if (tRT->GetTime (&CurrentTime, NULL) == EFI_SUCCESS) {
+    Seconds = SecondsElapsedFromBaseYear (
+                Private->StartTime.Year,
+                CurrentTime.Year,
+                CurrentTime.Month,
+                CurrentTime.Day,
+                CurrentTime.Hour,
+                CurrentTime.Minute,
+                CurrentTime.Second
+                );
+    Seconds = (Seconds >= Private->StartSeconds) ? Seconds - Private->StartSeconds : 0;
+  }
+
+  Offset = sizeof(EFI_KEY_FILE_ASSERTION_RECORD);
+  if (DescriptionId == EFI_KEY_FILE_INLINE_DESCRIPTION) {
+    Offset = StslAppendKeyString (Record, Offset, Description, SctStrLen (Description));
+  }
+  Offset = StslAppendKeyString (Record, Offset, Detail, DetailLength);
+
+  Assertion.Record.Type   = EFI_KEY_FILE_RECORD_ASSERTION;
+  Assertion.Record.Size   = (UINT16) Offset;
+  Assertion.Result        = (UINT8) Type;
+  Assertion.Reserved      = 0;
+  Assertion.DescriptionId = DescriptionId;
+  Assertion.Timestamp     = Seconds;
+  SctCopyMem (&Assertion.EventId, EventId, sizeof(EFI_GUID));
+  SctCopyMem (Record, &Assertion, sizeof(EFI_KEY_FILE_ASSERTION_RECORD));
+
+  return StslWriteKeyData (Private, Offset, Record);
+}
+
+EFI_STATUS
+StslWriteKeyTerm (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN EFI_STATUS                   TestStatus,
+  IN EFI_TIME                     *CurrentTime,
+  IN UINT32                       ElapsedSeconds
+  )
+/*++
+
+Routine Description:
+
+  Write the terminator record of the binary key files.
+
+--*/
+{
+  EFI_KEY_FILE_TERM_RECORD  Term;
+
+  SctZeroMem (&Term, sizeof(EFI_KEY_FILE_TERM_RECORD));
+  Term.Record.Type      = EFI_KEY_FILE_RECORD_TERM;
+  Term.Record.Size      = (UINT16) sizeof(EFI_KEY_FILE_TERM_RECORD);
+  Term.TestStatus       = (UINT16) (TestStatus & 0xFFFF);
+  Term.EndTime.Year     = CurrentTime->Year;
+  Term.EndTime.Month    = CurrentTime->Month;
+  Term.EndTime.Day      = CurrentTime->Day;
+  Term.EndTime.Hour     = CurrentTime->Hour;
+  Term.EndTime.Minute   = CurrentTime->Minute;
+  Term.EndTime.Second   = CurrentTime->Second;
+  Term.ElapsedSeconds   = ElapsedSeconds;
+
+  return StslWriteKeyData (Private, sizeof(EFI_KEY_FILE_TERM_RECORD), &Term);
+}
+
+EFI_STATUS
+StslInternDescription (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private,
+  IN CHAR16                       *Description,
+  OUT UINT16                      *DescriptionId
+  )
+/*++
+
+Routine Description:
+
+  Get the ID of a description in the current segment of the binary key files.
+  A new description is added into the hash table and its description record
+  is written before it is used.
+
+--*/
+{
+  EFI_STATUS                        Status;
+  UINT32                            Hash;
+  UINTN                             Length;
+  CHAR16                            *Char;
+  STSL_DESCRIPTION                  *Entry;
+  EFI_KEY_FILE_DESCRIPTION_RECORD   *Record;
+  UINTN                             Size;
+
+  //
+  // FNV-1a hash of the description
+  //
+  Hash = 2166136261U;
+  for (Char = Description; *Char != L'\0'; Char ++) {
+    Hash = (Hash ^ *Char) * 16777619U;
+  }
+  Length = (UINTN) (Char - Description);
+
+  for (Entry = Private->DescriptionTable[Hash % STSL_DESCRIPTION_HASH_SIZE];
+       Entry != NULL;
+       Entry = Entry->Next) {
+    if ((Entry->Hash == Hash) && (SctStrCmp (Entry->Text, Description) == 0)) {
+      *DescriptionId = Entry->Id;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (Private->DescriptionCount >= EFI_KEY_FILE_MAX_DESCRIPTION) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Add a new description
+  //
+  Status = tBS->AllocatePool (
+                  EfiBootServicesData,
+                  sizeof(STSL_DESCRIPTION) + Length * sizeof(CHAR16),
+                  (VOID **)&Entry
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Size = sizeof(EFI_KEY_FILE_DESCRIPTION_RECORD) + (Length + 1) * sizeof(CHAR16);
+  Status = tBS->AllocatePool (
+                  EfiBootServicesData,
+                  Size,
+                  (VOID **)&Record
+                  );
+  if (EFI_ERROR (Status)) {
+    tBS->FreePool (Entry);
+    return Status;
+  }
+
+  Entry->Hash = Hash;
+  Entry->Id   = (UINT16) Private->DescriptionCount;
+  SctCopyMem (Entry->Text, Description, (Length + 1) * sizeof(CHAR16));
+
+  Record->Record.Type = EFI_KEY_FILE_RECORD_DESCRIPTION;
+  Record->Record.Size = (UINT16) Size;
+  Record->Id          = Entry->Id;
+  SctCopyMem (Record + 1, Description, (Length + 1) * sizeof(CHAR16));
+
+  Status = StslWriteKeyData (Private, Size, Record);
+  tBS->FreePool (Record);
+  if (EFI_ERROR (Status)) {
+    tBS->FreePool (Entry);
+    return Status;
+  }
+
+  Entry->Next = Private->DescriptionTable[Hash % STSL_DESCRIPTION_HASH_SIZE];
+  Private->DescriptionTable[Hash % STSL_DESCRIPTION_HASH_SIZE] = Entry;
+  Private->DescriptionCount ++;
+
+  *DescriptionId = Entry->Id;
+  return EFI_SUCCESS;
+}
+
+VOID
+StslFreeDescriptions (
+  IN STANDARD_TEST_PRIVATE_DATA   *Private
+  )
+/*++
+
+Routine Description:
+
+  Free the interned descriptions, a new segment of the binary key files
+  starts with an empty description table.
+
+--*/
+{
+  UINTN             Index;
+  STSL_DESCRIPTION  *Entry;
+
+  for (Index = 0; Index < STSL_DESCRIPTION_HASH_SIZE; Index ++) {
+    while (Private->DescriptionTable[Index] != NULL) {
+      Entry = Private->DescriptionTable[Index];
+      Private->DescriptionTable[Index] = Entry->Next;
+      tBS->FreePool (Entry);
+    }
+  }
+
+  Private->DescriptionCount = 0;
+}
+
 EFI_STATUS
 StslWriteLogFileName (
   IN STANDARD_TEST_PRIVATE_DATA   *Private
@@ -1680,6 +2151,11 @@ StslFreePointer (
     Private->DevicePath = NULL;
   }
 
+  //
+  // Free the interned descriptions
+  //
+  StslFreeDescriptions (Private);
+
   return EFI_SUCCESS;
 }
 
@@ -40,6 +40,11 @@ Abstract:
 
 #define EFI_MAX_PRINT_BUFFER                1024
 
+//
+// Number of buckets in the description hash table of the binary key files
+//
+#define STSL_DESCRIPTION_HASH_SIZE          256
+
 //
 // Private data structures
 //
@@ -54,6 +59,16 @@ typedef struct {
   EFI_FILE_HANDLE                           FileHandle;
 } EFI_LIB_CONFIG_FILE_HANDLE;
 
+//
+// Description interned in the current segment of the binary key files
+//
+typedef struct _STSL_DESCRIPTION {
+  struct _STSL_DESCRIPTION                  *Next;
+  UINT32                                    Hash;
+  UINT16                                    Id;
+  CHAR16                                    Text[1];
+} STSL_DESCRIPTION;
+
 typedef struct {
   UINT32                                    Signature;
   EFI_STANDARD_TEST_LIBRARY_PROTOCOL        StandardTest;
@@ -88,6 +103,14 @@ typedef struct {
 
   BOOLEAN                                   BeginLogging;
   EFI_TIME                                  StartTime;
+
+  //
+  // Binary key files, see KeyFile.h
+  //
+  BOOLEAN                                   BinaryKeyFile;
+  UINT32                                    StartSeconds;
+  STSL_DESCRIPTION                          *DescriptionTable[STSL_DESCRIPTION_HASH_SIZE];
+  UINTN                                     DescriptionCount;
 } STANDARD_TEST_PRIVATE_DATA;
 
 #define STANDARD_TEST_PRIVATE_DATA_FROM_STSL(a) \
@@ -213,60 +213,178 @@ _freeItem (
   IN INI                          *ptrItem
   );
 
-INI *
-_getNextSection (
-  IN INI                          *CurSection
+VOID
+_freeComment (
+  IN COMMENTLINE                  *ptrCmtHead
   );
 
 VOID
 _prosessLine (
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
   IN CHAR8                        *ptrLine,
-  OUT CHAR8                       *ptrSection,
-  OUT BOOLEAN                     *isSectionGot,
-  OUT UINT32                      *commentNo
+  IN OUT INI                      **ptrHead
   );
 
 VOID
 _getcomment (
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
-  IN CHAR8                        *ptrStr,
-  OUT UINT32                      *commentNo
+  IN CHAR8                        *ptrStr
   );
 
 VOID
 _getsection (
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
   IN CHAR8                        *ptrStr,
-  OUT CHAR8                       *ptrSection,
-  OUT UINT32                      *commentNo
+  OUT INI                         **ptrHead
   );
 
 VOID
-_additem (
+_getentry (
+  IN CHAR8                        *ptrStr,
+  OUT CHAR8                       *ptrEntry,
+  OUT CHAR8                       **ptrValue
+  );
+
+EFI_STATUS
+_getKey (
+  IN CHAR16                       *Section,
+  IN CHAR16                       *Entry     OPTIONAL,
+  OUT CHAR8                       *tmpSection,
+  OUT CHAR8                       *tmpEntry  OPTIONAL
+  );
+
+CHAR8 *
+_getAsciiValue (
+  IN CHAR16                       *String
+  );
+
+EFI_STATUS
+_getValue (
+  IN INI                          *ptrItem,
+  OUT CHAR16                      *String,
+  IN OUT UINT32                   *maxLength
+  );
+
+EFI_STATUS
+_setValue (
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
-  IN INI                          *ptrItem
+  IN INI                          *ptrItem,
+  IN CHAR8                        *Value
+  );
+
+UINT32
+_hashString (
+  IN CHAR8                        *String
+  );
+
+UINT32
+_hashEntry (
+  IN INI                          *ptrHead,
+  IN CHAR8                        *Entry
   );
 
 VOID
-_getentry (
-  IN CHAR8                        *ptrStr,
-  IN CHAR8                        *ptrEntry,
-  OUT CHAR8                       *ptrValue
+_hashInsert (
+  IN OUT INI_HASH_TABLE           *Table,
+  IN INI_HASH_LINK                *Link
+  );
+
+VOID
+_hashRemove (
+  IN OUT INI_HASH_TABLE           *Table,
+  IN INI_HASH_LINK                *Link
+  );
+
+VOID
+_hashFree (
+  IN OUT INI_HASH_TABLE           *Table,
+  IN BOOLEAN                      FreeLinks
+  );
+
+INI_ATOM *
+_internString (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *String
+  );
+
+INI_SECTION *
+_findGroup (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *Section
+  );
+
+INI *
+_findEntry (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrHead,
+  IN CHAR8                        *Entry
+  );
+
+INI *
+_findFirstEntry (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *Section,
+  IN CHAR8                        *Entry
   );
 
 INI *
 _searchSection (
-  IN INI                          *Head,
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
   IN UINT32                       Order,
-  OUT CHAR8                       *Section
+  IN CHAR8                        *Section
 );
 
+INI *
+_newItem (
+  IN CHAR8                        *Value
+  );
+
+EFI_STATUS
+_addSection (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *Section,
+  OUT INI                         **ptrHead
+  );
+
+EFI_STATUS
+_addEntry (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrHead,
+  IN CHAR8                        *Entry,
+  IN CHAR8                        *Value,
+  OUT INI                         **ptrNew
+  );
+
 VOID
-_rmComment (
-  IN COMMENTLINE                  **CmtHead,
-  IN INI                          *ptrItem
-);
+_rmSection (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrHead
+  );
+
+VOID
+_outAppend (
+  IN OUT INI_OUTPUT               *Output,
+  IN CHAR8                        *String,
+  IN UINTN                        Length
+  );
+
+VOID
+_outString (
+  IN OUT INI_OUTPUT               *Output,
+  IN CHAR8                        *String
+  );
+
+VOID
+_outChunkEnd (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN OUT INI_OUTPUT               *Output
+  );
+
+VOID
+_buildFile (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN OUT INI_OUTPUT               *Output
+  );
 
 //
 // Name and Description of EFI_TEST_PROFILE_LIBRARY_PROTOCOL
@@ -629,12 +747,10 @@ Returns:
   UINTN                             Index;
   UINTN                             Number;
   UINTN                             BufSize;
-  CHAR8                             ptrLine[MAX_LINE_LEN];
+  CHAR8                             *ptrLine;
   EFI_PHYSICAL_ADDRESS              BufferPhysicalAddress;
   UINT8                             *Buffer;
-  CHAR8                             ptrSection[MAX_STRING_LEN + 1] ;
-  UINT32                            commentNo ;
-  BOOLEAN                           isSectionGot ;
+  INI                               *ptrHead;
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL   *Vol;
   UINTN                             FileInfoSize;
   EFI_FILE_INFO                     *FileInfo;
@@ -671,22 +787,10 @@ Returns:
     return EFI_OUT_OF_RESOURCES;
   }
 
-  //
-  // current section name is null
-  //
-  ptrSection[0] = '\0';
-
   //
   // section not found
   //
-  isSectionGot = FALSE;
-
-  //
-  // current comment number :
-  // every comment line's comment number is the same as the comment number of
-  // the first non comment line after this comment line.
-  //
-  commentNo = 1;
+  ptrHead = NULL;
 
   //
   //  Determine device handle for fs protocol on specified device path
@@ -778,6 +882,15 @@ Returns:
     Number = 0;
   }
 
+  //
+  // A line is never longer than the file
+  //
+  ptrLine = (CHAR8 *) SctAllocatePool (BufSize + 1);
+  if (ptrLine == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT_FREE_BUFFER;
+  }
+
   //
   // process the profile line by line
   //
@@ -793,9 +906,7 @@ Returns:
       _prosessLine (
         NewIniFile,
         ptrLine,
-        ptrSection,
-        &isSectionGot,
-        &commentNo
+        &ptrHead
       );
     }
 
@@ -813,10 +924,9 @@ Returns:
   _prosessLine (
     NewIniFile,
     ptrLine,
-    ptrSection,
-    &isSectionGot,
-    &commentNo
+    &ptrHead
   );
+  SctFreePool (ptrLine);
 
   //
   // close the profile, and return file handle
@@ -1187,19 +1297,14 @@ Returns:
 
 --*/
 {
-  INI                     *ptrCur;
-  COMMENTLINE             *ptrCmtCur;
-  BOOLEAN                 first;
-  UINT32                  commentNo;
   EFI_STATUS              Status;
   EFI_HANDLE              DeviceHandle;
   EFI_FILE_HANDLE         RootDir;
   EFI_FILE_HANDLE         Handle;
+  UINTN                   Index;
   UINTN                   BufferSize;
-  UINTN                   BufferUnicodeSize;
-  CHAR8                   Buffer[MAX_LINE_LEN * 10];
-  CHAR16                  BufferUnicode[MAX_LINE_LEN * 10 * sizeof(CHAR16)];
-  CHAR8                   Line[MAX_LINE_LEN * 2];
+  CHAR16                  *BufferUnicode;
+  INI_OUTPUT              Output;
 
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *Vol;
   EFI_DEVICE_PATH_PROTOCOL         *RootDevPath;
@@ -1207,8 +1312,6 @@ Returns:
 
   Private = EFI_INI_FILE_PRIVATE_DATA_FROM_THIS (This);
 
-  commentNo = 0;
-
   //
   // File not modified, needn't to write back to the disk
   //
@@ -1216,6 +1319,44 @@ Returns:
     return EFI_SUCCESS;
   }
 
+  //
+  // Build the whole file image in memory, so that it is written with a
+  // single call
+  //
+  Output.Data    = NULL;
+  Output.Size    = 0;
+  Output.MaxSize = 0;
+  Output.Status  = EFI_SUCCESS;
+
+  _buildFile (Private, &Output);
+  if (EFI_ERROR (Output.Status)) {
+    if (Output.Data != NULL) {
+      SctFreePool (Output.Data);
+    }
+    return Output.Status;
+  }
+
+  BufferUnicode = NULL;
+  if (Private->isUnicode) {
+    //
+    // File head and the content. The content may contain NULL characters,
+    // so it is converted byte by byte.
+    //
+    BufferUnicode = (CHAR16 *) SctAllocatePool ((Output.Size + 1) * sizeof (CHAR16));
+    if (BufferUnicode == NULL) {
+      if (Output.Data != NULL) {
+        SctFreePool (Output.Data);
+      }
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    ((UINT8 *) BufferUnicode)[0] = 0xff;
+    ((UINT8 *) BufferUnicode)[1] = 0xfe;
+    for (Index = 0; Index < Output.Size; Index ++) {
+      BufferUnicode[Index + 1] = (CHAR16) (UINT8) Output.Data[Index];
+    }
+  }
+
   RootDevPath = Private->DevPath;
   //
   //  Determine device handle for fs protocol on specified device path
@@ -1226,7 +1367,7 @@ Returns:
                   &DeviceHandle
                   );
   if (EFI_ERROR (Status)) {
-    return Status;
+    goto EXIT_FREE_BUFFER;
   }
 
   //
@@ -1238,7 +1379,7 @@ Returns:
                   (VOID*)&Vol
                   );
   if (EFI_ERROR (Status)) {
-    return Status;
+    goto EXIT_FREE_BUFFER;
   }
 
   //
@@ -1246,7 +1387,7 @@ Returns:
   //
   Status = Vol->OpenVolume (Vol, &RootDir);
   if (EFI_ERROR (Status)) {
-    return Status;
+    goto EXIT_FREE_BUFFER;
   }
 
   //
@@ -1261,7 +1402,7 @@ Returns:
                       );
   if (EFI_ERROR (Status)) {
     RootDir->Close (RootDir);
-    return Status;
+    goto EXIT_FREE_BUFFER;
   }
 
   Status = Handle->Delete (Handle);
@@ -1270,7 +1411,8 @@ Returns:
   //
   if (Status != EFI_SUCCESS) {
     RootDir->Close (RootDir);
-    return EFI_UNSUPPORTED;
+    Status = EFI_UNSUPPORTED;
+    goto EXIT_FREE_BUFFER;
   }
 
   //
@@ -1285,150 +1427,39 @@ Returns:
                       );
   if (EFI_ERROR (Status)) {
     RootDir->Close (RootDir);
-    return Status;
-  }
-
-  ptrCur = Private->Head ;
-  first = TRUE;
-
-  //
-  // write file head
-  //
-  if (Private->isUnicode) {
-    Buffer[0] = 0xff;
-    Buffer[1] = 0xfe;
-    BufferSize = 2;
-    Status = Handle->Write (Handle, &BufferSize, Buffer);
-    if (EFI_ERROR (Status)) {
-      Handle->Close (Handle);
-      RootDir->Close (RootDir);
-      return Status;
-    }
-  }
-
-  //
-  // write file line by line
-  //
-  while (ptrCur != NULL) {
-    if (*(ptrCur->ptrEntry) == '\0') {
-      //
-      // New section encountered
-      // If it's not the first section, add a blank line
-      //
-      if (first) {
-        first = FALSE;
-        Buffer[0] = '\0';
-      } else {
-        //
-        // Flush the previous section
-        //
-        if (Private->isUnicode) {
-          BufferSize = SctAsciiStrLen (Buffer) + 1;
-          BufferUnicodeSize = BufferSize * sizeof (CHAR16);
-          SctAsciiToUnicode (BufferUnicode, Buffer, BufferSize);
-          Status = Handle->Write (Handle, &BufferUnicodeSize, BufferUnicode);
-        } else {
-          Status = Handle->Write (Handle, &BufferSize, Buffer);
-        }
-        if (EFI_ERROR (Status)) {
-          Handle->Close (Handle);
-          RootDir->Close (RootDir);
-          return Status;
-        }
-
-        SctAsciiStrCpy (Buffer, "\r\n");
-      }
-    }
-
-    //
-    //  If there are comment lines before this line, write comment lines first
-    //
-    ptrCmtCur = Private->CommentLineHead;
-    while (ptrCmtCur != NULL) {
-      if (ptrCmtCur->commentNo == ptrCur->commentNo) {
-        commentNo = ptrCmtCur->commentNo;
-        SctAsciiStrCpy (Line, ptrCmtCur->ptrComment);
-        SctAsciiStrCat (Line, "\r\n");
-        SctAsciiStrCat (Buffer, Line);
-      }
-      ptrCmtCur = ptrCmtCur->ptrNext ;
-    }
-
-    if (*(ptrCur->ptrEntry) == '\0') {
-      //
-      // new section, write the section head
-      //
-      SctAsciiStrCpy (Line, "[");
-      SctAsciiStrCat (Line, ptrCur->ptrSection);
-      SctAsciiStrCat (Line, "]\r\n");
-      SctAsciiStrCat (Buffer, Line);
-    } else {
-      //
-      // write the entry and value line
-      //
-      SctAsciiStrnCpy (Line, ptrCur->ptrEntry, MAX_STRING_LEN);
-      SctAsciiStrCat (Line, "=");
-      SctAsciiStrCat (Line, ptrCur->ptrValue);
-      SctAsciiStrCat (Line, "\r\n");
-      SctAsciiStrCat (Buffer, Line);
-    }
-
-    ptrCur = ptrCur->ptrNext;
+    goto EXIT_FREE_BUFFER;
   }
 
   //
-  // Flush the last section
+  // write the file image
   //
   if (Private->isUnicode) {
-    BufferSize = SctAsciiStrLen (Buffer) + 1;
-    BufferUnicodeSize = BufferSize * sizeof (CHAR16);
-    SctAsciiToUnicode (BufferUnicode, Buffer, BufferSize);
-    Status = Handle->Write (Handle, &BufferUnicodeSize, BufferUnicode);
-  } else {
-    Status = Handle->Write (Handle, &BufferSize, Buffer);
+    BufferSize = (Output.Size + 1) * sizeof (CHAR16);
+    Status = Handle->Write (Handle, &BufferSize, BufferUnicode);
+  } else if (Output.Size != 0) {
+    BufferSize = Output.Size;
+    Status = Handle->Write (Handle, &BufferSize, Output.Data);
   }
   if (EFI_ERROR (Status)) {
     Handle->Close (Handle);
     RootDir->Close (RootDir);
-    return Status;
-  }
-
-  //
-  //  If there are comment lines in the end of the file, write these comment lines
-  //
-  ptrCmtCur = Private->CommentLineHead;
-  commentNo ++;
-  Buffer[0] = '\0';
-  while (ptrCmtCur != NULL) {
-    if (ptrCmtCur->commentNo >= commentNo) {
-      SctAsciiStrCpy (Line, ptrCmtCur->ptrComment);
-      SctAsciiStrCat (Line, "\r\n");
-      SctAsciiStrCat (Buffer, Line);
-    }
-    ptrCmtCur = ptrCmtCur->ptrNext;
-  }
-
-  if (Buffer[0] != '\0') {
-    if (Private->isUnicode) {
-      BufferSize = SctAsciiStrLen (Buffer) + 1;
-      BufferUnicodeSize = BufferSize * sizeof (CHAR16);
-      SctAsciiToUnicode (BufferUnicode, Buffer, BufferSize);
-      Status = Handle->Write (Handle, &BufferUnicodeSize, BufferUnicode);
-    } else {
-      Status = Handle->Write (Handle, &BufferSize, Buffer);
-    }
-    if (EFI_ERROR (Status)) {
-      Handle->Close (Handle);
-      RootDir->Close (RootDir);
-      return Status;
-    }
+    goto EXIT_FREE_BUFFER;
   }
 
   Handle->Flush (Handle);
   Handle->Close (Handle);
   RootDir->Close (RootDir);
   Private->Modified = FALSE;
-  return EFI_SUCCESS;
+  Status = EFI_SUCCESS;
+
+EXIT_FREE_BUFFER:
+  if (BufferUnicode != NULL) {
+    SctFreePool (BufferUnicode);
+  }
+  if (Output.Data != NULL) {
+    SctFreePool (Output.Data);
+  }
+  return Status;
 }
 
 EFI_STATUS
@@ -1467,13 +1498,11 @@ Returns:
 
 --*/
 {
-  CHAR8   ptrSection[MAX_STRING_LEN + 1];
-  CHAR8   ptrEntry[MAX_STRING_LEN + 1];
-  CHAR8   ptrString[MAX_STRING_LEN + 1];
-  INI     *ptrCur;
+  EFI_STATUS  Status;
+  INI         *ptrCur;
 
-  CHAR8   tmpSection[MAX_STRING_LEN + 1];
-  CHAR8   tmpEntry[MAX_STRING_LEN + 1];
+  CHAR8       tmpSection[MAX_STRING_LEN + 1];
+  CHAR8       tmpEntry[MAX_STRING_LEN + 1];
 
   EFI_INI_FILE_PRIVATE_DATA       *Private;
 
@@ -1486,26 +1515,9 @@ Returns:
 
   SctStrCpy (String, L"");
 
-  if (SctStrLen (Section) > MAX_STRING_LEN || SctStrLen (Entry) > MAX_STRING_LEN) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrEntry, Entry, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
-
-  SctAsciiStrCpy (tmpEntry, ptrEntry);
-  _alltrim (tmpEntry);
-
-  if (SctAsciiStrLen (tmpSection) == 0 || SctAsciiStrLen (tmpEntry) == 0) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, Entry, tmpSection, tmpEntry);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   Private = EFI_INI_FILE_PRIVATE_DATA_FROM_THIS (This);
@@ -1514,32 +1526,12 @@ Returns:
   // file content are in memory
   // so to find the field
   //
-
-  ptrCur = Private->Head;
-
-  while (ptrCur != NULL) {
-    //
-    // the same, so find the field
-    //
-    if ((SctAsciiStriCmp (tmpSection, ptrCur->ptrSection) == 0) &&
-        (SctAsciiStriCmp (tmpEntry, ptrCur->ptrEntry)     == 0)) {
-      if (SctAsciiStrLen (ptrCur->ptrValue) < *maxLength) {
-        SctAsciiStrCpy (ptrString, ptrCur->ptrValue);
-        SctAsciiToUnicode (String, ptrString, SctAsciiStrLen (ptrString) + 1);
-        return EFI_SUCCESS;
-      } else {
-        SctAsciiStrnCpy (ptrString, ptrCur->ptrValue, *maxLength - 1);
-        ptrString[*maxLength-1] = '\0';
-        SctAsciiToUnicode (String, ptrString, SctAsciiStrLen (ptrString) + 1);
-        *maxLength = (UINT32) (SctAsciiStrLen (ptrCur->ptrValue) + 1);
-        return EFI_BUFFER_TOO_SMALL;
-      }
-    }
-
-    ptrCur = ptrCur->ptrNext;
+  ptrCur = _findFirstEntry (Private, tmpSection, tmpEntry);
+  if (ptrCur == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  return _getValue (ptrCur, String, maxLength);
 }
 
 EFI_STATUS
@@ -1571,17 +1563,14 @@ Returns:
 
 --*/
 {
-  CHAR8   ptrSection[MAX_STRING_LEN + 1];
-  CHAR8   ptrEntry[MAX_STRING_LEN + 1];
-  CHAR8   ptrString[MAX_STRING_LEN + 1];
-
-  INI     *ptrCur;
-  INI     *ptrPrev;
-  INI     *ptrNew;
+  EFI_STATUS  Status;
+  INI         *ptrCur;
+  INI         *ptrHead;
+  INI_SECTION *Group;
 
-  CHAR8   tmpSection[MAX_STRING_LEN + 1];
-  CHAR8   tmpEntry[MAX_STRING_LEN + 1];
-  CHAR8   tmpString[MAX_STRING_LEN + 1];
+  CHAR8       tmpSection[MAX_STRING_LEN + 1];
+  CHAR8       tmpEntry[MAX_STRING_LEN + 1];
+  CHAR8       *tmpString;
 
   EFI_INI_FILE_PRIVATE_DATA   *Private;
 
@@ -1594,108 +1583,50 @@ Returns:
     return EFI_INVALID_PARAMETER;
   }
 
-  if (SctStrLen (Section) > MAX_STRING_LEN ||
-      SctStrLen (Entry)   > MAX_STRING_LEN ||
-      SctStrLen (String)  > MAX_STRING_LEN) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrEntry, Entry, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
-
-  SctAsciiStrCpy (tmpEntry, ptrEntry);
-  _alltrim (tmpEntry);
-
-  if (SctAsciiStrLen (tmpSection) == 0 || SctAsciiStrLen (tmpEntry) == 0) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, Entry, tmpSection, tmpEntry);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  if (SctUnicodeToAscii (ptrString, String, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
+  tmpString = _getAsciiValue (String);
+  if (tmpString == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  SctAsciiStrCpy (tmpString, ptrString);
-  _alltrim (tmpString);
-
   //
   // if both section and entry are found
   //
-  ptrCur = Private->Head;
-  ptrPrev = NULL;
-  while (ptrCur != NULL) {
-    if (SctAsciiStriCmp (tmpSection, ptrCur->ptrSection) == 0) {
-      if (SctAsciiStriCmp (tmpEntry, ptrCur->ptrEntry) == 0) {
-        if (SctAsciiStriCmp (tmpString, ptrCur->ptrValue) != 0) {
-          SctAsciiStrnCpy (ptrCur->ptrValue, tmpString, MAX_STRING_LEN);
-          Private->Modified = TRUE;
-        }
-        return EFI_SUCCESS;
-      }
-      ptrPrev = ptrCur;
+  ptrCur = _findFirstEntry (Private, tmpSection, tmpEntry);
+  if (ptrCur != NULL) {
+    Status = EFI_SUCCESS;
+    if (SctAsciiStriCmp (tmpString, ptrCur->ptrValue) != 0) {
+      Status = _setValue (Private, ptrCur, tmpString);
     }
-    ptrCur = ptrCur->ptrNext;
+    SctFreePool (tmpString);
+    return Status;
   }
 
   //
   // if not, should add a new item
+  // 1. if only section is found, add it to the last section of the name
+  // 2. if section is not found, should add a new section head
   //
-  ptrNew = (INI *) SctAllocatePool (sizeof(INI));
-  if (ptrNew == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-  ptrNew->commentNo = 0;
-  ptrNew->ptrNext = NULL;
-  SctAsciiStrnCpy (ptrNew->ptrSection, tmpSection, MAX_STRING_LEN);
-  SctAsciiStrnCpy (ptrNew->ptrEntry, tmpEntry, MAX_STRING_LEN);
-  SctAsciiStrnCpy (ptrNew->ptrValue, tmpString, MAX_STRING_LEN);
-
-  //
-  // 1. if only section is found
-  //
-  if (ptrPrev != NULL) {
-    ptrNew->commentNo = 0;
-    ptrNew->ptrNext   = ptrPrev->ptrNext;
-    ptrPrev->ptrNext  = ptrNew;
-    if (Private->Tail == ptrPrev) {
-      Private->Tail = ptrNew;
+  Group = _findGroup (Private, tmpSection);
+  if ((Group != NULL) && (Group->Count != 0)) {
+    ptrHead = Group->Instances[Group->Count - 1];
+  } else {
+    Status = _addSection (Private, tmpSection, &ptrHead);
+    if (EFI_ERROR (Status)) {
+      SctFreePool (tmpString);
+      return Status;
     }
-    Private->Modified = TRUE;
-    return EFI_SUCCESS;
   }
 
-  //
-  // 2. if section is not found, should add a new section head
-  //
-  ptrCur = ptrNew;
-
-  ptrNew = (INI *) SctAllocatePool (sizeof (INI));
-  if (ptrNew == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-  ptrNew->commentNo = 0;
-  ptrNew->ptrNext = NULL;
-  SctAsciiStrnCpy (ptrNew->ptrSection, tmpSection, MAX_STRING_LEN);
-  SctAsciiStrCpy (ptrNew->ptrEntry, "");
-  SctAsciiStrCpy (ptrNew->ptrValue, "");
-
-  ptrCur->commentNo = 0;
-  ptrCur->ptrNext   = NULL;
-  ptrNew->commentNo = 0;
-  ptrNew->ptrNext   = ptrCur;
-  if (Private->Tail != NULL) {
-    Private->Tail->ptrNext = ptrNew;
-  } else {
-    Private->Head = ptrNew;
+  Status = _addEntry (Private, ptrHead, tmpEntry, tmpString, &ptrCur);
+  SctFreePool (tmpString);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  Private->Tail = ptrCur;
 
   Private->Modified = TRUE;
   return EFI_SUCCESS;
@@ -1726,11 +1657,9 @@ Returns:
 
 --*/
 {
-  INI                             *ptrCur;
-  INI                             *ptrPrev;
-  INI                             *ptrNext;
+  EFI_STATUS                      Status;
+  INI_SECTION                     *Group;
   EFI_INI_FILE_PRIVATE_DATA       *Private;
-  CHAR8                           ptrSection[MAX_STRING_LEN + 1];
   CHAR8                           tmpSection[MAX_STRING_LEN + 1];
 
   Private = EFI_INI_FILE_PRIVATE_DATA_FROM_THIS (This);
@@ -1739,32 +1668,19 @@ Returns:
     return EFI_INVALID_PARAMETER;
   }
 
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, NULL, tmpSection, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
 
-  ptrCur = Private->Head;
-  ptrPrev = NULL;
-  while (ptrCur != NULL) {
-    if (SctAsciiStriCmp (tmpSection, ptrCur->ptrSection) == 0) {
+  Group = _findGroup (Private, tmpSection);
+  if (Group != NULL) {
+    //
+    // Remove from the last one, so the instance table is never shifted
+    //
+    while (Group->Count != 0) {
       Private->Modified = TRUE;
-      _rmComment (&(Private->CommentLineHead), ptrCur);
-      ptrNext = ptrCur->ptrNext;
-      _freeItem (ptrCur);
-      if (ptrPrev == NULL) {
-        Private->Head = ptrNext;
-      } else {
-        ptrPrev->ptrNext = ptrNext;
-      }
-      if (ptrNext == NULL) {
-        Private->Tail = ptrPrev;
-      }
-      ptrCur = ptrNext;
-    } else {
-      ptrPrev = ptrCur;
-      ptrCur = ptrCur->ptrNext;
+      _rmSection (Private, Group->Instances[Group->Count - 1]);
     }
   }
 
@@ -1813,13 +1729,11 @@ Returns:
 
 --*/
 {
-  CHAR8 ptrSection[MAX_STRING_LEN + 1];
-  CHAR8 ptrEntry[MAX_STRING_LEN + 1];
-  CHAR8 ptrString[MAX_STRING_LEN + 1];
-  INI   *ptrCur;
+  EFI_STATUS  Status;
+  INI         *ptrCur;
 
-  CHAR8 tmpSection[MAX_STRING_LEN + 1];
-  CHAR8 tmpEntry[MAX_STRING_LEN + 1];
+  CHAR8       tmpSection[MAX_STRING_LEN + 1];
+  CHAR8       tmpEntry[MAX_STRING_LEN + 1];
 
   EFI_INI_FILE_PRIVATE_DATA       *Private;
 
@@ -1832,68 +1746,27 @@ Returns:
 
   SctStrCpy (String, L"");
 
-  if (SctStrLen (Section) > MAX_STRING_LEN || SctStrLen (Entry) > MAX_STRING_LEN) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrEntry, Entry, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
-
-  SctAsciiStrCpy (tmpEntry, ptrEntry);
-  _alltrim (tmpEntry);
-
-  if (SctAsciiStrLen (tmpSection) == 0 || SctAsciiStrLen (tmpEntry) == 0) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, Entry, tmpSection, tmpEntry);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   Private = EFI_INI_FILE_PRIVATE_DATA_FROM_THIS (This);
 
   //
-  // file content are in memory
-  // so to find the field
-  //
-
   // find the section first
-  ptrCur = _searchSection (Private->Head, Order, tmpSection);
-
-  if (ptrCur != NULL) {
-    ptrCur = ptrCur->ptrNext;
+  //
+  ptrCur = _searchSection (Private, Order, tmpSection);
+  if (ptrCur == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  while (ptrCur != NULL) {
-    if (*(ptrCur->ptrEntry) == '\0') {
-      //
-      // reached another section
-      //
-      break;
-    }
-    if ((SctAsciiStriCmp (tmpSection, ptrCur->ptrSection) == 0) &&
-        (SctAsciiStriCmp (tmpEntry, ptrCur->ptrEntry)     == 0)) {
-      if (SctAsciiStrLen (ptrCur->ptrValue) < *maxLength) {
-        SctAsciiStrCpy (ptrString, ptrCur->ptrValue);
-        SctAsciiToUnicode (String, ptrString, SctAsciiStrLen (ptrString) + 1);
-        return EFI_SUCCESS;
-      } else {
-        SctAsciiStrnCpy (ptrString, ptrCur->ptrValue, *maxLength - 1);
-        ptrString[*maxLength-1] = '\0';
-        SctAsciiToUnicode (String, ptrString, SctAsciiStrLen (ptrString) + 1 );
-        *maxLength = (UINT32) (SctAsciiStrLen (ptrCur->ptrValue) + 1);
-        return EFI_BUFFER_TOO_SMALL;
-      }
-    }
-
-    ptrCur = ptrCur->ptrNext;
-  }  // endof while
+  ptrCur = _findEntry (Private, ptrCur, tmpEntry);
+  if (ptrCur == NULL) {
+    return EFI_NOT_FOUND;
+  }
 
-  return EFI_NOT_FOUND;
+  return _getValue (ptrCur, String, maxLength);
 }
 
 EFI_STATUS
@@ -1927,17 +1800,13 @@ Returns:
 
 --*/
 {
-  CHAR8 ptrSection[MAX_STRING_LEN + 1];
-  CHAR8 ptrEntry[MAX_STRING_LEN + 1];
-  CHAR8 ptrString[MAX_STRING_LEN + 1];
-
-  INI   *ptrCur;
-  INI   *ptrPrev;
-  INI   *ptrNew;
+  EFI_STATUS  Status;
+  INI         *ptrCur;
+  INI         *ptrHead;
 
-  CHAR8 tmpSection[MAX_STRING_LEN + 1];
-  CHAR8 tmpEntry[MAX_STRING_LEN + 1];
-  CHAR8 tmpString[MAX_STRING_LEN + 1];
+  CHAR8       tmpSection[MAX_STRING_LEN + 1];
+  CHAR8       tmpEntry[MAX_STRING_LEN + 1];
+  CHAR8       *tmpString;
 
   EFI_INI_FILE_PRIVATE_DATA        *Private;
 
@@ -1950,116 +1819,50 @@ Returns:
     return EFI_INVALID_PARAMETER;
   }
 
-  if (SctStrLen (Section) > MAX_STRING_LEN ||
-      SctStrLen (Entry)   > MAX_STRING_LEN ||
-      SctStrLen (String)  > MAX_STRING_LEN) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if (SctUnicodeToAscii (ptrEntry, Entry, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
-
-  SctAsciiStrCpy (tmpEntry, ptrEntry);
-  _alltrim (tmpEntry);
-
-  if (SctAsciiStrLen (tmpSection) == 0 || SctAsciiStrLen (tmpEntry) == 0) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, Entry, tmpSection, tmpEntry);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  if (SctUnicodeToAscii (ptrString, String, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
+  tmpString = _getAsciiValue (String);
+  if (tmpString == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  SctAsciiStrCpy (tmpString, ptrString);
-  _alltrim (tmpString);
-
   //
   // if both section and entry are found
   //
-  ptrCur = _searchSection (Private->Head, Order, tmpSection);
-  ptrPrev = ptrCur;
-  if (ptrCur != NULL) {
-    ptrCur = ptrCur->ptrNext;
-  }
-  while (ptrCur != NULL) {
-    if (*(ptrCur->ptrEntry) == '\0') {
-      //
-      // reached another section
-      //
-      break;
-    }
-    if ((SctAsciiStriCmp (tmpSection, ptrCur->ptrSection ) == 0) &&
-        (SctAsciiStriCmp (tmpEntry, ptrCur->ptrEntry )     == 0)) {
+  ptrHead = _searchSection (Private, Order, tmpSection);
+  if (ptrHead != NULL) {
+    ptrCur = _findEntry (Private, ptrHead, tmpEntry);
+    if (ptrCur != NULL) {
+      Status = EFI_SUCCESS;
       if (SctAsciiStriCmp (tmpString, ptrCur->ptrValue) != 0) {
-        SctAsciiStrnCpy (ptrCur->ptrValue, tmpString, MAX_STRING_LEN);
-        Private->Modified = TRUE;
+        Status = _setValue (Private, ptrCur, tmpString);
       }
-      return EFI_SUCCESS;
+      SctFreePool (tmpString);
+      return Status;
     }
-    ptrPrev = ptrCur;
-    ptrCur = ptrCur->ptrNext;
   }
 
   //
   // if not, should add a new item
+  // 1. if only section is found, add it to the end of the section
+  // 2. if section is not found, should add a new section head
   //
-  ptrNew = (INI *) SctAllocatePool (sizeof(INI));
-  if (ptrNew == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-  ptrNew->commentNo = 0;
-  ptrNew->ptrNext = NULL;
-  SctAsciiStrnCpy (ptrNew->ptrSection, tmpSection, MAX_STRING_LEN);
-  SctAsciiStrnCpy (ptrNew->ptrEntry, tmpEntry, MAX_STRING_LEN);
-  SctAsciiStrnCpy (ptrNew->ptrValue, tmpString, MAX_STRING_LEN);
-
-  //
-  // 1. if only section is found
-  //
-  if (ptrPrev != NULL) {
-    ptrNew->commentNo = 0;
-    ptrNew->ptrNext = ptrPrev->ptrNext;
-    ptrPrev->ptrNext = ptrNew;
-    if (Private->Tail == ptrPrev) {
-      Private->Tail = ptrNew;
+  if (ptrHead == NULL) {
+    Status = _addSection (Private, tmpSection, &ptrHead);
+    if (EFI_ERROR (Status)) {
+      SctFreePool (tmpString);
+      return Status;
     }
-    Private->Modified = TRUE;
-    return EFI_SUCCESS;
   }
 
-  //
-  // 2. if section is not found, should add a new section head
-  //
-  ptrCur = ptrNew;
-
-  ptrNew = (INI *)SctAllocatePool (sizeof(INI));
-  if (ptrNew == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-  ptrNew->commentNo = 0;
-  ptrNew->ptrNext = NULL;
-  SctAsciiStrnCpy (ptrNew->ptrSection, tmpSection, MAX_STRING_LEN);
-  SctAsciiStrCpy (ptrNew->ptrEntry, "");
-  SctAsciiStrCpy (ptrNew->ptrValue, "");
-
-  ptrCur->commentNo = 0;
-  ptrCur->ptrNext   = NULL;
-  ptrNew->commentNo = 0;
-  ptrNew->ptrNext   = ptrCur;
-  if (Private->Tail != NULL) {
-    Private->Tail->ptrNext = ptrNew;
-  } else {
-    Private->Head = ptrNew;
+  Status = _addEntry (Private, ptrHead, tmpEntry, tmpString, &ptrCur);
+  SctFreePool (tmpString);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  Private->Tail = ptrCur;
 
   Private->Modified = TRUE;
   return EFI_SUCCESS;
@@ -2092,12 +1895,9 @@ Returns:
 
 --*/
 {
-  INI                              *ptrCur;
-  INI                              *ptrPrev;
+  EFI_STATUS                       Status;
   INI                              *ptrSect;
-  INI                              *ptrNext;
   EFI_INI_FILE_PRIVATE_DATA        *Private;
-  CHAR8                            ptrSection[MAX_STRING_LEN + 1];
   CHAR8                            tmpSection[MAX_STRING_LEN + 1];
 
   Private = EFI_INI_FILE_PRIVATE_DATA_FROM_THIS (This);
@@ -2106,53 +1906,17 @@ Returns:
     return EFI_INVALID_PARAMETER;
   }
 
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, NULL, tmpSection, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
 
-  ptrSect = _searchSection (Private->Head, Order, tmpSection);
+  ptrSect = _searchSection (Private, Order, tmpSection);
   if (ptrSect == NULL) {
     return EFI_NOT_FOUND;
   }
 
-  ptrCur = Private->Head;
-  ptrPrev = NULL;
-  while (ptrCur != NULL) {
-    if (ptrCur == ptrSect) {
-      break;
-    }
-    ptrPrev = ptrCur;
-    ptrCur = ptrCur->ptrNext;
-  }
-
-  _rmComment (&(Private->CommentLineHead), ptrSect);
-  ptrNext = ptrSect->ptrNext;
-  _freeItem (ptrSect);
-  ptrCur = ptrNext;
-  while (ptrCur != NULL) {
-    if (*(ptrCur->ptrEntry) == '\0') {
-      //
-      // reached another section
-      //
-      break;
-    }
-    _rmComment (&(Private->CommentLineHead), ptrCur);
-    ptrNext = ptrCur->ptrNext;
-    _freeItem (ptrCur);
-    ptrCur = ptrNext;
-  }
-
-  if (ptrPrev == NULL) {
-    Private->Head = ptrNext;
-  } else {
-    ptrPrev->ptrNext = ptrNext;
-  }
-
-  if (ptrNext == NULL) {
-    Private->Tail = ptrPrev;
-  }
+  _rmSection (Private, ptrSect);
 
   Private->Modified = TRUE;
   return EFI_SUCCESS;
@@ -2184,9 +1948,9 @@ Returns:
 
 --*/
 {
-  INI                              *ptrCur;
+  EFI_STATUS                       Status;
+  INI_SECTION                      *Group;
   EFI_INI_FILE_PRIVATE_DATA        *Private;
-  CHAR8                            ptrSection[MAX_STRING_LEN + 1];
   CHAR8                            tmpSection[MAX_STRING_LEN + 1];
 
   Private = EFI_INI_FILE_PRIVATE_DATA_FROM_THIS (This);
@@ -2195,21 +1959,15 @@ Returns:
     return EFI_INVALID_PARAMETER;
   }
 
-  if (SctUnicodeToAscii (ptrSection, Section, MAX_STRING_LEN + 1) == -1) {
-    return EFI_INVALID_PARAMETER;
+  Status = _getKey (Section, NULL, tmpSection, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  SctAsciiStrCpy (tmpSection, ptrSection);
-  _alltrim (tmpSection);
-
   *OrderNum = 0;
-  ptrCur = Private->Head;
-  while (ptrCur != NULL) {
-    if (SctAsciiStriCmp (tmpSection, ptrCur->ptrSection) == 0) {
-      ++ (*OrderNum);
-    }
-
-    ptrCur = _getNextSection (ptrCur);
+  Group = _findGroup (Private, tmpSection);
+  if (Group != NULL) {
+    *OrderNum = Group->Count;
   }
 
   return EFI_SUCCESS;
@@ -2246,8 +2004,13 @@ Routine Description:
   IniFile->Head                      = NULL;
   IniFile->Tail                      = NULL;
   IniFile->CommentLineHead           = NULL;
+  IniFile->CommentLineTail           = NULL;
   IniFile->isUnicode                 = FALSE;
   IniFile->Modified                  = FALSE;
+
+  SctZeroMem (&IniFile->Atoms, sizeof (INI_HASH_TABLE));
+  SctZeroMem (&IniFile->Sections, sizeof (INI_HASH_TABLE));
+  SctZeroMem (&IniFile->Entries, sizeof (INI_HASH_TABLE));
 }
 
 VOID
@@ -2294,70 +2057,84 @@ Routine Description:
 
 --*/
 {
-  INI         *ptrTmp;
-  COMMENTLINE *ptrCommentTmp;
+  INI           *ptrTmp;
+  INI_SECTION   *Group;
+  UINT32        Index;
 
   while (IniFile->Head != NULL) {
     ptrTmp = IniFile->Head->ptrNext;
-    SctFreePool (IniFile->Head);
+    _freeItem (IniFile->Head);
     IniFile->Head = ptrTmp;
   }
   IniFile->Tail = NULL;
 
-  while (IniFile->CommentLineHead != NULL) {
-    ptrCommentTmp = IniFile->CommentLineHead->ptrNext;
-    SctFreePool (IniFile->CommentLineHead);
-    IniFile->CommentLineHead = ptrCommentTmp;
+  _freeComment (IniFile->CommentLineHead);
+  IniFile->CommentLineHead = NULL;
+  IniFile->CommentLineTail = NULL;
+
+  //
+  // Sections own their instance tables, atoms are plain pool buffers
+  //
+  if (IniFile->Sections.Buckets != NULL) {
+    for (Index = 0; Index < IniFile->Sections.Size; Index ++) {
+      while (IniFile->Sections.Buckets[Index] != NULL) {
+        Group = (INI_SECTION *) IniFile->Sections.Buckets[Index];
+        IniFile->Sections.Buckets[Index] = Group->Link.HashNext;
+        if (Group->Instances != NULL) {
+          SctFreePool (Group->Instances);
+        }
+        SctFreePool (Group);
+      }
+    }
   }
+  _hashFree (&IniFile->Sections, FALSE);
+  _hashFree (&IniFile->Atoms, TRUE);
+  _hashFree (&IniFile->Entries, FALSE);
 }
 
 VOID
 _prosessLine (
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
   IN CHAR8                        *ptrLine,
-  OUT CHAR8                       *ptrSection,
-  OUT BOOLEAN                     *isSectionGot,
-  OUT UINT32                      *commentNo
+  IN OUT INI                      **ptrHead
   )
 /*++
 
 Routine Description:
 
-  Parse a line.
+  Parse a line. ptrHead is the head of the current section, NULL if no
+  section was got yet.
 
 --*/
 {
-  CHAR8 ptrEntry[MAX_STRING_LEN + 1];
-  CHAR8 ptrValue[MAX_STRING_LEN + 1];
-  INI   *ptrItem;
+  CHAR8       ptrEntry[MAX_STRING_LEN + 1];
+  CHAR8       *ptrValue;
+  INI         *ptrItem;
+  EFI_STATUS  Status;
 
   ptrLine = _alltrim (ptrLine);
 
   if (*ptrLine == '#') {
     // it's a comment line
-    _getcomment (IniFile, ptrLine, commentNo);
+    _getcomment (IniFile, ptrLine);
   } else if ((*ptrLine == '[') && (SctAsciiStrChr (ptrLine, ']') != NULL)) {
     // it's a section head
-    _getsection (IniFile, ptrLine, ptrSection, commentNo);
-    *isSectionGot = TRUE;
+    _getsection (IniFile, ptrLine, ptrHead);
   } else if (SctAsciiStrChr (ptrLine, '=') != NULL) {
-    _getentry (ptrLine, ptrEntry, ptrValue);
+    _getentry (ptrLine, ptrEntry, &ptrValue);
 
-    if (*isSectionGot == TRUE) {
-      ptrItem = (INI *)SctAllocatePool (sizeof(INI));
-      if (ptrItem == NULL) {
+    if (*ptrHead != NULL) {
+      Status = _addEntry (IniFile, *ptrHead, ptrEntry, ptrValue, &ptrItem);
+      if (EFI_ERROR (Status)) {
         return;
       }
 
-      ptrItem->commentNo = *commentNo;
-      ptrItem->ptrNext = NULL;
-      SctAsciiStrnCpy (ptrItem->ptrSection, ptrSection, MAX_STRING_LEN);
-      SctAsciiStrnCpy (ptrItem->ptrEntry, ptrEntry, MAX_STRING_LEN);
-      SctAsciiStrnCpy (ptrItem->ptrValue, ptrValue, MAX_STRING_LEN);
-
-      (*commentNo) ++;
-
-      _additem (IniFile, ptrItem);
+      //
+      // the pending comment lines belong to this line
+      //
+      ptrItem->CommentLineHead = IniFile->CommentLineHead;
+      IniFile->CommentLineHead = NULL;
+      IniFile->CommentLineTail = NULL;
     }
   }
 }
@@ -2365,18 +2142,16 @@ Routine Description:
 VOID
 _getcomment(
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
-  IN CHAR8                        *ptrStr,
-  OUT UINT32                      *commentNo
+  IN CHAR8                        *ptrStr
   )
 /*++
 
 Routine Description:
 
-  Get comment line.
+  Get comment line. It is kept pending until the next line is got.
 
 --*/
 {
-  static COMMENTLINE *ptrCommentLineCurrent = NULL;
   COMMENTLINE        *ptrCommentLineNew;
   UINT32             Index;
   UINT32             Length;
@@ -2392,30 +2167,26 @@ Routine Description:
   }
   ptrStr[Index] = '\0';
 
-  ptrCommentLineNew = (COMMENTLINE *) SctAllocatePool (sizeof (COMMENTLINE));
-  ptrCommentLineNew->commentNo = 0;
+  ptrCommentLineNew = (COMMENTLINE *) SctAllocatePool (sizeof (COMMENTLINE) + Index);
+  if (ptrCommentLineNew == NULL) {
+    return;
+  }
   ptrCommentLineNew->ptrNext = NULL;
-  SctAsciiStrnCpy (ptrCommentLineNew->ptrComment, ptrStr, MAX_LINE_LEN);
-
-  ptrCommentLineNew->commentNo = *commentNo;
+  SctCopyMem (ptrCommentLineNew->ptrComment, ptrStr, Index + 1);
 
   if (IniFile->CommentLineHead == NULL) {
     IniFile->CommentLineHead = ptrCommentLineNew;
-    IniFile->CommentLineHead->ptrNext = NULL;
-    ptrCommentLineCurrent = IniFile->CommentLineHead;
   } else {
-    ptrCommentLineNew->ptrNext = NULL;
-    ptrCommentLineCurrent->ptrNext = ptrCommentLineNew;
-    ptrCommentLineCurrent = ptrCommentLineNew;
+    IniFile->CommentLineTail->ptrNext = ptrCommentLineNew;
   }
+  IniFile->CommentLineTail = ptrCommentLineNew;
 }
 
 VOID
 _getsection (
   IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
   IN CHAR8                        *ptrStr,
-  OUT CHAR8                       *ptrSection,
-  OUT UINT32                      *commentNo
+  OUT INI                         **ptrHead
   )
 /*++
 
@@ -2425,8 +2196,9 @@ Routine Description:
 
 --*/
 {
-  CHAR8 *p, *q;
-  INI   *ptrItem;
+  CHAR8       *p, *q;
+  CHAR8       ptrSection[MAX_STRING_LEN + 1];
+  EFI_STATUS  Status;
 
   p = SctAsciiStrChr (ptrStr, '[');
   q = SctAsciiStrChr (ptrStr, ']');
@@ -2446,22 +2218,18 @@ Routine Description:
     ptrSection[MAX_STRING_LEN] = '\0';
   }
 
-  ptrItem = (INI *)SctAllocatePool (sizeof(INI));
-  if (ptrItem == NULL) {
+  Status = _addSection (IniFile, ptrSection, ptrHead);
+  if (EFI_ERROR (Status)) {
+    *ptrHead = NULL;
     return;
   }
 
-  ptrItem->commentNo = 0;
-  ptrItem->ptrNext = NULL;
-  SctAsciiStrnCpy (ptrItem->ptrSection, ptrSection, MAX_STRING_LEN);
-  SctAsciiStrCpy (ptrItem->ptrEntry, "");
-  SctAsciiStrCpy (ptrItem->ptrValue, "");
-
-  ptrItem->commentNo  = *commentNo;
-
-  (*commentNo) ++;
-
-  _additem (IniFile, ptrItem);
+  //
+  // the pending comment lines belong to this line
+  //
+  (*ptrHead)->CommentLineHead = IniFile->CommentLineHead;
+  IniFile->CommentLineHead = NULL;
+  IniFile->CommentLineTail = NULL;
 }
 
 CHAR8 *_alltrim(
@@ -2508,41 +2276,18 @@ Routine Description:
   return ptrStr;
 }
 
-VOID
-_additem (
-  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
-  IN INI                          *ptrItem
-  )
-/*++
-
-Routine Description:
-
-  Insert new item to the end of ini table .
-
---*/
-{
-  if (IniFile->Head == NULL) {
-    IniFile->Head = ptrItem;
-    IniFile->Tail = ptrItem;
-    IniFile->Head->ptrNext = NULL;
-  } else {
-    ptrItem->ptrNext = NULL;
-    IniFile->Tail->ptrNext = ptrItem;
-    IniFile->Tail = ptrItem;
-  }
-}
-
 VOID
 _getentry (
   IN CHAR8                        *ptrStr,
-  IN CHAR8                        *ptrEntry,
-  OUT CHAR8                       *ptrValue
+  OUT CHAR8                       *ptrEntry,
+  OUT CHAR8                       **ptrValue
   )
 /*++
 
 Routine Description:
 
-  Parse one line and generate the entry and value.
+  Parse one line and generate the entry and value. The value is returned in
+  place in the line.
 
 --*/
 {
@@ -2572,112 +2317,905 @@ Routine Description:
     _alltrim (p);
   }
 
-  if (SctAsciiStrLen (p) <= MAX_STRING_LEN) {
-    SctAsciiStrCpy (ptrValue, p);
-  } else {
-    SctAsciiStrnCpy (ptrValue, p, MAX_STRING_LEN);
-    ptrValue[MAX_STRING_LEN] = '\0';
+  *ptrValue = p;
+}
+
+EFI_STATUS
+_getKey (
+  IN CHAR16                       *Section,
+  IN CHAR16                       *Entry     OPTIONAL,
+  OUT CHAR8                       *tmpSection,
+  OUT CHAR8                       *tmpEntry  OPTIONAL
+  )
+/*++
+
+Routine Description:
+
+  Convert the Unicode section and entry names of a request into trimmed ASCII
+  strings of at most MAX_STRING_LEN characters.
+
+--*/
+{
+  if (SctStrLen (Section) > MAX_STRING_LEN) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (SctUnicodeToAscii (tmpSection, Section, MAX_STRING_LEN + 1) == -1) {
+    return EFI_INVALID_PARAMETER;
+  }
+  _alltrim (tmpSection);
+
+  if (Entry == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  if (SctStrLen (Entry) > MAX_STRING_LEN) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (SctUnicodeToAscii (tmpEntry, Entry, MAX_STRING_LEN + 1) == -1) {
+    return EFI_INVALID_PARAMETER;
+  }
+  _alltrim (tmpEntry);
+
+  if (SctAsciiStrLen (tmpSection) == 0 || SctAsciiStrLen (tmpEntry) == 0) {
+    return EFI_INVALID_PARAMETER;
   }
+
+  return EFI_SUCCESS;
 }
 
-INI *
-_searchSection (
-  IN INI                          *Head,
-  IN UINT32                       Order,
-  OUT CHAR8                       *Section
-)
+CHAR8 *
+_getAsciiValue (
+  IN CHAR16                       *String
+  )
 /*++
 
 Routine Description:
 
-  Search for the specific section in the ini table
+  Convert a Unicode value into a trimmed ASCII string allocated from pool.
+  Values have no length limit.
 
 --*/
 {
-  INI     *ptrCur;
-  UINT32  CurOrder;
-
-  CurOrder = 0;
-  ptrCur = Head;
-  while (ptrCur != NULL) {
-    if (SctAsciiStriCmp (Section, ptrCur->ptrSection) == 0) {
-      if (CurOrder == Order) {
-        break;
-      }
-      ++ CurOrder;
-    }
+  CHAR8   *Value;
+  UINTN   Length;
 
-    ptrCur = _getNextSection (ptrCur);
+  Length = SctStrLen (String);
+  Value  = (CHAR8 *) SctAllocatePool (Length + 1);
+  if (Value == NULL) {
+    return NULL;
   }
 
-  return ptrCur;
+  SctUnicodeToAscii (Value, String, Length + 1);
+  _alltrim (Value);
+  return Value;
 }
 
-INI *
-_getNextSection (
-  IN INI                          *CurSection
-)
+EFI_STATUS
+_getValue (
+  IN INI                          *ptrItem,
+  OUT CHAR16                      *String,
+  IN OUT UINT32                   *maxLength
+  )
 /*++
 
 Routine Description:
 
-  Search for the next section in the ini table
+  Return the value of an entry, truncated to maxLength characters.
 
 --*/
 {
-  INI   *ptrCur;
+  UINTN   Length;
 
-  ptrCur = CurSection->ptrNext;
-  while (ptrCur != NULL) {
-    if (*(ptrCur->ptrEntry) == '\0') {
-      break;
+  Length = SctAsciiStrLen (ptrItem->ptrValue);
+  if (Length < *maxLength) {
+    SctAsciiToUnicode (String, ptrItem->ptrValue, Length + 1);
+    return EFI_SUCCESS;
+  }
+
+  if (*maxLength != 0) {
+    SctAsciiToUnicode (String, ptrItem->ptrValue, *maxLength - 1);
+    String[*maxLength - 1] = L'\0';
+  }
+  *maxLength = (UINT32) (Length + 1);
+  return EFI_BUFFER_TOO_SMALL;
+}
+
+EFI_STATUS
+_setValue (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrItem,
+  IN CHAR8                        *Value
+  )
+/*++
+
+Routine Description:
+
+  Update the value of an entry. The value buffer is reused when it is large
+  enough.
+
+--*/
+{
+  UINTN   Size;
+  CHAR8   *NewValue;
+
+  Size = SctAsciiStrLen (Value) + 1;
+  if (Size > ptrItem->ValueSize) {
+    NewValue = (CHAR8 *) SctAllocatePool (Size);
+    if (NewValue == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    if (ptrItem->ptrValue != NULL) {
+      SctFreePool (ptrItem->ptrValue);
     }
-    ptrCur = ptrCur->ptrNext;
+    ptrItem->ptrValue  = NewValue;
+    ptrItem->ValueSize = Size;
   }
 
-  return ptrCur;
+  SctCopyMem (ptrItem->ptrValue, Value, Size);
+  IniFile->Modified = TRUE;
+  return EFI_SUCCESS;
 }
 
-VOID
-_freeItem (
-  IN INI                          *ptrItem
+UINT32
+_hashString (
+  IN CHAR8                        *String
   )
 /*++
 
 Routine Description:
 
-  Free an INI item
+  Case-insensitive FNV-1a hash of a string.
 
 --*/
 {
-  SctFreePool (ptrItem);
+  UINT32  Hash;
+  CHAR8   Char;
+
+  Hash = 2166136261U;
+  while (*String != '\0') {
+    Char = *String++;
+    if ((Char >= 'a') && (Char <= 'z')) {
+      Char = (CHAR8) (Char - 'a' + 'A');
+    }
+    Hash = (Hash ^ (UINT8) Char) * 16777619U;
+  }
+
+  return Hash;
 }
 
-VOID
-_rmComment (
-  IN COMMENTLINE                  **CmtHead,
-  IN INI                          *ptrItem
-)
+UINT32
+_hashEntry (
+  IN INI                          *ptrHead,
+  IN CHAR8                        *Entry
+  )
+/*++
+
+Routine Description:
+
+  Hash of an entry name within a section instance.
+
+--*/
 {
-  COMMENTLINE *ptrCmtCur;
-  COMMENTLINE *ptrCmtPrev;
-  COMMENTLINE *ptrCmtNext;
+  UINTN   Head;
+
+  Head = (UINTN) ptrHead;
+  return _hashString (Entry) ^ ((UINT32) (Head >> 4) * 2654435761U);
+}
+
+VOID
+_hashInsert (
+  IN OUT INI_HASH_TABLE           *Table,
+  IN INI_HASH_LINK                *Link
+  )
+/*++
+
+Routine Description:
+
+  Insert a link into a hash table, and grow the table if it gets too loaded.
+  Growing is best effort, a full table still works with longer chains.
 
-  ptrCmtCur = *CmtHead;
-  ptrCmtPrev = NULL;
-  while (ptrCmtCur != NULL) {
-    if (ptrCmtCur->commentNo == ptrItem->commentNo) {
-      ptrCmtNext = ptrCmtCur->ptrNext;
-      SctFreePool (ptrCmtCur);
-      if (ptrCmtPrev == NULL) {
-        *CmtHead = ptrCmtNext;
-      } else {
-        ptrCmtPrev->ptrNext = ptrCmtNext;
+--*/
+{
+  INI_HASH_LINK   **Buckets;
+  INI_HASH_LINK   *Cur;
+  UINT32          Size;
+  UINT32          Index;
+
+  if ((Table->Buckets == NULL) ||
+      (Table->Count >= Table->Size * INI_HASH_MAX_LOAD)) {
+    Size = (Table->Buckets == NULL) ? INI_HASH_INIT_SIZE : Table->Size * 2;
+    Buckets = (INI_HASH_LINK **) SctAllocateZeroPool (Size * sizeof (INI_HASH_LINK *));
+    if (Buckets != NULL) {
+      for (Index = 0; Index < Table->Size; Index ++) {
+        while (Table->Buckets[Index] != NULL) {
+          Cur = Table->Buckets[Index];
+          Table->Buckets[Index] = Cur->HashNext;
+          Cur->HashNext = Buckets[Cur->Hash & (Size - 1)];
+          Buckets[Cur->Hash & (Size - 1)] = Cur;
+        }
       }
-      ptrCmtCur = ptrCmtNext;
-    } else {
-      ptrCmtPrev = ptrCmtCur;
-      ptrCmtCur = ptrCmtCur->ptrNext;
+      if (Table->Buckets != NULL) {
+        SctFreePool (Table->Buckets);
+      }
+      Table->Buckets = Buckets;
+      Table->Size    = Size;
+    }
+  }
+
+  if (Table->Buckets == NULL) {
+    //
+    // Nothing to chain to. Lookups fall back to a miss, which callers handle
+    // as if the table was never used.
+    //
+    Link->HashNext = NULL;
+    return;
+  }
+
+  Index = Link->Hash & (Table->Size - 1);
+  Link->HashNext = Table->Buckets[Index];
+  Table->Buckets[Index] = Link;
+  Table->Count ++;
+}
+
+VOID
+_hashRemove (
+  IN OUT INI_HASH_TABLE           *Table,
+  IN INI_HASH_LINK                *Link
+  )
+/*++
+
+Routine Description:
+
+  Remove a link from a hash table.
+
+--*/
+{
+  INI_HASH_LINK   **Prev;
+
+  if (Table->Buckets == NULL) {
+    return;
+  }
+
+  Prev = &Table->Buckets[Link->Hash & (Table->Size - 1)];
+  while (*Prev != NULL) {
+    if (*Prev == Link) {
+      *Prev = Link->HashNext;
+      Table->Count --;
+      return;
+    }
+    Prev = &(*Prev)->HashNext;
+  }
+}
+
+VOID
+_hashFree (
+  IN OUT INI_HASH_TABLE           *Table,
+  IN BOOLEAN                      FreeLinks
+  )
+/*++
+
+Routine Description:
+
+  Free a hash table, and optionally the pool buffers linked in it.
+
+--*/
+{
+  INI_HASH_LINK   *Cur;
+  UINT32          Index;
+
+  if (Table->Buckets == NULL) {
+    return;
+  }
+
+  if (FreeLinks) {
+    for (Index = 0; Index < Table->Size; Index ++) {
+      while (Table->Buckets[Index] != NULL) {
+        Cur = Table->Buckets[Index];
+        Table->Buckets[Index] = Cur->HashNext;
+        SctFreePool (Cur);
+      }
+    }
+  }
+
+  SctFreePool (Table->Buckets);
+  Table->Buckets = NULL;
+  Table->Size    = 0;
+  Table->Count   = 0;
+}
+
+INI_ATOM *
+_internString (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *String
+  )
+/*++
+
+Routine Description:
+
+  Return the interned copy of a string, creating it if needed. Interning is
+  case-sensitive, the spelling of every name is kept for the flush.
+
+--*/
+{
+  INI_ATOM        *Atom;
+  INI_HASH_LINK   *Cur;
+  UINT32          Hash;
+  UINTN           Length;
+
+  Hash = _hashString (String);
+  if (IniFile->Atoms.Buckets != NULL) {
+    Cur = IniFile->Atoms.Buckets[Hash & (IniFile->Atoms.Size - 1)];
+    while (Cur != NULL) {
+      Atom = (INI_ATOM *) Cur;
+      if ((Cur->Hash == Hash) && (SctAsciiStrCmp (Atom->String, String) == 0)) {
+        return Atom;
+      }
+      Cur = Cur->HashNext;
+    }
+  }
+
+  Length = SctAsciiStrLen (String);
+  Atom = (INI_ATOM *) SctAllocatePool (sizeof (INI_ATOM) + Length);
+  if (Atom == NULL) {
+    return NULL;
+  }
+
+  Atom->Link.Hash = Hash;
+  SctCopyMem (Atom->String, String, Length + 1);
+  _hashInsert (&IniFile->Atoms, &Atom->Link);
+  if (IniFile->Atoms.Buckets == NULL) {
+    //
+    // Not reachable from the table, so it can not be freed with it
+    //
+    SctFreePool (Atom);
+    return NULL;
+  }
+
+  return Atom;
+}
+
+INI_SECTION *
+_findGroup (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *Section
+  )
+/*++
+
+Routine Description:
+
+  Find the sections with the specific name (case-insensitive).
+
+--*/
+{
+  INI_SECTION     *Group;
+  INI_HASH_LINK   *Cur;
+  UINT32          Hash;
+
+  if (IniFile->Sections.Buckets == NULL) {
+    return NULL;
+  }
+
+  Hash = _hashString (Section);
+  Cur  = IniFile->Sections.Buckets[Hash & (IniFile->Sections.Size - 1)];
+  while (Cur != NULL) {
+    Group = (INI_SECTION *) Cur;
+    if ((Cur->Hash == Hash) && (SctAsciiStriCmp (Group->Name->String, Section) == 0)) {
+      return Group;
+    }
+    Cur = Cur->HashNext;
+  }
+
+  return NULL;
+}
+
+INI *
+_findEntry (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrHead,
+  IN CHAR8                        *Entry
+  )
+/*++
+
+Routine Description:
+
+  Find the first entry with the specific name (case-insensitive) in a section.
+
+--*/
+{
+  INI             *ptrItem;
+  INI_HASH_LINK   *Cur;
+  UINT32          Hash;
+
+  if (IniFile->Entries.Buckets == NULL) {
+    return NULL;
+  }
+
+  Hash = _hashEntry (ptrHead, Entry);
+  Cur  = IniFile->Entries.Buckets[Hash & (IniFile->Entries.Size - 1)];
+  while (Cur != NULL) {
+    ptrItem = (INI *) Cur;
+    if ((Cur->Hash == Hash) &&
+        (ptrItem->ptrHead == ptrHead) &&
+        (SctAsciiStriCmp (ptrItem->ptrEntry->String, Entry) == 0)) {
+      return ptrItem;
+    }
+    Cur = Cur->HashNext;
+  }
+
+  return NULL;
+}
+
+INI *
+_findFirstEntry (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *Section,
+  IN CHAR8                        *Entry
+  )
+/*++
+
+Routine Description:
+
+  Find the first entry in file order with the specific section and entry name.
+
+--*/
+{
+  INI_SECTION   *Group;
+  INI           *ptrItem;
+  UINT32        Index;
+
+  Group = _findGroup (IniFile, Section);
+  if (Group == NULL) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < Group->Count; Index ++) {
+    ptrItem = _findEntry (IniFile, Group->Instances[Index], Entry);
+    if (ptrItem != NULL) {
+      return ptrItem;
+    }
+  }
+
+  return NULL;
+}
+
+INI *
+_searchSection (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN UINT32                       Order,
+  IN CHAR8                        *Section
+)
+/*++
+
+Routine Description:
+
+  Search for the specific section in the ini table
+
+--*/
+{
+  INI_SECTION   *Group;
+
+  Group = _findGroup (IniFile, Section);
+  if ((Group == NULL) || (Order >= Group->Count)) {
+    return NULL;
+  }
+
+  return Group->Instances[Order];
+}
+
+INI *
+_newItem (
+  IN CHAR8                        *Value
+  )
+/*++
+
+Routine Description:
+
+  Allocate a new item with a copy of the value.
+
+--*/
+{
+  INI     *ptrItem;
+
+  ptrItem = (INI *) SctAllocateZeroPool (sizeof (INI));
+  if (ptrItem == NULL) {
+    return NULL;
+  }
+
+  ptrItem->ValueSize = SctAsciiStrLen (Value) + 1;
+  ptrItem->ptrValue  = (CHAR8 *) SctAllocatePool (ptrItem->ValueSize);
+  if (ptrItem->ptrValue == NULL) {
+    SctFreePool (ptrItem);
+    return NULL;
+  }
+  SctCopyMem (ptrItem->ptrValue, Value, ptrItem->ValueSize);
+
+  return ptrItem;
+}
+
+EFI_STATUS
+_addSection (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN CHAR8                        *Section,
+  OUT INI                         **ptrHead
+  )
+/*++
+
+Routine Description:
+
+  Append a new section head to the end of the ini table.
+
+--*/
+{
+  INI_SECTION   *Group;
+  INI           *ptrItem;
+  INI           **Instances;
+  INI_ATOM      *Name;
+
+  Name = _internString (IniFile, Section);
+  if (Name == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Group = _findGroup (IniFile, Section);
+  if (Group == NULL) {
+    Group = (INI_SECTION *) SctAllocateZeroPool (sizeof (INI_SECTION));
+    if (Group == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Group->Name      = Name;
+    Group->Link.Hash = Name->Link.Hash;
+    _hashInsert (&IniFile->Sections, &Group->Link);
+    if (IniFile->Sections.Buckets == NULL) {
+      SctFreePool (Group);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  if (Group->Count == Group->MaxCount) {
+    Instances = (INI **) SctAllocatePool ((Group->MaxCount + 4) * 2 * sizeof (INI *));
+    if (Instances == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    if (Group->Instances != NULL) {
+      SctCopyMem (Instances, Group->Instances, Group->Count * sizeof (INI *));
+      SctFreePool (Group->Instances);
+    }
+    Group->Instances = Instances;
+    Group->MaxCount  = (Group->MaxCount + 4) * 2;
+  }
+
+  ptrItem = _newItem ("");
+  if (ptrItem == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ptrItem->ptrHead    = ptrItem;
+  ptrItem->ptrSection = Name;
+  ptrItem->ptrEntry   = NULL;
+  ptrItem->Group      = Group;
+  ptrItem->ptrLast    = ptrItem;
+
+  Group->Instances[Group->Count] = ptrItem;
+  Group->Count ++;
+
+  ptrItem->ptrPrev = IniFile->Tail;
+  ptrItem->ptrNext = NULL;
+  if (IniFile->Tail != NULL) {
+    IniFile->Tail->ptrNext = ptrItem;
+  } else {
+    IniFile->Head = ptrItem;
+  }
+  IniFile->Tail = ptrItem;
+
+  *ptrHead = ptrItem;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+_addEntry (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrHead,
+  IN CHAR8                        *Entry,
+  IN CHAR8                        *Value,
+  OUT INI                         **ptrNew
+  )
+/*++
+
+Routine Description:
+
+  Append a new entry to the end of a section. Only the first entry of a name
+  in a section is hashed, it is the one every lookup returns.
+
+--*/
+{
+  INI       *ptrItem;
+  INI       *ptrLast;
+  INI_ATOM  *Name;
+
+  Name = _internString (IniFile, Entry);
+  if (Name == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ptrItem = _newItem (Value);
+  if (ptrItem == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ptrItem->ptrHead    = ptrHead;
+  ptrItem->ptrSection = ptrHead->ptrSection;
+  ptrItem->ptrEntry   = Name;
+
+  if (_findEntry (IniFile, ptrHead, Entry) == NULL) {
+    ptrItem->Link.Hash = _hashEntry (ptrHead, Entry);
+    _hashInsert (&IniFile->Entries, &ptrItem->Link);
+    ptrItem->isHashed = (BOOLEAN) (IniFile->Entries.Buckets != NULL);
+  }
+
+  ptrLast = ptrHead->ptrLast;
+  ptrItem->ptrPrev = ptrLast;
+  ptrItem->ptrNext = ptrLast->ptrNext;
+  if (ptrLast->ptrNext != NULL) {
+    ptrLast->ptrNext->ptrPrev = ptrItem;
+  } else {
+    IniFile->Tail = ptrItem;
+  }
+  ptrLast->ptrNext  = ptrItem;
+  ptrHead->ptrLast  = ptrItem;
+
+  *ptrNew = ptrItem;
+  return EFI_SUCCESS;
+}
+
+VOID
+_rmSection (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN INI                          *ptrHead
+  )
+/*++
+
+Routine Description:
+
+  Remove a section and all its entries and comment lines.
+
+--*/
+{
+  INI_SECTION   *Group;
+  INI           *ptrCur;
+  INI           *ptrNext;
+  INI           *ptrEnd;
+  UINT32        Index;
+
+  //
+  // Remove it from the instance table of its name. Sections are mostly
+  // removed from the last one, so search from the end.
+  //
+  Group = ptrHead->Group;
+  for (Index = Group->Count; Index > 0; Index --) {
+    if (Group->Instances[Index - 1] == ptrHead) {
+      break;
+    }
+  }
+  if (Index == 0) {
+    return;
+  }
+  for (Index --; Index + 1 < Group->Count; Index ++) {
+    Group->Instances[Index] = Group->Instances[Index + 1];
+  }
+  Group->Count --;
+
+  //
+  // Unlink the section from the ini table
+  //
+  ptrEnd = ptrHead->ptrLast->ptrNext;
+  if (ptrHead->ptrPrev == NULL) {
+    IniFile->Head = ptrEnd;
+  } else {
+    ptrHead->ptrPrev->ptrNext = ptrEnd;
+  }
+  if (ptrEnd == NULL) {
+    IniFile->Tail = ptrHead->ptrPrev;
+  } else {
+    ptrEnd->ptrPrev = ptrHead->ptrPrev;
+  }
+
+  ptrCur = ptrHead;
+  while (ptrCur != ptrEnd) {
+    ptrNext = ptrCur->ptrNext;
+    if (ptrCur->isHashed) {
+      _hashRemove (&IniFile->Entries, &ptrCur->Link);
+    }
+    _freeItem (ptrCur);
+    ptrCur = ptrNext;
+  }
+}
+
+VOID
+_freeItem (
+  IN INI                          *ptrItem
+  )
+/*++
+
+Routine Description:
+
+  Free an INI item and its comment lines.
+
+--*/
+{
+  _freeComment (ptrItem->CommentLineHead);
+  if (ptrItem->ptrValue != NULL) {
+    SctFreePool (ptrItem->ptrValue);
+  }
+  SctFreePool (ptrItem);
+}
+
+VOID
+_freeComment (
+  IN COMMENTLINE                  *ptrCmtHead
+  )
+/*++
+
+Routine Description:
+
+  Free a list of comment lines.
+
+--*/
+{
+  COMMENTLINE *ptrCmtNext;
+
+  while (ptrCmtHead != NULL) {
+    ptrCmtNext = ptrCmtHead->ptrNext;
+    SctFreePool (ptrCmtHead);
+    ptrCmtHead = ptrCmtNext;
+  }
+}
+
+VOID
+_outAppend (
+  IN OUT INI_OUTPUT               *Output,
+  IN CHAR8                        *String,
+  IN UINTN                        Length
+  )
+/*++
+
+Routine Description:
+
+  Append bytes to the output buffer. Once an allocation fails, the error is
+  kept in the buffer and the following appends are ignored.
+
+--*/
+{
+  CHAR8   *Data;
+  UINTN   MaxSize;
+
+  if (EFI_ERROR (Output->Status)) {
+    return;
+  }
+
+  if (Output->Size + Length > Output->MaxSize) {
+    MaxSize = (Output->MaxSize == 0) ? MAX_LINE_LEN * 10 : Output->MaxSize;
+    while (Output->Size + Length > MaxSize) {
+      MaxSize *= 2;
+    }
+
+    Data = (CHAR8 *) SctAllocatePool (MaxSize);
+    if (Data == NULL) {
+      Output->Status = EFI_OUT_OF_RESOURCES;
+      return;
+    }
+    if (Output->Data != NULL) {
+      SctCopyMem (Data, Output->Data, Output->Size);
+      SctFreePool (Output->Data);
+    }
+    Output->Data    = Data;
+    Output->MaxSize = MaxSize;
+  }
+
+  SctCopyMem (Output->Data + Output->Size, String, Length);
+  Output->Size += Length;
+}
+
+VOID
+_outString (
+  IN OUT INI_OUTPUT               *Output,
+  IN CHAR8                        *String
+  )
+{
+  _outAppend (Output, String, SctAsciiStrLen (String));
+}
+
+VOID
+_outChunkEnd (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN OUT INI_OUTPUT               *Output
+  )
+/*++
+
+Routine Description:
+
+  End a chunk of the file. A unicode ini file has always been written one
+  section at a time including the string terminator, and the terminator is
+  kept so that the file content stays the same.
+
+--*/
+{
+  if (IniFile->isUnicode) {
+    _outAppend (Output, "", 1);
+  }
+}
+
+VOID
+_buildFile (
+  IN EFI_INI_FILE_PRIVATE_DATA    *IniFile,
+  IN OUT INI_OUTPUT               *Output
+  )
+/*++
+
+Routine Description:
+
+  Build the ini file image: every section starts with its comment lines and
+  its head, separated from the previous section by a blank line. Each entry
+  follows its own comment lines. The comment lines at the end of the file are
+  written last.
+
+--*/
+{
+  INI           *ptrCur;
+  COMMENTLINE   *ptrCmtCur;
+
+  for (ptrCur = IniFile->Head; ptrCur != NULL; ptrCur = ptrCur->ptrNext) {
+    if ((ptrCur->ptrEntry == NULL) && (ptrCur != IniFile->Head)) {
+      //
+      // New section encountered, end the previous section and add a blank
+      // line
+      //
+      _outChunkEnd (IniFile, Output);
+      _outString (Output, "\r\n");
+    }
+
+    //
+    //  If there are comment lines before this line, write comment lines first
+    //
+    for (ptrCmtCur = ptrCur->CommentLineHead; ptrCmtCur != NULL; ptrCmtCur = ptrCmtCur->ptrNext) {
+      _outString (Output, ptrCmtCur->ptrComment);
+      _outString (Output, "\r\n");
+    }
+
+    if (ptrCur->ptrEntry == NULL) {
+      //
+      // new section, write the section head
+      //
+      _outString (Output, "[");
+      _outString (Output, ptrCur->ptrSection->String);
+      _outString (Output, "]\r\n");
+    } else {
+      //
+      // write the entry and value line
+      //
+      _outString (Output, ptrCur->ptrEntry->String);
+      _outString (Output, "=");
+      _outString (Output, ptrCur->ptrValue);
+      _outString (Output, "\r\n");
+    }
+  }
+
+  //
+  // End the last section
+  //
+  if (IniFile->Head != NULL) {
+    _outChunkEnd (IniFile, Output);
+  }
+
+  //
+  //  If there are comment lines in the end of the file, write these comment lines
+  //
+  if (IniFile->CommentLineHead != NULL) {
+    for (ptrCmtCur = IniFile->CommentLineHead; ptrCmtCur != NULL; ptrCmtCur = ptrCmtCur->ptrNext) {
+      _outString (Output, ptrCmtCur->ptrComment);
+      _outString (Output, "\r\n");
     }
+    _outChunkEnd (IniFile, Output);
   }
 }
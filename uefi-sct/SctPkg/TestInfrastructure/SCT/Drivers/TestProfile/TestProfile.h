@@ -59,26 +59,91 @@ typedef struct {
 #define MAX_STRING_LEN      100
 #define MAX_LINE_LEN        512
 
+//
+// Initial number of buckets of the hash tables in an ini file. The tables
+// grow by doubling when the load factor exceeds INI_HASH_MAX_LOAD.
+//
+#define INI_HASH_INIT_SIZE  64
+#define INI_HASH_MAX_LOAD   2
+
 //
 // Forward reference for pure ANSI compatibility
 //
 
+typedef struct _INI_HASH_LINK INI_HASH_LINK;
+typedef struct _INI_ATOM INI_ATOM;
+typedef struct _INI_SECTION INI_SECTION;
 typedef struct _INI INI;
 typedef struct _COMMENTLINE COMMENTLINE;
 
+//
+// Hash chain link. It is the first field of every hashed structure. The hash
+// is computed on the case-insensitive name of the structure, and for an entry
+// also on the section instance that holds it.
+//
+struct _INI_HASH_LINK {
+  INI_HASH_LINK                   *HashNext;
+  UINT32                          Hash;
+};
+
+typedef struct {
+  UINT32                          Size;
+  UINT32                          Count;
+  INI_HASH_LINK                   **Buckets;
+} INI_HASH_TABLE;
+
+//
+// Interned string. Section and entry names are stored once per ini file and
+// shared by all the items that use them.
+//
+struct _INI_ATOM {
+  INI_HASH_LINK                   Link;
+  CHAR8                           String[1];
+};
+
+//
+// All the sections with the same (case-insensitive) name. Instances holds the
+// section head items in file order, so that Instances[Order] is the section
+// of that order.
+//
+struct _INI_SECTION {
+  INI_HASH_LINK                   Link;
+  INI_ATOM                        *Name;
+  UINT32                          Count;
+  UINT32                          MaxCount;
+  INI                             **Instances;
+};
+
+//
+// One line of the ini file: a section head (ptrEntry is NULL) or an entry.
+// Entries are hashed on (ptrHead, ptrEntry), so a lookup only visits the
+// entries of one section instance.
+//
 struct _INI {
-  UINT32                          commentNo;
-  CHAR8                           ptrSection[MAX_STRING_LEN + 1];
-  CHAR8                           ptrEntry[MAX_STRING_LEN + 1];
-  CHAR8                           ptrValue[MAX_STRING_LEN + 1];
+  INI_HASH_LINK                   Link;
   INI                             *ptrNext;
+  INI                             *ptrPrev;
+  INI                             *ptrHead;
+  INI_ATOM                        *ptrSection;
+  INI_ATOM                        *ptrEntry;
+  CHAR8                           *ptrValue;
+  UINTN                           ValueSize;
+  BOOLEAN                         isHashed;
+  COMMENTLINE                     *CommentLineHead;
+  //
+  // Section head only
+  //
+  INI_SECTION                     *Group;
+  INI                             *ptrLast;
 };
 
-
+//
+// Comment lines are kept with the line that follows them in the file. Comment
+// lines at the end of the file are kept in the ini file itself.
+//
 struct _COMMENTLINE {
-  UINT32                          commentNo;
-  CHAR8                           ptrComment[MAX_LINE_LEN];
   COMMENTLINE                     *ptrNext;
+  CHAR8                           ptrComment[1];
 };
 
 typedef struct {
@@ -89,10 +154,24 @@ typedef struct {
   INI                             *Head;
   INI                             *Tail;
   COMMENTLINE                     *CommentLineHead;
+  COMMENTLINE                     *CommentLineTail;
+  INI_HASH_TABLE                  Atoms;
+  INI_HASH_TABLE                  Sections;
+  INI_HASH_TABLE                  Entries;
   BOOLEAN                         isUnicode;
   BOOLEAN                         Modified;
 } EFI_INI_FILE_PRIVATE_DATA;
 
+//
+// Output buffer used to build the ini file image on flush
+//
+typedef struct {
+  CHAR8                           *Data;
+  UINTN                           Size;
+  UINTN                           MaxSize;
+  EFI_STATUS                      Status;
+} INI_OUTPUT;
+
 #define EFI_INI_FILE_PRIVATE_DATA_FROM_THIS(a)  \
   CR(a, EFI_INI_FILE_PRIVATE_DATA, Handle, EFI_INI_FILE_PRIVATE_DATA_SIGNATURE)
 
@@ -126,6 +126,17 @@ Returns:
   }
   gFT->TestCaseIniFile = NULL;
 
+  gFT->TestCaseJournalName = SctPoolPrint (
+                 L"%s\\%s",
+                 gFT->FilePath,
+                 EFI_SCT_FILE_TEST_CASE_JOURNAL
+                 );
+  if (gFT->TestCaseJournalName == NULL) {
+    FreeFrameworkTable ();
+    return EFI_OUT_OF_RESOURCES;
+  }
+  gFT->TestCaseJournal = NULL;
+
   gFT->IsFirstTimeExecute = TRUE;
 
   //
@@ -174,6 +185,11 @@ Routine Description:
 
 --*/
 {
+  //
+  // Write out the buffered output and return to the write-through mode
+  //
+  SetOutputBufferPolicy (0, 0);
+
   //
   // Close/Free the INI file
   //
@@ -182,6 +198,14 @@ Routine Description:
     gFT->TplProtocol->EfiIniClose (gFT->TplProtocol, gFT->TestCaseIniFile);
   }
 
+  //
+  // Close/Free the test case journal
+  //
+  CloseTestCaseJournal ();
+  if (gFT->TestCaseJournalName != NULL) {
+    tBS->FreePool (gFT->TestCaseJournalName);
+  }
+
   //
   // Close the standard test support files
   //
@@ -217,6 +217,54 @@ Returns:
     ConfigData->EditCommandString = SctStrDuplicate (Buffer);
   }
 
+  //
+  // Get the buffer size of the test output files
+  //
+  Status = ConfigGetString (IniFile, L"OutputBufferSize", Buffer);
+  if (!EFI_ERROR (Status)) {
+    SctStrToInt (Buffer, &ConfigData->OutputBufferSize);
+  }
+
+  //
+  // Get the flush interval of the test output files
+  //
+  Status = ConfigGetString (IniFile, L"OutputFlushInterval", Buffer);
+  if (!EFI_ERROR (Status)) {
+    SctStrToInt (Buffer, &ConfigData->OutputFlushInterval);
+  }
+
+  //
+  // Get the test manifest enabled
+  //
+  Status = ConfigGetString (IniFile, L"EnableTestManifest", Buffer);
+  if (!EFI_ERROR (Status)) {
+    SctStrToBoolean (Buffer, &ConfigData->EnableTestManifest);
+  }
+
+  //
+  // Get the reset batching enabled
+  //
+  Status = ConfigGetString (IniFile, L"EnableResetBatching", Buffer);
+  if (!EFI_ERROR (Status)) {
+    SctStrToBoolean (Buffer, &ConfigData->EnableResetBatching);
+  }
+
+  //
+  // Get the instance profile enabled
+  //
+  Status = ConfigGetString (IniFile, L"EnableInstanceProfile", Buffer);
+  if (!EFI_ERROR (Status)) {
+    SctStrToBoolean (Buffer, &ConfigData->EnableInstanceProfile);
+  }
+
+  //
+  // Get the binary key file enabled
+  //
+  Status = ConfigGetString (IniFile, L"EnableBinaryKeyFile", Buffer);
+  if (!EFI_ERROR (Status)) {
+    SctStrToBoolean (Buffer, &ConfigData->EnableBinaryKeyFile);
+  }
+
   //
   // Check error
   //
@@ -369,6 +417,54 @@ Returns:
   //
   ConfigSetString (IniFile, L"EditCommandString", ConfigData->EditCommandString);
 
+  //
+  // Save the buffer size of the test output files
+  //
+  Status = SctIntToStr (ConfigData->OutputBufferSize, Buffer);
+  if (!EFI_ERROR (Status)) {
+    ConfigSetString (IniFile, L"OutputBufferSize", Buffer);
+  }
+
+  //
+  // Save the flush interval of the test output files
+  //
+  Status = SctIntToStr (ConfigData->OutputFlushInterval, Buffer);
+  if (!EFI_ERROR (Status)) {
+    ConfigSetString (IniFile, L"OutputFlushInterval", Buffer);
+  }
+
+  //
+  // Save the test manifest enabled
+  //
+  Status = SctBooleanToStr (ConfigData->EnableTestManifest, Buffer);
+  if (!EFI_ERROR (Status)) {
+    ConfigSetString (IniFile, L"EnableTestManifest", Buffer);
+  }
+
+  //
+  // Save the reset batching enabled
+  //
+  Status = SctBooleanToStr (ConfigData->EnableResetBatching, Buffer);
+  if (!EFI_ERROR (Status)) {
+    ConfigSetString (IniFile, L"EnableResetBatching", Buffer);
+  }
+
+  //
+  // Save the instance profile enabled
+  //
+  Status = SctBooleanToStr (ConfigData->EnableInstanceProfile, Buffer);
+  if (!EFI_ERROR (Status)) {
+    ConfigSetString (IniFile, L"EnableInstanceProfile", Buffer);
+  }
+
+  //
+  // Save the binary key file enabled
+  //
+  Status = SctBooleanToStr (ConfigData->EnableBinaryKeyFile, Buffer);
+  if (!EFI_ERROR (Status)) {
+    ConfigSetString (IniFile, L"EnableBinaryKeyFile", Buffer);
+  }
+
   //
   // Close the file
   //
@@ -484,6 +580,14 @@ Routine Description:
 
   ConfigData->EditCommandString   = SctStrDuplicate (EDIT_COMMAND_DEFAULT);
 
+  ConfigData->OutputBufferSize    = OUTPUT_BUFFER_SIZE_DEFAULT;
+  ConfigData->OutputFlushInterval = OUTPUT_FLUSH_INTERVAL_DEFAULT;
+
+  ConfigData->EnableTestManifest  = ENABLE_TEST_MANIFEST_DEFAULT;
+  ConfigData->EnableResetBatching = ENABLE_RESET_BATCHING_DEFAULT;
+  ConfigData->EnableInstanceProfile = ENABLE_INSTANCE_PROFILE_DEFAULT;
+  ConfigData->EnableBinaryKeyFile = ENABLE_BINARY_KEY_FILE_DEFAULT;
+
   ConfigData->TestLevel           = EFI_TEST_LEVEL_MINIMAL | EFI_TEST_LEVEL_DEFAULT;
   ConfigData->VerboseLevel        = EFI_VERBOSE_LEVEL_DEFAULT;
 
@@ -31,6 +31,25 @@ Abstract:
 //
 
 #define EFI_SCT_SECTION_TEST_CASE           L"Test Case"
+#define EFI_SCT_SECTION_TEST_RESET          L"Test Reset"
+
+//
+// A record of the test case journal. Each record holds the whole state of one
+// test case, so replaying the journal in order and keeping the last record of
+// every test case gives the latest state.
+//
+#define EFI_SCT_TEST_CASE_RECORD_SIGNATURE  EFI_SIGNATURE_32('s','t','c','r')
+
+typedef struct {
+  UINT32                    Signature;
+  UINT32                    Order;
+  EFI_GUID                  Guid;
+  UINT32                    Iterations;
+  UINT32                    Passes;
+  UINT32                    Warnings;
+  UINT32                    Failures;
+  UINT32                    Crc32;
+} EFI_SCT_TEST_CASE_RECORD;
 
 //
 // Internal function declaration
@@ -80,6 +99,21 @@ FreeSingleTestCase (
   IN EFI_SCT_TEST_CASE            *TestCase
   );
 
+EFI_STATUS
+OpenTestCaseFile (
+  VOID
+  );
+
+EFI_STATUS
+ResetTestCaseJournal (
+  VOID
+  );
+
+EFI_STATUS
+OpenTestCaseJournal (
+  OUT EFI_FILE_HANDLE             *Handle
+  );
+
 EFI_STATUS
 TestCaseGetOrderNum (
   IN EFI_INI_FILE_HANDLE          IniFile,
@@ -260,29 +294,9 @@ Returns:
   //
   // Open/Create the TestCase file if not done yet
   //
-  if (gFT->TestCaseIniFile == NULL) {
-    Status = gFT->TplProtocol->EfiIniOpen (
-                                 gFT->TplProtocol,
-                                 gFT->DevicePath,
-                                 gFT->TestCaseFileName,
-                                 &gFT->TestCaseIniFile
-                                 );
-    if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
-      return Status;
-    }
-
-    // Not exist, create the file
-    if (Status == EFI_NOT_FOUND) {
-      Status = gFT->TplProtocol->EfiIniCreate (
-                                   gFT->TplProtocol,
-                                   gFT->DevicePath,
-                                   gFT->TestCaseFileName,
-                                   &gFT->TestCaseIniFile
-                                   );
-      if (EFI_ERROR (Status)) {
-        return Status;
-      }
-    }
+  Status = OpenTestCaseFile ();
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   // Initial variables
@@ -334,6 +348,204 @@ Returns:
                       IniFile
                       );
 
+  //
+  // The test case file holds the latest state now, start a new journal
+  //
+  Status = ResetTestCaseJournal ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Reset test case journal - %r", Status));
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+JournalTestCase (
+  IN EFI_SCT_TEST_CASE            *TestCase
+  )
+/*++
+
+Routine Description:
+
+  Append the state of a test case to the test case journal. It is used on the
+  test case boundaries instead of SaveTestCases, which rewrites the whole test
+  case file.
+
+  The journal is started by SaveTestCases. If it is not started yet, or it
+  cannot be written, the test case file is saved instead.
+
+Arguments:
+
+  TestCase      - Pointer to the test case.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS                Status;
+  UINTN                     BufferSize;
+  EFI_SCT_TEST_CASE_RECORD  Record;
+
+  //
+  // Check parameters
+  //
+  if (TestCase == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Journal records only make sense on top of a saved test case file
+  //
+  if (gFT->TestCaseJournal == NULL) {
+    return SaveTestCases ();
+  }
+
+  //
+  // Build the record
+  //
+  SctZeroMem (&Record, sizeof(EFI_SCT_TEST_CASE_RECORD));
+
+  Record.Signature  = EFI_SCT_TEST_CASE_RECORD_SIGNATURE;
+  Record.Order      = TestCase->Order;
+  Record.Iterations = TestCase->Iterations;
+  Record.Passes     = TestCase->Passes;
+  Record.Warnings   = TestCase->Warnings;
+  Record.Failures   = TestCase->Failures;
+  SctCopyMem (&Record.Guid, &TestCase->Guid, sizeof(EFI_GUID));
+
+  tBS->CalculateCrc32 (&Record, sizeof(EFI_SCT_TEST_CASE_RECORD), &Record.Crc32);
+
+  //
+  // Append it to the journal
+  //
+  BufferSize = sizeof(EFI_SCT_TEST_CASE_RECORD);
+  Status = gFT->TestCaseJournal->Write (
+                                   gFT->TestCaseJournal,
+                                   &BufferSize,
+                                   &Record
+                                   );
+  if (!EFI_ERROR (Status)) {
+    Status = gFT->TestCaseJournal->Flush (gFT->TestCaseJournal);
+  }
+
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Write test case journal - %r", Status));
+    CloseTestCaseJournal ();
+    return SaveTestCases ();
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+ReplayTestCaseJournal (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Apply the records of the test case journal to the loaded test cases, and
+  compact them into the test case file. A torn record at the end of the
+  journal (the system was reset during the write) stops the replay.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS                Status;
+  UINTN                     BufferSize;
+  UINTN                     NumberOfRecords;
+  UINT32                    Crc32;
+  EFI_FILE_HANDLE           Handle;
+  EFI_SCT_TEST_CASE         *TestCase;
+  EFI_SCT_TEST_CASE_RECORD  Record;
+
+  //
+  // Debug information
+  //
+  EFI_SCT_DEBUG ((EFI_SCT_D_TRACE, L"Replay test case journal <%s>", gFT->TestCaseJournalName));
+
+  //
+  // Open the journal
+  //
+  Status = OpenTestCaseJournal (&Handle);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Test case journal doesn't exist"));
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Walk through all records
+  //
+  NumberOfRecords = 0;
+
+  while (TRUE) {
+    BufferSize = sizeof(EFI_SCT_TEST_CASE_RECORD);
+    Status = Handle->Read (Handle, &BufferSize, &Record);
+    if (EFI_ERROR (Status) || (BufferSize != sizeof(EFI_SCT_TEST_CASE_RECORD))) {
+      break;
+    }
+
+    if (Record.Signature != EFI_SCT_TEST_CASE_RECORD_SIGNATURE) {
+      break;
+    }
+
+    Crc32        = Record.Crc32;
+    Record.Crc32 = 0;
+    tBS->CalculateCrc32 (&Record, sizeof(EFI_SCT_TEST_CASE_RECORD), &Record.Crc32);
+    if (Record.Crc32 != Crc32) {
+      break;
+    }
+
+    NumberOfRecords ++;
+
+    //
+    // The test case may be gone if the test case file was removed
+    //
+    Status = FindTestCaseByGuid (&Record.Guid, &TestCase);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    TestCase->Order      = Record.Order;
+    TestCase->Iterations = Record.Iterations;
+    TestCase->Passes     = Record.Passes;
+    TestCase->Warnings   = Record.Warnings;
+    TestCase->Failures   = Record.Failures;
+  }
+
+  Handle->Close (Handle);
+
+  EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Replay %d test case records", NumberOfRecords));
+
+  if (NumberOfRecords == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Compact the journal into the test case file
+  //
+  Status = SaveTestCases ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Save test cases - %r", Status));
+    return Status;
+  }
+
   //
   // Done
   //
@@ -341,6 +553,303 @@ Returns:
 }
 
 
+EFI_STATUS
+RecordTestReset (
+  IN EFI_RESET_TYPE               ResetType
+  )
+/*++
+
+Routine Description:
+
+  Count a system reset issued by the framework for a test case. The counters
+  are kept in the test case file, so they survive the reset.
+
+Arguments:
+
+  ResetType     - Type of the reset.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT32      WarmResets;
+  UINT32      ColdResets;
+  CHAR16      Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+
+  Status = GetTestResets (&WarmResets, &ColdResets);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (ResetType == EfiResetWarm) {
+    WarmResets ++;
+  } else {
+    ColdResets ++;
+  }
+
+  //
+  // Only the reset section changes, the test cases in the file are the last
+  // saved ones and the journal still applies on top of them
+  //
+  SctShortToStr (WarmResets, Buffer);
+  gFT->TestCaseIniFile->SetString (
+                          gFT->TestCaseIniFile,
+                          EFI_SCT_SECTION_TEST_RESET,
+                          L"WarmResets",
+                          Buffer
+                          );
+
+  SctShortToStr (ColdResets, Buffer);
+  gFT->TestCaseIniFile->SetString (
+                          gFT->TestCaseIniFile,
+                          EFI_SCT_SECTION_TEST_RESET,
+                          L"ColdResets",
+                          Buffer
+                          );
+
+  return gFT->TplProtocol->EfiIniFlush (
+                             gFT->TplProtocol,
+                             gFT->TestCaseIniFile
+                             );
+}
+
+
+EFI_STATUS
+GetTestResets (
+  OUT UINT32                      *WarmResets,
+  OUT UINT32                      *ColdResets
+  )
+/*++
+
+Routine Description:
+
+  Get the number of system resets issued by the framework in this test run.
+
+Arguments:
+
+  WarmResets    - Number of warm resets.
+  ColdResets    - Number of cold resets.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT32      BufferSize;
+  CHAR16      Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+
+  if ((WarmResets == NULL) || (ColdResets == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *WarmResets = 0;
+  *ColdResets = 0;
+
+  Status = OpenTestCaseFile ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  BufferSize = EFI_SCT_MAX_BUFFER_SIZE;
+  Status = gFT->TestCaseIniFile->GetString (
+                                   gFT->TestCaseIniFile,
+                                   EFI_SCT_SECTION_TEST_RESET,
+                                   L"WarmResets",
+                                   Buffer,
+                                   &BufferSize
+                                   );
+  if (!EFI_ERROR (Status)) {
+    SctStrToShort (Buffer, WarmResets);
+  }
+
+  BufferSize = EFI_SCT_MAX_BUFFER_SIZE;
+  Status = gFT->TestCaseIniFile->GetString (
+                                   gFT->TestCaseIniFile,
+                                   EFI_SCT_SECTION_TEST_RESET,
+                                   L"ColdResets",
+                                   Buffer,
+                                   &BufferSize
+                                   );
+  if (!EFI_ERROR (Status)) {
+    SctStrToShort (Buffer, ColdResets);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+SetTestResetBatching (
+  IN BOOLEAN                      ResetBatching
+  )
+/*++
+
+Routine Description:
+
+  Record whether the test cases with reset are batched in this test run, so
+  a run resumed after a reset keeps the same execution order. The order of
+  the test cases itself is not changed.
+
+Arguments:
+
+  ResetBatching - TRUE if the test cases with reset are batched.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS  Status;
+  CHAR16      Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+
+  Status = OpenTestCaseFile ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = SctBooleanToStr (ResetBatching, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  gFT->TestCaseIniFile->SetString (
+                          gFT->TestCaseIniFile,
+                          EFI_SCT_SECTION_TEST_RESET,
+                          L"ResetBatching",
+                          Buffer
+                          );
+
+  return gFT->TplProtocol->EfiIniFlush (
+                             gFT->TplProtocol,
+                             gFT->TestCaseIniFile
+                             );
+}
+
+
+EFI_STATUS
+GetTestResetBatching (
+  OUT BOOLEAN                     *ResetBatching
+  )
+/*++
+
+Routine Description:
+
+  Get whether the test cases with reset are batched in this test run.
+
+Arguments:
+
+  ResetBatching - TRUE if the test cases with reset are batched.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT32      BufferSize;
+  CHAR16      Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+
+  if (ResetBatching == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *ResetBatching = FALSE;
+
+  Status = OpenTestCaseFile ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  BufferSize = EFI_SCT_MAX_BUFFER_SIZE;
+  Status = gFT->TestCaseIniFile->GetString (
+                                   gFT->TestCaseIniFile,
+                                   EFI_SCT_SECTION_TEST_RESET,
+                                   L"ResetBatching",
+                                   Buffer,
+                                   &BufferSize
+                                   );
+  if (!EFI_ERROR (Status)) {
+    SctStrToBoolean (Buffer, ResetBatching);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+ClearTestResets (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Clear the reset counters and the reset batching flag at the start of a test
+  run. The change is written with the next save of the test cases.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS  Status;
+
+  Status = OpenTestCaseFile ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gFT->TestCaseIniFile->RmSection (
+                                   gFT->TestCaseIniFile,
+                                   EFI_SCT_SECTION_TEST_RESET
+                                   );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    return Status;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+CloseTestCaseJournal (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Close the test case journal. The next journal record will save the test case
+  file and start a new journal.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+
+--*/
+{
+  if (gFT->TestCaseJournal != NULL) {
+    gFT->TestCaseJournal->Close (gFT->TestCaseJournal);
+    gFT->TestCaseJournal = NULL;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 EFI_STATUS
 LoadTestSequence (
   IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
@@ -1653,3 +2162,156 @@ Routine Description:
                     Buffer
                     );
 }
+
+
+EFI_STATUS
+OpenTestCaseFile (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Open the test case file if not done yet. It is created if it doesn't exist.
+
+--*/
+{
+  EFI_STATUS  Status;
+
+  if (gFT->TestCaseIniFile != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gFT->TplProtocol->EfiIniOpen (
+                               gFT->TplProtocol,
+                               gFT->DevicePath,
+                               gFT->TestCaseFileName,
+                               &gFT->TestCaseIniFile
+                               );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    return Status;
+  }
+
+  //
+  // Not exist, create the file
+  //
+  if (Status == EFI_NOT_FOUND) {
+    Status = gFT->TplProtocol->EfiIniCreate (
+                                 gFT->TplProtocol,
+                                 gFT->DevicePath,
+                                 gFT->TestCaseFileName,
+                                 &gFT->TestCaseIniFile
+                                 );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+ResetTestCaseJournal (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Start a new (empty) test case journal and keep it open for appending.
+
+--*/
+{
+  EFI_STATUS  Status;
+
+  CloseTestCaseJournal ();
+
+  //
+  // Create the file, an existing one is deleted first
+  //
+  Status = SctCreateFileFromDevicePath (
+             gFT->DevicePath,
+             gFT->TestCaseJournalName,
+             &gFT->TestCaseJournal
+             );
+  if (EFI_ERROR (Status)) {
+    gFT->TestCaseJournal = NULL;
+    return Status;
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+OpenTestCaseJournal (
+  OUT EFI_FILE_HANDLE             *Handle
+  )
+/*++
+
+Routine Description:
+
+  Open the test case journal for reading.
+
+--*/
+{
+  EFI_STATUS                        Status;
+  EFI_HANDLE                        DeviceHandle;
+  EFI_FILE_HANDLE                   RootDir;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL   *Vol;
+  EFI_DEVICE_PATH_PROTOCOL          *RemainingDevicePath;
+
+  //
+  // Locate the device handle
+  //
+  RemainingDevicePath = gFT->DevicePath;
+  Status = tBS->LocateDevicePath (
+                 &gEfiSimpleFileSystemProtocolGuid,
+                 &RemainingDevicePath,
+                 &DeviceHandle
+                 );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Locate the simple file system
+  //
+  Status = tBS->HandleProtocol (
+                 DeviceHandle,
+                 &gEfiSimpleFileSystemProtocolGuid,
+                 (VOID **)&Vol
+                 );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Open the root directory
+  //
+  Status = Vol->OpenVolume (Vol, &RootDir);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Open the file
+  //
+  Status = RootDir->Open (
+                      RootDir,
+                      Handle,
+                      gFT->TestCaseJournalName,
+                      EFI_FILE_MODE_READ,
+                      0
+                      );
+
+  RootDir->Close (RootDir);
+  return Status;
+}
@@ -654,7 +654,8 @@ GetNextTestCase (
 
 Routine Description:
 
-  Get the next test case.
+  Get the next test case. The test cases marked by BatchResetTestCases come
+  after all other test cases.
 
 Arguments:
 
@@ -668,7 +669,6 @@ Returns:
 
 --*/
 {
-  UINT32              Order;
   SCT_LIST_ENTRY      *Link;
   EFI_SCT_TEST_CASE   *TempTestCase;
   EFI_SCT_TEST_CASE   *Target;
@@ -683,22 +683,23 @@ Returns:
   //
   // Initialize
   //
-  Order  = EFI_SCT_TEST_CASE_INVALID;
   Target = NULL;
 
   //
-  // Walk through all test cases
+  // Walk through all test cases. The batched ones sort after the others, the
+  // order is compared inside each group.
   //
   for (Link = gFT->TestCaseList.ForwardLink; Link != &gFT->TestCaseList; Link = Link->ForwardLink) {
     TempTestCase = CR (Link, EFI_SCT_TEST_CASE, Link, EFI_SCT_TEST_CASE_SIGNATURE);
 
     if (TempTestCase->Order != EFI_SCT_TEST_CASE_INVALID) {
-      if ((Order == EFI_SCT_TEST_CASE_INVALID) ||
-          (Order >  TempTestCase->Order      )) {
+      if ((Target == NULL) ||
+          (Target->ResetBatched && !TempTestCase->ResetBatched) ||
+          ((Target->ResetBatched == TempTestCase->ResetBatched) &&
+           (Target->Order        >  TempTestCase->Order       ))) {
         if ((TempTestCase->Passes   == EFI_SCT_TEST_CASE_INVALID) ||
             (TempTestCase->Warnings == EFI_SCT_TEST_CASE_INVALID) ||
             (TempTestCase->Failures == EFI_SCT_TEST_CASE_INVALID)) {
-          Order  = TempTestCase->Order;
           Target = TempTestCase;
         }
       }
@@ -923,6 +924,169 @@ Arguments:
 }
 
 
+EFI_STATUS
+BatchResetTestCases (
+  IN BOOLEAN                      ResetBatching
+  )
+/*++
+
+Routine Description:
+
+  Mark the selected test cases which require a system reset, so GetNextTestCase
+  runs them behind all other selected test cases. The test cases without reset
+  then run in one boot, and the test cases with reset run back to back at the
+  end. The relative order inside each group is kept. Only the test cases in
+  memory are marked, the order saved in the test case file is not changed.
+
+Arguments:
+
+  ResetBatching - TRUE to mark the test cases, FALSE to clear the marks.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS          Status;
+  UINTN               NumberOfResetCases;
+  SCT_LIST_ENTRY      *Link;
+  EFI_SCT_TEST_CASE   *TestCase;
+  EFI_TEST_ATTRIBUTE  CaseAttribute;
+
+  NumberOfResetCases = 0;
+
+  for (Link = gFT->TestCaseList.ForwardLink; Link != &gFT->TestCaseList; Link = Link->ForwardLink) {
+    TestCase = CR (Link, EFI_SCT_TEST_CASE, Link, EFI_SCT_TEST_CASE_SIGNATURE);
+
+    TestCase->ResetBatched = FALSE;
+
+    if (!ResetBatching || (TestCase->Order == EFI_SCT_TEST_CASE_INVALID)) {
+      continue;
+    }
+
+    Status = GetTestCaseAttribute (&TestCase->Guid, &CaseAttribute);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    if ((CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) != 0) {
+      TestCase->ResetBatched = TRUE;
+      NumberOfResetCases ++;
+    }
+  }
+
+  EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Batch %d reset test cases", NumberOfResetCases));
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+GetResetBatchingGain (
+  OUT UINTN                       *Cases,
+  OUT UINTN                       *BaselineCases,
+  OUT UINTN                       *BatchedCases
+  )
+/*++
+
+Routine Description:
+
+  Get the number of the selected test cases without reset, and how many of
+  them run before the first system reset. BaselineCases is the number in the
+  selected order, BatchedCases is the number in the execution order.
+
+Arguments:
+
+  Cases         - Number of the selected test cases without reset.
+  BaselineCases - Number of them before the first reset in the selected order.
+  BatchedCases  - Number of them before the first reset in the execution order.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+
+--*/
+{
+  EFI_STATUS          Status;
+  UINT32              MinResetOrder;
+  BOOLEAN             ResetBatched;
+  SCT_LIST_ENTRY      *Link;
+  EFI_SCT_TEST_CASE   *TestCase;
+  EFI_TEST_ATTRIBUTE  CaseAttribute;
+
+  //
+  // Check parameters
+  //
+  if ((Cases == NULL) || (BaselineCases == NULL) || (BatchedCases == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Find the smallest order of the test cases with reset
+  //
+  MinResetOrder = EFI_SCT_TEST_CASE_INVALID;
+  ResetBatched  = FALSE;
+
+  for (Link = gFT->TestCaseList.ForwardLink; Link != &gFT->TestCaseList; Link = Link->ForwardLink) {
+    TestCase = CR (Link, EFI_SCT_TEST_CASE, Link, EFI_SCT_TEST_CASE_SIGNATURE);
+
+    if (TestCase->Order == EFI_SCT_TEST_CASE_INVALID) {
+      continue;
+    }
+
+    if (TestCase->ResetBatched) {
+      ResetBatched = TRUE;
+    }
+
+    Status = GetTestCaseAttribute (&TestCase->Guid, &CaseAttribute);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    if (((CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) != 0) &&
+        (MinResetOrder > TestCase->Order)) {
+      MinResetOrder = TestCase->Order;
+    }
+  }
+
+  //
+  // Count the test cases without reset, and the ones before it
+  //
+  *Cases         = 0;
+  *BaselineCases = 0;
+
+  for (Link = gFT->TestCaseList.ForwardLink; Link != &gFT->TestCaseList; Link = Link->ForwardLink) {
+    TestCase = CR (Link, EFI_SCT_TEST_CASE, Link, EFI_SCT_TEST_CASE_SIGNATURE);
+
+    if (TestCase->Order == EFI_SCT_TEST_CASE_INVALID) {
+      continue;
+    }
+
+    Status = GetTestCaseAttribute (&TestCase->Guid, &CaseAttribute);
+    if (EFI_ERROR (Status) || ((CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) != 0)) {
+      continue;
+    }
+
+    (*Cases) ++;
+    if (TestCase->Order < MinResetOrder) {
+      (*BaselineCases) ++;
+    }
+  }
+
+  //
+  // All of them run before the first reset if the reset test cases are batched
+  //
+  *BatchedCases = ResetBatched ? *Cases : *BaselineCases;
+
+  return EFI_SUCCESS;
+}
+
+
 //
 // Internal functions implementation
 //
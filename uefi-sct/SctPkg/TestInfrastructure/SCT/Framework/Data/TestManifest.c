@@ -0,0 +1,1819 @@
+/** @file
+
+  Copyright 2006 - 2016 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2016, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  TestManifest.c
+
+Abstract:
+
+  This file provides the services to manage the test manifest.
+
+  The test manifest records the test interface and the test entries exported
+  by each test image file, keyed by the file name, size and modification time.
+  When a test image file matches its record, the framework builds a shadow test
+  protocol from the manifest instead of loading the image. The image itself is
+  only loaded when one of its test entries is executed.
+
+--*/
+
+#include "Sct.h"
+
+//
+// Internal definitions
+//
+
+#define EFI_SCT_SECTION_TEST_MANIFEST     L"Test File"
+
+#define EFI_SCT_MANIFEST_FILE_SIGNATURE   EFI_SIGNATURE_32('s','t','m','f')
+
+//
+// The TPL INI file limits the length of a line, keep room for the key
+//
+#define EFI_SCT_MANIFEST_MAX_VALUE_LEN    (EFI_SCT_MAX_BUFFER_SIZE - 32)
+#define EFI_SCT_MANIFEST_TIME_LEN         20
+
+typedef struct {
+  UINT32                    Signature;
+  SCT_LIST_ENTRY            Link;
+
+  CHAR16                    *FileName;
+  UINT64                    FileSize;
+  CHAR16                    FileTime[EFI_SCT_MANIFEST_TIME_LEN];
+
+  EFI_SCT_TEST_FILE_TYPE    Type;
+  VOID                      *Context;
+  BOOLEAN                   Used;
+} EFI_SCT_MANIFEST_FILE;
+
+//
+// Internal variables
+//
+
+SCT_LIST_ENTRY  mManifestFileList;
+BOOLEAN         mManifestLoaded = FALSE;
+BOOLEAN         mManifestDirty  = FALSE;
+UINTN           mManifestHits   = 0;
+UINTN           mManifestMisses = 0;
+
+//
+// Internal functions declaration
+//
+
+EFI_STATUS
+LoadSingleManifestFile (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  OUT EFI_SCT_MANIFEST_FILE       **ManifestFile
+  );
+
+EFI_STATUS
+SaveSingleManifestFile (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN EFI_SCT_MANIFEST_FILE        *ManifestFile,
+  IN EFI_SCT_TEST_FILE            *TestFile
+  );
+
+EFI_STATUS
+CreateSingleManifestFile (
+  IN CHAR16                       *FileName,
+  IN EFI_FILE_INFO                *FileInfo,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  OUT EFI_SCT_MANIFEST_FILE       **ManifestFile
+  );
+
+EFI_STATUS
+FreeSingleManifestFile (
+  IN EFI_SCT_MANIFEST_FILE        *ManifestFile
+  );
+
+EFI_STATUS
+LoadManifestContext (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  OUT VOID                        **Context
+  );
+
+EFI_STATUS
+LoadManifestEntry (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN UINTN                        Index,
+  OUT EFI_GUID                    *EntryId,
+  OUT CHAR16                      **Name,
+  OUT CHAR16                      **Description,
+  OUT EFI_TEST_LEVEL              *TestLevel,
+  OUT EFI_GUID                    **SupportProtocols,
+  OUT EFI_TEST_ATTRIBUTE          *CaseAttribute
+  );
+
+EFI_STATUS
+SaveManifestInterface (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN UINT64                       TestRevision,
+  IN EFI_GUID                     *CategoryGuid,
+  IN CHAR16                       *Name,
+  IN CHAR16                       *Description
+  );
+
+EFI_STATUS
+SaveManifestEntry (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN UINTN                        Index,
+  IN EFI_GUID                     *EntryId,
+  IN CHAR16                       *Name,
+  IN CHAR16                       *Description,
+  IN EFI_TEST_LEVEL               TestLevel,
+  IN EFI_GUID                     *SupportProtocols,
+  IN EFI_TEST_ATTRIBUTE           CaseAttribute
+  );
+
+BOOLEAN
+ManifestContextFits (
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context
+  );
+
+BOOLEAN
+ManifestStringFits (
+  IN CHAR16                       *String
+  );
+
+BOOLEAN
+ManifestGuidArrayFits (
+  IN EFI_GUID                     *GuidArray
+  );
+
+VOID
+ManifestTimeToStr (
+  IN EFI_TIME                     *Time,
+  OUT CHAR16                      *Buffer
+  );
+
+EFI_SCT_MANIFEST_FILE *
+FindManifestFileByName (
+  IN CHAR16                       *FileName
+  );
+
+EFI_STATUS
+ManifestGetString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  OUT CHAR16                      *Buffer
+  );
+
+EFI_STATUS
+ManifestSetString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  IN CHAR16                       *Buffer
+  );
+
+EFI_STATUS
+ManifestGetEntryString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  IN UINTN                        Index,
+  OUT CHAR16                      *Buffer
+  );
+
+EFI_STATUS
+ManifestSetEntryString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  IN UINTN                        Index,
+  IN CHAR16                       *Buffer
+  );
+
+
+//
+// External functions implementation
+//
+
+EFI_STATUS
+LoadTestManifest (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName
+  )
+/*++
+
+Routine Description:
+
+  Load the test manifest from a file. A missing file is not an error, it only
+  means all test image files have to be loaded this time.
+
+Arguments:
+
+  DevicePath    - Device path of the file.
+  FileName      - Name of the file.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS              Status;
+  EFI_INI_FILE_HANDLE     IniFile;
+  UINT32                  Index;
+  UINT32                  NumberOfFiles;
+  EFI_SCT_MANIFEST_FILE   *ManifestFile;
+
+  //
+  // Check parameters
+  //
+  if ((DevicePath == NULL) || (FileName == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Debug information
+  //
+  EFI_SCT_DEBUG ((EFI_SCT_D_TRACE, L"Load test manifest from <%s>", FileName));
+
+  //
+  // Start from an empty manifest
+  //
+  if (mManifestLoaded) {
+    FreeTestManifest ();
+  }
+
+  SctInitializeListHead (&mManifestFileList);
+  mManifestLoaded = TRUE;
+  mManifestDirty  = FALSE;
+  mManifestHits   = 0;
+  mManifestMisses = 0;
+
+  //
+  // Open the file
+  //
+  Status = gFT->TplProtocol->EfiIniOpen (
+                               gFT->TplProtocol,
+                               DevicePath,
+                               FileName,
+                               &IniFile
+                               );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Open test manifest - %r", Status));
+    mManifestDirty = TRUE;
+    return (Status == EFI_NOT_FOUND) ? EFI_SUCCESS : Status;
+  }
+
+  //
+  // Get the number of test file records
+  //
+  Status = IniFile->GetOrderNum (
+                      IniFile,
+                      EFI_SCT_SECTION_TEST_MANIFEST,
+                      &NumberOfFiles
+                      );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Get order number - %r", Status));
+    gFT->TplProtocol->EfiIniClose (gFT->TplProtocol, IniFile);
+    mManifestDirty = TRUE;
+    return Status;
+  }
+
+  //
+  // Walk through all test file records
+  //
+  for (Index = 0; Index < NumberOfFiles; Index ++) {
+    Status = LoadSingleManifestFile (
+               IniFile,
+               Index,
+               &ManifestFile
+               );
+    if (EFI_ERROR (Status)) {
+      //
+      // Drop the broken record, it will be rebuilt from the image
+      //
+      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Load test manifest (#%d) - %r", Index, Status));
+      mManifestDirty = TRUE;
+      continue;
+    }
+
+    SctInsertTailList (&mManifestFileList, &ManifestFile->Link);
+  }
+
+  //
+  // Close the file
+  //
+  gFT->TplProtocol->EfiIniClose (
+                      gFT->TplProtocol,
+                      IniFile
+                      );
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+SaveTestManifest (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  IN SCT_LIST_ENTRY               *TestFileList
+  )
+/*++
+
+Routine Description:
+
+  Save the test manifest into a file. The file is only rewritten when a test
+  image file was added, changed, or removed since the last save.
+
+Arguments:
+
+  DevicePath    - Device path of the file.
+  FileName      - Name of the file.
+  TestFileList  - Pointer to the loaded test file list.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS              Status;
+  EFI_INI_FILE_HANDLE     IniFile;
+  UINT32                  Index;
+  SCT_LIST_ENTRY          *Link;
+  EFI_SCT_TEST_FILE       *TestFile;
+  EFI_SCT_MANIFEST_FILE   *ManifestFile;
+
+  //
+  // Check parameters
+  //
+  if ((DevicePath == NULL) || (FileName == NULL) || (TestFileList == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mManifestLoaded) {
+    return EFI_NOT_READY;
+  }
+
+  //
+  // Debug information
+  //
+  EFI_SCT_DEBUG ((
+    EFI_SCT_D_TRACE,
+    L"Test manifest: %d hits, %d misses",
+    mManifestHits,
+    mManifestMisses
+    ));
+
+  //
+  // A record without a test file means the file was changed or removed
+  //
+  for (Link = mManifestFileList.ForwardLink; Link != &mManifestFileList; Link = Link->ForwardLink) {
+    ManifestFile = CR (Link, EFI_SCT_MANIFEST_FILE, Link, EFI_SCT_MANIFEST_FILE_SIGNATURE);
+    if (!ManifestFile->Used) {
+      mManifestDirty = TRUE;
+      break;
+    }
+  }
+
+  if (!mManifestDirty) {
+    return EFI_SUCCESS;
+  }
+
+  EFI_SCT_DEBUG ((EFI_SCT_D_TRACE, L"Save test manifest into <%s>", FileName));
+
+  //
+  // Open the file
+  //
+  Status = gFT->TplProtocol->EfiIniOpen (
+                               gFT->TplProtocol,
+                               DevicePath,
+                               FileName,
+                               &IniFile
+                               );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Open test manifest - %r", Status));
+    return Status;
+  }
+
+  //
+  // Not exist, create the file
+  //
+  if (Status == EFI_NOT_FOUND) {
+    Status = gFT->TplProtocol->EfiIniCreate (
+                                 gFT->TplProtocol,
+                                 DevicePath,
+                                 FileName,
+                                 &IniFile
+                                 );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create test manifest - %r", Status));
+      return Status;
+    }
+  }
+
+  //
+  // Remove the original test file records
+  //
+  Status = IniFile->RmSection (
+                      IniFile,
+                      EFI_SCT_SECTION_TEST_MANIFEST
+                      );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Remove section - %r", Status));
+    gFT->TplProtocol->EfiIniClose (gFT->TplProtocol, IniFile);
+    return Status;
+  }
+
+  //
+  // Walk through all test files which have a record
+  //
+  Index = 0;
+
+  for (Link = TestFileList->ForwardLink; Link != TestFileList; Link = Link->ForwardLink) {
+    TestFile = CR (Link, EFI_SCT_TEST_FILE, Link, EFI_SCT_TEST_FILE_SIGNATURE);
+
+    ManifestFile = FindManifestFileByName (TestFile->FileName);
+    if ((ManifestFile == NULL) || !ManifestFile->Used ||
+        (ManifestFile->Type != TestFile->Type)) {
+      continue;
+    }
+
+    Status = SaveSingleManifestFile (
+               IniFile,
+               Index,
+               ManifestFile,
+               TestFile
+               );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Save test manifest (#%d) - %r", Index, Status));
+      continue;
+    }
+
+    Index ++;
+  }
+
+  //
+  // Close the file
+  //
+  gFT->TplProtocol->EfiIniClose (
+                      gFT->TplProtocol,
+                      IniFile
+                      );
+
+  mManifestDirty = FALSE;
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+FreeTestManifest (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Free the test manifest, including the shadow test protocols which are not
+  claimed by a test file.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+
+--*/
+{
+  EFI_SCT_MANIFEST_FILE   *ManifestFile;
+
+  if (!mManifestLoaded) {
+    return EFI_SUCCESS;
+  }
+
+  while (!SctIsListEmpty (&mManifestFileList)) {
+    ManifestFile = CR (mManifestFileList.ForwardLink, EFI_SCT_MANIFEST_FILE, Link, EFI_SCT_MANIFEST_FILE_SIGNATURE);
+
+    SctRemoveEntryList (&ManifestFile->Link);
+    FreeSingleManifestFile (ManifestFile);
+  }
+
+  mManifestLoaded = FALSE;
+  mManifestDirty  = FALSE;
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+FindTestManifest (
+  IN CHAR16                       *FileName,
+  IN EFI_FILE_INFO                *FileInfo,
+  OUT EFI_SCT_TEST_FILE_TYPE      *Type,
+  OUT VOID                        **Context
+  )
+/*++
+
+Routine Description:
+
+  Find the record of a test image file. The record only matches when the size
+  and the modification time of the file are unchanged.
+
+Arguments:
+
+  FileName      - Name of the test image file.
+  FileInfo      - File information of the test image file.
+  Type          - Type of the test file.
+  Context       - Shadow test protocol of the test file. The caller owns it
+                  and frees it with FreeTestManifestContext().
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  EFI_NOT_FOUND - Not found or out of date.
+
+--*/
+{
+  EFI_SCT_MANIFEST_FILE   *ManifestFile;
+  CHAR16                  FileTime[EFI_SCT_MANIFEST_TIME_LEN];
+
+  //
+  // Check parameters
+  //
+  if ((FileName == NULL) || (FileInfo == NULL) ||
+      (Type     == NULL) || (Context  == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mManifestLoaded) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Find and validate the record
+  //
+  ManifestFile = FindManifestFileByName (FileName);
+  if ((ManifestFile == NULL) || ManifestFile->Used) {
+    mManifestMisses ++;
+    return EFI_NOT_FOUND;
+  }
+
+  ManifestTimeToStr (&FileInfo->ModificationTime, FileTime);
+
+  if ((ManifestFile->FileSize != FileInfo->FileSize) ||
+      (SctStrCmp (ManifestFile->FileTime, FileTime) != 0)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Test manifest out of date <%s>", FileName));
+    mManifestMisses ++;
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Hand over the shadow test protocol
+  //
+  *Type    = ManifestFile->Type;
+  *Context = ManifestFile->Context;
+
+  ManifestFile->Context = NULL;
+  ManifestFile->Used    = TRUE;
+
+  mManifestHits ++;
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+AddTestManifest (
+  IN CHAR16                       *FileName,
+  IN EFI_FILE_INFO                *FileInfo,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context
+  )
+/*++
+
+Routine Description:
+
+  Add the record of a test image file which has just been loaded.
+
+Arguments:
+
+  FileName      - Name of the test image file.
+  FileInfo      - File information of the test image file.
+  Type          - Type of the test file.
+  Context       - Test protocol of the test file.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  EFI_UNSUPPORTED - The test file cannot be described by the manifest.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS              Status;
+  EFI_SCT_MANIFEST_FILE   *ManifestFile;
+
+  //
+  // Check parameters
+  //
+  if ((FileName == NULL) || (FileInfo == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mManifestLoaded) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Check the test protocol could be saved completely
+  //
+  if (!ManifestContextFits (Type, Context)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Test manifest skips <%s>", FileName));
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Replace the out-of-date record of the same file
+  //
+  ManifestFile = FindManifestFileByName (FileName);
+  if (ManifestFile != NULL) {
+    SctRemoveEntryList (&ManifestFile->Link);
+    FreeSingleManifestFile (ManifestFile);
+  }
+
+  Status = CreateSingleManifestFile (
+             FileName,
+             FileInfo,
+             Type,
+             &ManifestFile
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test manifest - %r", Status));
+    return Status;
+  }
+
+  ManifestFile->Used = TRUE;
+  SctInsertTailList (&mManifestFileList, &ManifestFile->Link);
+
+  mManifestDirty = TRUE;
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+FreeTestManifestContext (
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context
+  )
+/*++
+
+Routine Description:
+
+  Free a shadow test protocol built from the test manifest.
+
+Arguments:
+
+  Type          - Type of the test file.
+  Context       - Shadow test protocol of the test file.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_BB_TEST_PROTOCOL    *BbTest;
+  EFI_BB_TEST_ENTRY       *BbEntry;
+  EFI_WB_TEST_PROTOCOL    *WbTest;
+  EFI_WB_TEST_ENTRY       *WbEntry;
+
+  //
+  // Check parameters
+  //
+  if (Context == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  switch (Type) {
+  case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
+  case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
+    //
+    // Black-box test file
+    //
+    BbTest = (EFI_BB_TEST_PROTOCOL *) Context;
+
+    while (BbTest->EntryList != NULL) {
+      BbEntry           = BbTest->EntryList;
+      BbTest->EntryList = BbEntry->Next;
+
+      if (BbEntry->Name != NULL) {
+        tBS->FreePool (BbEntry->Name);
+      }
+      if (BbEntry->Description != NULL) {
+        tBS->FreePool (BbEntry->Description);
+      }
+      if (BbEntry->SupportProtocols != NULL) {
+        tBS->FreePool (BbEntry->SupportProtocols);
+      }
+      tBS->FreePool (BbEntry);
+    }
+
+    if (BbTest->Name != NULL) {
+      tBS->FreePool (BbTest->Name);
+    }
+    if (BbTest->Description != NULL) {
+      tBS->FreePool (BbTest->Description);
+    }
+    tBS->FreePool (BbTest);
+    break;
+
+  case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
+    //
+    // White-box test file
+    //
+    WbTest = (EFI_WB_TEST_PROTOCOL *) Context;
+
+    while (WbTest->EntryList != NULL) {
+      WbEntry           = WbTest->EntryList;
+      WbTest->EntryList = WbEntry->Next;
+
+      if (WbEntry->Name != NULL) {
+        tBS->FreePool (WbEntry->Name);
+      }
+      if (WbEntry->Description != NULL) {
+        tBS->FreePool (WbEntry->Description);
+      }
+      if (WbEntry->SupportProtocols != NULL) {
+        tBS->FreePool (WbEntry->SupportProtocols);
+      }
+      tBS->FreePool (WbEntry);
+    }
+
+    if (WbTest->Name != NULL) {
+      tBS->FreePool (WbTest->Name);
+    }
+    if (WbTest->Description != NULL) {
+      tBS->FreePool (WbTest->Description);
+    }
+    tBS->FreePool (WbTest);
+    break;
+
+  default:
+    //
+    // Unsupported file
+    //
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Unsupported file"));
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+//
+// Internal functions implementation
+//
+
+EFI_STATUS
+LoadSingleManifestFile (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  OUT EFI_SCT_MANIFEST_FILE       **ManifestFile
+  )
+/*++
+
+Routine Description:
+
+  Load a single test file record.
+
+--*/
+{
+  EFI_STATUS              Status;
+  CHAR16                  Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+  UINTN                   Value;
+  EFI_SCT_MANIFEST_FILE   *TempManifestFile;
+
+  //
+  // Allocate memory for the record
+  //
+  Status = tBS->AllocatePool (
+                 EfiBootServicesData,
+                 sizeof(EFI_SCT_MANIFEST_FILE),
+                 (VOID **)&TempManifestFile
+                 );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+    return Status;
+  }
+
+  SctZeroMem (TempManifestFile, sizeof(EFI_SCT_MANIFEST_FILE));
+  TempManifestFile->Signature = EFI_SCT_MANIFEST_FILE_SIGNATURE;
+
+  //
+  // Load the file name
+  //
+  Status = ManifestGetString (IniFile, Order, L"FileName", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without file name"));
+    FreeSingleManifestFile (TempManifestFile);
+    return Status;
+  }
+
+  TempManifestFile->FileName = SctStrDuplicate (Buffer);
+  if (TempManifestFile->FileName == NULL) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Out of resources"));
+    FreeSingleManifestFile (TempManifestFile);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Load the file size
+  //
+  Status = ManifestGetString (IniFile, Order, L"FileSize", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without file size"));
+    FreeSingleManifestFile (TempManifestFile);
+    return Status;
+  }
+
+  SctHexStrToInt (Buffer, &Value);
+  TempManifestFile->FileSize = (UINT64) Value;
+
+  //
+  // Load the file time
+  //
+  Status = ManifestGetString (IniFile, Order, L"FileTime", Buffer);
+  if (EFI_ERROR (Status) || (SctStrLen (Buffer) >= EFI_SCT_MANIFEST_TIME_LEN)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without file time"));
+    FreeSingleManifestFile (TempManifestFile);
+    return EFI_NOT_FOUND;
+  }
+
+  SctStrCpy (TempManifestFile->FileTime, Buffer);
+
+  //
+  // Load the test file type
+  //
+  Status = ManifestGetString (IniFile, Order, L"Type", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without type"));
+    FreeSingleManifestFile (TempManifestFile);
+    return Status;
+  }
+
+  SctHexStrToInt (Buffer, &Value);
+  TempManifestFile->Type = (EFI_SCT_TEST_FILE_TYPE) Value;
+
+  //
+  // Load the shadow test protocol
+  //
+  switch (TempManifestFile->Type) {
+  case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
+  case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
+  case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
+    Status = LoadManifestContext (
+               IniFile,
+               Order,
+               TempManifestFile->Type,
+               &TempManifestFile->Context
+               );
+    if (EFI_ERROR (Status)) {
+      FreeSingleManifestFile (TempManifestFile);
+      return Status;
+    }
+    break;
+
+  case EFI_SCT_TEST_FILE_TYPE_APPLICATION:
+    //
+    // The application test is described by its own INI file
+    //
+    break;
+
+  default:
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Invalid type"));
+    FreeSingleManifestFile (TempManifestFile);
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Done
+  //
+  *ManifestFile = TempManifestFile;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+SaveSingleManifestFile (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN EFI_SCT_MANIFEST_FILE        *ManifestFile,
+  IN EFI_SCT_TEST_FILE            *TestFile
+  )
+/*++
+
+Routine Description:
+
+  Save a single test file record.
+
+--*/
+{
+  EFI_STATUS              Status;
+  CHAR16                  Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+  UINTN                   Index;
+  EFI_BB_TEST_PROTOCOL    *BbTest;
+  EFI_BB_TEST_ENTRY       *BbEntry;
+  EFI_WB_TEST_PROTOCOL    *WbTest;
+  EFI_WB_TEST_ENTRY       *WbEntry;
+
+  //
+  // Save the file name, size, time and type
+  //
+  Status = ManifestSetString (IniFile, Order, L"FileName", ManifestFile->FileName);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SctIntToHexStr ((UINTN) ManifestFile->FileSize, Buffer);
+  ManifestSetString (IniFile, Order, L"FileSize", Buffer);
+
+  ManifestSetString (IniFile, Order, L"FileTime", ManifestFile->FileTime);
+
+  SctIntToHexStr ((UINTN) ManifestFile->Type, Buffer);
+  ManifestSetString (IniFile, Order, L"Type", Buffer);
+
+  //
+  // Save the test interface and the test entries
+  //
+  Index = 0;
+
+  switch (TestFile->Type) {
+  case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
+  case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
+    //
+    // Black-box test file
+    //
+    BbTest = (EFI_BB_TEST_PROTOCOL *) TestFile->Context;
+
+    SaveManifestInterface (
+      IniFile,
+      Order,
+      BbTest->TestRevision,
+      &BbTest->CategoryGuid,
+      BbTest->Name,
+      BbTest->Description
+      );
+
+    for (BbEntry = BbTest->EntryList; BbEntry != NULL; BbEntry = BbEntry->Next) {
+      SaveManifestEntry (
+        IniFile,
+        Order,
+        Index,
+        &BbEntry->EntryId,
+        BbEntry->Name,
+        BbEntry->Description,
+        BbEntry->TestLevelSupportMap,
+        BbEntry->SupportProtocols,
+        BbEntry->CaseAttribute
+        );
+      Index ++;
+    }
+    break;
+
+  case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
+    //
+    // White-box test file
+    //
+    WbTest = (EFI_WB_TEST_PROTOCOL *) TestFile->Context;
+
+    SaveManifestInterface (
+      IniFile,
+      Order,
+      WbTest->TestRevision,
+      &WbTest->CategoryGuid,
+      WbTest->Name,
+      WbTest->Description
+      );
+
+    for (WbEntry = WbTest->EntryList; WbEntry != NULL; WbEntry = WbEntry->Next) {
+      SaveManifestEntry (
+        IniFile,
+        Order,
+        Index,
+        &WbEntry->EntryId,
+        WbEntry->Name,
+        WbEntry->Description,
+        WbEntry->TestLevelSupportMap,
+        WbEntry->SupportProtocols,
+        WbEntry->CaseAttribute
+        );
+      Index ++;
+    }
+    break;
+
+  default:
+    //
+    // Only the type is recorded for the application test
+    //
+    return EFI_SUCCESS;
+  }
+
+  SctIntToHexStr (Index, Buffer);
+  ManifestSetString (IniFile, Order, L"EntryNum", Buffer);
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+CreateSingleManifestFile (
+  IN CHAR16                       *FileName,
+  IN EFI_FILE_INFO                *FileInfo,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  OUT EFI_SCT_MANIFEST_FILE       **ManifestFile
+  )
+/*++
+
+Routine Description:
+
+  Create a single test file record.
+
+--*/
+{
+  EFI_STATUS              Status;
+  EFI_SCT_MANIFEST_FILE   *TempManifestFile;
+
+  Status = tBS->AllocatePool (
+                 EfiBootServicesData,
+                 sizeof(EFI_SCT_MANIFEST_FILE),
+                 (VOID **)&TempManifestFile
+                 );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+    return Status;
+  }
+
+  SctZeroMem (TempManifestFile, sizeof(EFI_SCT_MANIFEST_FILE));
+
+  TempManifestFile->Signature = EFI_SCT_MANIFEST_FILE_SIGNATURE;
+  TempManifestFile->FileName  = SctStrDuplicate (FileName);
+  TempManifestFile->FileSize  = FileInfo->FileSize;
+  TempManifestFile->Type      = Type;
+
+  if (TempManifestFile->FileName == NULL) {
+    tBS->FreePool (TempManifestFile);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ManifestTimeToStr (&FileInfo->ModificationTime, TempManifestFile->FileTime);
+
+  //
+  // Done
+  //
+  *ManifestFile = TempManifestFile;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+FreeSingleManifestFile (
+  IN EFI_SCT_MANIFEST_FILE        *ManifestFile
+  )
+/*++
+
+Routine Description:
+
+  Free a single test file record.
+
+--*/
+{
+  if (ManifestFile->Context != NULL) {
+    FreeTestManifestContext (ManifestFile->Type, ManifestFile->Context);
+    ManifestFile->Context = NULL;
+  }
+
+  if (ManifestFile->FileName != NULL) {
+    tBS->FreePool (ManifestFile->FileName);
+    ManifestFile->FileName = NULL;
+  }
+
+  tBS->FreePool (ManifestFile);
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+LoadManifestContext (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  OUT VOID                        **Context
+  )
+/*++
+
+Routine Description:
+
+  Build a shadow test protocol from a test file record. The entry points are
+  left NULL, the image has to be loaded before any entry is executed.
+
+--*/
+{
+  EFI_STATUS              Status;
+  CHAR16                  Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+  UINTN                   Index;
+  UINTN                   NumberOfEntries;
+  UINTN                   Revision;
+  EFI_BB_TEST_PROTOCOL    *BbTest;
+  EFI_BB_TEST_ENTRY       *BbEntry;
+  EFI_BB_TEST_ENTRY       **BbLast;
+  EFI_WB_TEST_PROTOCOL    *WbTest;
+  EFI_WB_TEST_ENTRY       *WbEntry;
+  EFI_WB_TEST_ENTRY       **WbLast;
+  VOID                    *TempContext;
+  EFI_GUID                EntryId;
+  CHAR16                  *Name;
+  CHAR16                  *Description;
+  EFI_TEST_LEVEL          TestLevel;
+  EFI_GUID                *SupportProtocols;
+  EFI_TEST_ATTRIBUTE      CaseAttribute;
+
+  //
+  // Allocate the test protocol, black-box and white-box share the layout of
+  // the leading fields but not of the names
+  //
+  Status = tBS->AllocatePool (
+                 EfiBootServicesData,
+                 (Type == EFI_SCT_TEST_FILE_TYPE_WHITE_BOX) ?
+                   sizeof(EFI_WB_TEST_PROTOCOL) : sizeof(EFI_BB_TEST_PROTOCOL),
+                 &TempContext
+                 );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+    return Status;
+  }
+
+  BbTest = (EFI_BB_TEST_PROTOCOL *) TempContext;
+  WbTest = (EFI_WB_TEST_PROTOCOL *) TempContext;
+
+  if (Type == EFI_SCT_TEST_FILE_TYPE_WHITE_BOX) {
+    SctZeroMem (WbTest, sizeof(EFI_WB_TEST_PROTOCOL));
+  } else {
+    SctZeroMem (BbTest, sizeof(EFI_BB_TEST_PROTOCOL));
+  }
+
+  BbLast = &BbTest->EntryList;
+  WbLast = &WbTest->EntryList;
+
+  //
+  // Load the test interface
+  //
+  Status = ManifestGetString (IniFile, Order, L"TestRevision", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without test revision"));
+    FreeTestManifestContext (Type, TempContext);
+    return Status;
+  }
+
+  SctHexStrToInt (Buffer, &Revision);
+
+  Status = ManifestGetString (IniFile, Order, L"CategoryGuid", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without category GUID"));
+    FreeTestManifestContext (Type, TempContext);
+    return Status;
+  }
+
+  if (Type == EFI_SCT_TEST_FILE_TYPE_WHITE_BOX) {
+    WbTest->TestRevision = (UINT64) Revision;
+    Status = SctStrToGuid (Buffer, &WbTest->CategoryGuid);
+  } else {
+    BbTest->TestRevision = (UINT64) Revision;
+    Status = SctStrToGuid (Buffer, &BbTest->CategoryGuid);
+  }
+
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Invalid category GUID"));
+    FreeTestManifestContext (Type, TempContext);
+    return Status;
+  }
+
+  Status = ManifestGetString (IniFile, Order, L"Name", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without name"));
+    FreeTestManifestContext (Type, TempContext);
+    return Status;
+  }
+
+  Name = SctStrDuplicate (Buffer);
+
+  Status = ManifestGetString (IniFile, Order, L"Description", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without description"));
+    if (Name != NULL) {
+      tBS->FreePool (Name);
+    }
+    FreeTestManifestContext (Type, TempContext);
+    return Status;
+  }
+
+  Description = SctStrDuplicate (Buffer);
+
+  if (Type == EFI_SCT_TEST_FILE_TYPE_WHITE_BOX) {
+    WbTest->Name        = Name;
+    WbTest->Description = Description;
+  } else {
+    BbTest->Name        = Name;
+    BbTest->Description = Description;
+  }
+
+  if ((Name == NULL) || (Description == NULL)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Out of resources"));
+    FreeTestManifestContext (Type, TempContext);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Load the test entries
+  //
+  Status = ManifestGetString (IniFile, Order, L"EntryNum", Buffer);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Without entry number"));
+    FreeTestManifestContext (Type, TempContext);
+    return Status;
+  }
+
+  SctHexStrToInt (Buffer, &NumberOfEntries);
+
+  for (Index = 0; Index < NumberOfEntries; Index ++) {
+    Status = LoadManifestEntry (
+               IniFile,
+               Order,
+               Index,
+               &EntryId,
+               &Name,
+               &Description,
+               &TestLevel,
+               &SupportProtocols,
+               &CaseAttribute
+               );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Load test entry (#%d) - %r", Index, Status));
+      FreeTestManifestContext (Type, TempContext);
+      return Status;
+    }
+
+    //
+    // Append the entry, a partial list is released as a whole on failure
+    //
+    if (Type == EFI_SCT_TEST_FILE_TYPE_WHITE_BOX) {
+      Status = tBS->AllocatePool (
+                     EfiBootServicesData,
+                     sizeof(EFI_WB_TEST_ENTRY),
+                     (VOID **)&WbEntry
+                     );
+      if (!EFI_ERROR (Status)) {
+        SctZeroMem (WbEntry, sizeof(EFI_WB_TEST_ENTRY));
+        SctCopyMem (&WbEntry->EntryId, &EntryId, sizeof(EFI_GUID));
+        WbEntry->Name                = Name;
+        WbEntry->Description         = Description;
+        WbEntry->TestLevelSupportMap = TestLevel;
+        WbEntry->SupportProtocols    = SupportProtocols;
+        WbEntry->CaseAttribute       = CaseAttribute;
+
+        *WbLast = WbEntry;
+        WbLast  = &WbEntry->Next;
+      }
+    } else {
+      Status = tBS->AllocatePool (
+                     EfiBootServicesData,
+                     sizeof(EFI_BB_TEST_ENTRY),
+                     (VOID **)&BbEntry
+                     );
+      if (!EFI_ERROR (Status)) {
+        SctZeroMem (BbEntry, sizeof(EFI_BB_TEST_ENTRY));
+        SctCopyMem (&BbEntry->EntryId, &EntryId, sizeof(EFI_GUID));
+        BbEntry->Name                = Name;
+        BbEntry->Description         = Description;
+        BbEntry->TestLevelSupportMap = TestLevel;
+        BbEntry->SupportProtocols    = SupportProtocols;
+        BbEntry->CaseAttribute       = CaseAttribute;
+
+        *BbLast = BbEntry;
+        BbLast  = &BbEntry->Next;
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+      tBS->FreePool (Name);
+      tBS->FreePool (Description);
+      if (SupportProtocols != NULL) {
+        tBS->FreePool (SupportProtocols);
+      }
+      FreeTestManifestContext (Type, TempContext);
+      return Status;
+    }
+  }
+
+  //
+  // Done
+  //
+  *Context = TempContext;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+LoadManifestEntry (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN UINTN                        Index,
+  OUT EFI_GUID                    *EntryId,
+  OUT CHAR16                      **Name,
+  OUT CHAR16                      **Description,
+  OUT EFI_TEST_LEVEL              *TestLevel,
+  OUT EFI_GUID                    **SupportProtocols,
+  OUT EFI_TEST_ATTRIBUTE          *CaseAttribute
+  )
+/*++
+
+Routine Description:
+
+  Load a single test entry from a test file record.
+
+--*/
+{
+  EFI_STATUS  Status;
+  CHAR16      Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+  UINTN       Value;
+
+  *Name             = NULL;
+  *Description      = NULL;
+  *SupportProtocols = NULL;
+
+  //
+  // Load the entry ID
+  //
+  Status = ManifestGetEntryString (IniFile, Order, L"EntryId", Index, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = SctStrToGuid (Buffer, EntryId);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Load the test level and the case attribute
+  //
+  Status = ManifestGetEntryString (IniFile, Order, L"TestLevel", Index, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SctHexStrToInt (Buffer, &Value);
+  *TestLevel = (EFI_TEST_LEVEL) Value;
+
+  Status = ManifestGetEntryString (IniFile, Order, L"CaseAttribute", Index, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SctHexStrToInt (Buffer, &Value);
+  *CaseAttribute = (EFI_TEST_ATTRIBUTE) Value;
+
+  //
+  // Load the support protocols, an empty string stands for no array
+  //
+  Status = ManifestGetEntryString (IniFile, Order, L"SupportProtocols", Index, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Buffer[0] != L'\0') {
+    Status = SctStrToGuidArray (Buffer, SupportProtocols);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Load the name and the description
+  //
+  Status = ManifestGetEntryString (IniFile, Order, L"Name", Index, Buffer);
+  if (!EFI_ERROR (Status)) {
+    *Name = SctStrDuplicate (Buffer);
+
+    Status = ManifestGetEntryString (IniFile, Order, L"Description", Index, Buffer);
+    if (!EFI_ERROR (Status)) {
+      *Description = SctStrDuplicate (Buffer);
+    }
+  }
+
+  if (EFI_ERROR (Status) || (*Name == NULL) || (*Description == NULL)) {
+    if (*Name != NULL) {
+      tBS->FreePool (*Name);
+    }
+    if (*Description != NULL) {
+      tBS->FreePool (*Description);
+    }
+    if (*SupportProtocols != NULL) {
+      tBS->FreePool (*SupportProtocols);
+    }
+    return EFI_ERROR (Status) ? Status : EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+SaveManifestInterface (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN UINT64                       TestRevision,
+  IN EFI_GUID                     *CategoryGuid,
+  IN CHAR16                       *Name,
+  IN CHAR16                       *Description
+  )
+/*++
+
+Routine Description:
+
+  Save the test interface into a test file record.
+
+--*/
+{
+  CHAR16  Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+
+  SctIntToHexStr ((UINTN) TestRevision, Buffer);
+  ManifestSetString (IniFile, Order, L"TestRevision", Buffer);
+
+  SctGuidToStr (CategoryGuid, Buffer);
+  ManifestSetString (IniFile, Order, L"CategoryGuid", Buffer);
+
+  ManifestSetString (IniFile, Order, L"Name",        (Name        != NULL) ? Name        : L"");
+  ManifestSetString (IniFile, Order, L"Description", (Description != NULL) ? Description : L"");
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+SaveManifestEntry (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN UINTN                        Index,
+  IN EFI_GUID                     *EntryId,
+  IN CHAR16                       *Name,
+  IN CHAR16                       *Description,
+  IN EFI_TEST_LEVEL               TestLevel,
+  IN EFI_GUID                     *SupportProtocols,
+  IN EFI_TEST_ATTRIBUTE           CaseAttribute
+  )
+/*++
+
+Routine Description:
+
+  Save a single test entry into a test file record.
+
+--*/
+{
+  CHAR16  Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+
+  SctGuidToStr (EntryId, Buffer);
+  ManifestSetEntryString (IniFile, Order, L"EntryId", Index, Buffer);
+
+  ManifestSetEntryString (IniFile, Order, L"Name",        Index, (Name        != NULL) ? Name        : L"");
+  ManifestSetEntryString (IniFile, Order, L"Description", Index, (Description != NULL) ? Description : L"");
+
+  SctIntToHexStr ((UINTN) TestLevel, Buffer);
+  ManifestSetEntryString (IniFile, Order, L"TestLevel", Index, Buffer);
+
+  Buffer[0] = L'\0';
+  if (SupportProtocols != NULL) {
+    SctGuidArrayToStr (SupportProtocols, Buffer);
+  }
+  ManifestSetEntryString (IniFile, Order, L"SupportProtocols", Index, Buffer);
+
+  SctIntToHexStr ((UINTN) CaseAttribute, Buffer);
+  ManifestSetEntryString (IniFile, Order, L"CaseAttribute", Index, Buffer);
+
+  return EFI_SUCCESS;
+}
+
+
+BOOLEAN
+ManifestContextFits (
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context
+  )
+/*++
+
+Routine Description:
+
+  Check whether every string of a test protocol fits into the INI file.
+
+--*/
+{
+  EFI_BB_TEST_PROTOCOL    *BbTest;
+  EFI_BB_TEST_ENTRY       *BbEntry;
+  EFI_WB_TEST_PROTOCOL    *WbTest;
+  EFI_WB_TEST_ENTRY       *WbEntry;
+
+  switch (Type) {
+  case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
+  case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
+    BbTest = (EFI_BB_TEST_PROTOCOL *) Context;
+    if (!ManifestStringFits (BbTest->Name) ||
+        !ManifestStringFits (BbTest->Description)) {
+      return FALSE;
+    }
+
+    for (BbEntry = BbTest->EntryList; BbEntry != NULL; BbEntry = BbEntry->Next) {
+      if (!ManifestStringFits (BbEntry->Name)        ||
+          !ManifestStringFits (BbEntry->Description) ||
+          !ManifestGuidArrayFits (BbEntry->SupportProtocols)) {
+        return FALSE;
+      }
+    }
+    return TRUE;
+
+  case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
+    WbTest = (EFI_WB_TEST_PROTOCOL *) Context;
+    if (!ManifestStringFits (WbTest->Name) ||
+        !ManifestStringFits (WbTest->Description)) {
+      return FALSE;
+    }
+
+    for (WbEntry = WbTest->EntryList; WbEntry != NULL; WbEntry = WbEntry->Next) {
+      if (!ManifestStringFits (WbEntry->Name)        ||
+          !ManifestStringFits (WbEntry->Description) ||
+          !ManifestGuidArrayFits (WbEntry->SupportProtocols)) {
+        return FALSE;
+      }
+    }
+    return TRUE;
+
+  case EFI_SCT_TEST_FILE_TYPE_APPLICATION:
+    return TRUE;
+
+  default:
+    return FALSE;
+  }
+}
+
+
+BOOLEAN
+ManifestStringFits (
+  IN CHAR16                       *String
+  )
+/*++
+
+Routine Description:
+
+  Check whether a string fits into a single INI value.
+
+--*/
+{
+  if (String == NULL) {
+    return TRUE;
+  }
+
+  return (BOOLEAN) (SctStrLen (String) < EFI_SCT_MANIFEST_MAX_VALUE_LEN);
+}
+
+
+BOOLEAN
+ManifestGuidArrayFits (
+  IN EFI_GUID                     *GuidArray
+  )
+/*++
+
+Routine Description:
+
+  Check whether a GUID array fits into a single INI value. Each GUID takes 36
+  characters plus a separator.
+
+--*/
+{
+  UINTN   Length;
+
+  if (GuidArray == NULL) {
+    return TRUE;
+  }
+
+  Length = 0;
+  while (SctCompareGuid (GuidArray, &gEfiNullGuid) != 0) {
+    Length += 37;
+    if (Length >= EFI_SCT_MANIFEST_MAX_VALUE_LEN) {
+      return FALSE;
+    }
+    GuidArray ++;
+  }
+
+  return TRUE;
+}
+
+
+VOID
+ManifestTimeToStr (
+  IN EFI_TIME                     *Time,
+  OUT CHAR16                      *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Convert a modification time to a string.
+
+--*/
+{
+  SctSPrint (
+    Buffer,
+    EFI_SCT_MANIFEST_TIME_LEN * sizeof(CHAR16),
+    L"%04d-%02d-%02d %02d:%02d:%02d",
+    (UINTN) Time->Year,
+    (UINTN) Time->Month,
+    (UINTN) Time->Day,
+    (UINTN) Time->Hour,
+    (UINTN) Time->Minute,
+    (UINTN) Time->Second
+    );
+}
+
+
+EFI_SCT_MANIFEST_FILE *
+FindManifestFileByName (
+  IN CHAR16                       *FileName
+  )
+/*++
+
+Routine Description:
+
+  Find a test file record by the file name.
+
+--*/
+{
+  SCT_LIST_ENTRY          *Link;
+  EFI_SCT_MANIFEST_FILE   *ManifestFile;
+
+  for (Link = mManifestFileList.ForwardLink; Link != &mManifestFileList; Link = Link->ForwardLink) {
+    ManifestFile = CR (Link, EFI_SCT_MANIFEST_FILE, Link, EFI_SCT_MANIFEST_FILE_SIGNATURE);
+
+    if (SctStriCmp (ManifestFile->FileName, FileName) == 0) {
+      return ManifestFile;
+    }
+  }
+
+  return NULL;
+}
+
+
+EFI_STATUS
+ManifestGetString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  OUT CHAR16                      *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Get a string from a test file section.
+
+--*/
+{
+  UINT32  BufferSize;
+
+  BufferSize = EFI_SCT_MAX_BUFFER_SIZE;
+  return IniFile->GetStringByOrder (
+                    IniFile,
+                    Order,
+                    EFI_SCT_SECTION_TEST_MANIFEST,
+                    Key,
+                    Buffer,
+                    &BufferSize
+                    );
+}
+
+
+EFI_STATUS
+ManifestSetString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  IN CHAR16                       *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Set a string into a test file section.
+
+--*/
+{
+  return IniFile->SetStringByOrder (
+                    IniFile,
+                    Order,
+                    EFI_SCT_SECTION_TEST_MANIFEST,
+                    Key,
+                    Buffer
+                    );
+}
+
+
+EFI_STATUS
+ManifestGetEntryString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  IN UINTN                        Index,
+  OUT CHAR16                      *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Get a string of a test entry from a test file section. The keys of the
+  test entries are suffixed with the entry index.
+
+--*/
+{
+  CHAR16  EntryKey[32];
+
+  SctSPrint (EntryKey, sizeof(EntryKey), L"%s%d", Key, Index);
+  return ManifestGetString (IniFile, Order, EntryKey, Buffer);
+}
+
+
+EFI_STATUS
+ManifestSetEntryString (
+  IN EFI_INI_FILE_HANDLE          IniFile,
+  IN UINT32                       Order,
+  IN CHAR16                       *Key,
+  IN UINTN                        Index,
+  IN CHAR16                       *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Set a string of a test entry into a test file section.
+
+--*/
+{
+  CHAR16  EntryKey[32];
+
+  SctSPrint (EntryKey, sizeof(EntryKey), L"%s%d", Key, Index);
+  return ManifestSetString (IniFile, Order, EntryKey, Buffer);
+}
@@ -238,6 +238,7 @@ SctAgentCmdDispatch (
     //
     RivlDelRivlType (NULL);
     RivlDelRivlVariable (NULL);
+    PassiveTestContextSync ();
     return EFI_ABORTED;
 
   case ELET_CMD:
@@ -246,6 +247,10 @@ SctAgentCmdDispatch (
 
   case EXECUTE:
     EntsMonitor->MonitorSaveContext(EntsMonitor);
+    //
+    // The test may reset the system or change the context file
+    //
+    PassiveTestContextSync ();
     FreeDebugServices();
     Status = DispatchExecComd ();
     InitializeDebugServices();
@@ -257,6 +262,10 @@ SctAgentCmdDispatch (
     Status = DispatchFileTransferComd (MonitorCmd->CmdType);
     break;
 
+  case RIVL_BATCH:
+    Status = DispatchBatchComd ();
+    break;
+
   default:
     Status = DispatchInternalComd ();
   }
@@ -41,6 +41,7 @@ Abstract:
 #define CMD_ACK_KEYWORD     L" _ACK_ "
 #define CMD_OUT_KEYWORD     L" _OUT_ "
 #define CMD_LOG_KEYWORD     L" _LOG_ "
+#define CMD_NEXT_KEYWORD    L" _NEXT_ "
 
 #define ACK_SEND_LOG
 
@@ -78,6 +79,12 @@ SendAppACK (
   IN EFI_MONITOR_COMMAND           *Cmd
   );
 
+EFI_STATUS
+BuildAppACK (
+  IN  EFI_MONITOR_COMMAND          *Cmd,
+  OUT CHAR16                       **Ack
+  );
+
 EFI_STATUS
 EmptyCmd (
   IN EFI_MONITOR_COMMAND           *Cmd
@@ -340,6 +347,121 @@ Returns:
   return Status;
 }
 
+EFI_STATUS
+DispatchBatchComd (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Dispatch a batch of internal commands. The commands are separated by
+  " _NEXT_ " and run in order, a failed one does not stop the others. The
+  ack of each command is built as if it was sent alone, and the acks are
+  joined by " _NEXT_ " in the output of the batch.
+
+Arguments:
+
+  None
+
+Returns:
+
+  EFI_SUCCESS - Operation succeeded.
+  EFI_OUT_OF_RESOURCES - Memory allocation failed.
+  Others      - Some failure happened.
+
+--*/
+{
+  EFI_STATUS          Status;
+  EFI_MONITOR_COMMAND *BatchCmd;
+  EFI_MONITOR_COMMAND SubCmd;
+  CHAR16              *SubBuffer;
+  CHAR16              *NextBuffer;
+  CHAR16              *Ack;
+  UINTN               AckCount;
+  UINTN               Index;
+
+  BatchCmd = gEasFT->Cmd;
+  if (BatchCmd->ComdArg == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SctSetMem (&SubCmd, sizeof (SubCmd), 0);
+  SubCmd.Signature  = EFI_MONITOR_COMMAND_SIGNATURE;
+  SubCmd.Version    = EFI_MONITOR_COMMAND_VERSION;
+
+  Status            = EFI_SUCCESS;
+  AckCount          = 0;
+
+  for (SubBuffer = BatchCmd->ComdArg; SubBuffer != NULL; SubBuffer = NextBuffer) {
+    Index = EntsStrStr (SubBuffer, CMD_NEXT_KEYWORD);
+    if (Index != 0) {
+      SubBuffer[Index - 1]  = L'\0';
+      NextBuffer            = SubBuffer + Index - 1 + SctStrLen (CMD_NEXT_KEYWORD);
+    } else {
+      NextBuffer            = NULL;
+    }
+
+    //
+    // Only the RIVL commands may be batched, they run on the sub command
+    // as if it was the current one
+    //
+    Status = GetCmdDispatch (SubBuffer, &SubCmd);
+    if (!EFI_ERROR (Status) &&
+        ((SubCmd.CmdType < RIVL_DEFTYPE) || (SubCmd.CmdType > RIVL_DELVAR))) {
+      Status = EFI_UNSUPPORTED;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      gEasFT->Cmd = &SubCmd;
+      Status      = DispatchInternalComd ();
+      gEasFT->Cmd = BatchCmd;
+    } else if (Status != EFI_OUT_OF_RESOURCES) {
+      EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"RIVL_BATCH (%s) Status - %r", SubBuffer, Status));
+      Status = RecordMessage (
+                &SubCmd.ComdRuntimeInfo,
+                &SubCmd.ComdRuntimeInfoSize,
+                L"RIVL_BATCH Status - %r",
+                Status
+                );
+      if (!EFI_ERROR (Status)) {
+        Status = EFI_UNSUPPORTED;
+      }
+    }
+
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      break;
+    }
+
+    SubCmd.ComdResult = EFI_ERROR (Status) ? FAIL : PASS;
+
+    Status = BuildAppACK (&SubCmd, &Ack);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    //
+    // Append the ack of the sub command to the output
+    //
+    Status = RecordMessage (
+              &BatchCmd->ComdOutput,
+              &BatchCmd->ComdOutputSize,
+              (AckCount == 0) ? L"%s" : CMD_NEXT_KEYWORD L"%s",
+              Ack
+              );
+    EntsFreePool (Ack);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    AckCount++;
+    EmptyCmd (&SubCmd);
+  }
+
+  EmptyCmd (&SubCmd);
+  return Status;
+}
+
 EFI_STATUS
 DispatchExecComd (
   VOID
@@ -644,6 +766,14 @@ Returns:
     EFI_ENTS_DEBUG ((EFI_ENTS_D_TRACE, L"GetRemoteCmd: %s", RIVL_GETVAR_CMD));
     return EFI_SUCCESS;
   }
+  //
+  // Is it RIVL_BATCH
+  //
+  if (SctCompareMem (Cmd->ComdName, RIVL_BATCH_CMD, SctStrLen (RIVL_BATCH_CMD) * 2) == 0) {
+    Cmd->CmdType = RIVL_BATCH;
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_TRACE, L"GetRemoteCmd: %s", RIVL_BATCH_CMD));
+    return EFI_SUCCESS;
+  }
 
   Status = EntsFindTestFileByName (Cmd->ComdName, &(Cmd->TestFile));
   if (EFI_ERROR (Status)) {
@@ -680,13 +810,67 @@ Returns:
 {
   EFI_STATUS                Status;
   CHAR16                    *AppResultTmp;
-  UINTN                     Len;
-  UINTN                     OutputLen;
-  UINTN                     RuntimeInfoLen;
   EFI_ENTS_MONITOR_PROTOCOL *EntsMonitor;
 
   EntsMonitor = gEasFT->Monitor;
 
+  //
+  // The output of a batch is the acks of its commands
+  //
+  if ((Cmd->CmdType == RIVL_BATCH) && (Cmd->ComdOutput != NULL)) {
+    Status = EntsMonitor->MonitorSender (EntsMonitor, Cmd->ComdOutput);
+    if (EFI_ERROR (Status)) {
+      EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"in SendResult: sender error Status - %r\n", Status));
+    }
+
+    return Status;
+  }
+
+  Status = BuildAppACK (Cmd, &AppResultTmp);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EntsMonitor->MonitorSender (EntsMonitor, AppResultTmp);
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"in SendResult: sender error Status - %r\n", Status));
+  }
+
+  if (AppResultTmp) {
+    EntsFreePool(AppResultTmp);
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+BuildAppACK (
+  IN  EFI_MONITOR_COMMAND          *Cmd,
+  OUT CHAR16                       **Ack
+  )
+/*++
+
+Routine Description:
+
+  Build the ack of a command, the caller frees it.
+
+Arguments:
+
+  Cmd - Pointer to EFI_MONITOR_COMMAND structure.
+  Ack - Return the ack string.
+
+Returns:
+
+  EFI_SUCCESS - Operation succeeded.
+  EFI_OUT_OF_RESOURCES - Memory allocation failed.
+
+--*/
+{
+  CHAR16                    *AppResultTmp;
+  UINTN                     Len;
+  UINTN                     OutputLen;
+  UINTN                     RuntimeInfoLen;
+
   //
   // AR: need to diff InternalSendACK and EletSendACK: how to store runtimeInfo
   //
@@ -703,7 +887,7 @@ Returns:
 
   AppResultTmp = EntsAllocatePool (Len * 2);
   if (AppResultTmp == NULL) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Error in SendAppACK: EFI_OUT_OF_RESOURCES"));
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Error in BuildAppACK: EFI_OUT_OF_RESOURCES"));
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -739,16 +923,8 @@ Returns:
   }
 #endif
 
-  Status = EntsMonitor->MonitorSender (EntsMonitor, AppResultTmp);
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"in SendResult: sender error Status - %r\n", Status));
-  }
-
-  if (AppResultTmp) {
-    EntsFreePool(AppResultTmp);
-  }
-
-  return Status;
+  *Ack = AppResultTmp;
+  return EFI_SUCCESS;
 }
 
 EFI_STATUS
@@ -445,6 +445,7 @@ Returns:
   CHAR8                             FileName[MAX_FILENAME_LEN];
   CHAR8                             ModeStr[MAX_MODE_STR_LEN];
   UINTN                             MacAddrLen;
+  EFI_EFTP_OPTION                   Options[EFTP_OFFER_OPTION_COUNT];
 
   //
   // Open file to be transferred.
@@ -530,18 +531,30 @@ Returns:
     goto Cleanup2;
   }
 
+  //
+  // Ask for full frames and a window of blocks per ACK, and for the size
+  // of a download so the buffer can be sized when it is too small
+  //
+  Options[0].OptionStr  = "blksize";
+  Options[0].ValueStr   = EFTP_OFFER_BLKSIZE;
+  Options[1].OptionStr  = "windowsize";
+  Options[1].ValueStr   = EFTP_OFFER_WINDOWSIZE;
+  Options[2].OptionStr  = "tsize";
+  Options[2].ValueStr   = "0";
+
   UnicodeToChar (FileName, (gEasFT->Cmd)->ComdArg);
   Token.Filename        = FileName;
   Token.OverrideData    = NULL;
   Token.ModeStr         = ModeStr;
-  Token.OptionCount     = 0;
-  Token.OptionList      = NULL;
+  Token.OptionCount     = (Operation == GET_FILE) ? EFTP_OFFER_OPTION_COUNT : EFTP_OFFER_OPTION_COUNT - 1;
+  Token.OptionList      = Options;
   Token.Context         = NULL;
   Token.TimeoutCallback = NULL;
   Token.BufferSize      = 0;
   Token.Buffer          = NULL;
   Token.CheckPacket     = NULL;
   Token.PacketNeeded    = NULL;
+  mTransferSize         = MAX_REAL_FILE_SIZE;
 
 Operation_start:
   //
@@ -556,8 +569,13 @@ Operation_start:
     // Download file
     //
     Token.CheckPacket = NULL;
-    Token.BufferSize  = MAX_REAL_FILE_SIZE;
+    Token.BufferSize  = mTransferSize;
     Token.Buffer      = EntsAllocatePool ((UINTN) Token.BufferSize);
+    if (Token.Buffer == NULL) {
+      SctPrint (L"Allocate buffer (%ld bytes) failed.\n", mTransferSize);
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Cleanup2;
+    }
 
     SctPrint (L"Begin download ... ");
     Status = EftpIo->ReadFile (EftpIo, &Token);
@@ -582,18 +600,24 @@ Operation_start:
       }
 
     } else if (Status == EFI_BUFFER_TOO_SMALL) {
-      mTransferSize = MAX_REAL_FILE_SIZE;
-      SctPrint (L"Buffer too small, try to allocate a larger buffer(%ld).\n", mTransferSize);
-      Token.Buffer = EntsAllocatePool ((UINTN) mTransferSize);
-      if (Token.Buffer == NULL) {
-        SctPrint (L"Allocate buffer (%ld bytes) failed.\n", mTransferSize);
-        goto Cleanup2;
+      SctFreePool (Token.Buffer);
+
+      //
+      // The size reported from the tsize option, or twice the buffer when
+      // the EMS didn't tell it
+      //
+      if ((Token.BufferSize != (UINT64) -1) && (Token.BufferSize > mTransferSize)) {
+        mTransferSize = Token.BufferSize;
+      } else {
+        mTransferSize = SctMultU64x32 (mTransferSize, 2);
       }
 
+      SctPrint (L"Buffer too small, try to allocate a larger buffer(%ld).\n", mTransferSize);
       Token.Status = EFI_SUCCESS;
       goto Operation_start;
     } else if (EFI_ERROR (Status)) {
       SctPrint (L"Download error - %r\n", Status);
+      SctFreePool (Token.Buffer);
     }
 
     break;
@@ -61,6 +61,7 @@ Abstract:
 #define RIVL_GETVAR_CMD           L"RIVL_GETVAR"
 #define RIVL_DELTYPE_CMD          L"RIVL_DELTYPE"
 #define RIVL_DELVAR_CMD           L"RIVL_DELVAR"
+#define RIVL_BATCH_CMD            L"RIVL_BATCH"
 #define EFI_NETWORK_ABORT_COMMAND L"TEST_ABORT"
 #define EFI_NETWORK_EXEC_COMMAND  L"TEST_EXEC"
 #define EFI_NETWORK_GET_FILE      L"GET_FILE"
@@ -103,6 +103,30 @@ Returns:
 --*/
 ;
 
+EFI_STATUS
+DispatchBatchComd (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Dispatch a batch of internal commands, and keep their acks to be sent
+  back together
+
+Arguments:
+
+  None
+
+Returns:
+
+  EFI_SUCCESS - Operation succeeded.
+  EFI_OUT_OF_RESOURCES - Memory allocation failed.
+  Others      - Some failure happened.
+
+--*/
+;
+
 EFI_STATUS
 DispatchExecComd (
   VOID
@@ -71,6 +71,7 @@ typedef enum {
   RUNTIME_INFO_CLEAR,
   GET_FILE,
   PUT_FILE,
+  RIVL_BATCH,
 } ENTS_CMD_TYPE;
 
 typedef enum _ENTS_CMD_RESULT
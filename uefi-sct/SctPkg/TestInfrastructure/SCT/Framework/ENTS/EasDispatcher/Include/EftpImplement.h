@@ -36,6 +36,15 @@ Abstract:
 #define MAX_FILENAME_LEN            50
 #define MAX_MODE_STR_LEN            10
 
+//
+// Options offered with each transfer. The block fills an Ethernet frame
+// with the EFTP header and the CRC the EMS appends. An EMS that doesn't
+// know the options answers without an OACK, in the stop-and-wait way.
+//
+#define EFTP_OFFER_BLKSIZE          "1488"
+#define EFTP_OFFER_WINDOWSIZE       "16"
+#define EFTP_OFFER_OPTION_COUNT     3
+
 //
 // External functions declarations
 //
@@ -30,6 +30,16 @@ Abstract:
 #define MAX_FILENAME_LEN                   128
 #define MAX_RECORD_LEN                     512
 
+//
+// The context is kept resident in a hash of CONTEXT_HASH_SIZE buckets. The
+// file is a log of fixed MAX_RECORD_LEN blocks, each one sets a record or,
+// with a size of 0, deletes it; the last block of a key wins. The log is
+// rewritten when it holds more than twice the live records plus
+// CONTEXT_COMPACT_SLACK blocks.
+//
+#define CONTEXT_HASH_SIZE                  32
+#define CONTEXT_COMPACT_SLACK              16
+
 typedef struct _EFI_PASSIVE_TEST_CONTEXT_RECORD {
   CHAR8                                            *Key;
   UINTN                                            Size;
@@ -41,9 +51,17 @@ typedef struct _EFI_PASSIVE_TEST_CONTEXT {
   EFI_FILE_HANDLE                                  DirHandle;
   EFI_FILE_HANDLE                                  FileHandle;
   CHAR16                                           FileName[MAX_FILENAME_LEN];
-  IN UINT64                                        Attributes;
+  EFI_DEVICE_PATH_PROTOCOL                         *DevicePath;
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *Records[CONTEXT_HASH_SIZE];
+  UINTN                                            RecordCount;
+  UINTN                                            LogCount;
 }EFI_PASSIVE_TEST_CONTEXT;
-
+
+//
+// The resident context, NULL until a record is accessed
+//
+STATIC EFI_PASSIVE_TEST_CONTEXT                    *mContext = NULL;
+
 STATIC
 EFI_STATUS
 ContextReopen (
@@ -55,203 +73,312 @@ EFI_STATUS
 ContextOpen (
   IN EFI_DEVICE_PATH_PROTOCOL                      *DevicePath,
   IN CHAR16                                        *FileName,
-  IN UINT64                                        Attributes,
   OUT EFI_PASSIVE_TEST_CONTEXT                     **Context
   );
 
+STATIC
+VOID
+ContextClose (
+  IN EFI_PASSIVE_TEST_CONTEXT                      *Context
+  );
+
+STATIC
+EFI_PASSIVE_TEST_CONTEXT_RECORD **
+FindRecord (
+  IN EFI_PASSIVE_TEST_CONTEXT                      *Context,
+  IN CHAR8                                         *Key
+  )
+{
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  **Link;
+  UINT32                                           Hash;
+  CHAR8                                            *TmpStr;
+
+  //
+  // FNV-1a hash of the key
+  //
+  Hash = 2166136261U;
+  for (TmpStr = Key; *TmpStr != '\0'; TmpStr++) {
+    Hash = (Hash ^ (UINT8) *TmpStr) * 16777619U;
+  }
+
+  //
+  // Return the link to the record, or the link at the end of the bucket
+  //
+  Link = &Context->Records[Hash % CONTEXT_HASH_SIZE];
+  while ((*Link != NULL) && (SctAsciiStrCmp ((*Link)->Key, Key) != 0)) {
+    Link = &(*Link)->Next;
+  }
+
+  return Link;
+}
+
+STATIC
+VOID
+FreeRecord (
+  IN EFI_PASSIVE_TEST_CONTEXT_RECORD               *Record
+  )
+{
+  EntsFreePool(Record->Key);
+  if (Record->Value != NULL) {
+    EntsFreePool(Record->Value);
+  }
+  EntsFreePool(Record);
+}
+
 STATIC
 EFI_STATUS
-DelRecord (
+StoreRecord (
+  IN EFI_PASSIVE_TEST_CONTEXT                      *Context,
+  IN CHAR8                                         *Key,
+  IN UINTN                                         RecordSize,
+  IN VOID                                          *RecordValue
+  )
+{
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  **Link;
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *Record;
+  CHAR8                                            *KeyBuf;
+  VOID                                             *ValueBuf;
+
+  ValueBuf = (VOID *)EntsAllocateZeroPool (RecordSize);
+  if (ValueBuf == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  EntsCopyMem(ValueBuf, RecordValue, RecordSize);
+
+  //
+  // Replace the value of the record if found, otherwise create a new record
+  // at the end of the bucket
+  //
+  Link = FindRecord (Context, Key);
+  if (*Link != NULL) {
+    EntsFreePool((*Link)->Value);
+    (*Link)->Value = ValueBuf;
+    (*Link)->Size  = RecordSize;
+    return EFI_SUCCESS;
+  }
+
+  Record = (EFI_PASSIVE_TEST_CONTEXT_RECORD *)EntsAllocateZeroPool(sizeof(EFI_PASSIVE_TEST_CONTEXT_RECORD));
+  KeyBuf = (CHAR8 *)EntsAllocateZeroPool (SctAsciiStrLen (Key) + 1);
+  if ((Record == NULL) || (KeyBuf == NULL)) {
+    if (Record != NULL) {
+      EntsFreePool(Record);
+    }
+    if (KeyBuf != NULL) {
+      EntsFreePool(KeyBuf);
+    }
+    EntsFreePool(ValueBuf);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  SctAsciiStrCpy (KeyBuf, Key);
+  Record->Key   = KeyBuf;
+  Record->Size  = RecordSize;
+  Record->Value = ValueBuf;
+  *Link         = Record;
+  Context->RecordCount++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+RemoveRecord (
   IN EFI_PASSIVE_TEST_CONTEXT                      *Context,
   IN CHAR8                                         *Key
-  );
+  )
+{
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  **Link;
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *Record;
+
+  Link = FindRecord (Context, Key);
+  if (*Link == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Record = *Link;
+  *Link  = Record->Next;
+  FreeRecord (Record);
+  Context->RecordCount--;
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeRecords (
+  IN EFI_PASSIVE_TEST_CONTEXT                      *Context
+  )
+{
+  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *Record;
+  UINTN                                            Index;
+
+  for (Index = 0; Index < CONTEXT_HASH_SIZE; Index++) {
+    while (Context->Records[Index] != NULL) {
+      Record                  = Context->Records[Index];
+      Context->Records[Index] = Record->Next;
+      FreeRecord (Record);
+    }
+  }
+
+  Context->RecordCount = 0;
+}
 
 STATIC
 EFI_STATUS
 ParseRecordLine (
   IN CHAR8                                 *LineBuf,
-  IN OUT EFI_PASSIVE_TEST_CONTEXT_RECORD   *Record
+  OUT CHAR8                                **Key,
+  OUT UINTN                                *Size,
+  OUT VOID                                 **Value
   )
 {
   CHAR8                                    *TmpStr;
-  CHAR8                                    *KeyBuf;
-  VOID                                     *ValueBuf;
-  UINTN                                    ValueSize;
 
+  LineBuf[MAX_RECORD_LEN - 1] = '\0';
   TmpStr  = SctAsciiStrChr (LineBuf, '|');
   if (TmpStr == NULL) {
     return EFI_INVALID_PARAMETER;
   }
   *TmpStr = '\0';
-  KeyBuf = (CHAR8 *)EntsAllocateZeroPool((TmpStr - LineBuf + 1));
-  if (KeyBuf == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-  SctAsciiStrCpy (KeyBuf, LineBuf);
   TmpStr++;
-  EntsCopyMem(&ValueSize, TmpStr, sizeof(UINTN));
-  ValueBuf = (VOID *)EntsAllocateZeroPool (ValueSize);
-  if (ValueBuf == NULL) {
-    EntsFreePool (KeyBuf);
-    return EFI_OUT_OF_RESOURCES;
+  if (TmpStr + sizeof(UINTN) + 1 > LineBuf + MAX_RECORD_LEN) {
+    return EFI_INVALID_PARAMETER;
   }
+  EntsCopyMem(Size, TmpStr, sizeof(UINTN));
   TmpStr += sizeof(UINTN) + 1;
-  EntsCopyMem(ValueBuf, TmpStr, ValueSize);
+  if (*Size > (UINTN) (LineBuf + MAX_RECORD_LEN - TmpStr)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-  Record->Key   = KeyBuf;
-  Record->Size  = ValueSize;
-  Record->Value = ValueBuf;
+  *Key   = LineBuf;
+  *Value = TmpStr;
   return EFI_SUCCESS;
 }
 
 STATIC
 EFI_STATUS
 ReadRecordsFromFile (
-  IN EFI_PASSIVE_TEST_CONTEXT              *Context,
-  OUT EFI_PASSIVE_TEST_CONTEXT_RECORD      **RecordListHead
+  IN EFI_PASSIVE_TEST_CONTEXT              *Context
   )
 {
   EFI_STATUS                               Status;
   EFI_FILE_HANDLE                          FileHandle;
   CHAR8                                    Buffer[MAX_RECORD_LEN];
   UINTN                                    BufSize;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD          *Record;
-
-  if (RecordListHead == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
+  CHAR8                                    *Key;
+  UINTN                                    Size;
+  VOID                                     *Value;
 
-  *RecordListHead = NULL;
-  FileHandle       = Context->FileHandle;
+  FileHandle = Context->FileHandle;
 
   //
-  // Read all the records from the file to initialize the record list
+  // Replay the log into the record hash. A short block at the end is a write
+  // cut by a reset, it is dropped.
   //
-  BufSize = MAX_RECORD_LEN;
-  Status = FileHandle->Read (FileHandle, &BufSize, Buffer);
-  if (EFI_ERROR(Status)) {
-    EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Read file error - %r", Status));
-    goto Error1;
-  }
-  while (BufSize != 0) {
-    Record = (EFI_PASSIVE_TEST_CONTEXT_RECORD *)EntsAllocateZeroPool(sizeof(EFI_PASSIVE_TEST_CONTEXT_RECORD));
-    if (Record == NULL) {
+  while (TRUE) {
+    BufSize = MAX_RECORD_LEN;
+    Status = FileHandle->Read (FileHandle, &BufSize, Buffer);
+    if (EFI_ERROR(Status)) {
+      EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Read file error - %r", Status));
       goto Error1;
     }
+    if (BufSize != MAX_RECORD_LEN) {
+      break;
+    }
 
-    //
-    // Process a line and insert the record into record list 
-    //
-    Status = ParseRecordLine(Buffer, Record);
+    Status = ParseRecordLine(Buffer, &Key, &Size, &Value);
     if (EFI_ERROR(Status)) {
-      EntsFreePool(Record);
       EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Parse the record line fail - %r", Status));
       goto Error1;
     }
 
-    Record->Next = *RecordListHead;
-    *RecordListHead = Record;
-
-#if 0
-    for (BufPos = 0; BufPos < BufSize; BufPos++) {
-      if (Buffer[BufPos] == '\n') {
-        //
-        // Make the LineBuf as a string (end with '\0')
-        //
-        LineBuf[LinePos++] = '\0';
-
-        Record = (EFI_PASSIVE_TEST_CONTEXT_RECORD *)EntsAllocateZeroPool(sizeof(EFI_PASSIVE_TEST_CONTEXT_RECORD));
-        if (Record == NULL) {
-          goto Error1;
-        }
-        //
-        // Process a line and insert the record into record list 
-        //
-        Status  = ParseRecordLine(LineBuf, LinePos,  Record);
-        if (EFI_ERROR(Status)) {
-          EntsFreePool(Record);
-          EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Parse the record line %s fail - %r", LineBuf, Status));
-          goto Error1;
-        }
-        Record->Next = *RecordListHead;
-		*RecordListHead = Record;
-
-        LinePos = 0;
-        continue;
-      }
-      LineBuf[LinePos++] = Buffer[BufPos];
+    if (Size == 0) {
+      RemoveRecord (Context, Key);
+      Status = EFI_SUCCESS;
+    } else {
+      Status = StoreRecord (Context, Key, Size, Value);
     }
-#endif
-    //
-    // Read a new buffer
-    //
-    BufSize = MAX_RECORD_LEN;
-    Status = FileHandle->Read (FileHandle, &BufSize, Buffer);
     if (EFI_ERROR(Status)) {
-      EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Read file error - %r", Status));
       goto Error1;
     }
+    Context->LogCount++;
   }
 
+  if (BufSize != 0) {
+    EFI_ENTS_DEBUG((EFI_ENTS_D_WARNING, L"Drop the partial record at the end of %s", Context->FileName));
+  }
   return EFI_SUCCESS;
 Error1:
   //
-  // Free the record list and return
+  // Free the records and return
   //
-  while(*RecordListHead != NULL) {
-    Record = *RecordListHead;
-	*RecordListHead = (*RecordListHead)->Next;
-    EntsFreePool(Record->Key);
-	EntsFreePool(Record->Value);
-	EntsFreePool(Record);
-  }
+  FreeRecords (Context);
   return Status;
 }
 
 STATIC
 EFI_STATUS
-WriteRecordsToFile(
+WriteRecord (
   IN EFI_PASSIVE_TEST_CONTEXT              *Context,
-  IN EFI_PASSIVE_TEST_CONTEXT_RECORD       *RecordListHead
+  IN CHAR8                                 *Key,
+  IN UINTN                                 RecordSize,
+  IN VOID                                  *RecordValue
   )
 {
   EFI_STATUS                               Status;
   EFI_FILE_HANDLE                          FileHandle;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD          *Record;
   CHAR8                                    Buffer[MAX_RECORD_LEN];
   UINTN                                    BufSize;
   UINTN                                    Index;
 
+  FileHandle = Context->FileHandle;
+
+  EntsZeroMem (Buffer, MAX_RECORD_LEN);
+  SctAsciiStrCpy (Buffer, Key);
+  Index = SctAsciiStrLen (Key);
+  Buffer[Index++] = '|';
+  EntsCopyMem(Buffer + Index, &RecordSize, sizeof(UINTN));
+  Index += sizeof(UINTN);
+  Buffer[Index++] = '|';
+  if (RecordSize != 0) {
+    EntsCopyMem(Buffer + Index, RecordValue, RecordSize);
+  }
+  BufSize = MAX_RECORD_LEN;
+  Status = FileHandle->Write(FileHandle, &BufSize, Buffer);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Context->LogCount++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+WriteRecordsToFile(
+  IN EFI_PASSIVE_TEST_CONTEXT              *Context
+  )
+{
+  EFI_STATUS                               Status;
+  EFI_PASSIVE_TEST_CONTEXT_RECORD          *Record;
+  UINTN                                    Index;
+
   //
   // Delete the old file and create a new one to throw away old records
   //
   Status = ContextReopen(Context);
   if (EFI_ERROR(Status)) {
-  	return Status;
-  }
-
-  if (RecordListHead == NULL) {
-    return EFI_SUCCESS;
+    return Status;
   }
 
-  FileHandle = Context->FileHandle;
-
-  for (Record = RecordListHead; Record != NULL; Record = Record->Next) {
-    SctAsciiStrCpy (Buffer, Record->Key);
-    Index = SctAsciiStrLen (Record->Key);
-    Buffer[Index++] = '|';
-    EntsCopyMem(Buffer + Index, &Record->Size, sizeof(UINTN));
-    Index += sizeof(UINTN);
-	Buffer[Index++] = '|';
-	EntsCopyMem(Buffer + Index, Record->Value, MAX_RECORD_LEN - Index);
-    BufSize = MAX_RECORD_LEN;
-    Status = FileHandle->Write(FileHandle, &BufSize, Buffer);
-    if (EFI_ERROR(Status)) {
-      return Status;
+  Context->LogCount = 0;
+  for (Index = 0; Index < CONTEXT_HASH_SIZE; Index++) {
+    for (Record = Context->Records[Index]; Record != NULL; Record = Record->Next) {
+      Status = WriteRecord (Context, Record->Key, Record->Size, Record->Value);
+      if (EFI_ERROR(Status)) {
+        return Status;
+      }
     }
   }
 
-  return FileHandle->Flush(FileHandle);
+  return Context->FileHandle->Flush(Context->FileHandle);
 }
 
 STATIC
@@ -264,82 +391,25 @@ SetRecord (
   )
 {
   EFI_STATUS                                Status;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD           *RecordListHead;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD           *Record;
-  CHAR8                                     *KeyBuf;
-  VOID                                      *ValueBuf;
 
-  Status = ReadRecordsFromFile(Context, &RecordListHead);
+  Status = StoreRecord (Context, Key, RecordSize, RecordValue);
   if (EFI_ERROR(Status)) {
-  	return Status;
-  }
-
-  for (Record = RecordListHead; Record != NULL; Record = Record->Next) {
-  	if (SctAsciiStrCmp (Key, Record->Key) == 0) {
-      break;
-    }
+    return Status;
   }
 
   //
-  // Create a new record if does not found otherwise replease the
-  // value with new one and then inset the record list
+  // Compact the log once it is mostly old records, append to it otherwise.
+  // Either way the file is not flushed here, PassiveTestContextSync does it.
   //
-  if (Record == NULL) {
-    Record = (EFI_PASSIVE_TEST_CONTEXT_RECORD *)EntsAllocateZeroPool(sizeof(EFI_PASSIVE_TEST_CONTEXT_RECORD));
-    if (Record == NULL ) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto FreeAndReturn;
-    }
-    KeyBuf = (CHAR8 *)EntsAllocateZeroPool (SctAsciiStrLen (Key) + 1);
-    if (KeyBuf == NULL) {
-      EntsFreePool(Record);
-      Status = EFI_OUT_OF_RESOURCES;
-      goto FreeAndReturn;
-    }
-    ValueBuf = (CHAR8 *)EntsAllocateZeroPool (RecordSize);
-    if (ValueBuf == NULL) {
-      EntsFreePool(Record);
-      EntsFreePool(KeyBuf);
-      Status = EFI_OUT_OF_RESOURCES;
-      goto FreeAndReturn;
-    }
-    SctAsciiStrCpy (KeyBuf, Key);
-	EntsCopyMem(ValueBuf, RecordValue, RecordSize);
-    Record->Key    = KeyBuf;
-    Record->Size   = RecordSize;
-	Record->Value  = ValueBuf;
-    Record->Next   = RecordListHead;
-    RecordListHead = Record;
+  if (Context->LogCount >= Context->RecordCount * 2 + CONTEXT_COMPACT_SLACK) {
+    Status = WriteRecordsToFile(Context);
   } else {
-    ValueBuf = (VOID *)EntsAllocateZeroPool (RecordSize);
-    if (ValueBuf == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto FreeAndReturn;
-    }
-    EntsFreePool(Record->Value);
-	EntsCopyMem(ValueBuf, RecordValue, RecordSize);
-	Record->Value = ValueBuf;
-	Record->Size  = RecordSize;
+    Status = WriteRecord (Context, Key, RecordSize, RecordValue);
   }
-
-  //
-  // Write all the records to file
-  //
-  Status = WriteRecordsToFile(Context, RecordListHead);
   if (EFI_ERROR(Status)) {
-    EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"WriteRecordsToFile fail - %r", Status));
-  }
-FreeAndReturn:
-  //
-  // Free the record list and return
-  //
-  while(RecordListHead != NULL) {
-    Record = RecordListHead;
-	RecordListHead = RecordListHead->Next;
-    EntsFreePool(Record->Key);
-	EntsFreePool(Record->Value);
-	EntsFreePool(Record);
+    EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Write the record fail - %r", Status));
   }
+
   return Status;
 }
 
@@ -352,48 +422,18 @@ GetRecord (
   OUT VOID                                  *RecordBuf
   )
 {
-  EFI_STATUS                                Status;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD           *RecordListHead;
   EFI_PASSIVE_TEST_CONTEXT_RECORD           *Record;
 
-  Status = ReadRecordsFromFile(Context, &RecordListHead);
-  if (EFI_ERROR(Status)) {
-  	return Status;
-  }
-
-  //
-  // Search the record with key in the record line of the contextcontainer. Notes:
-  // the records in the list are same as the ones in file
-  //
-  for (Record = RecordListHead; Record != NULL; Record = Record->Next) {
-    if (SctAsciiStrCmp (Record->Key, Key) == 0) {
-      break;
-    }
-  }
-
+  Record = *FindRecord (Context, Key);
   if (Record == NULL) {
-    Status = EFI_NOT_FOUND;
-    goto FreeAndReturn;
+    return EFI_NOT_FOUND;
   }
 
   if (*BufSize > Record->Size) {
     *BufSize = Record->Size;
   }
   EntsCopyMem(RecordBuf, Record->Value, *BufSize);
-  Status = EFI_SUCCESS;
-
-FreeAndReturn:
-  //
-  // Free the record list and return
-  //
-  while(RecordListHead != NULL) {
-    Record = RecordListHead;
-	RecordListHead = RecordListHead->Next;
-    EntsFreePool(Record->Key);
-	EntsFreePool(Record->Value);
-	EntsFreePool(Record);
-  }
-  return Status;
+  return EFI_SUCCESS;
 }
 
 STATIC
@@ -404,58 +444,24 @@ DelRecord (
   )
 {
   EFI_STATUS                                       Status;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *RecordListHead;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *Record;
-  EFI_PASSIVE_TEST_CONTEXT_RECORD                  *Tmp;
 
-  Status = ReadRecordsFromFile(Context, &RecordListHead);
+  Status = RemoveRecord (Context, Key);
   if (EFI_ERROR(Status)) {
-  	return Status;
-  }
-
-  if (RecordListHead == NULL) {
-    return EFI_NOT_FOUND;
-  } else {
-    if (SctAsciiStrCmp (Key, RecordListHead->Key) == 0) {
-      Record = RecordListHead;
-	  RecordListHead = RecordListHead->Next;
-    } else {
-      for (Record = RecordListHead; Record->Next != NULL; Record = Record->Next) {
-        if (SctAsciiStrCmp (Key, Record->Next->Key) == 0) {
-          break;
-        }
-      }
-      if(Record->Next == NULL) {
-        Status = EFI_NOT_FOUND;
-        goto FreeAndReturn;
-      } else {
-        Tmp = Record->Next;
-        Record->Next = Record->Next->Next;
-        EntsFreePool(Tmp->Key);
-        EntsFreePool(Tmp->Value);
-        EntsFreePool(Tmp);
-      }
-    }
+    return Status;
   }
 
   //
-  // Write the remain records to file
+  // Log the delete as a record of size 0
   //
-  Status = WriteRecordsToFile(Context, RecordListHead);
-  if (EFI_ERROR(Status)) {
-    EFI_ENTS_DEBUG((EFI_ENTS_D_WARNING, L"WriteRecordsToFile fail - %r", Status));
+  if (Context->LogCount >= Context->RecordCount * 2 + CONTEXT_COMPACT_SLACK) {
+    Status = WriteRecordsToFile(Context);
+  } else {
+    Status = WriteRecord (Context, Key, 0, NULL);
   }
-FreeAndReturn:
-  //
-  // Free the record list and return
-  //
-  while(RecordListHead != NULL) {
-    Record = RecordListHead;
-	RecordListHead = RecordListHead->Next;
-    EntsFreePool(Record->Key);
-	EntsFreePool(Record->Value);
-	EntsFreePool(Record);
+  if (EFI_ERROR(Status)) {
+    EFI_ENTS_DEBUG((EFI_ENTS_D_WARNING, L"Write the record fail - %r", Status));
   }
+
   return Status;
 }
 
@@ -467,7 +473,11 @@ ContextReopen (
 {
   EFI_STATUS                                       Status;
 
-  Status = Context->FileHandle->Close(Context->FileHandle);
+  //
+  // Delete closes the handle as well
+  //
+  Status = Context->FileHandle->Delete(Context->FileHandle);
+  Context->FileHandle = NULL;
   if (EFI_ERROR(Status)) {
     return Status;
   }
@@ -475,7 +485,7 @@ ContextReopen (
                                  Context->DirHandle,
                                  &Context->FileHandle,
                                  Context->FileName,
-                                 Context->Attributes,
+                                 EFI_FILE_MODE_CREATE|EFI_FILE_MODE_WRITE|EFI_FILE_MODE_READ,
                                  0
                                  );
   if (EFI_ERROR(Status)) {
@@ -486,12 +496,30 @@ ContextReopen (
   return EFI_SUCCESS;
 }
 
+STATIC
+BOOLEAN
+ContextMatch (
+  IN EFI_PASSIVE_TEST_CONTEXT                      *Context,
+  IN EFI_DEVICE_PATH_PROTOCOL                      *DevicePath,
+  IN CHAR16                                        *FileName
+  )
+{
+  UINTN                                            Size;
+
+  if ((Context == NULL) || (EntsStrCmp (Context->FileName, FileName) != 0)) {
+    return FALSE;
+  }
+
+  Size = SctDevicePathSize (DevicePath);
+  return (BOOLEAN) ((Size == SctDevicePathSize (Context->DevicePath)) &&
+                    (EntsCompareMem (Context->DevicePath, DevicePath, Size) == 0));
+}
+
 STATIC
 EFI_STATUS
 ContextOpen (
   IN EFI_DEVICE_PATH_PROTOCOL                      *DevicePath,
   IN CHAR16                                        *FileName,
-  IN UINT64                                        Attributes,
   OUT EFI_PASSIVE_TEST_CONTEXT                     **Context
   )
 {
@@ -500,6 +528,7 @@ ContextOpen (
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL                  *Vol;
   EFI_FILE_HANDLE                                  RootDir;
   EFI_FILE_HANDLE                                  FileHandle;
+  EFI_DEVICE_PATH_PROTOCOL                         *RemainingDevicePath;
 
   //
   // Check the parameter
@@ -508,17 +537,33 @@ ContextOpen (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The resident context is used as long as it is the same file
+  //
+  if (ContextMatch (mContext, DevicePath, FileName)) {
+    *Context = mContext;
+    return EFI_SUCCESS;
+  }
+  PassiveTestContextSync ();
+
   *Context = (EFI_PASSIVE_TEST_CONTEXT *)EntsAllocateZeroPool(sizeof(EFI_PASSIVE_TEST_CONTEXT));
   if (*Context == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
+  (*Context)->DevicePath = EntsDuplicateDevicePath (DevicePath);
+  if ((*Context)->DevicePath == NULL) {
+    EntsFreePool(*Context);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
   //
   // Open the file if not exist create a new
   //
+  RemainingDevicePath = DevicePath;
   Status = gntBS->LocateDevicePath (
                     &gEfiSimpleFileSystemProtocolGuid,
-                    &DevicePath,
+                    &RemainingDevicePath,
                     &DeviceHandle
                     );
   if (EFI_ERROR(Status)) {
@@ -543,7 +588,7 @@ ContextOpen (
                       RootDir,
                       &FileHandle,
                       FileName,
-                      Attributes,
+                      EFI_FILE_MODE_WRITE|EFI_FILE_MODE_READ,
                       0
                       );
   if (EFI_ERROR(Status)) {
@@ -554,10 +599,20 @@ ContextOpen (
   (*Context)->DirHandle    = RootDir;
   (*Context)->FileHandle   = FileHandle;
   EntsStrCpy((*Context)->FileName, FileName);
-  (*Context)->Attributes   = Attributes;
 
+  //
+  // Load the records, the file position is left at the end of the log
+  //
+  Status = ReadRecordsFromFile (*Context);
+  if (EFI_ERROR(Status)) {
+    ContextClose (*Context);
+    return Status;
+  }
+
+  mContext = *Context;
   return EFI_SUCCESS;
 ContextOpenError:
+  EntsFreePool((*Context)->DevicePath);
   EntsFreePool(*Context);
   return Status;
 }
@@ -580,11 +635,47 @@ ContextClose (
     Context->DirHandle->Close(Context->DirHandle);
   }
 
+  FreeRecords (Context);
+  EntsFreePool(Context->DevicePath);
   EntsFreePool(Context);
 
+  if (mContext == Context) {
+    mContext = NULL;
+  }
+
   return ;
 }
 
+EFI_STATUS
+PassiveTestContextSync (
+  VOID
+  )
+{
+  EFI_STATUS                                       Status;
+
+  //
+  // Nothing is resident
+  //
+  if (mContext == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Flush the log and drop the resident context: an other image may change
+  // the file before the next access, or the system is about to be reset
+  //
+  Status = EFI_SUCCESS;
+  if (mContext->FileHandle != NULL) {
+    Status = mContext->FileHandle->Flush(mContext->FileHandle);
+    if (EFI_ERROR(Status)) {
+      EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"PassiveTestContextSync: Flush %s fail - %r", mContext->FileName, Status));
+    }
+  }
+
+  ContextClose (mContext);
+  return Status;
+}
+
 EFI_STATUS
 PassiveTestContextCreate (
   IN EFI_DEVICE_PATH_PROTOCOL                      *DevicePath,
@@ -607,6 +698,13 @@ PassiveTestContextCreate (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The resident records are of the old file
+  //
+  if (ContextMatch (mContext, DevicePath, FileName)) {
+    ContextClose (mContext);
+  }
+
   //
   // Open the file if not exist create a new
   //
@@ -692,6 +790,13 @@ PassiveTestContextDelete (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The resident records are of the old file
+  //
+  if (ContextMatch (mContext, DevicePath, FileName)) {
+    ContextClose (mContext);
+  }
+
   //
   // Open the file if not exist create a new
   //
@@ -762,7 +867,7 @@ SetContextRecord (
   }
 
   Unicode2Ascii(AsciiKey, Key);
-  if (SctAsciiStrLen (AsciiKey) + Size + 1 > MAX_RECORD_LEN) {
+  if (SctAsciiStrLen (AsciiKey) + sizeof(UINTN) + Size + 2 > MAX_RECORD_LEN) {
     return EFI_INVALID_PARAMETER;
   }
 
@@ -772,12 +877,11 @@ SetContextRecord (
   }
 
   //
-  // Open the file
+  // Open the file, or take the resident context
   //
   Status = ContextOpen (
              DevicePath, 
              FileName, 
-             EFI_FILE_MODE_WRITE|EFI_FILE_MODE_READ,
              &Context
              );
   if (EFI_ERROR(Status)) {
@@ -812,7 +916,6 @@ SetContextRecord (
     }
   }
 
-  ContextClose(Context);
   return Status;
 }
 
@@ -840,12 +943,11 @@ GetContextRecord (
   Unicode2Ascii(AsciiKey, Key);
 
   //
-  // Open the file
+  // Open the file, or take the resident context
   //
   Status = ContextOpen (
              DevicePath, 
              FileName, 
-             EFI_FILE_MODE_READ,
              &Context
              );
   if (EFI_ERROR(Status)) {
@@ -861,10 +963,8 @@ GetContextRecord (
              );
   if (EFI_ERROR(Status)) {
     EFI_ENTS_DEBUG((EFI_ENTS_D_WARNING, L"GetContextRecord: GetRecord Key:%s - %r", Key, Status));
-    ContextClose(Context);
 	return Status;
   }
 
-  ContextClose(Context);
   return EFI_SUCCESS;
 }
@@ -36,7 +36,15 @@ Abstract:
 // See RFC 2349
 //
 #define EFTP_MAX_TIMEOUT                255
-#define EFTP_SUPPORTED_OPTIONS_COUNT    3
+//
+// "windowsize" of RFC 7440. A window is acknowledged with a bitmap of the
+// blocks received after the acknowledged one, so it is bounded by the
+// bits of the bitmap
+//
+#define EFTP_DEFAULT_WINDOWSIZE         1
+#define EFTP_MAX_WINDOWSIZE             64
+#define EFTP_WINDOW_BITMAP_SIZE         (EFTP_MAX_WINDOWSIZE / 8)
+#define EFTP_SUPPORTED_OPTIONS_COUNT    4
 #define EFTP_UNSUPPORTED_OPTIONS_COUNT  6
 //
 // ms
@@ -29,13 +29,16 @@ CHAR8 *mSupportedOptions[EFTP_SUPPORTED_OPTIONS_COUNT] = {
   "timeout",
   "blksize",
   "tsize",
+  "windowsize",
 };
 
 CHAR8 *mUnsupportedOptions[EFTP_UNSUPPORTED_OPTIONS_COUNT] = {
   "restart",
   "session",
   "pktdelay",
-  "stream""multicast""bigblk#",
+  "stream",
+  "multicast",
+  "bigblk#",
 };
 
 STATIC
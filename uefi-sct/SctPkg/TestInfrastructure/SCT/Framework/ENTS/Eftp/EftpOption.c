@@ -44,6 +44,13 @@ ExtractBlksize (
   CHAR8           *Str
   );
 
+STATIC
+EFI_STATUS
+ExtractWindowsize (
+  IN EFTP_OPTION  *Opt,
+  CHAR8           *Str
+  );
+
 STATIC EFTP_OPTIONOBJ mOptionObjs[] = {
   {
     EFTP_OPTION_TSIZE,
@@ -60,6 +67,11 @@ STATIC EFTP_OPTIONOBJ mOptionObjs[] = {
     "blksize",
     ExtractBlksize
   },
+  {
+    EFTP_OPTION_WINDOWSIZE,
+    "windowsize",
+    ExtractWindowsize
+  },
   {
     0,
     NULL,
@@ -95,6 +107,7 @@ Returns:
   Opt->Tsize        = 0;
   Opt->Pktdelay     = 0;
   Opt->NBlkInStream = 1;
+  Opt->WindowSize   = EFTP_DEFAULT_WINDOWSIZE;
   Opt->Exist        = 0;
 }
 
@@ -437,6 +450,47 @@ Returns:
 
 }
 
+STATIC
+EFI_STATUS
+ExtractWindowsize (
+  IN EFTP_OPTION  *Opt,
+  CHAR8           *Str
+  )
+/*++
+
+Routine Description:
+
+  Extract the windowsize option.
+
+Arguments:
+
+  Opt  - Eftp option structure.
+  Str  - The windowsize's option value
+
+Returns:
+
+  EFI_INVALID_PARAMETER  - The string isn't well-formed.
+  EFI_SUCCESS            - Successfully extracted.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT64      I;
+
+  ASSERT (Opt && Str);
+
+  Status = StrToUint64 (Str, &I);
+
+  if (EFI_ERROR (Status) || (I < 1) || (I > EFTP_MAX_WINDOWSIZE)) {
+    return EFI_INVALID_PARAMETER;
+
+  }
+
+  Opt->WindowSize = (UINT16) I;
+  return EFI_SUCCESS;
+
+}
+
 EFI_STATUS
 EftpCheckOption (
   IN EFI_EFTP_OPTION             *OptionList,
@@ -481,14 +535,14 @@ Returns:
 
     }
 
-    for (Index2 = 0; Index2 < EFTP_OPTION_MAX; Index2++) {
+    for (Index2 = 0; mOptionObjs[Index2].Name != NULL; Index2++) {
       if (NetAsciiStrCaseCmp (mOptionObjs[Index2].Name, OptionList[Index1].OptionStr) != 0) {
         continue;
       }
       //
       // in RRQ multicast option is zero, so it is invalid. Skip this extract
       //
-      if (Index2 == EFTP_OPTION_MCAST) {
+      if (mOptionObjs[Index2].Index == EFTP_OPTION_MCAST) {
         continue;
       }
 
@@ -565,7 +619,7 @@ Returns:
   Status = EFI_SUCCESS;
 
   for (Loop = 0; Loop < NOption; Loop++) {
-    for (Index = 0; Index < EFTP_OPTION_MAX; Index++) {
+    for (Index = 0; mOptionObjs[Index].Name != NULL; Index++) {
 
       if (NetAsciiStrCaseCmp (mOptionObjs[Index].Name, OptionList[Loop].OptionStr) != 0) {
         continue;
@@ -578,7 +632,7 @@ Returns:
         goto OnExit;
       }
 
-      Option->Exist |= (UINT64) (1 << Index);
+      Option->Exist |= (UINT64) (1 << mOptionObjs[Index].Index);
       break;
     }
   }
@@ -586,11 +640,11 @@ Returns:
   //
   // Verify that all the options coexist happy
   //
-  for (Index = 0; Index < EFTP_OPTION_MAX; Index++) {
+  for (Index = 0; mOptionObjs[Index].Name != NULL; Index++) {
     //
     // Only verify the options that DOES exists in the packet
     //
-    if (!(Option->Exist & (UINT64) (1 << Index)) || (mOptionObjs[Index].Verify == NULL)) {
+    if (!(Option->Exist & (UINT64) (1 << mOptionObjs[Index].Index)) || (mOptionObjs[Index].Verify == NULL)) {
       continue;
     }
 
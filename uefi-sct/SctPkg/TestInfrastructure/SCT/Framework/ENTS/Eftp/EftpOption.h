@@ -40,6 +40,7 @@ enum {
   EFTP_OPTION_BIGBLKNO,
   EFTP_OPTION_STREAM,
   EFTP_OPTION_PKTDELAY,
+  EFTP_OPTION_WINDOWSIZE,
   EFTP_OPTION_MAX,
 };
 
@@ -52,6 +53,7 @@ typedef struct _EFTP_OPTION {
   UINT64              Tsize;
   UINT16              Pktdelay;
   UINT16              NBlkInStream;
+  UINT16              WindowSize;
   UINT64              Exist;  // This is a flag marking whether an option exists in the packet
 } EFTP_OPTION;
 
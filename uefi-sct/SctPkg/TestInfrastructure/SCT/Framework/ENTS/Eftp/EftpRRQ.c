@@ -44,6 +44,14 @@ EftpRrqFlushLostBlock (
   IN EFTP_IO_PRIVATE  *Private
   );
 
+STATIC
+EFI_STATUS
+EftpRrqMarkBlk (
+  IN EFTP_IO_PRIVATE  *Private,
+  IN UINT64           BlkNo,
+  OUT BOOLEAN         *AckNow
+  );
+
 STATIC
 BOOLEAN
 EftpListIntegrityCheck (
@@ -148,6 +156,7 @@ Returns:
   EFTP_DEBUG_VERBOSE ((L"EftpInitRrqState: initialize Rrq role to ROLE_INIT\n"));
   EftpRrqChangeRole (EFTP_RRQ_ROLE_INIT, Rrq);
   LIST_INIT (&Rrq->LostPacketList);
+  Rrq->BufferSize = Private->Token->BufferSize;
 
   return Rrq;
 
@@ -913,7 +922,6 @@ Returns:
   return EFI_SUCCESS;
 
 }
-#if 0
 STATIC
 EFI_STATUS
 EftpRrqInitRcvOack (
@@ -976,7 +984,17 @@ Returns:
       goto SendErr;
     }
 
-    Private->Timeout = Opt->Timeout;
+    if (Opt->Exist & (UINT64) (1 << EFTP_OPTION_TIMEOUT)) {
+      Private->Timeout = Opt->Timeout;
+    }
+
+    //
+    // With the file size known the last block is acknowledged at once,
+    // even when it is a full one
+    //
+    if (Opt->Exist & (UINT64) (1 << EFTP_OPTION_TSIZE)) {
+      Private->RrqState->EndBlkNo = SctDivU64x32 (Opt->Tsize + Opt->BlkSize - 1, Opt->BlkSize, NULL);
+    }
 
     //
     // Begin  downloading, or normal tftp procedure
@@ -1042,35 +1060,6 @@ SilentShutdown:
   return EFI_ABORTED;
 
 }
-#else
-STATIC
-EFI_STATUS
-EftpRrqInitRcvOack (
-  IN EFTP_IO_PRIVATE   *Private,
-  IN EFI_EFTP_PACKET   *Packet,
-  IN UINT32            PacketLen
-  )
-/*++
-Routine Description:
-
-  The OACK packet process routine when in INIT role.
-
-Arguments:
-
-  Private   - Eftp instance private data
-  Packet    - Packet received 
-  PacketLen - Length of the received packet
-  
-Returns:
-
-  EFI_ABORTED  - something is wrong
-
---*/
-{
-  ASSERT (Private && Private->RrqState && Packet);
-  return EFI_ABORTED;
-}
-#endif
 
 STATIC
 VOID
@@ -1200,6 +1189,7 @@ Returns:
   EFTP_ERRINFO        Err;
   EFI_STATUS          Status;
   BOOLEAN             Copy;
+  BOOLEAN             AckNow;
   UINT64              BlkNo;
 
   ASSERT (Private && Private->RrqState && Packet);
@@ -1224,6 +1214,64 @@ Returns:
     break;
 
   case EFTP_RRQ_ESTABLISHED:
+    if (Opt->WindowSize > 1) {
+      //
+      // Windowed download: blocks are saved as they come, and an ACK is
+      // sent for a new hole, a filled hole, the end of the window or the last
+      // block
+      //
+      Status = EftpRrqMarkBlk (Private, BlkNo, &AckNow);
+      if (Status == EFI_NOT_FOUND) {
+#ifdef _EFTP_STAT_
+        Private->DroppedPkts++;
+#endif
+        return EFI_SUCCESS;
+      }
+
+      if (Status == EFI_ALREADY_STARTED) {
+        //
+        // A block received before. Only the end of the window is resent
+        // when the server missed our ACK, other ones are late resends that
+        // must not be answered, or the server resends them again
+        //
+        AckNow = (BOOLEAN) (BlkNo >= Rrq->WindowEndBlkNo);
+      } else if (EFI_ERROR (Status)) {
+        EFTP_DEBUG_ERROR ((L"EftpRrqActiveRcvData: failed to record the block\n"));
+        Err.Code  = EFI_EFTP_ERRORCODE_NOT_DEFINED;
+        Err.Desc  = "Out of resources";
+        goto SendErr;
+      } else {
+        Status = EftpRrqSaveBlk (Private, Packet, PacketLen);
+        if (EFI_ERROR (Status)) {
+          EFTP_DEBUG_ERROR ((L"EftpRrqActiveRcvData: failed to save the block\n"));
+          Err.Code  = EFI_EFTP_ERRORCODE_DISK_FULL;
+          Err.Desc  = (Private->Result == EFI_ABORTED ? "User cancelled download" : "Disk full");
+          goto SendErr;
+        }
+
+        if (PacketLen < (UINTN) (Opt->BlkSize + EFTP_HEADER_LEN)) {
+          Rrq->EndBlkNo = BlkNo;
+        }
+
+        if ((BlkNo >= Rrq->WindowEndBlkNo) ||
+            ((Rrq->EndBlkNo != 0) && (Private->NextBlkNo > Rrq->EndBlkNo))) {
+          AckNow = TRUE;
+        }
+      }
+
+      if (AckNow) {
+        Status = EftpRrqSendAck (Private, Private->NextBlkNo - 1);
+        if (EFI_ERROR (Status)) {
+          EFTP_DEBUG_ERROR ((L"EftpRrqActiveRcvData: failed to send the ack, silent shutdown\n"));
+
+          goto SilentShutdown;
+        }
+      }
+
+      EftpSetTimer (Private, Private->Timeout, 0);
+      break;
+    }
+
     if (BlkNo != Private->NextBlkNo) {
       EFTP_DEBUG_ERROR (
         (L"EftpRrqActiveRcvData: ignore a unexpected data block(%ld/%ld)\n",
@@ -1463,6 +1511,9 @@ Returns:
 
 --*/
 {
+  UINT32      NOption;
+  EFI_STATUS  Status;
+
   ASSERT (Private && Private->RrqState && Packet);
 
   switch (Private->State) {
@@ -1472,6 +1523,25 @@ Returns:
     break;
 
   case EFTP_RRQ_ESTABLISHED:
+    //
+    // The server repeats its option OACK while our ACK0 is lost. An OACK
+    // without option pairs is the end of the file.
+    //
+    if ((Private->NextBlkNo == 1) &&
+        !EFI_ERROR (EftpGetOptions (&Private->Eftp, PacketLen, Packet, &NOption, NULL)) &&
+        (NOption != 0)
+        ) {
+      Status = EftpRrqSendAck (Private, 0);
+      if (EFI_ERROR (Status)) {
+        EFTP_DEBUG_ERROR ((L"EftpRrqActiveRcvOack: failed to resend ACK0\n"));
+
+        RRQ_SILENT_SHUTDOWN (Private);
+        return EFI_ABORTED;
+      }
+
+      return EFI_SUCCESS;
+    }
+
     Private->Eof        = TRUE;
     Private->Result     = EFI_SUCCESS;
     RRQ_LOUD_SHUTDOWN (Private);
@@ -1544,6 +1614,22 @@ Returns:
 
     }
 
+    //
+    // In a window the blocks received since the last ACK may have moved it
+    // on, so acknowledge afresh rather than repeat the last ACK
+    //
+    if (Private->Option.WindowSize > 1) {
+      Status = EftpRrqSendAck (Private, Private->NextBlkNo - 1);
+      if (EFI_ERROR (Status)) {
+        EFTP_DEBUG_ERROR ((L"EftpRrqActiveTimer: failed to send the ack, init silent shutdown\n"));
+
+        goto SilentShutdown;
+      }
+
+      EftpSetTimer (Private, Private->Timeout, 0);
+      return ;
+    }
+
     Buf = Private->LastCtrl;
     ASSERT (Buf && (Buf->RefCnt >= 1));
 
@@ -1644,8 +1730,6 @@ Returns:
 
 }
 
-#define MAX_REAL_FILE_SIZE    10485760
-
 STATIC
 EFI_STATUS
 EftpRrqSaveBlk (
@@ -1709,7 +1793,7 @@ Returns:
 
     Start   = SctMultU64x32 (BlkNo - 1, Opt->BlkSize);
 
-    if (Start + DataLen > MAX_REAL_FILE_SIZE) {
+    if (Start + DataLen > Private->RrqState->BufferSize) {
       EFTP_DEBUG_ERROR ((L"EftpRrqSaveBlk: User provided buffer is too small.\n"));
 
       Private->Token->BufferSize  = (UINT64) -1;
@@ -1723,7 +1807,11 @@ Returns:
       DataLen
       );
 
-    if (DataLen <= Opt->BlkSize) {
+    //
+    // Blocks of a window may come out of order, the size ends with the
+    // highest one
+    //
+    if (BlkNo >= Private->RrqState->HighBlkNo) {
       (Private->Token->BufferSize) = Start + DataLen;
     }
 
@@ -1757,14 +1845,29 @@ Returns:
 
 --*/
 {
-  EFTP_PACKET_BUFFER  *Buf;
-  EFI_EFTP_PACKET     *Packet;
-  EFI_STATUS          Status;
-  UINT32              Len;
+  EFTP_PACKET_BUFFER    *Buf;
+  EFI_EFTP_PACKET       *Packet;
+  EFI_STATUS            Status;
+  UINT32                Len;
+  EFTP_RRQ_STATE        *Rrq;
+  EFTP_LOSTBLOCK_ENTRY  *Lost;
+  NET_LIST_ENTRY        *Entry;
+  UINT8                 *Map;
+  UINT64                Index;
 
-  ASSERT (Private);
+  ASSERT (Private && Private->RrqState);
 
+  Rrq = Private->RrqState;
   Len = EFTP_HEADER_LEN;
+
+  //
+  // With holes in the window the bitmap of the blocks received after BlkNo
+  // follows, bit i for block BlkNo + 1 + i
+  //
+  if (Rrq->LostListSize != 0) {
+    Len += EFTP_WINDOW_BITMAP_SIZE;
+  }
+
   Buf = EftpAllocPacket (Len);
 
   if (Buf == NULL) {
@@ -1792,6 +1895,24 @@ Returns:
     return NULL;
   }
 
+  if (Len > EFTP_HEADER_LEN) {
+    Map = (UINT8 *) Packet + EFTP_HEADER_LEN;
+    NetZeroMem (Map, EFTP_WINDOW_BITMAP_SIZE);
+
+    for (Index = BlkNo + 1; (Index <= Rrq->HighBlkNo) && (Index <= BlkNo + EFTP_MAX_WINDOWSIZE); Index++) {
+      Map[(UINTN) (Index - BlkNo - 1) / 8] |= (UINT8) (1 << ((UINTN) (Index - BlkNo - 1) % 8));
+    }
+
+    LIST_FOR_EACH (Entry, &Rrq->LostPacketList) {
+      Lost = LIST_ENTRY (Entry, EFTP_LOSTBLOCK_ENTRY, Entry);
+      for (Index = Lost->Start; (Index <= Lost->End) && (Index <= BlkNo + EFTP_MAX_WINDOWSIZE); Index++) {
+        if (Index > BlkNo) {
+          Map[(UINTN) (Index - BlkNo - 1) / 8] &= (UINT8) ~(1 << ((UINTN) (Index - BlkNo - 1) % 8));
+        }
+      }
+    }
+  }
+
   Packet->Hdr.OpCode    = HTONS (EFI_EFTP_OPCODE_ACK);
   Packet->Hdr.CodeVar   = 0;
   Packet->Hdr.Length    = HTONS ((UINT16) Len);
@@ -1882,7 +2003,8 @@ Returns:
 
   }
 
-  Private->LastCtrl = Buf;
+  Private->LastCtrl                   = Buf;
+  Private->RrqState->WindowEndBlkNo   = BlkNo + Private->Option.WindowSize;
 
   return EFI_SUCCESS;
 }
@@ -1930,6 +2052,115 @@ Returns:
   return EFI_SUCCESS;
 }
 
+STATIC
+EFI_STATUS
+EftpRrqMarkBlk (
+  IN EFTP_IO_PRIVATE  *Private,
+  IN UINT64           BlkNo,
+  OUT BOOLEAN         *AckNow
+  )
+/*++
+
+Routine Description:
+
+  Record a block received in a window. A block beyond the highest one
+  received makes the blocks between them lost, a lost block fills its
+  hole. NextBlkNo is moved to the first block missing.
+
+Arguments:
+
+  Private   : The instance's private data
+  BlkNo     : The block number received
+  AckNow    : Set to TRUE when a hole appears or the last one is filled
+
+Returns:
+
+  EFI_SUCCESS          : The block is new and recorded
+  EFI_ALREADY_STARTED  : The block was received before
+  EFI_NOT_FOUND        : The block is beyond the window or the file
+  EFI_OUT_OF_RESOURCES : Failed to allocate a lost block entry
+
+--*/
+{
+  EFTP_RRQ_STATE        *Rrq;
+  EFTP_LOSTBLOCK_ENTRY  *Lost;
+  EFTP_LOSTBLOCK_ENTRY  *Split;
+  NET_LIST_ENTRY        *Entry;
+
+  Rrq     = Private->RrqState;
+  *AckNow = FALSE;
+
+  if ((BlkNo >= Private->NextBlkNo + EFTP_MAX_WINDOWSIZE) ||
+      ((Rrq->EndBlkNo != 0) && (BlkNo > Rrq->EndBlkNo))
+      ) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (BlkNo > Rrq->HighBlkNo) {
+    if (BlkNo > Rrq->HighBlkNo + 1) {
+      Lost = NetAllocatePool (sizeof (EFTP_LOSTBLOCK_ENTRY));
+      if (Lost == NULL) {
+        Private->Result = EFI_OUT_OF_RESOURCES;
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      Lost->Start = Rrq->HighBlkNo + 1;
+      Lost->End   = BlkNo - 1;
+      LIST_INSERT_TAIL (&Rrq->LostPacketList, &Lost->Entry);
+
+      Rrq->LostListSize += (UINT32) (Lost->End - Lost->Start + 1);
+      *AckNow = TRUE;
+    }
+
+    Rrq->HighBlkNo = BlkNo;
+  } else {
+    Lost = NULL;
+    LIST_FOR_EACH (Entry, &Rrq->LostPacketList) {
+      Lost = LIST_ENTRY (Entry, EFTP_LOSTBLOCK_ENTRY, Entry);
+      if ((BlkNo >= Lost->Start) && (BlkNo <= Lost->End)) {
+        break;
+      }
+    }
+
+    if (Entry == &Rrq->LostPacketList) {
+      return EFI_ALREADY_STARTED;
+    }
+
+    if (Lost->Start == Lost->End) {
+      LIST_REMOVE_ENTRY (&Lost->Entry);
+      NetFreePool (Lost);
+    } else if (BlkNo == Lost->Start) {
+      Lost->Start++;
+    } else if (BlkNo == Lost->End) {
+      Lost->End--;
+    } else {
+      Split = NetAllocatePool (sizeof (EFTP_LOSTBLOCK_ENTRY));
+      if (Split == NULL) {
+        Private->Result = EFI_OUT_OF_RESOURCES;
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      Split->Start  = BlkNo + 1;
+      Split->End    = Lost->End;
+      Lost->End     = BlkNo - 1;
+      LIST_INSERT_AFTER_ENTRY (&Lost->Entry, &Split->Entry);
+    }
+
+    Rrq->LostListSize--;
+    if (Rrq->LostListSize == 0) {
+      *AckNow = TRUE;
+    }
+  }
+
+  if (LIST_IS_EMPTY (&Rrq->LostPacketList)) {
+    Private->NextBlkNo = Rrq->HighBlkNo + 1;
+  } else {
+    Private->NextBlkNo = LIST_HEAD (&Rrq->LostPacketList, EFTP_LOSTBLOCK_ENTRY, Entry)->Start;
+  }
+
+  return EFI_SUCCESS;
+}
+
 STATIC
 BOOLEAN
 EftpListIntegrityCheck (
@@ -100,6 +100,15 @@ typedef struct _EFTP_RRQ_STATE {
   UINT32          LostListSize;
 
   EFTP_RRQ_ROLE   Role;           // current role, being init, active, passive or smart
+
+  //
+  // Windowed download. LostPacketList holds the missing blocks below
+  // HighBlkNo, and LostListSize counts them.
+  //
+  UINT64          HighBlkNo;      // highest block received
+  UINT64          EndBlkNo;       // last block of the file, 0 until known
+  UINT64          WindowEndBlkNo; // last block the server sends before an ACK
+  UINT64          BufferSize;     // size of the user's buffer
 } EFTP_RRQ_STATE;
 
 //
@@ -61,6 +61,21 @@ EftpWrqBuildData (
   IN UINT64           BlkNo
   );
 
+STATIC
+EFI_STATUS
+EftpWrqSendBlk (
+  IN EFTP_IO_PRIVATE  *Private,
+  IN UINT64           BlkNo
+  );
+
+STATIC
+EFI_STATUS
+EftpWrqRcvWindowAck (
+  IN EFTP_IO_PRIVATE  *Private,
+  IN EFI_EFTP_PACKET  *Packet,
+  IN UINTN            PacketLen
+  );
+
 EFTP_WRQ_STATE *
 EftpInitWrqState (
   IN EFTP_IO_PRIVATE*Private
@@ -334,7 +349,12 @@ Returns:
   //
   switch (OpCode) {
   case EFI_EFTP_OPCODE_ACK:
-    if (PacketLen != (UINTN) (EFTP_HEADER_LEN)) {
+    //
+    // In a window the ACK may carry the bitmap of the blocks received
+    //
+    if ((PacketLen != (UINTN) (EFTP_HEADER_LEN)) &&
+        ((Private->Option.WindowSize <= 1) || (PacketLen != (UINTN) (EFTP_HEADER_LEN + EFTP_WINDOW_BITMAP_SIZE)))
+        ) {
       EFTP_DEBUG_VERBOSE ((L"EftpWrqRxCallback: Got a bad ACK, ignore it!\n"));
       Status = EFI_SUCCESS;
       break;
@@ -576,6 +596,24 @@ Returns:
       goto SendErr;
     }
 
+    //
+    // In a window resend the first block not acknowledged, and let the
+    // holes reported afterwards be resent again
+    //
+    if (Private->Option.WindowSize > 1) {
+      Private->WrqState->ResendBlkNo = Private->WrqState->AckedBlkNo;
+
+      Status = EftpWrqSendBlk (Private, Private->WrqState->AckedBlkNo + 1);
+      if (EFI_ERROR (Status)) {
+        EFTP_DEBUG_ERROR ((L"EftpWrqTimer: failed to retransmit the data, init silent shutdown\n"));
+
+        goto SilentShutdown;
+      }
+
+      EftpSetTimer (Private, Private->Timeout, 0);
+      break;
+    }
+
     ASSERT (Private->WrqState && Private->WrqState->LastData);
 
     Buf = Private->WrqState->LastData;
@@ -695,6 +733,10 @@ Returns:
   // Fall through to send a data packet
   //
   case EFTP_WRQ_ESTABLISHED:
+    if (Opt->WindowSize > 1) {
+      return EftpWrqRcvWindowAck (Private, Packet, PacketLen);
+    }
+
     if (AckNo != Private->NextBlkNo - 1) {
       return EFI_SUCCESS;
 
@@ -934,7 +976,34 @@ Returns:
 
     }
 
-    Private->Timeout  = Private->Option.Timeout;
+    //
+    // Blocks of a window are resent out of order, they can't be taken from
+    // PacketNeeded which hands them out one after the other
+    //
+    if ((Private->Option.WindowSize > 1) && (Private->Token->Buffer == NULL)) {
+      EFTP_DEBUG_ERROR ((L"EftpWrqRcvOack: windowsize needs the data in the token's buffer\n"));
+
+      Err.Code  = EFI_EFTP_ERRORCODE_ILLEGAL_OPERATION;
+      Err.Desc  = "Windowsize not supported";
+
+      Status    = EftpSendError (Private, &Err, EftpWrqTxCallback);
+
+      if (EFI_ERROR (Status)) {
+        WRQ_SILENT_SHUTDOWN (Private);
+        return EFI_DEVICE_ERROR;
+
+      }
+
+      Private->Result = EFI_UNSUPPORTED;
+      WRQ_LOUD_SHUTDOWN (Private);
+      return EFI_SUCCESS;
+
+    }
+
+    if (Private->Option.Exist & (UINT64) (1 << EFTP_OPTION_TIMEOUT)) {
+      Private->Timeout = Private->Option.Timeout;
+    }
+
     Private->State    = EFTP_WRQ_ESTABLISHED;
 
     //
@@ -1173,6 +1242,184 @@ Returns:
 
 }
 
+STATIC
+EFI_STATUS
+EftpWrqSendBlk (
+  IN EFTP_IO_PRIVATE  *Private,
+  IN UINT64           BlkNo
+  )
+/*++
+
+Routine Description:
+
+  Build and send the data packet of a block, and keep it as the last data
+
+Arguments:
+
+  Private : Eftp instance private data
+  BlkNo   : Block number of the data to send
+
+Returns:
+
+  EFI_ABORTED : Failed to build the data packet
+  EFI_SUCCESS : The data packet is sent
+  Others      : Failed to send the data packet
+
+--*/
+{
+  EFTP_PACKET_BUFFER  *Buf;
+  EFI_STATUS          Status;
+
+  Buf = EftpWrqBuildData (Private, BlkNo);
+  if (Buf == NULL) {
+    EFTP_DEBUG_ERROR ((L"EftpWrqSendBlk: failed to retrieve data, EftpWrqBuildData returns%r\n", Private->Result));
+    return EFI_ABORTED;
+  }
+
+  Status = EftpSendPacket (Private, Buf);
+  if (EFI_ERROR (Status)) {
+    EFTP_DEBUG_ERROR ((L"EftpWrqSendBlk: failed to send data block, EftpSendPacket returns%r\n", Status));
+
+    EftpReleasePacket (Buf);
+    return Status;
+  }
+
+  if (Private->WrqState->LastData) {
+    EftpReleasePacket (Private->WrqState->LastData);
+
+  }
+
+  Private->WrqState->LastData = Buf;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EftpWrqRcvWindowAck (
+  IN EFTP_IO_PRIVATE  *Private,
+  IN EFI_EFTP_PACKET  *Packet,
+  IN UINTN            PacketLen
+  )
+/*++
+
+Routine Description:
+
+  Process an ACK of the windowed upload. The ACK acknowledges every block
+  up to its block number; its optional bitmap tells which of the following
+  blocks the server has, so the holes below the highest of them are
+  resent. The window is then filled up with new blocks. A repeated ACK
+  that makes nothing to send resends the holes, or the first block not
+  acknowledged, again.
+
+Arguments:
+
+  Private : Eftp private instance data
+  Packet  : Packet received.
+  PacketLen : The length of the received packet
+
+Returns:
+
+  EFI_SUCCESS : Packet is OK, and the instance is willing to receive another packet
+  EFI_ABORTED : The instance is about to finish, and don't start receive again
+
+--*/
+{
+  EFTP_WRQ_STATE  *Wrq;
+  UINT8           *Map;
+  UINT64          AckNo;
+  UINT64          Holes[EFTP_MAX_WINDOWSIZE];
+  UINTN           NHole;
+  UINTN           NSent;
+  UINTN           Index;
+  INTN            High;
+  BOOLEAN         Repeated;
+  EFI_STATUS      Status;
+
+  Wrq   = Private->WrqState;
+  AckNo = NTOHS (Packet->Ack.Block);
+
+  if ((AckNo < Wrq->AckedBlkNo) || (AckNo >= Private->NextBlkNo)) {
+    return EFI_SUCCESS;
+  }
+
+  Repeated        = (BOOLEAN) (AckNo == Wrq->AckedBlkNo);
+  Wrq->AckedBlkNo = AckNo;
+
+  if (Private->Eof && (AckNo == Private->LastBlkNo)) {
+    EFTP_DEBUG_VERBOSE ((L"EftpWrqRcvWindowAck: successfully uploaded, Cong\n"));
+
+    Private->Result = EFI_SUCCESS;
+    WRQ_SILENT_SHUTDOWN (Private);
+    return EFI_ABORTED;
+  }
+
+  NHole = 0;
+  if (PacketLen >= (UINTN) (EFTP_HEADER_LEN + EFTP_WINDOW_BITMAP_SIZE)) {
+    Map = (UINT8 *) Packet + EFTP_HEADER_LEN;
+    for (High = EFTP_MAX_WINDOWSIZE - 1; High >= 0; High--) {
+      if (Map[High / 8] & (1 << (High % 8))) {
+        break;
+      }
+    }
+
+    for (Index = 0; (INTN) Index < High; Index++) {
+      if (!(Map[Index / 8] & (1 << (Index % 8)))) {
+        Holes[NHole++] = AckNo + 1 + Index;
+      }
+    }
+  }
+
+  NSent = 0;
+  for (Index = 0; Index < NHole; Index++) {
+    if (Holes[Index] <= Wrq->ResendBlkNo) {
+      continue;
+    }
+
+    Status = EftpWrqSendBlk (Private, Holes[Index]);
+    if (EFI_ERROR (Status)) {
+      goto SilentShutdown;
+    }
+
+    Wrq->ResendBlkNo = Holes[Index];
+    NSent++;
+  }
+
+  while (!Private->Eof && (Private->NextBlkNo <= AckNo + Private->Option.WindowSize)) {
+    Status = EftpWrqSendBlk (Private, Private->NextBlkNo);
+    if (EFI_ERROR (Status)) {
+      goto SilentShutdown;
+    }
+
+    Private->NextBlkNo++;
+    NSent++;
+  }
+
+  if ((NSent == 0) && Repeated) {
+    for (Index = 0; Index < NHole; Index++) {
+      Status = EftpWrqSendBlk (Private, Holes[Index]);
+      if (EFI_ERROR (Status)) {
+        goto SilentShutdown;
+      }
+
+      NSent++;
+    }
+
+    if (NSent == 0) {
+      Status = EftpWrqSendBlk (Private, AckNo + 1);
+      if (EFI_ERROR (Status)) {
+        goto SilentShutdown;
+      }
+    }
+  }
+
+  EftpSetTimer (Private, Private->Timeout, 0);
+  return EFI_SUCCESS;
+
+SilentShutdown:
+  WRQ_SILENT_SHUTDOWN (Private);
+  return EFI_ABORTED;
+}
+
 VOID
 EftpWrqCleanUp (
   IN EFTP_IO_PRIVATE*Private
@@ -54,6 +54,12 @@ Abstract:
 //
 typedef struct _EFTP_WRQ_STATE {
   EFTP_PACKET_BUFFER  *LastData;  // saved for retransmission
+
+  //
+  // Windowed upload
+  //
+  UINT64              AckedBlkNo;   // highest block acknowledged
+  UINT64              ResendBlkNo;  // highest block resent for a hole
 } EFTP_WRQ_STATE;
 
 EFTP_WRQ_STATE  *
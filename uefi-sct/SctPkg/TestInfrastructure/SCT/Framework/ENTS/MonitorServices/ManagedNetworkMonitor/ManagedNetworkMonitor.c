@@ -68,11 +68,42 @@ STATIC UINT64                               LastCleanupPktTimeStamp = 0x0;
 
 STATIC LINK_LAYER_STATUS                    LinkStatus              = WaitForPacket;
 
-STATIC UINT32                               mCurrentReceiveOffset;
-STATIC UINT32                               mCurrentOpCode;
 STATIC UINT32                               mCurrentSeqId;
 STATIC UINT32                               mCurrentPacketLength;
 
+//
+// The windowed link agreed in the last PROBE, and the link clock in mSecond
+//
+STATIC MNP_LINK_CONTEXT                     mLink                   = { 0, 0 };
+STATIC EFI_EVENT                            LinkTickEvent;
+STATIC UINT32                               mLinkTick               = 0;
+
+//
+// Sender side of the windowed link. Srtt is scaled by 8 and RttVar by 4, as
+// in RFC 6298.
+//
+typedef struct {
+  UINT32  Count;
+  UINT32  Next;
+  UINT8   Acked[LINK_BITMAP_SIZE];
+  UINT8   Resent[LINK_BITMAP_SIZE];
+  UINT32  SendTick[LINK_FRAGMENT_MAX];
+  UINT32  Srtt;
+  UINT32  RttVar;
+  UINT32  Rto;
+} MNP_SEND_WINDOW;
+
+STATIC MNP_SEND_WINDOW                      mSendWindow;
+
+//
+// Receiver side: the fragments of the message in MnpBufferIn held so far.
+// mReceiveCount is 0 until the last fragment arrives.
+//
+STATIC UINT8                                mReceiveBitmap[LINK_BITMAP_SIZE];
+STATIC UINT32                               mReceiveCount;
+STATIC UINT32                               mReceiveLength;
+STATIC UINT32                               mReceiveSinceAck;
+
 EFI_MAC_ADDRESS                             mDestinationAddress     = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 EFI_MAC_ADDRESS                             mSourceAddress          = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 
@@ -124,7 +155,10 @@ EFI_MANAGED_NETWORK_RECEIVE_DATA            mMnpRxDataTemplate = {
   NULL                    // PacketData
 };
 
-CHAR8                                       MnpBufferIn[MNP_BUFFER_IN_MAX];
+//
+// The messages are reassembled with their EAS_APP_FLAG in front
+//
+CHAR8                                       MnpBufferIn[sizeof (EAS_APP_FLAG) + MNP_BUFFER_IN_MAX + 1];
 CHAR8                                       *MnpBufferOut;
 UINTN                                       MnpBufferOutSize;
 
@@ -146,6 +180,40 @@ MnpSendPacketOut (
   IN UINTN     Size
   );
 
+EFI_STATUS
+MnpSendFragment (
+  IN CHAR8     *Buffer,
+  IN UINT32    Sequence,
+  IN UINTN     Size,
+  IN UINTN     Offset
+  );
+
+VOID
+MnpWindowStart (
+  VOID
+  );
+
+VOID
+MnpWindowAcknowledge (
+  IN UINT8     *Bitmap
+  );
+
+VOID
+MnpWindowSack (
+  IN UINT8     *Bitmap
+  );
+
+VOID
+MnpWindowTimeout (
+  VOID
+  );
+
+VOID
+LinkTick (
+  IN EFI_EVENT    Event,
+  IN VOID         *Context
+  );
+
 VOID
 NotifyFunctionSend (
   EFI_EVENT Event,
@@ -169,6 +237,14 @@ SendOutAck (
   IN UINT32                         Type
   );
 
+EFI_STATUS
+SendOutLinkPacket (
+  IN UINT32                         SeqId,
+  IN UINT32                         Type,
+  IN VOID                           *Data,
+  IN UINTN                          DataSize
+  );
+
 VOID
 MnpNetWorkPoll (
   VOID
@@ -476,6 +552,8 @@ Returns:
   tBS->CloseEvent (TxLLToken.Event);
   CancelResendTimer ();
   tBS->CloseEvent (ResendTimeEvent);
+  tBS->SetTimer (LinkTickEvent, TimerCancel, 0);
+  tBS->CloseEvent (LinkTickEvent);
 
   //
   // Destroy MNP instance
@@ -622,6 +700,21 @@ ManagedNetworkSaveContext (
     return Status;
   }
 
+  //
+  // Save the windowed link agreed with the EMS
+  //
+  Status = SetContextRecord (
+             gntDevicePath,
+             SCT_PASSIVE_MODE_RECORD_FILE,
+             ENTS_LINK_WINDOW_NAME,
+             sizeof(MNP_LINK_CONTEXT),
+             &mLink
+             );
+  if (EFI_ERROR(Status)) {
+    EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"Can not set LinkWindow - %r\n", Status));
+    return Status;
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -681,6 +774,27 @@ ManagedNetworkRestoreContext (
     SendSequenceSavedForResend = 0;
   }
 
+  //
+  // Get the windowed link, the link is stop-and-wait without it
+  //
+  BufSize = sizeof(MNP_LINK_CONTEXT);
+  Status = GetContextRecord (
+             gntDevicePath,
+             SCT_PASSIVE_MODE_RECORD_FILE,
+             ENTS_LINK_WINDOW_NAME,
+             &BufSize,
+             &mLink
+             );
+  if (EFI_ERROR (Status) || (mLink.Window > MNP_LINK_WINDOW)) {
+    EFI_ENTS_DEBUG((EFI_ENTS_D_TRACE, L"Can not get the LinkWindow"));
+    mLink.Window     = 0;
+    mLink.MaxMessage = 0;
+  }
+
+  mSendWindow.Srtt   = 0;
+  mSendWindow.RttVar = 0;
+  mSendWindow.Rto    = LINK_RTO_INITIAL;
+
   return EFI_SUCCESS;
 }
 
@@ -726,7 +840,7 @@ Returns:
   if (*Buffer == NULL) {
   	return EFI_OUT_OF_RESOURCES;
   }
-  Status            = Char8ToChar16 (MnpBufferIn, *Size, *Buffer);
+  Status            = Char8ToChar16 (MnpBufferIn + sizeof (EAS_APP_FLAG), *Size, *Buffer);
   HasReceivePacket  = FALSE;
   return Status;
 }
@@ -757,6 +871,8 @@ Returns:
 --*/
 {
   EFI_STATUS                    Status;
+  EAS_APP_FLAG                  AppFlag;
+  EFI_TPL                       OldTpl;
 
   EntsOutput (L"MNP Send ...\n");
   if (LinkStatus == SendoutPacket) {
@@ -766,17 +882,32 @@ Returns:
     return EFI_ACCESS_DENIED;
   }
 
+  MnpBufferOutSize = EntsStrLen(Buffer);
+  if ((mLink.Window != 0) && (sizeof (EAS_APP_FLAG) + MnpBufferOutSize > mLink.MaxMessage)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Message is too long for the EMS"));
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
   tBS->Stall (1000);
 
-  MnpBufferOutSize = EntsStrLen(Buffer);
-  MnpBufferOut = EntsAllocatePool (MnpBufferOutSize + 1);
+  //
+  // The message is sent with its EAS_APP_FLAG in front
+  //
+  MnpBufferOut = EntsAllocatePool (sizeof (EAS_APP_FLAG) + MnpBufferOutSize + 1);
   if (MnpBufferOut == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
-  Status        = Char16ToChar8 (Buffer, MnpBufferOut, MnpBufferOutSize);
+
+  AppFlag.LLFlag ^= AppFlag.LLFlag;
+  AppSequence = AppSequenceSavedForResend;
+  AppFlag.Flag.SeqId = HTONL (AppSequence);
+  EntsCopyMem (MnpBufferOut, &AppFlag.LLFlag, sizeof (EAS_APP_FLAG));
+
+  Status        = Char16ToChar8 (Buffer, MnpBufferOut + sizeof (EAS_APP_FLAG), MnpBufferOutSize);
   if (EFI_ERROR (Status)) {
     return Status;
   }
+  MnpBufferOutSize += sizeof (EAS_APP_FLAG);
 
   //
   // Retrieve LastSendSequence to act as the link sequence in case the
@@ -786,12 +917,21 @@ Returns:
   LastSendSequence += 1;
   LinkStatus = SendoutPacket;
 
-  MnpSendPacketOut (MnpBufferOut, LastSendSequence, MnpBufferOutSize);
+  if (mLink.Window != 0) {
+    //
+    // The window is also driven by the receive and timer callbacks
+    //
+    OldTpl = tBS->RaiseTPL (TPL_CALLBACK);
+    MnpWindowStart ();
+    tBS->RestoreTPL (OldTpl);
+  } else {
+    MnpSendPacketOut (MnpBufferOut, LastSendSequence, MnpBufferOutSize);
 
-  Status = SetResendTimer (LL_TIMEOUT);
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Set resend timer error"));
-    return Status;
+    Status = SetResendTimer (LL_TIMEOUT);
+    if (EFI_ERROR (Status)) {
+      EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Set resend timer error"));
+      return Status;
+    }
   }
 
   while (LinkStatus == SendoutPacket) {
@@ -818,7 +958,7 @@ Routine Description:
 
 Arguments:
 
-  Buffer    - A buffer for writing.
+  Buffer    - A buffer for writing, with the EAS_APP_FLAG in front.
   Sequence  - The Sequence Id of the packet to send.
   Size      - The size of the buffer to send.
 
@@ -830,257 +970,748 @@ Returns:
 
 --*/
 {
-  BOOLEAN           IsOver;
-  EAS_MNP_FRAG_FLAG FragFlag;
-  EAS_APP_FLAG      AppFlag;
-  UINTN             BufferSize;
-  UINT32            PacketLength;
-  UINT32            PacketStartPoint;
+  UINTN             PacketStartPoint;
   EFI_STATUS        Status;
-  UINT8             *FragmentBuffer;
-
-  if (0 == Size) {
-    return EFI_SUCCESS;
-  }
-
-  IsOver = FALSE;
-  FragFlag.LLFlag ^= FragFlag.LLFlag;
-  FragFlag.Flag.SeqId   = HTONL (Sequence);
-  FragFlag.Flag.OpCode  = LINK_OPERATION_DATA;
-  BufferSize            = Size;
-  PacketStartPoint      = 0;
-  FragmentBuffer        = NULL;
-
-  while (!IsOver) {
-    //
-    // Build Fragment Flag
-    //
-    if (BufferSize <= MAX_PACKET_LENGTH) {
-      IsOver = TRUE;
-      CLR_FLAG_MF (FragFlag.LLFlag);
-      PacketLength          = (UINT32) BufferSize;
-      FragFlag.Flag.Offset  = HTONS (PacketStartPoint);
-    } else {
-      //
-      // Need more fragement
-      //
-      IsOver = FALSE;
-      SET_FLAG_MF (FragFlag.LLFlag);
-      PacketLength          = MAX_PACKET_LENGTH;
-      FragFlag.Flag.Offset  = HTONS (PacketStartPoint);
-      BufferSize -= MAX_PACKET_LENGTH;
-    }
-    //
-    // Build App Flag
-    //
-    AppFlag.LLFlag ^= AppFlag.LLFlag;
-    AppSequence = AppSequenceSavedForResend;
-    AppFlag.Flag.SeqId = HTONL(AppSequence);
-    //
-    // Build data
-    //
-    FragmentBuffer = EntsAllocatePool (PacketLength + sizeof (EAS_MNP_FRAG_FLAG) + sizeof (EAS_APP_FLAG));
-    if(NULL == FragmentBuffer) {
-      EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"EntsAllocatePool Error"));
-      return EFI_OUT_OF_RESOURCES;
-    }
-
-    EntsCopyMem (&TxData, &mMnpTxDataTemplate, sizeof (EFI_MANAGED_NETWORK_TRANSMIT_DATA));
-    TxData.DataLength = (UINT32) (PacketLength + sizeof (EAS_MNP_FRAG_FLAG) + sizeof (EAS_APP_FLAG));
-    TxData.FragmentTable[0].FragmentLength = (UINT32) (PacketLength + sizeof (EAS_MNP_FRAG_FLAG) + sizeof (EAS_APP_FLAG));
-    TxData.FragmentTable[0].FragmentBuffer = FragmentBuffer;
-
-    EntsCopyMem (
-      (UINT8 *) TxData.FragmentTable[0].FragmentBuffer + sizeof (EAS_MNP_FRAG_FLAG) + sizeof (EAS_APP_FLAG),
-      (CHAR8 *) Buffer + PacketStartPoint,
-      PacketLength
-      );
-    EntsCopyMem (
-      (UINT8 *) TxData.FragmentTable[0].FragmentBuffer + sizeof (EAS_MNP_FRAG_FLAG),
-      &AppFlag.LLFlag,
-      sizeof (EAS_APP_FLAG)
-      );
-    EntsCopyMem (
-      TxData.FragmentTable[0].FragmentBuffer,
-      &FragFlag.LLFlag,
-      sizeof (EAS_MNP_FRAG_FLAG)
-      );
-    PacketStartPoint += PacketLength;
-
-    TxToken.Packet.TxData = &TxData;
 
-    //
-    // Ready to send buffer
-    //
-    Context = 0;
-    Status  = Mnp->Transmit (Mnp, &TxToken);
+  for (PacketStartPoint = 0; PacketStartPoint < Size; PacketStartPoint += MAX_PACKET_LENGTH) {
+    Status = MnpSendFragment (Buffer, Sequence, Size, PacketStartPoint);
     if (EFI_ERROR (Status)) {
-      RecycleTxBuffer(FragmentBuffer);
-      EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Mnp->Transmit Error"));
       return Status;
     }
-    //
-    // Check the event ( Omitted...)
-    //
-    RecycleTxBuffer(FragmentBuffer);
   }
 
   return EFI_SUCCESS;
 }
 
-//
-// Internal functions implementations
-//
-STATIC
 EFI_STATUS
-StartInitMnp (
-  IN EFI_MANAGED_NETWORK_PROTOCOL  *MnpProtocol
+MnpSendFragment (
+  IN CHAR8     *Buffer,
+  IN UINT32    Sequence,
+  IN UINTN     Size,
+  IN UINTN     Offset
   )
 /*++
 
 Routine Description:
 
-  Initialize MNP.
+  This func is to send the fragment of a data packet starting at Offset out
+  to managed network.
 
 Arguments:
 
-  None
+  Buffer    - A buffer for writing, with the EAS_APP_FLAG in front.
+  Sequence  - The Sequence Id of the packet to send.
+  Size      - The size of the buffer to send.
+  Offset    - The offset of the fragment in the buffer.
 
 Returns:
 
-  EFI_SUCCESS - Operation succeeded.
-  Others      - Some failure happened.
-  
+  EFI_SUCCESS          - Operation succeeded.
+  EFI_OUT_OF_RESOURCES - Memory allocation failed.
+  Others               - Some failure happened.
+
 --*/
 {
-  EFI_STATUS              Status;
-  EFI_SIMPLE_NETWORK_MODE SnpModeData;
-
-  Status = MnpProtocol->Configure (
-                          MnpProtocol,
-                          &mMnpConfigDataTemplate
-                          );
-
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"StartInitMnp: Mnp->Configure fail - %r", Status));
-    return Status;
-  }
+  EAS_MNP_FRAG_FLAG FragFlag;
+  UINT32            PacketLength;
+  EFI_STATUS        Status;
+  UINT8             *FragmentBuffer;
 
-  Status = MnpProtocol->GetModeData (
-                          MnpProtocol,
-                          NULL,
-                          &SnpModeData
-                          );
-  if (EFI_ERROR (Status) && (Status != EFI_NOT_STARTED)) {
-    EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"StartInitMnp: Mnp->GetModeData fail - %r", Status));
-    return Status;
+  //
+  // Build Fragment Flag
+  //
+  FragFlag.LLFlag ^= FragFlag.LLFlag;
+  FragFlag.Flag.SeqId   = HTONL (Sequence);
+  FragFlag.Flag.OpCode  = LINK_OPERATION_DATA;
+  FragFlag.Flag.Offset  = HTONS ((UINT16) Offset);
+  if (Size - Offset <= MAX_PACKET_LENGTH) {
+    CLR_FLAG_MF (FragFlag.LLFlag);
+    PacketLength = (UINT32) (Size - Offset);
+  } else {
+    //
+    // Need more fragement
+    //
+    SET_FLAG_MF (FragFlag.LLFlag);
+    PacketLength = MAX_PACKET_LENGTH;
   }
 
-  EntsCopyMem (&mSourceAddress, &SnpModeData.CurrentAddress, sizeof (EFI_MAC_ADDRESS));
-  EFI_ENTS_DEBUG ((EFI_ENTS_D_TRACE, L"mSourceAddress : %x:%x:%x:%x:%x:%x", 
-  mSourceAddress.Addr[0], mSourceAddress.Addr[1], 
-  mSourceAddress.Addr[2], mSourceAddress.Addr[3], 
-  mSourceAddress.Addr[4], mSourceAddress.Addr[5]));
-  mMnpConfigDataTemplate.ProtocolTypeFilter = EAS_MNP_PROT_RIVL_TYPE;
-
-  RxToken.Packet.RxData = NULL;
-  RxToken.Event         = NULL;
-
-  Status = tBS->CreateEvent (
-                  EVT_NOTIFY_SIGNAL,
-                  TPL_CALLBACK,
-                  (EFI_EVENT_NOTIFY) NotifyFunctionListen,
-                  NULL,
-                  &RxToken.Event
-                  );
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"CreateEvent Error"));
-    return Status;
+  //
+  // Build data
+  //
+  FragmentBuffer = EntsAllocatePool (PacketLength + sizeof (EAS_MNP_FRAG_FLAG));
+  if(NULL == FragmentBuffer) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"EntsAllocatePool Error"));
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  Status = MnpProtocol->Receive (MnpProtocol, &RxToken);
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Mnp Receive Error"));
-    goto Error1;
-  }
+  EntsCopyMem (&TxData, &mMnpTxDataTemplate, sizeof (EFI_MANAGED_NETWORK_TRANSMIT_DATA));
+  TxData.DataLength = (UINT32) (PacketLength + sizeof (EAS_MNP_FRAG_FLAG));
+  TxData.FragmentTable[0].FragmentLength = (UINT32) (PacketLength + sizeof (EAS_MNP_FRAG_FLAG));
+  TxData.FragmentTable[0].FragmentBuffer = FragmentBuffer;
 
-  Status = tBS->CreateEvent (
-                  EVT_NOTIFY_SIGNAL,
-                  TPL_CALLBACK,
-                  (EFI_EVENT_NOTIFY) NotifyFunctionSend,
-                  &Context,
-                  &TxToken.Event
-                  );
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"CreateEvent Error"));
-    goto Error1;
-  }
+  EntsCopyMem (
+    (UINT8 *) TxData.FragmentTable[0].FragmentBuffer + sizeof (EAS_MNP_FRAG_FLAG),
+    (CHAR8 *) Buffer + Offset,
+    PacketLength
+    );
+  EntsCopyMem (
+    TxData.FragmentTable[0].FragmentBuffer,
+    &FragFlag.LLFlag,
+    sizeof (EAS_MNP_FRAG_FLAG)
+    );
 
-  Status = tBS->CreateEvent (
-                  EVT_NOTIFY_SIGNAL,
-                  TPL_CALLBACK,
-                  (EFI_EVENT_NOTIFY) NotifyFunctionSend,
-                  &Context,
-                  &TxLLToken.Event
-                  );
-  if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"CreateEvent Error"));
-    goto Error2;
-  }
+  TxToken.Packet.TxData = &TxData;
 
-  Status = tBS->CreateEvent (
-                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
-                  TPL_CALLBACK,
-                  (EFI_EVENT_NOTIFY) ReSendTimer,
-                  NULL,
-                  &ResendTimeEvent
-                  );
+  //
+  // Ready to send buffer
+  //
+  Context = 0;
+  Status  = Mnp->Transmit (Mnp, &TxToken);
   if (EFI_ERROR (Status)) {
-    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Create resend timer error"));
-    goto Error3;
+    RecycleTxBuffer(FragmentBuffer);
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Mnp->Transmit Error"));
+    return Status;
   }
+  //
+  // Check the event ( Omitted...)
+  //
+  RecycleTxBuffer(FragmentBuffer);
 
   return EFI_SUCCESS;
-
-Error3:
-  tBS->CloseEvent (TxLLToken.Event);
-Error2:
-  tBS->CloseEvent (TxToken.Event);
-Error1:
-  tBS->CloseEvent (RxToken.Event);
-  return Status;
 }
 
-VOID
-NotifyFunctionSend (
-  EFI_EVENT Event,
-  VOID      *EventContext
+STATIC
+EFI_STATUS
+MnpWindowSendFragment (
+  IN UINT32    Index
   )
 /*++
 
 Routine Description:
 
-  Callback function on sending packet.
+  Send one fragment of the message in MnpBufferOut over the windowed link.
 
 Arguments:
 
-  Event        - Event to be singaled.
-  EventContext - EventContext.
+  Index - The index of the fragment.
 
 Returns:
 
-  
+  EFI_SUCCESS - Operation succeeded.
+  Others      - Some failure happened.
 
 --*/
 {
-  UINTN *NotifyTimes;
-
-  if (EventContext == NULL) {
-    return ;
-  }
+  mSendWindow.SendTick[Index] = mLinkTick;
+  return MnpSendFragment (MnpBufferOut, LastSendSequence, MnpBufferOutSize, Index * MAX_PACKET_LENGTH);
+}
 
-  NotifyTimes = (UINTN *) EventContext;
-  (*NotifyTimes)++;
+STATIC
+VOID
+MnpWindowFill (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Send the fragments never sent, as long as less than mLink.Window fragments
+  are unacknowledged.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  InFlight;
+
+  InFlight = 0;
+  for (Index = 0; Index < mSendWindow.Next; Index++) {
+    if (!LINK_BITMAP_TEST (mSendWindow.Acked, Index)) {
+      InFlight++;
+    }
+  }
+
+  while ((mSendWindow.Next < mSendWindow.Count) && (InFlight < mLink.Window)) {
+    MnpWindowSendFragment (mSendWindow.Next);
+    mSendWindow.Next++;
+    InFlight++;
+  }
+}
+
+STATIC
+VOID
+MnpWindowSetTimer (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Restart the resend timer with the current retransmission timeout.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  tBS->SetTimer (
+         ResendTimeEvent,
+         TimerRelative,
+         (UINT64) mSendWindow.Rto * 10000
+         );
+}
+
+STATIC
+VOID
+MnpWindowUpdateRto (
+  IN UINT32    Rtt
+  )
+/*++
+
+Routine Description:
+
+  Update the retransmission timeout with a round trip time sample.
+
+Arguments:
+
+  Rtt - The round trip time of a fragment sent once, in mSecond.
+
+Returns:
+
+  None
+
+--*/
+{
+  INT32   Delta;
+  UINT32  Variation;
+
+  if (Rtt == 0) {
+    Rtt = 1;
+  }
+
+  if (mSendWindow.Srtt == 0) {
+    mSendWindow.Srtt   = Rtt << 3;
+    mSendWindow.RttVar = Rtt << 1;
+  } else {
+    Delta = (INT32) Rtt - (INT32) (mSendWindow.Srtt >> 3);
+    mSendWindow.Srtt = (UINT32) ((INT32) mSendWindow.Srtt + Delta);
+    if (Delta < 0) {
+      Delta = -Delta;
+    }
+
+    mSendWindow.RttVar = (UINT32) ((INT32) mSendWindow.RttVar + Delta - (INT32) (mSendWindow.RttVar >> 2));
+  }
+
+  Variation        = (mSendWindow.RttVar > LINK_TICK) ? mSendWindow.RttVar : LINK_TICK;
+  mSendWindow.Rto  = (mSendWindow.Srtt >> 3) + Variation;
+  if (mSendWindow.Rto < LINK_RTO_MIN) {
+    mSendWindow.Rto = LINK_RTO_MIN;
+  } else if (mSendWindow.Rto > LINK_RTO_MAX) {
+    mSendWindow.Rto = LINK_RTO_MAX;
+  }
+}
+
+VOID
+MnpWindowStart (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Start sending the message in MnpBufferOut over the windowed link. The
+  caller raises the TPL to TPL_CALLBACK.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  mSendWindow.Count = (UINT32) ((MnpBufferOutSize + MAX_PACKET_LENGTH - 1) / MAX_PACKET_LENGTH);
+  mSendWindow.Next  = 0;
+  EntsZeroMem (mSendWindow.Acked, LINK_BITMAP_SIZE);
+  EntsZeroMem (mSendWindow.Resent, LINK_BITMAP_SIZE);
+
+  MnpWindowFill ();
+  MnpWindowSetTimer ();
+}
+
+VOID
+MnpWindowAcknowledge (
+  IN UINT8     *Bitmap
+  )
+/*++
+
+Routine Description:
+
+  Mark the fragments reported by the EMS as received. Only the fragments
+  sent once give a round trip time sample (Karn's algorithm).
+
+Arguments:
+
+  Bitmap  - The fragments received by the EMS.
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  Rtt;
+  BOOLEAN Sampled;
+  BOOLEAN Progress;
+
+  Rtt       = 0;
+  Sampled   = FALSE;
+  Progress  = FALSE;
+
+  for (Index = 0; Index < mSendWindow.Next; Index++) {
+    if (!LINK_BITMAP_TEST (Bitmap, Index) || LINK_BITMAP_TEST (mSendWindow.Acked, Index)) {
+      continue;
+    }
+
+    LINK_BITMAP_SET (mSendWindow.Acked, Index);
+    Progress = TRUE;
+    if (!LINK_BITMAP_TEST (mSendWindow.Resent, Index)) {
+      Rtt     = mLinkTick - mSendWindow.SendTick[Index];
+      Sampled = TRUE;
+    }
+  }
+
+  if (Sampled) {
+    MnpWindowUpdateRto (Rtt);
+  }
+
+  if (Progress) {
+    MnpWindowSetTimer ();
+  }
+}
+
+VOID
+MnpWindowSack (
+  IN UINT8     *Bitmap
+  )
+/*++
+
+Routine Description:
+
+  Handle a DATA_SACK of the message in MnpBufferOut. A fragment missing
+  below one received is resent at once if it has been in flight for a round
+  trip, then the window slides.
+
+Arguments:
+
+  Bitmap  - The fragments received by the EMS.
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  UINT32  Highest;
+
+  MnpWindowAcknowledge (Bitmap);
+
+  Highest = 0;
+  for (Index = 0; Index < mSendWindow.Next; Index++) {
+    if (LINK_BITMAP_TEST (mSendWindow.Acked, Index)) {
+      Highest = Index;
+    }
+  }
+
+  for (Index = 0; Index < Highest; Index++) {
+    if (LINK_BITMAP_TEST (mSendWindow.Acked, Index)) {
+      continue;
+    }
+
+    if (mLinkTick - mSendWindow.SendTick[Index] >= (mSendWindow.Srtt >> 3)) {
+      LINK_BITMAP_SET (mSendWindow.Resent, Index);
+      MnpWindowSendFragment (Index);
+    }
+  }
+
+  MnpWindowFill ();
+}
+
+VOID
+MnpWindowTimeout (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  The retransmission timer of the windowed link expired: back off and resend
+  the fragments in flight. If the EMS holds all of them the DATA_ACK was
+  lost, the last fragment is resent to have it repeated.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Index;
+  BOOLEAN Resent;
+
+  mSendWindow.Rto = (mSendWindow.Rto * 2 > LINK_RTO_MAX) ? LINK_RTO_MAX : mSendWindow.Rto * 2;
+
+  Resent = FALSE;
+  for (Index = 0; Index < mSendWindow.Next; Index++) {
+    if (!LINK_BITMAP_TEST (mSendWindow.Acked, Index)) {
+      LINK_BITMAP_SET (mSendWindow.Resent, Index);
+      MnpWindowSendFragment (Index);
+      Resent = TRUE;
+    }
+  }
+
+  if (!Resent && (mSendWindow.Count > 0)) {
+    LINK_BITMAP_SET (mSendWindow.Resent, mSendWindow.Count - 1);
+    MnpWindowSendFragment (mSendWindow.Count - 1);
+  }
+
+  MnpWindowSetTimer ();
+}
+
+STATIC
+VOID
+MnpLinkNegotiate (
+  IN UINT8     *Data,
+  IN UINT32    DataLength
+  )
+/*++
+
+Routine Description:
+
+  Agree on the link with the capability in a PROBE, and answer it with the
+  PROBE_ACK. An EMS that does not know the windowed link sends no
+  capability, and gets a PROBE_ACK without capability.
+
+Arguments:
+
+  Data        - The payload of the PROBE.
+  DataLength  - The length of the payload.
+
+Returns:
+
+  None
+
+--*/
+{
+  EAS_LINK_CAPABILITY Capability;
+
+  mLink.Window       = 0;
+  mLink.MaxMessage   = 0;
+  mSendWindow.Srtt   = 0;
+  mSendWindow.RttVar = 0;
+  mSendWindow.Rto    = LINK_RTO_INITIAL;
+
+  if (DataLength >= sizeof (EAS_LINK_CAPABILITY)) {
+    EntsCopyMem (&Capability, Data, sizeof (EAS_LINK_CAPABILITY));
+    if ((NTOHL (Capability.Signature) == LINK_CAPABILITY_SIGNATURE) &&
+        (Capability.Version >= LINK_CAPABILITY_VERSION) &&
+        (Capability.Window != 0) &&
+        (NTOHS (Capability.MaxMessage) != 0)) {
+      mLink.Window     = (Capability.Window < MNP_LINK_WINDOW) ? Capability.Window : MNP_LINK_WINDOW;
+      mLink.MaxMessage = NTOHS (Capability.MaxMessage);
+    }
+  }
+
+  if (mLink.Window == 0) {
+    SendOutAck (0, LINK_OPERATION_PROBE_ACK);
+    return ;
+  }
+
+  Capability.Signature  = HTONL (LINK_CAPABILITY_SIGNATURE);
+  Capability.Version    = LINK_CAPABILITY_VERSION;
+  Capability.Window     = MNP_LINK_WINDOW;
+  Capability.MaxMessage = HTONS (sizeof (EAS_APP_FLAG) + MNP_BUFFER_IN_MAX);
+  SendOutLinkPacket (0, LINK_OPERATION_PROBE_ACK, &Capability, sizeof (EAS_LINK_CAPABILITY));
+}
+
+STATIC
+BOOLEAN
+MnpReassemble (
+  IN UINT32    SequenceId,
+  IN UINT32    Offset,
+  IN BOOLEAN   IsOver,
+  IN UINT8     *Data,
+  IN UINT32    DataLength
+  )
+/*++
+
+Routine Description:
+
+  Place a DATA fragment into MnpBufferIn by its offset, so the fragments may
+  arrive in any order.
+
+Arguments:
+
+  SequenceId  - The Sequence Id of the fragment.
+  Offset      - The offset of the fragment in the message.
+  IsOver      - Whether it is the last fragment.
+  Data        - The payload of the fragment.
+  DataLength  - The length of the payload.
+
+Returns:
+
+  TRUE  - The message is complete.
+  FALSE - More fragments are needed, or the fragment is dropped.
+
+--*/
+{
+  UINT32  Index;
+
+  //
+  // A message is cut at MAX_PACKET_LENGTH, only its last fragment is shorter
+  //
+  if ((Offset % MAX_PACKET_LENGTH != 0) ||
+      (!IsOver && (DataLength != MAX_PACKET_LENGTH)) ||
+      (Offset + DataLength > sizeof (EAS_APP_FLAG) + MNP_BUFFER_IN_MAX)) {
+    return FALSE;
+  }
+
+  //
+  // The fragment of a new message
+  //
+  if (SequenceId != mCurrentSeqId) {
+    mCurrentSeqId     = SequenceId;
+    mReceiveCount     = 0;
+    mReceiveLength    = 0;
+    mReceiveSinceAck  = 0;
+    EntsZeroMem (mReceiveBitmap, LINK_BITMAP_SIZE);
+  }
+
+  Index = Offset / MAX_PACKET_LENGTH;
+  EntsCopyMem (MnpBufferIn + Offset, Data, DataLength);
+  LINK_BITMAP_SET (mReceiveBitmap, Index);
+
+  if (IsOver) {
+    mReceiveCount   = Index + 1;
+    mReceiveLength  = Offset + DataLength;
+  }
+
+  if (mReceiveCount == 0) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < mReceiveCount; Index++) {
+    if (!LINK_BITMAP_TEST (mReceiveBitmap, Index)) {
+      return FALSE;
+    }
+  }
+
+  //
+  // Start over for the next message
+  //
+  mReceiveCount = 0;
+  EntsZeroMem (mReceiveBitmap, LINK_BITMAP_SIZE);
+
+  return (BOOLEAN) (mReceiveLength >= sizeof (EAS_APP_FLAG));
+}
+
+//
+// Internal functions implementations
+//
+STATIC
+EFI_STATUS
+StartInitMnp (
+  IN EFI_MANAGED_NETWORK_PROTOCOL  *MnpProtocol
+  )
+/*++
+
+Routine Description:
+
+  Initialize MNP.
+
+Arguments:
+
+  None
+
+Returns:
+
+  EFI_SUCCESS - Operation succeeded.
+  Others      - Some failure happened.
+  
+--*/
+{
+  EFI_STATUS              Status;
+  EFI_SIMPLE_NETWORK_MODE SnpModeData;
+
+  Status = MnpProtocol->Configure (
+                          MnpProtocol,
+                          &mMnpConfigDataTemplate
+                          );
+
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"StartInitMnp: Mnp->Configure fail - %r", Status));
+    return Status;
+  }
+
+  Status = MnpProtocol->GetModeData (
+                          MnpProtocol,
+                          NULL,
+                          &SnpModeData
+                          );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_STARTED)) {
+    EFI_ENTS_DEBUG((EFI_ENTS_D_ERROR, L"StartInitMnp: Mnp->GetModeData fail - %r", Status));
+    return Status;
+  }
+
+  EntsCopyMem (&mSourceAddress, &SnpModeData.CurrentAddress, sizeof (EFI_MAC_ADDRESS));
+  EFI_ENTS_DEBUG ((EFI_ENTS_D_TRACE, L"mSourceAddress : %x:%x:%x:%x:%x:%x", 
+  mSourceAddress.Addr[0], mSourceAddress.Addr[1], 
+  mSourceAddress.Addr[2], mSourceAddress.Addr[3], 
+  mSourceAddress.Addr[4], mSourceAddress.Addr[5]));
+  mMnpConfigDataTemplate.ProtocolTypeFilter = EAS_MNP_PROT_RIVL_TYPE;
+
+  RxToken.Packet.RxData = NULL;
+  RxToken.Event         = NULL;
+
+  Status = tBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  (EFI_EVENT_NOTIFY) NotifyFunctionListen,
+                  NULL,
+                  &RxToken.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"CreateEvent Error"));
+    return Status;
+  }
+
+  Status = MnpProtocol->Receive (MnpProtocol, &RxToken);
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Mnp Receive Error"));
+    goto Error1;
+  }
+
+  Status = tBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  (EFI_EVENT_NOTIFY) NotifyFunctionSend,
+                  &Context,
+                  &TxToken.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"CreateEvent Error"));
+    goto Error1;
+  }
+
+  Status = tBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  (EFI_EVENT_NOTIFY) NotifyFunctionSend,
+                  &Context,
+                  &TxLLToken.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"CreateEvent Error"));
+    goto Error2;
+  }
+
+  Status = tBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  (EFI_EVENT_NOTIFY) ReSendTimer,
+                  NULL,
+                  &ResendTimeEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Create resend timer error"));
+    goto Error3;
+  }
+
+  //
+  // The clock of the windowed link, to take the round trip times
+  //
+  Status = tBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  (EFI_EVENT_NOTIFY) LinkTick,
+                  NULL,
+                  &LinkTickEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Create link tick timer error"));
+    goto Error4;
+  }
+
+  Status = tBS->SetTimer (LinkTickEvent, TimerPeriodic, LINK_TICK * 10000);
+  if (EFI_ERROR (Status)) {
+    EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"Set link tick timer error"));
+    goto Error5;
+  }
+
+  return EFI_SUCCESS;
+
+Error5:
+  tBS->CloseEvent (LinkTickEvent);
+Error4:
+  tBS->CloseEvent (ResendTimeEvent);
+Error3:
+  tBS->CloseEvent (TxLLToken.Event);
+Error2:
+  tBS->CloseEvent (TxToken.Event);
+Error1:
+  tBS->CloseEvent (RxToken.Event);
+  return Status;
+}
+
+VOID
+NotifyFunctionSend (
+  EFI_EVENT Event,
+  VOID      *EventContext
+  )
+/*++
+
+Routine Description:
+
+  Callback function on sending packet.
+
+Arguments:
+
+  Event        - Event to be singaled.
+  EventContext - EventContext.
+
+Returns:
+
+  
+
+--*/
+{
+  UINTN *NotifyTimes;
+
+  if (EventContext == NULL) {
+    return ;
+  }
+
+  NotifyTimes = (UINTN *) EventContext;
+  (*NotifyTimes)++;
 
   return ;
 }
@@ -1145,9 +1776,12 @@ Returns:
   BOOLEAN           IsOver;
   UINT32            PacketStartPoint;
   UINT32            PacketLength;
+  UINT8             *Payload;
   UINT32            OpCode;
   UINT32            SequenceId;
   UINT64            TimeStamp;
+  UINT32            Index;
+  UINT8             AllAcked[LINK_BITMAP_SIZE];
 
   if (RxToken.Status == EFI_ABORTED) {
     return;
@@ -1181,6 +1815,7 @@ Returns:
   EntsCopyMem (&FragFlag.LLFlag, RxData->PacketData, sizeof (EAS_MNP_FRAG_FLAG));
   SequenceId        = NTOHL (FragFlag.Flag.SeqId);
   PacketStartPoint  = NTOHS (FragFlag.Flag.Offset);
+  Payload           = (UINT8 *) RxData->PacketData + sizeof (EAS_MNP_FRAG_FLAG);
   PacketLength      = RxData->DataLength - sizeof (EAS_MNP_FRAG_FLAG);
   IsOver            = HAS_FLAG_MF (FragFlag.LLFlag) ? FALSE : TRUE;
   OpCode            = FragFlag.Flag.OpCode;
@@ -1190,13 +1825,6 @@ Returns:
   //
   SendSequenceSavedForResend = LastSendSequence;
 
-  //
-  // Build App Flag
-  //
-  EntsCopyMem (&AppFlag.LLFlag, (UINT8 *) RxData->PacketData + sizeof (EAS_MNP_FRAG_FLAG), sizeof (EAS_APP_FLAG));
-  AppSequence = NTOHL (AppFlag.Flag.SeqId);
-  PacketLength -= sizeof (EAS_APP_FLAG);
-
   if (PacketStartPoint == 0) {
     //
     // Record the Destination address (EFI Management Side) into variable for late use.
@@ -1221,52 +1849,48 @@ Returns:
         return ;
       }
     }
-    mCurrentReceiveOffset = PacketLength;
-    mCurrentOpCode        = OpCode;
-    mCurrentSeqId         = SequenceId;
-  } else if ((PacketStartPoint != mCurrentReceiveOffset) || 
-                                     (OpCode != mCurrentOpCode) || 
-                                     (SequenceId != mCurrentSeqId)) {
-    goto RESTART_RECEIVE;
-  } else {
-    mCurrentReceiveOffset += PacketLength;
-  }
-  
-  //
-  // Build data
-  //
-  if (mCurrentReceiveOffset > MNP_BUFFER_IN_MAX) {
-    //
-    // Too long packet
-    //
-    mCurrentReceiveOffset = 0;
-    goto RESTART_RECEIVE;
   }
 
-  if (!IsOver) {
-    goto RESTART_RECEIVE;
-  }
-
-
-  //
-  // Receive a complete packet
-  //
   switch (OpCode) {
   case LINK_OPERATION_PROBE:
     //
-    // Send out probe ack
+    // Agree on the link and send out probe ack
     //
-    SendOutAck (SequenceId, LINK_OPERATION_PROBE_ACK);
+    MnpLinkNegotiate (Payload, PacketLength);
     break;
 
   case LINK_OPERATION_DATA:
+    if ((mLink.Window != 0) && (SequenceId == LastReceiveSequence)) {
+      //
+      // A fragment of the message received, the DATA_ACK was lost
+      //
+      SendOutAck (LastReceiveSequence, LINK_OPERATION_DATA_ACK);
+      break;
+    }
+
+    if (!MnpReassemble (SequenceId, PacketStartPoint, IsOver, Payload, PacketLength)) {
+      //
+      // The windowed link reports a hole, the end of the message, and every
+      // half window of fragments
+      //
+      Index = PacketStartPoint / MAX_PACKET_LENGTH;
+      mReceiveSinceAck++;
+      if ((mLink.Window != 0) &&
+          (IsOver ||
+           ((Index > 0) && !LINK_BITMAP_TEST (mReceiveBitmap, Index - 1)) ||
+           (mReceiveSinceAck * 2 >= mLink.Window))) {
+        mReceiveSinceAck = 0;
+        SendOutLinkPacket (SequenceId, LINK_OPERATION_DATA_SACK, mReceiveBitmap, LINK_BITMAP_SIZE);
+      }
+      break;
+    }
 
-    EntsCopyMem (
-      MnpBufferIn + PacketStartPoint,
-      (CHAR8 *) RxData->PacketData + sizeof (EAS_MNP_FRAG_FLAG) + sizeof (EAS_APP_FLAG),
-      PacketLength
-      );
-    MnpBufferIn[mCurrentReceiveOffset] = '\0';
+    //
+    // Build App Flag
+    //
+    EntsCopyMem (&AppFlag.LLFlag, MnpBufferIn, sizeof (EAS_APP_FLAG));
+    AppSequence = NTOHL (AppFlag.Flag.SeqId);
+    MnpBufferIn[mReceiveLength] = '\0';
 
     switch (LinkStatus) {
     case SendoutPacket:
@@ -1287,7 +1911,7 @@ Returns:
         LastReceiveSequence        = SequenceId;
         SendOutAck (LastReceiveSequence, LINK_OPERATION_DATA_ACK);
         ExpectReceiveSequence      = LastReceiveSequence + 1;
-        mCurrentPacketLength       = mCurrentReceiveOffset;
+        mCurrentPacketLength       = mReceiveLength - sizeof (EAS_APP_FLAG);
         HasReceivePacket           = TRUE;
         LinkStatus                 = WaitForPacket;
       }
@@ -1324,6 +1948,13 @@ Returns:
         //
         // Receive the acknowledgement
         //
+        if (mLink.Window != 0) {
+          //
+          // Take the round trip time of the last fragment
+          //
+          EntsSetMem (AllAcked, LINK_BITMAP_SIZE, 0xFF);
+          MnpWindowAcknowledge (AllAcked);
+        }
         CancelResendTimer ();
         LinkStatus = WaitForPacket;
       } else {
@@ -1341,18 +1972,26 @@ Returns:
     }
     break;
 
+  case LINK_OPERATION_DATA_SACK:
+    //
+    // Only the windowed link reports part of a message
+    //
+    if ((LinkStatus == SendoutPacket) && (SequenceId == LastSendSequence) &&
+        (mLink.Window != 0) && (PacketLength >= LINK_BITMAP_SIZE)) {
+      MnpWindowSack (Payload);
+    }
+    break;
+
   case LINK_OPERATION_CLEANUP:
-    EntsCopyMem (
-      MnpBufferIn + PacketStartPoint,
-      (CHAR8 *) RxData->PacketData + sizeof (EAS_MNP_FRAG_FLAG),
-      PacketLength
-      );
-    MnpBufferIn[mCurrentReceiveOffset] = '\0';
-      
+    if (PacketLength < sizeof (UINT64)) {
+      break;
+    }
+
     //
     // Check the valid of the Reset message.
     //
-    TimeStamp = GetPktTimeStamp((UINT64 *)(MnpBufferIn + PacketStartPoint));
+    EntsCopyMem (&TimeStamp, Payload, sizeof (UINT64));
+    TimeStamp = GetPktTimeStamp (&TimeStamp);
 
     if (LastCleanupPktTimeStamp < TimeStamp)
     {
@@ -1388,8 +2027,6 @@ Returns:
     break;
   }
 
-  mCurrentReceiveOffset = 0;
-
 RESTART_RECEIVE:
   RecycleRxBuffer ();
   Status = Mnp->Receive (Mnp, &RxToken);
@@ -1418,9 +2055,39 @@ Returns:
 
 --*/
 {
+  if (mLink.Window != 0) {
+    MnpWindowTimeout ();
+    return ;
+  }
+
   MnpSendPacketOut (MnpBufferOut, LastSendSequence, MnpBufferOutSize);
 }
 
+VOID
+LinkTick (
+  IN EFI_EVENT    Event,
+  IN VOID         *EventContext
+  )
+/*++
+
+Routine Description:
+
+  Callback function to advance the link clock.
+
+Arguments:
+
+  Event        - Event to be singaled.
+  EventContext - EventContext.
+
+Returns:
+
+  None
+
+--*/
+{
+  mLinkTick += LINK_TICK;
+}
+
 EFI_STATUS
 SetResendTimer (
   IN  UINTN uSec
@@ -1501,13 +2168,45 @@ Returns:
   Others      - Some failure happened.
   EFI_OUT_OF_RESOURCES - Memory allocation failure.
 
+--*/
+{
+  return SendOutLinkPacket (SeqId, Type, NULL, 0);
+}
+
+EFI_STATUS
+SendOutLinkPacket (
+  IN UINT32                         SeqId,
+  IN UINT32                         Type,
+  IN VOID                           *Data,
+  IN UINTN                          DataSize
+  )
+/*++
+
+Routine Description:
+
+  Send a link packet with a payload, such as a DATA_SACK or a PROBE_ACK with
+  the link capability.
+
+Arguments:
+
+  SeqId    - Sequence ID.
+  Type     - The operation of the packet.
+  Data     - The payload, NULL if DataSize is 0.
+  DataSize - The length of the payload.
+
+Returns:
+
+  EFI_SUCCESS - Operation succeeded.
+  Others      - Some failure happened.
+  EFI_OUT_OF_RESOURCES - Memory allocation failure.
+
 --*/
 {
   EFI_STATUS                            Status;
   EAS_MNP_FRAG_FLAG                     FragFlag;
   UINT8                                 *Buffer;
 
-  Buffer = EntsAllocatePool (sizeof (EAS_MNP_FRAG_FLAG));
+  Buffer = EntsAllocatePool (sizeof (EAS_MNP_FRAG_FLAG) + DataSize);
   if(Buffer == NULL) {
     EFI_ENTS_DEBUG ((EFI_ENTS_D_ERROR, L"EntsAllocatePool Error"));
     return EFI_OUT_OF_RESOURCES;
@@ -1521,11 +2220,14 @@ Returns:
   // Build data
   //
   EntsCopyMem (&TxLLData, &mMnpTxDataTemplate, sizeof (EFI_MANAGED_NETWORK_TRANSMIT_DATA));
-  TxLLData.DataLength                       = (UINT32) (sizeof (EAS_MNP_FRAG_FLAG));
-  TxLLData.FragmentTable[0].FragmentLength  = (UINT32) (sizeof (EAS_MNP_FRAG_FLAG));
+  TxLLData.DataLength                       = (UINT32) (sizeof (EAS_MNP_FRAG_FLAG) + DataSize);
+  TxLLData.FragmentTable[0].FragmentLength  = (UINT32) (sizeof (EAS_MNP_FRAG_FLAG) + DataSize);
   TxLLData.FragmentTable[0].FragmentBuffer  = Buffer;
 
   EntsCopyMem (TxLLData.FragmentTable[0].FragmentBuffer, &FragFlag.LLFlag, sizeof (EAS_MNP_FRAG_FLAG));
+  if (DataSize != 0) {
+    EntsCopyMem (Buffer + sizeof (EAS_MNP_FRAG_FLAG), Data, DataSize);
+  }
 
   //
   // Ready to send buffer
@@ -39,6 +39,7 @@ Abstract:
 #define ENTS_SERVER_MAC_ADDRESS_NAME  L"ServerMac"
 #define ENTS_APP_SEQUENCE_NAME        L"AppSequence"
 #define ENTS_LINK_SEQUENCE_NAME       L"LinkSequence"
+#define ENTS_LINK_WINDOW_NAME         L"LinkWindow"
 #define ENTS_MNP_MONITOR_NAME         L"Mnp"
 
 #pragma pack(1)
@@ -66,6 +67,7 @@ typedef union {
 #define LINK_OPERATION_PROBE_ACK   0x02
 #define LINK_OPERATION_DATA        0x11
 #define LINK_OPERATION_DATA_ACK    0x12
+#define LINK_OPERATION_DATA_SACK   0x13
 #define LINK_OPERATION_CLEANUP     0x21
 #define LINK_OPERATION_CLEANUP_ACK 0x22
 
@@ -86,6 +88,53 @@ typedef enum {
 
 #define MAX_PACKET_LENGTH 1492
 
+//
+// The capability of the windowed link, carried in the payload of PROBE and
+// PROBE_ACK. A peer that does not know it sends no capability, and the link
+// stays stop-and-wait.
+//
+#define LINK_CAPABILITY_SIGNATURE  0x53574E44
+#define LINK_CAPABILITY_VERSION    1
+
+#pragma pack(1)
+typedef struct {
+  UINT32  Signature;
+  UINT8   Version;
+  UINT8   Window;
+  UINT16  MaxMessage;
+} EAS_LINK_CAPABILITY;
+#pragma pack()
+
+//
+// The windowed link agreed with the EMS, saved with the other context.
+// Window is 0 for the stop-and-wait link.
+//
+typedef struct {
+  UINT32  Window;
+  UINT32  MaxMessage;
+} MNP_LINK_CONTEXT;
+
+//
+// In the windowed link the fragments of a message are sent without waiting,
+// at most Window of them unacknowledged. The receiver reports the fragments
+// it holds with DATA_SACK, a bitmap indexed by Offset / MAX_PACKET_LENGTH,
+// and the whole message with DATA_ACK.
+//
+#define LINK_FRAGMENT_MAX          64
+#define LINK_BITMAP_SIZE           (LINK_FRAGMENT_MAX / 8)
+#define LINK_BITMAP_TEST(Map, Index)  (((Map)[(Index) / 8] & (1 << ((Index) % 8))) != 0)
+#define LINK_BITMAP_SET(Map, Index)   ((Map)[(Index) / 8] |= (UINT8) (1 << ((Index) % 8)))
+
+#define MNP_LINK_WINDOW            16
+
+//
+// Unit: mSecond. The link clock ticks every LINK_TICK.
+//
+#define LINK_TICK                  10
+#define LINK_RTO_INITIAL           1000
+#define LINK_RTO_MIN               50
+#define LINK_RTO_MAX               8000
+
 EFI_STATUS
 ManagedNetworkSaveContext (
   IN EFI_ENTS_MONITOR_PROTOCOL                 *This
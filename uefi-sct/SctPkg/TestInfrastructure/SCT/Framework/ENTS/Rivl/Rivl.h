@@ -47,6 +47,12 @@ Abstract:
 #define RIVL_VAR_FEATURE_ADDRESS  0x20
 #define RIVL_VAR_FEATURE_POINTER  0x40
 
+//
+// The name hash tables of variables and types start with this many buckets
+// and double when they hold twice as many names
+//
+#define RIVL_HASH_MIN_SIZE        64
+
 #define RIVL_DEBUG_PRINT
 
 #ifdef RIVL_DEBUG_PRINT
@@ -75,6 +81,9 @@ typedef struct _RIVL_TYPE {
   UINT32            Size;
   UINT32            MemberNumber;
   RIVL_MEMBER       *Member;
+  struct _RIVL_TYPE *NextByName;
+  UINT32            *MemberMap;
+  UINT32            MemberMapSize;
 } RIVL_TYPE;
 
 typedef struct _RIVL_VARIABLE {
@@ -86,6 +95,7 @@ typedef struct _RIVL_VARIABLE {
   UINT32                ArrayNumber;
   UINT32                Attribute;
   VOID                  *Address;
+  struct _RIVL_VARIABLE *NextByName;
 } RIVL_VARIABLE;
 
 extern RIVL_INTERNAL_TYPE gRivlInternalTypeArray[];
@@ -163,6 +173,27 @@ Returns:
 --*/
 ;
 
+UINT32
+RivlNameHash (
+  IN CHAR16                    *Name
+  )
+/*++
+
+Routine Description:
+
+  This func is to hash a variable, type or member name for the lookup tables.
+
+Arguments:
+
+  Name  - The name to be hashed.
+
+Returns:
+
+  The FNV-1a hash of the name.
+
+--*/
+;
+
 RIVL_INTERNAL_TYPE        *
 SearchRivlInternalType (
   IN CHAR16                    *Type
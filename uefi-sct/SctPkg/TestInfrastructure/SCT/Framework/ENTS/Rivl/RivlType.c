@@ -31,6 +31,13 @@ Abstract:
 #include "SctLib.h"
 
 RIVL_TYPE           *gRivlTypeList = NULL;
+
+//
+// gRivlTypeList keeps the types, mRivlTypeHash finds a type by name
+//
+STATIC RIVL_TYPE    **mRivlTypeHash     = NULL;
+STATIC UINT32       mRivlTypeHashSize   = 0;
+STATIC UINT32       mRivlTypeCount      = 0;
 RIVL_INTERNAL_TYPE  gRivlInternalTypeArray[] = {
   {
     L"BOOLEAN",
@@ -103,6 +110,16 @@ AddRivlMember (
   IN UINT32                    Offset
   );
 
+BOOLEAN
+RivlTypeHashGrow (
+  VOID
+  );
+
+VOID
+BuildRivlMemberMap (
+  IN RIVL_TYPE                 *RivlType
+  );
+
 EFI_STATUS
 RivlAddRivlType (
   IN CHAR16                    *TypeBuf
@@ -322,6 +339,7 @@ Returns:
 {
   RIVL_TYPE *NewRivlType;
   RIVL_TYPE *OldRivlType;
+  UINT32    Bucket;
 
   NewRivlType = EntsAllocatePool (sizeof (RIVL_TYPE));
   if (NewRivlType == NULL) {
@@ -361,8 +379,10 @@ Returns:
     EntsFreePool (NewRivlType);
     return EFI_ALREADY_STARTED;
   }
+  BuildRivlMemberMap (NewRivlType);
+
   //
-  // Add to Variable List
+  // Add to Type List
   //
   OldRivlType       = gRivlTypeList;
   gRivlTypeList     = NewRivlType;
@@ -371,6 +391,21 @@ Returns:
     OldRivlType->Prev = NewRivlType;
   }
 
+  mRivlTypeCount++;
+
+  //
+  // A new table hashes the type with all the others
+  //
+  if (((mRivlTypeHash == NULL) || (mRivlTypeCount > mRivlTypeHashSize * 2)) && RivlTypeHashGrow ()) {
+    return EFI_SUCCESS;
+  }
+
+  if (mRivlTypeHash != NULL) {
+    Bucket                      = RivlNameHash (Type) & (mRivlTypeHashSize - 1);
+    NewRivlType->NextByName     = mRivlTypeHash[Bucket];
+    mRivlTypeHash[Bucket]       = NewRivlType;
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -397,6 +432,7 @@ Returns:
 --*/
 {
   RIVL_TYPE *OldRivlType;
+  RIVL_TYPE **Link;
 
   if (Type == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -409,6 +445,17 @@ Returns:
     return EFI_NOT_FOUND;
   }
 
+  if (mRivlTypeHash != NULL) {
+    Link = &mRivlTypeHash[RivlNameHash (Type) & (mRivlTypeHashSize - 1)];
+    while (*Link != OldRivlType) {
+      Link = &(*Link)->NextByName;
+    }
+
+    *Link = OldRivlType->NextByName;
+  }
+
+  mRivlTypeCount--;
+
   if (OldRivlType->Prev != NULL) {
     OldRivlType->Prev->Next = OldRivlType->Next;
   }
@@ -427,6 +474,10 @@ Returns:
     EntsFreePool (OldRivlType->Member);
   }
 
+  if (OldRivlType->MemberMap != NULL) {
+    EntsFreePool (OldRivlType->MemberMap);
+  }
+
   EntsFreePool (OldRivlType);
 
   return EFI_SUCCESS;
@@ -465,11 +516,23 @@ Returns:
       EntsFreePool (OldRivlType->Member);
     }
 
+    if (OldRivlType->MemberMap != NULL) {
+      EntsFreePool (OldRivlType->MemberMap);
+    }
+
     EntsFreePool (OldRivlType);
 
     OldRivlType = gRivlTypeList;
   }
 
+  if (mRivlTypeHash != NULL) {
+    EntsFreePool (mRivlTypeHash);
+  }
+
+  mRivlTypeHash     = NULL;
+  mRivlTypeHashSize = 0;
+  mRivlTypeCount    = 0;
+
   return EFI_SUCCESS;
 }
 
@@ -499,7 +562,20 @@ Returns:
     return NULL;
   }
 
-  RivlType = gRivlTypeList;
+  //
+  // Without the table, out of memory, the list is walked
+  //
+  if (mRivlTypeHash == NULL) {
+    for (RivlType = gRivlTypeList; RivlType != NULL; RivlType = RivlType->Next) {
+      if (SctStrCmp (RivlType->Type, Type) == 0) {
+        return RivlType;
+      }
+    }
+
+    return NULL;
+  }
+
+  RivlType = mRivlTypeHash[RivlNameHash (Type) & (mRivlTypeHashSize - 1)];
   while (RivlType != NULL) {
     if (SctStrCmp (RivlType->Type, Type) == 0) {
       //
@@ -508,12 +584,42 @@ Returns:
       return RivlType;
     }
 
-    RivlType = RivlType->Next;
+    RivlType = RivlType->NextByName;
   }
 
   return NULL;
 }
 
+UINT32
+RivlNameHash (
+  IN CHAR16                    *Name
+  )
+/*++
+
+Routine Description:
+
+  This func is to hash a variable, type or member name for the lookup tables.
+
+Arguments:
+
+  Name  - The name to be hashed.
+
+Returns:
+
+  The FNV-1a hash of the name.
+
+--*/
+{
+  UINT32  Hash;
+
+  Hash = 2166136261U;
+  while (*Name != L'\0') {
+    Hash = (Hash ^ (UINT16) *Name++) * 16777619U;
+  }
+
+  return Hash;
+}
+
 RIVL_INTERNAL_TYPE *
 SearchRivlInternalType (
   IN CHAR16                    *Type
@@ -574,6 +680,23 @@ Returns:
 --*/
 {
   RIVL_MEMBER *RivlMember;
+  UINT32      Slot;
+
+  //
+  // The member map is probed linearly from the hash slot until an empty one
+  //
+  if (RivlType->MemberMap != NULL) {
+    for (Slot = RivlNameHash (Name) & (RivlType->MemberMapSize - 1);
+         RivlType->MemberMap[Slot] != 0;
+         Slot = (Slot + 1) & (RivlType->MemberMapSize - 1)) {
+      RivlMember = RivlType->Member + RivlType->MemberMap[Slot] - 1;
+      if (SctStrCmp (RivlMember->Name, Name) == 0) {
+        return RivlMember;
+      }
+    }
+
+    return NULL;
+  }
 
   RivlMember = RivlType->Member;
   while (RivlMember->Name[0] != L'\0') {
@@ -670,3 +793,103 @@ Returns:
 
   return EFI_INVALID_PARAMETER;
 }
+
+BOOLEAN
+RivlTypeHashGrow (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  This func is to double the type hash table, or create it, and hash all the
+  RivlType again.
+
+Arguments:
+
+  None
+
+Returns:
+
+  TRUE if all the types are hashed in a new table, FALSE if out of memory.
+
+--*/
+{
+  RIVL_TYPE *RivlType;
+  RIVL_TYPE **NewHash;
+  UINT32    NewSize;
+  UINT32    Bucket;
+
+  NewSize = (mRivlTypeHashSize == 0) ? RIVL_HASH_MIN_SIZE : mRivlTypeHashSize * 2;
+  NewHash = EntsAllocateZeroPool (NewSize * sizeof (RIVL_TYPE *));
+  if (NewHash == NULL) {
+    //
+    // Keep the old table, it only gets slower
+    //
+    return FALSE;
+  }
+
+  for (RivlType = gRivlTypeList; RivlType != NULL; RivlType = RivlType->Next) {
+    Bucket                = RivlNameHash (RivlType->Type) & (NewSize - 1);
+    RivlType->NextByName  = NewHash[Bucket];
+    NewHash[Bucket]       = RivlType;
+  }
+
+  if (mRivlTypeHash != NULL) {
+    EntsFreePool (mRivlTypeHash);
+  }
+
+  mRivlTypeHash     = NewHash;
+  mRivlTypeHashSize = NewSize;
+  return TRUE;
+}
+
+VOID
+BuildRivlMemberMap (
+  IN RIVL_TYPE                 *RivlType
+  )
+/*++
+
+Routine Description:
+
+  This func is to build the member map of RivlType: an open addressing table
+  of the member indexes by name, at most half full. Without it the members
+  are searched one by one.
+
+Arguments:
+
+  RivlType  - The RivlType whose members are mapped.
+
+Returns:
+
+  None
+
+--*/
+{
+  UINT32  Size;
+  UINT32  Index;
+  UINT32  Slot;
+
+  RivlType->MemberMap     = NULL;
+  RivlType->MemberMapSize = 0;
+  if ((RivlType->Member == NULL) || (RivlType->MemberNumber == 0)) {
+    return ;
+  }
+
+  for (Size = 4; Size < RivlType->MemberNumber * 2; Size *= 2)
+    ;
+  RivlType->MemberMap = EntsAllocateZeroPool (Size * sizeof (UINT32));
+  if (RivlType->MemberMap == NULL) {
+    return ;
+  }
+
+  RivlType->MemberMapSize = Size;
+  for (Index = 0; Index < RivlType->MemberNumber; Index++) {
+    Slot = RivlNameHash (RivlType->Member[Index].Name) & (Size - 1);
+    while (RivlType->MemberMap[Slot] != 0) {
+      Slot = (Slot + 1) & (Size - 1);
+    }
+
+    RivlType->MemberMap[Slot] = Index + 1;
+  }
+}
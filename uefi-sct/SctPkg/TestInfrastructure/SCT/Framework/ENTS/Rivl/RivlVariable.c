@@ -33,9 +33,22 @@ Abstract:
 
 RIVL_VARIABLE *gRivlVariableList;
 
+//
+// gRivlVariableList keeps the variables, mRivlVariableHash finds a variable
+// by name
+//
+STATIC RIVL_VARIABLE  **mRivlVariableHash   = NULL;
+STATIC UINT32         mRivlVariableHashSize = 0;
+STATIC UINT32         mRivlVariableCount    = 0;
+
 //
 // Internal functions
 //
+BOOLEAN
+RivlVariableHashGrow (
+  VOID
+  );
+
 UINT32
 GetSizeFromTypeList (
   IN CHAR16                    *Type
@@ -229,6 +242,7 @@ Returns:
 {
   RIVL_VARIABLE *NewRivlVariable;
   RIVL_VARIABLE *OldRivlVariable;
+  UINT32        Bucket;
 
   //
   // Create node
@@ -319,6 +333,22 @@ Returns:
     OldRivlVariable->Prev = NewRivlVariable;
   }
 
+  mRivlVariableCount++;
+
+  //
+  // A new table hashes the variable with all the others
+  //
+  if (((mRivlVariableHash == NULL) || (mRivlVariableCount > mRivlVariableHashSize * 2)) &&
+      RivlVariableHashGrow ()) {
+    return EFI_SUCCESS;
+  }
+
+  if (mRivlVariableHash != NULL) {
+    Bucket                      = RivlNameHash (Name) & (mRivlVariableHashSize - 1);
+    NewRivlVariable->NextByName = mRivlVariableHash[Bucket];
+    mRivlVariableHash[Bucket]   = NewRivlVariable;
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -345,6 +375,7 @@ Returns:
 --*/
 {
   RIVL_VARIABLE *OldRivlVariable;
+  RIVL_VARIABLE **Link;
 
   if (Name == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -357,6 +388,17 @@ Returns:
     return EFI_NOT_FOUND;
   }
 
+  if (mRivlVariableHash != NULL) {
+    Link = &mRivlVariableHash[RivlNameHash (Name) & (mRivlVariableHashSize - 1)];
+    while (*Link != OldRivlVariable) {
+      Link = &(*Link)->NextByName;
+    }
+
+    *Link = OldRivlVariable->NextByName;
+  }
+
+  mRivlVariableCount--;
+
   if (OldRivlVariable->Prev != NULL) {
     OldRivlVariable->Prev->Next = OldRivlVariable->Next;
   }
@@ -442,6 +484,14 @@ Returns:
     OldRivlVariable = gRivlVariableList;
   }
 
+  if (mRivlVariableHash != NULL) {
+    EntsFreePool (mRivlVariableHash);
+  }
+
+  mRivlVariableHash     = NULL;
+  mRivlVariableHashSize = 0;
+  mRivlVariableCount    = 0;
+
   return EFI_SUCCESS;
 }
 
@@ -471,7 +521,20 @@ Returns:
     return NULL;
   }
 
-  RivlVariable = gRivlVariableList;
+  //
+  // Without the table, out of memory, the list is walked
+  //
+  if (mRivlVariableHash == NULL) {
+    for (RivlVariable = gRivlVariableList; RivlVariable != NULL; RivlVariable = RivlVariable->Next) {
+      if (SctStrCmp (RivlVariable->Name, Name) == 0) {
+        return RivlVariable;
+      }
+    }
+
+    return NULL;
+  }
+
+  RivlVariable = mRivlVariableHash[RivlNameHash (Name) & (mRivlVariableHashSize - 1)];
   while (RivlVariable != NULL) {
     if (SctStrCmp (RivlVariable->Name, Name) == 0) {
       //
@@ -480,12 +543,62 @@ Returns:
       return RivlVariable;
     }
 
-    RivlVariable = RivlVariable->Next;
+    RivlVariable = RivlVariable->NextByName;
   }
 
   return NULL;
 }
 
+BOOLEAN
+RivlVariableHashGrow (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  This func is to double the variable hash table, or create it, and hash all
+  the RivlVariable again.
+
+Arguments:
+
+  None
+
+Returns:
+
+  TRUE if all the variables are hashed in a new table, FALSE if out of memory.
+
+--*/
+{
+  RIVL_VARIABLE *RivlVariable;
+  RIVL_VARIABLE **NewHash;
+  UINT32        NewSize;
+  UINT32        Bucket;
+
+  NewSize = (mRivlVariableHashSize == 0) ? RIVL_HASH_MIN_SIZE : mRivlVariableHashSize * 2;
+  NewHash = EntsAllocateZeroPool (NewSize * sizeof (RIVL_VARIABLE *));
+  if (NewHash == NULL) {
+    //
+    // Keep the old table, it only gets slower
+    //
+    return FALSE;
+  }
+
+  for (RivlVariable = gRivlVariableList; RivlVariable != NULL; RivlVariable = RivlVariable->Next) {
+    Bucket                    = RivlNameHash (RivlVariable->Name) & (NewSize - 1);
+    RivlVariable->NextByName  = NewHash[Bucket];
+    NewHash[Bucket]           = RivlVariable;
+  }
+
+  if (mRivlVariableHash != NULL) {
+    EntsFreePool (mRivlVariableHash);
+  }
+
+  mRivlVariableHash     = NewHash;
+  mRivlVariableHashSize = NewSize;
+  return TRUE;
+}
+
 EFI_STATUS
 RivlSetRivlVariable (
   IN CHAR16                    *VarBuf
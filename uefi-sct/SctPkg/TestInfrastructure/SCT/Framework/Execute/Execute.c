@@ -121,6 +121,16 @@ GetLibInstanceNo (
   IN SCT_LIST_ENTRY        *LinkHead
   );
 
+VOID
+ResetSystemForTestCase (
+  IN UINT32                       CaseAttribute
+  );
+
+VOID
+ReportTestResets (
+  VOID
+  );
+
 //
 // External functions implementation
 //
@@ -213,6 +223,29 @@ Returns:
     goto FUNC_EXIT;
   }
 
+  Status = ClearTestResets ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Clear test resets - %r", Status));
+  }
+
+  //
+  // Run the test cases which require a system reset at the end. The flag is
+  // kept for this run, so the resumed execution keeps the same order.
+  //
+  Status = BatchResetTestCases (gFT->ConfigData->EnableResetBatching);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Batch reset test cases - %r", Status));
+    goto FUNC_EXIT;
+  }
+
+  if (gFT->ConfigData->EnableResetBatching) {
+    Status = SetTestResetBatching (TRUE);
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Set test reset batching - %r", Status));
+      goto FUNC_EXIT;
+    }
+  }
+
   //
   // 3. Find the next test case
   //
@@ -282,6 +315,7 @@ Returns:
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *Vol = NULL;
   EFI_FILE_HANDLE                  RootDir;
   EFI_DEVICE_PATH_PROTOCOL         *DevicePath = gFT->DevicePath;
+  BOOLEAN                          ResetBatching;
   
   SctPrint (L"Continue test preparing...\n");
  
@@ -341,6 +375,20 @@ Returns:
   //
   gFT->IsFirstTimeExecute = FALSE;
 
+  //
+  // Keep the execution order of the run, if it batches the reset test cases
+  //
+  Status = GetTestResetBatching (&ResetBatching);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Get test reset batching - %r", Status));
+  }
+
+  Status = BatchResetTestCases (ResetBatching);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Batch reset test cases - %r", Status));
+    goto FUNC_EXIT;
+  }
+
   //
   // Find the running test case
   //
@@ -444,6 +492,16 @@ Routine Description:
     return Status;
   }
 
+  //
+  // Save the selected test cases. The test case boundaries during execution
+  // only append to the test case journal.
+  //
+  Status = SaveTestCases ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Save test cases - %r", Status));
+    return Status;
+  }
+
   //
   // Reset the execute test results
   //
@@ -459,6 +517,7 @@ Routine Description:
   // Start the execution
   //
   Status = ExecuteMainFunc (&ExecuteInfo);
+  FreeIhvConfigCache ();
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Execute - %r", Status));
     return Status;
@@ -470,6 +529,8 @@ Routine Description:
     return Status;
   }
 
+  ReportTestResets ();
+
   //
   // Done
   //
@@ -554,6 +615,7 @@ Routine Description:
   // Start the execution
   //
   Status = ExecuteMainFunc (&ExecuteInfo);
+  FreeIhvConfigCache ();
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Execute - %r", Status));
     return Status;
@@ -565,6 +627,8 @@ Routine Description:
     return Status;
   }
 
+  ReportTestResets ();
+
   //
   // Done
   //
@@ -634,6 +698,15 @@ Routine Description:
       return Status;
     }
 
+    //
+    // Record the results of this test case
+    //
+    Status = JournalTestCase (ExecuteInfo->TestCase);
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Journal test case - %r", Status));
+      return Status;
+    }
+
     //
     // Send assertion to remotion computer in passive mode to inform case end.
     //
@@ -1433,13 +1506,7 @@ Routine Description:
     // Reset required
     //
     if ((BbEntry->CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) != 0) {
-      FreeDebugServices ();
-
-      //
-      // Free 1 second to let all flush works done
-      //
-      tBS->Stall (1000000);
-      tRT->ResetSystem (EfiResetCold, EFI_SUCCESS, 0, NULL);
+      ResetSystemForTestCase (BbEntry->CaseAttribute);
     }
   }
 
@@ -1546,13 +1613,7 @@ Routine Description:
     // Reset required
     //
     if ((WbEntry->CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) != 0) {
-      FreeDebugServices ();
-
-      //
-      // Free 1 second to let all flush works done
-      //
-      tBS->Stall (1000000);
-      tRT->ResetSystem (EfiResetCold, EFI_SUCCESS, 0, NULL);
+      ResetSystemForTestCase (WbEntry->CaseAttribute);
     }
   }
 
@@ -1671,13 +1732,7 @@ Routine Description:
     // Reset required
     //
     if ((ApEntry->CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) != 0) {
-      FreeDebugServices ();
-
-      //
-      // Free 1 second to let all flush works done
-      //
-      tBS->Stall (1000000);
-      tRT->ResetSystem (EfiResetCold, EFI_SUCCESS, 0, NULL);
+      ResetSystemForTestCase (ApEntry->CaseAttribute);
     }
   }
 
@@ -1852,6 +1907,7 @@ Routine Description:
   }
 
   ConfigData->VerboseLevel        = gFT->ConfigData->VerboseLevel;
+  ConfigData->BinaryKeyFile       = gFT->ConfigData->EnableBinaryKeyFile;
 
   //
   // Set the test category and device path info
@@ -2080,6 +2136,15 @@ Routine Description:
     }
   }
 
+  //
+  // The head line of the key file must be on the disk before the watchdog
+  // timer is set, otherwise a hang could not be detected after the reset
+  //
+  Status = FlushOutputFiles ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Flush output files - %r", Status));
+  }
+
   //
   // Set the watchdog timer for recovery
   //
@@ -2096,6 +2161,14 @@ Routine Description:
     EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Set watchdog timer - %r", Status));
   }
 
+  //
+  // Start the profiling
+  //
+  Status = StartInstanceProfile (ExecuteInfo);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Start instance profile - %r", Status));
+  }
+
   //
   // Done
   //
@@ -2142,6 +2215,14 @@ Routine Description:
     EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Set watchdog timer - %r", Status));
   }
 
+  //
+  // Stop the profiling while the assertion counters are still valid
+  //
+  Status = StopInstanceProfile (ExecuteInfo);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Stop instance profile - %r", Status));
+  }
+
   //
   // Stop the logging
   //
@@ -2161,6 +2242,14 @@ Routine Description:
     EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Stop test logging - %r", Status));
   }
 
+  //
+  // Write out the buffered output at the end of the test instance
+  //
+  Status = FlushOutputFiles ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Flush output files - %r", Status));
+  }
+
   //
   // Remove recovery file
   //
@@ -2191,3 +2280,135 @@ GetLibInstanceNo (
 
   return Index; 
 }
+
+
+VOID
+ResetSystemForTestCase (
+  IN UINT32                       CaseAttribute
+  )
+/*++
+
+Routine Description:
+
+  Reset the system for a test case which requires it. All test data is
+  written and flushed down to the boot medium before the reset. A warm reset
+  is used if the test case allows it.
+
+--*/
+{
+  EFI_STATUS                Status;
+  EFI_RESET_TYPE            ResetType;
+  EFI_HANDLE                DeviceHandle;
+  EFI_BLOCK_IO_PROTOCOL     *BlockIo;
+  EFI_DEVICE_PATH_PROTOCOL  *RemainingDevicePath;
+
+  if ((CaseAttribute & EFI_TEST_CASE_WARM_RESET) != 0) {
+    ResetType = EfiResetWarm;
+  } else {
+    ResetType = EfiResetCold;
+  }
+
+  Status = RecordTestReset (ResetType);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Record test reset - %r", Status));
+  }
+
+  //
+  // Write out the buffered output and close the open files
+  //
+  FlushOutputFiles ();
+  FreeDebugServices ();
+  CloseTestCaseJournal ();
+  PassiveTestContextSync ();
+
+  //
+  // Flush the device of the boot medium. Once it returns, all data written
+  // through the file system is on the media, no need to wait any more.
+  //
+  RemainingDevicePath = gFT->DevicePath;
+  Status = tBS->LocateDevicePath (
+                 &gEfiBlockIoProtocolGuid,
+                 &RemainingDevicePath,
+                 &DeviceHandle
+                 );
+  if (!EFI_ERROR (Status)) {
+    Status = tBS->HandleProtocol (
+                   DeviceHandle,
+                   &gEfiBlockIoProtocolGuid,
+                   (VOID **) &BlockIo
+                   );
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = BlockIo->FlushBlocks (BlockIo);
+  }
+
+  if (EFI_ERROR (Status)) {
+    //
+    // No way to know when the data is on the media, wait as before
+    //
+    tBS->Stall (1000000);
+  }
+
+  tRT->ResetSystem (ResetType, EFI_SUCCESS, 0, NULL);
+}
+
+
+VOID
+ReportTestResets (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Report the number of system resets issued for the test cases in this run,
+  and how many test cases without reset ran before the first reset, compared
+  with the selected order.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINT32      WarmResets;
+  UINT32      ColdResets;
+  UINTN       Cases;
+  UINTN       BaselineCases;
+  UINTN       BatchedCases;
+
+  Status = GetTestResets (&WarmResets, &ColdResets);
+  if (EFI_ERROR (Status) || ((WarmResets == 0) && (ColdResets == 0))) {
+    return;
+  }
+
+  SctPrint (
+    L"  System resets: %d cold, %d warm\n",
+    (UINTN) ColdResets,
+    (UINTN) WarmResets
+    );
+
+  EFI_SCT_DEBUG ((
+    EFI_SCT_D_DEBUG,
+    L"System resets: %d cold, %d warm",
+    (UINTN) ColdResets,
+    (UINTN) WarmResets
+    ));
+
+  Status = GetResetBatchingGain (&Cases, &BaselineCases, &BatchedCases);
+  if (EFI_ERROR (Status) || (Cases == 0)) {
+    return;
+  }
+
+  SctPrint (
+    L"  Cases without reset before the first reset: %d of %d (%d in the selected order)\n",
+    BatchedCases,
+    Cases,
+    BaselineCases
+    );
+
+  EFI_SCT_DEBUG ((
+    EFI_SCT_D_DEBUG,
+    L"Cases without reset before the first reset: %d of %d (%d in the selected order)",
+    BatchedCases,
+    Cases,
+    BaselineCases
+    ));
+}
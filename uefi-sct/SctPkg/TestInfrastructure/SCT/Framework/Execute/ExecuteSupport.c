@@ -32,6 +32,22 @@ Abstract:
 
 #define EFI_SCT_MAX_BUFFER_SIZE             512
 
+//
+// The handles of the device configuration file, and the interfaces of the
+// protocol under test on them. They are resolved once and kept until the
+// handle database changes or the execution ends.
+//
+BOOLEAN                   mIhvConfigValid        = FALSE;
+UINTN                     mIhvNoConfigHandles    = 0;
+EFI_HANDLE                *mIhvConfigHandles     = NULL;
+EFI_EVENT                 mIhvConfigEvent        = NULL;
+VOID                      *mIhvConfigRegistration;
+
+BOOLEAN                   mIhvInterfaceValid     = FALSE;
+EFI_GUID                  mIhvInterfaceGuid;
+EFI_SCT_INTERFACE_INDEX   mIhvInterfaceIndex     = { NULL, 0 };
+EFI_EVENT                 mIhvInterfaceEvent     = NULL;
+VOID                      *mIhvInterfaceRegistration;
 
 //
 // Internal functions declarations
@@ -105,6 +121,8 @@ Returns:
   ExecuteInfo->Warnings     = 0;
   ExecuteInfo->Failures     = 0;
 
+  SctZeroMem (&ExecuteInfo->Profile, sizeof(EFI_SCT_INSTANCE_PROFILE));
+
   //
   // Search the related test file
   //
@@ -844,7 +862,7 @@ GatherConfigHandles (
   EFI_INI_FILE_HANDLE                 IniFile;
   UINT32                              Order;
   UINT32                              OrderNum;
-  CHAR16                              Buffer[EFI_SCT_MAX_BUFFER_SIZE];
+  CHAR16                              *Buffer;
   UINTN                               Index;
   UINTN                               NoHandles;
   EFI_HANDLE                          *HandleBuffer;
@@ -945,60 +963,72 @@ GatherConfigHandles (
   }
 
   //
-  // Scan each device configuration data
+  // Read the device paths of all device configuration data. A device path
+  // which is missing or already matched is left empty.
   //
+  Status = tBS->AllocatePool (
+                   EfiBootServicesData,
+                   sizeof(CHAR16) * EFI_SCT_MAX_BUFFER_SIZE * (OrderNum + 1),
+                   (VOID **)&Buffer
+                   );
+  if (EFI_ERROR (Status)) {
+    ProfileLib->EfiIniClose (ProfileLib, IniFile);
+    tBS->FreePool (HandleBuffer);
+    tBS->FreePool (*ConfigHandleBuffer);
+    return Status;
+  }
+
   for (Order = 0; Order < OrderNum; Order++) {
-    //
-    // Here, only need to find the matched device path in the system
-    //
     Status = DeviceConfigGetString (
                IniFile,
                Order,
                L"DevicePath",
-               Buffer
+               Buffer + Order * EFI_SCT_MAX_BUFFER_SIZE
                );
+    if (EFI_ERROR (Status)) {
+      Buffer[Order * EFI_SCT_MAX_BUFFER_SIZE] = L'\0';
+    }
+  }
+
+  //
+  // Convert the device path of each handle once, and match it against the
+  // device configuration data. The first handle of a device path wins.
+  //
+  for (Index = 0; Index < NoHandles; Index++) {
+    Status = tBS->HandleProtocol (
+                     HandleBuffer[Index],
+                     &gEfiDevicePathProtocolGuid,
+                     (VOID **)&DevicePath
+                     );
     if (EFI_ERROR (Status)) {
       continue;
     }
 
-    //
-    // Search the matched device path in the system
-    //
-    for (Index = 0; Index < NoHandles; Index++) {
-      Status = tBS->HandleProtocol (
-                       HandleBuffer[Index],
-                       &gEfiDevicePathProtocolGuid,
-                       (VOID **)&DevicePath
-                       );
-      if (EFI_ERROR (Status)) {
-        continue;
-      }
+    DevicePathStr = SctDevicePathToStr (DevicePath);
+    if (DevicePathStr == NULL) {
+      continue;
+    }
 
-      DevicePathStr = SctDevicePathToStr (DevicePath);
+    for (Order = 0; Order < OrderNum; Order++) {
+      if ((Buffer[Order * EFI_SCT_MAX_BUFFER_SIZE] != L'\0') &&
+          (SctStrCmp (Buffer + Order * EFI_SCT_MAX_BUFFER_SIZE, DevicePathStr) == 0)) {
+        Buffer[Order * EFI_SCT_MAX_BUFFER_SIZE] = L'\0';
 
-      if (SctStrCmp (Buffer, DevicePathStr) == 0) {
-        tBS->FreePool (DevicePathStr);
-        break;
+        InsertChildHandles (
+          NoConfigHandles,
+          *ConfigHandleBuffer,
+          HandleBuffer[Index]
+          );
       }
-
-      tBS->FreePool (DevicePathStr);
     }
 
-    //
-    // Found it?
-    //
-    if (Index < NoHandles) {
-      InsertChildHandles (
-        NoConfigHandles,
-        *ConfigHandleBuffer,
-        HandleBuffer[Index]
-        );
-    }
+    tBS->FreePool (DevicePathStr);
   }
 
   //
   // Free resources
   //
+  tBS->FreePool (Buffer);
   tBS->FreePool (HandleBuffer);
 
   //
@@ -1012,48 +1042,374 @@ GatherConfigHandles (
   return EFI_SUCCESS;
 }
 
+STATIC
+VOID
+EFIAPI
+IhvCacheChangedNotify (
+  IN EFI_EVENT                  Event,
+  IN VOID                       *Context
+  )
+/*++
+
+Routine Description:
+
+  Invalidate a part of the IHV configuration cache when a protocol is
+  installed. Context points to the valid flag of that part.
+
+--*/
+{
+  *(BOOLEAN *) Context = FALSE;
+}
+
+STATIC
+EFI_STATUS
+RegisterIhvCacheNotify (
+  IN EFI_GUID                   *ProtocolGuid,
+  IN BOOLEAN                    *Valid,
+  OUT EFI_EVENT                 *Event,
+  OUT VOID                      **Registration
+  )
+/*++
+
+Routine Description:
+
+  Create an event which clears the valid flag whenever the protocol is
+  installed or reinstalled on any handle.
+
+--*/
+{
+  EFI_STATUS  Status;
+
+  Status = tBS->CreateEvent (
+#if (EFI_SPECIFICATION_VERSION < 0x00020028)
+                  EFI_EVENT_NOTIFY_SIGNAL,
+                  EFI_TPL_CALLBACK,
+#else
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+#endif
+                  (EFI_EVENT_NOTIFY) IhvCacheChangedNotify,
+                  Valid,
+                  Event
+                  );
+  if (EFI_ERROR (Status)) {
+    *Event = NULL;
+    return Status;
+  }
+
+  Status = tBS->RegisterProtocolNotify (
+                  ProtocolGuid,
+                  *Event,
+                  Registration
+                  );
+  if (EFI_ERROR (Status)) {
+    tBS->CloseEvent (*Event);
+    *Event = NULL;
+    return Status;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_SCT_INTERFACE_SLOT *
+FindInterfaceSlot (
+  IN EFI_SCT_INTERFACE_INDEX    *InterfaceIndex,
+  IN VOID                       *Interface
+  )
+/*++
+
+Routine Description:
+
+  Find the slot of an interface in the index. Returns the slot holding the
+  interface, or the empty slot where it would be inserted, or NULL if the
+  index has not been created.
+
+--*/
+{
+  UINTN                     Hash;
+  UINTN                     Mask;
+  UINTN                     Count;
+  EFI_SCT_INTERFACE_SLOT    *Slot;
+
+  if ((InterfaceIndex->Slots == NULL) || (InterfaceIndex->SlotCount == 0)) {
+    return NULL;
+  }
+
+  //
+  // Interfaces are pool allocations, so the low bits carry no information
+  //
+  Hash = ((UINTN) Interface >> 3) * 2654435761U;
+  Mask = InterfaceIndex->SlotCount - 1;
+  Hash = Hash & Mask;
+
+  for (Count = 0; Count < InterfaceIndex->SlotCount; Count ++) {
+    Slot = &InterfaceIndex->Slots[(Hash + Count) & Mask];
+    if ((Slot->Interface == NULL) || (Slot->Interface == Interface)) {
+      return Slot;
+    }
+  }
+
+  //
+  // The index is never full
+  //
+  return NULL;
+}
+
+STATIC
+EFI_STATUS
+BuildInterfaceIndex (
+  IN UINTN                      NoHandles,
+  IN EFI_HANDLE                 *HandleBuffer,
+  IN EFI_GUID                   *ProtocolGuid,
+  OUT EFI_SCT_INTERFACE_INDEX   *InterfaceIndex
+  )
+/*++
+
+Routine Description:
+
+  Index the interfaces of a protocol on the handles by interface.
+
+--*/
+{
+  EFI_STATUS                Status;
+  UINTN                     Index;
+  VOID                      *Interface;
+  EFI_SCT_INTERFACE_SLOT    *Slot;
+
+  //
+  // Keep the load factor at most one half
+  //
+  InterfaceIndex->SlotCount = 16;
+  while (InterfaceIndex->SlotCount < NoHandles * 2) {
+    InterfaceIndex->SlotCount = InterfaceIndex->SlotCount * 2;
+  }
+
+  Status = tBS->AllocatePool (
+                  EfiBootServicesData,
+                  sizeof(EFI_SCT_INTERFACE_SLOT) * InterfaceIndex->SlotCount,
+                  (VOID **)&InterfaceIndex->Slots
+                  );
+  if (EFI_ERROR (Status)) {
+    InterfaceIndex->Slots     = NULL;
+    InterfaceIndex->SlotCount = 0;
+    return Status;
+  }
+
+  SctZeroMem (
+    InterfaceIndex->Slots,
+    sizeof(EFI_SCT_INTERFACE_SLOT) * InterfaceIndex->SlotCount
+    );
+
+  for (Index = 0; Index < NoHandles; Index++) {
+    Status = tBS->HandleProtocol (
+                     HandleBuffer[Index],
+                     ProtocolGuid,
+                     (VOID **) &Interface
+                     );
+    if (EFI_ERROR (Status) || (Interface == NULL)) {
+      continue;
+    }
+
+    Slot = FindInterfaceSlot (InterfaceIndex, Interface);
+    if ((Slot != NULL) && (Slot->Interface == NULL)) {
+      Slot->Interface = Interface;
+      Slot->Handle    = HandleBuffer[Index];
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeInterfaceIndex (
+  IN OUT EFI_SCT_INTERFACE_INDEX  *InterfaceIndex
+  )
+{
+  if (InterfaceIndex->Slots != NULL) {
+    tBS->FreePool (InterfaceIndex->Slots);
+  }
+
+  InterfaceIndex->Slots     = NULL;
+  InterfaceIndex->SlotCount = 0;
+}
+
 BOOLEAN
 IhvInterfaceFilter (
   IN VOID                       *ClientInterface,
   IN EFI_HANDLE                 SupportHandle,
   IN EFI_GUID                   *ProtocolGuid
   )
+/*++
+
+Routine Description:
+
+  Check whether the interface is installed on a handle of the device
+  configuration file, or on one of their child handles.
+
+  The handles are gathered on the first call and the interfaces of the
+  protocol on them are indexed, so that later calls only look up the index.
+  Installing a device path invalidates the handles, installing the protocol
+  invalidates the index. The valid flags are set before rebuilding, so that
+  a change during the rebuild is not lost.
+
+--*/
 {
-  EFI_STATUS            Status;
-  BOOLEAN               Result;
-  UINTN                 NoConfigHandles;
-  EFI_HANDLE            *ConfigHandleBuffer;
+  EFI_STATUS                Status;
+  VOID                      *Interface;
+  EFI_SCT_INTERFACE_SLOT    *Slot;
 
   //
   // Gather all related handles from device configuration file
   //
-  Status = GatherConfigHandles (
-             SupportHandle,
-             &NoConfigHandles,
-             &ConfigHandleBuffer
-             );
-  if (EFI_ERROR (Status)) {
-    return FALSE;
+  if (!mIhvConfigValid) {
+    if (mIhvConfigEvent == NULL) {
+      RegisterIhvCacheNotify (
+        &gEfiDevicePathProtocolGuid,
+        &mIhvConfigValid,
+        &mIhvConfigEvent,
+        &mIhvConfigRegistration
+        );
+    }
+
+    if (mIhvConfigHandles != NULL) {
+      tBS->FreePool (mIhvConfigHandles);
+      mIhvConfigHandles = NULL;
+    }
+
+    //
+    // Without a device configuration file no handle is tested
+    //
+    mIhvConfigValid = TRUE;
+    Status = GatherConfigHandles (
+               SupportHandle,
+               &mIhvNoConfigHandles,
+               &mIhvConfigHandles
+               );
+    if (EFI_ERROR (Status)) {
+      mIhvNoConfigHandles = 0;
+      mIhvConfigHandles   = NULL;
+    }
+
+    //
+    // Without the notification the handles are gathered again next time
+    //
+    if (mIhvConfigEvent == NULL) {
+      mIhvConfigValid = FALSE;
+    }
+
+    mIhvInterfaceValid = FALSE;
   }
 
   //
-  // Find the matched handle with interface
+  // A NULL interface cannot be indexed, match it on the handles directly
   //
-  Result = MatchHandleInterface (
-             NoConfigHandles,
-             ConfigHandleBuffer,
+  if (ClientInterface == NULL) {
+    return MatchHandleInterface (
+             mIhvNoConfigHandles,
+             mIhvConfigHandles,
              ProtocolGuid,
              ClientInterface
              );
+  }
+
+  //
+  // Index the interfaces of the protocol on these handles
+  //
+  if (!mIhvInterfaceValid || (SctCompareGuid (&mIhvInterfaceGuid, ProtocolGuid) != 0)) {
+    if ((mIhvInterfaceEvent == NULL) || (SctCompareGuid (&mIhvInterfaceGuid, ProtocolGuid) != 0)) {
+      if (mIhvInterfaceEvent != NULL) {
+        tBS->CloseEvent (mIhvInterfaceEvent);
+        mIhvInterfaceEvent = NULL;
+      }
+
+      RegisterIhvCacheNotify (
+        ProtocolGuid,
+        &mIhvInterfaceValid,
+        &mIhvInterfaceEvent,
+        &mIhvInterfaceRegistration
+        );
+    }
+
+    FreeInterfaceIndex (&mIhvInterfaceIndex);
+    SctCopyMem (&mIhvInterfaceGuid, ProtocolGuid, sizeof(EFI_GUID));
+
+    mIhvInterfaceValid = TRUE;
+    Status = BuildInterfaceIndex (
+               mIhvNoConfigHandles,
+               mIhvConfigHandles,
+               ProtocolGuid,
+               &mIhvInterfaceIndex
+               );
+    if (EFI_ERROR (Status)) {
+      mIhvInterfaceValid = FALSE;
+      return FALSE;
+    }
+
+    if (mIhvInterfaceEvent == NULL) {
+      mIhvInterfaceValid = FALSE;
+    }
+  }
+
+  //
+  // Find the matched handle with interface
+  //
+  Slot = FindInterfaceSlot (&mIhvInterfaceIndex, ClientInterface);
+  if ((Slot == NULL) || (Slot->Interface == NULL)) {
+    return FALSE;
+  }
 
   //
-  // Free sources
+  // The protocol may have been uninstalled and its interface reused since the
+  // index was built
   //
-  tBS->FreePool (ConfigHandleBuffer);
+  Status = tBS->HandleProtocol (
+                   Slot->Handle,
+                   ProtocolGuid,
+                   (VOID **) &Interface
+                   );
+  if (EFI_ERROR (Status) || (Interface != ClientInterface)) {
+    return FALSE;
+  }
 
   //
   // Done
   //
-  return Result;
+  return TRUE;
 }
 
+VOID
+FreeIhvConfigCache (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Free the IHV configuration cache at the end of an execution, so that the
+  next execution reads the device configuration file again.
+
+--*/
+{
+  if (mIhvConfigEvent != NULL) {
+    tBS->CloseEvent (mIhvConfigEvent);
+    mIhvConfigEvent = NULL;
+  }
+
+  if (mIhvInterfaceEvent != NULL) {
+    tBS->CloseEvent (mIhvInterfaceEvent);
+    mIhvInterfaceEvent = NULL;
+  }
+
+  if (mIhvConfigHandles != NULL) {
+    tBS->FreePool (mIhvConfigHandles);
+    mIhvConfigHandles = NULL;
+  }
+
+  FreeInterfaceIndex (&mIhvInterfaceIndex);
+
+  mIhvNoConfigHandles = 0;
+  mIhvConfigValid     = FALSE;
+  mIhvInterfaceValid  = FALSE;
+}
@@ -27,6 +27,24 @@ Abstract:
 #ifndef _EFI_EXECUTE_SUPPORT_H_
 #define _EFI_EXECUTE_SUPPORT_H_
 
+//
+// EFI_SCT_INSTANCE_PROFILE
+//
+// The state of a test instance when it is started. The differences to the
+// state when it is stopped are written to the profile record. The start is
+// taken from the Timestamp Protocol if it is there, or else from GetTime.
+//
+
+typedef struct {
+  BOOLEAN                   Started;
+  BOOLEAN                   UseTimeStamp;
+  UINT64                    StartTicks;
+  EFI_TIME                  StartTime;
+  UINT32                    Assertions;
+  UINT64                    BytesWritten;
+  UINT64                    FreePages;
+} EFI_SCT_INSTANCE_PROFILE;
+
 //
 // EFI_SCT_EXECUTE_INFO
 //
@@ -49,8 +67,28 @@ typedef struct {
   UINT32                    Passes;
   UINT32                    Warnings;
   UINT32                    Failures;
+
+  EFI_SCT_INSTANCE_PROFILE  Profile;
 } EFI_SCT_EXECUTE_INFO;
 
+//
+// EFI_SCT_INTERFACE_INDEX
+//
+// An open-addressing hash table which maps a protocol interface to the handle
+// it is installed on. A NULL interface means an empty slot. SlotCount is
+// always a power of 2.
+//
+
+typedef struct {
+  VOID                      *Interface;
+  EFI_HANDLE                Handle;
+} EFI_SCT_INTERFACE_SLOT;
+
+typedef struct {
+  EFI_SCT_INTERFACE_SLOT    *Slots;
+  UINTN                     SlotCount;
+} EFI_SCT_INTERFACE_INDEX;
+
 //
 // Support functions declaration
 //
@@ -92,6 +130,16 @@ ResetExecuteTestResults (
   IN EFI_SCT_EXECUTE_INFO         *ExecuteInfo
   );
 
+EFI_STATUS
+StartInstanceProfile (
+  IN EFI_SCT_EXECUTE_INFO         *ExecuteInfo
+  );
+
+EFI_STATUS
+StopInstanceProfile (
+  IN EFI_SCT_EXECUTE_INFO         *ExecuteInfo
+  );
+
 typedef
 BOOLEAN
 (EFIAPI *EFI_INTERFACE_FILTER) (
@@ -107,5 +155,10 @@ IhvInterfaceFilter (
   IN EFI_GUID                   *ProtocolGuid
   );
 
+VOID
+FreeIhvConfigCache (
+  VOID
+  );
+
 
 #endif
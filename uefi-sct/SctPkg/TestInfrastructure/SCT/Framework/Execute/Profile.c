@@ -0,0 +1,413 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2017, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  Profile.c
+
+Abstract:
+
+  This file provides the profiling of the test instances. For each test
+  instance, a profile record is written next to its key file:
+
+    |PROF|<Microseconds>|<Clock>|<Assertions>|<Bytes>|<FreePagesBefore>|<FreePagesAfter>|<CaseGuid>|<CaseName>
+
+  The instances are timed with the Timestamp Protocol. GetTime, whose
+  resolution is often one second, is used only if the protocol is not there.
+  The clock that was used is written in the <Clock> field.
+
+--*/
+
+#include "Sct.h"
+
+//
+// Modular variables
+//
+
+SCT_TIMER   mProfileTimer;
+BOOLEAN     mProfileTimerLocated = FALSE;
+EFI_STATUS  mProfileTimerStatus  = EFI_NOT_STARTED;
+
+//
+// Internal functions declaration
+//
+
+UINT32
+GetAssertionCount (
+  VOID
+  );
+
+UINT64
+GetFreeMemoryPages (
+  VOID
+  );
+
+UINT64
+GetElapsedMicroseconds (
+  IN EFI_SCT_INSTANCE_PROFILE     *Profile
+  );
+
+//
+// External functions implementation
+//
+
+EFI_STATUS
+StartInstanceProfile (
+  IN EFI_SCT_EXECUTE_INFO         *ExecuteInfo
+  )
+/*++
+
+Routine Description:
+
+  Start to profile a test instance. It must be called after the logging is
+  started, since the assertion counters are reset at that time.
+
+Arguments:
+
+  ExecuteInfo   - Pointer to the execute information.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+
+--*/
+{
+  EFI_SCT_INSTANCE_PROFILE  *Profile;
+
+  //
+  // Check parameters
+  //
+  if (ExecuteInfo == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Profile          = &ExecuteInfo->Profile;
+  Profile->Started = FALSE;
+
+  if (!gFT->ConfigData->EnableInstanceProfile) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Take the start time at last, so the profiling itself is not counted
+  //
+  Profile->FreePages    = GetFreeMemoryPages ();
+  Profile->BytesWritten = GetOutputBytesWritten ();
+  Profile->Assertions   = GetAssertionCount ();
+
+  //
+  // The Timestamp Protocol is only located once
+  //
+  if (!mProfileTimerLocated) {
+    mProfileTimerStatus  = SctTimerInit (&mProfileTimer);
+    mProfileTimerLocated = TRUE;
+  }
+
+  Profile->UseTimeStamp = (BOOLEAN) !EFI_ERROR (mProfileTimerStatus);
+  if (Profile->UseTimeStamp) {
+    Profile->StartTicks = SctTimerRead (&mProfileTimer);
+  } else {
+    tRT->GetTime (&Profile->StartTime, NULL);
+  }
+
+  Profile->Started = TRUE;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+StopInstanceProfile (
+  IN EFI_SCT_EXECUTE_INFO         *ExecuteInfo
+  )
+/*++
+
+Routine Description:
+
+  Stop to profile a test instance and write its profile record. It must be
+  called before the logging is stopped.
+
+  An instance resumed after a system reset is only profiled from the resume
+  point on.
+
+Arguments:
+
+  ExecuteInfo   - Pointer to the execute information.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS                Status;
+  EFI_SCT_INSTANCE_PROFILE  *Profile;
+  UINT64                    Microseconds;
+  UINT32                    Assertions;
+  UINT64                    BytesWritten;
+  UINT64                    FreePages;
+  CHAR16                    *FullMetaName;
+  CHAR16                    *FileName;
+  CHAR16                    *Record;
+  UINTN                     BufferSize;
+  EFI_FILE_HANDLE           Handle;
+
+  //
+  // Check parameters
+  //
+  if (ExecuteInfo == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Profile = &ExecuteInfo->Profile;
+  if (!Profile->Started) {
+    return EFI_SUCCESS;
+  }
+
+  Profile->Started = FALSE;
+
+  Microseconds = GetElapsedMicroseconds (Profile);
+  Assertions   = GetAssertionCount () - Profile->Assertions;
+  BytesWritten = GetOutputBytesWritten () - Profile->BytesWritten;
+  FreePages    = GetFreeMemoryPages ();
+
+  //
+  // The profile record is named as the key file
+  //
+  Status = GetFileFullMetaName (ExecuteInfo, &FullMetaName);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Get file full meta name - %r", Status));
+    return Status;
+  }
+
+  FileName = SctPoolPrint (
+               FullMetaName,
+               ExecuteInfo->Index,
+               ExecuteInfo->Iteration,
+               EFI_SCT_PROFILE_FILE_EXT
+               );
+  tBS->FreePool (FullMetaName);
+  if (FileName == NULL) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"SctPoolPrint: Out of resources"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Record = SctPoolPrint (
+             L"%c|%s|%ld|%s|%d|%ld|%ld|%ld|%g|%s\n",
+             (UINTN) 0xFEFF,
+             EFI_SCT_PROFILE_RECORD_TAG,
+             Microseconds,
+             Profile->UseTimeStamp ? EFI_SCT_PROFILE_CLOCK_TIMESTAMP : EFI_SCT_PROFILE_CLOCK_GETTIME,
+             (UINTN) Assertions,
+             BytesWritten,
+             Profile->FreePages,
+             FreePages,
+             &ExecuteInfo->TestCase->Guid,
+             (ExecuteInfo->TestCase->Name != NULL) ? ExecuteInfo->TestCase->Name : L""
+             );
+  if (Record == NULL) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"SctPoolPrint: Out of resources"));
+    tBS->FreePool (FileName);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Write the profile record
+  //
+  Status = SctCreateFileFromDevicePath (
+             gFT->DevicePath,
+             FileName,
+             &Handle
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create profile file - %r", Status));
+    tBS->FreePool (FileName);
+    tBS->FreePool (Record);
+    return Status;
+  }
+
+  BufferSize = SctStrLen (Record) * 2;
+  Status = Handle->Write (Handle, &BufferSize, Record);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Write profile file - %r", Status));
+  }
+
+  Handle->Close (Handle);
+  tBS->FreePool (FileName);
+  tBS->FreePool (Record);
+
+  return Status;
+}
+
+//
+// Internal functions implementation
+//
+
+UINT32
+GetAssertionCount (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the number of the assertions recorded in the current test instance.
+
+--*/
+{
+  UINT32  Passes;
+  UINT32  Warnings;
+  UINT32  Failures;
+
+  Passes   = 0;
+  Warnings = 0;
+  Failures = 0;
+
+  gFT->StslProtocol->GetResultCount (gFT->StslProtocol, EFI_TEST_ASSERTION_PASSED,  &Passes);
+  gFT->StslProtocol->GetResultCount (gFT->StslProtocol, EFI_TEST_ASSERTION_WARNING, &Warnings);
+  gFT->StslProtocol->GetResultCount (gFT->StslProtocol, EFI_TEST_ASSERTION_FAILED,  &Failures);
+
+  return Passes + Warnings + Failures;
+}
+
+
+UINT64
+GetFreeMemoryPages (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the number of the free pages in the memory map. 0 is returned if the
+  memory map could not be got.
+
+--*/
+{
+  EFI_STATUS              Status;
+  UINTN                   MapSize;
+  EFI_MEMORY_DESCRIPTOR   *MemoryMap;
+  EFI_MEMORY_DESCRIPTOR   *Descriptor;
+  UINTN                   MapKey;
+  UINTN                   DescriptorSize;
+  UINT32                  DescriptorVersion;
+  UINTN                   Offset;
+  UINT64                  FreePages;
+
+  //
+  // Get the size of the memory map. Leave some room for the descriptors
+  // added by the allocation of the buffer itself.
+  //
+  MapSize = 0;
+  Status  = tBS->GetMemoryMap (
+                   &MapSize,
+                   NULL,
+                   &MapKey,
+                   &DescriptorSize,
+                   &DescriptorVersion
+                   );
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    return 0;
+  }
+
+  MapSize += 4 * DescriptorSize;
+
+  Status = tBS->AllocatePool (
+                 EfiBootServicesData,
+                 MapSize,
+                 (VOID **)&MemoryMap
+                 );
+  if (EFI_ERROR (Status)) {
+    return 0;
+  }
+
+  Status = tBS->GetMemoryMap (
+                 &MapSize,
+                 MemoryMap,
+                 &MapKey,
+                 &DescriptorSize,
+                 &DescriptorVersion
+                 );
+  if (EFI_ERROR (Status)) {
+    tBS->FreePool (MemoryMap);
+    return 0;
+  }
+
+  FreePages = 0;
+  for (Offset = 0; Offset < MapSize; Offset += DescriptorSize) {
+    Descriptor = (EFI_MEMORY_DESCRIPTOR *) ((UINT8 *) MemoryMap + Offset);
+    if (Descriptor->Type == EfiConventionalMemory) {
+      FreePages += Descriptor->NumberOfPages;
+    }
+  }
+
+  tBS->FreePool (MemoryMap);
+  return FreePages;
+}
+
+
+UINT64
+GetElapsedMicroseconds (
+  IN EFI_SCT_INSTANCE_PROFILE     *Profile
+  )
+/*++
+
+Routine Description:
+
+  Get the elapsed time in microseconds since the profile was started. The
+  resolution is the one of the clock taken by StartInstanceProfile.
+
+--*/
+{
+  UINT64    EndTicks;
+  EFI_TIME  EndTime;
+  EFI_TIME  *StartTime;
+  UINT64    Start;
+  UINT64    End;
+
+  if (Profile->UseTimeStamp) {
+    EndTicks = SctTimerRead (&mProfileTimer);
+    return SctDivU64x32 (
+             SctTimerTicksToNs (
+               &mProfileTimer,
+               SctTimerElapsed (&mProfileTimer, Profile->StartTicks, EndTicks)
+               ),
+             1000,
+             NULL
+             );
+  }
+
+  tRT->GetTime (&EndTime, NULL);
+  StartTime = &Profile->StartTime;
+
+  Start = SctMultU64x32 (
+            ((StartTime->Hour * 60 + StartTime->Minute) * 60 + StartTime->Second),
+            1000000
+            ) + StartTime->Nanosecond / 1000;
+  End   = SctMultU64x32 (
+            ((EndTime.Hour * 60 + EndTime.Minute) * 60 + EndTime.Second),
+            1000000
+            ) + EndTime.Nanosecond / 1000;
+
+  //
+  // A test instance is not expected to run more than one day
+  //
+  if (End < Start) {
+    End += SctMultU64x32 (24 * 60 * 60, 1000000);
+  }
+
+  return End - Start;
+}
@@ -145,6 +145,17 @@ Returns:
     return Status;
   }
 
+  CloseTestCaseJournal ();
+
+  Status = RemoveFile (
+             gFT->DevicePath,
+             gFT->TestCaseJournalName
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Remove TestCase.jnl - %r", Status));
+    return Status;
+  }
+
   //
   // Remove the skipped case
   //
@@ -339,9 +350,9 @@ Returns:
   ExecuteInfo->TestCase->Warnings = EFI_SCT_TEST_CASE_RUNNING;
   ExecuteInfo->TestCase->Failures = EFI_SCT_TEST_CASE_RUNNING;
 
-  Status = SaveTestCases ();
+  Status = JournalTestCase (ExecuteInfo->TestCase);
   if (EFI_ERROR(Status)) {
-    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Save test cases - %r", Status));
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Journal test case - %r", Status));
     return Status;
   }
 
@@ -35,6 +35,8 @@ Abstract:
 #include <Library/EfiTestLib.h>
 #include "LibPrivate.h"
 
+#include EFI_PROTOCOL_DEFINITION (BlockIo)
+
 #include EFI_TEST_PROTOCOL_DEFINITION(TestProfileLibrary)
 #include EFI_TEST_PROTOCOL_DEFINITION(TestRecoveryLibrary)
 #include EFI_TEST_PROTOCOL_DEFINITION(TestLoggingLibrary)
@@ -109,6 +109,47 @@ SaveTestCases (
   VOID
   );
 
+EFI_STATUS
+JournalTestCase (
+  IN EFI_SCT_TEST_CASE            *TestCase
+  );
+
+EFI_STATUS
+ReplayTestCaseJournal (
+  VOID
+  );
+
+EFI_STATUS
+CloseTestCaseJournal (
+  VOID
+  );
+
+EFI_STATUS
+RecordTestReset (
+  IN EFI_RESET_TYPE               ResetType
+  );
+
+EFI_STATUS
+GetTestResets (
+  OUT UINT32                      *WarmResets,
+  OUT UINT32                      *ColdResets
+  );
+
+EFI_STATUS
+SetTestResetBatching (
+  IN BOOLEAN                      ResetBatching
+  );
+
+EFI_STATUS
+GetTestResetBatching (
+  OUT BOOLEAN                     *ResetBatching
+  );
+
+EFI_STATUS
+ClearTestResets (
+  VOID
+  );
+
 EFI_STATUS
 LoadTestSequence (
   IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
@@ -171,6 +212,50 @@ FreeTestNodes (
   IN SCT_LIST_ENTRY               *TestNodeList
   );
 
+//
+// Test manifest services
+//
+
+EFI_STATUS
+LoadTestManifest (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName
+  );
+
+EFI_STATUS
+SaveTestManifest (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  IN SCT_LIST_ENTRY               *TestFileList
+  );
+
+EFI_STATUS
+FreeTestManifest (
+  VOID
+  );
+
+EFI_STATUS
+FindTestManifest (
+  IN CHAR16                       *FileName,
+  IN EFI_FILE_INFO                *FileInfo,
+  OUT EFI_SCT_TEST_FILE_TYPE      *Type,
+  OUT VOID                        **Context
+  );
+
+EFI_STATUS
+AddTestManifest (
+  IN CHAR16                       *FileName,
+  IN EFI_FILE_INFO                *FileInfo,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context
+  );
+
+EFI_STATUS
+FreeTestManifestContext (
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context
+  );
+
 //
 // Skipped Case Services
 //
@@ -114,4 +114,16 @@ BuildTestCaseOrder (
   VOID
   );
 
+EFI_STATUS
+BatchResetTestCases (
+  IN BOOLEAN                      ResetBatching
+  );
+
+EFI_STATUS
+GetResetBatchingGain (
+  OUT UINTN                       *Cases,
+  OUT UINTN                       *BaselineCases,
+  OUT UINTN                       *BatchedCases
+  );
+
 #endif
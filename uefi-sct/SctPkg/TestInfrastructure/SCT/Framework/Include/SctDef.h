@@ -77,13 +77,23 @@ Abstract:
 #define EFI_SCT_FILE_GUID_DATABASE          L"Data\\GuidFile.txt"
 #define EFI_SCT_FILE_RECOVERY               L"Data\\Recovery.dat"
 #define EFI_SCT_FILE_TEST_CASE              L"Data\\TestCase.ini"
+#define EFI_SCT_FILE_TEST_CASE_JOURNAL      L"Data\\TestCase.jnl"
 #define EFI_SCT_FILE_SKIPPED_CASE           L"Data\\SkippedCase.ini"
 #define EFI_SCT_FILE_DEVICE_CONFIG          L"Data\\DeviceConfig.ini"
+#define EFI_SCT_FILE_TEST_MANIFEST          L"Data\\TestManifest.ini"
 #define EFI_SCT_SYNC_FILE_CASE_TREE         L"Data\\CaseTree.ini"
 
 #define EFI_SCT_FILE_SUMMARY_LOG            L"Overall\\Summary.log"
 #define EFI_SCT_FILE_SUMMARY_EKL            L"Overall\\Summary.ekl"
 
+//
+// Profile record of a test instance, kept next to its key file
+//
+#define EFI_SCT_PROFILE_FILE_EXT            L"prf"
+#define EFI_SCT_PROFILE_RECORD_TAG          L"PROF"
+#define EFI_SCT_PROFILE_CLOCK_TIMESTAMP     L"Timestamp"
+#define EFI_SCT_PROFILE_CLOCK_GETTIME       L"GetTime"
+
 //
 // Maximum buffer size in the SCT
 //
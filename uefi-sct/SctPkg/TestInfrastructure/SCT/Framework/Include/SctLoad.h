@@ -107,4 +107,10 @@ FindTestFileByCaseGuid (
   OUT VOID                        **TestEntry
   );
 
+EFI_STATUS
+GetTestCaseAttribute (
+  IN EFI_GUID                     *Guid,
+  OUT EFI_TEST_ATTRIBUTE          *CaseAttribute
+  );
+
 #endif
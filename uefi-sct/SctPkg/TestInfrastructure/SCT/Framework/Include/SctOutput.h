@@ -33,7 +33,15 @@ Abstract:
 
 #define TEST_OUTPUT_PRIVATE_DATA_SIGNATURE  EFI_SIGNATURE_32('T','O','L','I')
 
-#define TEST_OUTPUT_PRIVATE_DATA_REVISION   0x00010000
+#define TEST_OUTPUT_PRIVATE_DATA_REVISION   EFI_TEST_OUTPUT_LIBRARY_REVISION
+
+//
+// Number of buckets in the file handle hash table
+//
+#define TEST_OUTPUT_HASH_SIZE               64
+
+#define TEST_OUTPUT_HASH(FileHandle)        \
+  ((((UINTN) (FileHandle)) >> 3) % TEST_OUTPUT_HASH_SIZE)
 
 //
 // Forward reference for pure ANSI compatibility
@@ -42,16 +50,40 @@ typedef struct _TEST_OUTPUT_FILE TEST_OUTPUT_FILE;
 
 struct _TEST_OUTPUT_FILE {
   TEST_OUTPUT_FILE            *Next;
+  TEST_OUTPUT_FILE            *HashNext;
   EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
   CHAR16                      *FileName;
   EFI_FILE_HANDLE             FileHandle;
   UINTN                       OpenCount;
+
+  //
+  // Ring buffer of the data not yet written to the file
+  //
+  UINT8                       *Buffer;
+  UINTN                       BufferSize;
+  UINTN                       Head;
+  UINTN                       Length;
 };
 
 typedef struct {
   UINT32                                    Signature;
   EFI_TEST_OUTPUT_LIBRARY_PROTOCOL          TestOutput;
   TEST_OUTPUT_FILE                          *OutputFileList;
+  TEST_OUTPUT_FILE                          *HashTable[TEST_OUTPUT_HASH_SIZE];
+
+  //
+  // Buffered output policy. BufferSize is 0 for the write-through mode.
+  //
+  UINTN                                     BufferSize;
+  UINTN                                     FlushInterval;
+  EFI_EVENT                                 FlushEvent;
+  BOOLEAN                                   Busy;
+  EFI_TRL_WRITE_RESET_RECORD                WriteResetRecord;
+
+  //
+  // Total bytes of the strings written through the library
+  //
+  UINT64                                    BytesWritten;
 } TEST_OUTPUT_PRIVATE_DATA;
 
 #define TEST_OUTPUT_PRIVATE_DATA_FROM_THIS(a) \
@@ -63,4 +95,34 @@ typedef struct {
 
 extern EFI_TEST_OUTPUT_LIBRARY_PROTOCOL *gOutputProtocol;
 
+//
+// External functions declaration
+//
+
+EFI_STATUS
+SetOutputBufferPolicy (
+  IN UINTN                        BufferSize,
+  IN UINTN                        FlushInterval
+  );
+
+EFI_STATUS
+FlushOutputFiles (
+  VOID
+  );
+
+UINT64
+GetOutputBytesWritten (
+  VOID
+  );
+
+EFI_STATUS
+HookOutputResetRecord (
+  IN EFI_TEST_RECOVERY_LIBRARY_PROTOCOL   *TrlProtocol
+  );
+
+EFI_STATUS
+UnhookOutputResetRecord (
+  IN EFI_TEST_RECOVERY_LIBRARY_PROTOCOL   *TrlProtocol
+  );
+
 #endif
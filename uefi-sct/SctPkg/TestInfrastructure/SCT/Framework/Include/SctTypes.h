@@ -42,6 +42,12 @@ Abstract:
 #define SCENARIO_STRING_DEFAULT             L""
 #define EDIT_COMMAND_DEFAULT                L"edit"
 #define DEFAULT_SCT_DIRECTORY   L"SCT"
+#define OUTPUT_BUFFER_SIZE_DEFAULT          0x8000
+#define OUTPUT_FLUSH_INTERVAL_DEFAULT       2
+#define ENABLE_TEST_MANIFEST_DEFAULT        TRUE
+#define ENABLE_RESET_BATCHING_DEFAULT       FALSE
+#define ENABLE_INSTANCE_PROFILE_DEFAULT     TRUE
+#define ENABLE_BINARY_KEY_FILE_DEFAULT      FALSE
 
 #define TEST_CASE_MAX_RUN_TIME_MIN          0
 
@@ -65,6 +71,14 @@ typedef struct {
 
   CHAR16                    *EditCommandString;
 
+  UINTN                     OutputBufferSize;
+  UINTN                     OutputFlushInterval;
+
+  BOOLEAN                   EnableTestManifest;
+  BOOLEAN                   EnableResetBatching;
+  BOOLEAN                   EnableInstanceProfile;
+  BOOLEAN                   EnableBinaryKeyFile;
+
   EFI_TEST_LEVEL            TestLevel;
   EFI_VERBOSE_LEVEL         VerboseLevel;
 } EFI_SCT_CONFIG_DATA;
@@ -113,6 +127,11 @@ typedef struct {
   UINT32                    Passes;
   UINT32                    Warnings;
   UINT32                    Failures;
+
+  //
+  // Only kept in memory, set by BatchResetTestCases
+  //
+  BOOLEAN                   ResetBatched;
 } EFI_SCT_TEST_CASE;
 
 
@@ -279,6 +298,9 @@ typedef struct {
 
   EFI_INI_FILE_HANDLE                 TestCaseIniFile;
 
+  CHAR16                              *TestCaseJournalName;
+  EFI_FILE_HANDLE                     TestCaseJournal;
+
   EFI_SCT_CONFIG_DATA                 *ConfigData;
 
   SCT_LIST_ENTRY                      CategoryList;
@@ -484,6 +484,11 @@ Returns:
 
   tBS->FreePool (FileName);
 
+  //
+  // Flush the test output before a test case writes its reset record
+  //
+  HookOutputResetRecord (gFT->TrlProtocol);
+
   //
   // Done
   //
@@ -534,6 +539,7 @@ Returns:
   // EFI test recovery support file
   //
   if ((gFT->TrlProtocol != NULL) || (gFT->TrlInterface != NULL)) {
+    UnhookOutputResetRecord (gFT->TrlProtocol);
     CloseSingleSupportFile (&gEfiTestRecoveryLibraryGuid);
     gFT->TrlProtocol  = NULL;
     gFT->TrlInterface = NULL;
@@ -37,6 +37,44 @@ LoadSingleTestImageFile (
   OUT EFI_SCT_TEST_FILE           **TestFile
   );
 
+EFI_STATUS
+LoadManifestTestFile (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context,
+  OUT EFI_SCT_TEST_FILE           **TestFile
+  );
+
+EFI_STATUS
+LoadSingleTestApFile (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  OUT EFI_SCT_TEST_FILE           **TestFile
+  );
+
+EFI_STATUS
+StartTestImageFile (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  OUT EFI_HANDLE                  *ImageHandle,
+  OUT EFI_SCT_TEST_FILE_TYPE      *Type,
+  OUT VOID                        **Context
+  );
+
+EFI_STATUS
+LoadTestFileImage (
+  IN EFI_SCT_TEST_FILE            *TestFile
+  );
+
+EFI_STATUS
+FindTestEntryInFile (
+  IN EFI_SCT_TEST_FILE            *TestFile,
+  IN EFI_GUID                     *Guid,
+  OUT VOID                        **TestProtocol,
+  OUT VOID                        **TestEntry
+  );
+
 EFI_STATUS
 LoadSingleTestScriptFile (
   IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
@@ -100,6 +138,8 @@ Returns:
   UINTN                             FileInfoSize;
   EFI_FILE_INFO                     *FileInfo;
   EFI_SCT_TEST_FILE                 *TestFile;
+  EFI_SCT_TEST_FILE_TYPE            Type;
+  VOID                              *Context;
   EFI_DEVICE_PATH_PROTOCOL          *RemainderPath;
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL   *Vol;
 
@@ -218,11 +258,40 @@ Returns:
           break;
         }
 
-        Status = LoadSingleTestImageFile (
-                   DevicePath,
+        //
+        // Use the test manifest record if the file is unchanged, otherwise
+        // load the image and record it for the next time
+        //
+        Status = FindTestManifest (
                    FileName,
-                   &TestFile
+                   FileInfo,
+                   &Type,
+                   &Context
                    );
+        if (!EFI_ERROR (Status)) {
+          Status = LoadManifestTestFile (
+                     DevicePath,
+                     FileName,
+                     Type,
+                     Context,
+                     &TestFile
+                     );
+        } else {
+          Status = LoadSingleTestImageFile (
+                     DevicePath,
+                     FileName,
+                     &TestFile
+                     );
+          if (!EFI_ERROR (Status)) {
+            AddTestManifest (
+              FileName,
+              FileInfo,
+              TestFile->Type,
+              TestFile->Context
+              );
+          }
+        }
+
         if (EFI_ERROR (Status)) {
           EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load a test image file - %r", Status));
           tBS->FreePool (FileName);
@@ -377,7 +446,8 @@ FindTestFileByCaseGuid (
 
 Routine Description:
 
-  Search the test file based on the test case's GUID.
+  Search the test file based on the test case's GUID. A test file created from
+  the test manifest gets its image loaded here, on the first use of an entry.
 
 Arguments:
 
@@ -394,14 +464,9 @@ Returns:
 
 --*/
 {
+  EFI_STATUS              Status;
   SCT_LIST_ENTRY          *Link;
   EFI_SCT_TEST_FILE       *TempTestFile;
-  EFI_BB_TEST_PROTOCOL    *BbTest;
-  EFI_BB_TEST_ENTRY       *BbEntry;
-  EFI_WB_TEST_PROTOCOL    *WbTest;
-  EFI_WB_TEST_ENTRY       *WbEntry;
-  EFI_AP_TEST_INTERFACE   *ApTest;
-  EFI_AP_TEST_ENTRY       *ApEntry;
 
   //
   // Check parameters
@@ -417,91 +482,133 @@ Returns:
   for (Link = gFT->TestFileList.ForwardLink; Link != &gFT->TestFileList; Link = Link->ForwardLink) {
     TempTestFile = CR (Link, EFI_SCT_TEST_FILE, Link, EFI_SCT_TEST_FILE_SIGNATURE);
 
+    Status = FindTestEntryInFile (
+               TempTestFile,
+               Guid,
+               TestProtocol,
+               TestEntry
+               );
+    if (Status == EFI_NOT_FOUND) {
+      continue;
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
     //
-    // Deal with the different kinds of test files
+    // The test file was created from the test manifest, load its image
+    // before the entry is used
     //
-    switch (TempTestFile->Type) {
-    case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
-    case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
-      //
-      // Black-box test file
-      //
-      BbTest = (EFI_BB_TEST_PROTOCOL *) TempTestFile->Context;
+    if ((TempTestFile->ImageHandle == NULL) &&
+        ((TempTestFile->Type == EFI_SCT_TEST_FILE_TYPE_BLACK_BOX    ) ||
+         (TempTestFile->Type == EFI_SCT_TEST_FILE_TYPE_WHITE_BOX    ) ||
+         (TempTestFile->Type == EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX))) {
+      Status = LoadTestFileImage (TempTestFile);
+      if (EFI_ERROR (Status)) {
+        EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load test file image - %r", Status));
+        return Status;
+      }
 
-      for (BbEntry = BbTest->EntryList; BbEntry != NULL; BbEntry = BbEntry->Next) {
-        if (SctCompareGuid (Guid, &BbEntry->EntryId) == 0) {
-          break;
-        }
+      Status = FindTestEntryInFile (
+                 TempTestFile,
+                 Guid,
+                 TestProtocol,
+                 TestEntry
+                 );
+      if (EFI_ERROR (Status)) {
+        EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Entry not in test image <%s>", TempTestFile->FileName));
+        return EFI_NOT_FOUND;
       }
+    }
 
-      if (BbEntry != NULL) {
-        *TestFile     = TempTestFile;
-        *TestProtocol = BbTest;
-        *TestEntry    = BbEntry;
+    *TestFile = TempTestFile;
+    return EFI_SUCCESS;
+  }
 
-        return EFI_SUCCESS;
-      }
+  //
+  // Not found
+  //
+  EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Not found"));
+  return EFI_NOT_FOUND;
+}
 
-      break;
 
-    case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
-      //
-      // White-box test file
-      //
-      WbTest = (EFI_WB_TEST_PROTOCOL *) TempTestFile->Context;
+EFI_STATUS
+GetTestCaseAttribute (
+  IN EFI_GUID                     *Guid,
+  OUT EFI_TEST_ATTRIBUTE          *CaseAttribute
+  )
+/*++
 
-      for (WbEntry = WbTest->EntryList; WbEntry != NULL; WbEntry = WbEntry->Next) {
-        if (SctCompareGuid (Guid, &WbEntry->EntryId) == 0) {
-          break;
-        }
-      }
+Routine Description:
 
-      if (WbEntry != NULL) {
-        *TestFile     = TempTestFile;
-        *TestProtocol = WbTest;
-        *TestEntry    = WbEntry;
+  Get the case attribute of a test case. Unlike FindTestFileByCaseGuid, it
+  does not load the image of a test file created from the test manifest.
 
-        return EFI_SUCCESS;
-      }
+Arguments:
 
-      break;
+  Guid          - Specifies GUID to search by.
+  CaseAttribute - Pointer to the case attribute.
 
-    case EFI_SCT_TEST_FILE_TYPE_APPLICATION:
-    case EFI_SCT_TEST_FILE_TYPE_SCRIPT:
-      //
-      // EFI application or script test file
-      //
-      ApTest = (EFI_AP_TEST_INTERFACE *) TempTestFile->Context;
+Returns:
 
-      for (ApEntry = ApTest->EntryList; ApEntry != NULL; ApEntry = ApEntry->Next) {
-        if (SctCompareGuid (Guid, &ApEntry->EntryId) == 0) {
-          break;
-        }
-      }
+  EFI_SUCCESS   - Successfully.
+  EFI_NOT_FOUND - Not found.
+  Other value   - Something failed.
 
-      if (ApEntry != NULL) {
-        *TestFile     = TempTestFile;
-        *TestProtocol = ApTest;
-        *TestEntry    = ApEntry;
+--*/
+{
+  EFI_STATUS              Status;
+  SCT_LIST_ENTRY          *Link;
+  EFI_SCT_TEST_FILE       *TestFile;
+  VOID                    *TestProtocol;
+  VOID                    *TestEntry;
 
-        return EFI_SUCCESS;
-      }
+  //
+  // Check parameters
+  //
+  if ((Guid == NULL) || (CaseAttribute == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Walk through all test files
+  //
+  for (Link = gFT->TestFileList.ForwardLink; Link != &gFT->TestFileList; Link = Link->ForwardLink) {
+    TestFile = CR (Link, EFI_SCT_TEST_FILE, Link, EFI_SCT_TEST_FILE_SIGNATURE);
+
+    Status = FindTestEntryInFile (
+               TestFile,
+               Guid,
+               &TestProtocol,
+               &TestEntry
+               );
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
 
+    switch (TestFile->Type) {
+    case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
+    case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
+      *CaseAttribute = ((EFI_BB_TEST_ENTRY *) TestEntry)->CaseAttribute;
+      break;
+
+    case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
+      *CaseAttribute = ((EFI_WB_TEST_ENTRY *) TestEntry)->CaseAttribute;
       break;
 
     default:
-      //
-      // Unsupported file
-      //
-      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Unsupported file"));
-      return EFI_UNSUPPORTED;
+      *CaseAttribute = ((EFI_AP_TEST_ENTRY *) TestEntry)->CaseAttribute;
+      break;
     }
+
+    return EFI_SUCCESS;
   }
 
   //
   // Not found
   //
-  EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Not found"));
   return EFI_NOT_FOUND;
 }
 
@@ -526,15 +633,8 @@ Routine Description:
 {
   EFI_STATUS                  Status;
   EFI_HANDLE                  ImageHandle;
-  EFI_DEVICE_PATH_PROTOCOL    *FileNode;
-  EFI_DEVICE_PATH_PROTOCOL    *FilePath;
-  EFI_LOADED_IMAGE_PROTOCOL   *LoadedImage;
-  UINTN                       ExitDataSize;
-  CHAR16                      *ExitData;
-  CHAR16                      *ApFileName;
-  EFI_BB_TEST_PROTOCOL        *BbTest;
-  EFI_WB_TEST_PROTOCOL        *WbTest;
-  EFI_AP_TEST_INTERFACE       *ApTest;
+  EFI_SCT_TEST_FILE_TYPE      Type;
+  VOID                        *Context;
 
   //
   // Check parameters
@@ -548,6 +648,201 @@ Routine Description:
   //
   EFI_SCT_DEBUG ((EFI_SCT_D_TRACE, L"Load test image file <%s>", FileName));
 
+  //
+  // Load the test image file and find its test protocol
+  //
+  Status = StartTestImageFile (
+             DevicePath,
+             FileName,
+             &ImageHandle,
+             &Type,
+             &Context
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Type == EFI_SCT_TEST_FILE_TYPE_APPLICATION) {
+    //
+    // It is an application
+    //
+    return LoadSingleTestApFile (
+             DevicePath,
+             FileName,
+             TestFile
+             );
+  }
+
+  //
+  // It is a black-box, white-box or IHV black-box test
+  //
+  Status = CreateSingleTestFile (
+             DevicePath,
+             FileName,
+             ImageHandle,
+             Type,
+             Context,
+             TestFile
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
+    tBS->UnloadImage (ImageHandle);
+    return Status;
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+LoadManifestTestFile (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  IN EFI_SCT_TEST_FILE_TYPE       Type,
+  IN VOID                         *Context,
+  OUT EFI_SCT_TEST_FILE           **TestFile
+  )
+/*++
+
+Routine Description:
+
+  Create a single test file from its test manifest record, without loading the
+  test image file.
+
+--*/
+{
+  EFI_STATUS  Status;
+
+  //
+  // Debug information
+  //
+  EFI_SCT_DEBUG ((EFI_SCT_D_TRACE, L"Load test image file <%s> from manifest", FileName));
+
+  if (Type == EFI_SCT_TEST_FILE_TYPE_APPLICATION) {
+    //
+    // The application test only needs its INI file
+    //
+    return LoadSingleTestApFile (
+             DevicePath,
+             FileName,
+             TestFile
+             );
+  }
+
+  //
+  // The image handle stays NULL until an entry is executed
+  //
+  Status = CreateSingleTestFile (
+             DevicePath,
+             FileName,
+             NULL,
+             Type,
+             Context,
+             TestFile
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
+    FreeTestManifestContext (Type, Context);
+    return Status;
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+LoadSingleTestApFile (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  OUT EFI_SCT_TEST_FILE           **TestFile
+  )
+/*++
+
+Routine Description:
+
+  Load a single application test file from its INI file.
+
+--*/
+{
+  EFI_STATUS                  Status;
+  CHAR16                      *ApFileName;
+  EFI_AP_TEST_INTERFACE       *ApTest;
+
+  ApFileName = SctStrEndReplace (FileName, L"ini");
+  if (ApFileName == NULL) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Out of resources"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Load the application test interface
+  //
+  Status = LoadApTest (
+             DevicePath,
+             ApFileName,
+             &ApTest
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Unsupported file"));
+    tBS->FreePool (ApFileName);
+    return EFI_UNSUPPORTED;
+  }
+
+  tBS->FreePool (ApFileName);
+
+  Status = CreateSingleTestFile (
+             DevicePath,
+             FileName,
+             NULL,
+             EFI_SCT_TEST_FILE_TYPE_APPLICATION,
+             ApTest,
+             TestFile
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
+    FreeApTest (ApTest);
+    return Status;
+  }
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+StartTestImageFile (
+  IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
+  IN CHAR16                       *FileName,
+  OUT EFI_HANDLE                  *ImageHandle,
+  OUT EFI_SCT_TEST_FILE_TYPE      *Type,
+  OUT VOID                        **Context
+  )
+/*++
+
+Routine Description:
+
+  Load a test image file. A driver is started and its test protocol is
+  returned. An application is unloaded again and only its type is returned.
+
+--*/
+{
+  EFI_STATUS                  Status;
+  EFI_HANDLE                  TempImageHandle;
+  EFI_DEVICE_PATH_PROTOCOL    *FileNode;
+  EFI_DEVICE_PATH_PROTOCOL    *FilePath;
+  EFI_LOADED_IMAGE_PROTOCOL   *LoadedImage;
+  UINTN                       ExitDataSize;
+  CHAR16                      *ExitData;
+  VOID                        *TestProtocol;
+
   //
   // Add the file path to the device path
   //
@@ -575,7 +870,7 @@ Routine Description:
                  FilePath,
                  NULL,
                  0,
-                 &ImageHandle
+                 &TempImageHandle
                  );
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load image - %r", Status));
@@ -589,7 +884,7 @@ Routine Description:
   // Check the image is a driver or an application
   //
   Status = tBS->HandleProtocol (
-                 ImageHandle,
+                 TempImageHandle,
                  &gEfiLoadedImageProtocolGuid,
                  (VOID **)&LoadedImage
                  );
@@ -598,148 +893,229 @@ Routine Description:
     return Status;
   }
 
-  if ((LoadedImage->ImageCodeType == EfiBootServicesCode   ) ||
-      (LoadedImage->ImageCodeType == EfiRuntimeServicesCode)) {
+  if ((LoadedImage->ImageCodeType != EfiBootServicesCode   ) &&
+      (LoadedImage->ImageCodeType != EfiRuntimeServicesCode)) {
     //
-    // It is a driver
+    // It is an application, it is loaded again when it is executed
     //
-    Status = tBS->StartImage (
-                   ImageHandle,
-                   &ExitDataSize,
-                   &ExitData
-                   );
-    if (EFI_ERROR (Status)) {
-      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Start image - %r", Status));
-      return Status;
-    }
+    tBS->UnloadImage (TempImageHandle);
 
-    //
-    // Is it a black-box test?
-    //
-    Status = tBS->HandleProtocol (
-                   ImageHandle,
-                   &gEfiBbTestGuid,
-                   (VOID **)&BbTest
-                   );
-    if (!EFI_ERROR (Status)) {
-      Status = CreateSingleTestFile (
-                 DevicePath,
-                 FileName,
-                 ImageHandle,
-                 EFI_SCT_TEST_FILE_TYPE_BLACK_BOX,
-                 BbTest,
-                 TestFile
-                 );
-      if (EFI_ERROR (Status)) {
-        EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
-        tBS->UnloadImage (ImageHandle);
-        return Status;
-      }
+    *ImageHandle = NULL;
+    *Type        = EFI_SCT_TEST_FILE_TYPE_APPLICATION;
+    *Context     = NULL;
+    return EFI_SUCCESS;
+  }
 
-      return EFI_SUCCESS;
-    }
+  //
+  // It is a driver
+  //
+  Status = tBS->StartImage (
+                 TempImageHandle,
+                 &ExitDataSize,
+                 &ExitData
+                 );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Start image - %r", Status));
+    return Status;
+  }
 
+  //
+  // Is it a black-box test?
+  //
+  Status = tBS->HandleProtocol (
+                 TempImageHandle,
+                 &gEfiBbTestGuid,
+                 &TestProtocol
+                 );
+  if (!EFI_ERROR (Status)) {
+    *Type = EFI_SCT_TEST_FILE_TYPE_BLACK_BOX;
+  } else {
     //
     // Is it a white-box test?
     //
     Status = tBS->HandleProtocol (
-                   ImageHandle,
+                   TempImageHandle,
                    &gEfiWbTestGuid,
-                   (VOID **)&WbTest
+                   &TestProtocol
                    );
     if (!EFI_ERROR (Status)) {
-      Status = CreateSingleTestFile (
-                 DevicePath,
-                 FileName,
-                 ImageHandle,
-                 EFI_SCT_TEST_FILE_TYPE_WHITE_BOX,
-                 WbTest,
-                 TestFile
-                 );
-      if (EFI_ERROR (Status)) {
-        EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
-        tBS->UnloadImage (ImageHandle);
-        return Status;
+      *Type = EFI_SCT_TEST_FILE_TYPE_WHITE_BOX;
+    } else {
+      //
+      // Is it a IHV black-box test?
+      //
+      Status = tBS->HandleProtocol (
+                     TempImageHandle,
+                     &gEfiIHVBbTestGuid,
+                     &TestProtocol
+                     );
+      if (!EFI_ERROR (Status)) {
+        *Type = EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX;
       }
-
-      return EFI_SUCCESS;
     }
+  }
 
+  if (EFI_ERROR (Status)) {
     //
-    // Is it a IHV black-box test?
+    // Unsupported file
     //
-    Status = tBS->HandleProtocol (
-                   ImageHandle,
-                   &gEfiIHVBbTestGuid,
-                   (VOID **)&BbTest
-                   );
-    if (!EFI_ERROR (Status)) {
-      Status = CreateSingleTestFile (
-                 DevicePath,
-                 FileName,
-                 ImageHandle,
-                 EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX,
-                 BbTest,
-                 TestFile
-                 );
-      if (EFI_ERROR (Status)) {
-        EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
-        tBS->UnloadImage (ImageHandle);
-        return Status;
-      }
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Unsupported file"));
+    tBS->UnloadImage (TempImageHandle);
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Done
+  //
+  *ImageHandle = TempImageHandle;
+  *Context     = TestProtocol;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+LoadTestFileImage (
+  IN EFI_SCT_TEST_FILE            *TestFile
+  )
+/*++
 
-      return EFI_SUCCESS;
+Routine Description:
+
+  Load the image of a test file created from the test manifest, and replace
+  the shadow test protocol with the one installed by the image.
+
+--*/
+{
+  EFI_STATUS                  Status;
+  EFI_HANDLE                  ImageHandle;
+  EFI_SCT_TEST_FILE_TYPE      Type;
+  VOID                        *Context;
+
+  //
+  // Debug information
+  //
+  EFI_SCT_DEBUG ((EFI_SCT_D_TRACE, L"Load test image file <%s> on demand", TestFile->FileName));
+
+  Status = StartTestImageFile (
+             TestFile->DevicePath,
+             TestFile->FileName,
+             &ImageHandle,
+             &Type,
+             &Context
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Start test image file - %r", Status));
+    return Status;
+  }
+
+  //
+  // The test manifest is out of date if the type was changed
+  //
+  if (Type != TestFile->Type) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Test image file type changed <%s>", TestFile->FileName));
+    if (ImageHandle != NULL) {
+      tBS->UnloadImage (ImageHandle);
     }
+    return EFI_UNSUPPORTED;
+  }
 
-    tBS->UnloadImage (ImageHandle);
-  } else {
+  FreeTestManifestContext (TestFile->Type, TestFile->Context);
+
+  TestFile->ImageHandle = ImageHandle;
+  TestFile->Context     = Context;
+
+  //
+  // Done
+  //
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+FindTestEntryInFile (
+  IN EFI_SCT_TEST_FILE            *TestFile,
+  IN EFI_GUID                     *Guid,
+  OUT VOID                        **TestProtocol,
+  OUT VOID                        **TestEntry
+  )
+/*++
+
+Routine Description:
+
+  Search a test entry in a single test file based on the test case's GUID.
+
+--*/
+{
+  EFI_BB_TEST_PROTOCOL    *BbTest;
+  EFI_BB_TEST_ENTRY       *BbEntry;
+  EFI_WB_TEST_PROTOCOL    *WbTest;
+  EFI_WB_TEST_ENTRY       *WbEntry;
+  EFI_AP_TEST_INTERFACE   *ApTest;
+  EFI_AP_TEST_ENTRY       *ApEntry;
+
+  //
+  // Deal with the different kinds of test files
+  //
+  switch (TestFile->Type) {
+  case EFI_SCT_TEST_FILE_TYPE_IHV_BLACK_BOX:
+  case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
     //
-    // It is an application
+    // Black-box test file
     //
-    ApFileName = SctStrEndReplace (FileName, L"ini");
-    if (ApFileName == NULL) {
-      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Out of resources"));
-      return EFI_OUT_OF_RESOURCES;
+    BbTest = (EFI_BB_TEST_PROTOCOL *) TestFile->Context;
+
+    for (BbEntry = BbTest->EntryList; BbEntry != NULL; BbEntry = BbEntry->Next) {
+      if (SctCompareGuid (Guid, &BbEntry->EntryId) == 0) {
+        *TestProtocol = BbTest;
+        *TestEntry    = BbEntry;
+        return EFI_SUCCESS;
+      }
     }
 
+    break;
+
+  case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
     //
-    // Load the application test interface
+    // White-box test file
     //
-    Status = LoadApTest (
-               DevicePath,
-               ApFileName,
-               &ApTest
-               );
-    if (EFI_ERROR (Status)) {
-      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Unsupported file"));
-      tBS->FreePool (ApFileName);
-      return EFI_UNSUPPORTED;
+    WbTest = (EFI_WB_TEST_PROTOCOL *) TestFile->Context;
+
+    for (WbEntry = WbTest->EntryList; WbEntry != NULL; WbEntry = WbEntry->Next) {
+      if (SctCompareGuid (Guid, &WbEntry->EntryId) == 0) {
+        *TestProtocol = WbTest;
+        *TestEntry    = WbEntry;
+        return EFI_SUCCESS;
+      }
     }
 
-    tBS->FreePool (ApFileName);
+    break;
 
-    Status = CreateSingleTestFile (
-               DevicePath,
-               FileName,
-               NULL,
-               EFI_SCT_TEST_FILE_TYPE_APPLICATION,
-               ApTest,
-               TestFile
-               );
-    if (EFI_ERROR (Status)) {
-      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create a test file - %r", Status));
-      FreeApTest (ApTest);
-      return Status;
+  case EFI_SCT_TEST_FILE_TYPE_APPLICATION:
+  case EFI_SCT_TEST_FILE_TYPE_SCRIPT:
+    //
+    // EFI application or script test file
+    //
+    ApTest = (EFI_AP_TEST_INTERFACE *) TestFile->Context;
+
+    for (ApEntry = ApTest->EntryList; ApEntry != NULL; ApEntry = ApEntry->Next) {
+      if (SctCompareGuid (Guid, &ApEntry->EntryId) == 0) {
+        *TestProtocol = ApTest;
+        *TestEntry    = ApEntry;
+        return EFI_SUCCESS;
+      }
     }
 
-    return EFI_SUCCESS;
+    break;
+
+  default:
+    //
+    // Unsupported file
+    //
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Unsupported file"));
+    return EFI_UNSUPPORTED;
   }
 
-  //
-  // Unsupported file
-  //
-  EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Unsupported file"));
-  return EFI_UNSUPPORTED;
+  return EFI_NOT_FOUND;
 }
 
 
@@ -908,9 +1284,13 @@ Routine Description:
   case EFI_SCT_TEST_FILE_TYPE_BLACK_BOX:
   case EFI_SCT_TEST_FILE_TYPE_WHITE_BOX:
     //
-    // Black-box or White-box test file
+    // Black-box or White-box test file, or its shadow from the test manifest
     //
-    tBS->UnloadImage (TestFile->ImageHandle);
+    if (TestFile->ImageHandle != NULL) {
+      tBS->UnloadImage (TestFile->ImageHandle);
+    } else {
+      FreeTestManifestContext (TestFile->Type, TestFile->Context);
+    }
     break;
 
   case EFI_SCT_TEST_FILE_TYPE_APPLICATION:
@@ -1067,6 +1067,7 @@ Routine Description:
   UINTN       NumberOfTokens;
   CHAR16      *TempBuffer;
   CHAR16      **Tokens;
+  EFI_GUID    *TempGuid;
 
   if ((Buffer == NULL) || (GuidArray == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -1099,19 +1100,26 @@ Routine Description:
 
   SctZeroMem (*GuidArray, (NumberOfTokens + 1) * sizeof(EFI_GUID));
 
+  //
+  // Walk a local cursor, the caller gets the start of the array
+  //
+  TempGuid = *GuidArray;
+
   for (Index = 0; Index < NumberOfTokens; Index ++) {
     if (Tokens[Index][0] == L'\0') {
       continue;
     }
 
-    Status = SctStrToGuid (Tokens[Index], *GuidArray);
+    Status = SctStrToGuid (Tokens[Index], TempGuid);
     if (EFI_ERROR (Status)) {
+      tBS->FreePool (*GuidArray);
+      *GuidArray = NULL;
       tBS->FreePool (TempBuffer);
       tBS->FreePool (Tokens);
       return Status;
     }
 
-    (*GuidArray) ++;
+    TempGuid ++;
   }
 
   tBS->FreePool (TempBuffer);
@@ -1321,10 +1329,11 @@ Routine Description:
   SctSPrint (
     Buffer,
     0,
-    L"%s,%s,%s",
+    L"%s,%s,%s,%s",
     (CaseAttribute & EFI_TEST_CASE_MANUAL)         ? L"Manual"        : L"",
     (CaseAttribute & EFI_TEST_CASE_DESTRUCTIVE)    ? L"Destructive"   : L"",
-    (CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) ? L"ResetRequired" : L""
+    (CaseAttribute & EFI_TEST_CASE_RESET_REQUIRED) ? L"ResetRequired" : L"",
+    (CaseAttribute & EFI_TEST_CASE_WARM_RESET)     ? L"WarmReset"     : L""
     );
 
   return EFI_SUCCESS;
@@ -1381,6 +1390,8 @@ Routine Description:
       *CaseAttribute |= EFI_TEST_CASE_DESTRUCTIVE;
     } else if (SctStriCmp (Tokens[Index], L"ResetRequired") == 0) {
       *CaseAttribute |= EFI_TEST_CASE_RESET_REQUIRED;
+    } else if (SctStriCmp (Tokens[Index], L"WarmReset") == 0) {
+      *CaseAttribute |= EFI_TEST_CASE_WARM_RESET;
     } else {
       tBS->FreePool (TempBuffer);
       tBS->FreePool (Tokens);
@@ -801,6 +801,17 @@ Routine Description:
   
   tBS->FreePool (FileName);
 
+  //
+  // Set the buffered output policy of the test output library
+  //
+  Status = SetOutputBufferPolicy (
+             gFT->ConfigData->OutputBufferSize,
+             gFT->ConfigData->OutputFlushInterval
+             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Set output buffer policy - %r", Status));
+  }
+
   //
   // Done
   //
@@ -955,6 +966,15 @@ Routine Description:
 
   tBS->FreePool (FileName);
 
+  //
+  // Apply the test case boundaries recorded after the last save
+  //
+  Status = ReplayTestCaseJournal ();
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Replay test case journal - %r", Status));
+    return Status;
+  }
+
   //
   // Done
   //
@@ -1026,6 +1046,7 @@ Routine Description:
 {
   EFI_STATUS  Status;
   CHAR16      *FilePath;
+  CHAR16      *ManifestFileName;
 
   //
   // Check operations
@@ -1037,6 +1058,32 @@ Routine Description:
     return EFI_SUCCESS;
   }
 
+  //
+  // Load the test manifest, the unchanged test image files are not loaded
+  // until one of their test entries is executed
+  //
+  ManifestFileName = NULL;
+
+  if (gFT->ConfigData->EnableTestManifest) {
+    ManifestFileName = SctPoolPrint (
+                         L"%s\\%s",
+                         gFT->FilePath,
+                         EFI_SCT_FILE_TEST_MANIFEST
+                         );
+    if (ManifestFileName == NULL) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"SctPoolPrint: Out of resources"));
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Status = LoadTestManifest (
+               gFT->DevicePath,
+               ManifestFileName
+               );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load test manifest - %r", Status));
+    }
+  }
+
   //
   // Create the test file path
   //
@@ -1047,6 +1094,10 @@ Routine Description:
                );
   if (FilePath == NULL) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"SctPoolPrint: Out of resources"));
+    if (ManifestFileName != NULL) {
+      FreeTestManifest ();
+      tBS->FreePool (ManifestFileName);
+    }
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -1064,11 +1115,32 @@ Routine Description:
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load test files - %r", Status));
     tBS->FreePool (FilePath);
+    if (ManifestFileName != NULL) {
+      FreeTestManifest ();
+      tBS->FreePool (ManifestFileName);
+    }
     return Status;
   }
 
   tBS->FreePool (FilePath);
 
+  //
+  // Update the test manifest for the next time
+  //
+  if (ManifestFileName != NULL) {
+    Status = SaveTestManifest (
+               gFT->DevicePath,
+               ManifestFileName,
+               &gFT->TestFileList
+               );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Save test manifest - %r", Status));
+    }
+
+    FreeTestManifest ();
+    tBS->FreePool (ManifestFileName);
+  }
+
   //
   // Done
   //
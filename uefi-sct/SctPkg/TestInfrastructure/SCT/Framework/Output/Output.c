@@ -55,6 +55,50 @@ TOLWrite (
   IN CHAR16                                 *String
   );
 
+EFI_STATUS
+EFIAPI
+TOLWriteData (
+  IN EFI_TEST_OUTPUT_LIBRARY_PROTOCOL       *This,
+  IN EFI_FILE                               *FileHandle,
+  IN UINTN                                  BufferSize,
+  IN VOID                                   *Buffer
+  );
+
+//
+// Internal functions declaration
+//
+
+TEST_OUTPUT_FILE *
+FindOutputFile (
+  IN TEST_OUTPUT_PRIVATE_DATA               *Private,
+  IN EFI_FILE                               *FileHandle
+  );
+
+EFI_STATUS
+FlushOutputFile (
+  IN TEST_OUTPUT_FILE                       *OutputFile
+  );
+
+VOID
+FreeOutputBuffer (
+  IN TEST_OUTPUT_FILE                       *OutputFile
+  );
+
+VOID
+EFIAPI
+FlushOutputNotify (
+  IN EFI_EVENT                              Event,
+  IN VOID                                   *Context
+  );
+
+EFI_STATUS
+EFIAPI
+TOLWriteResetRecord (
+  IN EFI_TEST_RECOVERY_LIBRARY_PROTOCOL     *This,
+  IN UINTN                                  Size,
+  IN VOID                                   *Buffer
+  );
+
 //
 // Test output interface private data
 //
@@ -67,9 +111,17 @@ TEST_OUTPUT_PRIVATE_DATA gOutputPrivate = {
     L"EFI SCT Test Support Library",
     TOLOpen,
     TOLClose,
-    TOLWrite
+    TOLWrite,
+    TOLWriteData
   },
-  NULL
+  NULL,
+  { NULL },
+  0,
+  0,
+  NULL,
+  FALSE,
+  NULL,
+  0
 };
 
 EFI_TEST_OUTPUT_LIBRARY_PROTOCOL *gOutputProtocol = &gOutputPrivate.TestOutput;
@@ -311,6 +363,9 @@ Returns:
     OutputFile->FileHandle = Handle;
     OutputFile->Next = Private->OutputFileList;
     Private->OutputFileList = OutputFile;
+
+    OutputFile->HashNext = Private->HashTable[TEST_OUTPUT_HASH (Handle)];
+    Private->HashTable[TEST_OUTPUT_HASH (Handle)] = OutputFile;
   }
 
   //
@@ -346,43 +401,52 @@ Returns:
 
 --*/
 {
-  TEST_OUTPUT_FILE                  *PrevFile;
   TEST_OUTPUT_FILE                  *OutputFile;
+  TEST_OUTPUT_FILE                  **Link;
   TEST_OUTPUT_PRIVATE_DATA          *Private;
 
   Private = TEST_OUTPUT_PRIVATE_DATA_FROM_THIS (This);
 
   //
-  // Search the file in OutputFileList
+  // Search the file in the handle hash table
   //
-  PrevFile = NULL;
-  OutputFile = Private->OutputFileList;
-  while (OutputFile != NULL) {
-    if (FileHandle == OutputFile->FileHandle) {
-      break;
-    }
-    PrevFile = OutputFile;
-    OutputFile = OutputFile->Next;
-  }
-
+  OutputFile = FindOutputFile (Private, FileHandle);
   if (OutputFile == NULL) {
     return EFI_NOT_FOUND;
   }
 
   OutputFile->OpenCount --;
   if (OutputFile->OpenCount <= 0) {
+    //
+    // Write out the pending data before the file is closed
+    //
+    Private->Busy = TRUE;
+    FlushOutputFile (OutputFile);
+    Private->Busy = FALSE;
+
     //
     // Remove the item from the OutputFileList
     //
-    if (PrevFile == NULL) {
-      Private->OutputFileList = OutputFile->Next;
-    } else {
-      PrevFile->Next = OutputFile->Next;
+    Link = &Private->OutputFileList;
+    while (*Link != OutputFile) {
+      Link = &(*Link)->Next;
     }
+    *Link = OutputFile->Next;
+
+    //
+    // Remove the item from the hash table
+    //
+    Link = &Private->HashTable[TEST_OUTPUT_HASH (FileHandle)];
+    while (*Link != OutputFile) {
+      Link = &(*Link)->HashNext;
+    }
+    *Link = OutputFile->HashNext;
+
     //
     // Delete the item
     //
     FileHandle->Close (FileHandle);
+    FreeOutputBuffer (OutputFile);
     tBS->FreePool (OutputFile->DevicePath);
     tBS->FreePool (OutputFile->FileName);
     tBS->FreePool (OutputFile);
@@ -402,12 +466,48 @@ TOLWrite (
 
 Routine Description:
 
-  One interface function of the TestOutputLibrary to open a file.
+  One interface function of the TestOutputLibrary to write a string to a
+  file. In the buffered mode, the string is kept in the ring buffer of the
+  file until the buffer is full, the flush timer expires or the output files
+  are flushed explicitly.
 
 Arguments:
 
   This          - the protocol instance structure.
   FileHandle    - the opened file's handle.
+  String        - the string to be written.
+
+Returns:
+
+  EFI_SUCCESS   - write the file successfully.
+  EFI_NOT_FOUND - invalid FileHandle.
+
+--*/
+{
+  return TOLWriteData (This, FileHandle, SctStrLen (String) * 2, String);
+}
+
+EFI_STATUS
+EFIAPI
+TOLWriteData (
+  IN EFI_TEST_OUTPUT_LIBRARY_PROTOCOL       *This,
+  IN EFI_FILE                               *FileHandle,
+  IN UINTN                                  BufferSize,
+  IN VOID                                   *Buffer
+  )
+/*++
+
+Routine Description:
+
+  One interface function of the TestOutputLibrary to write raw data to a
+  file. It is buffered in the same way as TOLWrite, which is built on it.
+
+Arguments:
+
+  This          - the protocol instance structure.
+  FileHandle    - the opened file's handle.
+  BufferSize    - the size of the data in bytes.
+  Buffer        - the data to be written.
 
 Returns:
 
@@ -420,33 +520,457 @@ Returns:
   TEST_OUTPUT_FILE                  *OutputFile;
   TEST_OUTPUT_PRIVATE_DATA          *Private;
   UINTN                             BufSize;
+  UINTN                             Tail;
+  UINTN                             Count;
 
   Private = TEST_OUTPUT_PRIVATE_DATA_FROM_THIS (This);
 
   //
-  // Search the file in OutputFileList
+  // Search the file in the handle hash table
   //
-  OutputFile = Private->OutputFileList;
+  OutputFile = FindOutputFile (Private, FileHandle);
+  if (OutputFile == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  BufSize = BufferSize;
+  Private->BytesWritten += BufSize;
+
+  //
+  // The flush timer must not touch the buffers while they are updated
+  //
+  Private->Busy = TRUE;
+
+  //
+  // Allocate the ring buffer at the first write in the buffered mode
+  //
+  if ((Private->BufferSize != 0) && (OutputFile->Buffer == NULL)) {
+    Status = tBS->AllocatePool (
+                   EfiBootServicesData,
+                   Private->BufferSize,
+                   (VOID **)&OutputFile->Buffer
+                   );
+    if (!EFI_ERROR (Status)) {
+      OutputFile->BufferSize = Private->BufferSize;
+      OutputFile->Head       = 0;
+      OutputFile->Length     = 0;
+    } else {
+      OutputFile->Buffer     = NULL;
+    }
+  }
+
+  if ((OutputFile->Buffer == NULL) || (BufSize > OutputFile->BufferSize)) {
+    //
+    // Write the data to the file directly, after the pending data
+    //
+    Status = FlushOutputFile (OutputFile);
+    if (!EFI_ERROR (Status)) {
+      Status = FileHandle->Write (FileHandle, &BufSize, Buffer);
+    }
+    if (!EFI_ERROR (Status)) {
+      Status = FileHandle->Flush (FileHandle);
+    }
+
+    Private->Busy = FALSE;
+    return Status;
+  }
+
+  //
+  // Make room for the data when the ring buffer is full
+  //
+  if (OutputFile->Length + BufSize > OutputFile->BufferSize) {
+    Status = FlushOutputFile (OutputFile);
+    if (EFI_ERROR (Status)) {
+      Private->Busy = FALSE;
+      return Status;
+    }
+  }
+
+  //
+  // Append the data to the ring buffer
+  //
+  Tail  = (OutputFile->Head + OutputFile->Length) % OutputFile->BufferSize;
+  Count = OutputFile->BufferSize - Tail;
+  if (Count > BufSize) {
+    Count = BufSize;
+  }
+
+  SctCopyMem (OutputFile->Buffer + Tail, Buffer, Count);
+  SctCopyMem (OutputFile->Buffer, (UINT8 *) Buffer + Count, BufSize - Count);
+  OutputFile->Length += BufSize;
+
+  Private->Busy = FALSE;
+  return EFI_SUCCESS;
+}
+
+//
+// External functions implementation
+//
+
+EFI_STATUS
+SetOutputBufferPolicy (
+  IN UINTN                        BufferSize,
+  IN UINTN                        FlushInterval
+  )
+/*++
+
+Routine Description:
+
+  Set the buffered output policy of the test output library.
+
+Arguments:
+
+  BufferSize    - Size in bytes of the ring buffer of each output file. 0
+                  means every string is written and flushed immediately.
+  FlushInterval - Interval in seconds to flush the buffers. 0 means the
+                  buffers are only flushed when full or on request.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS                        Status;
+  TEST_OUTPUT_FILE                  *OutputFile;
+  TEST_OUTPUT_PRIVATE_DATA          *Private;
+
+  Private = &gOutputPrivate;
+
+  //
+  // Write out and release the buffers of the previous policy
+  //
+  FlushOutputFiles ();
+
+  for (OutputFile = Private->OutputFileList; OutputFile != NULL; OutputFile = OutputFile->Next) {
+    FreeOutputBuffer (OutputFile);
+  }
+
+  if (Private->FlushEvent != NULL) {
+    tBS->SetTimer (Private->FlushEvent, TimerCancel, 0);
+    tBS->CloseEvent (Private->FlushEvent);
+    Private->FlushEvent = NULL;
+  }
+
+  Private->BufferSize    = BufferSize;
+  Private->FlushInterval = FlushInterval;
+
+  if ((BufferSize == 0) || (FlushInterval == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Create a periodic timer to flush the buffers
+  //
+  Status = tBS->CreateEvent (
+                 EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                 TPL_CALLBACK,
+                 FlushOutputNotify,
+                 Private,
+                 &Private->FlushEvent
+                 );
+  if (EFI_ERROR (Status)) {
+    Private->FlushEvent = NULL;
+    return Status;
+  }
+
+  Status = tBS->SetTimer (
+                 Private->FlushEvent,
+                 TimerPeriodic,
+                 SctMultU64x32 (FlushInterval, 10000000)
+                 );
+  if (EFI_ERROR (Status)) {
+    tBS->CloseEvent (Private->FlushEvent);
+    Private->FlushEvent = NULL;
+    return Status;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+FlushOutputFiles (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Write the buffered data of all opened output files to the disk.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+  Other value   - Something failed.
+
+--*/
+{
+  EFI_STATUS                        Status;
+  EFI_STATUS                        ReturnStatus;
+  TEST_OUTPUT_FILE                  *OutputFile;
+  TEST_OUTPUT_PRIVATE_DATA          *Private;
+
+  Private = &gOutputPrivate;
+
+  Private->Busy = TRUE;
+
+  ReturnStatus = EFI_SUCCESS;
+  for (OutputFile = Private->OutputFileList; OutputFile != NULL; OutputFile = OutputFile->Next) {
+    Status = FlushOutputFile (OutputFile);
+    if (EFI_ERROR (Status)) {
+      ReturnStatus = Status;
+    }
+  }
+
+  Private->Busy = FALSE;
+
+  return ReturnStatus;
+}
+
+
+UINT64
+GetOutputBytesWritten (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Get the total bytes written through the test output library. The counter
+  includes the data still kept in the buffers.
+
+Returns:
+
+  The number of bytes.
+
+--*/
+{
+  return gOutputPrivate.BytesWritten;
+}
+
+
+EFI_STATUS
+HookOutputResetRecord (
+  IN EFI_TEST_RECOVERY_LIBRARY_PROTOCOL   *TrlProtocol
+  )
+/*++
+
+Routine Description:
+
+  Flush the buffered output whenever a test case writes its reset record. A
+  test case always writes the reset record before it resets the system, so
+  the checkpoints recorded before the reset are kept.
+
+Arguments:
+
+  TrlProtocol   - The test recovery library protocol.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+
+--*/
+{
+  if (TrlProtocol == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (TrlProtocol->WriteResetRecord != TOLWriteResetRecord) {
+    gOutputPrivate.WriteResetRecord = TrlProtocol->WriteResetRecord;
+    TrlProtocol->WriteResetRecord   = TOLWriteResetRecord;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+UnhookOutputResetRecord (
+  IN EFI_TEST_RECOVERY_LIBRARY_PROTOCOL   *TrlProtocol
+  )
+/*++
+
+Routine Description:
+
+  Restore the reset record function hooked by HookOutputResetRecord.
+
+Arguments:
+
+  TrlProtocol   - The test recovery library protocol.
+
+Returns:
+
+  EFI_SUCCESS   - Successfully.
+
+--*/
+{
+  if (TrlProtocol == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (TrlProtocol->WriteResetRecord == TOLWriteResetRecord) {
+    TrlProtocol->WriteResetRecord   = gOutputPrivate.WriteResetRecord;
+    gOutputPrivate.WriteResetRecord = NULL;
+  }
+
+  return EFI_SUCCESS;
+}
+
+//
+// Internal functions implementation
+//
+
+TEST_OUTPUT_FILE *
+FindOutputFile (
+  IN TEST_OUTPUT_PRIVATE_DATA               *Private,
+  IN EFI_FILE                               *FileHandle
+  )
+/*++
+
+Routine Description:
+
+  Find an opened output file by its handle.
+
+--*/
+{
+  TEST_OUTPUT_FILE                  *OutputFile;
+
+  OutputFile = Private->HashTable[TEST_OUTPUT_HASH (FileHandle)];
   while (OutputFile != NULL) {
     if (FileHandle == OutputFile->FileHandle) {
       break;
     }
-    OutputFile = OutputFile->Next;
+    OutputFile = OutputFile->HashNext;
   }
 
-  if (OutputFile == NULL) {
-    return EFI_NOT_FOUND;
+  return OutputFile;
+}
+
+
+EFI_STATUS
+FlushOutputFile (
+  IN TEST_OUTPUT_FILE                       *OutputFile
+  )
+/*++
+
+Routine Description:
+
+  Write the data in the ring buffer of an output file to the disk.
+
+--*/
+{
+  EFI_STATUS                        Status;
+  UINTN                             BufSize;
+
+  if (OutputFile->Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  while (OutputFile->Length != 0) {
+    BufSize = OutputFile->BufferSize - OutputFile->Head;
+    if (BufSize > OutputFile->Length) {
+      BufSize = OutputFile->Length;
+    }
+
+    Status = OutputFile->FileHandle->Write (
+                                       OutputFile->FileHandle,
+                                       &BufSize,
+                                       OutputFile->Buffer + OutputFile->Head
+                                       );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    if (BufSize == 0) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    OutputFile->Head    = (OutputFile->Head + BufSize) % OutputFile->BufferSize;
+    OutputFile->Length -= BufSize;
+  }
+
+  OutputFile->Head = 0;
+
+  return OutputFile->FileHandle->Flush (OutputFile->FileHandle);
+}
+
+
+VOID
+FreeOutputBuffer (
+  IN TEST_OUTPUT_FILE                       *OutputFile
+  )
+/*++
+
+Routine Description:
+
+  Free the ring buffer of an output file.
+
+--*/
+{
+  if (OutputFile->Buffer != NULL) {
+    tBS->FreePool (OutputFile->Buffer);
+    OutputFile->Buffer = NULL;
   }
 
+  OutputFile->BufferSize = 0;
+  OutputFile->Head       = 0;
+  OutputFile->Length     = 0;
+}
+
+
+VOID
+EFIAPI
+FlushOutputNotify (
+  IN EFI_EVENT                              Event,
+  IN VOID                                   *Context
+  )
+/*++
+
+Routine Description:
+
+  Notify function of the periodic flush timer.
+
+--*/
+{
+  TEST_OUTPUT_PRIVATE_DATA          *Private;
+  TEST_OUTPUT_FILE                  *OutputFile;
+
+  Private = (TEST_OUTPUT_PRIVATE_DATA *) Context;
+
   //
-  // Write the String to the file
+  // Skip this period if the buffers are being updated
   //
-  BufSize = SctStrLen (String) * 2;
-  Status = FileHandle->Write (FileHandle, &BufSize, String);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  if (Private->Busy) {
+    return;
+  }
+
+  Private->Busy = TRUE;
+
+  for (OutputFile = Private->OutputFileList; OutputFile != NULL; OutputFile = OutputFile->Next) {
+    FlushOutputFile (OutputFile);
   }
-  Status = FileHandle->Flush (FileHandle);
 
-  return Status;
+  Private->Busy = FALSE;
+}
+
+
+EFI_STATUS
+EFIAPI
+TOLWriteResetRecord (
+  IN EFI_TEST_RECOVERY_LIBRARY_PROTOCOL     *This,
+  IN UINTN                                  Size,
+  IN VOID                                   *Buffer
+  )
+/*++
+
+Routine Description:
+
+  Flush the buffered output, then write the reset record.
+
+--*/
+{
+  FlushOutputFiles ();
+
+  return gOutputPrivate.WriteResetRecord (This, Size, Buffer);
 }
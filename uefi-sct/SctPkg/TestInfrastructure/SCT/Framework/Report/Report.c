@@ -198,7 +198,11 @@ Returns:
   //
   // Load the buffer to the GUID assertion table with duplicate
   //
-  Status = LoadGuidAssertion (Buffer, TRUE, FileState);
+  if (IsBinaryKeyFile (Buffer, BufferSize)) {
+    Status = LoadBinaryGuidAssertion (Buffer, BufferSize, TRUE, FileState);
+  } else {
+    Status = LoadGuidAssertion (Buffer, TRUE, FileState);
+  }
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load GUID assertion - %r", Status));
     tBS->FreePool (Buffer);
@@ -345,7 +349,11 @@ Returns:
       //
       // Load the buffer to the GUID assertion table without duplicate
       //
-      Status = LoadGuidAssertion (Buffer, FALSE, &FileState);
+      if (IsBinaryKeyFile (Buffer, BufferSize)) {
+        Status = LoadBinaryGuidAssertion (Buffer, BufferSize, FALSE, &FileState);
+      } else {
+        Status = LoadGuidAssertion (Buffer, FALSE, &FileState);
+      }
       if (EFI_ERROR (Status)) {
         EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Load GUID assertion - %r", Status));
         tBS->FreePool (Buffer);
@@ -522,6 +530,33 @@ Returns:
       // This is a file
       //
 
+      //
+      // Collect the profile records of the test instances
+      //
+      if (SctStrEndWith (FileInfo->FileName, L"." EFI_SCT_PROFILE_FILE_EXT)) {
+        FileName = SctPoolPrint (L"%s\\%s", FilePath, FileInfo->FileName);
+        if (FileName == NULL) {
+          EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"SctPoolPrint: Out of resources"));
+          return EFI_OUT_OF_RESOURCES;
+        }
+
+        Status = ReadFileToBuffer (
+                   DevicePath,
+                   FileName,
+                   &BufferSize,
+                   (VOID **)&Buffer
+                   );
+        tBS->FreePool (FileName);
+        if (EFI_ERROR (Status)) {
+          EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Read file to buffer - %r", Status));
+          continue;
+        }
+
+        LoadProfileInfor (Buffer, FileInfo->FileName);
+        tBS->FreePool (Buffer);
+        continue;
+      }
+
       //
       // Only deal with the EFI key file
       //
@@ -578,12 +613,22 @@ Returns:
       //
       LogName = SctStrEndReplace (FileInfo->FileName, L"log");
 
-      Status = LoadReportInfor (
-                 CaseIndexStr,
-                 CaseIterationStr,
-                 Buffer,
-                 LogName
-                 );
+      if (IsBinaryKeyFile (Buffer, BufferSize)) {
+        Status = LoadBinaryReportInfor (
+                   CaseIndexStr,
+                   CaseIterationStr,
+                   Buffer,
+                   BufferSize,
+                   LogName
+                   );
+      } else {
+        Status = LoadReportInfor (
+                   CaseIndexStr,
+                   CaseIterationStr,
+                   Buffer,
+                   LogName
+                   );
+      }
       if (EFI_ERROR (Status)) {
         EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Load report infor - %r", Status));
         tBS->FreePool (TempName);
@@ -679,17 +724,15 @@ Arguments:
 
 --*/
 {
-  EFI_STATUS        Status;
-  UINT32            PassNumber;
-  UINT32            WarnNumber;
-  UINT32            FailNumber;
-  CHAR16            *FileName;
-  CHAR16            *Buffer;
-  UINTN             AsciiBufferSize;
-  CHAR8             *AsciiBuffer;
-  UINTN             ConfigBufferSize;
-  CHAR8             *ConfigBuffer;
-  EFI_FILE_HANDLE   Handle;
+  EFI_STATUS              Status;
+  UINT32                  PassNumber;
+  UINT32                  WarnNumber;
+  UINT32                  FailNumber;
+  CHAR16                  *FileName;
+  UINTN                   ConfigBufferSize;
+  CHAR8                   *ConfigBuffer;
+  EFI_FILE_HANDLE         Handle;
+  EFI_SCT_REPORT_WRITER   Writer;
 
   //
   // Check parameters
@@ -740,8 +783,10 @@ Arguments:
   tBS->FreePool (FileName);
 
   //
-  // Load the assertion information from the log directory
+  // Load the assertion and profile information from the log directory
   //
+  UnloadProfileInfor ();
+
   Status = GetProtocolAssertion (
              DevicePath,
              LogFilePath,
@@ -754,51 +799,14 @@ Arguments:
     tBS->FreePool (ConfigBuffer);
     UnloadGuidDatabase ();
     UnloadReportInfor ();
+    UnloadProfileInfor ();
     return Status;
   }
 
   //
-  // Get the report information to a buffer
+  // The GUID database is only used to load the assertion information
   //
-  Status = GetReportInfor (&Buffer);
-  if (EFI_ERROR (Status)) {
-    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Get report infor - %r", Status));
-    tBS->FreePool (ConfigBuffer);
-    UnloadGuidDatabase ();
-    UnloadReportInfor ();
-    return Status;
-  }
-
   UnloadGuidDatabase ();
-  UnloadReportInfor ();
-
-  //
-  // Convert the buffer to ASCII buffer
-  //
-  AsciiBufferSize = SctStrLen (Buffer) + 1;
-
-  Status = tBS->AllocatePool (
-                 EfiBootServicesData,
-                 AsciiBufferSize,
-                 (VOID **)&AsciiBuffer
-                 );
-  if (EFI_ERROR (Status)) {
-    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
-    tBS->FreePool (ConfigBuffer);
-    tBS->FreePool (Buffer);
-    return Status;
-  }
-
-  Status = SctUnicodeToAscii (AsciiBuffer, Buffer, SctStrLen (Buffer));
-  if (EFI_ERROR (Status)) {
-    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Convert Unicode to ASCII - %r", Status));
-    tBS->FreePool (ConfigBuffer);
-    tBS->FreePool (Buffer);
-    tBS->FreePool (AsciiBuffer);
-    return Status;
-  }
-
-  tBS->FreePool (Buffer);
 
   //
   // Create the report file
@@ -811,47 +819,41 @@ Arguments:
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Create report file - %r", Status));
     tBS->FreePool (ConfigBuffer);
-    tBS->FreePool (AsciiBuffer);
+    UnloadReportInfor ();
+    UnloadProfileInfor ();
     return Status;
   }
 
-  //
-  // Write the ASCII buffer to the report file (remove the null-terminator)
-  //
-  AsciiBufferSize --;
-
-  Status = Handle->Write (
-                     Handle,
-                     &AsciiBufferSize,
-                     AsciiBuffer
-                     );
+  Status = OpenReportWriter (Handle, &Writer);
   if (EFI_ERROR (Status)) {
-    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Write report file - %r", Status));
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Open report writer - %r", Status));
     tBS->FreePool (ConfigBuffer);
-    tBS->FreePool (AsciiBuffer);
+    UnloadReportInfor ();
+    UnloadProfileInfor ();
     Handle->Close (Handle);
     return Status;
   }
 
   //
-  // Write the config buffer to the report file
+  // Stream the report information, the slowest test instances and the config
+  // buffer to the report file
   //
-  Status = Handle->Write (
-                     Handle,
-                     &ConfigBufferSize,
-                     ConfigBuffer
-                     );
+  WriteReportInfor (&Writer);
+  UnloadReportInfor ();
+
+  WriteProfileInfor (&Writer);
+  UnloadProfileInfor ();
+
+  ReportWrite (&Writer, ConfigBuffer, ConfigBufferSize);
+  tBS->FreePool (ConfigBuffer);
+
+  Status = CloseReportWriter (&Writer);
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Write report file - %r", Status));
-    tBS->FreePool (ConfigBuffer);
-    tBS->FreePool (AsciiBuffer);
     Handle->Close (Handle);
     return Status;
   }
 
-  tBS->FreePool (ConfigBuffer);
-  tBS->FreePool (AsciiBuffer);
-
   //
   // Close the report file
   //
@@ -35,12 +35,15 @@ Abstract:
 EFI_SCT_GUID_DATABASE   *mGuidDatabase          = NULL;
 UINTN                   mGuidDatabaseMaxSize   = 0;
 UINTN                   mGuidDatabaseUsedSize  = 0;
+EFI_SCT_GUID_INDEX      mGuidDatabaseIndex     = { NULL, 0, 0 };
 
 EFI_SCT_GUID_ASSERTION  *mGuidAssertion         = NULL;
 UINTN                   mGuidAssertionMaxSize  = 0;
 UINTN                   mGuidAssertionUsedSize = 0;
+EFI_SCT_GUID_INDEX      mGuidAssertionIndex    = { NULL, 0, 0 };
 
 EFI_SCT_REPORT_INFOR    mReportInfor;
+EFI_SCT_REPORT_ITEM     *mLastReportItem       = NULL;
 
 
 //
@@ -49,17 +52,36 @@ EFI_SCT_REPORT_INFOR    mReportInfor;
 
 EFI_STATUS
 InsertGuidDatabase (
-  IN CHAR16                           *GuidStr,
+  IN EFI_GUID                         *Guid,
   IN CHAR16                           *TitleStr,
   IN CHAR16                           *IndexStr
   );
 
 EFI_STATUS
 InsertGuidAssertion (
-  IN CHAR16                           *GuidStr,
+  IN EFI_GUID                         *Guid OPTIONAL,
   IN UINTN                            AssertionType,
   IN BOOLEAN                          Duplicate,
-  OUT EFI_SCT_GUID_ASSERTION_STATE    *AssertionState
+  OUT EFI_SCT_GUID_ASSERTION_STATE    *AssertionState,
+  OUT EFI_SCT_GUID_ASSERTION          **GuidAssertion OPTIONAL
+  );
+
+EFI_SCT_GUID_SLOT *
+FindGuidSlot (
+  IN EFI_SCT_GUID_INDEX               *GuidIndex,
+  IN EFI_GUID                         *Guid
+  );
+
+EFI_STATUS
+InsertGuidIndex (
+  IN OUT EFI_SCT_GUID_INDEX           *GuidIndex,
+  IN EFI_GUID                         *Guid,
+  IN UINTN                            Entry
+  );
+
+VOID
+FreeGuidIndex (
+  IN OUT EFI_SCT_GUID_INDEX           *GuidIndex
   );
 
 EFI_STATUS
@@ -103,6 +125,7 @@ Routine Description:
   CHAR16      *GuidStr;
   CHAR16      *TitleStr;
   CHAR16      *IndexStr;
+  EFI_GUID    Guid;
 
   //
   // Check parameters
@@ -168,10 +191,20 @@ Routine Description:
       continue;
     }
 
+    //
+    // Skip the entry with an invalid GUID
+    //
+    Status = ConvertStrToGuid (GuidStr, &Guid);
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Invalid GUID in database - %s", GuidStr));
+      LineBuffer = StrTokenLine (NULL, L"\n\r");
+      continue;
+    }
+
     //
     // Insert the entry into the GUID database
     //
-    Status = InsertGuidDatabase (GuidStr, TitleStr, IndexStr);
+    Status = InsertGuidDatabase (&Guid, TitleStr, IndexStr);
     if (EFI_ERROR (Status)) {
       break;
     }
@@ -207,13 +240,15 @@ Routine Description:
     mGuidDatabase = NULL;
   }
 
+  FreeGuidIndex (&mGuidDatabaseIndex);
+
   return EFI_SUCCESS;
 }
 
 
 EFI_STATUS
 SearchGuidDatabase (
-  IN CHAR16                       *GuidStr,
+  IN EFI_GUID                     *Guid,
   OUT CHAR16                      *TitleStr,
   OUT CHAR16                      *IndexStr
   )
@@ -225,24 +260,26 @@ Routine Description:
 
 --*/
 {
-  UINTN   Index;
+  EFI_SCT_GUID_SLOT       *Slot;
+  EFI_SCT_GUID_DATABASE   *Entry;
 
-  if ((GuidStr == NULL) || (TitleStr == NULL) || (IndexStr == NULL)) {
+  if ((Guid == NULL) || (TitleStr == NULL) || (IndexStr == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
   //
-  // Search the GUID database
+  // Search the GUID database index
   //
-  for (Index = 0; Index < mGuidDatabaseUsedSize; Index ++) {
-    if (SctStrCmp (GuidStr, mGuidDatabase[Index].Guid) == 0) {
-      SctStrnCpy (TitleStr, mGuidDatabase[Index].Title, EFI_SCT_TITLE_LEN);
-      SctStrnCpy (IndexStr, mGuidDatabase[Index].Index, EFI_SCT_INDEX_LEN);
-      return EFI_SUCCESS;
-    }
+  Slot = FindGuidSlot (&mGuidDatabaseIndex, Guid);
+  if ((Slot == NULL) || (Slot->Entry == 0)) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  Entry = &mGuidDatabase[Slot->Entry - 1];
+  SctStrnCpy (TitleStr, Entry->Title, EFI_SCT_TITLE_LEN);
+  SctStrnCpy (IndexStr, Entry->Index, EFI_SCT_INDEX_LEN);
+
+  return EFI_SUCCESS;
 }
 
 
@@ -265,7 +302,8 @@ Routine Description:
   CHAR16                        *GuidStr;
   CHAR16                        *AssertionStr;
   UINTN                         AssertionType;
-  CHAR16                        GenericGuidStr[EFI_SCT_GUID_LEN];
+  EFI_GUID                      Guid;
+  BOOLEAN                       ValidGuid;
   EFI_SCT_GUID_ASSERTION_STATE  AssertionState;
 
   //
@@ -278,9 +316,6 @@ Routine Description:
   //
   // Initialize
   //
-  SctZeroMem (GenericGuidStr, EFI_SCT_GUID_LEN * sizeof(CHAR16));
-  SctGuidToStr (&gTestGenericFailureGuid, GenericGuidStr);
-
   *FileState = EFI_SCT_LOG_STATE_EMPTY;
 
   //
@@ -328,11 +363,13 @@ Routine Description:
       continue;
     }
 
+    ValidGuid = (BOOLEAN) !EFI_ERROR (ConvertStrToGuid (GuidStr, &Guid));
+
     if (!Duplicate) {
       //
       // Ignore the generic GUID
       //
-      if (SctStrCmp (GuidStr, GenericGuidStr) == 0) {
+      if (ValidGuid && (SctCompareGuid (&Guid, &gTestGenericFailureGuid) == 0)) {
         LineBuffer = StrTokenLine (NULL, L"\n\r");
         continue;
       }
@@ -363,10 +400,11 @@ Routine Description:
     // Insert it into GUID assertion
     //
     Status = InsertGuidAssertion (
-               GuidStr,
+               ValidGuid ? &Guid : NULL,
                AssertionType,
                Duplicate,
-               &AssertionState
+               &AssertionState,
+               NULL
                );
     if (EFI_ERROR (Status)) {
       EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Insert GUID assertion - %r", Status));
@@ -383,6 +421,107 @@ Routine Description:
 }
 
 
+EFI_STATUS
+LoadBinaryGuidAssertion (
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize,
+  IN BOOLEAN                      Duplicate,
+  OUT EFI_SCT_LOG_STATE           *FileState
+  )
+/*++
+
+Routine Description:
+
+  Load the GUID assertion from a binary key file buffer.
+
+--*/
+{
+  EFI_STATUS                    Status;
+  EFI_SCT_KEY_FILE_READER       Reader;
+  UINT16                        Type;
+  UINT8                         *Record;
+  UINTN                         RecordSize;
+  EFI_KEY_FILE_ASSERTION_RECORD Assertion;
+  UINTN                         AssertionType;
+  EFI_SCT_GUID_ASSERTION_STATE  AssertionState;
+
+  //
+  // Check parameters
+  //
+  if ((Buffer == NULL) || (FileState == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Initialize
+  //
+  *FileState = EFI_SCT_LOG_STATE_EMPTY;
+
+  Status = OpenKeyFileReader (Buffer, BufferSize, &Reader);
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Unsupported GUID assertion buffer"));
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Walk through the records
+  //
+  while (!EFI_ERROR (ReadKeyFileRecord (&Reader, &Type, &Record, &RecordSize))) {
+    if (Type == EFI_KEY_FILE_RECORD_HEAD) {
+      *FileState = EFI_SCT_LOG_STATE_RUNNING;
+      continue;
+    }
+
+    if (Type == EFI_KEY_FILE_RECORD_TERM) {
+      *FileState = EFI_SCT_LOG_STATE_FINISHED;
+      continue;
+    }
+
+    if (RecordSize < sizeof(EFI_KEY_FILE_ASSERTION_RECORD)) {
+      continue;
+    }
+
+    SctCopyMem (&Assertion, Record, sizeof(EFI_KEY_FILE_ASSERTION_RECORD));
+
+    if (!Duplicate) {
+      //
+      // Ignore the generic GUID
+      //
+      if (SctCompareGuid (&Assertion.EventId, &gTestGenericFailureGuid) == 0) {
+        continue;
+      }
+    }
+
+    if (Assertion.Result == EFI_TEST_ASSERTION_PASSED) {
+      AssertionType = EFI_SCT_GUID_ASSERTION_TYPE_PASS;
+    } else if (Assertion.Result == EFI_TEST_ASSERTION_FAILED) {
+      AssertionType = EFI_SCT_GUID_ASSERTION_TYPE_FAIL;
+    } else {
+      AssertionType = EFI_SCT_GUID_ASSERTION_TYPE_WARN;
+    }
+
+    //
+    // Insert it into GUID assertion
+    //
+    Status = InsertGuidAssertion (
+               &Assertion.EventId,
+               AssertionType,
+               Duplicate,
+               &AssertionState,
+               NULL
+               );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Insert GUID assertion - %r", Status));
+      CloseKeyFileReader (&Reader);
+      return Status;
+    }
+  }
+
+  CloseKeyFileReader (&Reader);
+  return EFI_SUCCESS;
+}
+
+
 EFI_STATUS
 UnloadGuidAssertion (
   VOID
@@ -403,6 +542,8 @@ Routine Description:
     mGuidAssertion = NULL;
   }
 
+  FreeGuidIndex (&mGuidAssertionIndex);
+
   return EFI_SUCCESS;
 }
 
@@ -704,6 +845,188 @@ Routine Description:
 }
 
 
+EFI_STATUS
+LoadBinaryReportInfor (
+  IN CHAR16                       *CaseIndexStr,
+  IN CHAR16                       *CaseIterationStr,
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize,
+  IN CHAR16                       *FileName
+  )
+/*++
+
+Routine Description:
+
+  Load the report information from a binary key file buffer. The fields are
+  formatted as in the text key file. Unlike LoadReportInfor, the generic and
+  the system hang GUIDs are compared as GUIDs, not as upper case strings.
+
+--*/
+{
+  EFI_STATUS                    Status;
+  EFI_SCT_KEY_FILE_READER       Reader;
+  UINT16                        Type;
+  UINT8                         *Record;
+  UINTN                         RecordSize;
+  UINTN                         Offset;
+  EFI_KEY_FILE_HEAD_RECORD      Head;
+  EFI_KEY_FILE_ASSERTION_RECORD Assertion;
+  UINTN                         AssertionType;
+  BOOLEAN                       SystemHang;
+  CHAR16                        *TestNameStr;
+  CHAR16                        *TestCategoryStr;
+  CHAR16                        *DevicePathStr;
+  CHAR16                        *TitleStr;
+  CHAR16                        *RuntimeInforStr;
+  CHAR16                        *CaseRevisionStr;
+  CHAR16                        *CaseGuidStr;
+  CHAR16                        *CaseNameStr;
+  CHAR16                        *Char;
+  CHAR16                        GuidStr[EFI_SCT_GUID_LEN];
+  CHAR16                        CaseGuidBuffer[EFI_SCT_GUID_LEN];
+  CHAR16                        CaseRevisionBuffer[EFI_SCT_CASE_REVISION_LEN];
+
+  //
+  // Check parameters
+  //
+  if ((CaseIndexStr == NULL) || (CaseIterationStr == NULL) || (Buffer == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Initialize
+  //
+  CaseGuidStr      = NULL;
+  CaseRevisionStr  = NULL;
+  CaseNameStr      = NULL;
+  TestNameStr      = NULL;
+  TestCategoryStr  = NULL;
+  DevicePathStr    = NULL;
+
+  Status = OpenKeyFileReader (Buffer, BufferSize, &Reader);
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  while (!EFI_ERROR (ReadKeyFileRecord (&Reader, &Type, &Record, &RecordSize))) {
+    if (Type == EFI_KEY_FILE_RECORD_HEAD) {
+      //
+      // The head record: scenario, case name, test name, test category and
+      // device path strings follow the fixed part
+      //
+      if (RecordSize < sizeof(EFI_KEY_FILE_HEAD_RECORD)) {
+        continue;
+      }
+
+      SctCopyMem (&Head, Record, sizeof(EFI_KEY_FILE_HEAD_RECORD));
+
+      SctSPrint (CaseGuidBuffer, sizeof(CaseGuidBuffer), L"%g", &Head.EntryId);
+      SctSPrint (CaseRevisionBuffer, sizeof(CaseRevisionBuffer), L"0x%08lx", Head.TestRevision);
+      CaseGuidStr     = CaseGuidBuffer;
+      CaseRevisionStr = CaseRevisionBuffer;
+
+      Offset          = sizeof(EFI_KEY_FILE_HEAD_RECORD);
+      GetKeyFileString (Record, RecordSize, &Offset);
+      CaseNameStr     = GetKeyFileString (Record, RecordSize, &Offset);
+      TestNameStr     = GetKeyFileString (Record, RecordSize, &Offset);
+      TestCategoryStr = GetKeyFileString (Record, RecordSize, &Offset);
+      DevicePathStr   = GetKeyFileString (Record, RecordSize, &Offset);
+      continue;
+    }
+
+    if ((Type != EFI_KEY_FILE_RECORD_ASSERTION) ||
+        (RecordSize < sizeof(EFI_KEY_FILE_ASSERTION_RECORD))) {
+      continue;
+    }
+
+    //
+    // The assertion record
+    //
+    SctCopyMem (&Assertion, Record, sizeof(EFI_KEY_FILE_ASSERTION_RECORD));
+
+    //
+    // Ignore the generic GUID
+    //
+    if (SctCompareGuid (&Assertion.EventId, &gTestGenericFailureGuid) == 0) {
+      continue;
+    }
+
+    SctSPrint (GuidStr, sizeof(GuidStr), L"%g", &Assertion.EventId);
+
+    if (Assertion.Result == EFI_TEST_ASSERTION_PASSED) {
+      AssertionType = EFI_SCT_GUID_ASSERTION_TYPE_PASS;
+    } else if (Assertion.Result == EFI_TEST_ASSERTION_FAILED) {
+      AssertionType = EFI_SCT_GUID_ASSERTION_TYPE_FAIL;
+    } else {
+      AssertionType = EFI_SCT_GUID_ASSERTION_TYPE_WARN;
+    }
+
+    //
+    // Get the title and the runtime information. The runtime information
+    // ends at the first line break, as in the text key file.
+    //
+    Offset = sizeof(EFI_KEY_FILE_ASSERTION_RECORD);
+    if (Assertion.DescriptionId == EFI_KEY_FILE_INLINE_DESCRIPTION) {
+      TitleStr = GetKeyFileString (Record, RecordSize, &Offset);
+    } else {
+      TitleStr = GetKeyFileDescription (&Reader, Assertion.DescriptionId);
+    }
+
+    RuntimeInforStr = GetKeyFileString (Record, RecordSize, &Offset);
+    if (RuntimeInforStr != NULL) {
+      for (Char = RuntimeInforStr; *Char != L'\0'; Char ++) {
+        if ((*Char == L'\r') || (*Char == L'\n')) {
+          *Char = L'\0';
+          break;
+        }
+      }
+    }
+
+    SystemHang = (BOOLEAN) (SctCompareGuid (&Assertion.EventId, &gEfiSystemHangAssertionGuid) == 0);
+    if (SystemHang) {
+      TitleStr        = SctStrDuplicate (L"System hangs or stops abnormally.");
+      RuntimeInforStr = SctPoolPrint (L"System hang in %s - %s", TestCategoryStr, CaseNameStr);
+    }
+
+    //
+    // Set the report item
+    //
+    Status = InsertReportInfor (
+               CaseIndexStr,
+               CaseIterationStr,
+               TestNameStr,
+               TestCategoryStr,
+               GuidStr,
+               AssertionType,
+               TitleStr,
+               RuntimeInforStr,
+               DevicePathStr,
+               CaseRevisionStr,
+               CaseGuidStr,
+               FileName
+               );
+
+    if (SystemHang) {
+      if (TitleStr != NULL) {
+        tBS->FreePool (TitleStr);
+      }
+      if (RuntimeInforStr != NULL) {
+        tBS->FreePool (RuntimeInforStr);
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Set report item - %r", Status));
+      CloseKeyFileReader (&Reader);
+      return Status;
+    }
+  }
+
+  CloseKeyFileReader (&Reader);
+  return EFI_SUCCESS;
+}
+
+
 EFI_STATUS
 UnloadReportInfor (
   VOID
@@ -758,6 +1081,7 @@ Routine Description:
   }
 
   mReportInfor.ReportItem = NULL;
+  mLastReportItem         = NULL;
 
   mReportInfor.TotalPass = 0;
   mReportInfor.TotalWarn = 0;
@@ -768,40 +1092,34 @@ Routine Description:
 
 
 EFI_STATUS
-GetReportInfor (
-  OUT CHAR16                      **Buffer
+WriteReportInfor (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
   )
 /*++
 
 Routine Description:
 
-  Get the report information into a buffer.
+  Write the report information to a report writer.
 
 --*/
 {
   EFI_SCT_REPORT_ITEM       *ReportItem;
   EFI_SCT_ASSERTION_INFOR   *AssertionInfor;
-  CHAR16                    *TempBuffer;
 
   //
   // Check parameters
   //
-  if (Buffer == NULL) {
+  if (Writer == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  //
-  // Initialize
-  //
-  *Buffer = NULL;
-
   //
   // Add summary head:
   // "Self Certification Test Report"
   // "Service\Protocol Name", "Total", "Failed", "Passed"
   //
-  AutoStrCat (
-    Buffer,
+  ReportPrint (
+    Writer,
     L"\"Self Certification Test Report\"\n"
     L"\"Service\\Protocol Name\",\"Total\",\"Failed\",\"Passed\"\n"
     );
@@ -816,19 +1134,14 @@ Routine Description:
   }
 
   while (ReportItem != NULL) {
-    TempBuffer = SctPoolPrint (
-                   L"\"%s\",\"%d\",\"%d\",\"%d\"\n",
-                   ReportItem->TestCategory,
-                   ReportItem->PassNumber + ReportItem->FailNumber,
-                   ReportItem->FailNumber,
-                   ReportItem->PassNumber
-                   );
-    if (TempBuffer == NULL) {
-      break;
-    }
-
-    AutoStrCat (Buffer, TempBuffer);
-    tBS->FreePool (TempBuffer);
+    ReportPrint (
+      Writer,
+      L"\"%s\",\"%d\",\"%d\",\"%d\"\n",
+      ReportItem->TestCategory,
+      ReportItem->PassNumber + ReportItem->FailNumber,
+      ReportItem->FailNumber,
+      ReportItem->PassNumber
+      );
 
     ReportItem = ReportItem->Prev;
   }
@@ -836,24 +1149,20 @@ Routine Description:
   //
   // Total summary
   //
-  TempBuffer = SctPoolPrint (
-                 L"\"Total service\\Protocol\",\"%d\",\"%d\",\"%d\"\n",
-                 mReportInfor.TotalPass + mReportInfor.TotalFail,
-                 mReportInfor.TotalFail,
-                 mReportInfor.TotalPass
-                 );
-  if (TempBuffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  AutoStrCat (Buffer, TempBuffer);
+  ReportPrint (
+    Writer,
+    L"\"Total service\\Protocol\",\"%d\",\"%d\",\"%d\"\n",
+    mReportInfor.TotalPass + mReportInfor.TotalFail,
+    mReportInfor.TotalFail,
+    mReportInfor.TotalPass
+    );
 
   //
   // Add fail head:
   // "Service\Protocol Name", "Index","Instance","Iteration","Guid","Result","Title","Runtime Information","Case Revision","Case GUID","Device Path","Logfile Name"
   //
-  AutoStrCat (
-    Buffer,
+  ReportPrint (
+    Writer,
     L"\n\"Service\\Protocol Name\",\"Index\",\"Instance\",\"Iteration\",\"Guid\",\"Result\",\"Title\",\"Runtime Information\",\"Case Revision\",\"Case GUID\",\"Device Path\",\"Logfile Name\"\n"
     );
 
@@ -877,26 +1186,21 @@ Routine Description:
     }
 
     while (AssertionInfor != NULL) {
-      TempBuffer = SctPoolPrint (
-                     L"\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"FAIL\",\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"%s\"\n",
-                     ReportItem->TestCategory,
-                     AssertionInfor->Index,
-                     AssertionInfor->CaseIndex,
-                     AssertionInfor->CaseIteration,
-                     AssertionInfor->Guid,
-                     AssertionInfor->Title,
-                     AssertionInfor->RuntimeInfor,
-                     AssertionInfor->CaseRevision,
-                     AssertionInfor->CaseGuid,
-                     AssertionInfor->DevicePath,
-                     AssertionInfor->FileName
-                     );
-      if (TempBuffer == NULL) {
-        break;
-      }
-
-      AutoStrCat (Buffer, TempBuffer);
-      tBS->FreePool (TempBuffer);
+      ReportPrint (
+        Writer,
+        L"\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"FAIL\",\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"%s\"\n",
+        ReportItem->TestCategory,
+        AssertionInfor->Index,
+        AssertionInfor->CaseIndex,
+        AssertionInfor->CaseIteration,
+        AssertionInfor->Guid,
+        AssertionInfor->Title,
+        AssertionInfor->RuntimeInfor,
+        AssertionInfor->CaseRevision,
+        AssertionInfor->CaseGuid,
+        AssertionInfor->DevicePath,
+        AssertionInfor->FileName
+        );
 
       AssertionInfor = AssertionInfor->Prev;
     }
@@ -908,8 +1212,8 @@ Routine Description:
   // Add pass head:
   // "Service\Protocol Name","Index","Instance","Iteration","Guid","Result","Title","Runtime Information","Case Revision","Case GUID"  //
   //
-  AutoStrCat (
-    Buffer,
+  ReportPrint (
+    Writer,
     L"\n\"Service\\Protocol Name\",\"Index\",\"Instance\",\"Iteration\",\"Guid\",\"Result\",\"Title\",\"Runtime Information\",\"Case Revision\",\"Case GUID\"\n"
     );
 
@@ -933,24 +1237,19 @@ Routine Description:
     }
 
     while (AssertionInfor != NULL) {
-      TempBuffer = SctPoolPrint (
-                     L"\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"PASS\",\"%s\",\"%s\",\"%s\",\"%s\"\n",
-                     ReportItem->TestCategory,
-                     AssertionInfor->Index,
-                     AssertionInfor->CaseIndex,
-                     AssertionInfor->CaseIteration,
-                     AssertionInfor->Guid,
-                     AssertionInfor->Title,
-                     AssertionInfor->RuntimeInfor,
-                     AssertionInfor->CaseRevision,
-                     AssertionInfor->CaseGuid
-                     );
-      if (TempBuffer == NULL) {
-        break;
-      }
-
-      AutoStrCat (Buffer, TempBuffer);
-      tBS->FreePool (TempBuffer);
+      ReportPrint (
+        Writer,
+        L"\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"PASS\",\"%s\",\"%s\",\"%s\",\"%s\"\n",
+        ReportItem->TestCategory,
+        AssertionInfor->Index,
+        AssertionInfor->CaseIndex,
+        AssertionInfor->CaseIteration,
+        AssertionInfor->Guid,
+        AssertionInfor->Title,
+        AssertionInfor->RuntimeInfor,
+        AssertionInfor->CaseRevision,
+        AssertionInfor->CaseGuid
+        );
 
       AssertionInfor = AssertionInfor->Prev;
     }
@@ -958,7 +1257,10 @@ Routine Description:
     ReportItem = ReportItem->Prev;
   }
 
-  return EFI_SUCCESS;
+  //
+  // The errors are kept by the writer
+  //
+  return Writer->Status;
 }
 
 
@@ -968,7 +1270,7 @@ Routine Description:
 
 EFI_STATUS
 InsertGuidDatabase (
-  IN CHAR16                       *GuidStr,
+  IN EFI_GUID                     *Guid,
   IN CHAR16                       *TitleStr,
   IN CHAR16                       *IndexStr
   )
@@ -981,15 +1283,24 @@ Routine Description:
 --*/
 {
   EFI_STATUS              Status;
+  EFI_SCT_GUID_SLOT       *Slot;
   EFI_SCT_GUID_DATABASE   *TempGuidDatabase;
 
   //
   // Check parameters
   //
-  if ((GuidStr == NULL) || (TitleStr == NULL) || (IndexStr == NULL)) {
+  if ((Guid == NULL) || (TitleStr == NULL) || (IndexStr == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The first entry of a GUID wins, skip the later ones
+  //
+  Slot = FindGuidSlot (&mGuidDatabaseIndex, Guid);
+  if ((Slot != NULL) && (Slot->Entry != 0)) {
+    return EFI_SUCCESS;
+  }
+
   //
   // Need to create a new buffer?
   //
@@ -1045,39 +1356,46 @@ Routine Description:
   //
   // Append the GUID entry to the GUID database
   //
-  SctStrnCpy (mGuidDatabase[mGuidDatabaseUsedSize].Guid, GuidStr, EFI_SCT_GUID_LEN);
+  SctCopyMem (&mGuidDatabase[mGuidDatabaseUsedSize].Guid, Guid, sizeof(EFI_GUID));
   SctStrnCpy (mGuidDatabase[mGuidDatabaseUsedSize].Title, TitleStr, EFI_SCT_TITLE_LEN);
   SctStrnCpy (mGuidDatabase[mGuidDatabaseUsedSize].Index, IndexStr, EFI_SCT_INDEX_LEN);
   mGuidDatabaseUsedSize ++;
 
-  return EFI_SUCCESS;
+  //
+  // Add the GUID entry to the index
+  //
+  return InsertGuidIndex (&mGuidDatabaseIndex, Guid, mGuidDatabaseUsedSize);
 }
 
 
 EFI_STATUS
 InsertGuidAssertion (
-  IN CHAR16                           *GuidStr,
+  IN EFI_GUID                         *Guid OPTIONAL,
   IN UINTN                            AssertionType,
   IN BOOLEAN                          Duplicate,
-  OUT EFI_SCT_GUID_ASSERTION_STATE    *AssertionState
+  OUT EFI_SCT_GUID_ASSERTION_STATE    *AssertionState,
+  OUT EFI_SCT_GUID_ASSERTION          **GuidAssertion OPTIONAL
   )
 /*++
 
 Routine Description:
 
-  Insert a GUID assertion.
+  Insert a GUID assertion. An assertion without a valid GUID (Guid is NULL)
+  is never merged with the others.
 
 --*/
 {
   EFI_STATUS              Status;
-  INTN                    Index;
+  BOOLEAN                 Indexed;
   UINTN                   OldAssertionType;
-  CHAR16                  SystemHangGuidStr[EFI_SCT_GUID_LEN];
+  EFI_SCT_GUID_SLOT       *Slot;
+  EFI_SCT_GUID_ASSERTION  *Entry;
   EFI_SCT_GUID_ASSERTION  *TempGuidAssertion;
+
   //
   // Check parameters
   //
-  if ((GuidStr == NULL) || (AssertionState == NULL)) {
+  if (AssertionState == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
@@ -1091,34 +1409,42 @@ Routine Description:
   //
   // Initialize
   //
-  SctZeroMem (SystemHangGuidStr, EFI_SCT_GUID_LEN);
-  SctGuidToStr (&gEfiSystemHangAssertionGuid, SystemHangGuidStr);
-
   *AssertionState = EFI_SCT_GUID_ASSERTION_STATE_NOT_FOUND;
+  if (GuidAssertion != NULL) {
+    *GuidAssertion = NULL;
+  }
+
+  //
+  // Every system hang assertion is kept
+  //
+  Indexed = (BOOLEAN) ((Guid != NULL) &&
+                       (SctCompareGuid (Guid, &gEfiSystemHangAssertionGuid) != 0));
 
   //
   // Remove the duplicate GUID assertion
   //
-  if (!Duplicate && (SctStrCmp (SystemHangGuidStr, GuidStr) != 0)) {
+  if (!Duplicate && Indexed) {
     //
-    // Seach the GUID assertion, from the last one for performance
+    // The index refers to the last assertion with this GUID
     //
-    for (Index = (INTN)mGuidAssertionUsedSize - 1; Index >= 0; Index --) {
-      if (SctStrCmp (mGuidAssertion[Index].Guid, GuidStr) != 0) {
-        continue;
+    Slot = FindGuidSlot (&mGuidAssertionIndex, Guid);
+    if ((Slot != NULL) && (Slot->Entry != 0)) {
+      Entry = &mGuidAssertion[Slot->Entry - 1];
+      if (GuidAssertion != NULL) {
+        *GuidAssertion = Entry;
       }
 
       //
       // Find it.
       // Set the worst assertion type (Pass = 0x01, Warn = 0x03, Fail = 0x07)
       //
-      OldAssertionType = mGuidAssertion[Index].AssertionType;
+      OldAssertionType = Entry->AssertionType;
       if ((OldAssertionType | AssertionType) == OldAssertionType) {
         *AssertionState = EFI_SCT_GUID_ASSERTION_STATE_FOUND;
         return EFI_SUCCESS;
       }
 
-      mGuidAssertion[Index].AssertionType |= AssertionType;
+      Entry->AssertionType |= AssertionType;
       *AssertionState = EFI_SCT_GUID_ASSERTION_STATE_OVERRIDE;
       return EFI_SUCCESS;
     }
@@ -1162,7 +1488,7 @@ Routine Description:
       return Status;
     }
 
-    SctZeroMem (mGuidAssertion, mGuidAssertionMaxSize * sizeof(EFI_SCT_GUID_ASSERTION));
+    SctZeroMem (TempGuidAssertion, mGuidAssertionMaxSize * sizeof(EFI_SCT_GUID_ASSERTION));
 
     //
     // Copy the original data
@@ -1179,10 +1505,25 @@ Routine Description:
   //
   // Append the GUID entry to the GUID assertion
   //
-  SctStrnCpy (mGuidAssertion[mGuidAssertionUsedSize].Guid, GuidStr, EFI_SCT_GUID_LEN);
-  mGuidAssertion[mGuidAssertionUsedSize].AssertionType = AssertionType;
+  Entry = &mGuidAssertion[mGuidAssertionUsedSize];
+  SctZeroMem (Entry, sizeof(EFI_SCT_GUID_ASSERTION));
+  if (Guid != NULL) {
+    SctCopyMem (&Entry->Guid, Guid, sizeof(EFI_GUID));
+  }
+  Entry->AssertionType = AssertionType;
   mGuidAssertionUsedSize ++;
 
+  if (GuidAssertion != NULL) {
+    *GuidAssertion = Entry;
+  }
+
+  //
+  // Add the GUID entry to the index
+  //
+  if (Indexed) {
+    return InsertGuidIndex (&mGuidAssertionIndex, Guid, mGuidAssertionUsedSize);
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -1214,9 +1555,11 @@ Routine Description:
   EFI_SCT_REPORT_ITEM           *ReportItem;
   EFI_SCT_REPORT_ITEM           *NewReportItem;
   EFI_SCT_ASSERTION_INFOR       *AssertionInfor;
-  EFI_SCT_ASSERTION_INFOR       *LastAssertionInfor;
   EFI_SCT_ASSERTION_INFOR       *NewAssertionInfor;
   EFI_SCT_GUID_ASSERTION_STATE  AssertionState;
+  EFI_SCT_GUID_ASSERTION        *GuidAssertion;
+  EFI_GUID                      Guid;
+  BOOLEAN                       ValidGuid;
 
   if ((CaseIndexStr == NULL) || (CaseIterationStr == NULL) ||
       (TestNameStr  == NULL) || (TestCategoryStr  == NULL) ||
@@ -1234,11 +1577,14 @@ Routine Description:
   //
   // Insert the GUID assertion
   //
+  ValidGuid = (BOOLEAN) !EFI_ERROR (ConvertStrToGuid (GuidStr, &Guid));
+
   Status = InsertGuidAssertion (
-             GuidStr,
+             ValidGuid ? &Guid : NULL,
              AssertionType,
              FALSE,                     // Without duplicate
-             &AssertionState
+             &AssertionState,
+             &GuidAssertion
              );
   if (EFI_ERROR (Status)) {
     EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Insert GUID assertion - %r", Status));
@@ -1253,52 +1599,48 @@ Routine Description:
   }
 
   //
-  // Search the report category
+  // Override the pass assertion. The GUID assertion refers to the passed
+  // assertion info, so remove it from its report item directly
   //
-  ReportItem = mReportInfor.ReportItem;
-  while (ReportItem != NULL) {
-    if (SctStrCmp (ReportItem->TestName, TestNameStr) != 0) {
-      ReportItem = ReportItem->Next;
-      continue;
+  if ((AssertionState == EFI_SCT_GUID_ASSERTION_STATE_OVERRIDE) &&
+      (GuidAssertion->AssertionInfor != NULL)) {
+    ReportItem     = GuidAssertion->ReportItem;
+    AssertionInfor = GuidAssertion->AssertionInfor;
+
+    mReportInfor.TotalPass --;
+    ReportItem->PassNumber --;
+
+    if (AssertionInfor->Prev == NULL) {
+      ReportItem->PassAssertion  = AssertionInfor->Next;
+    } else {
+      AssertionInfor->Prev->Next = AssertionInfor->Next;
     }
 
-    //
-    // Override the pass assertion
-    //
-    if (AssertionState == EFI_SCT_GUID_ASSERTION_STATE_OVERRIDE) {
-      mReportInfor.TotalPass --;
-      ReportItem->PassNumber --;
+    if (AssertionInfor->Next != NULL) {
+      AssertionInfor->Next->Prev = AssertionInfor->Prev;
+    }
 
-      //
-      // Search the passed assertion and remove it
-      //
-      AssertionInfor = ReportItem->PassAssertion;
-      LastAssertionInfor = NULL;
-
-      while (AssertionInfor != NULL) {
-        if (SctStrCmp (AssertionInfor->Guid, GuidStr) == 0) {
-          //
-          // Found it
-          //
-          if (LastAssertionInfor == NULL) {
-            ReportItem->PassAssertion  = AssertionInfor->Next;
-          } else {
-            LastAssertionInfor->Next   = AssertionInfor->Next;
-          }
-
-          if (AssertionInfor->Next != NULL) {
-            AssertionInfor->Next->Prev = LastAssertionInfor;
-          }
-
-          tBS->FreePool (AssertionInfor);
-          break;
-        }
+    tBS->FreePool (AssertionInfor);
+
+    GuidAssertion->ReportItem     = NULL;
+    GuidAssertion->AssertionInfor = NULL;
+  }
 
-        LastAssertionInfor = AssertionInfor;
-        AssertionInfor     = AssertionInfor->Next;
+  //
+  // Search the report category. The assertions of a test case are adjacent
+  // in the log file, so check the last used one first
+  //
+  if ((mLastReportItem != NULL) &&
+      (SctStrCmp (mLastReportItem->TestName, TestNameStr) == 0)) {
+    ReportItem = mLastReportItem;
+  } else {
+    ReportItem = mReportInfor.ReportItem;
+    while (ReportItem != NULL) {
+      if (SctStrCmp (ReportItem->TestName, TestNameStr) == 0) {
+        break;
       }
+      ReportItem = ReportItem->Next;
     }
-    break;
   }
 
   if (ReportItem == NULL) {
@@ -1334,6 +1676,8 @@ Routine Description:
     ReportItem = NewReportItem;
   }
 
+  mLastReportItem = ReportItem;
+
   //
   // Update the assertion number
   //
@@ -1363,11 +1707,15 @@ Routine Description:
   //
   // Get the Title and Index from GUID database
   //
-  Status = SearchGuidDatabase (
-             GuidStr,
-             NewAssertionInfor->Title,
-             NewAssertionInfor->Index
-             );
+  if (ValidGuid) {
+    Status = SearchGuidDatabase (
+               &Guid,
+               NewAssertionInfor->Title,
+               NewAssertionInfor->Index
+               );
+  } else {
+    Status = EFI_NOT_FOUND;
+  }
   if (EFI_ERROR (Status)) {
     //
     // Cannot find the related entry in the GUID database. It is not a fatal
@@ -1418,8 +1766,156 @@ Routine Description:
     AssertionInfor->Prev = NewAssertionInfor;
   }
 
+  //
+  // Remember the passed assertion info for a later override
+  //
+  if ((AssertionType == EFI_SCT_GUID_ASSERTION_TYPE_PASS) && (GuidAssertion != NULL)) {
+    GuidAssertion->ReportItem     = ReportItem;
+    GuidAssertion->AssertionInfor = NewAssertionInfor;
+  }
+
   //
   // Done
   //
   return EFI_SUCCESS;
 }
+
+
+EFI_SCT_GUID_SLOT *
+FindGuidSlot (
+  IN EFI_SCT_GUID_INDEX           *GuidIndex,
+  IN EFI_GUID                     *Guid
+  )
+/*++
+
+Routine Description:
+
+  Find the slot of a GUID in the index. Returns the slot holding the GUID, or
+  the empty slot where the GUID would be inserted, or NULL if the index has
+  not been created.
+
+--*/
+{
+  UINTN               Hash;
+  UINTN               Mask;
+  UINTN               Count;
+  EFI_SCT_GUID_SLOT   *Slot;
+
+  if ((GuidIndex->Slots == NULL) || (GuidIndex->SlotCount == 0)) {
+    return NULL;
+  }
+
+  //
+  // Mix the GUID fields. The test assertion GUIDs are random, so it is good
+  // enough for a linear probing
+  //
+  Hash = Guid->Data1 ^ ((UINTN) Guid->Data2 << 16) ^ Guid->Data3;
+  for (Count = 0; Count < 8; Count ++) {
+    Hash = (Hash * 31) + Guid->Data4[Count];
+  }
+
+  Mask = GuidIndex->SlotCount - 1;
+  Hash = Hash & Mask;
+
+  for (Count = 0; Count < GuidIndex->SlotCount; Count ++) {
+    Slot = &GuidIndex->Slots[(Hash + Count) & Mask];
+    if ((Slot->Entry == 0) || (SctCompareGuid (&Slot->Guid, Guid) == 0)) {
+      return Slot;
+    }
+  }
+
+  //
+  // The index is never full
+  //
+  return NULL;
+}
+
+
+EFI_STATUS
+InsertGuidIndex (
+  IN OUT EFI_SCT_GUID_INDEX       *GuidIndex,
+  IN EFI_GUID                     *Guid,
+  IN UINTN                        Entry
+  )
+/*++
+
+Routine Description:
+
+  Insert a GUID into the index, or update the entry of an existing one.
+
+--*/
+{
+  EFI_STATUS          Status;
+  UINTN               Index;
+  EFI_SCT_GUID_INDEX  NewIndex;
+  EFI_SCT_GUID_SLOT   *Slot;
+
+  //
+  // Need to create or enlarge the index? Keep it at most half full
+  //
+  if ((GuidIndex->UsedCount + 1) * 2 > GuidIndex->SlotCount) {
+    if (GuidIndex->SlotCount == 0) {
+      NewIndex.SlotCount = EFI_SCT_GUID_INDEX_SIZE;
+    } else {
+      NewIndex.SlotCount = GuidIndex->SlotCount * 2;
+    }
+    NewIndex.UsedCount = 0;
+
+    Status = tBS->AllocatePool (
+                   EfiBootServicesData,
+                   NewIndex.SlotCount * sizeof(EFI_SCT_GUID_SLOT),
+                   (VOID **)&NewIndex.Slots
+                   );
+    if (EFI_ERROR (Status)) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+      return Status;
+    }
+
+    SctZeroMem (NewIndex.Slots, NewIndex.SlotCount * sizeof(EFI_SCT_GUID_SLOT));
+
+    //
+    // Rehash the original entries
+    //
+    for (Index = 0; Index < GuidIndex->SlotCount; Index ++) {
+      if (GuidIndex->Slots[Index].Entry != 0) {
+        Slot = FindGuidSlot (&NewIndex, &GuidIndex->Slots[Index].Guid);
+        *Slot = GuidIndex->Slots[Index];
+        NewIndex.UsedCount ++;
+      }
+    }
+
+    FreeGuidIndex (GuidIndex);
+    *GuidIndex = NewIndex;
+  }
+
+  Slot = FindGuidSlot (GuidIndex, Guid);
+  if (Slot->Entry == 0) {
+    SctCopyMem (&Slot->Guid, Guid, sizeof(EFI_GUID));
+    GuidIndex->UsedCount ++;
+  }
+  Slot->Entry = Entry;
+
+  return EFI_SUCCESS;
+}
+
+
+VOID
+FreeGuidIndex (
+  IN OUT EFI_SCT_GUID_INDEX       *GuidIndex
+  )
+/*++
+
+Routine Description:
+
+  Free the GUID index.
+
+--*/
+{
+  if (GuidIndex->Slots != NULL) {
+    tBS->FreePool (GuidIndex->Slots);
+  }
+
+  GuidIndex->Slots     = NULL;
+  GuidIndex->SlotCount = 0;
+  GuidIndex->UsedCount = 0;
+}
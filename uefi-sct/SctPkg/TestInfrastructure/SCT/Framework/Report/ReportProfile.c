@@ -0,0 +1,280 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2017, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+Module Name:
+
+  ReportProfile.c
+
+Abstract:
+
+  This file provides the services to deal with the profile records of the
+  test instances for test report generation. Only the slowest instances are
+  kept, sorted by the elapsed time. The clock that timed each of them is
+  reported with it.
+
+--*/
+
+#include "Sct.h"
+#include "ReportSupport.h"
+
+//
+// Modular variables
+//
+
+EFI_SCT_PROFILE_INFOR   mProfileInfor[EFI_SCT_SLOWEST_CASE_NUM];
+UINTN                   mProfileInforCount = 0;
+
+//
+// Internal functions declaration
+//
+
+EFI_STATUS
+InsertProfileInfor (
+  IN EFI_SCT_PROFILE_INFOR        *ProfileInfor
+  );
+
+//
+// Module functions implementation
+//
+
+EFI_STATUS
+LoadProfileInfor (
+  IN CHAR16                       *Buffer,
+  IN CHAR16                       *FileName
+  )
+/*++
+
+Routine Description:
+
+  Load a profile record from a buffer.
+
+--*/
+{
+  EFI_SCT_PROFILE_INFOR   ProfileInfor;
+  CHAR16                  *LineBuffer;
+  CHAR16                  *FieldStr[EFI_SCT_PROFILE_FIELD_NUM];
+  UINTN                   Index;
+  UINT64                  Value;
+
+  //
+  // Check parameters
+  //
+  if ((Buffer == NULL) || (FileName == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Skip the first unicode char 0xFEFF
+  //
+  if (Buffer[0] != 0xFEFF) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Unsupported profile buffer"));
+    return EFI_SUCCESS;
+  }
+
+  LineBuffer = StrTokenLine (Buffer + 1, L"\n\r");
+  if ((LineBuffer == NULL) || (LineBuffer[0] != L'|')) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Split the record into the fields, the leading '|' is skipped
+  //
+  FieldStr[0] = StrTokenField (LineBuffer + 1, L"|");
+  for (Index = 1; Index < EFI_SCT_PROFILE_FIELD_NUM; Index ++) {
+    FieldStr[Index] = StrTokenField (NULL, L"|");
+  }
+
+  for (Index = 0; Index < EFI_SCT_PROFILE_FIELD_NUM; Index ++) {
+    if (FieldStr[Index] == NULL) {
+      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Incomplete profile record"));
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (SctStrCmp (FieldStr[0], EFI_SCT_PROFILE_RECORD_TAG) != 0) {
+    return EFI_SUCCESS;
+  }
+
+  SctZeroMem (&ProfileInfor, sizeof(EFI_SCT_PROFILE_INFOR));
+
+  SctStrToUInt64 (FieldStr[1], &Value);
+  ProfileInfor.Microseconds    = Value;
+  SctStrToUInt64 (FieldStr[3], &Value);
+  ProfileInfor.Assertions      = Value;
+  SctStrToUInt64 (FieldStr[4], &Value);
+  ProfileInfor.BytesWritten    = Value;
+  SctStrToUInt64 (FieldStr[5], &Value);
+  ProfileInfor.FreePagesBefore = Value;
+  SctStrToUInt64 (FieldStr[6], &Value);
+  ProfileInfor.FreePagesAfter  = Value;
+
+  SctStrnCpy (ProfileInfor.Clock, FieldStr[2], EFI_SCT_PROFILE_CLOCK_LEN - 1);
+  SctStrnCpy (ProfileInfor.CaseGuid, FieldStr[7], EFI_SCT_CASE_GUID_LEN - 1);
+  SctStrnCpy (ProfileInfor.CaseName, FieldStr[8], EFI_SCT_NAME_LEN - 1);
+  SctStrnCpy (ProfileInfor.FileName, FileName, EFI_SCT_NAME_LEN - 1);
+
+  return InsertProfileInfor (&ProfileInfor);
+}
+
+
+EFI_STATUS
+UnloadProfileInfor (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Unload the profile information.
+
+--*/
+{
+  mProfileInforCount = 0;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+WriteProfileInfor (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
+  )
+/*++
+
+Routine Description:
+
+  Write the slowest test instances to a report writer. Nothing is written if
+  no profile record was found.
+
+--*/
+{
+  UINTN                   Index;
+  EFI_SCT_PROFILE_INFOR   *ProfileInfor;
+  UINT64                  DeltaPages;
+  CHAR16                  *DeltaSign;
+  UINT64                  Milliseconds;
+  UINTN                   Microseconds;
+
+  //
+  // Check parameters
+  //
+  if (Writer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mProfileInforCount == 0) {
+    return Writer->Status;
+  }
+
+  //
+  // Add slowest cases head:
+  // "Slowest Test Instances"
+  // "Case Name","Case GUID","Time (ms)","Clock","Assertions","Bytes Logged","Memory Delta (KB)","Profile Name"
+  //
+  ReportPrint (
+    Writer,
+    L"\n\"Slowest Test Instances\"\n"
+    L"\"Case Name\",\"Case GUID\",\"Time (ms)\",\"Clock\",\"Assertions\",\"Bytes Logged\",\"Memory Delta (KB)\",\"Profile Name\"\n"
+    );
+
+  for (Index = 0; Index < mProfileInforCount; Index ++) {
+    ProfileInfor = &mProfileInfor[Index];
+
+    //
+    // The memory delta is the change of the used memory
+    //
+    if (ProfileInfor->FreePagesBefore >= ProfileInfor->FreePagesAfter) {
+      DeltaPages = ProfileInfor->FreePagesBefore - ProfileInfor->FreePagesAfter;
+      DeltaSign  = L"";
+    } else {
+      DeltaPages = ProfileInfor->FreePagesAfter - ProfileInfor->FreePagesBefore;
+      DeltaSign  = L"-";
+    }
+
+    Milliseconds = SctDivU64x32 (ProfileInfor->Microseconds, 1000, &Microseconds);
+
+    ReportPrint (
+      Writer,
+      L"\"%s\",\"%s\",\"%ld.%03d\",\"%s\",\"%ld\",\"%ld\",\"%s%ld\",\"%s\"\n",
+      ProfileInfor->CaseName,
+      ProfileInfor->CaseGuid,
+      Milliseconds,
+      Microseconds,
+      ProfileInfor->Clock,
+      ProfileInfor->Assertions,
+      ProfileInfor->BytesWritten,
+      DeltaSign,
+      SctMultU64x32 (DeltaPages, 4),
+      ProfileInfor->FileName
+      );
+  }
+
+  //
+  // The errors are kept by the writer
+  //
+  return Writer->Status;
+}
+
+
+//
+// Internal functions implementation
+//
+
+EFI_STATUS
+InsertProfileInfor (
+  IN EFI_SCT_PROFILE_INFOR        *ProfileInfor
+  )
+/*++
+
+Routine Description:
+
+  Insert a profile record into the slowest instance list, which is sorted by
+  the elapsed time in descending order. The record is dropped if the list is
+  full and it is not slower than the last one.
+
+--*/
+{
+  UINTN   Index;
+  UINTN   Last;
+
+  Index = mProfileInforCount;
+  while ((Index > 0) &&
+         (mProfileInfor[Index - 1].Microseconds < ProfileInfor->Microseconds)) {
+    Index --;
+  }
+
+  if (Index == EFI_SCT_SLOWEST_CASE_NUM) {
+    return EFI_SUCCESS;
+  }
+
+  if (mProfileInforCount < EFI_SCT_SLOWEST_CASE_NUM) {
+    mProfileInforCount ++;
+  }
+
+  //
+  // Move the faster ones down, the last one drops out of a full list
+  //
+  for (Last = mProfileInforCount - 1; Last > Index; Last --) {
+    SctCopyMem (
+      &mProfileInfor[Last],
+      &mProfileInfor[Last - 1],
+      sizeof(EFI_SCT_PROFILE_INFOR)
+      );
+  }
+
+  SctCopyMem (&mProfileInfor[Index], ProfileInfor, sizeof(EFI_SCT_PROFILE_INFOR));
+
+  return EFI_SUCCESS;
+}
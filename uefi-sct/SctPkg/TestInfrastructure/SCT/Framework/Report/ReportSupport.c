@@ -31,10 +31,6 @@ Abstract:
 // Module variables
 //
 
-CHAR16  *mReportBuffer        = NULL;
-UINTN   mReportBufferMaxSize  = 0;
-UINTN   mReportBufferUsedSize = 0;
-
 CHAR16  *mLineBuffer          = NULL;
 CHAR16  *mFieldBuffer         = NULL;
 
@@ -55,6 +51,16 @@ StrBrk (
   IN CHAR16                       *CharSet
   );
 
+EFI_STATUS
+FlushReportWriter (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
+  );
+
+BOOLEAN
+IsKeyFileSegment (
+  IN EFI_SCT_KEY_FILE_READER      *Reader
+  );
+
 
 //
 // Module functions implementation
@@ -394,101 +400,195 @@ Routine Description:
 }
 
 EFI_STATUS
-AutoStrCat (
-  IN OUT CHAR16                   **DstBuffer,
-  IN CHAR16                       *SrcBuffer
+OpenReportWriter (
+  IN EFI_FILE_HANDLE              Handle,
+  OUT EFI_SCT_REPORT_WRITER       *Writer
   )
 /*++
 
 Routine Description:
 
-  Append one string to an automatically enlarged string.
+  Create a report writer on an opened file.
 
 --*/
 {
   EFI_STATUS  Status;
-  CHAR16      *TempBuffer;
 
   //
   // Check parameters
   //
-  if ((DstBuffer == NULL) || (SrcBuffer == NULL)) {
+  if ((Handle == NULL) || (Writer == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  if (SctStrLen (SrcBuffer) >= EFI_SCT_LOG_BUFFER_SIZE) {
-    return EFI_INVALID_PARAMETER;
+  SctZeroMem (Writer, sizeof(EFI_SCT_REPORT_WRITER));
+
+  //
+  // Allocate the output buffer and the line buffer
+  //
+  Status = tBS->AllocatePool (
+                 EfiBootServicesData,
+                 EFI_SCT_REPORT_BUFFER_SIZE,
+                 (VOID **)&Writer->Buffer
+                 );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+    return Status;
+  }
+
+  Status = tBS->AllocatePool (
+                 EfiBootServicesData,
+                 EFI_SCT_REPORT_LINE_LEN * sizeof(CHAR16),
+                 (VOID **)&Writer->LineBuffer
+                 );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+    tBS->FreePool (Writer->Buffer);
+    Writer->Buffer = NULL;
+    return Status;
   }
 
+  Writer->Handle = Handle;
+  Writer->Status = EFI_SUCCESS;
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+CloseReportWriter (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
+  )
+/*++
+
+Routine Description:
+
+  Write out the remaining data and free the report writer. The file itself
+  is not closed.
+
+Returns:
+
+  The first error met by the report writer, or EFI_SUCCESS.
+
+--*/
+{
   //
-  // Need to create a new buffer?
+  // Check parameters
   //
-  if (*DstBuffer == NULL) {
-    //
-    // Allocate buffer for the destination data
-    //
-    mReportBufferMaxSize  = EFI_SCT_LOG_BUFFER_SIZE;
-    mReportBufferUsedSize = 0;
+  if (Writer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-    Status = tBS->AllocatePool (
-                   EfiBootServicesData,
-                   mReportBufferMaxSize * sizeof(CHAR16),
-                   (VOID **)&mReportBuffer
-                   );
-    if (EFI_ERROR (Status)) {
-      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
-      mReportBufferMaxSize = 0;
-      return Status;
-    }
+  FlushReportWriter (Writer);
 
-    SctZeroMem (mReportBuffer, mReportBufferMaxSize * sizeof(CHAR16));
+  if (Writer->Buffer != NULL) {
+    tBS->FreePool (Writer->Buffer);
+    Writer->Buffer = NULL;
   }
 
+  if (Writer->LineBuffer != NULL) {
+    tBS->FreePool (Writer->LineBuffer);
+    Writer->LineBuffer = NULL;
+  }
+
+  return Writer->Status;
+}
+
+
+EFI_STATUS
+ReportWrite (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer,
+  IN CHAR8                        *Buffer,
+  IN UINTN                        BufferSize
+  )
+/*++
+
+Routine Description:
+
+  Write an ASCII buffer to the report file.
+
+--*/
+{
+  UINTN   Size;
+
   //
-  // Need to enlarge a new buffer
+  // Check parameters
   //
-  if (mReportBufferUsedSize + SctStrLen (SrcBuffer) >= mReportBufferMaxSize) {
-    //
-    // Allocate buffer for the destination data
-    //
-    mReportBufferMaxSize = mReportBufferMaxSize * 2;
+  if ((Writer == NULL) || (Buffer == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
 
-    Status = tBS->AllocatePool (
-                   EfiBootServicesData,
-                   mReportBufferMaxSize * sizeof(CHAR16),
-                   (VOID **)&TempBuffer
-                   );
-    if (EFI_ERROR (Status)) {
-      EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
-      mReportBufferMaxSize = mReportBufferMaxSize / 2;
-      return Status;
+  while ((BufferSize != 0) && !EFI_ERROR (Writer->Status)) {
+    if (Writer->UsedSize == EFI_SCT_REPORT_BUFFER_SIZE) {
+      FlushReportWriter (Writer);
+      continue;
     }
 
-    SctZeroMem (TempBuffer, mReportBufferMaxSize * sizeof(CHAR16));
+    Size = EFI_SCT_REPORT_BUFFER_SIZE - Writer->UsedSize;
+    if (Size > BufferSize) {
+      Size = BufferSize;
+    }
 
-    //
-    // Copy the original data
-    //
-    SctCopyMem (TempBuffer, mReportBuffer, mReportBufferUsedSize * sizeof(CHAR16));
+    SctCopyMem (Writer->Buffer + Writer->UsedSize, Buffer, Size);
+    Writer->UsedSize += Size;
 
-    //
-    // Free the original buffer
-    //
-    tBS->FreePool (mReportBuffer);
-    mReportBuffer = TempBuffer;
+    Buffer     += Size;
+    BufferSize -= Size;
   }
 
+  return Writer->Status;
+}
+
+
+EFI_STATUS
+ReportPrint (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer,
+  IN CHAR16                       *Format,
+  ...
+  )
+/*++
+
+Routine Description:
+
+  Print a formatted line to the report file. The line is truncated to
+  EFI_SCT_REPORT_LINE_LEN characters.
+
+--*/
+{
+  VA_LIST   Marker;
+  CHAR16    *String;
+
   //
-  // Append the source data to the destination data
+  // Check parameters
   //
-  SctStrCpy (mReportBuffer + mReportBufferUsedSize, SrcBuffer);
-  mReportBufferUsedSize += SctStrLen (SrcBuffer);
+  if ((Writer == NULL) || (Format == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (EFI_ERROR (Writer->Status)) {
+    return Writer->Status;
+  }
+
+  VA_START (Marker, Format);
+  SctVSPrint (Writer->LineBuffer, EFI_SCT_REPORT_LINE_LEN * sizeof(CHAR16), Format, Marker);
+  VA_END (Marker);
 
   //
-  // Done
+  // Convert the line to ASCII in the output buffer
   //
-  *DstBuffer = mReportBuffer;
-  return EFI_SUCCESS;
+  String = Writer->LineBuffer;
+  while ((*String != L'\0') && !EFI_ERROR (Writer->Status)) {
+    if (Writer->UsedSize == EFI_SCT_REPORT_BUFFER_SIZE) {
+      FlushReportWriter (Writer);
+      continue;
+    }
+
+    Writer->Buffer[Writer->UsedSize] = (CHAR8) (*String & 0x00FF);
+    Writer->UsedSize ++;
+    String ++;
+  }
+
+  return Writer->Status;
 }
 
 
@@ -568,6 +668,339 @@ Routine Description:
 }
 
 
+EFI_STATUS
+ConvertStrToGuid (
+  IN CHAR16                       *String,
+  OUT EFI_GUID                    *Guid
+  )
+/*++
+
+Routine Description:
+
+  Convert a GUID string in the "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX" format
+  to a GUID.
+
+--*/
+{
+  UINTN   Index;
+
+  if ((String == NULL) || (Guid == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Check the format of the GUID string
+  //
+  for (Index = 0; Index < 36; Index ++) {
+    if ((Index == 8) || (Index == 13) || (Index == 18) || (Index == 23)) {
+      if (String[Index] != L'-') {
+        return EFI_INVALID_PARAMETER;
+      }
+    } else if (!(((String[Index] >= L'0') && (String[Index] <= L'9')) ||
+                 ((String[Index] >= L'a') && (String[Index] <= L'f')) ||
+                 ((String[Index] >= L'A') && (String[Index] <= L'F')))) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  if (String[Index] != L'\0') {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return SctStrToGuid (String, Guid);
+}
+
+
+BOOLEAN
+IsBinaryKeyFile (
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize
+  )
+/*++
+
+Routine Description:
+
+  Check whether a key file is in the binary format, which starts with a
+  segment header after the Unicode flag 0xFEFF.
+
+--*/
+{
+  UINT32  Signature;
+
+  if ((Buffer == NULL) || (BufferSize < sizeof(CHAR16) + sizeof(EFI_KEY_FILE_HEADER))) {
+    return FALSE;
+  }
+
+  if (*(CHAR16 *) Buffer != 0xFEFF) {
+    return FALSE;
+  }
+
+  SctCopyMem (&Signature, (UINT8 *) Buffer + sizeof(CHAR16), sizeof(UINT32));
+  return (BOOLEAN) (Signature == EFI_KEY_FILE_SIGNATURE);
+}
+
+
+EFI_STATUS
+OpenKeyFileReader (
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize,
+  OUT EFI_SCT_KEY_FILE_READER     *Reader
+  )
+/*++
+
+Routine Description:
+
+  Open a reader on a binary key file buffer.
+
+--*/
+{
+  if ((Buffer == NULL) || (Reader == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!IsBinaryKeyFile (Buffer, BufferSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  SctZeroMem (Reader, sizeof(EFI_SCT_KEY_FILE_READER));
+  Reader->Buffer     = (UINT8 *) Buffer;
+  Reader->BufferSize = BufferSize;
+  Reader->Offset     = sizeof(CHAR16);
+
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+CloseKeyFileReader (
+  IN OUT EFI_SCT_KEY_FILE_READER  *Reader
+  )
+/*++
+
+Routine Description:
+
+  Close a binary key file reader.
+
+--*/
+{
+  if (Reader == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Reader->Descriptions != NULL) {
+    tBS->FreePool (Reader->Descriptions);
+    Reader->Descriptions = NULL;
+  }
+
+  Reader->DescriptionMax = 0;
+  return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+ReadKeyFileRecord (
+  IN OUT EFI_SCT_KEY_FILE_READER  *Reader,
+  OUT UINT16                      *Type,
+  OUT UINT8                       **Record,
+  OUT UINTN                       *RecordSize
+  )
+/*++
+
+Routine Description:
+
+  Read the next head, assertion or terminator record from a binary key file.
+  The segment headers and the description records are handled by the reader,
+  and the records of unknown types are skipped.
+
+  A broken record or a segment of an unsupported version is skipped up to the
+  next segment header.
+
+Returns:
+
+  EFI_SUCCESS   - A record is read.
+  EFI_NOT_FOUND - No more records.
+
+--*/
+{
+  EFI_STATUS                      Status;
+  EFI_KEY_FILE_HEADER             Header;
+  EFI_KEY_FILE_RECORD             RecordHeader;
+  UINT8                           *Data;
+  UINTN                           Remain;
+  UINT16                          Id;
+  UINTN                           Offset;
+  CHAR16                          *Description;
+  CHAR16                          **Descriptions;
+  UINTN                           DescriptionMax;
+  BOOLEAN                         Broken;
+
+  if ((Reader == NULL) || (Type == NULL) || (Record == NULL) || (RecordSize == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  while (Reader->Offset + sizeof(EFI_KEY_FILE_RECORD) <= Reader->BufferSize) {
+    Data   = Reader->Buffer + Reader->Offset;
+    Remain = Reader->BufferSize - Reader->Offset;
+    Broken = FALSE;
+
+    if (IsKeyFileSegment (Reader)) {
+      //
+      // A new segment, its description IDs start from 0 again
+      //
+      SctCopyMem (&Header, Data, sizeof(EFI_KEY_FILE_HEADER));
+      if ((Header.Version == EFI_KEY_FILE_VERSION) &&
+          (Header.HeaderSize >= sizeof(EFI_KEY_FILE_HEADER)) &&
+          ((Header.HeaderSize & 1) == 0) &&
+          (Header.HeaderSize <= Remain)) {
+        Reader->Offset += Header.HeaderSize;
+        if (Reader->Descriptions != NULL) {
+          SctZeroMem (Reader->Descriptions, Reader->DescriptionMax * sizeof(CHAR16 *));
+        }
+        continue;
+      }
+
+      Broken = TRUE;
+    } else {
+      SctCopyMem (&RecordHeader, Data, sizeof(EFI_KEY_FILE_RECORD));
+      if ((RecordHeader.Size < sizeof(EFI_KEY_FILE_RECORD)) ||
+          ((RecordHeader.Size & 1) != 0) ||
+          (RecordHeader.Size > Remain)) {
+        Broken = TRUE;
+      }
+    }
+
+    if (Broken) {
+      //
+      // Skip to the next segment header
+      //
+      EFI_SCT_DEBUG ((EFI_SCT_D_DEBUG, L"Broken key file record at 0x%x", Reader->Offset));
+      do {
+        Reader->Offset += sizeof(CHAR16);
+      } while ((Reader->Offset + sizeof(EFI_KEY_FILE_HEADER) <= Reader->BufferSize) &&
+               !IsKeyFileSegment (Reader));
+      continue;
+    }
+
+    Reader->Offset += RecordHeader.Size;
+
+    switch (RecordHeader.Type) {
+    case EFI_KEY_FILE_RECORD_HEAD:
+    case EFI_KEY_FILE_RECORD_ASSERTION:
+    case EFI_KEY_FILE_RECORD_TERM:
+      *Type       = RecordHeader.Type;
+      *Record     = Data;
+      *RecordSize = RecordHeader.Size;
+      return EFI_SUCCESS;
+
+    case EFI_KEY_FILE_RECORD_DESCRIPTION:
+      if (RecordHeader.Size < sizeof(EFI_KEY_FILE_DESCRIPTION_RECORD)) {
+        break;
+      }
+
+      SctCopyMem (&Id, Data + sizeof(EFI_KEY_FILE_RECORD), sizeof(UINT16));
+      Offset      = sizeof(EFI_KEY_FILE_DESCRIPTION_RECORD);
+      Description = GetKeyFileString (Data, RecordHeader.Size, &Offset);
+      if ((Description == NULL) || (Id == EFI_KEY_FILE_INLINE_DESCRIPTION)) {
+        break;
+      }
+
+      //
+      // Grow the description table to hold the ID
+      //
+      if (Id >= Reader->DescriptionMax) {
+        DescriptionMax = (Reader->DescriptionMax == 0) ? EFI_SCT_KEY_FILE_DESCRIPTION_SIZE : Reader->DescriptionMax;
+        while (Id >= DescriptionMax) {
+          DescriptionMax *= 2;
+        }
+
+        Status = tBS->AllocatePool (
+                       EfiBootServicesData,
+                       DescriptionMax * sizeof(CHAR16 *),
+                       (VOID **)&Descriptions
+                       );
+        if (EFI_ERROR (Status)) {
+          EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Allocate pool - %r", Status));
+          return Status;
+        }
+
+        SctZeroMem (Descriptions, DescriptionMax * sizeof(CHAR16 *));
+        if (Reader->Descriptions != NULL) {
+          SctCopyMem (Descriptions, Reader->Descriptions, Reader->DescriptionMax * sizeof(CHAR16 *));
+          tBS->FreePool (Reader->Descriptions);
+        }
+
+        Reader->Descriptions   = Descriptions;
+        Reader->DescriptionMax = DescriptionMax;
+      }
+
+      Reader->Descriptions[Id] = Description;
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+
+CHAR16 *
+GetKeyFileString (
+  IN UINT8                        *Record,
+  IN UINTN                        RecordSize,
+  IN OUT UINTN                    *Offset
+  )
+/*++
+
+Routine Description:
+
+  Get the string at Offset of a binary key file record, and move Offset after
+  its null terminator. NULL is returned if the string is not terminated in the
+  record.
+
+--*/
+{
+  CHAR16  *String;
+  UINTN   Index;
+
+  if ((Record == NULL) || (Offset == NULL)) {
+    return NULL;
+  }
+
+  String = (CHAR16 *) (Record + *Offset);
+  for (Index = *Offset; Index + sizeof(CHAR16) <= RecordSize; Index += sizeof(CHAR16)) {
+    if ((Record[Index] == 0) && (Record[Index + 1] == 0)) {
+      *Offset = Index + sizeof(CHAR16);
+      return String;
+    }
+  }
+
+  return NULL;
+}
+
+
+CHAR16 *
+GetKeyFileDescription (
+  IN EFI_SCT_KEY_FILE_READER      *Reader,
+  IN UINT16                       DescriptionId
+  )
+/*++
+
+Routine Description:
+
+  Get a description of the current segment by its ID.
+
+--*/
+{
+  if ((Reader == NULL) || (DescriptionId >= Reader->DescriptionMax)) {
+    return NULL;
+  }
+
+  return Reader->Descriptions[DescriptionId];
+}
+
+
 //
 // Internal functions implementation
 //
@@ -636,3 +1069,63 @@ Routine Description:
 
   return NULL;
 }
+
+
+EFI_STATUS
+FlushReportWriter (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
+  )
+/*++
+
+Routine Description:
+
+  Write the output buffer of a report writer to the file.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINTN       BufferSize;
+
+  if (EFI_ERROR (Writer->Status) || (Writer->UsedSize == 0)) {
+    return Writer->Status;
+  }
+
+  BufferSize = Writer->UsedSize;
+
+  Status = Writer->Handle->Write (
+                             Writer->Handle,
+                             &BufferSize,
+                             Writer->Buffer
+                             );
+  if (EFI_ERROR (Status)) {
+    EFI_SCT_DEBUG ((EFI_SCT_D_ERROR, L"Write report file - %r", Status));
+    Writer->Status = Status;
+    return Status;
+  }
+
+  Writer->UsedSize = 0;
+  return EFI_SUCCESS;
+}
+
+
+BOOLEAN
+IsKeyFileSegment (
+  IN EFI_SCT_KEY_FILE_READER      *Reader
+  )
+/*++
+
+Routine Description:
+
+  Check whether a segment header is at the current offset of a reader.
+
+--*/
+{
+  UINT32  Signature;
+
+  if (Reader->Offset + sizeof(EFI_KEY_FILE_HEADER) > Reader->BufferSize) {
+    return FALSE;
+  }
+
+  SctCopyMem (&Signature, Reader->Buffer + Reader->Offset, sizeof(UINT32));
+  return (BOOLEAN) (Signature == EFI_KEY_FILE_SIGNATURE);
+}
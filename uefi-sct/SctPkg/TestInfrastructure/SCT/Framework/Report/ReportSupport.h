@@ -33,8 +33,10 @@ Abstract:
 
 #define EFI_SCT_GUID_DATABASE_SIZE          5000
 #define EFI_SCT_GUID_ASSERTION_SIZE         5000
+#define EFI_SCT_GUID_INDEX_SIZE             1024
 
-#define EFI_SCT_LOG_BUFFER_SIZE             5000
+#define EFI_SCT_REPORT_BUFFER_SIZE          0x4000
+#define EFI_SCT_REPORT_LINE_LEN             2048
 
 #define EFI_SCT_GUID_LEN                    60
 #define EFI_SCT_TITLE_LEN                   300
@@ -47,6 +49,12 @@ Abstract:
 #define EFI_SCT_DEVICE_PATH_LEN             300
 #define EFI_SCT_NAME_LEN                    256
 
+#define EFI_SCT_SLOWEST_CASE_NUM            20
+#define EFI_SCT_PROFILE_FIELD_NUM           9
+#define EFI_SCT_PROFILE_CLOCK_LEN           16
+
+#define EFI_SCT_KEY_FILE_DESCRIPTION_SIZE   64
+
 //
 // EFI_SCT_GUID_ASSERTION_STATE
 //
@@ -66,23 +74,49 @@ typedef UINTN EFI_SCT_GUID_ASSERTION_STATE;
 #define EFI_SCT_GUID_ASSERTION_TYPE_FAIL          0x07
 
 //
-// EFI_SCT_GUID_DATABASE
+// EFI_SCT_REPORT_WRITER
+//
+// Each report line is formatted into LineBuffer, converted to ASCII into the
+// fixed size Buffer, and written to the file whenever Buffer is full. Status
+// keeps the first error, so the callers only check it when closing.
 //
 
 typedef struct {
-  CHAR16                          Guid[EFI_SCT_GUID_LEN];
-  CHAR16                          Title[EFI_SCT_TITLE_LEN];
-  CHAR16                          Index[EFI_SCT_INDEX_LEN];
-} EFI_SCT_GUID_DATABASE;
+  EFI_FILE_HANDLE                 Handle;
+  CHAR8                           *Buffer;
+  UINTN                           UsedSize;
+  CHAR16                          *LineBuffer;
+  EFI_STATUS                      Status;
+} EFI_SCT_REPORT_WRITER;
 
 //
-// EFI_SCT_GUID_ASSERTION
+// EFI_SCT_GUID_INDEX
+//
+// An open-addressing hash table which maps a GUID to an entry of the GUID
+// database or the GUID assertion table. Entry is the entry index plus 1, 0
+// means an empty slot. SlotCount is always a power of 2.
 //
 
 typedef struct {
-  CHAR16                          Guid[EFI_SCT_GUID_LEN];
-  UINTN                           AssertionType;
-} EFI_SCT_GUID_ASSERTION;
+  EFI_GUID                        Guid;
+  UINTN                           Entry;
+} EFI_SCT_GUID_SLOT;
+
+typedef struct {
+  EFI_SCT_GUID_SLOT               *Slots;
+  UINTN                           SlotCount;
+  UINTN                           UsedCount;
+} EFI_SCT_GUID_INDEX;
+
+//
+// EFI_SCT_GUID_DATABASE
+//
+
+typedef struct {
+  EFI_GUID                        Guid;
+  CHAR16                          Title[EFI_SCT_TITLE_LEN];
+  CHAR16                          Index[EFI_SCT_INDEX_LEN];
+} EFI_SCT_GUID_DATABASE;
 
 //
 // EFI_SCT_ASSERTION_INFOR
@@ -134,6 +168,51 @@ typedef struct {
   EFI_SCT_REPORT_ITEM             *ReportItem;
 } EFI_SCT_REPORT_INFOR;
 
+//
+// EFI_SCT_GUID_ASSERTION
+//
+// ReportItem and AssertionInfor refer to the passed assertion in the report
+// information, which is removed when a later failure overrides it.
+//
+
+typedef struct {
+  EFI_GUID                        Guid;
+  UINTN                           AssertionType;
+  EFI_SCT_REPORT_ITEM             *ReportItem;
+  EFI_SCT_ASSERTION_INFOR         *AssertionInfor;
+} EFI_SCT_GUID_ASSERTION;
+
+//
+// EFI_SCT_KEY_FILE_READER
+//
+// A reader of the binary key files, see KeyFile.h. The description records
+// are kept by the reader, Descriptions[Id] refers to the string in Buffer.
+//
+
+typedef struct {
+  UINT8                           *Buffer;
+  UINTN                           BufferSize;
+  UINTN                           Offset;
+  CHAR16                          **Descriptions;
+  UINTN                           DescriptionMax;
+} EFI_SCT_KEY_FILE_READER;
+
+//
+// EFI_SCT_PROFILE_INFOR
+//
+
+typedef struct {
+  UINT64                          Microseconds;
+  CHAR16                          Clock[EFI_SCT_PROFILE_CLOCK_LEN];
+  UINT64                          Assertions;
+  UINT64                          BytesWritten;
+  UINT64                          FreePagesBefore;
+  UINT64                          FreePagesAfter;
+  CHAR16                          CaseGuid[EFI_SCT_CASE_GUID_LEN];
+  CHAR16                          CaseName[EFI_SCT_NAME_LEN];
+  CHAR16                          FileName[EFI_SCT_NAME_LEN];
+} EFI_SCT_PROFILE_INFOR;
+
 //
 // Module functions declarations
 //
@@ -160,9 +239,28 @@ GetIndexFromFileName (
   );
 
 EFI_STATUS
-AutoStrCat (
-  IN OUT CHAR16                   **DstBuffer,
-  IN CHAR16                       *SrcBuffer
+OpenReportWriter (
+  IN EFI_FILE_HANDLE              Handle,
+  OUT EFI_SCT_REPORT_WRITER       *Writer
+  );
+
+EFI_STATUS
+CloseReportWriter (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
+  );
+
+EFI_STATUS
+ReportWrite (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer,
+  IN CHAR8                        *Buffer,
+  IN UINTN                        BufferSize
+  );
+
+EFI_STATUS
+ReportPrint (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer,
+  IN CHAR16                       *Format,
+  ...
   );
 
 CHAR16 *
@@ -177,6 +275,51 @@ StrTokenField (
   IN CHAR16                       *CharSet
   );
 
+EFI_STATUS
+ConvertStrToGuid (
+  IN CHAR16                       *String,
+  OUT EFI_GUID                    *Guid
+  );
+
+BOOLEAN
+IsBinaryKeyFile (
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize
+  );
+
+EFI_STATUS
+OpenKeyFileReader (
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize,
+  OUT EFI_SCT_KEY_FILE_READER     *Reader
+  );
+
+EFI_STATUS
+CloseKeyFileReader (
+  IN OUT EFI_SCT_KEY_FILE_READER  *Reader
+  );
+
+EFI_STATUS
+ReadKeyFileRecord (
+  IN OUT EFI_SCT_KEY_FILE_READER  *Reader,
+  OUT UINT16                      *Type,
+  OUT UINT8                       **Record,
+  OUT UINTN                       *RecordSize
+  );
+
+CHAR16 *
+GetKeyFileString (
+  IN UINT8                        *Record,
+  IN UINTN                        RecordSize,
+  IN OUT UINTN                    *Offset
+  );
+
+CHAR16 *
+GetKeyFileDescription (
+  IN EFI_SCT_KEY_FILE_READER      *Reader,
+  IN UINT16                       DescriptionId
+  );
+
 EFI_STATUS
 LoadGuidDatabase (
   IN EFI_DEVICE_PATH_PROTOCOL     *DevicePath,
@@ -190,7 +333,7 @@ UnloadGuidDatabase (
 
 EFI_STATUS
 SearchGuidDatabase (
-  IN CHAR16                       *GuidStr,
+  IN EFI_GUID                     *Guid,
   OUT CHAR16                      *TitleStr,
   OUT CHAR16                      *IndexStr
   );
@@ -202,6 +345,14 @@ LoadGuidAssertion (
   OUT EFI_SCT_LOG_STATE           *FileState
   );
 
+EFI_STATUS
+LoadBinaryGuidAssertion (
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize,
+  IN BOOLEAN                      Duplicate,
+  OUT EFI_SCT_LOG_STATE           *FileState
+  );
+
 EFI_STATUS
 UnloadGuidAssertion (
   VOID
@@ -222,14 +373,39 @@ LoadReportInfor (
   IN CHAR16                       *FileName
   );
 
+EFI_STATUS
+LoadBinaryReportInfor (
+  IN CHAR16                       *CaseIndexStr,
+  IN CHAR16                       *CaseIterationStr,
+  IN VOID                         *Buffer,
+  IN UINTN                        BufferSize,
+  IN CHAR16                       *FileName
+  );
+
 EFI_STATUS
 UnloadReportInfor (
   VOID
   );
 
 EFI_STATUS
-GetReportInfor (
-  OUT CHAR16                      **Buffer
+WriteReportInfor (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
+  );
+
+EFI_STATUS
+LoadProfileInfor (
+  IN CHAR16                       *Buffer,
+  IN CHAR16                       *FileName
+  );
+
+EFI_STATUS
+UnloadProfileInfor (
+  VOID
+  );
+
+EFI_STATUS
+WriteProfileInfor (
+  IN OUT EFI_SCT_REPORT_WRITER    *Writer
   );
 
 EFI_STATUS
@@ -0,0 +1,623 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2019 Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+
+Module Name:
+
+  ExportKeyFile.c
+
+Abstract:
+
+  Export a binary key file (see Drivers\Include\KeyFile.h) to the text key
+  file which the standard test library writes when the binary key file is not
+  enabled, so the existing tools could be used on it.
+
+--*/
+
+//
+// Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+//
+// Definitions
+//
+
+#define MAX_LINE_LENGTH             512
+
+#define UNICODE_FLAG                0xFEFF
+
+//
+// The binary key file, a copy of Drivers\Include\KeyFile.h
+//
+#define KEY_FILE_SIGNATURE          0x59454B53
+#define KEY_FILE_VERSION            0x0001
+
+#define KEY_FILE_RECORD_HEAD        0x0001
+#define KEY_FILE_RECORD_DESCRIPTION 0x0002
+#define KEY_FILE_RECORD_ASSERTION   0x0003
+#define KEY_FILE_RECORD_TERM        0x0004
+
+#define KEY_FILE_INLINE_DESCRIPTION 0xFFFF
+
+#define KEY_FILE_HEADER_SIZE        8
+#define KEY_FILE_RECORD_SIZE        4
+#define KEY_FILE_HEAD_SIZE          40
+#define KEY_FILE_DESCRIPTION_SIZE   6
+#define KEY_FILE_ASSERTION_SIZE     28
+#define KEY_FILE_TERM_SIZE          18
+
+#define TEST_ASSERTION_PASSED       0
+#define TEST_ASSERTION_WARNING      1
+
+//
+// Types
+//
+
+typedef struct {
+  const unsigned char *Buffer;
+  size_t              Size;
+  size_t              Offset;
+  size_t              Descriptions[0x10000];
+} KEY_FILE_READER;
+
+//
+// Internal functions declaration
+//
+
+void
+PrintUsage (
+  void
+  );
+
+unsigned long
+GetValue (
+  const unsigned char *Buffer,
+  size_t              Size
+  );
+
+int
+IsKeyFileSegment (
+  const KEY_FILE_READER *Reader
+  );
+
+int
+ReadKeyFileRecord (
+  KEY_FILE_READER       *Reader,
+  unsigned long         *Type,
+  size_t                *Record,
+  size_t                *RecordSize
+  );
+
+size_t
+GetKeyFileString (
+  const KEY_FILE_READER *Reader,
+  size_t                Record,
+  size_t                RecordSize,
+  size_t                *Offset
+  );
+
+void
+WriteAscii (
+  FILE                  *File,
+  const char            *Format,
+  ...
+  );
+
+void
+WriteString (
+  FILE                  *File,
+  const KEY_FILE_READER *Reader,
+  size_t                String
+  );
+
+void
+WriteGuid (
+  FILE                  *File,
+  const unsigned char   *Guid
+  );
+
+void
+WriteTime (
+  FILE                  *File,
+  const unsigned char   *Time
+  );
+
+void
+ExportRecord (
+  FILE                  *File,
+  const KEY_FILE_READER *Reader,
+  unsigned long         Type,
+  size_t                Record,
+  size_t                RecordSize
+  );
+
+//
+// Modular variables
+//
+
+static KEY_FILE_READER  mReader;
+
+//
+// External functions implementation
+//
+
+int
+main (
+  int         Argc,
+  char        **Argv
+  )
+{
+  FILE            *File;
+  unsigned char   *Buffer;
+  long            Size;
+  char            *OutputName;
+  unsigned long   Type;
+  size_t          Record;
+  size_t          RecordSize;
+  int             Failed;
+
+  //
+  // Check parameters
+  //
+  if ((Argc < 2) || (Argc > 3)) {
+    PrintUsage ();
+    return -1;
+  }
+
+  //
+  // Read the binary key file
+  //
+  File = fopen (Argv[1], "rb");
+  if (File == NULL) {
+    printf ("Error: Cannot open %s\n", Argv[1]);
+    return -1;
+  }
+
+  fseek (File, 0, SEEK_END);
+  Size = ftell (File);
+  fseek (File, 0, SEEK_SET);
+
+  Buffer = malloc ((Size > 0) ? (size_t) Size : 1);
+  if (Buffer == NULL) {
+    printf ("Error: Out of memory\n");
+    fclose (File);
+    return -1;
+  }
+
+  if ((Size < 0) || (fread (Buffer, 1, (size_t) Size, File) != (size_t) Size)) {
+    printf ("Error: Cannot read %s\n", Argv[1]);
+    free (Buffer);
+    fclose (File);
+    return -1;
+  }
+
+  fclose (File);
+
+  mReader.Buffer = Buffer;
+  mReader.Size   = (size_t) Size;
+  mReader.Offset = 2;
+
+  if ((mReader.Size < 2 + KEY_FILE_HEADER_SIZE) ||
+      (GetValue (Buffer, 2) != UNICODE_FLAG) ||
+      !IsKeyFileSegment (&mReader)) {
+    printf ("Error: %s is not a binary key file\n", Argv[1]);
+    free (Buffer);
+    return -1;
+  }
+
+  //
+  // The default output file is <KeyFile>.txt
+  //
+  if (Argc == 3) {
+    OutputName = Argv[2];
+  } else {
+    OutputName = malloc (strlen (Argv[1]) + 5);
+    if (OutputName == NULL) {
+      printf ("Error: Out of memory\n");
+      free (Buffer);
+      return -1;
+    }
+    sprintf (OutputName, "%s.txt", Argv[1]);
+  }
+
+  File = fopen (OutputName, "wb");
+  if (File == NULL) {
+    printf ("Error: Cannot create %s\n", OutputName);
+    if (Argc != 3) {
+      free (OutputName);
+    }
+    free (Buffer);
+    return -1;
+  }
+
+  //
+  // Export the records, the segment headers and the description records are
+  // handled by the reader
+  //
+  fputc (UNICODE_FLAG & 0xFF, File);
+  fputc (UNICODE_FLAG >> 8, File);
+
+  while (ReadKeyFileRecord (&mReader, &Type, &Record, &RecordSize) == 0) {
+    ExportRecord (File, &mReader, Type, Record, RecordSize);
+  }
+
+  Failed = ferror (File);
+  if (fclose (File) != 0) {
+    Failed = 1;
+  }
+
+  printf ("%s: %s\n", OutputName, Failed ? "Failed to write" : "Done");
+
+  if (Argc != 3) {
+    free (OutputName);
+  }
+  free (Buffer);
+
+  return Failed ? -1 : 0;
+}
+
+//
+// Internal functions implementation
+//
+
+void
+PrintUsage (
+  void
+  )
+{
+  printf ("Usage: ExportKeyFile <KeyFile> [OutputFile]\n");
+  printf ("  KeyFile    - Binary key file (.ekl)\n");
+  printf ("  OutputFile - Text key file (default: <KeyFile>.txt)\n");
+}
+
+unsigned long
+GetValue (
+  const unsigned char *Buffer,
+  size_t              Size
+  )
+{
+  unsigned long       Value;
+
+  //
+  // Little-endian
+  //
+  Value = 0;
+  while (Size > 0) {
+    Size --;
+    Value = (Value << 8) | Buffer[Size];
+  }
+
+  return Value;
+}
+
+int
+IsKeyFileSegment (
+  const KEY_FILE_READER *Reader
+  )
+{
+  if (Reader->Offset + KEY_FILE_HEADER_SIZE > Reader->Size) {
+    return 0;
+  }
+
+  return GetValue (Reader->Buffer + Reader->Offset, 4) == KEY_FILE_SIGNATURE;
+}
+
+int
+ReadKeyFileRecord (
+  KEY_FILE_READER       *Reader,
+  unsigned long         *Type,
+  size_t                *Record,
+  size_t                *RecordSize
+  )
+{
+  const unsigned char   *Data;
+  size_t                Remain;
+  size_t                Size;
+  size_t                Offset;
+  size_t                Description;
+  unsigned long         Id;
+
+  //
+  // Follow ReadKeyFileRecord of the framework (Report\ReportSupport.c)
+  //
+  while (Reader->Offset + KEY_FILE_RECORD_SIZE <= Reader->Size) {
+    Data   = Reader->Buffer + Reader->Offset;
+    Remain = Reader->Size - Reader->Offset;
+
+    if (IsKeyFileSegment (Reader)) {
+      //
+      // A new segment, its description IDs start from 0 again
+      //
+      Size = GetValue (Data + 6, 2);
+      if ((GetValue (Data + 4, 2) == KEY_FILE_VERSION) &&
+          (Size >= KEY_FILE_HEADER_SIZE) &&
+          ((Size & 1) == 0) &&
+          (Size <= Remain)) {
+        Reader->Offset += Size;
+        memset (Reader->Descriptions, 0, sizeof (Reader->Descriptions));
+        continue;
+      }
+    } else {
+      Size = GetValue (Data + 2, 2);
+      if ((Size >= KEY_FILE_RECORD_SIZE) && ((Size & 1) == 0) && (Size <= Remain)) {
+        *Type       = GetValue (Data, 2);
+        *Record     = Reader->Offset;
+        *RecordSize = Size;
+        Reader->Offset += Size;
+
+        if ((*Type == KEY_FILE_RECORD_HEAD) ||
+            (*Type == KEY_FILE_RECORD_ASSERTION) ||
+            (*Type == KEY_FILE_RECORD_TERM)) {
+          return 0;
+        }
+
+        if ((*Type == KEY_FILE_RECORD_DESCRIPTION) && (Size >= KEY_FILE_DESCRIPTION_SIZE)) {
+          Id          = GetValue (Data + KEY_FILE_RECORD_SIZE, 2);
+          Offset      = KEY_FILE_DESCRIPTION_SIZE;
+          Description = GetKeyFileString (Reader, *Record, Size, &Offset);
+          if ((Description != 0) && (Id != KEY_FILE_INLINE_DESCRIPTION)) {
+            Reader->Descriptions[Id] = Description;
+          }
+        }
+        continue;
+      }
+    }
+
+    //
+    // A broken record, skip to the next segment header
+    //
+    fprintf (stderr, "Warning: Broken key file record at 0x%lx\n", (unsigned long) Reader->Offset);
+    do {
+      Reader->Offset += 2;
+    } while ((Reader->Offset + KEY_FILE_HEADER_SIZE <= Reader->Size) &&
+             !IsKeyFileSegment (Reader));
+  }
+
+  return -1;
+}
+
+size_t
+GetKeyFileString (
+  const KEY_FILE_READER *Reader,
+  size_t                Record,
+  size_t                RecordSize,
+  size_t                *Offset
+  )
+{
+  size_t                String;
+  size_t                Index;
+
+  //
+  // Get the buffer offset of the string at Offset of a record, and move
+  // Offset after its terminator. 0 if the string is not terminated in the
+  // record.
+  //
+  String = Record + *Offset;
+  for (Index = *Offset; Index + 2 <= RecordSize; Index += 2) {
+    if ((Reader->Buffer[Record + Index] == 0) && (Reader->Buffer[Record + Index + 1] == 0)) {
+      *Offset = Index + 2;
+      return String;
+    }
+  }
+
+  return 0;
+}
+
+void
+WriteAscii (
+  FILE                  *File,
+  const char            *Format,
+  ...
+  )
+{
+  va_list               Marker;
+  char                  Line[MAX_LINE_LENGTH];
+  size_t                Index;
+
+  va_start (Marker, Format);
+  vsnprintf (Line, sizeof (Line), Format, Marker);
+  va_end (Marker);
+
+  for (Index = 0; Line[Index] != 0; Index ++) {
+    fputc (Line[Index], File);
+    fputc (0, File);
+  }
+}
+
+void
+WriteString (
+  FILE                  *File,
+  const KEY_FILE_READER *Reader,
+  size_t                String
+  )
+{
+  //
+  // The strings are copied as they are, a missing string is written as an
+  // empty one
+  //
+  if (String == 0) {
+    return;
+  }
+
+  while ((Reader->Buffer[String] != 0) || (Reader->Buffer[String + 1] != 0)) {
+    fputc (Reader->Buffer[String], File);
+    fputc (Reader->Buffer[String + 1], File);
+    String += 2;
+  }
+}
+
+void
+WriteGuid (
+  FILE                  *File,
+  const unsigned char   *Guid
+  )
+{
+  size_t                Index;
+
+  //
+  // As "%g" of SctSPrint. The only known GUID which could be in a key file
+  // is the null GUID.
+  //
+  for (Index = 0; Index < 16; Index ++) {
+    if (Guid[Index] != 0) {
+      break;
+    }
+  }
+
+  if (Index == 16) {
+    WriteAscii (File, "G0");
+    return;
+  }
+
+  WriteAscii (
+    File,
+    "%08lx-%04lx-%04lx-%02x%02x-%02x%02x%02x%02x%02x%02x",
+    GetValue (Guid, 4),
+    GetValue (Guid + 4, 2),
+    GetValue (Guid + 6, 2),
+    Guid[8], Guid[9], Guid[10], Guid[11],
+    Guid[12], Guid[13], Guid[14], Guid[15]
+    );
+}
+
+void
+WriteTime (
+  FILE                  *File,
+  const unsigned char   *Time
+  )
+{
+  //
+  // "DD-MM-YYYY|HH:MM:SS" from an EFI_KEY_FILE_TIME
+  //
+  WriteAscii (
+    File,
+    "%02d-%02d-%04d|%02d:%02d:%02d",
+    Time[3],
+    Time[2],
+    (int) GetValue (Time, 2),
+    Time[4],
+    Time[5],
+    Time[6]
+    );
+}
+
+void
+ExportRecord (
+  FILE                  *File,
+  const KEY_FILE_READER *Reader,
+  unsigned long         Type,
+  size_t                Record,
+  size_t                RecordSize
+  )
+{
+  const unsigned char   *Data;
+  size_t                Offset;
+  size_t                Description;
+  unsigned long         Result;
+  unsigned long         Elapsed;
+  int                   Index;
+
+  Data = Reader->Buffer + Record;
+
+  switch (Type) {
+  case KEY_FILE_RECORD_HEAD:
+    //
+    // "|HEAD|||Config|Scenario|Date|Time|EntryId|Revision|EntryName|TestName|Category|DevicePath"
+    //
+    if (RecordSize < KEY_FILE_HEAD_SIZE) {
+      return;
+    }
+
+    WriteAscii (File, "|HEAD|||%lu|", GetValue (Data + 4, 4));
+    Offset = KEY_FILE_HEAD_SIZE;
+    WriteString (File, Reader, GetKeyFileString (Reader, Record, RecordSize, &Offset));
+    WriteAscii (File, "|");
+    WriteTime (File, Data + 32);
+    WriteAscii (File, "|");
+    WriteGuid (File, Data + 8);
+    if (GetValue (Data + 28, 4) != 0) {
+      WriteAscii (File, "|0x%lx%08lx", GetValue (Data + 28, 4), GetValue (Data + 24, 4));
+    } else {
+      WriteAscii (File, "|0x%08lx", GetValue (Data + 24, 4));
+    }
+    for (Index = 0; Index < 4; Index ++) {
+      WriteAscii (File, "|");
+      WriteString (File, Reader, GetKeyFileString (Reader, Record, RecordSize, &Offset));
+    }
+    WriteAscii (File, "\n");
+    break;
+
+  case KEY_FILE_RECORD_ASSERTION:
+    //
+    // "EventId:Result|Description:Detail", the detail ends with a line break
+    // added by RecordAssertion
+    //
+    if (RecordSize < KEY_FILE_ASSERTION_SIZE) {
+      return;
+    }
+
+    Result = Data[4];
+    WriteGuid (File, Data + 8);
+    WriteAscii (
+      File,
+      ":%s|",
+      (Result == TEST_ASSERTION_PASSED) ? "PASS" :
+      (Result == TEST_ASSERTION_WARNING) ? "WARNING" : "FAILURE"
+      );
+
+    Offset = KEY_FILE_ASSERTION_SIZE;
+    if (GetValue (Data + 6, 2) == KEY_FILE_INLINE_DESCRIPTION) {
+      Description = GetKeyFileString (Reader, Record, RecordSize, &Offset);
+    } else {
+      Description = Reader->Descriptions[GetValue (Data + 6, 2)];
+    }
+
+    WriteString (File, Reader, Description);
+    WriteAscii (File, ":");
+    WriteString (File, Reader, GetKeyFileString (Reader, Record, RecordSize, &Offset));
+    WriteAscii (File, "\r\n\r\n");
+    break;
+
+  case KEY_FILE_RECORD_TERM:
+    //
+    // "|TERM|Status|Date|Time|Days HH:MM:SS"
+    //
+    if (RecordSize < KEY_FILE_TERM_SIZE) {
+      return;
+    }
+
+    Elapsed = GetValue (Data + 14, 4);
+    WriteAscii (File, "|TERM|%04lx|", GetValue (Data + 4, 2));
+    WriteTime (File, Data + 6);
+    WriteAscii (
+      File,
+      "|%lu %02lu:%02lu:%02lu\n",
+      Elapsed / 86400,
+      (Elapsed / 3600) % 24,
+      (Elapsed / 60) % 60,
+      Elapsed % 60
+      );
+    break;
+
+  default:
+    break;
+  }
+}
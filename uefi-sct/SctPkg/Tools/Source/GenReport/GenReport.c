@@ -0,0 +1,3173 @@
+/** @file
+
+  Copyright 2006 - 2017 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2019 Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+/*++
+
+
+Module Name:
+
+  GenReport.c
+
+Abstract:
+
+  Generate the SCT test report on the host from the key files collected from
+  one or more test machines. The output is the same CSV as the report which
+  is generated on the target by GenerateReport. The key files are parsed by a
+  pool of threads, one machine is merged into its report once all its files
+  are parsed.
+
+  The parsing follows the framework (Report\ReportDatabase.c) step by step,
+  including the field length limits of the report, so the two reports could
+  be compared byte by byte. Both the text and the binary key files (see
+  Drivers\Include\KeyFile.h) are supported.
+
+--*/
+
+//
+// Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//
+// Definitions
+//
+
+#ifdef _WIN32
+#define PATH_SEPARATOR              "\\"
+#else
+#define PATH_SEPARATOR              "/"
+#endif
+
+#define MAX_THREAD_NUMBER           64
+
+#define LOG_DIRECTORY               "Log"
+#define CONFIG_FILE                 "Sct.cfg"
+#define GUID_DATABASE_FILE          "Data" PATH_SEPARATOR "GuidFile.txt"
+#define REPORT_FILE                 "Report.csv"
+
+//
+// The limits of the report on the target (Report\ReportSupport.h)
+//
+#define REPORT_LINE_LEN             2048
+#define GUID_LEN                    60
+#define TITLE_LEN                   300
+#define INDEX_LEN                   20
+#define CASE_INDEX_LEN              20
+#define CASE_ITERATION_LEN          20
+#define CASE_REVISION_LEN           20
+#define CASE_GUID_LEN               60
+#define RUNTIME_INFOR_LEN           600
+#define DEVICE_PATH_LEN             300
+#define NAME_LEN                    256
+#define SLOWEST_CASE_NUM            20
+#define PROFILE_FIELD_NUM           9
+#define PROFILE_CLOCK_LEN           16
+
+#define ASSERTION_TYPE_PASS         0x01
+#define ASSERTION_TYPE_WARN         0x03
+#define ASSERTION_TYPE_FAIL         0x07
+
+#define UNICODE_FLAG                0xFEFF
+
+//
+// The binary key file, a copy of Drivers\Include\KeyFile.h
+//
+#define KEY_FILE_SIGNATURE          0x59454B53
+#define KEY_FILE_VERSION            0x0001
+
+#define KEY_FILE_RECORD_HEAD        0x0001
+#define KEY_FILE_RECORD_DESCRIPTION 0x0002
+#define KEY_FILE_RECORD_ASSERTION   0x0003
+#define KEY_FILE_RECORD_TERM        0x0004
+
+#define KEY_FILE_INLINE_DESCRIPTION 0xFFFF
+
+#define KEY_FILE_HEADER_SIZE        8
+#define KEY_FILE_RECORD_SIZE        4
+#define KEY_FILE_HEAD_SIZE          40
+#define KEY_FILE_DESCRIPTION_SIZE   6
+#define KEY_FILE_ASSERTION_SIZE     28
+
+#define KEY_FILE_HEAD_ENTRY_ID      8
+#define KEY_FILE_HEAD_REVISION      24
+#define KEY_FILE_ASSERTION_RESULT   4
+#define KEY_FILE_ASSERTION_DESC_ID  6
+#define KEY_FILE_ASSERTION_EVENT_ID 8
+
+#define TEST_ASSERTION_PASSED       0
+#define TEST_ASSERTION_FAILED       2
+
+//
+// The fields of an assertion, in the layout of EFI_SCT_ASSERTION_INFOR. A
+// field that fills its buffer is not terminated on the target, so it runs
+// into the next one when it is printed.
+//
+#define FIELD_INDEX                 0
+#define FIELD_CASE_INDEX            1
+#define FIELD_CASE_ITERATION        2
+#define FIELD_CASE_REVISION         3
+#define FIELD_CASE_GUID             4
+#define FIELD_GUID                  5
+#define FIELD_TITLE                 6
+#define FIELD_RUNTIME_INFOR         7
+#define FIELD_DEVICE_PATH           8
+#define FIELD_FILE_NAME             9
+#define FIELD_NUMBER                10
+
+//
+// Types
+//
+
+typedef unsigned short      UCS2;
+typedef unsigned long long  UINT64_T;
+
+#ifdef _WIN32
+typedef HANDLE              THREAD;
+typedef CRITICAL_SECTION    LOCK;
+typedef CONDITION_VARIABLE  CONDITION;
+#else
+typedef pthread_t           THREAD;
+typedef pthread_mutex_t     LOCK;
+typedef pthread_cond_t      CONDITION;
+#endif
+
+typedef struct {
+  UCS2                *Line;
+  UCS2                *Field;
+} TOKEN_STATE;
+
+//
+// A reader on a binary key file. The offsets are in bytes, the records and
+// the strings are always aligned on a UCS-2 char.
+//
+typedef struct {
+  UCS2                *Buffer;
+  size_t              Size;
+  size_t              Offset;
+  UCS2                **Descriptions;
+  size_t              DescriptionMax;
+} KEY_FILE_READER;
+
+typedef struct {
+  unsigned char       Bytes[16];
+} GUID_KEY;
+
+//
+// Open-addressing hash table from a GUID to an entry index plus 1
+//
+typedef struct {
+  GUID_KEY            Guid;
+  size_t              Entry;
+} GUID_SLOT;
+
+typedef struct {
+  GUID_SLOT           *Slots;
+  size_t              SlotCount;
+  size_t              UsedCount;
+} GUID_INDEX;
+
+typedef struct {
+  const UCS2          *Title;
+  const UCS2          *Index;
+} GUID_ENTRY;
+
+typedef struct {
+  UCS2                *Buffer;
+  GUID_ENTRY          *Entries;
+  size_t              Count;
+  size_t              MaxCount;
+  GUID_INDEX          Index;
+} GUID_DATABASE;
+
+//
+// An assertion line of a key file, with the head fields in effect
+//
+typedef struct {
+  const UCS2          *Guid;
+  int                 ValidGuid;
+  GUID_KEY            GuidKey;
+  int                 Type;
+  const UCS2          *Title;
+  const UCS2          *RuntimeInfor;
+  const UCS2          *TestName;
+  const UCS2          *TestCategory;
+  const UCS2          *DevicePath;
+  const UCS2          *CaseRevision;
+  const UCS2          *CaseGuid;
+  UCS2                *OwnedRuntimeInfor;
+} LOG_ASSERTION;
+
+typedef struct {
+  UINT64_T            Microseconds;
+  UCS2                Clock[PROFILE_CLOCK_LEN];
+  UINT64_T            Assertions;
+  UINT64_T            BytesWritten;
+  UINT64_T            FreePagesBefore;
+  UINT64_T            FreePagesAfter;
+  UCS2                CaseGuid[CASE_GUID_LEN];
+  UCS2                CaseName[NAME_LEN];
+  UCS2                FileName[NAME_LEN];
+} PROFILE_INFOR;
+
+#define LOG_FILE_KEY        0
+#define LOG_FILE_PROFILE    1
+
+typedef struct {
+  char                *Path;
+  int                 Kind;
+  UCS2                CaseIndex[CASE_INDEX_LEN];
+  UCS2                CaseIteration[CASE_ITERATION_LEN];
+  UCS2                LogName[NAME_LEN + 4];
+  UCS2                *Buffer;
+  size_t              Size;
+
+  //
+  // The strings formatted from a binary key file
+  //
+  UCS2                **Strings;
+  size_t              StringCount;
+  size_t              StringMax;
+
+  //
+  // Loaded is set when the file reached LoadReportInfor. Failed is set when
+  // LoadReportInfor stopped with an error, the GUID assertions of the file
+  // are then not cleared on the target.
+  //
+  int                 Loaded;
+  int                 Failed;
+  LOG_ASSERTION       *Assertions;
+  size_t              AssertionCount;
+  size_t              AssertionMax;
+
+  int                 HasProfile;
+  PROFILE_INFOR       Profile;
+} LOG_FILE;
+
+typedef struct {
+  char                *SctDir;
+  char                *ReportName;
+  LOG_FILE            *Files;
+  size_t              FileCount;
+  size_t              FileMax;
+  size_t              Pending;
+  int                 Result;
+} MACHINE;
+
+//
+// The report information, in the order of the target
+//
+typedef struct {
+  const UCS2          *Field[FIELD_NUMBER];
+  int                 Removed;
+} ASSERTION_INFOR;
+
+typedef struct {
+  const UCS2          *TestName;
+  const UCS2          *TestCategory;
+  unsigned long       PassNumber;
+  unsigned long       FailNumber;
+  size_t              *Pass;
+  size_t              PassCount;
+  size_t              PassMax;
+  size_t              *Fail;
+  size_t              FailCount;
+  size_t              FailMax;
+} REPORT_ITEM;
+
+typedef struct {
+  int                 AssertionType;
+  size_t              Item;
+  size_t              Infor;
+} GUID_ASSERTION;
+
+typedef struct {
+  const GUID_DATABASE *Database;
+
+  REPORT_ITEM         *Items;
+  size_t              ItemCount;
+  size_t              ItemMax;
+  size_t              LastItem;
+  unsigned long       TotalPass;
+  unsigned long       TotalFail;
+
+  ASSERTION_INFOR     *Infors;
+  size_t              InforCount;
+  size_t              InforMax;
+
+  GUID_ASSERTION      *GuidAssertions;
+  size_t              GuidAssertionCount;
+  size_t              GuidAssertionMax;
+  GUID_INDEX          GuidAssertionIndex;
+
+  PROFILE_INFOR       Profiles[SLOWEST_CASE_NUM];
+  size_t              ProfileCount;
+} REPORT_INFOR;
+
+typedef struct {
+  UCS2                *Buffer;
+  size_t              Length;
+  size_t              Max;
+} LINE_BUFFER;
+
+#define JOB_PARSE_FILE      0
+#define JOB_MERGE_MACHINE   1
+
+typedef struct _JOB JOB;
+
+struct _JOB {
+  JOB                 *Next;
+  int                 Kind;
+  MACHINE             *Machine;
+  size_t              FileIndex;
+};
+
+typedef struct {
+  LOCK                Lock;
+  CONDITION           JobReady;
+  CONDITION           MachineDone;
+  JOB                 *Head;
+  JOB                 *Tail;
+  int                 Stop;
+  size_t              MachinesInFlight;
+} JOB_POOL;
+
+//
+// Modular variables
+//
+
+static const UCS2 mLineSet[]    = { '\n', '\r', 0 };
+static const UCS2 mNewLineSet[] = { '\n', 0 };
+static const UCS2 mBarSet[]     = { '|', 0 };
+static const UCS2 mColonSet[]   = { ':', 0 };
+static const UCS2 mEmpty[]      = { 0 };
+
+static const size_t mFieldLength[FIELD_NUMBER] = {
+  INDEX_LEN,
+  CASE_INDEX_LEN,
+  CASE_ITERATION_LEN,
+  CASE_REVISION_LEN,
+  CASE_GUID_LEN,
+  GUID_LEN,
+  TITLE_LEN,
+  RUNTIME_INFOR_LEN,
+  DEVICE_PATH_LEN,
+  NAME_LEN
+};
+
+//
+// The generic failure GUID is compared as a string, the system hang GUID as
+// a string and as a GUID, like on the target
+//
+static const char mGenericGuidStr[]    = "6A8CAA83-B9DA-46C7-98F6-D4969DABDAA0";
+static const char mSystemHangGuidStr[] = "DE687A18-0BBD-4396-8509-498FF23234F1";
+static GUID_KEY   mGenericGuid;
+static GUID_KEY   mSystemHangGuid;
+
+static const UCS2 *mSystemHangTitle;
+
+static GUID_DATABASE  mSharedDatabase;
+static int            mUseSharedDatabase = 0;
+static char           *mOutputDir        = NULL;
+static JOB_POOL       mPool;
+
+//
+// Internal functions declaration
+//
+
+void
+PrintUsage (
+  void
+  );
+
+int
+AddMachine (
+  MACHINE       **Machines,
+  size_t        *MachineCount,
+  size_t        *MachineMax,
+  const char    *SctDir
+  );
+
+int
+CollectLogFiles (
+  MACHINE       *Machine,
+  const char    *DirPath
+  );
+
+void
+ParseLogFile (
+  LOG_FILE      *File
+  );
+
+int
+MergeMachine (
+  MACHINE       *Machine
+  );
+
+//
+// Portable helpers
+//
+
+static void
+LockInit (
+  LOCK          *Lock
+  )
+{
+#ifdef _WIN32
+  InitializeCriticalSection (Lock);
+#else
+  pthread_mutex_init (Lock, NULL);
+#endif
+}
+
+static void
+LockAcquire (
+  LOCK          *Lock
+  )
+{
+#ifdef _WIN32
+  EnterCriticalSection (Lock);
+#else
+  pthread_mutex_lock (Lock);
+#endif
+}
+
+static void
+LockRelease (
+  LOCK          *Lock
+  )
+{
+#ifdef _WIN32
+  LeaveCriticalSection (Lock);
+#else
+  pthread_mutex_unlock (Lock);
+#endif
+}
+
+static void
+ConditionInit (
+  CONDITION     *Condition
+  )
+{
+#ifdef _WIN32
+  InitializeConditionVariable (Condition);
+#else
+  pthread_cond_init (Condition, NULL);
+#endif
+}
+
+static void
+ConditionWait (
+  CONDITION     *Condition,
+  LOCK          *Lock
+  )
+{
+#ifdef _WIN32
+  SleepConditionVariableCS (Condition, Lock, INFINITE);
+#else
+  pthread_cond_wait (Condition, Lock);
+#endif
+}
+
+static void
+ConditionBroadcast (
+  CONDITION     *Condition
+  )
+{
+#ifdef _WIN32
+  WakeAllConditionVariable (Condition);
+#else
+  pthread_cond_broadcast (Condition);
+#endif
+}
+
+static unsigned int
+GetProcessorNumber (
+  void
+  )
+{
+#ifdef _WIN32
+  SYSTEM_INFO   SystemInfo;
+
+  GetSystemInfo (&SystemInfo);
+  return (unsigned int) SystemInfo.dwNumberOfProcessors;
+#else
+  long          Number;
+
+  Number = sysconf (_SC_NPROCESSORS_ONLN);
+  return (Number > 0) ? (unsigned int) Number : 1;
+#endif
+}
+
+static void *
+GrowArray (
+  void          *Array,
+  size_t        *Max,
+  size_t        Count,
+  size_t        ElementSize
+  )
+{
+  size_t        NewMax;
+  void          *NewArray;
+
+  if (Count < *Max) {
+    return Array;
+  }
+
+  NewMax   = (*Max == 0) ? 16 : *Max * 2;
+  NewArray = realloc (Array, NewMax * ElementSize);
+  if (NewArray == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  *Max = NewMax;
+  return NewArray;
+}
+
+static char *
+DuplicateString (
+  const char    *String
+  )
+{
+  char          *Copy;
+
+  Copy = malloc (strlen (String) + 1);
+  if (Copy == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  strcpy (Copy, String);
+  return Copy;
+}
+
+static char *
+JoinPath (
+  const char    *Path,
+  const char    *Name
+  )
+{
+  char          *FullPath;
+
+  FullPath = malloc (strlen (Path) + strlen (Name) + 2);
+  if (FullPath == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  sprintf (FullPath, "%s%s%s", Path, PATH_SEPARATOR, Name);
+  return FullPath;
+}
+
+static int
+CompareNameNoCase (
+  const void    *Name1,
+  const void    *Name2
+  )
+{
+  const unsigned char   *String1;
+  const unsigned char   *String2;
+  int                   Char1;
+  int                   Char2;
+
+  String1 = *(const unsigned char **) Name1;
+  String2 = *(const unsigned char **) Name2;
+
+  do {
+    Char1 = *String1++;
+    Char2 = *String2++;
+    if ((Char1 >= 'A') && (Char1 <= 'Z')) {
+      Char1 += 'a' - 'A';
+    }
+    if ((Char2 >= 'A') && (Char2 <= 'Z')) {
+      Char2 += 'a' - 'A';
+    }
+  } while ((Char1 == Char2) && (Char1 != 0));
+
+  return Char1 - Char2;
+}
+
+static int
+EndWithNoCase (
+  const char    *String,
+  const char    *SubString
+  )
+{
+  size_t        Length;
+  size_t        SubLength;
+  const char    *Tail;
+
+  Length    = strlen (String);
+  SubLength = strlen (SubString);
+  if (Length < SubLength) {
+    return 0;
+  }
+
+  Tail = String + Length - SubLength;
+  return CompareNameNoCase (&Tail, &SubString) == 0;
+}
+
+//
+// Read a whole file through a memory mapping. Returns -1 if the file could
+// not be opened, *Data is NULL for an empty file.
+//
+static int
+MapFile (
+  const char    *Path,
+  void          **Data,
+  size_t        *Size,
+  void          **Mapping
+  )
+{
+#ifdef _WIN32
+  HANDLE          File;
+  HANDLE          MapHandle;
+  LARGE_INTEGER   FileSize;
+
+  *Data    = NULL;
+  *Size    = 0;
+  *Mapping = NULL;
+
+  File = CreateFileA (Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (File == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+
+  if (!GetFileSizeEx (File, &FileSize)) {
+    CloseHandle (File);
+    return -1;
+  }
+
+  if (FileSize.QuadPart == 0) {
+    CloseHandle (File);
+    return 0;
+  }
+
+  MapHandle = CreateFileMappingA (File, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle (File);
+  if (MapHandle == NULL) {
+    return -1;
+  }
+
+  *Data = MapViewOfFile (MapHandle, FILE_MAP_READ, 0, 0, 0);
+  if (*Data == NULL) {
+    CloseHandle (MapHandle);
+    return -1;
+  }
+
+  *Size    = (size_t) FileSize.QuadPart;
+  *Mapping = MapHandle;
+  return 0;
+#else
+  int             File;
+  struct stat     FileStat;
+
+  *Data    = NULL;
+  *Size    = 0;
+  *Mapping = NULL;
+
+  File = open (Path, O_RDONLY);
+  if (File < 0) {
+    return -1;
+  }
+
+  if (fstat (File, &FileStat) != 0) {
+    close (File);
+    return -1;
+  }
+
+  if (FileStat.st_size == 0) {
+    close (File);
+    return 0;
+  }
+
+  *Data = mmap (NULL, (size_t) FileStat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+  close (File);
+  if (*Data == MAP_FAILED) {
+    *Data = NULL;
+    return -1;
+  }
+
+  *Size = (size_t) FileStat.st_size;
+  return 0;
+#endif
+}
+
+static void
+UnmapFile (
+  void          *Data,
+  size_t        Size,
+  void          *Mapping
+  )
+{
+  if (Data == NULL) {
+    return;
+  }
+
+#ifdef _WIN32
+  (void) Size;
+  UnmapViewOfFile (Data);
+  CloseHandle ((HANDLE) Mapping);
+#else
+  (void) Mapping;
+  munmap (Data, Size);
+#endif
+}
+
+//
+// Read a Unicode file to a terminated buffer, like ReadFileToBuffer. The
+// buffer has one more null char than the file. FileSize is the size of the
+// file in bytes.
+//
+static UCS2 *
+ReadUnicodeFile (
+  const char    *Path,
+  size_t        *FileSize
+  )
+{
+  void                  *Data;
+  void                  *Mapping;
+  size_t                Size;
+  size_t                Length;
+  size_t                Index;
+  const unsigned char   *Bytes;
+  UCS2                  *Buffer;
+
+  if (MapFile (Path, &Data, &Size, &Mapping) != 0) {
+    return NULL;
+  }
+
+  Length = (Size + 1) / 2;
+  Buffer = malloc ((Length + 1) * sizeof (UCS2));
+  if (Buffer == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  Bytes = Data;
+  for (Index = 0; Index < Size / 2; Index ++) {
+    Buffer[Index] = (UCS2) (Bytes[Index * 2] | (Bytes[Index * 2 + 1] << 8));
+  }
+  if ((Size & 1) != 0) {
+    Buffer[Index] = Bytes[Size - 1];
+  }
+  Buffer[Length] = 0;
+
+  UnmapFile (Data, Size, Mapping);
+  *FileSize = Size;
+  return Buffer;
+}
+
+//
+// UCS-2 string helpers
+//
+
+static size_t
+Ucs2Len (
+  const UCS2    *String
+  )
+{
+  size_t        Length;
+
+  for (Length = 0; String[Length] != 0; Length ++) {
+    ;
+  }
+
+  return Length;
+}
+
+static int
+Ucs2Cmp (
+  const UCS2    *String1,
+  const UCS2    *String2
+  )
+{
+  while ((*String1 != 0) && (*String1 == *String2)) {
+    String1 ++;
+    String2 ++;
+  }
+
+  return (int) *String1 - (int) *String2;
+}
+
+static int
+Ucs2CmpAscii (
+  const UCS2    *String1,
+  const char    *String2
+  )
+{
+  while ((*String1 != 0) && (*String1 == (unsigned char) *String2)) {
+    String1 ++;
+    String2 ++;
+  }
+
+  return (int) *String1 - (int) (unsigned char) *String2;
+}
+
+static UCS2 *
+Ucs2FromAscii (
+  const char    *String
+  )
+{
+  size_t        Length;
+  size_t        Index;
+  UCS2          *Result;
+
+  Length = strlen (String);
+  Result = malloc ((Length + 1) * sizeof (UCS2));
+  if (Result == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  for (Index = 0; Index <= Length; Index ++) {
+    Result[Index] = (unsigned char) String[Index];
+  }
+
+  return Result;
+}
+
+static void
+Ucs2CopyN (
+  UCS2          *Destination,
+  const UCS2    *Source,
+  size_t        Length
+  )
+{
+  //
+  // SctStrnCpy: the rest of the destination is zeroed
+  //
+  while ((*Source != 0) && (Length > 0)) {
+    *Destination++ = *Source++;
+    Length --;
+  }
+
+  while (Length > 0) {
+    *Destination++ = 0;
+    Length --;
+  }
+}
+
+//
+// The tokenizers of the report (StrTokenLine and StrTokenField). They
+// terminate the tokens in place.
+//
+
+static int
+IsInSet (
+  UCS2          Char,
+  const UCS2    *CharSet
+  )
+{
+  for (; *CharSet != 0; CharSet ++) {
+    if (Char == *CharSet) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static UCS2 *
+Ucs2Brk (
+  UCS2          *String,
+  const UCS2    *CharSet
+  )
+{
+  for (; *String != 0; String ++) {
+    if (IsInSet (*String, CharSet)) {
+      return String;
+    }
+  }
+
+  return NULL;
+}
+
+static UCS2 *
+TokenLine (
+  TOKEN_STATE   *State,
+  UCS2          *String,
+  const UCS2    *CharSet
+  )
+{
+  UCS2          *Begin;
+  UCS2          *End;
+
+  Begin = (String == NULL) ? State->Line : String;
+  if (Begin == NULL) {
+    return NULL;
+  }
+
+  while ((*Begin != 0) && IsInSet (*Begin, CharSet)) {
+    Begin ++;
+  }
+
+  if (*Begin == 0) {
+    State->Line = NULL;
+    return NULL;
+  }
+
+  End = Ucs2Brk (Begin, CharSet);
+  if ((End != NULL) && (*End != 0)) {
+    *End = 0;
+    End ++;
+  }
+
+  State->Line = End;
+  return Begin;
+}
+
+static UCS2 *
+TokenField (
+  TOKEN_STATE   *State,
+  UCS2          *String,
+  const UCS2    *CharSet
+  )
+{
+  UCS2          *Begin;
+  UCS2          *End;
+
+  Begin = (String == NULL) ? State->Field : String;
+  if (Begin == NULL) {
+    return NULL;
+  }
+
+  if (*Begin == 0) {
+    State->Field = NULL;
+    return NULL;
+  }
+
+  End = Ucs2Brk (Begin, CharSet);
+  if ((End != NULL) && (*End != 0)) {
+    *End = 0;
+    End ++;
+  }
+
+  State->Field = End;
+  return Begin;
+}
+
+//
+// GUID helpers
+//
+
+static int
+HexValue (
+  UCS2          Char
+  )
+{
+  if ((Char >= '0') && (Char <= '9')) {
+    return Char - '0';
+  }
+  if ((Char >= 'a') && (Char <= 'f')) {
+    return Char - 'a' + 10;
+  }
+  if ((Char >= 'A') && (Char <= 'F')) {
+    return Char - 'A' + 10;
+  }
+  return -1;
+}
+
+static int
+ParseGuid (
+  const UCS2    *String,
+  GUID_KEY      *Guid
+  )
+{
+  size_t        Index;
+  size_t        Byte;
+  int           Value;
+
+  //
+  // ConvertStrToGuid: "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX" only. The bytes
+  // are kept in the text order, it is only used to compare the GUIDs.
+  //
+  memset (Guid, 0, sizeof (GUID_KEY));
+  Byte = 0;
+  for (Index = 0; Index < 36; Index ++) {
+    if ((Index == 8) || (Index == 13) || (Index == 18) || (Index == 23)) {
+      if (String[Index] != '-') {
+        return 0;
+      }
+      continue;
+    }
+
+    Value = HexValue (String[Index]);
+    if (Value < 0) {
+      return 0;
+    }
+
+    Guid->Bytes[Byte / 2] = (unsigned char) ((Guid->Bytes[Byte / 2] << 4) | Value);
+    Byte ++;
+  }
+
+  return String[Index] == 0;
+}
+
+static size_t
+HashGuid (
+  const GUID_KEY  *Guid
+  )
+{
+  size_t          Hash;
+  size_t          Index;
+
+  Hash = 0;
+  for (Index = 0; Index < sizeof (GUID_KEY); Index ++) {
+    Hash = (Hash * 31) + Guid->Bytes[Index];
+  }
+
+  return Hash;
+}
+
+static GUID_SLOT *
+FindGuidSlot (
+  const GUID_INDEX  *GuidIndex,
+  const GUID_KEY    *Guid
+  )
+{
+  size_t          Mask;
+  size_t          Hash;
+  size_t          Count;
+  GUID_SLOT       *Slot;
+
+  if (GuidIndex->SlotCount == 0) {
+    return NULL;
+  }
+
+  Mask = GuidIndex->SlotCount - 1;
+  Hash = HashGuid (Guid) & Mask;
+
+  for (Count = 0; Count < GuidIndex->SlotCount; Count ++) {
+    Slot = &GuidIndex->Slots[(Hash + Count) & Mask];
+    if ((Slot->Entry == 0) || (memcmp (&Slot->Guid, Guid, sizeof (GUID_KEY)) == 0)) {
+      return Slot;
+    }
+  }
+
+  return NULL;
+}
+
+static void
+InsertGuidIndex (
+  GUID_INDEX      *GuidIndex,
+  const GUID_KEY  *Guid,
+  size_t          Entry
+  )
+{
+  GUID_INDEX      NewIndex;
+  GUID_SLOT       *Slot;
+  size_t          Index;
+
+  //
+  // Keep the load factor under 3/4
+  //
+  if ((GuidIndex->UsedCount + 1) * 4 > GuidIndex->SlotCount * 3) {
+    NewIndex.SlotCount = (GuidIndex->SlotCount == 0) ? 1024 : GuidIndex->SlotCount * 2;
+    NewIndex.UsedCount = 0;
+    NewIndex.Slots     = calloc (NewIndex.SlotCount, sizeof (GUID_SLOT));
+    if (NewIndex.Slots == NULL) {
+      printf ("Error: Out of memory\n");
+      exit (-1);
+    }
+
+    for (Index = 0; Index < GuidIndex->SlotCount; Index ++) {
+      if (GuidIndex->Slots[Index].Entry != 0) {
+        Slot = FindGuidSlot (&NewIndex, &GuidIndex->Slots[Index].Guid);
+        *Slot = GuidIndex->Slots[Index];
+        NewIndex.UsedCount ++;
+      }
+    }
+
+    free (GuidIndex->Slots);
+    *GuidIndex = NewIndex;
+  }
+
+  Slot = FindGuidSlot (GuidIndex, Guid);
+  if (Slot->Entry == 0) {
+    GuidIndex->UsedCount ++;
+  }
+
+  Slot->Guid  = *Guid;
+  Slot->Entry = Entry;
+}
+
+static void
+ClearGuidIndex (
+  GUID_INDEX      *GuidIndex
+  )
+{
+  if (GuidIndex->UsedCount != 0) {
+    memset (GuidIndex->Slots, 0, GuidIndex->SlotCount * sizeof (GUID_SLOT));
+    GuidIndex->UsedCount = 0;
+  }
+}
+
+//
+// GUID database
+//
+
+static int
+LoadGuidDatabase (
+  const char      *Path,
+  GUID_DATABASE   *Database
+  )
+{
+  TOKEN_STATE     State;
+  UCS2            *LineBuffer;
+  UCS2            *GuidStr;
+  UCS2            *TitleStr;
+  UCS2            *IndexStr;
+  GUID_KEY        Guid;
+  GUID_SLOT       *Slot;
+  size_t          Size;
+
+  memset (Database, 0, sizeof (GUID_DATABASE));
+
+  Database->Buffer = ReadUnicodeFile (Path, &Size);
+  if (Database->Buffer == NULL) {
+    printf ("Error: Cannot read %s\n", Path);
+    return -1;
+  }
+
+  if (Database->Buffer[0] != UNICODE_FLAG) {
+    printf ("Warning: Unsupported GUID database file %s\n", Path);
+    return 0;
+  }
+
+  //
+  // "GUID / Title / Index" line triples, the first entry of a GUID is used
+  //
+  LineBuffer = TokenLine (&State, Database->Buffer + 1, mLineSet);
+  while (LineBuffer != NULL) {
+    if (LineBuffer[0] == '#') {
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    GuidStr  = LineBuffer;
+    TitleStr = TokenLine (&State, NULL, mLineSet);
+    if (TitleStr == NULL) {
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    IndexStr = TokenLine (&State, NULL, mLineSet);
+    if (IndexStr == NULL) {
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    if (ParseGuid (GuidStr, &Guid)) {
+      Slot = FindGuidSlot (&Database->Index, &Guid);
+      if ((Slot == NULL) || (Slot->Entry == 0)) {
+        Database->Entries = GrowArray (Database->Entries, &Database->MaxCount, Database->Count, sizeof (GUID_ENTRY));
+        Database->Entries[Database->Count].Title = TitleStr;
+        Database->Entries[Database->Count].Index = IndexStr;
+        Database->Count ++;
+        InsertGuidIndex (&Database->Index, &Guid, Database->Count);
+      }
+    }
+
+    LineBuffer = TokenLine (&State, NULL, mLineSet);
+  }
+
+  return 0;
+}
+
+static void
+FreeGuidDatabase (
+  GUID_DATABASE   *Database
+  )
+{
+  free (Database->Buffer);
+  free (Database->Entries);
+  free (Database->Index.Slots);
+  memset (Database, 0, sizeof (GUID_DATABASE));
+}
+
+static const GUID_ENTRY *
+SearchGuidDatabase (
+  const GUID_DATABASE   *Database,
+  const GUID_KEY        *Guid
+  )
+{
+  GUID_SLOT             *Slot;
+
+  Slot = FindGuidSlot (&Database->Index, Guid);
+  if ((Slot == NULL) || (Slot->Entry == 0)) {
+    return NULL;
+  }
+
+  return &Database->Entries[Slot->Entry - 1];
+}
+
+//
+// Log file parsing, runs on the worker threads
+//
+
+static int
+GetIndexFromFileName (
+  const char    *Name,
+  LOG_FILE      *File
+  )
+{
+  UCS2          FileName[NAME_LEN * 4];
+  UCS2          *String;
+  UCS2          *CaseIndex;
+  UCS2          *CaseIteration;
+  size_t        Length;
+  size_t        Index;
+
+  Length = strlen (Name);
+  if (Length >= sizeof (FileName) / sizeof (UCS2)) {
+    return -1;
+  }
+  for (Index = 0; Index <= Length; Index ++) {
+    FileName[Index] = (unsigned char) Name[Index];
+  }
+
+  //
+  // "Name_<Index>_<Iteration>_<GUID>.ekl", both numbers are shorter than 20
+  //
+  if (Length <= strlen ("XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX.ekl")) {
+    return -1;
+  }
+
+  String = FileName + Length - strlen ("XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX.ekl");
+  String --;
+  if (*String != '_') {
+    return -1;
+  }
+  *String = 0;
+
+  CaseIteration = NULL;
+  for (Index = 0; Index < 20; Index ++) {
+    String --;
+    if (*String == '_') {
+      CaseIteration = String + 1;
+      *String = 0;
+      break;
+    }
+  }
+  if ((Index == 0) || (Index == 20)) {
+    return -1;
+  }
+
+  CaseIndex = NULL;
+  for (Index = 0; Index < 20; Index ++) {
+    if (String == FileName) {
+      return -1;
+    }
+    String --;
+    if (*String == '_') {
+      CaseIndex = String + 1;
+      *String = 0;
+      break;
+    }
+  }
+  if ((Index == 0) || (Index == 20)) {
+    return -1;
+  }
+
+  Ucs2CopyN (File->CaseIndex, CaseIndex, CASE_INDEX_LEN);
+  Ucs2CopyN (File->CaseIteration, CaseIteration, CASE_ITERATION_LEN);
+
+  //
+  // The log file has the same name with the ".log" extension
+  //
+  for (Index = 0; Index < Length - 3; Index ++) {
+    File->LogName[Index] = (unsigned char) Name[Index];
+  }
+  File->LogName[Index++] = 'l';
+  File->LogName[Index++] = 'o';
+  File->LogName[Index++] = 'g';
+  File->LogName[Index]   = 0;
+  return 0;
+}
+
+static UCS2 *
+FormatSystemHang (
+  const UCS2    *TestCategory,
+  const UCS2    *CaseName
+  )
+{
+  static const char   Prefix[] = "System hang in ";
+  static const char   Middle[] = " - ";
+  size_t              Length;
+  size_t              Index;
+  UCS2                *Result;
+
+  if (TestCategory == NULL) {
+    TestCategory = mEmpty;
+  }
+  if (CaseName == NULL) {
+    CaseName = mEmpty;
+  }
+
+  Length = strlen (Prefix) + Ucs2Len (TestCategory) + strlen (Middle) + Ucs2Len (CaseName);
+  Result = malloc ((Length + 1) * sizeof (UCS2));
+  if (Result == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  Length = 0;
+  for (Index = 0; Prefix[Index] != 0; Index ++) {
+    Result[Length++] = (unsigned char) Prefix[Index];
+  }
+  for (Index = 0; TestCategory[Index] != 0; Index ++) {
+    Result[Length++] = TestCategory[Index];
+  }
+  for (Index = 0; Middle[Index] != 0; Index ++) {
+    Result[Length++] = (unsigned char) Middle[Index];
+  }
+  for (Index = 0; CaseName[Index] != 0; Index ++) {
+    Result[Length++] = CaseName[Index];
+  }
+  Result[Length] = 0;
+
+  return Result;
+}
+
+static void
+LoadReportInfor (
+  LOG_FILE      *File
+  )
+{
+  TOKEN_STATE   State;
+  UCS2          *LineBuffer;
+  UCS2          *GuidStr;
+  UCS2          *AssertionStr;
+  UCS2          *TitleStr;
+  UCS2          *RuntimeInforStr;
+  UCS2          *CaseGuidStr;
+  UCS2          *CaseRevisionStr;
+  UCS2          *CaseNameStr;
+  UCS2          *TestNameStr;
+  UCS2          *TestCategoryStr;
+  UCS2          *DevicePathStr;
+  int           AssertionType;
+  int           Index;
+  LOG_ASSERTION *Assertion;
+
+  File->Loaded = 1;
+
+  if (File->Buffer[0] != UNICODE_FLAG) {
+    return;
+  }
+
+  CaseGuidStr     = NULL;
+  CaseRevisionStr = NULL;
+  CaseNameStr     = NULL;
+  TestNameStr     = NULL;
+  TestCategoryStr = NULL;
+  DevicePathStr   = NULL;
+
+  LineBuffer = TokenLine (&State, File->Buffer + 1, mLineSet);
+  while (LineBuffer != NULL) {
+    if (LineBuffer[0] == '|') {
+      if (LineBuffer[1] == 'H') {
+        //
+        // The head line. Skip the leading empty string, "HEAD", two empty
+        // strings, the configuration number, the scenario, the date and the
+        // time. The device path is the rest of the line.
+        //
+        TokenField (&State, LineBuffer, mBarSet);
+        for (Index = 0; Index < 7; Index ++) {
+          TokenField (&State, NULL, mBarSet);
+        }
+
+        CaseGuidStr     = TokenField (&State, NULL, mBarSet);
+        CaseRevisionStr = TokenField (&State, NULL, mBarSet);
+        CaseNameStr     = TokenField (&State, NULL, mBarSet);
+        TestNameStr     = TokenField (&State, NULL, mBarSet);
+        TestCategoryStr = TokenField (&State, NULL, mBarSet);
+        DevicePathStr   = TokenField (&State, NULL, mNewLineSet);
+      }
+
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    //
+    // The item line "GUID:RESULT|Title:Runtime information"
+    //
+    GuidStr = TokenField (&State, LineBuffer, mColonSet);
+    if ((GuidStr == NULL) || (Ucs2CmpAscii (GuidStr, mGenericGuidStr) == 0)) {
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    AssertionStr = TokenField (&State, NULL, mBarSet);
+    if (AssertionStr == NULL) {
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    if (Ucs2CmpAscii (AssertionStr, "PASS") == 0) {
+      AssertionType = ASSERTION_TYPE_PASS;
+    } else if (Ucs2CmpAscii (AssertionStr, "FAILURE") == 0) {
+      AssertionType = ASSERTION_TYPE_FAIL;
+    } else {
+      AssertionType = ASSERTION_TYPE_WARN;
+    }
+
+    TitleStr        = TokenField (&State, NULL, mColonSet);
+    RuntimeInforStr = TokenField (&State, NULL, mLineSet);
+
+    //
+    // InsertReportInfor fails without the test name, LoadReportInfor stops
+    // there. The warning assertions are not reported.
+    //
+    if ((TestNameStr == NULL) || (TestCategoryStr == NULL)) {
+      File->Failed = 1;
+      return;
+    }
+
+    if (AssertionType == ASSERTION_TYPE_WARN) {
+      LineBuffer = TokenLine (&State, NULL, mLineSet);
+      continue;
+    }
+
+    File->Assertions = GrowArray (File->Assertions, &File->AssertionMax, File->AssertionCount, sizeof (LOG_ASSERTION));
+    Assertion = &File->Assertions[File->AssertionCount++];
+    memset (Assertion, 0, sizeof (LOG_ASSERTION));
+
+    Assertion->Guid         = GuidStr;
+    Assertion->ValidGuid    = ParseGuid (GuidStr, &Assertion->GuidKey);
+    Assertion->Type         = AssertionType;
+    Assertion->Title        = TitleStr;
+    Assertion->RuntimeInfor = RuntimeInforStr;
+    Assertion->TestName     = TestNameStr;
+    Assertion->TestCategory = TestCategoryStr;
+    Assertion->DevicePath   = DevicePathStr;
+    Assertion->CaseRevision = CaseRevisionStr;
+    Assertion->CaseGuid     = CaseGuidStr;
+
+    if (Ucs2CmpAscii (GuidStr, mSystemHangGuidStr) == 0) {
+      Assertion->Title             = mSystemHangTitle;
+      Assertion->OwnedRuntimeInfor = FormatSystemHang (TestCategoryStr, CaseNameStr);
+      Assertion->RuntimeInfor      = Assertion->OwnedRuntimeInfor;
+    }
+
+    LineBuffer = TokenLine (&State, NULL, mLineSet);
+  }
+}
+
+//
+// Binary key files. The reader follows ReadKeyFileRecord of the framework
+// (Report\ReportSupport.c), and the records are loaded as the text lines.
+//
+
+static unsigned long
+GetKeyFileValue (
+  const UCS2    *Buffer,
+  size_t        Offset,
+  size_t        Size
+  )
+{
+  unsigned long Value;
+  size_t        Index;
+  UCS2          Char;
+
+  //
+  // Little-endian, at any byte offset
+  //
+  Value = 0;
+  for (Index = Size; Index > 0; Index --) {
+    Char  = Buffer[(Offset + Index - 1) / 2];
+    Value = (Value << 8) | (((Offset + Index - 1) & 1) ? (Char >> 8) : (Char & 0xFF));
+  }
+
+  return Value;
+}
+
+static int
+IsBinaryKeyFile (
+  const LOG_FILE  *File
+  )
+{
+  if (File->Size < 2 + KEY_FILE_HEADER_SIZE) {
+    return 0;
+  }
+
+  return (File->Buffer[0] == UNICODE_FLAG) &&
+         (GetKeyFileValue (File->Buffer, 2, 4) == KEY_FILE_SIGNATURE);
+}
+
+static int
+IsKeyFileSegment (
+  const KEY_FILE_READER *Reader
+  )
+{
+  if (Reader->Offset + KEY_FILE_HEADER_SIZE > Reader->Size) {
+    return 0;
+  }
+
+  return GetKeyFileValue (Reader->Buffer, Reader->Offset, 4) == KEY_FILE_SIGNATURE;
+}
+
+static UCS2 *
+GetKeyFileString (
+  const KEY_FILE_READER *Reader,
+  size_t                Record,
+  size_t                RecordSize,
+  size_t                *Offset
+  )
+{
+  UCS2                  *String;
+  size_t                Index;
+
+  //
+  // NULL if the string is not terminated in the record
+  //
+  String = Reader->Buffer + (Record + *Offset) / 2;
+  for (Index = *Offset; Index + 2 <= RecordSize; Index += 2) {
+    if (Reader->Buffer[(Record + Index) / 2] == 0) {
+      *Offset = Index + 2;
+      return String;
+    }
+  }
+
+  return NULL;
+}
+
+static const UCS2 *
+GetKeyFileDescription (
+  const KEY_FILE_READER *Reader,
+  unsigned long         DescriptionId
+  )
+{
+  if (DescriptionId >= Reader->DescriptionMax) {
+    return NULL;
+  }
+
+  return Reader->Descriptions[DescriptionId];
+}
+
+static int
+ReadKeyFileRecord (
+  KEY_FILE_READER       *Reader,
+  unsigned long         *Type,
+  size_t                *Record,
+  size_t                *RecordSize
+  )
+{
+  size_t                Remain;
+  size_t                Size;
+  size_t                Offset;
+  size_t                DescriptionMax;
+  unsigned long         Id;
+  UCS2                  *Description;
+  int                   Broken;
+
+  while (Reader->Offset + KEY_FILE_RECORD_SIZE <= Reader->Size) {
+    Remain = Reader->Size - Reader->Offset;
+    Broken = 0;
+    Size   = 0;
+
+    if (IsKeyFileSegment (Reader)) {
+      //
+      // A new segment, its description IDs start from 0 again
+      //
+      Size = GetKeyFileValue (Reader->Buffer, Reader->Offset + 6, 2);
+      if ((GetKeyFileValue (Reader->Buffer, Reader->Offset + 4, 2) == KEY_FILE_VERSION) &&
+          (Size >= KEY_FILE_HEADER_SIZE) &&
+          ((Size & 1) == 0) &&
+          (Size <= Remain)) {
+        Reader->Offset += Size;
+        if (Reader->Descriptions != NULL) {
+          memset (Reader->Descriptions, 0, Reader->DescriptionMax * sizeof (UCS2 *));
+        }
+        continue;
+      }
+
+      Broken = 1;
+    } else {
+      Size = GetKeyFileValue (Reader->Buffer, Reader->Offset + 2, 2);
+      if ((Size < KEY_FILE_RECORD_SIZE) || ((Size & 1) != 0) || (Size > Remain)) {
+        Broken = 1;
+      }
+    }
+
+    if (Broken) {
+      //
+      // Skip to the next segment header
+      //
+      do {
+        Reader->Offset += 2;
+      } while ((Reader->Offset + KEY_FILE_HEADER_SIZE <= Reader->Size) &&
+               !IsKeyFileSegment (Reader));
+      continue;
+    }
+
+    *Type       = GetKeyFileValue (Reader->Buffer, Reader->Offset, 2);
+    *Record     = Reader->Offset;
+    *RecordSize = Size;
+    Reader->Offset += Size;
+
+    switch (*Type) {
+    case KEY_FILE_RECORD_HEAD:
+    case KEY_FILE_RECORD_ASSERTION:
+    case KEY_FILE_RECORD_TERM:
+      return 0;
+
+    case KEY_FILE_RECORD_DESCRIPTION:
+      if (Size < KEY_FILE_DESCRIPTION_SIZE) {
+        break;
+      }
+
+      Id          = GetKeyFileValue (Reader->Buffer, *Record + KEY_FILE_RECORD_SIZE, 2);
+      Offset      = KEY_FILE_DESCRIPTION_SIZE;
+      Description = GetKeyFileString (Reader, *Record, Size, &Offset);
+      if ((Description == NULL) || (Id == KEY_FILE_INLINE_DESCRIPTION)) {
+        break;
+      }
+
+      if (Id >= Reader->DescriptionMax) {
+        DescriptionMax = Reader->DescriptionMax;
+        while (Id >= DescriptionMax) {
+          DescriptionMax = (DescriptionMax == 0) ? 64 : DescriptionMax * 2;
+        }
+
+        Reader->Descriptions = realloc (Reader->Descriptions, DescriptionMax * sizeof (UCS2 *));
+        if (Reader->Descriptions == NULL) {
+          printf ("Error: Out of memory\n");
+          exit (-1);
+        }
+
+        memset (
+          Reader->Descriptions + Reader->DescriptionMax,
+          0,
+          (DescriptionMax - Reader->DescriptionMax) * sizeof (UCS2 *)
+          );
+        Reader->DescriptionMax = DescriptionMax;
+      }
+
+      Reader->Descriptions[Id] = Description;
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  return -1;
+}
+
+static UCS2 *
+KeepKeyFileString (
+  LOG_FILE      *File,
+  const char    *String
+  )
+{
+  File->Strings = GrowArray (File->Strings, &File->StringMax, File->StringCount, sizeof (UCS2 *));
+  File->Strings[File->StringCount] = Ucs2FromAscii (String);
+
+  return File->Strings[File->StringCount++];
+}
+
+static UCS2 *
+FormatKeyFileGuid (
+  LOG_FILE              *File,
+  const KEY_FILE_READER *Reader,
+  size_t                Offset
+  )
+{
+  char                  String[40];
+  unsigned long         Data4[8];
+  unsigned long         Sum;
+  size_t                Index;
+
+  //
+  // As "%g" of SctSPrint. The only known GUID which could be in a key file
+  // is the null GUID.
+  //
+  Sum = 0;
+  for (Index = 0; Index < 16; Index ++) {
+    Sum |= GetKeyFileValue (Reader->Buffer, Offset + Index, 1);
+  }
+  if (Sum == 0) {
+    return KeepKeyFileString (File, "G0");
+  }
+
+  for (Index = 0; Index < 8; Index ++) {
+    Data4[Index] = GetKeyFileValue (Reader->Buffer, Offset + 8 + Index, 1);
+  }
+
+  sprintf (
+    String,
+    "%08lx-%04lx-%04lx-%02lx%02lx-%02lx%02lx%02lx%02lx%02lx%02lx",
+    GetKeyFileValue (Reader->Buffer, Offset, 4),
+    GetKeyFileValue (Reader->Buffer, Offset + 4, 2),
+    GetKeyFileValue (Reader->Buffer, Offset + 6, 2),
+    Data4[0], Data4[1], Data4[2], Data4[3],
+    Data4[4], Data4[5], Data4[6], Data4[7]
+    );
+
+  return KeepKeyFileString (File, String);
+}
+
+static void
+LoadBinaryReportInfor (
+  LOG_FILE        *File
+  )
+{
+  KEY_FILE_READER Reader;
+  unsigned long   Type;
+  size_t          Record;
+  size_t          RecordSize;
+  size_t          Offset;
+  unsigned long   Result;
+  char            Revision[24];
+  UCS2            *GuidStr;
+  const UCS2      *TitleStr;
+  UCS2            *RuntimeInforStr;
+  UCS2            *CaseGuidStr;
+  UCS2            *CaseRevisionStr;
+  UCS2            *CaseNameStr;
+  UCS2            *TestNameStr;
+  UCS2            *TestCategoryStr;
+  UCS2            *DevicePathStr;
+  UCS2            *Char;
+  int             AssertionType;
+  LOG_ASSERTION   *Assertion;
+
+  File->Loaded = 1;
+
+  CaseGuidStr     = NULL;
+  CaseRevisionStr = NULL;
+  CaseNameStr     = NULL;
+  TestNameStr     = NULL;
+  TestCategoryStr = NULL;
+  DevicePathStr   = NULL;
+
+  memset (&Reader, 0, sizeof (KEY_FILE_READER));
+  Reader.Buffer = File->Buffer;
+  Reader.Size   = File->Size;
+  Reader.Offset = 2;
+
+  while (ReadKeyFileRecord (&Reader, &Type, &Record, &RecordSize) == 0) {
+    if (Type == KEY_FILE_RECORD_HEAD) {
+      //
+      // The scenario, case name, test name, test category and device path
+      // strings follow the fixed part
+      //
+      if (RecordSize < KEY_FILE_HEAD_SIZE) {
+        continue;
+      }
+
+      sprintf (
+        Revision,
+        "0x%08llx",
+        ((UINT64_T) GetKeyFileValue (Reader.Buffer, Record + KEY_FILE_HEAD_REVISION + 4, 4) << 32) |
+        GetKeyFileValue (Reader.Buffer, Record + KEY_FILE_HEAD_REVISION, 4)
+        );
+      CaseGuidStr     = FormatKeyFileGuid (File, &Reader, Record + KEY_FILE_HEAD_ENTRY_ID);
+      CaseRevisionStr = KeepKeyFileString (File, Revision);
+
+      Offset          = KEY_FILE_HEAD_SIZE;
+      GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+      CaseNameStr     = GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+      TestNameStr     = GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+      TestCategoryStr = GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+      DevicePathStr   = GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+      continue;
+    }
+
+    if ((Type != KEY_FILE_RECORD_ASSERTION) || (RecordSize < KEY_FILE_ASSERTION_SIZE)) {
+      continue;
+    }
+
+    GuidStr = FormatKeyFileGuid (File, &Reader, Record + KEY_FILE_ASSERTION_EVENT_ID);
+
+    File->Assertions = GrowArray (File->Assertions, &File->AssertionMax, File->AssertionCount, sizeof (LOG_ASSERTION));
+    Assertion = &File->Assertions[File->AssertionCount];
+    memset (Assertion, 0, sizeof (LOG_ASSERTION));
+
+    //
+    // The generic and the system hang GUIDs are compared as GUIDs here, not
+    // as upper case strings
+    //
+    Assertion->ValidGuid = ParseGuid (GuidStr, &Assertion->GuidKey);
+    if (Assertion->ValidGuid &&
+        (memcmp (&Assertion->GuidKey, &mGenericGuid, sizeof (GUID_KEY)) == 0)) {
+      continue;
+    }
+
+    Result = GetKeyFileValue (Reader.Buffer, Record + KEY_FILE_ASSERTION_RESULT, 1);
+    if (Result == TEST_ASSERTION_PASSED) {
+      AssertionType = ASSERTION_TYPE_PASS;
+    } else if (Result == TEST_ASSERTION_FAILED) {
+      AssertionType = ASSERTION_TYPE_FAIL;
+    } else {
+      AssertionType = ASSERTION_TYPE_WARN;
+    }
+
+    //
+    // The runtime information ends at the first line break, as in the text
+    // key file
+    //
+    Offset = KEY_FILE_ASSERTION_SIZE;
+    if (GetKeyFileValue (Reader.Buffer, Record + KEY_FILE_ASSERTION_DESC_ID, 2) == KEY_FILE_INLINE_DESCRIPTION) {
+      TitleStr = GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+    } else {
+      TitleStr = GetKeyFileDescription (&Reader, GetKeyFileValue (Reader.Buffer, Record + KEY_FILE_ASSERTION_DESC_ID, 2));
+    }
+
+    RuntimeInforStr = GetKeyFileString (&Reader, Record, RecordSize, &Offset);
+    if (RuntimeInforStr != NULL) {
+      for (Char = RuntimeInforStr; *Char != 0; Char ++) {
+        if ((*Char == '\r') || (*Char == '\n')) {
+          *Char = 0;
+          break;
+        }
+      }
+    }
+
+    //
+    // InsertReportInfor fails without the test name, LoadBinaryReportInfor
+    // stops there. The warning assertions are not reported.
+    //
+    if ((TestNameStr == NULL) || (TestCategoryStr == NULL)) {
+      File->Failed = 1;
+      break;
+    }
+
+    if (AssertionType == ASSERTION_TYPE_WARN) {
+      continue;
+    }
+
+    File->AssertionCount ++;
+
+    Assertion->Guid         = GuidStr;
+    Assertion->Type         = AssertionType;
+    Assertion->Title        = TitleStr;
+    Assertion->RuntimeInfor = RuntimeInforStr;
+    Assertion->TestName     = TestNameStr;
+    Assertion->TestCategory = TestCategoryStr;
+    Assertion->DevicePath   = DevicePathStr;
+    Assertion->CaseRevision = CaseRevisionStr;
+    Assertion->CaseGuid     = CaseGuidStr;
+
+    if (Assertion->ValidGuid &&
+        (memcmp (&Assertion->GuidKey, &mSystemHangGuid, sizeof (GUID_KEY)) == 0)) {
+      Assertion->Title             = mSystemHangTitle;
+      Assertion->OwnedRuntimeInfor = FormatSystemHang (TestCategoryStr, CaseNameStr);
+      Assertion->RuntimeInfor      = Assertion->OwnedRuntimeInfor;
+    }
+  }
+
+  free (Reader.Descriptions);
+}
+
+static UINT64_T
+Ucs2ToUint64 (
+  UCS2          *String
+  )
+{
+  UCS2          *Tail;
+  UINT64_T      Value;
+  int           Base;
+  int           Digit;
+
+  //
+  // SctStrToUInt64: spaces are trimmed, 0 on any error
+  //
+  while (*String == ' ') {
+    String ++;
+  }
+
+  Tail = String + Ucs2Len (String);
+  while ((Tail > String) && (Tail[-1] == ' ')) {
+    Tail --;
+  }
+
+  Base = 10;
+  if ((Tail - String >= 2) && (String[0] == '0') && ((String[1] == 'x') || (String[1] == 'X'))) {
+    String += 2;
+    Base    = 16;
+  }
+
+  Value = 0;
+  for (; String < Tail; String ++) {
+    if (Base == 16) {
+      if ((Value >> 60) != 0) {
+        return 0;
+      }
+      Digit = HexValue (*String);
+    } else {
+      if ((Value >> 61) != 0) {
+        return 0;
+      }
+      if (Value * 10 < Value * 2) {
+        return 0;
+      }
+      Digit = ((*String >= '0') && (*String <= '9')) ? (*String - '0') : -1;
+    }
+
+    if (Digit < 0) {
+      return 0;
+    }
+
+    Value = Value * Base + Digit;
+  }
+
+  return Value;
+}
+
+static void
+LoadProfileInfor (
+  LOG_FILE      *File,
+  const char    *Name
+  )
+{
+  TOKEN_STATE   State;
+  UCS2          *LineBuffer;
+  UCS2          *FieldStr[PROFILE_FIELD_NUM];
+  UCS2          *FileName;
+  size_t        Index;
+
+  if (File->Buffer[0] != UNICODE_FLAG) {
+    return;
+  }
+
+  LineBuffer = TokenLine (&State, File->Buffer + 1, mLineSet);
+  if ((LineBuffer == NULL) || (LineBuffer[0] != '|')) {
+    return;
+  }
+
+  FieldStr[0] = TokenField (&State, LineBuffer + 1, mBarSet);
+  for (Index = 1; Index < PROFILE_FIELD_NUM; Index ++) {
+    FieldStr[Index] = TokenField (&State, NULL, mBarSet);
+  }
+
+  for (Index = 0; Index < PROFILE_FIELD_NUM; Index ++) {
+    if (FieldStr[Index] == NULL) {
+      return;
+    }
+  }
+
+  if (Ucs2CmpAscii (FieldStr[0], "PROF") != 0) {
+    return;
+  }
+
+  memset (&File->Profile, 0, sizeof (PROFILE_INFOR));
+  File->Profile.Microseconds    = Ucs2ToUint64 (FieldStr[1]);
+  File->Profile.Assertions      = Ucs2ToUint64 (FieldStr[3]);
+  File->Profile.BytesWritten    = Ucs2ToUint64 (FieldStr[4]);
+  File->Profile.FreePagesBefore = Ucs2ToUint64 (FieldStr[5]);
+  File->Profile.FreePagesAfter  = Ucs2ToUint64 (FieldStr[6]);
+
+  Ucs2CopyN (File->Profile.Clock, FieldStr[2], PROFILE_CLOCK_LEN - 1);
+  Ucs2CopyN (File->Profile.CaseGuid, FieldStr[7], CASE_GUID_LEN - 1);
+  Ucs2CopyN (File->Profile.CaseName, FieldStr[8], NAME_LEN - 1);
+
+  FileName = Ucs2FromAscii (Name);
+  Ucs2CopyN (File->Profile.FileName, FileName, NAME_LEN - 1);
+  free (FileName);
+
+  File->HasProfile = 1;
+}
+
+void
+ParseLogFile (
+  LOG_FILE      *File
+  )
+{
+  const char    *Name;
+
+  //
+  // A file which cannot be read is skipped, like on the target
+  //
+  File->Buffer = ReadUnicodeFile (File->Path, &File->Size);
+  if (File->Buffer == NULL) {
+    printf ("Warning: Cannot read %s\n", File->Path);
+    return;
+  }
+
+  if (File->Kind == LOG_FILE_KEY) {
+    if (IsBinaryKeyFile (File)) {
+      LoadBinaryReportInfor (File);
+    } else {
+      LoadReportInfor (File);
+    }
+  } else {
+    Name = strrchr (File->Path, PATH_SEPARATOR[0]);
+    Name = (Name == NULL) ? File->Path : Name + 1;
+    LoadProfileInfor (File, Name);
+  }
+}
+
+static void
+FreeLogFile (
+  LOG_FILE      *File
+  )
+{
+  size_t        Index;
+
+  for (Index = 0; Index < File->AssertionCount; Index ++) {
+    free (File->Assertions[Index].OwnedRuntimeInfor);
+  }
+  for (Index = 0; Index < File->StringCount; Index ++) {
+    free (File->Strings[Index]);
+  }
+
+  free (File->Strings);
+
+  free (File->Assertions);
+  free (File->Buffer);
+  free (File->Path);
+}
+
+//
+// Log directory walking. The entries are taken in the name order, on the
+// target they are taken in the directory order.
+//
+
+int
+CollectLogFiles (
+  MACHINE       *Machine,
+  const char    *DirPath
+  )
+{
+  char          **Names;
+  size_t        NameCount;
+  size_t        NameMax;
+  size_t        Index;
+  char          *Path;
+  int           IsDirectory;
+  LOG_FILE      *File;
+#ifdef _WIN32
+  HANDLE            Find;
+  WIN32_FIND_DATAA  FindData;
+#else
+  DIR               *Dir;
+  struct dirent     *Entry;
+  struct stat       PathStat;
+#endif
+
+  Names     = NULL;
+  NameCount = 0;
+  NameMax   = 0;
+
+#ifdef _WIN32
+  Path = JoinPath (DirPath, "*");
+  Find = FindFirstFileA (Path, &FindData);
+  free (Path);
+  if (Find == INVALID_HANDLE_VALUE) {
+    printf ("Error: Cannot open directory %s\n", DirPath);
+    return -1;
+  }
+
+  do {
+    if ((strcmp (FindData.cFileName, ".") == 0) || (strcmp (FindData.cFileName, "..") == 0)) {
+      continue;
+    }
+    Names = GrowArray (Names, &NameMax, NameCount, sizeof (char *));
+    Names[NameCount++] = DuplicateString (FindData.cFileName);
+  } while (FindNextFileA (Find, &FindData));
+
+  FindClose (Find);
+#else
+  Dir = opendir (DirPath);
+  if (Dir == NULL) {
+    printf ("Error: Cannot open directory %s\n", DirPath);
+    return -1;
+  }
+
+  while ((Entry = readdir (Dir)) != NULL) {
+    if ((strcmp (Entry->d_name, ".") == 0) || (strcmp (Entry->d_name, "..") == 0)) {
+      continue;
+    }
+    Names = GrowArray (Names, &NameMax, NameCount, sizeof (char *));
+    Names[NameCount++] = DuplicateString (Entry->d_name);
+  }
+
+  closedir (Dir);
+#endif
+
+  qsort (Names, NameCount, sizeof (char *), CompareNameNoCase);
+
+  for (Index = 0; Index < NameCount; Index ++) {
+    Path = JoinPath (DirPath, Names[Index]);
+
+#ifdef _WIN32
+    IsDirectory = ((GetFileAttributesA (Path) & FILE_ATTRIBUTE_DIRECTORY) != 0);
+#else
+    IsDirectory = ((stat (Path, &PathStat) == 0) && S_ISDIR (PathStat.st_mode));
+#endif
+
+    if (IsDirectory) {
+      CollectLogFiles (Machine, Path);
+      free (Path);
+      free (Names[Index]);
+      continue;
+    }
+
+    Machine->Files = GrowArray (Machine->Files, &Machine->FileMax, Machine->FileCount, sizeof (LOG_FILE));
+    File = &Machine->Files[Machine->FileCount];
+    memset (File, 0, sizeof (LOG_FILE));
+    File->Path = Path;
+
+    if (EndWithNoCase (Names[Index], ".prf")) {
+      File->Kind = LOG_FILE_PROFILE;
+      Machine->FileCount ++;
+    } else if (EndWithNoCase (Names[Index], ".ekl") &&
+               (GetIndexFromFileName (Names[Index], File) == 0)) {
+      File->Kind = LOG_FILE_KEY;
+      Machine->FileCount ++;
+    } else {
+      free (Path);
+    }
+
+    free (Names[Index]);
+  }
+
+  free (Names);
+  return 0;
+}
+
+//
+// Report generation, runs on the worker threads
+//
+
+static void
+ClearGuidAssertion (
+  REPORT_INFOR  *Report
+  )
+{
+  Report->GuidAssertionCount = 0;
+  ClearGuidIndex (&Report->GuidAssertionIndex);
+}
+
+static void
+InsertReportInfor (
+  REPORT_INFOR          *Report,
+  LOG_FILE              *File,
+  LOG_ASSERTION         *Assertion
+  )
+{
+  int                   Indexed;
+  GUID_SLOT             *Slot;
+  GUID_ASSERTION        *GuidAssertion;
+  size_t                GuidAssertionIndex;
+  REPORT_ITEM           *Item;
+  size_t                ItemIndex;
+  ASSERTION_INFOR       *Infor;
+  size_t                InforIndex;
+  const GUID_ENTRY      *Entry;
+  size_t                Position;
+
+  //
+  // Insert the GUID assertion. Every system hang assertion is kept.
+  //
+  Indexed = Assertion->ValidGuid &&
+            (memcmp (&Assertion->GuidKey, &mSystemHangGuid, sizeof (GUID_KEY)) != 0);
+
+  GuidAssertionIndex = 0;
+  Slot = NULL;
+  if (Indexed) {
+    Slot = FindGuidSlot (&Report->GuidAssertionIndex, &Assertion->GuidKey);
+  }
+
+  if ((Slot != NULL) && (Slot->Entry != 0)) {
+    GuidAssertionIndex = Slot->Entry - 1;
+    GuidAssertion      = &Report->GuidAssertions[GuidAssertionIndex];
+
+    //
+    // Keep the worst result, skip the duplicate assertion
+    //
+    if ((GuidAssertion->AssertionType | Assertion->Type) == GuidAssertion->AssertionType) {
+      return;
+    }
+
+    GuidAssertion->AssertionType |= Assertion->Type;
+
+    //
+    // A failure overrides the passed assertion of the same GUID
+    //
+    if (GuidAssertion->Infor != 0) {
+      Infor = &Report->Infors[GuidAssertion->Infor - 1];
+      Infor->Removed = 1;
+      Report->Items[GuidAssertion->Item].PassNumber --;
+      Report->TotalPass --;
+      GuidAssertion->Infor = 0;
+    }
+  } else {
+    Report->GuidAssertions = GrowArray (Report->GuidAssertions, &Report->GuidAssertionMax, Report->GuidAssertionCount, sizeof (GUID_ASSERTION));
+    GuidAssertionIndex = Report->GuidAssertionCount++;
+    GuidAssertion = &Report->GuidAssertions[GuidAssertionIndex];
+    GuidAssertion->AssertionType = Assertion->Type;
+    GuidAssertion->Item          = 0;
+    GuidAssertion->Infor         = 0;
+
+    if (Indexed) {
+      InsertGuidIndex (&Report->GuidAssertionIndex, &Assertion->GuidKey, GuidAssertionIndex + 1);
+    }
+  }
+
+  //
+  // Search the report item of the test
+  //
+  if ((Report->ItemCount != 0) &&
+      (Ucs2Cmp (Report->Items[Report->LastItem].TestName, Assertion->TestName) == 0)) {
+    ItemIndex = Report->LastItem;
+  } else {
+    for (ItemIndex = 0; ItemIndex < Report->ItemCount; ItemIndex ++) {
+      if (Ucs2Cmp (Report->Items[ItemIndex].TestName, Assertion->TestName) == 0) {
+        break;
+      }
+    }
+
+    if (ItemIndex == Report->ItemCount) {
+      Report->Items = GrowArray (Report->Items, &Report->ItemMax, Report->ItemCount, sizeof (REPORT_ITEM));
+      Item = &Report->Items[Report->ItemCount++];
+      memset (Item, 0, sizeof (REPORT_ITEM));
+      Item->TestName     = Assertion->TestName;
+      Item->TestCategory = Assertion->TestCategory;
+    }
+  }
+
+  Report->LastItem = ItemIndex;
+  Item = &Report->Items[ItemIndex];
+
+  //
+  // Set the assertion information
+  //
+  Report->Infors = GrowArray (Report->Infors, &Report->InforMax, Report->InforCount, sizeof (ASSERTION_INFOR));
+  InforIndex = Report->InforCount++;
+  Infor = &Report->Infors[InforIndex];
+  for (Position = 0; Position < FIELD_NUMBER; Position ++) {
+    Infor->Field[Position] = mEmpty;
+  }
+  Infor->Removed = 0;
+
+  Entry = NULL;
+  if (Assertion->ValidGuid) {
+    Entry = SearchGuidDatabase (Report->Database, &Assertion->GuidKey);
+  }
+  if (Entry != NULL) {
+    Infor->Field[FIELD_TITLE] = Entry->Title;
+    Infor->Field[FIELD_INDEX] = Entry->Index;
+  }
+
+  Infor->Field[FIELD_CASE_INDEX]     = File->CaseIndex;
+  Infor->Field[FIELD_CASE_ITERATION] = File->CaseIteration;
+  Infor->Field[FIELD_GUID]           = Assertion->Guid;
+
+  if ((Infor->Field[FIELD_TITLE][0] == 0) && (Assertion->Title != NULL)) {
+    Infor->Field[FIELD_TITLE] = Assertion->Title;
+  }
+  if (Assertion->RuntimeInfor != NULL) {
+    Infor->Field[FIELD_RUNTIME_INFOR] = Assertion->RuntimeInfor;
+  }
+  if (Assertion->DevicePath != NULL) {
+    Infor->Field[FIELD_DEVICE_PATH] = Assertion->DevicePath;
+  }
+  if (Assertion->CaseRevision != NULL) {
+    Infor->Field[FIELD_CASE_REVISION] = Assertion->CaseRevision;
+  }
+  if (Assertion->CaseGuid != NULL) {
+    Infor->Field[FIELD_CASE_GUID] = Assertion->CaseGuid;
+  }
+  Infor->Field[FIELD_FILE_NAME] = File->LogName;
+
+  if (Assertion->Type == ASSERTION_TYPE_PASS) {
+    Report->TotalPass ++;
+    Item->PassNumber ++;
+    Item->Pass = GrowArray (Item->Pass, &Item->PassMax, Item->PassCount, sizeof (size_t));
+    Item->Pass[Item->PassCount++] = InforIndex;
+
+    //
+    // Remember the passed assertion for a later override
+    //
+    GuidAssertion = &Report->GuidAssertions[GuidAssertionIndex];
+    GuidAssertion->Item  = ItemIndex;
+    GuidAssertion->Infor = InforIndex + 1;
+  } else {
+    Report->TotalFail ++;
+    Item->FailNumber ++;
+    Item->Fail = GrowArray (Item->Fail, &Item->FailMax, Item->FailCount, sizeof (size_t));
+    Item->Fail[Item->FailCount++] = InforIndex;
+  }
+}
+
+static void
+InsertProfileInfor (
+  REPORT_INFOR          *Report,
+  const PROFILE_INFOR   *Profile
+  )
+{
+  size_t                Index;
+  size_t                Last;
+
+  Index = Report->ProfileCount;
+  while ((Index > 0) && (Report->Profiles[Index - 1].Microseconds < Profile->Microseconds)) {
+    Index --;
+  }
+
+  if (Index == SLOWEST_CASE_NUM) {
+    return;
+  }
+
+  if (Report->ProfileCount < SLOWEST_CASE_NUM) {
+    Report->ProfileCount ++;
+  }
+
+  for (Last = Report->ProfileCount - 1; Last > Index; Last --) {
+    Report->Profiles[Last] = Report->Profiles[Last - 1];
+  }
+
+  Report->Profiles[Index] = *Profile;
+}
+
+//
+// Report output. Each print is one ReportPrint on the target: the line is
+// truncated like SctVSPrint does and converted to ASCII.
+//
+
+static void
+LineAppend (
+  LINE_BUFFER   *Line,
+  const UCS2    *String,
+  size_t        Length
+  )
+{
+  size_t        NewMax;
+
+  if (Line->Length + Length + 1 > Line->Max) {
+    NewMax = Line->Max * 2;
+    while (Line->Length + Length + 1 > NewMax) {
+      NewMax *= 2;
+    }
+
+    Line->Buffer = realloc (Line->Buffer, NewMax * sizeof (UCS2));
+    if (Line->Buffer == NULL) {
+      printf ("Error: Out of memory\n");
+      exit (-1);
+    }
+    Line->Max = NewMax;
+  }
+
+  memcpy (Line->Buffer + Line->Length, String, Length * sizeof (UCS2));
+  Line->Length += Length;
+}
+
+static void
+LineAppendAscii (
+  LINE_BUFFER   *Line,
+  const char    *String
+  )
+{
+  UCS2          Char;
+
+  for (; *String != 0; String ++) {
+    Char = (unsigned char) *String;
+    LineAppend (Line, &Char, 1);
+  }
+}
+
+static void
+LineAppendString (
+  LINE_BUFFER   *Line,
+  const UCS2    *String,
+  size_t        MaxLength
+  )
+{
+  size_t        Length;
+
+  Length = Ucs2Len (String);
+  if (Length > MaxLength) {
+    Length = MaxLength;
+  }
+
+  LineAppend (Line, String, Length);
+}
+
+static void
+LineAppendNumber (
+  LINE_BUFFER   *Line,
+  UINT64_T      Value
+  )
+{
+  char          Buffer[32];
+  size_t        Index;
+
+  Index = sizeof (Buffer) - 1;
+  Buffer[Index] = 0;
+  do {
+    Buffer[--Index] = (char) ('0' + (Value % 10));
+    Value /= 10;
+  } while (Value != 0);
+
+  LineAppendAscii (Line, Buffer + Index);
+}
+
+static void
+LineAppendField (
+  LINE_BUFFER             *Line,
+  const ASSERTION_INFOR   *Infor,
+  size_t                  Position
+  )
+{
+  size_t                  Length;
+
+  //
+  // A full field buffer has no terminator on the target and runs into the
+  // next field
+  //
+  while (Position < FIELD_NUMBER) {
+    Length = Ucs2Len (Infor->Field[Position]);
+    if (Length < mFieldLength[Position]) {
+      LineAppend (Line, Infor->Field[Position], Length);
+      return;
+    }
+
+    LineAppend (Line, Infor->Field[Position], mFieldLength[Position]);
+    Position ++;
+  }
+}
+
+static void
+LineWrite (
+  LINE_BUFFER   *Line,
+  FILE          *Output
+  )
+{
+  size_t        Index;
+  size_t        MaxLength;
+
+  //
+  // SctVSPrint keeps REPORT_LINE_LEN - 2 chars of an overlong line
+  //
+  MaxLength = REPORT_LINE_LEN - 1;
+  if (Line->Length >= MaxLength) {
+    Line->Length = MaxLength - 1;
+  }
+
+  for (Index = 0; Index < Line->Length; Index ++) {
+    fputc ((unsigned char) (Line->Buffer[Index] & 0xFF), Output);
+  }
+
+  Line->Length = 0;
+}
+
+static void
+WriteReportInfor (
+  REPORT_INFOR  *Report,
+  LINE_BUFFER   *Line,
+  FILE          *Output
+  )
+{
+  size_t          ItemIndex;
+  size_t          Index;
+  REPORT_ITEM     *Item;
+  ASSERTION_INFOR *Infor;
+
+  LineAppendAscii (
+    Line,
+    "\"Self Certification Test Report\"\n"
+    "\"Service\\Protocol Name\",\"Total\",\"Failed\",\"Passed\"\n"
+    );
+  LineWrite (Line, Output);
+
+  for (ItemIndex = 0; ItemIndex < Report->ItemCount; ItemIndex ++) {
+    Item = &Report->Items[ItemIndex];
+    LineAppendAscii (Line, "\"");
+    LineAppendString (Line, Item->TestCategory, NAME_LEN);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendNumber (Line, Item->PassNumber + Item->FailNumber);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendNumber (Line, Item->FailNumber);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendNumber (Line, Item->PassNumber);
+    LineAppendAscii (Line, "\"\n");
+    LineWrite (Line, Output);
+  }
+
+  LineAppendAscii (Line, "\"Total service\\Protocol\",\"");
+  LineAppendNumber (Line, Report->TotalPass + Report->TotalFail);
+  LineAppendAscii (Line, "\",\"");
+  LineAppendNumber (Line, Report->TotalFail);
+  LineAppendAscii (Line, "\",\"");
+  LineAppendNumber (Line, Report->TotalPass);
+  LineAppendAscii (Line, "\"\n");
+  LineWrite (Line, Output);
+
+  //
+  // The failed assertions
+  //
+  LineAppendAscii (
+    Line,
+    "\n\"Service\\Protocol Name\",\"Index\",\"Instance\",\"Iteration\",\"Guid\",\"Result\",\"Title\",\"Runtime Information\",\"Case Revision\",\"Case GUID\",\"Device Path\",\"Logfile Name\"\n"
+    );
+  LineWrite (Line, Output);
+
+  for (ItemIndex = 0; ItemIndex < Report->ItemCount; ItemIndex ++) {
+    Item = &Report->Items[ItemIndex];
+    for (Index = 0; Index < Item->FailCount; Index ++) {
+      Infor = &Report->Infors[Item->Fail[Index]];
+      LineAppendAscii (Line, "\"");
+      LineAppendString (Line, Item->TestCategory, NAME_LEN);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_INDEX);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_INDEX);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_ITERATION);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_GUID);
+      LineAppendAscii (Line, "\",\"FAIL\",\"");
+      LineAppendField (Line, Infor, FIELD_TITLE);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_RUNTIME_INFOR);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_REVISION);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_GUID);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_DEVICE_PATH);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_FILE_NAME);
+      LineAppendAscii (Line, "\"\n");
+      LineWrite (Line, Output);
+    }
+  }
+
+  //
+  // The passed assertions
+  //
+  LineAppendAscii (
+    Line,
+    "\n\"Service\\Protocol Name\",\"Index\",\"Instance\",\"Iteration\",\"Guid\",\"Result\",\"Title\",\"Runtime Information\",\"Case Revision\",\"Case GUID\"\n"
+    );
+  LineWrite (Line, Output);
+
+  for (ItemIndex = 0; ItemIndex < Report->ItemCount; ItemIndex ++) {
+    Item = &Report->Items[ItemIndex];
+    for (Index = 0; Index < Item->PassCount; Index ++) {
+      Infor = &Report->Infors[Item->Pass[Index]];
+      if (Infor->Removed) {
+        continue;
+      }
+      LineAppendAscii (Line, "\"");
+      LineAppendString (Line, Item->TestCategory, NAME_LEN);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_INDEX);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_INDEX);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_ITERATION);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_GUID);
+      LineAppendAscii (Line, "\",\"PASS\",\"");
+      LineAppendField (Line, Infor, FIELD_TITLE);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_RUNTIME_INFOR);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_REVISION);
+      LineAppendAscii (Line, "\",\"");
+      LineAppendField (Line, Infor, FIELD_CASE_GUID);
+      LineAppendAscii (Line, "\"\n");
+      LineWrite (Line, Output);
+    }
+  }
+}
+
+static void
+WriteProfileInfor (
+  REPORT_INFOR  *Report,
+  LINE_BUFFER   *Line,
+  FILE          *Output
+  )
+{
+  size_t          Index;
+  PROFILE_INFOR   *Profile;
+
+  if (Report->ProfileCount == 0) {
+    return;
+  }
+
+  LineAppendAscii (
+    Line,
+    "\n\"Slowest Test Instances\"\n"
+    "\"Case Name\",\"Case GUID\",\"Time (ms)\",\"Clock\",\"Assertions\",\"Bytes Logged\",\"Memory Delta (KB)\",\"Profile Name\"\n"
+    );
+  LineWrite (Line, Output);
+
+  for (Index = 0; Index < Report->ProfileCount; Index ++) {
+    Profile = &Report->Profiles[Index];
+    LineAppendAscii (Line, "\"");
+    LineAppendString (Line, Profile->CaseName, NAME_LEN);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendString (Line, Profile->CaseGuid, CASE_GUID_LEN);
+    LineAppendAscii (Line, "\",\"");
+    //
+    // Milliseconds with three decimals, as "%ld.%03d" on the target
+    //
+    LineAppendNumber (Line, Profile->Microseconds / 1000);
+    LineAppendAscii (Line, ".");
+    if (Profile->Microseconds % 1000 < 100) {
+      LineAppendAscii (Line, (Profile->Microseconds % 1000 < 10) ? "00" : "0");
+    }
+    LineAppendNumber (Line, Profile->Microseconds % 1000);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendString (Line, Profile->Clock, PROFILE_CLOCK_LEN);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendNumber (Line, Profile->Assertions);
+    LineAppendAscii (Line, "\",\"");
+    LineAppendNumber (Line, Profile->BytesWritten);
+    LineAppendAscii (Line, "\",\"");
+    if (Profile->FreePagesBefore >= Profile->FreePagesAfter) {
+      LineAppendNumber (Line, (Profile->FreePagesBefore - Profile->FreePagesAfter) * 4);
+    } else {
+      LineAppendAscii (Line, "-");
+      LineAppendNumber (Line, (Profile->FreePagesAfter - Profile->FreePagesBefore) * 4);
+    }
+    LineAppendAscii (Line, "\",\"");
+    LineAppendString (Line, Profile->FileName, NAME_LEN);
+    LineAppendAscii (Line, "\"\n");
+    LineWrite (Line, Output);
+  }
+}
+
+static void
+WriteConfig (
+  MACHINE       *Machine,
+  FILE          *Output
+  )
+{
+  char          *Path;
+  void          *Data;
+  void          *Mapping;
+  size_t        Size;
+
+  //
+  // The system configuration is collected by shell commands on the target,
+  // it is appended as it is
+  //
+  Path = JoinPath (Machine->SctDir, CONFIG_FILE);
+  if (MapFile (Path, &Data, &Size, &Mapping) != 0) {
+    printf ("Warning: No %s, the system configuration is not reported\n", Path);
+    free (Path);
+    return;
+  }
+
+  if (Data != NULL) {
+    fwrite (Data, 1, Size, Output);
+  }
+
+  UnmapFile (Data, Size, Mapping);
+  free (Path);
+}
+
+static void
+FreeReportInfor (
+  REPORT_INFOR  *Report
+  )
+{
+  size_t        Index;
+
+  for (Index = 0; Index < Report->ItemCount; Index ++) {
+    free (Report->Items[Index].Pass);
+    free (Report->Items[Index].Fail);
+  }
+
+  free (Report->Items);
+  free (Report->Infors);
+  free (Report->GuidAssertions);
+  free (Report->GuidAssertionIndex.Slots);
+}
+
+int
+MergeMachine (
+  MACHINE       *Machine
+  )
+{
+  GUID_DATABASE LocalDatabase;
+  REPORT_INFOR  Report;
+  LINE_BUFFER   Line;
+  LOG_FILE      *File;
+  char          *Path;
+  FILE          *Output;
+  size_t        FileIndex;
+  size_t        Index;
+  int           Result;
+
+  memset (&LocalDatabase, 0, sizeof (GUID_DATABASE));
+  memset (&Report, 0, sizeof (REPORT_INFOR));
+
+  if (mUseSharedDatabase) {
+    Report.Database = &mSharedDatabase;
+  } else {
+    Path = JoinPath (Machine->SctDir, GUID_DATABASE_FILE);
+    Result = LoadGuidDatabase (Path, &LocalDatabase);
+    free (Path);
+    if (Result != 0) {
+      return -1;
+    }
+    Report.Database = &LocalDatabase;
+  }
+
+  //
+  // Merge the files in the walking order. The GUID assertions are merged in
+  // a key file, unless the key file is broken.
+  //
+  for (FileIndex = 0; FileIndex < Machine->FileCount; FileIndex ++) {
+    File = &Machine->Files[FileIndex];
+
+    if (File->Kind == LOG_FILE_PROFILE) {
+      if (File->HasProfile) {
+        InsertProfileInfor (&Report, &File->Profile);
+      }
+      continue;
+    }
+
+    if (!File->Loaded) {
+      continue;
+    }
+
+    for (Index = 0; Index < File->AssertionCount; Index ++) {
+      InsertReportInfor (&Report, File, &File->Assertions[Index]);
+    }
+
+    if (!File->Failed) {
+      ClearGuidAssertion (&Report);
+    }
+  }
+
+  //
+  // Write the report
+  //
+  Output = fopen (Machine->ReportName, "wb");
+  if (Output == NULL) {
+    printf ("Error: Cannot create %s\n", Machine->ReportName);
+    FreeReportInfor (&Report);
+    FreeGuidDatabase (&LocalDatabase);
+    return -1;
+  }
+
+  Line.Max    = REPORT_LINE_LEN;
+  Line.Length = 0;
+  Line.Buffer = malloc (Line.Max * sizeof (UCS2));
+  if (Line.Buffer == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  WriteReportInfor (&Report, &Line, Output);
+  WriteProfileInfor (&Report, &Line, Output);
+  WriteConfig (Machine, Output);
+
+  Result = ferror (Output) ? -1 : 0;
+  if (fclose (Output) != 0) {
+    Result = -1;
+  }
+  if (Result != 0) {
+    printf ("Error: Cannot write %s\n", Machine->ReportName);
+  }
+
+  free (Line.Buffer);
+  FreeReportInfor (&Report);
+  FreeGuidDatabase (&LocalDatabase);
+  return Result;
+}
+
+//
+// Job pool
+//
+
+static void
+PushJob (
+  JOB_POOL      *Pool,
+  int           Kind,
+  MACHINE       *Machine,
+  size_t        FileIndex,
+  int           Urgent
+  )
+{
+  JOB           *Job;
+
+  Job = malloc (sizeof (JOB));
+  if (Job == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+
+  Job->Kind      = Kind;
+  Job->Machine   = Machine;
+  Job->FileIndex = FileIndex;
+  Job->Next      = NULL;
+
+  //
+  // Merging releases the parsed files, so it goes first
+  //
+  if (Urgent) {
+    Job->Next  = Pool->Head;
+    Pool->Head = Job;
+    if (Pool->Tail == NULL) {
+      Pool->Tail = Job;
+    }
+  } else {
+    if (Pool->Tail == NULL) {
+      Pool->Head = Job;
+    } else {
+      Pool->Tail->Next = Job;
+    }
+    Pool->Tail = Job;
+  }
+
+  ConditionBroadcast (&Pool->JobReady);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+WorkerThread (
+  LPVOID        Context
+  )
+#else
+static void *
+WorkerThread (
+  void          *Context
+  )
+#endif
+{
+  JOB_POOL      *Pool;
+  JOB           *Job;
+  MACHINE       *Machine;
+  size_t        Index;
+
+  Pool = Context;
+
+  LockAcquire (&Pool->Lock);
+  while (1) {
+    while ((Pool->Head == NULL) && !Pool->Stop) {
+      ConditionWait (&Pool->JobReady, &Pool->Lock);
+    }
+
+    if (Pool->Head == NULL) {
+      break;
+    }
+
+    Job        = Pool->Head;
+    Pool->Head = Job->Next;
+    if (Pool->Head == NULL) {
+      Pool->Tail = NULL;
+    }
+    LockRelease (&Pool->Lock);
+
+    Machine = Job->Machine;
+    if (Job->Kind == JOB_PARSE_FILE) {
+      ParseLogFile (&Machine->Files[Job->FileIndex]);
+
+      LockAcquire (&Pool->Lock);
+      Machine->Pending --;
+      if (Machine->Pending == 0) {
+        PushJob (Pool, JOB_MERGE_MACHINE, Machine, 0, 1);
+      }
+    } else {
+      Machine->Result = MergeMachine (Machine);
+      if (Machine->Result == 0) {
+        printf ("%s: %lu files\n", Machine->ReportName, (unsigned long) Machine->FileCount);
+      }
+
+      for (Index = 0; Index < Machine->FileCount; Index ++) {
+        FreeLogFile (&Machine->Files[Index]);
+      }
+      free (Machine->Files);
+      Machine->Files     = NULL;
+      Machine->FileCount = 0;
+
+      LockAcquire (&Pool->Lock);
+      Pool->MachinesInFlight --;
+      ConditionBroadcast (&Pool->MachineDone);
+    }
+
+    free (Job);
+  }
+  LockRelease (&Pool->Lock);
+
+#ifdef _WIN32
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+//
+// External functions implementation
+//
+
+int
+main (
+  int           Argc,
+  char          **Argv
+  )
+{
+  MACHINE       *Machines;
+  size_t        MachineCount;
+  size_t        MachineMax;
+  size_t        MachineIndex;
+  size_t        FileIndex;
+  unsigned int  ThreadNumber;
+  unsigned int  Index;
+  THREAD        Threads[MAX_THREAD_NUMBER];
+  char          *GuidFile;
+  UCS2          *GuidString;
+  char          *LogPath;
+  char          Line[1024];
+  FILE          *ListFile;
+  size_t        Length;
+  int           ArgIndex;
+  int           Result;
+
+  Machines     = NULL;
+  MachineCount = 0;
+  MachineMax   = 0;
+  ThreadNumber = GetProcessorNumber ();
+  GuidFile     = NULL;
+
+  //
+  // Process the arguments
+  //
+  for (ArgIndex = 1; ArgIndex < Argc; ArgIndex ++) {
+    if ((strcmp (Argv[ArgIndex], "-j") == 0) && (ArgIndex + 1 < Argc)) {
+      ThreadNumber = (unsigned int) strtoul (Argv[++ArgIndex], NULL, 0);
+    } else if ((strcmp (Argv[ArgIndex], "-g") == 0) && (ArgIndex + 1 < Argc)) {
+      GuidFile = Argv[++ArgIndex];
+    } else if ((strcmp (Argv[ArgIndex], "-o") == 0) && (ArgIndex + 1 < Argc)) {
+      mOutputDir = Argv[++ArgIndex];
+    } else if ((strcmp (Argv[ArgIndex], "-l") == 0) && (ArgIndex + 1 < Argc)) {
+      ListFile = fopen (Argv[++ArgIndex], "r");
+      if (ListFile == NULL) {
+        printf ("Error: Cannot open %s\n", Argv[ArgIndex]);
+        return -1;
+      }
+      while (fgets (Line, sizeof (Line), ListFile) != NULL) {
+        Length = strlen (Line);
+        while ((Length > 0) && ((Line[Length - 1] == '\n') || (Line[Length - 1] == '\r'))) {
+          Line[--Length] = 0;
+        }
+        if (Length != 0) {
+          AddMachine (&Machines, &MachineCount, &MachineMax, Line);
+        }
+      }
+      fclose (ListFile);
+    } else if (Argv[ArgIndex][0] == '-') {
+      PrintUsage ();
+      return -1;
+    } else {
+      AddMachine (&Machines, &MachineCount, &MachineMax, Argv[ArgIndex]);
+    }
+  }
+
+  if (MachineCount == 0) {
+    PrintUsage ();
+    return -1;
+  }
+
+  if (ThreadNumber == 0) {
+    ThreadNumber = 1;
+  }
+  if (ThreadNumber > MAX_THREAD_NUMBER) {
+    ThreadNumber = MAX_THREAD_NUMBER;
+  }
+
+  GuidString = Ucs2FromAscii (mGenericGuidStr);
+  ParseGuid (GuidString, &mGenericGuid);
+  free (GuidString);
+  GuidString = Ucs2FromAscii (mSystemHangGuidStr);
+  ParseGuid (GuidString, &mSystemHangGuid);
+  free (GuidString);
+  mSystemHangTitle = Ucs2FromAscii ("System hangs or stops abnormally.");
+
+  if (GuidFile != NULL) {
+    if (LoadGuidDatabase (GuidFile, &mSharedDatabase) != 0) {
+      return -1;
+    }
+    mUseSharedDatabase = 1;
+  }
+
+  //
+  // Start the workers
+  //
+  memset (&mPool, 0, sizeof (JOB_POOL));
+  LockInit (&mPool.Lock);
+  ConditionInit (&mPool.JobReady);
+  ConditionInit (&mPool.MachineDone);
+
+  for (Index = 0; Index < ThreadNumber; Index ++) {
+#ifdef _WIN32
+    Threads[Index] = CreateThread (NULL, 0, WorkerThread, &mPool, 0, NULL);
+    Result = (Threads[Index] == NULL) ? -1 : 0;
+#else
+    Result = pthread_create (&Threads[Index], NULL, WorkerThread, &mPool);
+#endif
+    if (Result != 0) {
+      printf ("Error: Cannot create the worker threads\n");
+      return -1;
+    }
+  }
+
+  //
+  // Queue the machines. The number of the machines in flight is limited, so
+  // the memory is bounded by the largest machines.
+  //
+  for (MachineIndex = 0; MachineIndex < MachineCount; MachineIndex ++) {
+    LogPath = JoinPath (Machines[MachineIndex].SctDir, LOG_DIRECTORY);
+    if (CollectLogFiles (&Machines[MachineIndex], LogPath) != 0) {
+      Machines[MachineIndex].Result = -1;
+      free (LogPath);
+      continue;
+    }
+    free (LogPath);
+
+    LockAcquire (&mPool.Lock);
+    while (mPool.MachinesInFlight >= ThreadNumber) {
+      ConditionWait (&mPool.MachineDone, &mPool.Lock);
+    }
+
+    mPool.MachinesInFlight ++;
+    Machines[MachineIndex].Pending = Machines[MachineIndex].FileCount;
+    if (Machines[MachineIndex].FileCount == 0) {
+      PushJob (&mPool, JOB_MERGE_MACHINE, &Machines[MachineIndex], 0, 1);
+    }
+    for (FileIndex = 0; FileIndex < Machines[MachineIndex].FileCount; FileIndex ++) {
+      PushJob (&mPool, JOB_PARSE_FILE, &Machines[MachineIndex], FileIndex, 0);
+    }
+    LockRelease (&mPool.Lock);
+  }
+
+  //
+  // Wait for all machines and stop the workers
+  //
+  LockAcquire (&mPool.Lock);
+  while (mPool.MachinesInFlight != 0) {
+    ConditionWait (&mPool.MachineDone, &mPool.Lock);
+  }
+  mPool.Stop = 1;
+  ConditionBroadcast (&mPool.JobReady);
+  LockRelease (&mPool.Lock);
+
+  for (Index = 0; Index < ThreadNumber; Index ++) {
+#ifdef _WIN32
+    WaitForSingleObject (Threads[Index], INFINITE);
+    CloseHandle (Threads[Index]);
+#else
+    pthread_join (Threads[Index], NULL);
+#endif
+  }
+
+  //
+  // Done
+  //
+  Result = 0;
+  for (MachineIndex = 0; MachineIndex < MachineCount; MachineIndex ++) {
+    if (Machines[MachineIndex].Result != 0) {
+      Result = -1;
+    }
+    free (Machines[MachineIndex].SctDir);
+    free (Machines[MachineIndex].ReportName);
+  }
+
+  free (Machines);
+  FreeGuidDatabase (&mSharedDatabase);
+  return Result;
+}
+
+
+//
+// Internal functions implementation
+//
+
+void
+PrintUsage (
+  void
+  )
+{
+  printf ("Usage: GenReport [-j Threads] [-g GuidFile] [-o OutputDir] [-l ListFile] SctDir ...\n");
+  printf ("  -j Threads    - Number of worker threads (default: number of processors)\n");
+  printf ("  -g GuidFile   - GUID database for all machines (default: <SctDir>\\%s)\n", GUID_DATABASE_FILE);
+  printf ("  -o OutputDir  - Write <OutputDir>\\<SctDir name>.csv (default: <SctDir>\\%s)\n", REPORT_FILE);
+  printf ("  -l ListFile   - Read more SCT directories from a file, one per line\n");
+  printf ("  SctDir        - SCT directory of a machine, with the Log directory and Sct.cfg\n");
+}
+
+
+int
+AddMachine (
+  MACHINE       **Machines,
+  size_t        *MachineCount,
+  size_t        *MachineMax,
+  const char    *SctDir
+  )
+{
+  MACHINE       *Machine;
+  char          *Name;
+  char          *ReportName;
+  size_t        Length;
+
+  *Machines = GrowArray (*Machines, MachineMax, *MachineCount, sizeof (MACHINE));
+  Machine   = &(*Machines)[(*MachineCount)++];
+  memset (Machine, 0, sizeof (MACHINE));
+
+  //
+  // Remove the trailing separators
+  //
+  Machine->SctDir = DuplicateString (SctDir);
+  Length = strlen (Machine->SctDir);
+  while ((Length > 1) && ((Machine->SctDir[Length - 1] == '/') || (Machine->SctDir[Length - 1] == '\\'))) {
+    Machine->SctDir[--Length] = 0;
+  }
+
+  if (mOutputDir == NULL) {
+    Machine->ReportName = JoinPath (Machine->SctDir, REPORT_FILE);
+    return 0;
+  }
+
+  //
+  // The report is named as the machine directory
+  //
+  Name = Machine->SctDir + Length;
+  while ((Name > Machine->SctDir) && (Name[-1] != '/') && (Name[-1] != '\\')) {
+    Name --;
+  }
+
+  ReportName = malloc (strlen (Name) + 5);
+  if (ReportName == NULL) {
+    printf ("Error: Out of memory\n");
+    exit (-1);
+  }
+  sprintf (ReportName, "%s.csv", Name);
+
+  Machine->ReportName = JoinPath (mOutputDir, ReportName);
+  free (ReportName);
+  return 0;
+}
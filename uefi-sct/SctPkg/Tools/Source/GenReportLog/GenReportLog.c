@@ -0,0 +1,373 @@
+/** @file
+
+  Copyright 2006 - 2010 Unified EFI, Inc.<BR>
+  Copyright (c) 2010 - 2019 Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at 
+  http://opensource.org/licenses/bsd-license.php
+ 
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+**/
+/*++
+
+
+Module Name:
+
+  GenReportLog.c
+
+Abstract:
+
+  Generate a synthetic SCT log tree (key files and GUID database) to measure
+  the report generation on a large number of assertions.
+
+--*/
+
+//
+// Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Definitions
+//
+
+#define MAX_LINE_LENGTH           512
+#define MAX_PATH_LENGTH           1024
+
+#define DEFAULT_CASE_NUMBER       5000
+#define DEFAULT_ASSERTION_NUMBER  100
+
+//
+// One of DUPLICATE_RATE assertions re-checks an earlier GUID of the same case
+// and one of FAILURE_RATE assertions fails
+//
+#define DUPLICATE_RATE            4
+#define FAILURE_RATE              50
+
+//
+// Modular variables
+//
+
+static unsigned long mSeed = 0x5C7u;
+
+//
+// Internal functions declaration
+//
+
+void
+PrintUsage (
+  void
+  );
+
+unsigned long
+NextRandom (
+  void
+  );
+
+void
+MakeGuid (
+  unsigned long Index,
+  char          *GuidStr
+  );
+
+int
+WriteUnicodeLine (
+  FILE          *File,
+  const char    *String
+  );
+
+int
+GenGuidDatabase (
+  const char    *OutputDir,
+  unsigned long GuidNumber
+  );
+
+int
+GenKeyFile (
+  const char    *OutputDir,
+  unsigned long CaseIndex,
+  unsigned long AssertionNumber,
+  unsigned long *GuidNumber
+  );
+
+
+//
+// External functions implementation
+//
+
+int
+main (
+  int         Argc,
+  char        **Argv
+  )
+{
+  unsigned long   CaseNumber;
+  unsigned long   AssertionNumber;
+  unsigned long   GuidNumber;
+  unsigned long   Index;
+
+  //
+  // Check parameters
+  //
+  if ((Argc < 2) || (Argc > 4)) {
+    PrintUsage ();
+    return -1;
+  }
+
+  CaseNumber      = DEFAULT_CASE_NUMBER;
+  AssertionNumber = DEFAULT_ASSERTION_NUMBER;
+
+  if (Argc > 2) {
+    CaseNumber = strtoul (Argv[2], NULL, 0);
+  }
+  if (Argc > 3) {
+    AssertionNumber = strtoul (Argv[3], NULL, 0);
+  }
+
+  if ((CaseNumber == 0) || (AssertionNumber == 0)) {
+    PrintUsage ();
+    return -1;
+  }
+
+  //
+  // Generate the key files
+  //
+  GuidNumber = 0;
+  for (Index = 0; Index < CaseNumber; Index ++) {
+    if (GenKeyFile (Argv[1], Index, AssertionNumber, &GuidNumber) != 0) {
+      return -1;
+    }
+  }
+
+  //
+  // Generate the GUID database for all used GUIDs
+  //
+  if (GenGuidDatabase (Argv[1], GuidNumber) != 0) {
+    return -1;
+  }
+
+  printf (
+    "Generated %lu key files, %lu assertions, %lu GUIDs\n",
+    CaseNumber,
+    CaseNumber * AssertionNumber,
+    GuidNumber
+    );
+
+  return 0;
+}
+
+
+//
+// Internal functions implementation
+//
+
+void
+PrintUsage (
+  void
+  )
+{
+  printf ("Usage: GenReportLog <OutputDir> [CaseNumber] [AssertionNumber]\n");
+  printf ("  OutputDir       - An existing directory for the key files and GuidFile.txt\n");
+  printf ("  CaseNumber      - Number of key files (default %d)\n", DEFAULT_CASE_NUMBER);
+  printf ("  AssertionNumber - Number of assertions per key file (default %d)\n", DEFAULT_ASSERTION_NUMBER);
+}
+
+
+unsigned long
+NextRandom (
+  void
+  )
+{
+  //
+  // A fixed LCG, so the same parameters always generate the same log tree
+  //
+  mSeed = (mSeed * 1103515245u + 12345u) & 0xFFFFFFFFu;
+  return mSeed >> 8;
+}
+
+
+void
+MakeGuid (
+  unsigned long Index,
+  char          *GuidStr
+  )
+{
+  unsigned long   Hash;
+
+  //
+  // Spread the index over the GUID fields like a real random GUID
+  //
+  Hash = (Index * 2654435761u) & 0xFFFFFFFFu;
+
+  sprintf (
+    GuidStr,
+    "%08lX-%04lX-%04lX-%04lX-%04lX%08lX",
+    Hash,
+    (Index >> 16) & 0xFFFF,
+    Index & 0xFFFF,
+    ((Hash >> 16) ^ 0x8000) & 0xFFFF,
+    Hash & 0xFFFF,
+    Index & 0xFFFFFFFFu
+    );
+}
+
+
+int
+WriteUnicodeLine (
+  FILE          *File,
+  const char    *String
+  )
+{
+  unsigned char   Buffer[MAX_LINE_LENGTH * 2];
+  size_t          Length;
+  size_t          Index;
+
+  //
+  // Write the ASCII string as a little-endian UCS-2 string
+  //
+  Length = strlen (String);
+  if (Length > MAX_LINE_LENGTH) {
+    Length = MAX_LINE_LENGTH;
+  }
+
+  for (Index = 0; Index < Length; Index ++) {
+    Buffer[Index * 2]     = (unsigned char) String[Index];
+    Buffer[Index * 2 + 1] = 0;
+  }
+
+  if (fwrite (Buffer, 2, Length, File) != Length) {
+    printf ("Error: Cannot write the file\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+
+int
+GenGuidDatabase (
+  const char    *OutputDir,
+  unsigned long GuidNumber
+  )
+{
+  FILE            *File;
+  char            FileName[MAX_PATH_LENGTH];
+  char            GuidStr[48];
+  char            Line[MAX_LINE_LENGTH];
+  unsigned long   Index;
+
+  sprintf (FileName, "%s/GuidFile.txt", OutputDir);
+
+  File = fopen (FileName, "wb");
+  if (File == NULL) {
+    printf ("Error: Cannot create %s\n", FileName);
+    return -1;
+  }
+
+  //
+  // Unicode flag, then the "GUID / Title / Index" line triples
+  //
+  fputc (0xFF, File);
+  fputc (0xFE, File);
+
+  for (Index = 0; Index < GuidNumber; Index ++) {
+    MakeGuid (Index, GuidStr);
+    sprintf (Line, "%s\r\nBenchmark assertion %lu\r\n5.%lu.%lu\r\n", GuidStr, Index, Index / 1000, Index % 1000);
+    if (WriteUnicodeLine (File, Line) != 0) {
+      fclose (File);
+      return -1;
+    }
+  }
+
+  fclose (File);
+  return 0;
+}
+
+
+int
+GenKeyFile (
+  const char    *OutputDir,
+  unsigned long CaseIndex,
+  unsigned long AssertionNumber,
+  unsigned long *GuidNumber
+  )
+{
+  FILE            *File;
+  char            FileName[MAX_PATH_LENGTH];
+  char            CaseGuidStr[48];
+  char            GuidStr[48];
+  char            Line[MAX_LINE_LENGTH];
+  unsigned long   FirstGuid;
+  unsigned long   GuidIndex;
+  unsigned long   Index;
+  int             Result;
+
+  //
+  // The file name is "<Name>_<Index>_<Iteration>_<CaseGuid>.ekl"
+  //
+  MakeGuid (0x80000000u | CaseIndex, CaseGuidStr);
+  sprintf (FileName, "%s/Bench%lu_0_0_%s.ekl", OutputDir, CaseIndex, CaseGuidStr);
+
+  File = fopen (FileName, "wb");
+  if (File == NULL) {
+    printf ("Error: Cannot create %s\n", FileName);
+    return -1;
+  }
+
+  fputc (0xFF, File);
+  fputc (0xFE, File);
+
+  //
+  // The head line, in the same layout as the standard test library
+  //
+  sprintf (
+    Line,
+    "|HEAD|||0|Benchmark|01-01-2020|00:00:00|%s|0x00010000|Case%lu|Bench%lu|Benchmark\\Bench%lu|No device path\n",
+    CaseGuidStr,
+    CaseIndex,
+    CaseIndex / 100,
+    CaseIndex / 1000
+    );
+  Result = WriteUnicodeLine (File, Line);
+
+  //
+  // The assertion lines. Some of them repeat a GUID of the same case to go
+  // through the duplicate merging
+  //
+  FirstGuid = *GuidNumber;
+  for (Index = 0; (Index < AssertionNumber) && (Result == 0); Index ++) {
+    if ((*GuidNumber > FirstGuid) && ((NextRandom () % DUPLICATE_RATE) == 0)) {
+      GuidIndex = FirstGuid + NextRandom () % (*GuidNumber - FirstGuid);
+    } else {
+      GuidIndex = (*GuidNumber) ++;
+    }
+
+    MakeGuid (GuidIndex, GuidStr);
+    sprintf (
+      Line,
+      "%s:%s|Benchmark assertion %lu:Synthetic runtime information of case %lu\n",
+      GuidStr,
+      ((NextRandom () % FAILURE_RATE) == 0) ? "FAILURE" : "PASS",
+      GuidIndex,
+      CaseIndex
+      );
+    Result = WriteUnicodeLine (File, Line);
+  }
+
+  //
+  // The terminate line
+  //
+  if (Result == 0) {
+    Result = WriteUnicodeLine (File, "|TERM|0000|01-01-2020|00:00:01|0 00:00:01\n");
+  }
+
+  fclose (File);
+  return Result;
+}